@@ -1,5 +1,10 @@
 #include "AppRunner.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -7,17 +12,26 @@
 
 #include "ControlSettings.h"
 #include "GameController.h"
+#include "MeshCache.h"
 #include "MeshData.h"
 #include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "OcclusionCuller.h"
+#include "VertexQuantizer.h"
 #include "PlaneMesh.h"
 #include "RenderingSystem.h"
 #include "SceneConfig.h"
 #include "SceneLighting.h"
+#include "TangentGenerator.h"
 #include "KeyInputManager.h"
 #include "TextureResolver.h"
 #include "MaterialConfigurator.h"
 #include "framework/Framework.h"
 #include "framework/InputDevice.h"
+#include "framework/NullRenderDevice.h"
+#include "framework/ParallelFor.h"
 #include "framework/Timer.h"
 #include "framework/Window.h"
 
@@ -34,6 +48,192 @@ namespace {
         DirectX::XMStoreFloat4x4(&out, world);
         return out;
     }
+
+    void ReportModelLoad(const std::wstring &path, const ObjModelData &model,
+                         std::chrono::steady_clock::time_point start) {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::error_code ec;
+        const auto bytes = std::filesystem::file_size(path, ec);
+        std::size_t triangles = 0;
+        for (const auto &sub: model.submeshes) {
+            triangles += sub.mesh.BaseIndexCount() / 3;
+        }
+        const double megabytes = ec ? 0.0 : static_cast<double>(bytes) / (1024.0 * 1024.0);
+        const double safe_seconds = seconds > 0.0 ? seconds : 1e-9;
+        std::wcout << L"Loaded " << path << L": " << triangles << L" triangles in " << seconds * 1000.0
+                   << L" ms (" << megabytes / safe_seconds << L" MB/s, "
+                   << static_cast<double>(triangles) / safe_seconds << L" tris/s)" << std::endl;
+    }
+
+    // Trades a little vertex cache reuse for front-to-back cluster order; see MeshOptimizer::OptimizeOverdraw.
+    constexpr float kOverdrawThreshold = 1.05f;
+
+    // Triangle ratios of the generated LODs relative to full detail.
+    const std::vector<float> kLodRatios = {0.5f, 0.25f, 0.125f};
+
+    // Stores loaded models in the 16-byte VertexQuantizer layout instead of 32-byte float vertices.
+    constexpr bool kQuantizeVertices = true;
+
+    // Adds per-vertex tangents so the GBuffer skips the per-pixel cotangent frame for these meshes.
+    constexpr bool kGenerateTangents = true;
+
+    // Simulates the vertex cache and rasterizes 16 views for overdraw before and after optimizing, only to log
+    // the results; tests/MeshOptimizerTests --benchmark reports the same numbers without slowing down loads.
+    constexpr bool kLogMeshAnalysis = false;
+
+    // Reorders every submesh for vertex cache reuse and overdraw and builds its meshlets, LODs and quantized
+    // vertices. With kLogMeshAnalysis it also logs the simulated ACMR/ATVR and overdraw before and after.
+    void OptimizeModel(const std::wstring &path, ObjModelData &model) {
+        struct SubmeshStats {
+            VertexCacheStats cache;
+            OverdrawStats overdraw;
+        };
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<SubmeshStats> before(model.submeshes.size());
+        std::vector<SubmeshStats> after(model.submeshes.size());
+        std::vector<QuantizationStats> quantization(model.submeshes.size());
+        ParallelFor(model.submeshes.size(), DefaultWorkerCount(), [&](std::size_t i) {
+            MeshData &mesh = model.submeshes[i].mesh;
+            if (kLogMeshAnalysis) {
+                before[i] = {MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count),
+                             MeshOptimizer::AnalyzeOverdraw(mesh)};
+            }
+            MeshOptimizer::Optimize(mesh, kOverdrawThreshold);
+            if (kLogMeshAnalysis) {
+                after[i] = {MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count),
+                            MeshOptimizer::AnalyzeOverdraw(mesh)};
+            }
+            // Meshlets are contiguous ranges of the final index order, so they are built last; LODs are
+            // appended behind that range and leave it untouched.
+            Meshlets::Build(mesh);
+            MeshSimplifier::BuildLods(mesh, kLodRatios);
+            // Every pass above reads float positions, so the encoding runs last.
+            if (kQuantizeVertices) {
+                VertexQuantizer::Quantize(mesh, &quantization[i]);
+            }
+        });
+
+        std::size_t triangles = 0;
+        std::size_t vertices = 0;
+        std::size_t meshlets = 0;
+        SubmeshStats total_before;
+        SubmeshStats total_after;
+        QuantizationStats total_quantization;
+        for (std::size_t i = 0; i < model.submeshes.size(); ++i) {
+            triangles += model.submeshes[i].mesh.BaseIndexCount() / 3;
+            vertices += model.submeshes[i].mesh.vertex_count;
+            meshlets += model.submeshes[i].mesh.meshlets.size();
+            total_before.cache.transforms += before[i].cache.transforms;
+            total_after.cache.transforms += after[i].cache.transforms;
+            total_before.overdraw.pixels_covered += before[i].overdraw.pixels_covered;
+            total_before.overdraw.pixels_shaded += before[i].overdraw.pixels_shaded;
+            total_after.overdraw.pixels_covered += after[i].overdraw.pixels_covered;
+            total_after.overdraw.pixels_shaded += after[i].overdraw.pixels_shaded;
+            total_quantization.bytes_before += quantization[i].bytes_before;
+            total_quantization.bytes_after += quantization[i].bytes_after;
+            total_quantization.max_position_error = std::max(total_quantization.max_position_error,
+                                                             quantization[i].max_position_error);
+            total_quantization.max_normal_error = std::max(total_quantization.max_normal_error,
+                                                           quantization[i].max_normal_error);
+            total_quantization.max_uv_error = std::max(total_quantization.max_uv_error, quantization[i].max_uv_error);
+            total_quantization.max_tangent_error = std::max(total_quantization.max_tangent_error,
+                                                            quantization[i].max_tangent_error);
+        }
+        if (triangles == 0 || vertices == 0) {
+            return;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const auto tris = static_cast<double>(triangles);
+        const auto verts = static_cast<double>(vertices);
+        const auto overdraw = [](const OverdrawStats &stats) {
+            return stats.pixels_covered
+                       ? static_cast<double>(stats.pixels_shaded) / static_cast<double>(stats.pixels_covered)
+                       : 0.0;
+        };
+        std::wcout << L"Optimized " << path << L" in " << ms << L" ms: " << meshlets << L" meshlets" << std::endl;
+        if (kLogMeshAnalysis) {
+            std::wcout << L"  ACMR " << static_cast<double>(total_before.cache.transforms) / tris << L" -> "
+                       << static_cast<double>(total_after.cache.transforms) / tris << L", ATVR "
+                       << static_cast<double>(total_before.cache.transforms) / verts << L" -> "
+                       << static_cast<double>(total_after.cache.transforms) / verts << L", overdraw "
+                       << overdraw(total_before.overdraw) << L" -> " << overdraw(total_after.overdraw) << std::endl;
+        }
+        if (total_quantization.bytes_before > 0) {
+            // Every vertex and index is fetched at least once per full-detail draw, so the byte ratio is
+            // also the lower bound on input-assembler bandwidth saved.
+            std::wcout << L"  Quantized vertices: " << total_quantization.bytes_before / 1024 << L" KB -> "
+                       << total_quantization.bytes_after / 1024 << L" KB ("
+                       << 100.0 * static_cast<double>(total_quantization.bytes_after) /
+                          static_cast<double>(total_quantization.bytes_before)
+                       << L"%), max error: position " << total_quantization.max_position_error << L", normal "
+                       << total_quantization.max_normal_error << L" deg, tangent "
+                       << total_quantization.max_tangent_error << L" deg, uv " << total_quantization.max_uv_error
+                       << std::endl;
+        }
+
+        for (const auto &sub: model.submeshes) {
+            if (sub.mesh.lods.size() < 2) {
+                continue;
+            }
+            std::wcout << L"  LODs for " << sub.material_name << L":";
+            for (const MeshLod &lod: sub.mesh.lods) {
+                std::wcout << L" " << lod.index_count / 3 << L" tris (err " << lod.error << L")";
+            }
+            std::wcout << std::endl;
+        }
+    }
+
+    // Every setting above, and the meshlet limits, change the meshes a cache file holds.
+    std::uint64_t ProcessingSettingsHash() {
+        std::vector<float> settings = {kOverdrawThreshold, kQuantizeVertices ? 1.0f : 0.0f,
+                                       kGenerateTangents ? 1.0f : 0.0f, static_cast<float>(Meshlets::kMaxVertices),
+                                       static_cast<float>(Meshlets::kMaxTriangles)};
+        settings.insert(settings.end(), kLodRatios.begin(), kLodRatios.end());
+        return MeshCache::HashSettings(settings);
+    }
+
+    // Prefers the binary mesh cache next to the OBJ and rebuilds it when the sources or the processing
+    // settings changed.
+    ObjModelData LoadObjModelCached(const std::wstring &obj_path, const std::wstring &mtl_path) {
+        const std::wstring cache_path = MeshCache::CachePathFor(obj_path);
+        MeshSourceStamp stamp;
+        const bool has_stamp = MeshCache::ComputeStamp(obj_path, mtl_path, stamp);
+        stamp.settings_hash = ProcessingSettingsHash();
+
+        ObjModelData model;
+        const auto load_start = std::chrono::steady_clock::now();
+        if (has_stamp && MeshCache::Load(cache_path, stamp, model)) {
+            ReportModelLoad(cache_path, model, load_start);
+            return model;
+        }
+
+        model = MeshLoader::LoadObjModel(obj_path, mtl_path);
+        ReportModelLoad(obj_path, model, load_start);
+        if (kGenerateTangents) {
+            // Tangent generation may split vertices, so it runs before the optimizer renumbers them.
+            MeshLoader::GenerateTangents(model);
+        }
+        OptimizeModel(obj_path, model);
+        if (has_stamp && !model.submeshes.empty()) {
+            if (MeshCache::Save(cache_path, stamp, model)) {
+                std::wcout << L"Wrote mesh cache " << cache_path << std::endl;
+            }
+        }
+        return model;
+    }
+
+    // True when the mesh's AABB, scaled like the object, reaches min_extent along its two longest axes: large and
+    // not thin in two directions, like walls, floors and columns, rather than small props.
+    bool IsOccluder(const MeshData &mesh, const DirectX::XMFLOAT3 &scale, float min_extent) {
+        if (min_extent <= 0.0f || mesh.bounds_radius <= 0.0f) {
+            return false;
+        }
+        std::array<float, 3> extent = {(mesh.bounds_max.x - mesh.bounds_min.x) * std::abs(scale.x),
+                                       (mesh.bounds_max.y - mesh.bounds_min.y) * std::abs(scale.y),
+                                       (mesh.bounds_max.z - mesh.bounds_min.z) * std::abs(scale.z)};
+        std::sort(extent.begin(), extent.end());
+        return extent[1] >= min_extent;
+    }
 }
 
 
@@ -41,7 +241,7 @@ std::vector<LoadedSubmesh> LoadModelWithCache(
         const SceneObjectConfig &obj,
         std::unordered_map<std::wstring, std::vector<LoadedSubmesh>> &model_cache,
         std::vector<std::unique_ptr<MeshBuffers>> &mesh_buffers,
-        Framework &framework) {
+        RenderDevice &device) {
     const std::wstring key = obj.obj_path + L"|" + obj.mtl_path;
 
     // ---------- Cache hit ----------
@@ -50,22 +250,39 @@ std::vector<LoadedSubmesh> LoadModelWithCache(
     }
 
     // ---------- Load model ----------
-    ObjModelData model = MeshLoader::LoadObjModel(obj.obj_path, obj.mtl_path);
+    ObjModelData model = LoadObjModelCached(obj.obj_path, obj.mtl_path);
     std::vector<LoadedSubmesh> result;
+    size_t occluder_count = 0;
+    size_t occluder_triangles = 0;
 
     for (auto &sub: model.submeshes) {
-        if (sub.mesh.vertex_count == 0 || sub.mesh.indices.empty())
+        if (sub.mesh.vertex_count == 0 || sub.mesh.IndexCount() == 0)
             continue;
 
-        auto buffers = framework.CreateMeshBuffers(sub.mesh);
+        auto buffers = device.CreateMeshBuffers(sub.mesh);
         if (!buffers)
             continue;
 
+        // Objects that share this model share its occluders, so the first object's scale decides them.
+        if (IsOccluder(sub.mesh, obj.scale, obj.occluder_min_extent)) {
+            auto occluder = std::make_shared<OccluderMesh>(MeshLoader::ExtractOccluder(sub.mesh));
+            if (!occluder->indices.empty()) {
+                occluder_triangles += occluder->indices.size() / 3;
+                buffers->occluder = std::move(occluder);
+                ++occluder_count;
+            }
+        }
+
         result.push_back({.mesh = buffers.get(), .texture_path = sub.diffuse_texture_path, .albedo = sub.albedo});
 
         mesh_buffers.push_back(std::move(buffers));
     }
 
+    if (occluder_count > 0) {
+        std::wcout << L"Occluders: " << occluder_count << L" submeshes of " << obj.obj_path << L", "
+                   << occluder_triangles << L" triangles" << std::endl;
+    }
+
     // ---------- Cache store ----------
     model_cache[key] = result;
 
@@ -75,11 +292,15 @@ std::vector<LoadedSubmesh> LoadModelWithCache(
 std::vector<LoadedSubmesh> GetPlaneFallback(
         MeshBuffers *&plane_mesh,
         std::vector<std::unique_ptr<MeshBuffers>> &mesh_buffers,
-        Framework &framework) {
+        RenderDevice &device) {
     if (!plane_mesh) {
         auto planeData = PlaneMesh::CreateUnit().ToMeshData();
+        MeshLoader::ComputeBounds(planeData);
+        if (kGenerateTangents) {
+            TangentGenerator::Generate(planeData);
+        }
 
-        if (auto buffers = framework.CreateMeshBuffers(planeData)) {
+        if (auto buffers = device.CreateMeshBuffers(planeData)) {
             plane_mesh = buffers.get();
             mesh_buffers.emplace_back(std::move(buffers));
         }
@@ -98,7 +319,7 @@ std::vector<LoadedSubmesh> GetPlaneFallback(
 RenderObject CreateRenderObject(
         const SceneObjectConfig &configObj,
         const LoadedSubmesh &sub,
-        Framework &framework,
+        RenderDevice &device,
         TextureResolver &texture_resolver,
         const RenderSettings &render_settings) {
     RenderObject obj{};
@@ -113,98 +334,148 @@ RenderObject CreateRenderObject(
         configObj,
         sub,
         texture_resolver,
-        framework,
+        device,
         render_settings);
 
     return obj;
 }
 
 
-bool RunApplication(Window &window, InputDevice &input_device) {
-    Framework framework;
-    if (!framework.Initialize(&window)) {
-        std::wcerr << L"Failed to initialize Framework!" << std::endl;
-        return false;
+namespace {
+    // Capture written by F9 (windowed) or --headless ... <file>; see CommandCapture.
+    const std::wstring kCaptureFile = L"frame.gfwcap";
+    // Replays of the last capture per F10 or headless run; enough to average out timer resolution.
+    constexpr UINT kCaptureReplays = 1000;
+
+    // Re-submits the last capture kCaptureReplays times and reports the CPU cost per replayed frame.
+    void ReplayLastCapture(RenderDevice &device) {
+        const CommandCapture &capture = device.GetLastCapture();
+        if (capture.IsEmpty()) {
+            std::wcout << L"No frame captured yet (F9)" << std::endl;
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        if (!device.ReplayCapture(capture, kCaptureReplays)) {
+            return;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::wcout << L"Replayed capture " << kCaptureReplays << L" times: " << ms / kCaptureReplays
+                   << L" ms/frame for " << capture.Stream().CommandCount() << L" commands" << std::endl;
     }
 
-    AppConfig config;
-    config.camera.position = {0.0f, 2.0f, -8.0f};
-    config.camera.target = {0.0f, 1.0f, 0.0f};
-
-    AddObjectsToConfig(config); // <- scene config
-
-    Camera initial_camera;
-    initial_camera.position = config.camera.position;
-    initial_camera.target = config.camera.target;
-    initial_camera.up = {0.0f, 1.0f, 0.0f};
-    framework.SetCamera(initial_camera);
-
-    std::vector<std::unique_ptr<MeshBuffers>> mesh_buffers;
-    std::unordered_map<std::wstring, std::vector<LoadedSubmesh>> model_cache;
-    MeshBuffers *plane_mesh = nullptr;
-    TextureResolver texture_resolver(framework);
-    std::vector<RenderObject> objects;
-
-    for (const SceneObjectConfig &configObj: config.objects) {
-
-        std::vector<LoadedSubmesh> submeshes;
-
-        if (!configObj.obj_path.empty()) {
-            submeshes = LoadModelWithCache(
-                    configObj,
-                    model_cache,
-                    mesh_buffers,
-                    framework
-            );
-        } else {
-            submeshes = GetPlaneFallback(plane_mesh, mesh_buffers, framework);
+    // Everything the frame loop renders; mesh_buffers owns the meshes objects point to.
+    struct SceneResources {
+        AppConfig config;
+        std::vector<std::unique_ptr<MeshBuffers>> mesh_buffers;
+        std::vector<RenderObject> objects;
+    };
+
+    // Initializes rendering_system, loads the configured scene and blocks until the pipelines of the first
+    // frame exist. Shared by the windowed and the headless frame loop.
+    bool LoadScene(RenderDevice &device, RenderingSystem &rendering_system, SceneResources &scene) {
+        AppConfig &config = scene.config;
+        config.camera.position = {0.0f, 2.0f, -8.0f};
+        config.camera.target = {0.0f, 1.0f, 0.0f};
+
+        AddObjectsToConfig(config); // <- scene config
+
+        // Before the scene loads, so its pipelines compile on background threads while meshes and textures load.
+        if (!rendering_system.Initialize(&device, device.GetWidth(), device.GetHeight())) {
+            std::wcerr << L"Failed to initialize deferred RenderingSystem." << std::endl;
+            return false;
         }
 
-        if (submeshes.empty()) {
-            std::wcerr << L"Skipped object '" << configObj.name
-                       << L"': failed to create mesh.\n";
-            continue;
+        // Apply render settings from config; they decide which pipeline permutations the scene needs.
+        rendering_system.SetDisplacementScale(config.render_settings.displacement_scale);
+        rendering_system.SetNormalDisplacementScale(config.render_settings.normal_displacement_scale);
+        rendering_system.SetTessellationParams(config.render_settings.tessellation_min_level,
+                                               config.render_settings.tessellation_max_level);
+        rendering_system.SetTessellationEnabled(config.render_settings.tessellation_enabled);
+
+        Camera initial_camera;
+        initial_camera.position = config.camera.position;
+        initial_camera.target = config.camera.target;
+        initial_camera.up = {0.0f, 1.0f, 0.0f};
+        device.SetCamera(initial_camera);
+
+        std::unordered_map<std::wstring, std::vector<LoadedSubmesh>> model_cache;
+        MeshBuffers *plane_mesh = nullptr;
+        TextureResolver texture_resolver(device);
+
+        for (const SceneObjectConfig &configObj: config.objects) {
+
+            std::vector<LoadedSubmesh> submeshes;
+
+            if (!configObj.obj_path.empty()) {
+                submeshes = LoadModelWithCache(
+                        configObj,
+                        model_cache,
+                        scene.mesh_buffers,
+                        device
+                );
+            } else {
+                submeshes = GetPlaneFallback(plane_mesh, scene.mesh_buffers, device);
+            }
+
+            if (submeshes.empty()) {
+                std::wcerr << L"Skipped object '" << configObj.name
+                           << L"': failed to create mesh.\n";
+                continue;
+            }
+
+            // ---------- Create render objects ----------
+            for (auto &sub: submeshes) {
+                scene.objects.push_back(CreateRenderObject(
+                        configObj,
+                        sub,
+                        device,
+                        texture_resolver,
+                        config.render_settings
+                ));
+            }
         }
 
-        // ---------- Create render objects ----------
-        for (auto &sub: submeshes) {
-            objects.push_back(CreateRenderObject(
-                    configObj,
-                    sub,
-                    framework,
-                    texture_resolver,
-                    config.render_settings
-            ));
+        if (scene.objects.empty()) {
+            std::wcerr << L"No valid scene objects configured." <<
+                       std::endl;
+            return false;
         }
+
+        // Submit every mesh and texture copy of the scene as one batch; it runs while the pipelines compile.
+        device.FlushUploads();
+        device.LogMemoryStats();
+
+        rendering_system.PrewarmPipelines(scene.objects);
+        return rendering_system.FinishPipelineStartup();
     }
+}
 
-    if (objects.empty()) {
-        std::wcerr << L"No valid scene objects configured." <<
-                   std::endl;
+
+bool RunApplication(Window &window, InputDevice &input_device) {
+    const auto startup_start = std::chrono::steady_clock::now();
+    Framework framework;
+    if (!framework.Initialize(&window)) {
+        std::wcerr << L"Failed to initialize Framework!" << std::endl;
         return false;
     }
 
+    RenderingSystem rendering_system;
+    SceneResources scene;
+    if (!LoadScene(framework, rendering_system, scene)) {
+        return false;
+    }
+    const AppConfig &config = scene.config;
+    std::vector<RenderObject> &objects = scene.objects;
+
     Timer timer;
     timer.Reset();
     GameControllerSettings game_settings = ToGameControllerSettings(config.controls);
     GameController game(game_settings);
 
-    RenderingSystem rendering_system;
-    if (!rendering_system.Initialize(&framework, window.GetWidth(), window.GetHeight())) {
-        std::wcerr << L"Failed to initialize deferred RenderingSystem." << std::endl;
-        return false;
-    }
     LightControlState light_control = {};
     SetupDefaultLocalLights(light_control);
     PushLightsToRenderingSystem(light_control, rendering_system);
 
-    // Apply render settings from config
-    rendering_system.SetDisplacementScale(config.render_settings.displacement_scale);
-    rendering_system.SetNormalDisplacementScale(config.render_settings.normal_displacement_scale);
-    rendering_system.SetTessellationParams(config.render_settings.tessellation_min_level,
-                                           config.render_settings.tessellation_max_level);
-    rendering_system.SetTessellationEnabled(config.render_settings.tessellation_enabled);
-
     PrintSceneLightingHelp();
     PrintTessellationAndDebugHelp();
 
@@ -221,6 +492,43 @@ bool RunApplication(Window &window, InputDevice &input_device) {
         std::cout << "Render Mode: " << (rendering_system.GetRenderMode() == RenderingSystem::RenderMode::Wireframe ? "WIREFRAME" : "SOLID") << std::endl;
     });
 
+    key_manager.RegisterKeyBinding(Keys::C, [&rendering_system]() {
+        rendering_system.SetClusterCullingEnabled(!rendering_system.IsClusterCullingEnabled());
+        std::cout << "Cluster Culling: " << (rendering_system.IsClusterCullingEnabled() ? "ENABLED" : "DISABLED") << std::endl;
+    });
+
+    key_manager.RegisterKeyBinding(Keys::B, [&rendering_system]() {
+        rendering_system.SetLodSelectionEnabled(!rendering_system.IsLodSelectionEnabled());
+        std::cout << "LOD Selection: " << (rendering_system.IsLodSelectionEnabled() ? "ENABLED" : "DISABLED") << std::endl;
+    });
+
+    key_manager.RegisterKeyBinding(Keys::M, [&rendering_system]() {
+        rendering_system.SetParallelRecordingEnabled(!rendering_system.IsParallelRecordingEnabled());
+        std::cout << "Multi-threaded GBuffer recording: "
+                  << (rendering_system.IsParallelRecordingEnabled() ? "ENABLED" : "DISABLED") << std::endl;
+    });
+
+    key_manager.RegisterKeyBinding(Keys::N, [&rendering_system]() {
+        rendering_system.SetFrustumCullingEnabled(!rendering_system.IsFrustumCullingEnabled());
+        const RenderingSystem::FrustumCullStats stats = rendering_system.GetFrustumCullStats();
+        std::cout << "Object Frustum Culling: " << (rendering_system.IsFrustumCullingEnabled() ? "ENABLED" : "DISABLED")
+                  << " (last frame: " << stats.visible << " of " << stats.objects << " objects visible)" << std::endl;
+    });
+
+    key_manager.RegisterKeyBinding(Keys::H, [&rendering_system]() {
+        rendering_system.SetSceneBvhEnabled(!rendering_system.IsSceneBvhEnabled());
+        std::cout << "Scene BVH culling: " << (rendering_system.IsSceneBvhEnabled() ? "ENABLED" : "DISABLED (linear)")
+                  << std::endl;
+    });
+
+    key_manager.RegisterKeyBinding(Keys::X, [&rendering_system]() {
+        rendering_system.SetOcclusionCullingEnabled(!rendering_system.IsOcclusionCullingEnabled());
+        const OcclusionCuller::Stats &stats = rendering_system.GetOcclusionStats();
+        std::cout << "Occlusion Culling: " << (rendering_system.IsOcclusionCullingEnabled() ? "ENABLED" : "DISABLED")
+                  << " (last frame: " << stats.occluded << " of " << stats.tested << " objects occluded by "
+                  << stats.occluders << " occluders, " << stats.triangles << " triangles)" << std::endl;
+    });
+
     key_manager.RegisterKeyBinding(Keys::D0, [&rendering_system]() {
         rendering_system.SetGBufferDebugMode(RenderingSystem::GBufferDebugMode::None);
         std::cout << "GBuffer Debug: OFF" << std::endl;
@@ -246,7 +554,31 @@ bool RunApplication(Window &window, InputDevice &input_device) {
         std::cout << "GBuffer Debug: DEPTH (from Position.Z)" << std::endl;
     });
 
+    key_manager.RegisterKeyBinding(Keys::P, [&framework]() {
+        const FramePacer::Timeline &timeline = framework.GetFrameTimeline();
+        std::cout << "Frame pacing (" << framework.GetFramesInFlight() << " in flight): CPU "
+                  << timeline.cpu_frame_ms << " ms, fence wait " << timeline.fence_wait_ms << " ms, GPU behind by "
+                  << timeline.frames_in_flight << " frames, overlap " << timeline.Overlap() * 100.0 << "%" << std::endl;
+        const UploadBatchState::Stats &uploads = framework.GetUploadStats();
+        std::cout << "Uploads: " << uploads.batches << " batches, " << uploads.copies << " copies, "
+                  << (uploads.bytes + 1023) / 1024 << " KB; last batch " << uploads.last.copies << " copies, "
+                  << (uploads.last.bytes + 1023) / 1024 << " KB" << std::endl;
+        const AssetStreamer::Stats streaming = framework.GetStreamingStats();
+        std::cout << "Streaming: " << streaming.batches << " batches, " << streaming.resources << " resources, "
+                  << (streaming.bytes + 1023) / 1024 << " KB; last batch " << streaming.last_resources
+                  << " resources, " << (streaming.last_bytes + 1023) / 1024 << " KB" << std::endl;
+    });
+
+    key_manager.RegisterKeyBinding(Keys::F9, [&framework]() {
+        framework.CaptureNextFrame(kCaptureFile);
+    });
+
+    key_manager.RegisterKeyBinding(Keys::F10, [&framework]() {
+        ReplayLastCapture(framework);
+    });
+
     // Main render loop
+    bool first_frame = true;
     while (window.IsRunning()) {
         window.ProcessMessages();
         timer.Tick();
@@ -264,6 +596,12 @@ bool RunApplication(Window &window, InputDevice &input_device) {
         framework.BeginFrame();
         rendering_system.Render(objects, static_cast<float>(timer.GetTotalTime()));
         framework.EndFrame();
+
+        if (first_frame) {
+            first_frame = false;
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_start).count();
+            std::wcout << L"First frame submitted " << ms << L" ms after startup" << std::endl;
+        }
     }
 
     rendering_system.Shutdown();
@@ -274,3 +612,72 @@ bool RunApplication(Window &window, InputDevice &input_device) {
 
 
 
+
+bool RunHeadless(std::uint32_t frame_count, std::uint32_t width, std::uint32_t height,
+                 const std::wstring &capture_file) {
+    NullRenderDevice device;
+    if (!device.Initialize(width, height)) {
+        std::wcerr << L"Failed to initialize the null render device!" << std::endl;
+        return false;
+    }
+
+    RenderingSystem rendering_system;
+    SceneResources scene;
+    if (!LoadScene(device, rendering_system, scene)) {
+        return false;
+    }
+
+    LightControlState light_control = {};
+    SetupDefaultLocalLights(light_control);
+
+    // A fixed time step and camera keep runs comparable; there is no input to drive the GameController.
+    constexpr double kFrameTime = 1.0 / 60.0;
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+    std::size_t commands = 0;
+    std::size_t draws = 0;
+    std::size_t stream_bytes = 0;
+    std::size_t visible_objects = 0;
+    std::size_t occluded_objects = 0;
+    for (std::uint32_t frame = 0; frame < frame_count; ++frame) {
+        const auto start = std::chrono::steady_clock::now();
+        PushLightsToRenderingSystem(light_control, rendering_system);
+        if (!capture_file.empty() && frame + 1 == frame_count) {
+            device.CaptureNextFrame(capture_file);
+        }
+        device.BeginFrame();
+        rendering_system.Render(scene.objects, static_cast<float>(frame * kFrameTime));
+        device.EndFrame();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        total_ms += ms;
+        min_ms = frame == 0 ? ms : std::min(min_ms, ms);
+        max_ms = std::max(max_ms, ms);
+        const CommandStream &submitted = device.GetSubmittedCommands();
+        commands += submitted.CommandCount();
+        draws += submitted.DrawCount();
+        stream_bytes += submitted.SizeBytes();
+        visible_objects += rendering_system.GetFrustumCullStats().visible;
+        occluded_objects += rendering_system.GetFrustumCullStats().occluded;
+    }
+
+    if (frame_count > 0) {
+        const double frames = static_cast<double>(frame_count);
+        std::wcout << L"Headless: " << frame_count << L" frames at " << width << L"x" << height << L", CPU "
+                   << total_ms / frames << L" ms/frame (min " << min_ms << L", max " << max_ms << L"), "
+                   << static_cast<double>(commands) / frames << L" commands and "
+                   << static_cast<double>(draws) / frames << L" draws per frame, "
+                   << static_cast<double>(stream_bytes) / frames / 1024.0 << L" KB recorded per frame, "
+                   << static_cast<double>(visible_objects) / frames << L" of " << scene.objects.size()
+                   << L" objects drawn, " << static_cast<double>(occluded_objects) / frames
+                   << L" in the frustum but occluded" << std::endl;
+    }
+    if (!capture_file.empty()) {
+        ReplayLastCapture(device);
+    }
+
+    rendering_system.Shutdown();
+    device.Shutdown();
+    return true;
+}
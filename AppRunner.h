@@ -1,8 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 namespace gfw {
 class Window;
 class InputDevice;
 }
 
 bool RunApplication(gfw::Window &window, gfw::InputDevice &input_device);
+
+// Loads the same scene and runs frame_count frames on the null render backend without a window, then reports
+// the CPU time per frame. With a capture_file the last frame is captured to it and replayed in place.
+bool RunHeadless(std::uint32_t frame_count, std::uint32_t width, std::uint32_t height,
+                 const std::wstring &capture_file = {});
@@ -0,0 +1,197 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace gfw {
+    namespace {
+        // Radius and extents of an unbounded object: large enough to pass every plane, finite so that a zero plane
+        // component times the extent stays zero instead of NaN.
+        constexpr float kUnbounded = std::numeric_limits<float>::max();
+
+        // Writes the index of every set bit of a block's mask; bit i is object base + i.
+        std::size_t AppendVisible(std::uint32_t mask, std::size_t base, std::uint32_t *out) {
+            std::size_t written = 0;
+            while (mask != 0) {
+                out[written++] = static_cast<std::uint32_t>(base + std::countr_zero(mask));
+                mask &= mask - 1;
+            }
+            return written;
+        }
+    }
+
+    FrustumCuller::Frustum FrustumCuller::ExtractFrustum(const XMFLOAT4X4 &m) {
+        const XMFLOAT4 planes[6] = {
+            {m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41}, // left
+            {m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41}, // right
+            {m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42}, // bottom
+            {m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42}, // top
+            {m._13, m._23, m._33, m._43},                                 // near
+            {m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43}, // far
+        };
+        Frustum frustum;
+        for (int i = 0; i < 6; ++i) {
+            const float length = std::sqrt(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+            const float inv = length > 0.0f ? 1.0f / length : 0.0f;
+            frustum.planes[i] = {planes[i].x * inv, planes[i].y * inv, planes[i].z * inv, planes[i].w * inv};
+        }
+        return frustum;
+    }
+
+    void FrustumCuller::Resize(std::size_t count) {
+        const std::size_t padded = (count + kLaneCount - 1) / kLaneCount * kLaneCount;
+        const std::size_t old_count = count_;
+        for (std::vector<float> *lane : {&center_x_, &center_y_, &center_z_, &extent_x_, &extent_y_, &extent_z_, &radius_}) {
+            lane->resize(padded, 0.0f);
+        }
+        count_ = count;
+        for (std::size_t i = old_count; i < count; ++i) {
+            SetUnbounded(i);
+        }
+    }
+
+    void FrustumCuller::SetBounds(std::size_t index, const XMFLOAT3 &aabb_min, const XMFLOAT3 &aabb_max,
+                                  float sphere_radius, const XMFLOAT4X4 &world, float margin) {
+        const XMFLOAT3 center = {(aabb_min.x + aabb_max.x) * 0.5f, (aabb_min.y + aabb_max.y) * 0.5f,
+                                 (aabb_min.z + aabb_max.z) * 0.5f};
+        const XMFLOAT3 extent = {(aabb_max.x - aabb_min.x) * 0.5f + margin, (aabb_max.y - aabb_min.y) * 0.5f + margin,
+                                 (aabb_max.z - aabb_min.z) * 0.5f + margin};
+        const float rows[3][3] = {{world._11, world._12, world._13},
+                                  {world._21, world._22, world._23},
+                                  {world._31, world._32, world._33}};
+
+        center_x_[index] = center.x * rows[0][0] + center.y * rows[1][0] + center.z * rows[2][0] + world._41;
+        center_y_[index] = center.x * rows[0][1] + center.y * rows[1][1] + center.z * rows[2][1] + world._42;
+        center_z_[index] = center.x * rows[0][2] + center.y * rows[1][2] + center.z * rows[2][2] + world._43;
+        // Arvo: the world AABB of a transformed box has the absolute matrix applied to its extent.
+        extent_x_[index] = extent.x * std::abs(rows[0][0]) + extent.y * std::abs(rows[1][0]) + extent.z * std::abs(rows[2][0]);
+        extent_y_[index] = extent.x * std::abs(rows[0][1]) + extent.y * std::abs(rows[1][1]) + extent.z * std::abs(rows[2][1]);
+        extent_z_[index] = extent.x * std::abs(rows[0][2]) + extent.y * std::abs(rows[1][2]) + extent.z * std::abs(rows[2][2]);
+
+        float max_scale_sq = 0.0f;
+        for (const auto &row : rows) {
+            max_scale_sq = std::max(max_scale_sq, row[0] * row[0] + row[1] * row[1] + row[2] * row[2]);
+        }
+        radius_[index] = (sphere_radius + margin) * std::sqrt(max_scale_sq);
+    }
+
+    void FrustumCuller::SetUnbounded(std::size_t index) {
+        center_x_[index] = 0.0f;
+        center_y_[index] = 0.0f;
+        center_z_[index] = 0.0f;
+        extent_x_[index] = kUnbounded;
+        extent_y_[index] = kUnbounded;
+        extent_z_[index] = kUnbounded;
+        radius_[index] = kUnbounded;
+    }
+
+    std::size_t FrustumCuller::Cull(const Frustum &frustum, std::vector<std::uint32_t> &visible) const {
+        visible.resize(count_);
+        std::uint32_t *out = visible.data();
+        std::size_t written = 0;
+        const std::size_t block_count = (count_ + kLaneCount - 1) / kLaneCount;
+
+#if defined(__AVX__)
+        __m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        for (int p = 0; p < 6; ++p) {
+            nx[p] = _mm256_set1_ps(frustum.planes[p].x);
+            ny[p] = _mm256_set1_ps(frustum.planes[p].y);
+            nz[p] = _mm256_set1_ps(frustum.planes[p].z);
+            nw[p] = _mm256_set1_ps(frustum.planes[p].w);
+            ax[p] = _mm256_andnot_ps(sign, nx[p]);
+            ay[p] = _mm256_andnot_ps(sign, ny[p]);
+            az[p] = _mm256_andnot_ps(sign, nz[p]);
+        }
+        for (std::size_t block = 0; block < block_count; ++block) {
+            const std::size_t base = block * kLaneCount;
+            const __m256 cx = _mm256_loadu_ps(center_x_.data() + base);
+            const __m256 cy = _mm256_loadu_ps(center_y_.data() + base);
+            const __m256 cz = _mm256_loadu_ps(center_z_.data() + base);
+            const __m256 ex = _mm256_loadu_ps(extent_x_.data() + base);
+            const __m256 ey = _mm256_loadu_ps(extent_y_.data() + base);
+            const __m256 ez = _mm256_loadu_ps(extent_z_.data() + base);
+            const __m256 radius = _mm256_loadu_ps(radius_.data() + base);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                const __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)),
+                    _mm256_add_ps(_mm256_mul_ps(nz[p], cz), nw[p]));
+                const __m256 box = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)),
+                                                 _mm256_mul_ps(az[p], ez));
+                const __m256 reach = _mm256_xor_ps(_mm256_min_ps(radius, box), sign);
+                // Not-less-than keeps NaN distances visible.
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, reach, _CMP_NLT_UQ));
+            }
+            std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_ps(inside));
+            if (base + kLaneCount > count_) {
+                mask &= (1u << (count_ - base)) - 1u;
+            }
+            written += AppendVisible(mask, base, out + written);
+        }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        for (int p = 0; p < 6; ++p) {
+            nx[p] = _mm_set1_ps(frustum.planes[p].x);
+            ny[p] = _mm_set1_ps(frustum.planes[p].y);
+            nz[p] = _mm_set1_ps(frustum.planes[p].z);
+            nw[p] = _mm_set1_ps(frustum.planes[p].w);
+            ax[p] = _mm_andnot_ps(sign, nx[p]);
+            ay[p] = _mm_andnot_ps(sign, ny[p]);
+            az[p] = _mm_andnot_ps(sign, nz[p]);
+        }
+        for (std::size_t block = 0; block < block_count; ++block) {
+            const std::size_t base = block * kLaneCount;
+            const __m128 cx = _mm_loadu_ps(center_x_.data() + base);
+            const __m128 cy = _mm_loadu_ps(center_y_.data() + base);
+            const __m128 cz = _mm_loadu_ps(center_z_.data() + base);
+            const __m128 ex = _mm_loadu_ps(extent_x_.data() + base);
+            const __m128 ey = _mm_loadu_ps(extent_y_.data() + base);
+            const __m128 ez = _mm_loadu_ps(extent_z_.data() + base);
+            const __m128 radius = _mm_loadu_ps(radius_.data() + base);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)),
+                                                   _mm_add_ps(_mm_mul_ps(nz[p], cz), nw[p]));
+                const __m128 box = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+                                              _mm_mul_ps(az[p], ez));
+                const __m128 reach = _mm_xor_ps(_mm_min_ps(radius, box), sign);
+                // Not-less-than keeps NaN distances visible.
+                inside = _mm_and_ps(inside, _mm_cmpnlt_ps(distance, reach));
+            }
+            std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_ps(inside));
+            if (base + kLaneCount > count_) {
+                mask &= (1u << (count_ - base)) - 1u;
+            }
+            written += AppendVisible(mask, base, out + written);
+        }
+#else
+        for (std::size_t i = 0; i < count_; ++i) {
+            bool inside = true;
+            for (const XMFLOAT4 &plane : frustum.planes) {
+                const float distance =
+                    plane.x * center_x_[i] + plane.y * center_y_[i] + plane.z * center_z_[i] + plane.w;
+                const float box = std::abs(plane.x) * extent_x_[i] + std::abs(plane.y) * extent_y_[i] +
+                                  std::abs(plane.z) * extent_z_[i];
+                inside = inside && !(distance < -std::min(radius_[i], box));
+            }
+            if (inside) {
+                out[written++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        (void) block_count;
+#endif
+
+        visible.resize(written);
+        return count_ - written;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfw {
+    // World-space bounds of a scene's objects in SoA arrays, tested against a view frustum 8 (AVX) or 4 (SSE2)
+    // objects per iteration. Every object has an AABB and a sphere around the same center; a plane culls it when
+    // either volume is entirely outside, so each plane uses the tighter of the two radii.
+    class FrustumCuller {
+    public:
+#if defined(__AVX__)
+        static constexpr std::size_t kLaneCount = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        static constexpr std::size_t kLaneCount = 4;
+#else
+        static constexpr std::size_t kLaneCount = 1;
+#endif
+
+        // Planes point inwards and are normalized: p is inside when dot(plane.xyz, p) + plane.w >= 0.
+        struct Frustum {
+            DirectX::XMFLOAT4 planes[6] = {};
+        };
+
+        // Gribb/Hartmann extraction from a row-vector view-projection matrix with [0, 1] clip depth.
+        static Frustum ExtractFrustum(const DirectX::XMFLOAT4X4 &view_proj);
+
+        // Objects added by growing start unbounded, i.e. always visible.
+        void Resize(std::size_t count);
+        [[nodiscard]] std::size_t Size() const { return count_; }
+
+        // Object-space AABB plus the radius of a sphere around its center, placed by world (row vectors).
+        // margin grows both in object space, e.g. for displacement the bounds do not include.
+        void SetBounds(std::size_t index, const DirectX::XMFLOAT3 &aabb_min, const DirectX::XMFLOAT3 &aabb_max,
+                       float sphere_radius, const DirectX::XMFLOAT4X4 &world, float margin = 0.0f);
+        void SetUnbounded(std::size_t index);
+
+        // Replaces visible with the indices of objects that may intersect the frustum, in ascending order, and
+        // returns how many were culled.
+        std::size_t Cull(const Frustum &frustum, std::vector<std::uint32_t> &visible) const;
+
+    private:
+        std::size_t count_ = 0;
+        // Padded to a multiple of kLaneCount; Cull masks the lanes past count_.
+        std::vector<float> center_x_;
+        std::vector<float> center_y_;
+        std::vector<float> center_z_;
+        std::vector<float> extent_x_;
+        std::vector<float> extent_y_;
+        std::vector<float> extent_z_;
+        std::vector<float> radius_;
+    };
+}
@@ -1,39 +1,41 @@
 #pragma once
 
 #include <array>
-#include <d3d12.h>
-#include <wrl/client.h>
+#include <cstdint>
+#include "framework/CommandRecorder.h"
+#include "framework/RenderDevice.h"
 
 namespace gfw {
 class GBuffer {
 public:
-    static constexpr UINT kTargetCount = 3;
+    static constexpr std::uint32_t kTargetCount = 3;
+    // World position, world normal, albedo.
+    static constexpr std::array<Format, kTargetCount> kFormats = {
+        Format::R16G16B16A16Float, Format::R16G16B16A16Float, Format::R8G8B8A8Unorm
+    };
 
-    bool Initialize(ID3D12Device *device, UINT width, UINT height);
+    // The targets belong to device, which must outlive the GBuffer.
+    bool Initialize(RenderDevice &device, std::uint32_t width, std::uint32_t height);
+    // Releases the targets after the frame being recorded, the last one that may use them.
     void Shutdown();
 
-    void TransitionToRenderTargets(ID3D12GraphicsCommandList *cmd) const;
-    void TransitionToShaderResources(ID3D12GraphicsCommandList *cmd) const;
-    void Clear(ID3D12GraphicsCommandList *cmd) const;
+    void TransitionToRenderTargets(CommandRecorder &cmd) const;
+    void TransitionToShaderResources(CommandRecorder &cmd) const;
+    void Clear(CommandRecorder &cmd) const;
 
-    [[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetRtv(UINT index) const;
-    [[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GetSrv(UINT index) const;
-    [[nodiscard]] ID3D12DescriptorHeap *GetSrvHeap() const { return srv_heap_.Get(); }
+    [[nodiscard]] CpuDescriptor GetRtv(std::uint32_t index) const;
+    [[nodiscard]] GpuDescriptor GetSrv(std::uint32_t index) const;
+    [[nodiscard]] DescriptorHeapHandle GetSrvHeap() const { return srv_heap_; }
 
 private:
-    struct Target {
-        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
-        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-    };
+    void Transition(CommandRecorder &cmd, ResourceState before, ResourceState after) const;
 
-    ID3D12Device *device_ = nullptr;
-    UINT width_ = 0;
-    UINT height_ = 0;
-    UINT rtv_stride_ = 0;
-    UINT srv_stride_ = 0;
+    RenderDevice *device_ = nullptr;
+    std::uint32_t width_ = 0;
+    std::uint32_t height_ = 0;
 
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtv_heap_;
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srv_heap_;
-    std::array<Target, kTargetCount> targets_ = {};
+    DescriptorHeapHandle rtv_heap_;
+    DescriptorHeapHandle srv_heap_;
+    std::array<ResourceHandle, kTargetCount> targets_ = {};
 };
 }
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace gfw {
+
+// Feature bits of a GBuffer draw. Material features become compile-time defines of the GBuffer shaders, so
+// an absent feature costs neither a texture fetch nor a branch; the vertex format bits pick the input layout.
+enum GeometryFeature : std::uint32_t {
+    kGeometryNormalMap = 1u << 0,      // NORMAL_MAP
+    kGeometryDisplacement = 1u << 1,   // DISPLACEMENT, tessellated draws only
+    kGeometryAlphaTest = 1u << 2,      // ALPHA_TEST: discard base color alpha below 0.5
+    kGeometryTessellation = 1u << 3,   // hull and domain stages, patch topology
+    kGeometryWireframe = 1u << 4,      // fill mode only
+    kGeometryQuantizedVertex = 1u << 5, // QUANTIZED_VERTEX, VertexFormat::Quantized
+    kGeometryVertexTangents = 1u << 6,  // VERTEX_TANGENTS when normal mapped without tessellation
+};
+
+inline constexpr std::uint32_t kGeometryFeatureCount = 7;
+
+enum class GeometryStage { Vertex, Hull, Domain, Pixel };
+
+// Drops bits that cannot change the pipeline, so equivalent draws share one key.
+[[nodiscard]] inline std::uint32_t NormalizeGeometryFeatures(std::uint32_t features) {
+    if (!(features & kGeometryTessellation)) {
+        features &= ~kGeometryDisplacement;
+    }
+    return features;
+}
+
+// Defines (each set to 1) a stage is compiled with, in the order shaders/Shaders.cmake lists them.
+struct StageDefines {
+    std::array<const char *, 3> names = {};
+    std::uint32_t count = 0;
+
+    void Add(const char *name) { names[count++] = name; }
+};
+
+[[nodiscard]] inline StageDefines GeometryStageDefines(std::uint32_t features, GeometryStage stage) {
+    const bool tessellated = (features & kGeometryTessellation) != 0;
+    const bool normal_map = (features & kGeometryNormalMap) != 0;
+    // The domain shader builds its own tangent frame, and without a normal map tangents are never read.
+    const bool vertex_tangents = (features & kGeometryVertexTangents) && normal_map && !tessellated;
+
+    StageDefines defines;
+    switch (stage) {
+        case GeometryStage::Vertex:
+            if (features & kGeometryQuantizedVertex) defines.Add("QUANTIZED_VERTEX");
+            if (vertex_tangents) defines.Add("VERTEX_TANGENTS");
+            break;
+        case GeometryStage::Hull:
+            break;
+        case GeometryStage::Domain:
+            if (normal_map) defines.Add("NORMAL_MAP");
+            if (features & kGeometryDisplacement) defines.Add("DISPLACEMENT");
+            break;
+        case GeometryStage::Pixel:
+            if (vertex_tangents) defines.Add("VERTEX_TANGENTS");
+            if (normal_map) defines.Add("NORMAL_MAP");
+            if (features & kGeometryAlphaTest) defines.Add("ALPHA_TEST");
+            break;
+    }
+    return defines;
+}
+
+// Every distinct normalized feature set, i.e. every pipeline the GBuffer pass can ask for.
+[[nodiscard]] inline std::vector<std::uint32_t> EnumerateGeometryPermutations() {
+    std::vector<std::uint32_t> permutations;
+    for (std::uint32_t features = 0; features < (1u << kGeometryFeatureCount); ++features) {
+        if (NormalizeGeometryFeatures(features) == features) {
+            permutations.push_back(features);
+        }
+    }
+    return permutations;
+}
+
+}
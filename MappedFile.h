@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace gfw {
+
+// Read-only memory mapping of a whole file. An empty file opens successfully with Data() == nullptr.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool Open(const std::wstring &filename);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return is_open_; }
+    [[nodiscard]] const char *Data() const { return data_; }
+    [[nodiscard]] std::size_t Size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool is_open_ = false;
+#ifdef _WIN32
+    void *file_handle_ = nullptr;
+    void *mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace gfw
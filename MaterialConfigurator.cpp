@@ -11,7 +11,7 @@ void MaterialConfigurator::ConfigureMaterial(
     const SceneObjectConfig &config,
     const LoadedSubmesh &submesh,
     TextureResolver &resolver,
-    Framework &framework,
+    RenderDevice &device,
     const RenderSettings &render_settings) {
 
     obj.uv_params = {render_settings.uv_scale.x, render_settings.uv_scale.y,
@@ -23,11 +23,11 @@ void MaterialConfigurator::ConfigureMaterial(
             break;
 
         case MaterialMode::SolidColor:
-            ConfigureSolidColorMaterial(obj, framework, config);
+            ConfigureSolidColorMaterial(obj, device, config);
             break;
 
         case MaterialMode::Rainbow:
-            ConfigureRainbowMaterial(obj, framework, config);
+            ConfigureRainbowMaterial(obj, device, config);
             break;
     }
 }
@@ -61,17 +61,17 @@ void MaterialConfigurator::ConfigureTexturedMaterial(
 
 void MaterialConfigurator::ConfigureSolidColorMaterial(
     RenderObject &obj,
-    Framework &framework,
+    RenderDevice &device,
     const SceneObjectConfig &config) {
-    obj.texture = framework.CreateSolidTexture({1, 1, 1, 1});
+    obj.texture = device.CreateSolidTexture({1, 1, 1, 1});
     obj.albedo = config.solid_color;
 }
 
 void MaterialConfigurator::ConfigureRainbowMaterial(
     RenderObject &obj,
-    Framework &framework,
+    RenderDevice &device,
     const SceneObjectConfig &config) {
-    obj.texture = framework.CreateSolidTexture({1, 1, 1, 1});
+    obj.texture = device.CreateSolidTexture({1, 1, 1, 1});
     obj.albedo = {1, 1, 1, 1};
     obj.effect_params = {1.0f, config.rainbow_speed, 0.0f, 0.0f};
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <memory>
-#include "framework/Framework.h"
+#include "framework/RenderDevice.h"
 #include "SceneConfig.h"
 #include "MeshData.h"
 
@@ -24,7 +24,7 @@ public:
         const SceneObjectConfig &config,
         const LoadedSubmesh &submesh,
         TextureResolver &resolver,
-        Framework &framework,
+        RenderDevice &device,
         const RenderSettings &render_settings);
 
 private:
@@ -36,12 +36,12 @@ private:
 
     static void ConfigureSolidColorMaterial(
         RenderObject &obj,
-        Framework &framework,
+        RenderDevice &device,
         const SceneObjectConfig &config);
 
     static void ConfigureRainbowMaterial(
         RenderObject &obj,
-        Framework &framework,
+        RenderDevice &device,
         const SceneObjectConfig &config);
 };
 
@@ -0,0 +1,379 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace gfw {
+
+namespace {
+    constexpr char kMagic[8] = {'G', 'F', 'W', 'M', 'E', 'S', 'H', '\0'};
+    constexpr std::uint32_t kVersion = 9;
+    constexpr std::size_t kBlobAlignment = 16;
+    constexpr std::uint32_t kVertexHasTangents = 1u;
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t submesh_count;
+        std::uint64_t obj_size;
+        std::int64_t obj_mtime;
+        std::uint64_t mtl_size;
+        std::int64_t mtl_mtime;
+        std::uint64_t content_hash;
+        std::uint64_t settings_hash;
+        std::uint64_t file_size;
+    };
+    static_assert(sizeof(FileHeader) == 72);
+
+    // Offsets are from the start of the file; strings are stored as UTF-16 code units.
+    struct SubmeshRecord {
+        std::uint64_t vertex_offset;
+        std::uint64_t index_offset;
+        std::uint64_t name_offset;
+        std::uint64_t texture_offset;
+        std::uint64_t meshlet_offset;
+        std::uint32_t meshlet_count;
+        std::uint32_t meshlet_size; // sizeof(Meshlet) at write time
+        std::uint64_t lod_offset;
+        std::uint32_t lod_count;
+        std::uint32_t lod_size; // sizeof(MeshLod) at write time
+        std::uint32_t vertex_stride;
+        std::uint32_t vertex_count;
+        std::uint32_t index_count;
+        std::uint32_t index_size; // 2 or 4 bytes
+        std::uint32_t name_length;
+        std::uint32_t texture_length;
+        std::uint32_t topology;
+        std::uint32_t vertex_format; // VertexFormat
+        std::uint32_t vertex_flags;  // kVertexHasTangents
+        float bounds_radius;
+        float albedo[4];
+        float bounds_min[3];
+        float bounds_max[3];
+    };
+    static_assert(sizeof(SubmeshRecord) == 144);
+    static_assert(std::is_trivially_copyable_v<Meshlet>);
+    static_assert(std::is_trivially_copyable_v<MeshLod>);
+
+    std::uint64_t HashBytes(const char *data, std::size_t size, std::uint64_t hash) {
+        constexpr std::uint64_t kMul0 = 0x9e3779b97f4a7c15ull;
+        constexpr std::uint64_t kMul1 = 0xbf58476d1ce4e5b9ull;
+        std::size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash ^= word * kMul0;
+            hash = ((hash << 31) | (hash >> 33)) * kMul1;
+        }
+        for (; i < size; ++i) {
+            hash ^= static_cast<std::uint8_t>(data[i]);
+            hash *= kMul0;
+        }
+        return hash ^ (hash >> 32);
+    }
+
+    bool StampFile(const std::wstring &path, std::uint64_t &size, std::int64_t &mtime, std::uint64_t &hash) {
+        std::error_code ec;
+        const auto write_time = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return false;
+        }
+        MappedFile file;
+        if (!file.Open(path)) {
+            return false;
+        }
+        size = file.Size();
+        mtime = static_cast<std::int64_t>(write_time.time_since_epoch().count());
+        hash = HashBytes(file.Data(), file.Size(), hash ^ size);
+        return true;
+    }
+
+    // Vertex layouts as documented in MeshData.h.
+    std::uint32_t VertexStride(VertexFormat format, bool has_tangents) {
+        if (format == VertexFormat::Quantized) {
+            return has_tangents ? 20u : 16u;
+        }
+        return has_tangents ? 48u : 32u;
+    }
+
+    // Every range a draw reads has to stay inside the mesh's own index buffer. Index values themselves are
+    // trusted: the file was written from the source the content-hashed stamp identifies.
+    bool RangesValid(const MeshData &mesh) {
+        const std::uint64_t index_count = mesh.IndexCount();
+        if (mesh.topology == PrimitiveTopology::TriangleList && index_count % 3 != 0) {
+            return false;
+        }
+        for (const MeshLod &lod : mesh.lods) {
+            if (lod.index_count % 3 != 0 || std::uint64_t{lod.index_offset} + lod.index_count > index_count) {
+                return false;
+            }
+        }
+        for (const Meshlet &meshlet : mesh.meshlets) {
+            if (std::uint64_t{meshlet.index_offset} + std::uint64_t{meshlet.triangle_count} * 3 > index_count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t AlignUp(std::size_t value) {
+        return (value + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+    }
+
+    bool InRange(std::uint64_t offset, std::uint64_t bytes, std::size_t file_size) {
+        return offset <= file_size && bytes <= file_size - offset;
+    }
+
+    std::wstring ReadString(const char *base, std::uint64_t offset, std::uint32_t length) {
+        std::wstring out(length, L'\0');
+        for (std::uint32_t i = 0; i < length; ++i) {
+            char16_t unit;
+            std::memcpy(&unit, base + offset + i * sizeof(char16_t), sizeof(unit));
+            out[i] = static_cast<wchar_t>(unit);
+        }
+        return out;
+    }
+
+    std::uint64_t AppendString(std::vector<char> &blob, const std::wstring &text) {
+        const std::size_t offset = AlignUp(blob.size());
+        blob.resize(offset + text.size() * sizeof(char16_t));
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            const auto unit = static_cast<char16_t>(text[i]);
+            std::memcpy(blob.data() + offset + i * sizeof(char16_t), &unit, sizeof(unit));
+        }
+        return offset;
+    }
+}
+
+std::wstring MeshCache::CachePathFor(const std::wstring &obj_filename) {
+    return std::filesystem::path(obj_filename).replace_extension(L".gfwmesh").wstring();
+}
+
+bool MeshCache::ComputeStamp(const std::wstring &obj_filename, const std::wstring &mtl_filename,
+                             MeshSourceStamp &stamp) {
+    stamp = {};
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    if (!StampFile(obj_filename, stamp.obj_size, stamp.obj_mtime, hash)) {
+        return false;
+    }
+    // The MTL is optional; a missing one still has to match a cache written without it.
+    const std::wstring mtl_path = MeshLoader::ResolveMtlPath(obj_filename, mtl_filename);
+    hash = HashBytes(reinterpret_cast<const char *>(mtl_path.data()), mtl_path.size() * sizeof(wchar_t), hash);
+    if (!mtl_path.empty() && !StampFile(mtl_path, stamp.mtl_size, stamp.mtl_mtime, hash)) {
+        return false;
+    }
+    stamp.content_hash = hash;
+    return true;
+}
+
+std::uint64_t MeshCache::HashSettings(const std::vector<float> &settings) {
+    return HashBytes(reinterpret_cast<const char *>(settings.data()), settings.size() * sizeof(float),
+                     0xcbf29ce484222325ull ^ settings.size());
+}
+
+bool MeshCache::Load(const std::wstring &cache_filename, const MeshSourceStamp &stamp, ObjModelData &model) {
+    // Loaded meshes view their vertex and index blobs in the mapping, so it lives as long as the last of them.
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(cache_filename) || file->Size() < sizeof(FileHeader)) {
+        return false;
+    }
+
+    const char *base = file->Data();
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        return false;
+    }
+    const MeshSourceStamp cached = {header.obj_size, header.obj_mtime, header.mtl_size, header.mtl_mtime,
+                                    header.content_hash, header.settings_hash};
+    if (!(cached == stamp)) {
+        return false;
+    }
+    if (header.file_size != file->Size() ||
+        !InRange(sizeof(FileHeader), std::uint64_t{header.submesh_count} * sizeof(SubmeshRecord), file->Size())) {
+        std::wcerr << L"Malformed mesh cache: " << cache_filename << std::endl;
+        return false;
+    }
+
+    ObjModelData loaded;
+    loaded.submeshes.resize(header.submesh_count);
+    for (std::uint32_t i = 0; i < header.submesh_count; ++i) {
+        SubmeshRecord record;
+        std::memcpy(&record, base + sizeof(FileHeader) + i * sizeof(SubmeshRecord), sizeof(record));
+
+        const std::uint64_t vertex_bytes = std::uint64_t{record.vertex_count} * record.vertex_stride;
+        const std::uint64_t index_bytes = std::uint64_t{record.index_count} * record.index_size;
+        const bool has_tangents = (record.vertex_flags & kVertexHasTangents) != 0;
+        if ((record.index_size != 2 && record.index_size != 4) || record.index_offset % record.index_size != 0 ||
+            record.topology != static_cast<std::uint32_t>(PrimitiveTopology::TriangleList) ||
+            record.vertex_format > static_cast<std::uint32_t>(VertexFormat::Quantized) ||
+            record.vertex_stride != VertexStride(static_cast<VertexFormat>(record.vertex_format), has_tangents) ||
+            !InRange(record.vertex_offset, vertex_bytes, file->Size()) ||
+            !InRange(record.index_offset, index_bytes, file->Size()) ||
+            !InRange(record.name_offset, std::uint64_t{record.name_length} * sizeof(char16_t), file->Size()) ||
+            !InRange(record.texture_offset, std::uint64_t{record.texture_length} * sizeof(char16_t), file->Size()) ||
+            (record.meshlet_count > 0 && record.meshlet_size != sizeof(Meshlet)) ||
+            !InRange(record.meshlet_offset, std::uint64_t{record.meshlet_count} * sizeof(Meshlet), file->Size()) ||
+            (record.lod_count > 0 && record.lod_size != sizeof(MeshLod)) ||
+            !InRange(record.lod_offset, std::uint64_t{record.lod_count} * sizeof(MeshLod), file->Size())) {
+            std::wcerr << L"Malformed mesh cache: " << cache_filename << std::endl;
+            return false;
+        }
+
+        ObjSubmeshData &sub = loaded.submeshes[i];
+        sub.material_name = ReadString(base, record.name_offset, record.name_length);
+        sub.diffuse_texture_path = ReadString(base, record.texture_offset, record.texture_length);
+        sub.albedo = {record.albedo[0], record.albedo[1], record.albedo[2], record.albedo[3]};
+
+        MeshData &mesh = sub.mesh;
+        mesh.vertex_stride = record.vertex_stride;
+        mesh.vertex_count = record.vertex_count;
+        mesh.topology = static_cast<PrimitiveTopology>(record.topology);
+        mesh.vertex_format = static_cast<VertexFormat>(record.vertex_format);
+        mesh.has_tangents = has_tangents;
+        mesh.bounds_min = {record.bounds_min[0], record.bounds_min[1], record.bounds_min[2]};
+        mesh.bounds_max = {record.bounds_max[0], record.bounds_max[1], record.bounds_max[2]};
+        mesh.bounds_radius = record.bounds_radius;
+        mesh.view.owner = file;
+        mesh.view.vertices = reinterpret_cast<const std::uint8_t *>(base + record.vertex_offset);
+        mesh.view.indices = reinterpret_cast<const std::uint8_t *>(base + record.index_offset);
+        mesh.view.index_count = record.index_count;
+        mesh.view.index_size = record.index_size;
+        mesh.lods.resize(record.lod_count);
+        if (record.lod_count > 0) {
+            std::memcpy(mesh.lods.data(), base + record.lod_offset, record.lod_count * sizeof(MeshLod));
+        }
+        mesh.meshlets.resize(record.meshlet_count);
+        if (record.meshlet_count > 0) {
+            std::memcpy(mesh.meshlets.data(), base + record.meshlet_offset, record.meshlet_count * sizeof(Meshlet));
+        }
+        if (!RangesValid(mesh)) {
+            std::wcerr << L"Malformed mesh cache: " << cache_filename << std::endl;
+            return false;
+        }
+    }
+
+    model = std::move(loaded);
+    return true;
+}
+
+bool MeshCache::Save(const std::wstring &cache_filename, const MeshSourceStamp &stamp, const ObjModelData &model) {
+    const auto submesh_count = static_cast<std::uint32_t>(model.submeshes.size());
+    std::vector<char> blob(sizeof(FileHeader) + submesh_count * sizeof(SubmeshRecord));
+    std::vector<SubmeshRecord> records(submesh_count);
+
+    for (std::uint32_t i = 0; i < submesh_count; ++i) {
+        const ObjSubmeshData &sub = model.submeshes[i];
+        const MeshData &mesh = sub.mesh;
+        SubmeshRecord &record = records[i];
+        record = {};
+        record.vertex_stride = mesh.vertex_stride;
+        record.vertex_count = mesh.vertex_count;
+        record.index_count = mesh.IndexCount();
+        record.index_size = mesh.vertex_count <= 0x10000u ? 2 : 4;
+        record.topology = static_cast<std::uint32_t>(mesh.topology);
+        record.vertex_format = static_cast<std::uint32_t>(mesh.vertex_format);
+        record.vertex_flags = mesh.has_tangents ? kVertexHasTangents : 0u;
+        record.albedo[0] = sub.albedo.x;
+        record.albedo[1] = sub.albedo.y;
+        record.albedo[2] = sub.albedo.z;
+        record.albedo[3] = sub.albedo.w;
+        record.bounds_min[0] = mesh.bounds_min.x;
+        record.bounds_min[1] = mesh.bounds_min.y;
+        record.bounds_min[2] = mesh.bounds_min.z;
+        record.bounds_max[0] = mesh.bounds_max.x;
+        record.bounds_max[1] = mesh.bounds_max.y;
+        record.bounds_max[2] = mesh.bounds_max.z;
+        record.bounds_radius = mesh.bounds_radius;
+
+        record.vertex_offset = AlignUp(blob.size());
+        blob.resize(record.vertex_offset + mesh.VertexByteSize());
+        if (mesh.VertexByteSize() > 0) {
+            std::memcpy(blob.data() + record.vertex_offset, mesh.VertexBytes(), mesh.VertexByteSize());
+        }
+
+        record.index_offset = AlignUp(blob.size());
+        blob.resize(record.index_offset + std::size_t{record.index_count} * record.index_size);
+        if (record.index_size == mesh.IndexSize()) {
+            if (record.index_count > 0) {
+                std::memcpy(blob.data() + record.index_offset, mesh.IndexBytes(),
+                            std::size_t{record.index_count} * record.index_size);
+            }
+        } else if (record.index_size == 4) {
+            auto *wide = reinterpret_cast<std::uint32_t *>(blob.data() + record.index_offset);
+            for (std::uint32_t k = 0; k < record.index_count; ++k) {
+                wide[k] = mesh.Index(k);
+            }
+        } else {
+            auto *narrow = reinterpret_cast<std::uint16_t *>(blob.data() + record.index_offset);
+            for (std::uint32_t k = 0; k < record.index_count; ++k) {
+                narrow[k] = static_cast<std::uint16_t>(mesh.Index(k));
+            }
+        }
+
+        record.name_length = static_cast<std::uint32_t>(sub.material_name.size());
+        record.name_offset = AppendString(blob, sub.material_name);
+        record.texture_length = static_cast<std::uint32_t>(sub.diffuse_texture_path.size());
+        record.texture_offset = AppendString(blob, sub.diffuse_texture_path);
+
+        record.meshlet_count = static_cast<std::uint32_t>(mesh.meshlets.size());
+        record.meshlet_size = sizeof(Meshlet);
+        record.meshlet_offset = AlignUp(blob.size());
+        blob.resize(record.meshlet_offset + mesh.meshlets.size() * sizeof(Meshlet));
+        if (!mesh.meshlets.empty()) {
+            std::memcpy(blob.data() + record.meshlet_offset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+        }
+
+        record.lod_count = static_cast<std::uint32_t>(mesh.lods.size());
+        record.lod_size = sizeof(MeshLod);
+        record.lod_offset = AlignUp(blob.size());
+        blob.resize(record.lod_offset + mesh.lods.size() * sizeof(MeshLod));
+        if (!mesh.lods.empty()) {
+            std::memcpy(blob.data() + record.lod_offset, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+        }
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.submesh_count = submesh_count;
+    header.obj_size = stamp.obj_size;
+    header.obj_mtime = stamp.obj_mtime;
+    header.mtl_size = stamp.mtl_size;
+    header.mtl_mtime = stamp.mtl_mtime;
+    header.content_hash = stamp.content_hash;
+    header.settings_hash = stamp.settings_hash;
+    header.file_size = blob.size();
+    std::memcpy(blob.data(), &header, sizeof(header));
+    if (submesh_count > 0) {
+        std::memcpy(blob.data() + sizeof(FileHeader), records.data(), records.size() * sizeof(SubmeshRecord));
+    }
+
+    // Write a sibling temp file first so a crash never leaves a truncated cache behind.
+    const std::filesystem::path final_path(cache_filename);
+    std::filesystem::path temp_path = final_path;
+    temp_path += L".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open() || !out.write(blob.data(), static_cast<std::streamsize>(blob.size()))) {
+            std::wcerr << L"Failed to write mesh cache: " << temp_path.wstring() << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, final_path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        std::wcerr << L"Failed to replace mesh cache: " << cache_filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "MeshLoader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfw {
+    // Identity of an OBJ/MTL pair; a cache file is only valid for the stamp it was written with.
+    struct MeshSourceStamp {
+        std::uint64_t obj_size = 0;
+        std::int64_t obj_mtime = 0;
+        std::uint64_t mtl_size = 0;
+        std::int64_t mtl_mtime = 0;
+        std::uint64_t content_hash = 0;
+        // Processing the cached meshes went through after parsing; see HashSettings. Set by the caller.
+        std::uint64_t settings_hash = 0;
+
+        bool operator==(const MeshSourceStamp &other) const = default;
+    };
+
+    // Binary container (.gfwmesh) for post-processed ObjModelData, stored next to the source OBJ.
+    class MeshCache {
+    public:
+        static std::wstring CachePathFor(const std::wstring &obj_filename);
+
+        static bool ComputeStamp(const std::wstring &obj_filename, const std::wstring &mtl_filename,
+                                 MeshSourceStamp &stamp);
+
+        // Hash of the values that decide how a loaded model is processed before it is cached, for
+        // MeshSourceStamp::settings_hash.
+        static std::uint64_t HashSettings(const std::vector<float> &settings);
+
+        // Returns false when the cache is missing, stale, or malformed; a file whose ranges do not fit its
+        // own buffers (blobs past the end of the file, LODs or meshlets past the indices) counts as malformed.
+        // The loaded meshes view their vertex and index blobs in the mapped file (see MeshData::view) rather
+        // than copying them; index values are not re-checked, the stamp already ties them to their source.
+        static bool Load(const std::wstring &cache_filename, const MeshSourceStamp &stamp, ObjModelData &model);
+
+        static bool Save(const std::wstring &cache_filename, const MeshSourceStamp &stamp, const ObjModelData &model);
+    };
+}
@@ -1,41 +1,106 @@
 #pragma once
 
-#include <d3d12.h>
+#include <DirectXMath.h>
 #include <cstdint>
+#include <memory>
 #include <vector>
-#include <wrl/client.h>
-
-using Microsoft::WRL::ComPtr;
+#include "framework/CommandRecorder.h"
 
 namespace gfw {
+    // Contiguous triangle range of a mesh's index buffer with object-space culling bounds.
+    struct Meshlet {
+        std::uint32_t index_offset = 0;
+        std::uint32_t triangle_count = 0;
+        std::uint32_t vertex_count = 0; // unique vertices referenced by the range
+        DirectX::XMFLOAT3 center = {0.0f, 0.0f, 0.0f};
+        float radius = 0.0f;
+        DirectX::XMFLOAT3 aabb_min = {0.0f, 0.0f, 0.0f};
+        DirectX::XMFLOAT3 aabb_max = {0.0f, 0.0f, 0.0f};
+        // Backface cone: every triangle faces away from a viewer inside the cone; cutoff >= 1 disables it.
+        DirectX::XMFLOAT3 cone_axis = {0.0f, 0.0f, 0.0f};
+        float cone_cutoff = 1.0f;
+    };
+
+    // Index range of one level of detail; error is the object-space deviation from LOD 0.
+    struct MeshLod {
+        std::uint32_t index_offset = 0;
+        std::uint32_t index_count = 0;
+        float error = 0.0f;
+    };
+
+    // Layout of MeshData::vertex_data. Float32 is the loader's 32-byte Vertex; Quantized is the 16-byte
+    // VertexQuantizer layout whose positions are relative to the mesh AABB. Either may be followed by a
+    // tangent (see has_tangents).
+    enum class VertexFormat : std::uint32_t {
+        Float32 = 0,
+        Quantized = 1
+    };
+
+    // Vertex and index blobs a MeshData reads in place instead of owning, e.g. straight out of a mapped cache
+    // file. `owner` keeps that storage alive for as long as any mesh points into it.
+    struct MeshDataView {
+        std::shared_ptr<const void> owner;
+        const std::uint8_t *vertices = nullptr;
+        const std::uint8_t *indices = nullptr;
+        std::uint32_t index_count = 0;
+        std::uint32_t index_size = 0; // 2 or 4 bytes
+    };
+
     struct MeshData {
         std::vector<std::uint8_t> vertex_data;
         std::uint32_t vertex_stride = 0;
         std::uint32_t vertex_count = 0;
         std::vector<std::uint32_t> indices;
-        D3D_PRIMITIVE_TOPOLOGY topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-    };
+        PrimitiveTopology topology = PrimitiveTopology::TriangleList;
+        VertexFormat vertex_format = VertexFormat::Float32;
+        // Float32 vertices carry a float4 tangent at byte 32 (stride 48); Quantized ones an octahedral
+        // SNORM16 tangent at byte 16 (stride 20). The handedness is in w or position.w respectively.
+        bool has_tangents = false;
+        // Object-space AABB of the vertex positions; zero when unknown.
+        DirectX::XMFLOAT3 bounds_min = {0.0f, 0.0f, 0.0f};
+        DirectX::XMFLOAT3 bounds_max = {0.0f, 0.0f, 0.0f};
+        // Radius of the sphere around the AABB center that holds every vertex; 0 when unknown.
+        float bounds_radius = 0.0f;
+        std::vector<Meshlet> meshlets;
+        // When present, lods[0] is the full-detail range and coarser levels follow it in `indices`.
+        std::vector<MeshLod> lods;
+        // When set, vertex_data and indices stay empty and the accessors below read the viewed blobs instead.
+        // Mesh processing only works on owned data; readers should go through the accessors.
+        MeshDataView view;
+
+        [[nodiscard]] bool IsView() const { return view.vertices != nullptr; }
 
-    class MeshBuffers {
-    public:
-        MeshBuffers() = default;
+        [[nodiscard]] const std::uint8_t *VertexBytes() const {
+            return IsView() ? view.vertices : vertex_data.data();
+        }
 
-        ~MeshBuffers() = default;
+        [[nodiscard]] std::size_t VertexByteSize() const {
+            return IsView() ? std::size_t{vertex_count} * vertex_stride : vertex_data.size();
+        }
 
-        MeshBuffers(const MeshBuffers &) = delete;
+        [[nodiscard]] std::uint32_t IndexCount() const {
+            return IsView() ? view.index_count : static_cast<std::uint32_t>(indices.size());
+        }
 
-        MeshBuffers &operator=(const MeshBuffers &) = delete;
+        // Bytes per index as stored: views keep 16-bit indices narrow, owned indices are always 32-bit.
+        [[nodiscard]] std::uint32_t IndexSize() const {
+            return IsView() ? view.index_size : static_cast<std::uint32_t>(sizeof(std::uint32_t));
+        }
 
-        MeshBuffers(MeshBuffers &&) = default;
+        [[nodiscard]] const std::uint8_t *IndexBytes() const {
+            return IsView() ? view.indices : reinterpret_cast<const std::uint8_t *>(indices.data());
+        }
 
-        MeshBuffers &operator=(MeshBuffers &&) = default;
+        [[nodiscard]] std::uint32_t Index(std::size_t i) const {
+            if (!IsView()) {
+                return indices[i];
+            }
+            return view.index_size == 2 ? reinterpret_cast<const std::uint16_t *>(view.indices)[i]
+                                        : reinterpret_cast<const std::uint32_t *>(view.indices)[i];
+        }
 
-        ComPtr<ID3D12Resource> vertex_buffer;
-        ComPtr<ID3D12Resource> index_buffer;
-        D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view = {};
-        D3D12_INDEX_BUFFER_VIEW index_buffer_view = {};
-        UINT vertex_count = 0;  // Number of vertices (used for non-indexed draws)
-        UINT index_count = 0;   // Number of indices (used for indexed draws)
-        D3D_PRIMITIVE_TOPOLOGY topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        [[nodiscard]] std::uint32_t BaseIndexCount() const {
+            return lods.empty() ? IndexCount() : lods[0].index_count;
+        }
     };
-}
\ No newline at end of file
+}
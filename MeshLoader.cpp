@@ -1,14 +1,24 @@
 #define NOMINMAX
 #include "MeshLoader.h"
+#include "MappedFile.h"
+#include "OcclusionCuller.h"
+#include "TangentGenerator.h"
+#include "VertexQuantizer.h"
+#include "framework/ParallelFor.h"
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <vector>
 #include <string>
-#include <map>
+#include <string_view>
 #include <unordered_map>
+#include <charconv>
+#include <cctype>
+#include <cmath>
 #include <cstring>
 #include <algorithm>
+#include <array>
 #include <DirectXMath.h>
 
 using namespace DirectX;
@@ -25,26 +35,144 @@ struct ObjIndex {
     int v = 0;
     int vt = 0;
     int vn = 0;
-    bool operator<(const ObjIndex &other) const {
-        if (v != other.v) return v < other.v;
-        if (vt != other.vt) return vt < other.vt;
-        return vn < other.vn;
+};
+
+// Whitespace as seen by stream extraction, minus '\n' which already delimits lines.
+static bool IsObjSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Tokenizes one OBJ line in place. Mirrors `std::istream >>` closely enough that the
+// parsed values match the stream-based reader it replaced.
+class ObjLineReader {
+public:
+    ObjLineReader(const char *begin, const char *end) : begin_(begin), ptr_(begin), end_(end) {}
+
+    [[nodiscard]] bool Empty() const { return begin_ == end_; }
+    [[nodiscard]] bool StartsWith(char c) const { return begin_ != end_ && *begin_ == c; }
+
+    std::string_view NextToken() {
+        SkipSpaces();
+        const char *start = ptr_;
+        while (ptr_ < end_ && !IsObjSpace(*ptr_)) ++ptr_;
+        return {start, static_cast<size_t>(ptr_ - start)};
+    }
+
+    bool NextFloat(float &out) {
+        SkipSpaces();
+        const char *p = ptr_;
+        if (p < end_ && *p == '+') ++p;
+        const char *digits = (p < end_ && *p == '-') ? p + 1 : p;
+        // from_chars also accepts "inf"/"nan", which stream extraction rejects.
+        if (digits >= end_ || !(std::isdigit(static_cast<unsigned char>(*digits)) || *digits == '.')) {
+            return false;
+        }
+        const auto [next, ec] = std::from_chars(p, end_, out);
+        if (ec != std::errc()) {
+            return false;
+        }
+        ptr_ = next;
+        return true;
+    }
+
+private:
+    void SkipSpaces() {
+        while (ptr_ < end_ && IsObjSpace(*ptr_)) ++ptr_;
     }
+
+    const char *begin_;
+    const char *ptr_;
+    const char *end_;
 };
 
-static std::ifstream OpenObjStream(const std::wstring &filename) {
-    return std::ifstream(filename, std::ios::binary);
+// Same contract as the former std::stoi wrapper: leading integer prefix, 0 on failure.
+static int ParseObjInt(std::string_view s) {
+    const char *p = s.data();
+    const char *end = p + s.size();
+    if (p < end && *p == '+') {
+        ++p;
+        if (p < end && *p == '-') return 0;
+    }
+    int value = 0;
+    const auto [next, ec] = std::from_chars(p, end, value);
+    return ec == std::errc() ? value : 0;
 }
 
-static int ParseObjInt(const std::string &s) {
-    if (s.empty()) return 0;
-    try {
-        return std::stoi(s);
-    } catch (...) {
-        return 0;
+static ObjIndex ParseObjCorner(std::string_view corner) {
+    ObjIndex idx;
+    const size_t firstSlash = corner.find('/');
+    if (firstSlash == std::string_view::npos) {
+        idx.v = ParseObjInt(corner);
+        return idx;
+    }
+    const size_t secondSlash = corner.find('/', firstSlash + 1);
+    idx.v = ParseObjInt(corner.substr(0, firstSlash));
+    if (secondSlash == std::string_view::npos) {
+        idx.vt = ParseObjInt(corner.substr(firstSlash + 1));
+    } else {
+        idx.vt = ParseObjInt(corner.substr(firstSlash + 1, secondSlash - firstSlash - 1));
+        idx.vn = ParseObjInt(corner.substr(secondSlash + 1));
     }
+    return idx;
 }
 
+// Open-addressing (linear probing) map from a resolved (v, vt, vn) triple to a submesh vertex index.
+class ObjVertexCache {
+public:
+    // Returns the index already assigned to `key`, or stores and returns `candidate`.
+    std::uint32_t FindOrInsert(const ObjIndex &key, std::uint32_t candidate) {
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Grow();
+        }
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = Hash(key) & mask;; i = (i + 1) & mask) {
+            Slot &slot = slots_[i];
+            if (slot.value == kEmpty) {
+                slot.key = key;
+                slot.value = candidate;
+                ++size_;
+                return candidate;
+            }
+            if (slot.key.v == key.v && slot.key.vt == key.vt && slot.key.vn == key.vn) {
+                return slot.value;
+            }
+        }
+    }
+
+private:
+    static constexpr std::uint32_t kEmpty = 0xffffffffu;
+
+    struct Slot {
+        ObjIndex key;
+        std::uint32_t value = kEmpty;
+    };
+
+    static size_t Hash(const ObjIndex &key) {
+        std::uint64_t h = static_cast<std::uint32_t>(key.v);
+        h = (h << 21) ^ static_cast<std::uint32_t>(key.vt);
+        h = (h << 21) ^ static_cast<std::uint32_t>(key.vn);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    void Grow() {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(old.empty() ? 64 : old.size() * 2, Slot{});
+        const size_t mask = slots_.size() - 1;
+        for (const Slot &slot : old) {
+            if (slot.value == kEmpty) continue;
+            size_t i = Hash(slot.key) & mask;
+            while (slots_[i].value != kEmpty) i = (i + 1) & mask;
+            slots_[i] = slot;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
 struct ParsedMtl {
     std::wstring diffuse_texture;
     DirectX::XMFLOAT4 kd = {1.0f, 1.0f, 1.0f, 1.0f};
@@ -66,22 +194,14 @@ static std::wstring JoinPath(const std::wstring &base, const std::wstring &relat
     return base + L"/" + relative;
 }
 
-static std::unordered_map<std::wstring, ParsedMtl> ParseMtl(
-        const std::wstring &obj_dir,
-        const std::wstring &mtl_filename) {
+static std::unordered_map<std::wstring, ParsedMtl> ParseMtl(const std::wstring &mtl_path) {
     std::unordered_map<std::wstring, ParsedMtl> result;
-    if (mtl_filename.empty()) {
+    if (mtl_path.empty()) {
         return result;
     }
-    std::wstring mtl_path = JoinPath(obj_dir, mtl_filename);
-    std::ifstream file(mtl_path, std::ios::binary);
+    std::ifstream file(std::filesystem::path(mtl_path), std::ios::binary);
     if (!file.is_open()) {
-        // Support callers that already pass a full/usable path to MTL.
-        mtl_path = mtl_filename;
-        file = std::ifstream(mtl_path, std::ios::binary);
-        if (!file.is_open()) {
-            return result;
-        }
+        return result;
     }
 
     std::wstring current;
@@ -113,25 +233,171 @@ static std::unordered_map<std::wstring, ParsedMtl> ParseMtl(
     return result;
 }
 
-ObjModelData MeshLoader::LoadObjModel(const std::wstring &obj_filename, const std::wstring &mtl_filename) {
+std::wstring MeshLoader::ResolveMtlPath(const std::wstring &obj_filename, const std::wstring &mtl_filename) {
+    if (mtl_filename.empty()) {
+        return {};
+    }
+    std::wstring mtl_path = JoinPath(DirectoryOf(obj_filename), mtl_filename);
+    if (std::ifstream(std::filesystem::path(mtl_path), std::ios::binary).is_open()) {
+        return mtl_path;
+    }
+    // Support callers that already pass a full/usable path to MTL.
+    if (std::ifstream(std::filesystem::path(mtl_filename), std::ios::binary).is_open()) {
+        return mtl_filename;
+    }
+    return {};
+}
+
+// Attribute and face records of one newline-aligned slice of the OBJ. Face corners stay
+// unresolved; relative indices need the attribute counts of all preceding chunks.
+struct ObjChunk {
+    struct Record {
+        std::uint32_t first = 0;          // first corner, or index into `materials` for usemtl
+        std::uint32_t corner_count = 0;   // kUseMtl marks a usemtl record
+        std::uint32_t position_count = 0; // chunk-local attribute counts when the record was read
+        std::uint32_t uv_count = 0;
+        std::uint32_t normal_count = 0;
+    };
+    static constexpr std::uint32_t kUseMtl = 0xffffffffu;
+
+    std::vector<XMFLOAT3> positions;
+    std::vector<XMFLOAT3> normals;
+    std::vector<XMFLOAT2> uvs;
+    std::vector<ObjIndex> corners;
+    std::vector<std::string_view> materials;
+    std::vector<Record> records;
+};
+
+static constexpr size_t kMinObjChunkBytes = 4u << 20;
+
+static void ParseObjChunk(const char *begin, const char *end, ObjChunk &chunk) {
+    const float scale = 0.01f;
+    auto make_record = [&chunk](std::uint32_t first, std::uint32_t corner_count) {
+        ObjChunk::Record record;
+        record.first = first;
+        record.corner_count = corner_count;
+        record.position_count = static_cast<std::uint32_t>(chunk.positions.size());
+        record.uv_count = static_cast<std::uint32_t>(chunk.uvs.size());
+        record.normal_count = static_cast<std::uint32_t>(chunk.normals.size());
+        return record;
+    };
+
+    const char *cursor = begin;
+    while (cursor < end) {
+        const char *line_end = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+        if (!line_end) line_end = end;
+        ObjLineReader line(cursor, line_end);
+        cursor = line_end + 1;
+
+        if (line.Empty() || line.StartsWith('#')) continue;
+        const std::string_view type = line.NextToken();
+
+        if (type == "v") {
+            XMFLOAT3 p;
+            if (!line.NextFloat(p.x) || !line.NextFloat(p.y) || !line.NextFloat(p.z)) continue;
+            p.x *= scale; p.y *= scale; p.z *= scale;
+            p.z = -p.z;
+            chunk.positions.push_back(p);
+        } else if (type == "vt") {
+            XMFLOAT2 uv = {};
+            if (!line.NextFloat(uv.x) || !line.NextFloat(uv.y)) continue;
+            uv.y = 1.0f - uv.y;
+            chunk.uvs.push_back(uv);
+        } else if (type == "vn") {
+            XMFLOAT3 n;
+            if (!line.NextFloat(n.x) || !line.NextFloat(n.y) || !line.NextFloat(n.z)) continue;
+            n.z = -n.z;
+            chunk.normals.push_back(n);
+        } else if (type == "usemtl") {
+            chunk.records.push_back(make_record(static_cast<std::uint32_t>(chunk.materials.size()), ObjChunk::kUseMtl));
+            chunk.materials.push_back(line.NextToken());
+        } else if (type == "f") {
+            const auto first = static_cast<std::uint32_t>(chunk.corners.size());
+            for (std::string_view corner = line.NextToken(); !corner.empty(); corner = line.NextToken()) {
+                chunk.corners.push_back(ParseObjCorner(corner));
+            }
+            const auto corner_count = static_cast<std::uint32_t>(chunk.corners.size()) - first;
+            if (corner_count >= 3) {
+                chunk.records.push_back(make_record(first, corner_count));
+            } else {
+                chunk.corners.resize(first);
+            }
+        }
+    }
+}
+
+// Splits [data, data + size) into at most max_chunks ranges that each end just past a newline.
+static std::vector<std::pair<const char *, const char *>> SplitObjChunks(const char *data, size_t size, unsigned max_chunks) {
+    const size_t chunk_count = std::max<size_t>(1, std::min<size_t>(max_chunks, size / kMinObjChunkBytes));
+    std::vector<std::pair<const char *, const char *>> ranges;
+    ranges.reserve(chunk_count);
+    const char *const end = data + size;
+    const char *begin = data;
+    for (size_t i = 1; i <= chunk_count && begin < end; ++i) {
+        const char *split = (i == chunk_count) ? end : data + size * i / chunk_count;
+        if (split < begin) split = begin;
+        if (split < end) {
+            const void *nl = std::memchr(split, '\n', end - split);
+            split = nl ? static_cast<const char *>(nl) + 1 : end;
+        }
+        ranges.emplace_back(begin, split);
+        begin = split;
+    }
+    return ranges;
+}
+
+ObjModelData MeshLoader::LoadObjModel(const std::wstring &obj_filename, const std::wstring &mtl_filename,
+                                      unsigned thread_count) {
     ObjModelData model;
-    std::ifstream file = OpenObjStream(obj_filename);
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.Open(obj_filename)) {
         std::wcerr << L"Failed to open OBJ: " << obj_filename << std::endl;
         return model;
     }
 
-    const auto mtls = ParseMtl(DirectoryOf(obj_filename), mtl_filename);
+    const auto mtls = ParseMtl(ResolveMtlPath(obj_filename, mtl_filename));
 
+    // ---------- Parse chunks concurrently ----------
+    const unsigned workers = thread_count ? thread_count : DefaultWorkerCount();
+    const auto ranges = SplitObjChunks(file.Data(), file.Size(), workers);
+    std::vector<ObjChunk> chunks(ranges.size());
+    ParallelFor(chunks.size(), workers, [&](size_t i) {
+        ParseObjChunk(ranges[i].first, ranges[i].second, chunks[i]);
+    });
+
+    // ---------- Merge attributes in file order ----------
     std::vector<XMFLOAT3> positions;
     std::vector<XMFLOAT3> normals;
     std::vector<XMFLOAT2> uvs;
-    const float scale = 0.01f;
+    std::vector<std::array<std::uint32_t, 3>> chunk_bases(chunks.size());
+    {
+        size_t position_total = 0, uv_total = 0, normal_total = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunk_bases[i] = {static_cast<std::uint32_t>(position_total),
+                              static_cast<std::uint32_t>(uv_total),
+                              static_cast<std::uint32_t>(normal_total)};
+            position_total += chunks[i].positions.size();
+            uv_total += chunks[i].uvs.size();
+            normal_total += chunks[i].normals.size();
+        }
+        positions.reserve(position_total);
+        uvs.reserve(uv_total);
+        normals.reserve(normal_total);
+        for (ObjChunk &chunk : chunks) {
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            chunk.positions = {};
+            chunk.uvs = {};
+            chunk.normals = {};
+        }
+    }
 
+    // ---------- Resolve faces and build submeshes ----------
     std::unordered_map<std::wstring, size_t> material_to_submesh;
     std::vector<std::vector<Vertex>> vertices_per_submesh;
     std::vector<std::vector<std::uint32_t>> indices_per_submesh;
-    std::vector<std::map<ObjIndex, uint32_t>> index_map_per_submesh;
+    std::vector<ObjVertexCache> index_map_per_submesh;
 
     auto ensure_submesh = [&](const std::wstring &material_name) -> size_t {
         auto it = material_to_submesh.find(material_name);
@@ -154,60 +420,30 @@ ObjModelData MeshLoader::LoadObjModel(const std::wstring &obj_filename, const st
     };
 
     size_t current_submesh = ensure_submesh(L"default");
+    std::wstring material_name;
 
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;
-        std::stringstream ss(line);
-        std::string type;
-        ss >> type;
-
-        if (type == "v") {
-            XMFLOAT3 p;
-            if (!(ss >> p.x >> p.y >> p.z)) continue;
-            p.x *= scale; p.y *= scale; p.z *= scale;
-            p.z = -p.z;
-            positions.push_back(p);
-        } else if (type == "vt") {
-            XMFLOAT2 uv = {};
-            if (!(ss >> uv.x >> uv.y)) continue;
-            uv.y = 1.0f - uv.y;
-            uvs.push_back(uv);
-        } else if (type == "vn") {
-            XMFLOAT3 n;
-            if (!(ss >> n.x >> n.y >> n.z)) continue;
-            n.z = -n.z;
-            normals.push_back(n);
-        } else if (type == "usemtl") {
-            std::string mat;
-            ss >> mat;
-            std::wstring wmat(mat.begin(), mat.end());
-            current_submesh = ensure_submesh(wmat);
-        } else if (type == "f") {
-            std::string vertexStr;
-            std::vector<ObjIndex> faceIndices;
-            while (ss >> vertexStr) {
-                ObjIndex idx;
-                size_t firstSlash = vertexStr.find('/');
-                size_t secondSlash = vertexStr.find('/', firstSlash + 1);
-                if (firstSlash == std::string::npos) {
-                    idx.v = ParseObjInt(vertexStr);
-                } else if (secondSlash == std::string::npos) {
-                    idx.v = ParseObjInt(vertexStr.substr(0, firstSlash));
-                    idx.vt = ParseObjInt(vertexStr.substr(firstSlash + 1));
-                } else {
-                    idx.v = ParseObjInt(vertexStr.substr(0, firstSlash));
-                    idx.vt = ParseObjInt(vertexStr.substr(firstSlash + 1, secondSlash - firstSlash - 1));
-                    idx.vn = ParseObjInt(vertexStr.substr(secondSlash + 1));
-                }
-                faceIndices.push_back(idx);
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const ObjChunk &chunk = chunks[c];
+        for (const ObjChunk::Record &record : chunk.records) {
+            if (record.corner_count == ObjChunk::kUseMtl) {
+                const std::string_view mat = chunk.materials[record.first];
+                material_name.assign(mat.begin(), mat.end());
+                current_submesh = ensure_submesh(material_name);
+                continue;
             }
 
-            const int posCount = static_cast<int>(positions.size());
-            const int normCount = static_cast<int>(normals.size());
-            const int uvCount = static_cast<int>(uvs.size());
-            for (size_t i = 1; i + 1 < faceIndices.size(); ++i) {
-                ObjIndex tri[3] = { faceIndices[0], faceIndices[i + 1], faceIndices[i] };
+            const int posCount = static_cast<int>(chunk_bases[c][0] + record.position_count);
+            const int uvCount = static_cast<int>(chunk_bases[c][1] + record.uv_count);
+            const int normCount = static_cast<int>(chunk_bases[c][2] + record.normal_count);
+            // A face before any position has nothing valid to reference.
+            if (posCount == 0) continue;
+
+            const ObjIndex *face_indices = chunk.corners.data() + record.first;
+            auto &sub_vertices = vertices_per_submesh[current_submesh];
+            auto &sub_indices = indices_per_submesh[current_submesh];
+            auto &sub_index_map = index_map_per_submesh[current_submesh];
+            for (size_t i = 1; i + 1 < record.corner_count; ++i) {
+                ObjIndex tri[3] = { face_indices[0], face_indices[i + 1], face_indices[i] };
                 for (int k = 0; k < 3; ++k) {
                     ObjIndex &objIdx = tri[k];
                     if (objIdx.v < 0) objIdx.v = posCount + objIdx.v + 1;
@@ -217,11 +453,9 @@ ObjModelData MeshLoader::LoadObjModel(const std::wstring &obj_filename, const st
                     objIdx.vt = std::max(0, std::min(objIdx.vt, uvCount));
                     objIdx.vn = std::max(0, std::min(objIdx.vn, normCount));
 
-                    auto &sub_vertices = vertices_per_submesh[current_submesh];
-                    auto &sub_indices = indices_per_submesh[current_submesh];
-                    auto &sub_index_map = index_map_per_submesh[current_submesh];
-
-                    if (sub_index_map.find(objIdx) == sub_index_map.end()) {
+                    const auto candidate = static_cast<std::uint32_t>(sub_vertices.size());
+                    const std::uint32_t index = sub_index_map.FindOrInsert(objIdx, candidate);
+                    if (index == candidate) {
                         Vertex v = {};
                         v.px = positions[objIdx.v - 1].x;
                         v.py = positions[objIdx.v - 1].y;
@@ -235,11 +469,9 @@ ObjModelData MeshLoader::LoadObjModel(const std::wstring &obj_filename, const st
                             v.ny = normals[objIdx.vn - 1].y;
                             v.nz = normals[objIdx.vn - 1].z;
                         }
-                        uint32_t newIdx = static_cast<uint32_t>(sub_vertices.size());
                         sub_vertices.push_back(v);
-                        sub_index_map[objIdx] = newIdx;
                     }
-                    sub_indices.push_back(sub_index_map[objIdx]);
+                    sub_indices.push_back(index);
                 }
             }
         }
@@ -255,11 +487,98 @@ ObjModelData MeshLoader::LoadObjModel(const std::wstring &obj_filename, const st
         if (sub.mesh.vertex_count > 0) {
             sub.mesh.vertex_data.resize(sub.mesh.vertex_count * sub.mesh.vertex_stride);
             std::memcpy(sub.mesh.vertex_data.data(), sub_vertices.data(), sub.mesh.vertex_data.size());
+            ComputeBounds(sub.mesh);
         }
     }
     return model;
 }
 
+void MeshLoader::ComputeBounds(MeshData &mesh) {
+    if (mesh.vertex_format != VertexFormat::Float32 || mesh.vertex_count == 0) {
+        return;
+    }
+    // Every Float32 layout starts with the position, whatever follows it.
+    const auto position = [&](std::uint32_t i) {
+        XMFLOAT3 p;
+        std::memcpy(&p, mesh.vertex_data.data() + std::size_t{i} * mesh.vertex_stride, sizeof(p));
+        return p;
+    };
+    XMFLOAT3 lo = position(0);
+    XMFLOAT3 hi = lo;
+    for (std::uint32_t i = 1; i < mesh.vertex_count; ++i) {
+        const XMFLOAT3 p = position(i);
+        lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+        hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+    }
+    const XMFLOAT3 center = {(lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f};
+    float radius_sq = 0.0f;
+    for (std::uint32_t i = 0; i < mesh.vertex_count; ++i) {
+        const XMFLOAT3 p = position(i);
+        const XMFLOAT3 d = {p.x - center.x, p.y - center.y, p.z - center.z};
+        radius_sq = std::max(radius_sq, d.x * d.x + d.y * d.y + d.z * d.z);
+    }
+    mesh.bounds_min = lo;
+    mesh.bounds_max = hi;
+    mesh.bounds_radius = std::sqrt(radius_sq);
+}
+
+OccluderMesh MeshLoader::ExtractOccluder(const MeshData &mesh) {
+    OccluderMesh occluder;
+    if (mesh.topology != PrimitiveTopology::TriangleList || mesh.vertex_count == 0) {
+        return occluder;
+    }
+    const bool quantized = mesh.vertex_format == VertexFormat::Quantized;
+    if (!quantized && mesh.vertex_format != VertexFormat::Float32) {
+        return occluder;
+    }
+    const MeshLod lod = mesh.lods.empty()
+                            ? MeshLod{0, mesh.IndexCount(), 0.0f}
+                            : mesh.lods.back();
+    if (std::size_t{lod.index_offset} + lod.index_count > mesh.IndexCount()) {
+        return occluder;
+    }
+
+    const XMFLOAT3 offset = mesh.bounds_min;
+    const XMFLOAT3 scale = {mesh.bounds_max.x - mesh.bounds_min.x, mesh.bounds_max.y - mesh.bounds_min.y,
+                            mesh.bounds_max.z - mesh.bounds_min.z};
+    const auto position = [&](std::uint32_t i) {
+        const std::uint8_t *vertex = mesh.VertexBytes() + std::size_t{i} * mesh.vertex_stride;
+        XMFLOAT3 p;
+        if (quantized) {
+            QuantizedVertex encoded;
+            std::memcpy(&encoded, vertex, sizeof(encoded));
+            float normal[3], uv[2];
+            VertexQuantizer::Decode(encoded, offset, scale, &p.x, normal, uv);
+        } else {
+            std::memcpy(&p, vertex, sizeof(p));
+        }
+        return p;
+    };
+
+    // Coarse LODs use a small part of the vertex buffer, so only those vertices are decoded and kept.
+    std::unordered_map<std::uint32_t, std::uint32_t> remap;
+    const std::uint32_t index_count = lod.index_count - lod.index_count % 3;
+    occluder.indices.reserve(index_count);
+    for (std::uint32_t i = 0; i < index_count; ++i) {
+        const std::uint32_t index = mesh.Index(lod.index_offset + i);
+        if (index >= mesh.vertex_count) {
+            return {};
+        }
+        const auto [it, inserted] = remap.try_emplace(index, static_cast<std::uint32_t>(occluder.positions.size()));
+        if (inserted) {
+            occluder.positions.push_back(position(index));
+        }
+        occluder.indices.push_back(it->second);
+    }
+    return occluder;
+}
+
+void MeshLoader::GenerateTangents(ObjModelData &model, unsigned thread_count) {
+    ParallelFor(model.submeshes.size(), thread_count ? thread_count : DefaultWorkerCount(), [&](size_t i) {
+        TangentGenerator::Generate(model.submeshes[i].mesh);
+    });
+}
+
 MeshData MeshLoader::LoadObj(const std::wstring &filename) {
     ObjModelData model = LoadObjModel(filename);
     for (const auto &sub : model.submeshes) {
@@ -6,6 +6,8 @@
 #include <DirectXMath.h>
 
 namespace gfw {
+    struct OccluderMesh;
+
     struct ObjSubmeshData {
         MeshData mesh;
         std::wstring material_name;
@@ -19,7 +21,20 @@ namespace gfw {
 
     class MeshLoader {
     public:
-        static ObjModelData LoadObjModel(const std::wstring &obj_filename, const std::wstring &mtl_filename = L"");
+        // thread_count == 0 picks the hardware concurrency; small files are always parsed on one thread.
+        // The result does not depend on the thread count.
+        static ObjModelData LoadObjModel(const std::wstring &obj_filename, const std::wstring &mtl_filename = L"",
+                                         unsigned thread_count = 0);
         static MeshData LoadObj(const std::wstring& filename);
+        // Adds MikkTSpace-style vertex tangents to every submesh (see TangentGenerator), one submesh per
+        // task on up to thread_count threads (0 picks the hardware concurrency).
+        static void GenerateTangents(ObjModelData &model, unsigned thread_count = 0);
+        // Sets the AABB and bounding radius of a mesh with Float32 vertices from its positions.
+        static void ComputeBounds(MeshData &mesh);
+        // Positions and triangles of the coarsest LOD of a triangle list (the whole mesh without LODs), with the
+        // vertices it does not use dropped. Empty for other topologies and vertex formats.
+        static OccluderMesh ExtractOccluder(const MeshData &mesh);
+        // MTL path LoadObjModel would read for this pair, or empty when none can be opened.
+        static std::wstring ResolveMtlPath(const std::wstring &obj_filename, const std::wstring &mtl_filename);
     };
 }
@@ -0,0 +1,466 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace gfw {
+
+namespace {
+    constexpr int kCacheSize = 32;
+    constexpr float kLastTriangleScore = 0.75f;
+    constexpr float kCacheDecayPower = 1.5f;
+    constexpr float kValenceBoostScale = 2.0f;
+    constexpr float kValenceBoostPower = 0.5f;
+
+    float VertexScore(int cache_position, std::uint32_t remaining_triangles) {
+        if (remaining_triangles == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cache_position >= 0) {
+            if (cache_position < 3) {
+                // Slightly below the next cache slots so the walk does not fold back onto the last triangle.
+                score = kLastTriangleScore;
+            } else {
+                const float scaler = 1.0f / static_cast<float>(kCacheSize - 3);
+                score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scaler, kCacheDecayPower);
+            }
+        }
+        score += kValenceBoostScale * std::pow(static_cast<float>(remaining_triangles), -kValenceBoostPower);
+        return score;
+    }
+
+    // Positions are the first three floats of every vertex layout this project uses.
+    DirectX::XMFLOAT3 LoadPosition(const MeshData &mesh, std::uint32_t index) {
+        DirectX::XMFLOAT3 p;
+        std::memcpy(&p, mesh.vertex_data.data() + std::size_t{index} * mesh.vertex_stride, sizeof(p));
+        return p;
+    }
+
+    DirectX::XMFLOAT3 Sub(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b) {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    DirectX::XMFLOAT3 Cross(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b) {
+        return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+
+    float Dot(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // FIFO post-transform cache that can be flushed in O(1) by advancing the timestamp.
+    class FifoCacheSimulator {
+    public:
+        FifoCacheSimulator(std::uint32_t vertex_count, std::uint32_t cache_size)
+            : loaded_at_(vertex_count, 0), cache_size_(cache_size), timestamp_(cache_size + 1) {}
+
+        void Flush() { timestamp_ += cache_size_ + 1; }
+
+        // Returns the number of vertices of the triangle that had to be transformed.
+        std::uint32_t Touch(const std::uint32_t *triangle) {
+            std::uint32_t misses = 0;
+            for (int k = 0; k < 3; ++k) {
+                std::uint32_t &loaded_at = loaded_at_[triangle[k]];
+                if (timestamp_ - loaded_at > cache_size_) {
+                    loaded_at = timestamp_++;
+                    ++misses;
+                }
+            }
+            return misses;
+        }
+
+    private:
+        std::vector<std::uint32_t> loaded_at_;
+        std::uint32_t cache_size_;
+        std::uint32_t timestamp_;
+    };
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<std::uint32_t> &indices, std::uint32_t vertex_count) {
+    const std::size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2 || vertex_count == 0) {
+        return;
+    }
+
+    // ---------- Vertex -> triangle adjacency ----------
+    std::vector<std::uint32_t> remaining(vertex_count, 0);
+    for (std::size_t i = 0; i < triangle_count * 3; ++i) {
+        ++remaining[indices[i]];
+    }
+    std::vector<std::uint32_t> adjacency_offset(vertex_count + 1, 0);
+    for (std::uint32_t v = 0; v < vertex_count; ++v) {
+        adjacency_offset[v + 1] = adjacency_offset[v] + remaining[v];
+    }
+    std::vector<std::uint32_t> adjacency(adjacency_offset[vertex_count]);
+    {
+        std::vector<std::uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (std::size_t t = 0; t < triangle_count; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<std::uint32_t>(t);
+            }
+        }
+    }
+
+    // ---------- Initial scores ----------
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (std::uint32_t v = 0; v < vertex_count; ++v) {
+        vertex_score[v] = VertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    std::size_t best_triangle = 0;
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] +
+                            vertex_score[indices[t * 3 + 2]];
+        if (triangle_score[t] > triangle_score[best_triangle]) {
+            best_triangle = t;
+        }
+    }
+
+    // ---------- Greedy emission ----------
+    std::vector<std::uint32_t> output;
+    output.reserve(triangle_count * 3);
+    std::uint32_t cache[kCacheSize + 3];
+    std::uint32_t next_cache[kCacheSize + 3];
+    int cache_count = 0;
+    std::size_t scan_cursor = 0;
+    constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+    while (output.size() < triangle_count * 3) {
+        if (best_triangle == kNone) {
+            // Nothing in the cache has triangles left; continue with the next unemitted triangle.
+            while (emitted[scan_cursor]) {
+                ++scan_cursor;
+            }
+            best_triangle = scan_cursor;
+        }
+
+        const std::uint32_t *tri = &indices[best_triangle * 3];
+        emitted[best_triangle] = true;
+        output.insert(output.end(), tri, tri + 3);
+
+        for (int k = 0; k < 3; ++k) {
+            const std::uint32_t v = tri[k];
+            std::uint32_t *begin = adjacency.data() + adjacency_offset[v];
+            std::uint32_t *end = begin + remaining[v];
+            std::uint32_t *it = std::find(begin, end, static_cast<std::uint32_t>(best_triangle));
+            std::swap(*it, *(end - 1));
+            --remaining[v];
+        }
+
+        // New LRU order: the emitted triangle first, then the previous cache without duplicates.
+        int next_count = 0;
+        for (int k = 0; k < 3; ++k) {
+            next_cache[next_count++] = tri[k];
+        }
+        for (int i = 0; i < cache_count; ++i) {
+            const std::uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                next_cache[next_count++] = v;
+            }
+        }
+
+        // Vertices pushed out of the simulated cache lose their position bonus.
+        for (int i = kCacheSize; i < next_count; ++i) {
+            cache_position[next_cache[i]] = -1;
+        }
+        cache_count = std::min(next_count, kCacheSize);
+
+        best_triangle = kNone;
+        float best_score = -1.0f;
+        for (int i = 0; i < next_count; ++i) {
+            const std::uint32_t v = next_cache[i];
+            if (i < kCacheSize) {
+                cache_position[v] = i;
+            }
+            const float score = VertexScore(cache_position[v], remaining[v]);
+            const float delta = score - vertex_score[v];
+            vertex_score[v] = score;
+            const std::uint32_t *adjacent = adjacency.data() + adjacency_offset[v];
+            for (std::uint32_t a = 0; a < remaining[v]; ++a) {
+                const std::uint32_t t = adjacent[a];
+                triangle_score[t] += delta;
+            }
+        }
+        for (int i = 0; i < cache_count; ++i) {
+            const std::uint32_t v = next_cache[i];
+            const std::uint32_t *adjacent = adjacency.data() + adjacency_offset[v];
+            for (std::uint32_t a = 0; a < remaining[v]; ++a) {
+                const std::uint32_t t = adjacent[a];
+                if (triangle_score[t] > best_score) {
+                    best_score = triangle_score[t];
+                    best_triangle = t;
+                }
+            }
+        }
+        std::memcpy(cache, next_cache, sizeof(std::uint32_t) * cache_count);
+    }
+
+    indices = std::move(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(MeshData &mesh, float threshold) {
+    std::vector<std::uint32_t> &indices = mesh.indices;
+    const std::size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2 || mesh.vertex_count == 0 || mesh.vertex_stride < sizeof(DirectX::XMFLOAT3)) {
+        return;
+    }
+
+    // ---------- Cluster boundaries ----------
+    // A triangle that misses on all three vertices starts a new run (hard boundary). Within a run, a
+    // soft boundary is placed once the cluster, simulated from a cold cache, has brought its ACMR down
+    // to threshold times the ACMR of the whole run, so every cluster stays cache-friendly when it is
+    // drawn out of order.
+    FifoCacheSimulator cache(mesh.vertex_count, 16);
+    std::vector<std::size_t> hard_boundaries;
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+        if (cache.Touch(&indices[t * 3]) == 3) {
+            hard_boundaries.push_back(t);
+        }
+    }
+    hard_boundaries.push_back(triangle_count);
+
+    std::vector<std::size_t> cluster_begin;
+    for (std::size_t h = 0; h + 1 < hard_boundaries.size(); ++h) {
+        const std::size_t begin = hard_boundaries[h];
+        const std::size_t end = hard_boundaries[h + 1];
+        cache.Flush();
+        std::uint32_t run_misses = 0;
+        for (std::size_t t = begin; t < end; ++t) {
+            run_misses += cache.Touch(&indices[t * 3]);
+        }
+        const float limit = threshold * static_cast<float>(run_misses) / static_cast<float>(end - begin);
+
+        cluster_begin.push_back(begin);
+        cache.Flush();
+        std::uint32_t cluster_misses = 0;
+        std::size_t start = begin;
+        for (std::size_t t = begin; t + 1 < end; ++t) {
+            cluster_misses += cache.Touch(&indices[t * 3]);
+            if (static_cast<float>(cluster_misses) <= limit * static_cast<float>(t - start + 1)) {
+                cluster_begin.push_back(t + 1);
+                start = t + 1;
+                cache.Flush();
+                cluster_misses = 0;
+            }
+        }
+    }
+    const std::size_t cluster_count = cluster_begin.size();
+    cluster_begin.push_back(triangle_count);
+    if (cluster_count < 2) {
+        return;
+    }
+
+    // ---------- Occlusion potential ----------
+    // Area-weighted centroid and normal per cluster; clusters far out along their own normal are likely
+    // to occlude the rest of the mesh from most directions, so they are drawn first.
+    std::vector<DirectX::XMFLOAT3> centroids(cluster_count, {0.0f, 0.0f, 0.0f});
+    std::vector<DirectX::XMFLOAT3> normals(cluster_count, {0.0f, 0.0f, 0.0f});
+    DirectX::XMFLOAT3 mesh_centroid = {0.0f, 0.0f, 0.0f};
+    float mesh_area = 0.0f;
+    for (std::size_t c = 0; c < cluster_count; ++c) {
+        float cluster_area = 0.0f;
+        for (std::size_t t = cluster_begin[c]; t < cluster_begin[c + 1]; ++t) {
+            const DirectX::XMFLOAT3 a = LoadPosition(mesh, indices[t * 3]);
+            const DirectX::XMFLOAT3 b = LoadPosition(mesh, indices[t * 3 + 1]);
+            const DirectX::XMFLOAT3 p = LoadPosition(mesh, indices[t * 3 + 2]);
+            const DirectX::XMFLOAT3 n = Cross(Sub(b, a), Sub(p, a));
+            const float area = std::sqrt(Dot(n, n));
+            centroids[c].x += (a.x + b.x + p.x) * area;
+            centroids[c].y += (a.y + b.y + p.y) * area;
+            centroids[c].z += (a.z + b.z + p.z) * area;
+            normals[c].x += n.x;
+            normals[c].y += n.y;
+            normals[c].z += n.z;
+            cluster_area += area;
+        }
+        mesh_centroid.x += centroids[c].x;
+        mesh_centroid.y += centroids[c].y;
+        mesh_centroid.z += centroids[c].z;
+        mesh_area += cluster_area;
+        const float inv = cluster_area > 0.0f ? 1.0f / (3.0f * cluster_area) : 0.0f;
+        centroids[c] = {centroids[c].x * inv, centroids[c].y * inv, centroids[c].z * inv};
+    }
+    const float inv_mesh = mesh_area > 0.0f ? 1.0f / (3.0f * mesh_area) : 0.0f;
+    mesh_centroid = {mesh_centroid.x * inv_mesh, mesh_centroid.y * inv_mesh, mesh_centroid.z * inv_mesh};
+
+    std::vector<float> sort_keys(cluster_count);
+    for (std::size_t c = 0; c < cluster_count; ++c) {
+        const float length = std::sqrt(Dot(normals[c], normals[c]));
+        sort_keys[c] = length > 0.0f ? Dot(Sub(centroids[c], mesh_centroid), normals[c]) / length : 0.0f;
+    }
+    std::vector<std::size_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&sort_keys](std::size_t a, std::size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<std::uint32_t> output;
+    output.reserve(triangle_count * 3);
+    for (const std::size_t c: order) {
+        output.insert(output.end(), indices.begin() + static_cast<std::ptrdiff_t>(cluster_begin[c] * 3),
+                      indices.begin() + static_cast<std::ptrdiff_t>(cluster_begin[c + 1] * 3));
+    }
+    indices = std::move(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData &mesh) {
+    if (mesh.vertex_count == 0 || mesh.indices.empty() || mesh.vertex_stride == 0) {
+        return;
+    }
+    constexpr std::uint32_t kUnmapped = 0xffffffffu;
+    std::vector<std::uint32_t> remap(mesh.vertex_count, kUnmapped);
+    std::vector<std::uint8_t> vertex_data(mesh.vertex_data.size());
+    std::uint32_t next_vertex = 0;
+    for (std::uint32_t &index: mesh.indices) {
+        if (remap[index] == kUnmapped) {
+            std::memcpy(vertex_data.data() + std::size_t{next_vertex} * mesh.vertex_stride,
+                        mesh.vertex_data.data() + std::size_t{index} * mesh.vertex_stride, mesh.vertex_stride);
+            remap[index] = next_vertex++;
+        }
+        index = remap[index];
+    }
+    vertex_data.resize(std::size_t{next_vertex} * mesh.vertex_stride);
+    mesh.vertex_data = std::move(vertex_data);
+    mesh.vertex_count = next_vertex;
+}
+
+void MeshOptimizer::Optimize(MeshData &mesh, float overdraw_threshold) {
+    if (mesh.topology != PrimitiveTopology::TriangleList) {
+        return;
+    }
+    OptimizeVertexCache(mesh.indices, mesh.vertex_count);
+    if (overdraw_threshold > 0.0f) {
+        OptimizeOverdraw(mesh, overdraw_threshold);
+    }
+    OptimizeVertexFetch(mesh);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<std::uint32_t> &indices,
+                                                   std::uint32_t vertex_count, std::uint32_t cache_size) {
+    VertexCacheStats stats;
+    const std::size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0 || vertex_count == 0 || cache_size == 0) {
+        return stats;
+    }
+
+    FifoCacheSimulator cache(vertex_count, cache_size);
+    std::vector<bool> referenced(vertex_count, false);
+    std::uint32_t unique_vertices = 0;
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+        for (int k = 0; k < 3; ++k) {
+            const std::uint32_t v = indices[t * 3 + k];
+            if (!referenced[v]) {
+                referenced[v] = true;
+                ++unique_vertices;
+            }
+        }
+        stats.transforms += cache.Touch(&indices[t * 3]);
+    }
+    stats.acmr = static_cast<float>(stats.transforms) / static_cast<float>(triangle_count);
+    stats.atvr = static_cast<float>(stats.transforms) / static_cast<float>(unique_vertices);
+    return stats;
+}
+
+OverdrawStats MeshOptimizer::AnalyzeOverdraw(const MeshData &mesh, std::uint32_t view_count,
+                                             std::uint32_t resolution) {
+    OverdrawStats stats;
+    const std::size_t triangle_count = mesh.indices.size() / 3;
+    if (triangle_count == 0 || mesh.vertex_count == 0 || view_count == 0 || resolution == 0 ||
+        mesh.vertex_stride < sizeof(DirectX::XMFLOAT3)) {
+        return stats;
+    }
+
+    std::vector<DirectX::XMFLOAT3> positions(mesh.vertex_count);
+    DirectX::XMFLOAT3 lo = LoadPosition(mesh, 0);
+    DirectX::XMFLOAT3 hi = lo;
+    for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+        positions[v] = LoadPosition(mesh, v);
+        lo = {std::min(lo.x, positions[v].x), std::min(lo.y, positions[v].y), std::min(lo.z, positions[v].z)};
+        hi = {std::max(hi.x, positions[v].x), std::max(hi.y, positions[v].y), std::max(hi.z, positions[v].z)};
+    }
+    const DirectX::XMFLOAT3 center = {(lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f};
+    const DirectX::XMFLOAT3 extent = Sub(hi, center);
+    const float radius = std::max(std::sqrt(Dot(extent, extent)), 1e-6f);
+    const float to_pixels = 0.5f * static_cast<float>(resolution) / radius;
+    const float half_resolution = 0.5f * static_cast<float>(resolution);
+
+    std::vector<DirectX::XMFLOAT3> projected(mesh.vertex_count);
+    std::vector<float> depth(std::size_t{resolution} * resolution);
+    const float golden_angle = 2.39996323f;
+
+    for (std::uint32_t view = 0; view < view_count; ++view) {
+        // Fibonacci sphere directions give an even spread without clustering at the poles.
+        const float y = 1.0f - 2.0f * (static_cast<float>(view) + 0.5f) / static_cast<float>(view_count);
+        const float ring = std::sqrt(std::max(0.0f, 1.0f - y * y));
+        const float phi = golden_angle * static_cast<float>(view);
+        const DirectX::XMFLOAT3 forward = {ring * std::cos(phi), y, ring * std::sin(phi)};
+        const DirectX::XMFLOAT3 world_up = std::fabs(forward.y) > 0.99f ? DirectX::XMFLOAT3{1.0f, 0.0f, 0.0f}
+                                                                         : DirectX::XMFLOAT3{0.0f, 1.0f, 0.0f};
+        DirectX::XMFLOAT3 right = Cross(world_up, forward);
+        const float right_length = std::sqrt(Dot(right, right));
+        right = {right.x / right_length, right.y / right_length, right.z / right_length};
+        const DirectX::XMFLOAT3 up = Cross(forward, right);
+
+        for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+            const DirectX::XMFLOAT3 d = Sub(positions[v], center);
+            projected[v] = {Dot(d, right) * to_pixels + half_resolution, Dot(d, up) * to_pixels + half_resolution,
+                            Dot(d, forward)};
+        }
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+
+        for (std::size_t t = 0; t < triangle_count; ++t) {
+            const DirectX::XMFLOAT3 &a = projected[mesh.indices[t * 3]];
+            const DirectX::XMFLOAT3 &b = projected[mesh.indices[t * 3 + 1]];
+            const DirectX::XMFLOAT3 &c = projected[mesh.indices[t * 3 + 2]];
+            const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (std::fabs(area) < 1e-8f) {
+                continue;
+            }
+            const float sign = area > 0.0f ? 1.0f : -1.0f;
+            const float inv_area = 1.0f / std::fabs(area);
+
+            const int min_x = std::max(0, static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+            const int min_y = std::max(0, static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+            const int max_x = std::min(static_cast<int>(resolution) - 1,
+                                       static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}))));
+            const int max_y = std::min(static_cast<int>(resolution) - 1,
+                                       static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}))));
+            for (int py = min_y; py <= max_y; ++py) {
+                const float sy = static_cast<float>(py) + 0.5f;
+                for (int px = min_x; px <= max_x; ++px) {
+                    const float sx = static_cast<float>(px) + 0.5f;
+                    const float w0 = sign * ((c.x - b.x) * (sy - b.y) - (c.y - b.y) * (sx - b.x));
+                    const float w1 = sign * ((a.x - c.x) * (sy - c.y) - (a.y - c.y) * (sx - c.x));
+                    const float w2 = sign * ((b.x - a.x) * (sy - a.y) - (b.y - a.y) * (sx - a.x));
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                        continue;
+                    }
+                    const float z = (w0 * a.z + w1 * b.z + w2 * c.z) * inv_area;
+                    float &stored = depth[static_cast<std::size_t>(py) * resolution + px];
+                    if (z < stored) {
+                        stored = z;
+                        ++stats.pixels_shaded;
+                    }
+                }
+            }
+        }
+
+        for (const float d: depth) {
+            if (d != std::numeric_limits<float>::infinity()) {
+                ++stats.pixels_covered;
+            }
+        }
+    }
+
+    stats.overdraw = stats.pixels_covered > 0
+                         ? static_cast<float>(stats.pixels_shaded) / static_cast<float>(stats.pixels_covered)
+                         : 0.0f;
+    return stats;
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MeshData.h"
+#include <cstdint>
+#include <vector>
+
+namespace gfw {
+    struct VertexCacheStats {
+        float acmr = 0.0f; // transformed vertices per triangle
+        float atvr = 0.0f; // transformed vertices per referenced vertex
+        std::uint32_t transforms = 0;
+    };
+
+    struct OverdrawStats {
+        float overdraw = 0.0f; // shaded fragments per covered pixel, averaged over all views
+        std::uint64_t pixels_covered = 0;
+        std::uint64_t pixels_shaded = 0;
+    };
+
+    // Index and vertex reordering for triangle lists; operates in place on MeshData.
+    class MeshOptimizer {
+    public:
+        // Forsyth-style greedy triangle ordering for the post-transform vertex cache.
+        static void OptimizeVertexCache(std::vector<std::uint32_t> &indices, std::uint32_t vertex_count);
+
+        // Splits the (cache-optimized) triangle order into clusters and draws outward-facing clusters
+        // first. threshold is the ACMR a cluster may degrade to relative to its parent run; larger
+        // values give more, smaller clusters and less overdraw at the cost of vertex cache reuse.
+        static void OptimizeOverdraw(MeshData &mesh, float threshold);
+
+        // Renumbers vertices in first-use order so fetches stream through the vertex buffer.
+        // Vertices no triangle references are dropped.
+        static void OptimizeVertexFetch(MeshData &mesh);
+
+        // Runs all passes on triangle-list meshes; a non-positive threshold skips the overdraw pass.
+        static void Optimize(MeshData &mesh, float overdraw_threshold = 1.05f);
+
+        // Simulates a FIFO post-transform cache of the given size.
+        static VertexCacheStats AnalyzeVertexCache(const std::vector<std::uint32_t> &indices,
+                                                   std::uint32_t vertex_count, std::uint32_t cache_size = 16);
+
+        // Depth-tested software raster of the mesh in draw order from view_count directions spread over
+        // a sphere (orthographic, no culling, like the GBuffer pipeline).
+        static OverdrawStats AnalyzeOverdraw(const MeshData &mesh, std::uint32_t view_count = 16,
+                                             std::uint32_t resolution = 256);
+    };
+}
@@ -0,0 +1,320 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace gfw {
+
+namespace {
+    struct Quadric {
+        // Symmetric 3x3 A, vector b and scalar c of sum(w * (n.p + d)^2); weight is sum(w).
+        float a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        float b0 = 0, b1 = 0, b2 = 0;
+        float c = 0;
+        float weight = 0;
+
+        void AddPlane(const XMFLOAT3 &n, float d, float w) {
+            a00 += w * n.x * n.x; a11 += w * n.y * n.y; a22 += w * n.z * n.z;
+            a01 += w * n.x * n.y; a02 += w * n.x * n.z; a12 += w * n.y * n.z;
+            b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric &q) {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22;
+            a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+        }
+
+        // Mean squared distance of p to the accumulated planes.
+        [[nodiscard]] float Error(const XMFLOAT3 &p) const {
+            const float rx = a00 * p.x + a01 * p.y + a02 * p.z;
+            const float ry = a01 * p.x + a11 * p.y + a12 * p.z;
+            const float rz = a02 * p.x + a12 * p.y + a22 * p.z;
+            const float e = p.x * rx + p.y * ry + p.z * rz + 2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return weight > 0.0f ? std::max(e, 0.0f) / weight : 0.0f;
+        }
+    };
+
+    enum class VertexKind : std::uint8_t {
+        Manifold, // interior vertex with a single wedge; may collapse
+        Border,   // on an open edge; may receive collapses but never moves
+        Locked,   // shares its position with another vertex (attribute seam); never touched
+    };
+
+    struct Collapse {
+        std::uint32_t from;
+        std::uint32_t to;
+        float error;
+    };
+
+    XMFLOAT3 Sub(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b) {
+        return a < b ? (std::uint64_t{a} << 32) | b : (std::uint64_t{b} << 32) | a;
+    }
+
+    std::vector<XMFLOAT3> LoadPositions(const MeshData &mesh) {
+        std::vector<XMFLOAT3> positions(mesh.vertex_count);
+        for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+            std::memcpy(&positions[v], mesh.vertex_data.data() + std::size_t{v} * mesh.vertex_stride, sizeof(XMFLOAT3));
+        }
+        return positions;
+    }
+
+    std::vector<VertexKind> ClassifyVertices(const std::vector<XMFLOAT3> &positions,
+                                             const std::vector<std::uint32_t> &indices) {
+        const auto vertex_count = static_cast<std::uint32_t>(positions.size());
+        std::vector<VertexKind> kinds(vertex_count, VertexKind::Manifold);
+
+        // Vertices that share a position but differ in attributes form a seam.
+        struct PositionHash {
+            std::size_t operator()(const XMFLOAT3 &p) const {
+                std::uint32_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        struct PositionEqual {
+            bool operator()(const XMFLOAT3 &a, const XMFLOAT3 &b) const {
+                return std::memcmp(&a, &b, sizeof(XMFLOAT3)) == 0;
+            }
+        };
+        std::unordered_map<XMFLOAT3, std::uint32_t, PositionHash, PositionEqual> first_with_position;
+        first_with_position.reserve(vertex_count);
+        for (std::uint32_t v = 0; v < vertex_count; ++v) {
+            auto [it, inserted] = first_with_position.emplace(positions[v], v);
+            if (!inserted) {
+                kinds[v] = VertexKind::Locked;
+                kinds[it->second] = VertexKind::Locked;
+            }
+        }
+
+        // Edges used by exactly one triangle are open; their vertices must not move.
+        std::unordered_map<std::uint64_t, std::uint32_t> edge_use;
+        edge_use.reserve(indices.size());
+        for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                ++edge_use[EdgeKey(indices[t + k], indices[t + (k + 1) % 3])];
+            }
+        }
+        for (const auto &[key, count]: edge_use) {
+            if (count != 1) {
+                continue;
+            }
+            for (const std::uint32_t v: {static_cast<std::uint32_t>(key >> 32), static_cast<std::uint32_t>(key)}) {
+                if (kinds[v] == VertexKind::Manifold) {
+                    kinds[v] = VertexKind::Border;
+                }
+            }
+        }
+        return kinds;
+    }
+
+    // Rejects collapses that would flip or crush a triangle around `from`.
+    bool CollapseKeepsOrientation(const std::vector<XMFLOAT3> &positions, const std::vector<std::uint32_t> &indices,
+                                  const std::uint32_t *triangles, std::uint32_t triangle_count,
+                                  std::uint32_t from, std::uint32_t to) {
+        for (std::uint32_t i = 0; i < triangle_count; ++i) {
+            const std::uint32_t *tri = &indices[std::size_t{triangles[i]} * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                continue; // this triangle disappears
+            }
+            XMFLOAT3 p[3];
+            XMFLOAT3 q[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = positions[tri[k]];
+                q[k] = tri[k] == from ? positions[to] : p[k];
+            }
+            const XMFLOAT3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+            const XMFLOAT3 after = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+            const float before_length = std::sqrt(Dot(before, before));
+            const float after_length = std::sqrt(Dot(after, after));
+            if (after_length <= 0.0f || Dot(before, after) < 0.25f * before_length * after_length) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+std::vector<std::uint32_t> MeshSimplifier::Simplify(const MeshData &mesh, const std::vector<std::uint32_t> &indices,
+                                                    std::size_t target_index_count, float &error) {
+    error = 0.0f;
+    std::vector<std::uint32_t> result(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(indices.size() / 3 * 3));
+    if (result.size() <= target_index_count || mesh.vertex_count == 0 || mesh.vertex_stride < sizeof(XMFLOAT3)) {
+        return result;
+    }
+
+    const std::vector<XMFLOAT3> positions = LoadPositions(mesh);
+    const std::vector<VertexKind> kinds = ClassifyVertices(positions, result);
+
+    std::vector<Quadric> quadrics(mesh.vertex_count);
+    for (std::size_t t = 0; t < result.size(); t += 3) {
+        const XMFLOAT3 &a = positions[result[t]];
+        const XMFLOAT3 n = Cross(Sub(positions[result[t + 1]], a), Sub(positions[result[t + 2]], a));
+        const float length = std::sqrt(Dot(n, n));
+        if (length <= 0.0f) {
+            continue;
+        }
+        const XMFLOAT3 unit = {n.x / length, n.y / length, n.z / length};
+        Quadric q;
+        q.AddPlane(unit, -Dot(unit, a), length * 0.5f);
+        for (int k = 0; k < 3; ++k) {
+            quadrics[result[t + k]].Add(q);
+        }
+    }
+
+    std::vector<std::uint32_t> remap(mesh.vertex_count);
+    std::vector<std::uint8_t> touched(mesh.vertex_count);
+    std::vector<std::uint32_t> adjacency_offset(mesh.vertex_count + 1);
+    std::vector<std::uint32_t> adjacency;
+    std::vector<Collapse> candidates;
+    float max_error_sq = 0.0f;
+
+    while (result.size() > target_index_count) {
+        const std::size_t triangle_count = result.size() / 3;
+
+        // ---------- Vertex -> triangle adjacency of the current mesh ----------
+        std::fill(adjacency_offset.begin(), adjacency_offset.end(), 0u);
+        for (const std::uint32_t v: result) {
+            ++adjacency_offset[v + 1];
+        }
+        for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+            adjacency_offset[v + 1] += adjacency_offset[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<std::uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+            for (std::size_t i = 0; i < result.size(); ++i) {
+                adjacency[fill[result[i]]++] = static_cast<std::uint32_t>(i / 3);
+            }
+        }
+
+        // ---------- Candidate collapses, cheapest first ----------
+        candidates.clear();
+        for (std::size_t t = 0; t < triangle_count; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                const std::uint32_t a = result[t * 3 + k];
+                const std::uint32_t b = result[t * 3 + (k + 1) % 3];
+                for (const auto &[from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+                    if (kinds[from] != VertexKind::Manifold || kinds[to] == VertexKind::Locked) {
+                        continue;
+                    }
+                    Quadric q = quadrics[from];
+                    q.Add(quadrics[to]);
+                    candidates.push_back({from, to, q.Error(positions[to])});
+                }
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse &l, const Collapse &r) {
+            if (l.error != r.error) return l.error < r.error;
+            if (l.from != r.from) return l.from < r.from;
+            return l.to < r.to;
+        });
+
+        // ---------- Apply non-overlapping collapses ----------
+        // Each collapse removes about two triangles; the pass stops once that reaches the target so the
+        // last pass does not overshoot with expensive collapses.
+        for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), std::uint8_t{0});
+        const std::size_t triangles_to_remove = triangle_count - target_index_count / 3;
+        std::size_t collapses = 0;
+        for (const Collapse &collapse: candidates) {
+            if (collapses * 2 >= triangles_to_remove) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+            const std::uint32_t *around = adjacency.data() + adjacency_offset[collapse.from];
+            const std::uint32_t around_count = adjacency_offset[collapse.from + 1] - adjacency_offset[collapse.from];
+            if (!CollapseKeepsOrientation(positions, result, around, around_count, collapse.from, collapse.to)) {
+                continue;
+            }
+            // Neighbours of `from` are frozen too, so the orientation check above stays valid for this pass.
+            for (std::uint32_t i = 0; i < around_count; ++i) {
+                const std::uint32_t *tri = &result[std::size_t{around[i]} * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            max_error_sq = std::max(max_error_sq, collapse.error);
+            ++collapses;
+        }
+        if (collapses == 0) {
+            break;
+        }
+
+        std::size_t write = 0;
+        for (std::size_t t = 0; t < triangle_count; ++t) {
+            const std::uint32_t a = remap[result[t * 3]];
+            const std::uint32_t b = remap[result[t * 3 + 1]];
+            const std::uint32_t c = remap[result[t * 3 + 2]];
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    error = std::sqrt(max_error_sq);
+    return result;
+}
+
+void MeshSimplifier::BuildLods(MeshData &mesh, const std::vector<float> &ratios) {
+    mesh.lods.clear();
+    const auto base_count = static_cast<std::uint32_t>(mesh.indices.size() / 3 * 3);
+    if (base_count == 0 || mesh.topology != PrimitiveTopology::TriangleList) {
+        return;
+    }
+    mesh.lods.push_back({0, base_count, 0.0f});
+
+    std::vector<std::uint32_t> previous(mesh.indices.begin(), mesh.indices.begin() + base_count);
+    float previous_error = 0.0f;
+    for (const float ratio: ratios) {
+        const auto target = static_cast<std::size_t>(static_cast<double>(base_count / 3) * ratio) * 3;
+        float level_error = 0.0f;
+        std::vector<std::uint32_t> lod = Simplify(mesh, previous, target, level_error);
+        // Levels that barely shrink only cost memory.
+        if (lod.empty() || lod.size() * 10 > previous.size() * 9) {
+            break;
+        }
+        MeshOptimizer::OptimizeVertexCache(lod, mesh.vertex_count);
+
+        // Each level is simplified from the previous one, so errors add up (triangle inequality).
+        previous_error += level_error;
+        mesh.lods.push_back({static_cast<std::uint32_t>(mesh.indices.size()), static_cast<std::uint32_t>(lod.size()),
+                             previous_error});
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+        previous = std::move(lod);
+    }
+}
+
+}
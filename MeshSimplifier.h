@@ -0,0 +1,22 @@
+#pragma once
+
+#include "MeshData.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfw {
+    // Quadric edge-collapse simplification that keeps the vertex buffer and only rewrites indices.
+    // Open edges (including submesh boundaries) and vertices split by UV/normal seams stay locked.
+    class MeshSimplifier {
+    public:
+        // Collapses edges of a triangle list until at most target_index_count indices remain or no
+        // collapse is left. error receives the RMS object-space distance of the worst collapse.
+        static std::vector<std::uint32_t> Simplify(const MeshData &mesh, const std::vector<std::uint32_t> &indices,
+                                                   std::size_t target_index_count, float &error);
+
+        // Appends one LOD per ratio (relative to the base triangle count) after the base indices and
+        // fills mesh.lods, with LOD 0 covering the base range. Stops when a level no longer shrinks.
+        static void BuildLods(MeshData &mesh, const std::vector<float> &ratios);
+    };
+}
@@ -0,0 +1,186 @@
+#include "Meshlets.h"
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+using namespace DirectX;
+
+namespace gfw {
+
+namespace {
+    XMFLOAT3 LoadPosition(const MeshData &mesh, std::uint32_t index) {
+        XMFLOAT3 p;
+        std::memcpy(&p, mesh.vertex_data.data() + std::size_t{index} * mesh.vertex_stride, sizeof(p));
+        return p;
+    }
+
+    XMFLOAT3 Sub(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    void ComputeBounds(const MeshData &mesh, Meshlet &meshlet) {
+        const std::uint32_t *indices = mesh.indices.data() + meshlet.index_offset;
+        const std::uint32_t index_count = meshlet.triangle_count * 3;
+
+        XMFLOAT3 lo = LoadPosition(mesh, indices[0]);
+        XMFLOAT3 hi = lo;
+        for (std::uint32_t i = 1; i < index_count; ++i) {
+            const XMFLOAT3 p = LoadPosition(mesh, indices[i]);
+            lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+            hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+        }
+        meshlet.aabb_min = lo;
+        meshlet.aabb_max = hi;
+        meshlet.center = {(lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f};
+
+        float radius_sq = 0.0f;
+        for (std::uint32_t i = 0; i < index_count; ++i) {
+            const XMFLOAT3 d = Sub(LoadPosition(mesh, indices[i]), meshlet.center);
+            radius_sq = std::max(radius_sq, Dot(d, d));
+        }
+        meshlet.radius = std::sqrt(radius_sq);
+
+        // Normals follow the clockwise front-face winding, so they point towards a viewer that sees the front.
+        XMFLOAT3 normals[Meshlets::kMaxTriangles];
+        std::uint32_t normal_count = 0;
+        XMFLOAT3 axis = {0.0f, 0.0f, 0.0f};
+        for (std::uint32_t t = 0; t < meshlet.triangle_count; ++t) {
+            const XMFLOAT3 a = LoadPosition(mesh, indices[t * 3]);
+            const XMFLOAT3 n = Cross(Sub(LoadPosition(mesh, indices[t * 3 + 1]), a),
+                                     Sub(LoadPosition(mesh, indices[t * 3 + 2]), a));
+            const float length = std::sqrt(Dot(n, n));
+            if (length <= 0.0f) {
+                continue;
+            }
+            normals[normal_count] = {n.x / length, n.y / length, n.z / length};
+            axis = {axis.x + normals[normal_count].x, axis.y + normals[normal_count].y,
+                    axis.z + normals[normal_count].z};
+            ++normal_count;
+        }
+
+        meshlet.cone_axis = {0.0f, 0.0f, 0.0f};
+        meshlet.cone_cutoff = 1.0f;
+        const float axis_length = std::sqrt(Dot(axis, axis));
+        if (normal_count == 0 || axis_length <= 0.0f) {
+            return;
+        }
+        axis = {axis.x / axis_length, axis.y / axis_length, axis.z / axis_length};
+        float min_dot = 1.0f;
+        for (std::uint32_t i = 0; i < normal_count; ++i) {
+            min_dot = std::min(min_dot, Dot(normals[i], axis));
+        }
+        meshlet.cone_axis = axis;
+        // Normals spread over a hemisphere or more can always be seen from somewhere.
+        if (min_dot > 0.0f) {
+            meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+        }
+    }
+}
+
+void Meshlets::Build(MeshData &mesh) {
+    mesh.meshlets.clear();
+    const std::size_t triangle_count = mesh.indices.size() / 3;
+    if (triangle_count == 0 || mesh.vertex_count == 0 || mesh.vertex_stride < sizeof(XMFLOAT3)) {
+        return;
+    }
+
+    // last_meshlet[v] is the id of the newest meshlet that references v.
+    std::vector<std::uint32_t> last_meshlet(mesh.vertex_count, 0xffffffffu);
+    Meshlet current;
+    std::uint32_t current_id = 0;
+
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+        const std::uint32_t *tri = &mesh.indices[t * 3];
+        auto count_new = [&]() {
+            std::uint32_t fresh = 0;
+            for (int k = 0; k < 3; ++k) {
+                const bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+                if (!repeated && last_meshlet[tri[k]] != current_id) {
+                    ++fresh;
+                }
+            }
+            return fresh;
+        };
+
+        std::uint32_t fresh = count_new();
+        if (current.triangle_count > 0 &&
+            (current.triangle_count == kMaxTriangles || current.vertex_count + fresh > kMaxVertices)) {
+            ComputeBounds(mesh, current);
+            mesh.meshlets.push_back(current);
+            current = {};
+            current.index_offset = static_cast<std::uint32_t>(t * 3);
+            ++current_id;
+            fresh = count_new();
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            last_meshlet[tri[k]] = current_id;
+        }
+        current.vertex_count += fresh;
+        ++current.triangle_count;
+    }
+    ComputeBounds(mesh, current);
+    mesh.meshlets.push_back(current);
+}
+
+MeshletCullView Meshlets::MakeCullView(const XMMATRIX &world, const XMMATRIX &view_proj,
+                                       const XMFLOAT3 &camera_position) {
+    MeshletCullView cull_view;
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, XMMatrixMultiply(world, view_proj));
+    const FrustumCuller::Frustum frustum = FrustumCuller::ExtractFrustum(m);
+    std::copy(std::begin(frustum.planes), std::end(frustum.planes), cull_view.planes);
+
+    const XMMATRIX inv_world = XMMatrixInverse(nullptr, world);
+    XMStoreFloat3(&cull_view.camera_position, XMVector3TransformCoord(XMLoadFloat3(&camera_position), inv_world));
+    return cull_view;
+}
+
+std::uint32_t Meshlets::Cull(const std::vector<Meshlet> &meshlets, const MeshletCullView &view, bool cone_culling,
+                             std::vector<MeshletDrawRange> &ranges) {
+    std::uint32_t culled = 0;
+    for (const Meshlet &meshlet: meshlets) {
+        bool visible = true;
+        for (const XMFLOAT4 &plane: view.planes) {
+            const float distance = plane.x * meshlet.center.x + plane.y * meshlet.center.y +
+                                   plane.z * meshlet.center.z + plane.w;
+            if (distance < -meshlet.radius) {
+                visible = false;
+                break;
+            }
+        }
+
+        if (visible && cone_culling && meshlet.cone_cutoff < 1.0f) {
+            const XMFLOAT3 to_center = Sub(meshlet.center, view.camera_position);
+            const float distance = std::sqrt(Dot(to_center, to_center));
+            if (Dot(to_center, meshlet.cone_axis) >= meshlet.cone_cutoff * distance + meshlet.radius) {
+                visible = false;
+            }
+        }
+
+        if (!visible) {
+            ++culled;
+            continue;
+        }
+        const std::uint32_t index_count = meshlet.triangle_count * 3;
+        if (!ranges.empty() && ranges.back().index_offset + ranges.back().index_count == meshlet.index_offset) {
+            ranges.back().index_count += index_count;
+        } else {
+            ranges.push_back({meshlet.index_offset, index_count});
+        }
+    }
+    return culled;
+}
+
+}
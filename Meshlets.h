@@ -0,0 +1,36 @@
+#pragma once
+
+#include "MeshData.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+namespace gfw {
+    struct MeshletDrawRange {
+        std::uint32_t index_offset = 0;
+        std::uint32_t index_count = 0;
+    };
+
+    // Object-space view data for meshlet culling; planes point inwards and are normalized.
+    struct MeshletCullView {
+        DirectX::XMFLOAT4 planes[6] = {};
+        DirectX::XMFLOAT3 camera_position = {0.0f, 0.0f, 0.0f};
+    };
+
+    class Meshlets {
+    public:
+        static constexpr std::uint32_t kMaxVertices = 64;
+        static constexpr std::uint32_t kMaxTriangles = 124;
+
+        // Splits the index buffer, in its current order, into meshlets and fills mesh.meshlets.
+        static void Build(MeshData &mesh);
+
+        // Expresses the view_proj frustum and the world-space camera position in the object space of world.
+        static MeshletCullView MakeCullView(const DirectX::XMMATRIX &world, const DirectX::XMMATRIX &view_proj,
+                                            const DirectX::XMFLOAT3 &camera_position);
+
+        // Appends visible meshlets as index ranges, merging neighbours; returns the number culled.
+        static std::uint32_t Cull(const std::vector<Meshlet> &meshlets, const MeshletCullView &view,
+                                  bool cone_culling, std::vector<MeshletDrawRange> &ranges);
+    };
+}
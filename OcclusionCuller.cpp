@@ -0,0 +1,435 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "framework/ParallelFor.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFW_OCCLUSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace gfw {
+    namespace {
+        // Larger buffers only cost memory and time; 8192 keeps the pyramid within kMaxLevels.
+        constexpr std::uint32_t kMaxResolution = 8192;
+        constexpr size_t kMaxLevels = 15;
+        // Occluder vertices projected further off screen than this many pixels drop their triangle, which keeps the
+        // edge functions within float precision.
+        constexpr float kGuardBand = 1.0e6f;
+        // Objects per ParallelFor item in Cull.
+        constexpr size_t kCullBatch = 256;
+
+        XMFLOAT4X4 Multiply(const XMFLOAT4X4 &a, const XMFLOAT4X4 &b) {
+            XMFLOAT4X4 result;
+            for (int row = 0; row < 4; ++row) {
+                for (int column = 0; column < 4; ++column) {
+                    result.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column] +
+                                            a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+                }
+            }
+            return result;
+        }
+
+        XMFLOAT4 Transform(float x, float y, float z, const XMFLOAT4X4 &m) {
+            return {x * m._11 + y * m._21 + z * m._31 + m._41, x * m._12 + y * m._22 + z * m._32 + m._42,
+                    x * m._13 + y * m._23 + z * m._33 + m._43, x * m._14 + y * m._24 + z * m._34 + m._44};
+        }
+    }
+
+    void OcclusionCuller::Resize(std::uint32_t width, std::uint32_t height) {
+        width = std::clamp((width + kTileSize - 1) / kTileSize * kTileSize, kTileSize, kMaxResolution);
+        height = std::clamp((height + kTileSize - 1) / kTileSize * kTileSize, kTileSize, kMaxResolution);
+        if (width == width_ && height == height_) {
+            return;
+        }
+        width_ = width;
+        height_ = height;
+        levels_.clear();
+        level_widths_.clear();
+        level_heights_.clear();
+        for (;;) {
+            level_widths_.push_back(width);
+            level_heights_.push_back(height);
+            levels_.emplace_back(std::size_t{width} * height, 1.0f);
+            if (width == 1 && height == 1) {
+                break;
+            }
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+
+    void OcclusionCuller::BeginFrame(const XMFLOAT4X4 &view_proj) {
+        view_proj_ = view_proj;
+        occluders_.clear();
+        vertex_count_ = 0;
+        triangle_count_ = 0;
+        stats_ = {};
+    }
+
+    void OcclusionCuller::AddOccluder(const OccluderMesh &mesh, const XMFLOAT4X4 &world) {
+        if (mesh.indices.size() < 3) {
+            return;
+        }
+        occluders_.push_back({&mesh, Multiply(world, view_proj_), vertex_count_, triangle_count_});
+        vertex_count_ += mesh.positions.size();
+        triangle_count_ += mesh.indices.size() / 3;
+    }
+
+    size_t OcclusionCuller::SetupOccluder(const Occluder &occluder, size_t &triangles) {
+        const OccluderMesh &mesh = *occluder.mesh;
+        const float width = static_cast<float>(width_);
+        const float height = static_cast<float>(height_);
+        XMFLOAT4 *screen = screen_.data() + occluder.first_vertex;
+        for (size_t i = 0; i < mesh.positions.size(); ++i) {
+            const XMFLOAT4 p = Transform(mesh.positions[i].x, mesh.positions[i].y, mesh.positions[i].z,
+                                         occluder.world_view_proj);
+            screen[i] = {0.0f, 0.0f, 0.0f, 0.0f};
+            // Clipping at the near plane would need new vertices; dropping the triangles only occludes less.
+            if (!(p.z >= 0.0f && p.w > 0.0f)) {
+                continue;
+            }
+            const float inv_w = 1.0f / p.w;
+            const float x = (p.x * inv_w * 0.5f + 0.5f) * width;
+            const float y = (0.5f - p.y * inv_w * 0.5f) * height;
+            if (std::abs(x) < kGuardBand && std::abs(y) < kGuardBand) {
+                screen[i] = {x, y, p.z * inv_w, 1.0f};
+            }
+        }
+
+        const auto usable = [&](std::uint32_t index) {
+            return index < mesh.positions.size() && screen[index].w != 0.0f;
+        };
+        const auto edge_function = [](float x0, float y0, float x1, float y1, float *edge) {
+            edge[0] = y0 - y1;
+            edge[1] = x1 - x0;
+            edge[2] = (y1 - y0) * x0 - (x1 - x0) * y0;
+        };
+        Triangle *out = triangles_.data() + occluder.first_triangle;
+        size_t drawn = 0;
+        triangles = 0;
+        for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            std::uint32_t index[3] = {mesh.indices[t], mesh.indices[t + 1], mesh.indices[t + 2]};
+            if (!usable(index[0]) || !usable(index[1]) || !usable(index[2])) {
+                continue;
+            }
+            float sx[4], sy[4], sz[4];
+            for (int v = 0; v < 3; ++v) {
+                sx[v] = screen[index[v]].x;
+                sy[v] = screen[index[v]].y;
+                sz[v] = screen[index[v]].z;
+            }
+            float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+            if (!(std::abs(area) > 0.0f)) {
+                continue;
+            }
+            if (area < 0.0f) {
+                // Both windings occlude: the GBuffer pass draws both (kGeometryCullMode in RenderingSystem.cpp).
+                std::swap(index[1], index[2]);
+                std::swap(sx[1], sx[2]);
+                std::swap(sy[1], sy[2]);
+                std::swap(sz[1], sz[2]);
+                area = -area;
+            }
+
+            // Edge i is opposite vertex i, so edge i over area is vertex i's barycentric weight.
+            Triangle &triangle = out[drawn];
+            const float inv_area = 1.0f / area;
+            float depth[3] = {0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < 3; ++i) {
+                edge_function(sx[(i + 1) % 3], sy[(i + 1) % 3], sx[(i + 2) % 3], sy[(i + 2) % 3], triangle.edge[i]);
+                for (int k = 0; k < 3; ++k) {
+                    depth[k] += triangle.edge[i][k] * sz[i] * inv_area;
+                }
+            }
+            std::fill_n(triangle.edge[3], 3, 0.0f);
+            int vertices = 3;
+
+            // Inner coverage leaves the pixels along an edge two triangles share uncovered, which would split
+            // every quad along its diagonal. When the next triangle shares an edge and the two form a convex
+            // quad, draw them as one: the quad's far side is no farther than this triangle's plane raised by
+            // how far behind it the fourth vertex lies.
+            if (t + 5 < mesh.indices.size()) {
+                const std::uint32_t *next = &mesh.indices[t + 3];
+                int opposite = -1;
+                int shared = 0;
+                for (int v = 0; v < 3; ++v) {
+                    if (std::find(next, next + 3, index[v]) != next + 3) {
+                        ++shared;
+                    } else {
+                        opposite = v;
+                    }
+                }
+                const std::uint32_t *fourth = std::find_if(next, next + 3, [&](std::uint32_t i) {
+                    return std::find(index, index + 3, i) == index + 3;
+                });
+                if (shared == 2 && fourth != next + 3 && usable(*fourth)) {
+                    const XMFLOAT4 &p = screen[*fourth];
+                    const auto side = [&](int edge) {
+                        return triangle.edge[edge][0] * p.x + triangle.edge[edge][1] * p.y + triangle.edge[edge][2];
+                    };
+                    const int a = (opposite + 1) % 3;
+                    const int b = (opposite + 2) % 3;
+                    if (side(opposite) < 0.0f && side(a) > 0.0f && side(b) > 0.0f) {
+                        depth[2] += std::max(0.0f, p.z - (depth[0] * p.x + depth[1] * p.y + depth[2]));
+                        edge_function(sx[a], sy[a], p.x, p.y, triangle.edge[opposite]);
+                        edge_function(p.x, p.y, sx[b], sy[b], triangle.edge[3]);
+                        sx[3] = p.x;
+                        sy[3] = p.y;
+                        sz[3] = p.z;
+                        vertices = 4;
+                        t += 3;
+                    }
+                }
+            }
+
+            // Pixels [x, x + 1] lying entirely within the extent, clamped before converting to int.
+            triangle.x0 = std::max(0, static_cast<std::int32_t>(std::ceil(*std::min_element(sx, sx + vertices))));
+            triangle.y0 = std::max(0, static_cast<std::int32_t>(std::ceil(*std::min_element(sy, sy + vertices))));
+            triangle.x1 = std::min(static_cast<std::int32_t>(width_) - 1,
+                                   static_cast<std::int32_t>(std::floor(*std::max_element(sx, sx + vertices))) - 1);
+            triangle.y1 = std::min(static_cast<std::int32_t>(height_) - 1,
+                                   static_cast<std::int32_t>(std::floor(*std::max_element(sy, sy + vertices))) - 1);
+            if (triangle.x0 > triangle.x1 || triangle.y0 > triangle.y1) {
+                continue;
+            }
+            // From the pixel center to its farthest corner.
+            depth[2] += 0.5f * (std::abs(depth[0]) + std::abs(depth[1]));
+            std::copy_n(depth, 3, triangle.depth);
+            // Moving each edge inwards by the reach of a pixel corner leaves only pixels entirely inside, so no
+            // depth is written where the occluder does not cover the whole pixel.
+            for (auto &edge : triangle.edge) {
+                edge[2] -= 0.5f * (std::abs(edge[0]) + std::abs(edge[1]));
+            }
+            triangle.max_depth = *std::max_element(sz, sz + vertices);
+            triangles += vertices - 2;
+            ++drawn;
+        }
+        return drawn;
+    }
+
+    void OcclusionCuller::RasterizeBand(std::uint32_t band) {
+        const std::int32_t row_begin = static_cast<std::int32_t>(band * kTileSize);
+        const std::int32_t row_end = row_begin + static_cast<std::int32_t>(kTileSize);
+        float *depth = levels_[0].data();
+        std::fill(depth + std::size_t{width_} * row_begin, depth + std::size_t{width_} * row_end, 1.0f);
+
+        for (const std::uint32_t index : band_triangles_[band]) {
+            const Triangle &triangle = triangles_[index];
+            const std::int32_t y0 = std::max(triangle.y0, row_begin);
+            const std::int32_t y1 = std::min(triangle.y1, row_end - 1);
+#if defined(GFW_OCCLUSION_SSE2)
+            // Four pixels per step from a 4-aligned start; width_ is a multiple of kTileSize, so no step overruns.
+            const std::int32_t x_begin = triangle.x0 & ~3;
+            const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 e0x = _mm_set1_ps(triangle.edge[0][0]);
+            const __m128 e1x = _mm_set1_ps(triangle.edge[1][0]);
+            const __m128 e2x = _mm_set1_ps(triangle.edge[2][0]);
+            const __m128 e3x = _mm_set1_ps(triangle.edge[3][0]);
+            const __m128 zx = _mm_set1_ps(triangle.depth[0]);
+            const __m128 max_depth = _mm_set1_ps(triangle.max_depth);
+            const __m128 zero = _mm_setzero_ps();
+            for (std::int32_t y = y0; y <= y1; ++y) {
+                const float py = static_cast<float>(y) + 0.5f;
+                const __m128 e0y = _mm_set1_ps(triangle.edge[0][1] * py + triangle.edge[0][2]);
+                const __m128 e1y = _mm_set1_ps(triangle.edge[1][1] * py + triangle.edge[1][2]);
+                const __m128 e2y = _mm_set1_ps(triangle.edge[2][1] * py + triangle.edge[2][2]);
+                const __m128 e3y = _mm_set1_ps(triangle.edge[3][1] * py + triangle.edge[3][2]);
+                const __m128 zy = _mm_set1_ps(triangle.depth[1] * py + triangle.depth[2]);
+                float *row = depth + std::size_t{width_} * y;
+                for (std::int32_t x = x_begin; x <= triangle.x1; x += 4) {
+                    const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+                    const __m128 inside = _mm_and_ps(
+                        _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e0x, px), e0y), zero),
+                                   _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e1x, px), e1y), zero)),
+                        _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e2x, px), e2y), zero),
+                                   _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e3x, px), e3y), zero)));
+                    const __m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(zx, px), zy), max_depth);
+                    const __m128 old = _mm_loadu_ps(row + x);
+                    const __m128 nearer = _mm_min_ps(old, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+                }
+            }
+#else
+            for (std::int32_t y = y0; y <= y1; ++y) {
+                const float py = static_cast<float>(y) + 0.5f;
+                float *row = depth + std::size_t{width_} * y;
+                for (std::int32_t x = triangle.x0; x <= triangle.x1; ++x) {
+                    const float px = static_cast<float>(x) + 0.5f;
+                    bool inside = true;
+                    for (const auto &edge : triangle.edge) {
+                        inside = inside && edge[0] * px + edge[1] * py + edge[2] >= 0.0f;
+                    }
+                    if (inside) {
+                        const float z = std::min(triangle.depth[0] * px + triangle.depth[1] * py + triangle.depth[2],
+                                                 triangle.max_depth);
+                        row[x] = std::min(row[x], z);
+                    }
+                }
+            }
+#endif
+        }
+
+        // A band is a row of whole tiles, so it reduces on its own down to one texel per tile.
+        for (size_t level = 1; level < levels_.size() && (kTileSize >> level) > 0; ++level) {
+            ReduceLevel(level, row_begin >> level, row_end >> level);
+        }
+    }
+
+    void OcclusionCuller::ReduceLevel(size_t level, std::uint32_t row_begin, std::uint32_t row_end) {
+        const std::vector<float> &src = levels_[level - 1];
+        std::vector<float> &dst = levels_[level];
+        const std::uint32_t src_width = level_widths_[level - 1];
+        const std::uint32_t src_height = level_heights_[level - 1];
+        const std::uint32_t dst_width = level_widths_[level];
+        for (std::uint32_t y = row_begin; y < row_end; ++y) {
+            // Odd sizes repeat their last row or column.
+            const std::uint32_t y0 = y * 2;
+            const std::uint32_t y1 = std::min(y0 + 1, src_height - 1);
+            for (std::uint32_t x = 0; x < dst_width; ++x) {
+                const std::uint32_t x0 = x * 2;
+                const std::uint32_t x1 = std::min(x0 + 1, src_width - 1);
+                dst[std::size_t{y} * dst_width + x] =
+                    std::max({src[std::size_t{y0} * src_width + x0], src[std::size_t{y0} * src_width + x1],
+                              src[std::size_t{y1} * src_width + x0], src[std::size_t{y1} * src_width + x1]});
+            }
+        }
+    }
+
+    void OcclusionCuller::Rasterize(unsigned thread_count) {
+        if (levels_.empty()) {
+            return;
+        }
+        screen_.resize(vertex_count_);
+        triangles_.resize(triangle_count_);
+        drawn_triangles_.assign(occluders_.size(), 0);
+        drawn_source_triangles_.assign(occluders_.size(), 0);
+        // Every occluder writes its own slice of screen_ and triangles_.
+        ParallelFor(occluders_.size(), thread_count, [&](size_t i) {
+            drawn_triangles_[i] = SetupOccluder(occluders_[i], drawn_source_triangles_[i]);
+        });
+        stats_.occluders = occluders_.size();
+        stats_.triangles = 0;
+        for (const size_t drawn : drawn_source_triangles_) {
+            stats_.triangles += drawn;
+        }
+
+        // Bands only read their own triangles; walking every triangle per band costs more than drawing small ones.
+        band_triangles_.resize(height_ / kTileSize);
+        for (std::vector<std::uint32_t> &band : band_triangles_) {
+            band.clear();
+        }
+        for (size_t i = 0; i < occluders_.size(); ++i) {
+            const auto first = static_cast<std::uint32_t>(occluders_[i].first_triangle);
+            for (std::uint32_t index = first; index < first + drawn_triangles_[i]; ++index) {
+                const Triangle &triangle = triangles_[index];
+                for (std::int32_t band = triangle.y0 / static_cast<std::int32_t>(kTileSize);
+                     band <= triangle.y1 / static_cast<std::int32_t>(kTileSize); ++band) {
+                    band_triangles_[band].push_back(index);
+                }
+            }
+        }
+
+        ParallelFor(height_ / kTileSize, thread_count, [&](size_t band) {
+            RasterizeBand(static_cast<std::uint32_t>(band));
+        });
+        for (size_t level = 1; level < levels_.size(); ++level) {
+            if ((kTileSize >> level) == 0) {
+                ReduceLevel(level, 0, level_heights_[level]);
+            }
+        }
+    }
+
+    bool OcclusionCuller::IsOccluded(const SceneBvh::Bounds &bounds) const {
+        if (levels_.empty() || SceneBvh::IsEmpty(bounds)) {
+            return false;
+        }
+        float min_x = std::numeric_limits<float>::max(), min_y = min_x, min_z = min_x;
+        float max_x = -min_x, max_y = -min_x;
+        for (int corner = 0; corner < 8; ++corner) {
+            const XMFLOAT4 p = Transform(corner & 1 ? bounds.max.x : bounds.min.x,
+                                         corner & 2 ? bounds.max.y : bounds.min.y,
+                                         corner & 4 ? bounds.max.z : bounds.min.z, view_proj_);
+            // Depth over w is monotonic in view depth only in front of the camera.
+            if (!(p.z >= 0.0f && p.w > 0.0f)) {
+                return false;
+            }
+            const float inv_w = 1.0f / p.w;
+            const float x = (p.x * inv_w * 0.5f + 0.5f) * static_cast<float>(width_);
+            const float y = (0.5f - p.y * inv_w * 0.5f) * static_cast<float>(height_);
+            min_x = std::min(min_x, x);
+            max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y);
+            max_y = std::max(max_y, y);
+            min_z = std::min(min_z, p.z * inv_w);
+        }
+        // Partly off screen: the part outside was never rasterized against.
+        if (!(min_x >= 0.0f && min_y >= 0.0f && max_x < static_cast<float>(width_) && max_y < static_cast<float>(height_))) {
+            return false;
+        }
+        // Every pixel the rectangle touches.
+        const auto x0 = static_cast<std::uint32_t>(min_x), x1 = static_cast<std::uint32_t>(max_x);
+        const auto y0 = static_cast<std::uint32_t>(min_y), y1 = static_cast<std::uint32_t>(max_y);
+
+        // Start where the rectangle spans at most 2x2 texels and descend only into texels the object is not
+        // entirely behind.
+        size_t start = 0;
+        while (start + 1 < levels_.size() && ((x1 >> start) - (x0 >> start) > 1 || (y1 >> start) - (y0 >> start) > 1)) {
+            ++start;
+        }
+        struct Texel {
+            std::uint32_t level, x, y;
+        };
+        Texel stack[4 + 3 * kMaxLevels];
+        size_t top = 0;
+        for (std::uint32_t y = y0 >> start; y <= y1 >> start; ++y) {
+            for (std::uint32_t x = x0 >> start; x <= x1 >> start; ++x) {
+                stack[top++] = {static_cast<std::uint32_t>(start), x, y};
+            }
+        }
+        while (top > 0) {
+            const Texel texel = stack[--top];
+            if (levels_[texel.level][std::size_t{texel.y} * level_widths_[texel.level] + texel.x] < min_z) {
+                continue;
+            }
+            if (texel.level == 0) {
+                return false;
+            }
+            const std::uint32_t level = texel.level - 1;
+            for (std::uint32_t y = std::max(texel.y * 2, y0 >> level); y <= std::min(texel.y * 2 + 1, y1 >> level);
+                 ++y) {
+                for (std::uint32_t x = std::max(texel.x * 2, x0 >> level); x <= std::min(texel.x * 2 + 1, x1 >> level);
+                     ++x) {
+                    stack[top++] = {level, x, y};
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t OcclusionCuller::Cull(const std::vector<SceneBvh::Bounds> &bounds, std::vector<std::uint32_t> &objects,
+                                 unsigned thread_count) {
+        occluded_.assign(objects.size(), 0);
+        ParallelFor((objects.size() + kCullBatch - 1) / kCullBatch, thread_count, [&](size_t batch) {
+            const size_t end = std::min(objects.size(), (batch + 1) * kCullBatch);
+            for (size_t i = batch * kCullBatch; i < end; ++i) {
+                occluded_[i] = IsOccluded(bounds[i]) ? 1 : 0;
+            }
+        });
+        size_t kept = 0;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            if (!occluded_[i]) {
+                objects[kept++] = objects[i];
+            }
+        }
+        const size_t removed = objects.size() - kept;
+        objects.resize(kept);
+        stats_.tested += occluded_.size();
+        stats_.occluded += removed;
+        return removed;
+    }
+}
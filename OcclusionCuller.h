@@ -0,0 +1,112 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SceneBvh.h"
+
+namespace gfw {
+    // Object-space triangle list an object occludes with, usually a mesh's coarsest LOD; see
+    // MeshLoader::ExtractOccluder.
+    struct OccluderMesh {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<std::uint32_t> indices;
+    };
+
+    // Software occlusion culling on the CPU. Occluder triangles are rasterized into a small depth buffer, split
+    // into bands of kTileSize rows so workers never share a pixel, and a max-depth pyramid is built over it.
+    // An object is occluded when the nearest point of its world AABB is behind the farthest occluder depth
+    // everywhere its screen rectangle covers. Results do not depend on the thread count or scheduling.
+    //
+    // Both stages err towards visible: occluder triangles crossing the near plane are skipped, a triangle only
+    // covers the pixels entirely inside it and stores the farthest depth it reaches within each, and objects
+    // crossing the near plane or leaving the screen are never culled. The price is that an edge two triangles
+    // share leaves a line of uncovered pixels, so a mesh occludes less than its outline; consecutive triangles
+    // forming a convex quad are drawn as one to keep quads whole.
+    class OcclusionCuller {
+    public:
+        static constexpr std::uint32_t kTileSize = 8;
+
+        struct Stats {
+            size_t occluders = 0;
+            size_t triangles = 0; // occluder triangles in front of the near plane and on screen
+            size_t tested = 0;
+            size_t occluded = 0;
+        };
+
+        // Rounded up to whole tiles.
+        void Resize(std::uint32_t width, std::uint32_t height);
+        [[nodiscard]] std::uint32_t Width() const { return width_; }
+        [[nodiscard]] std::uint32_t Height() const { return height_; }
+
+        // Starts a frame seen through view_proj (row vectors, [0, 1] depth); forgets the previous occluders.
+        void BeginFrame(const DirectX::XMFLOAT4X4 &view_proj);
+
+        // mesh has to stay alive until Rasterize returns.
+        void AddOccluder(const OccluderMesh &mesh, const DirectX::XMFLOAT4X4 &world);
+        [[nodiscard]] bool HasOccluders() const { return !occluders_.empty(); }
+
+        // Clears the depth buffer, draws every occluder added since BeginFrame and builds the pyramid.
+        void Rasterize(unsigned thread_count);
+
+        // Removes the objects whose world bounds (bounds[i] for objects[i]) are occluded, keeping the order of the
+        // rest, and returns how many were removed. Empty bounds stay visible.
+        size_t Cull(const std::vector<SceneBvh::Bounds> &bounds, std::vector<std::uint32_t> &objects,
+                    unsigned thread_count);
+
+        [[nodiscard]] bool IsOccluded(const SceneBvh::Bounds &bounds) const;
+
+        [[nodiscard]] const Stats &GetStats() const { return stats_; }
+        // Row-major width * height depth of the last Rasterize; 1 where no occluder was drawn.
+        [[nodiscard]] const std::vector<float> &Depth() const { return levels_.empty() ? empty_ : levels_[0]; }
+
+    private:
+        struct Occluder {
+            const OccluderMesh *mesh;
+            DirectX::XMFLOAT4X4 world_view_proj;
+            size_t first_vertex;   // into screen_
+            size_t first_triangle; // into triangles_, which holds the drawn ones first
+        };
+
+        // Edge functions and depth plane of a screen-space triangle, or of a convex quad made of two triangles
+        // sharing an edge: the pixel with center p is covered when edge[i][0] * p.x + edge[i][1] * p.y +
+        // edge[i][2] >= 0 for every edge. The edges are moved inwards so that this only holds when all four of its
+        // corners are inside. A triangle's fourth edge is all zeros.
+        struct Triangle {
+            float edge[4][3];
+            float depth[3];  // farthest depth within a covered pixel, as a plane over the pixel center
+            float max_depth; // of the vertices
+            std::int32_t x0, y0, x1, y1; // inclusive pixel bounds
+        };
+
+        // Projects an occluder's vertices and sets up the triangles and quads it draws at the start of its slice of
+        // triangles_; returns how many there are and sets triangles to the mesh triangles they hold.
+        size_t SetupOccluder(const Occluder &occluder, size_t &triangles);
+        // Clears, draws and reduces kTileSize rows of the depth buffer.
+        void RasterizeBand(std::uint32_t band);
+        // Fills rows [row_begin, row_end) of level from the level below it.
+        void ReduceLevel(size_t level, std::uint32_t row_begin, std::uint32_t row_end);
+
+        std::uint32_t width_ = 0;
+        std::uint32_t height_ = 0;
+        DirectX::XMFLOAT4X4 view_proj_ = {};
+        std::vector<Occluder> occluders_;
+        size_t vertex_count_ = 0;
+        size_t triangle_count_ = 0;
+        // Pixel x, y and depth of each occluder vertex; w is 0 for vertices no triangle may use.
+        std::vector<DirectX::XMFLOAT4> screen_;
+        std::vector<Triangle> triangles_;
+        std::vector<size_t> drawn_triangles_;        // entries of triangles_ per occluder
+        std::vector<size_t> drawn_source_triangles_; // mesh triangles those hold
+        // Triangles overlapping each band, in triangles_ order.
+        std::vector<std::vector<std::uint32_t>> band_triangles_;
+        // levels_[0] is the depth buffer; every further level holds the max of 2x2 texels of the one before.
+        std::vector<std::vector<float>> levels_;
+        std::vector<std::uint32_t> level_widths_;
+        std::vector<std::uint32_t> level_heights_;
+        std::vector<std::uint8_t> occluded_;
+        std::vector<float> empty_;
+        Stats stats_ = {};
+    };
+}
@@ -1,6 +1,7 @@
 #include "PlaneMesh.h"
 
 #include <array>
+#include <cstring>
 
 namespace gfw {
     PlaneMesh PlaneMesh::CreateUnit() {
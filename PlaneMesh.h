@@ -13,9 +13,9 @@ namespace gfw {
             MeshData data;
             data.vertex_data = vertex_data_;
             data.vertex_stride = vertex_stride_;
-            data.vertex_count = static_cast<UINT>(vertex_data_.size()) / vertex_stride_;
+            data.vertex_count = static_cast<std::uint32_t>(vertex_data_.size()) / vertex_stride_;
             data.indices.assign(indices_.begin(), indices_.end());
-            data.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+            data.topology = PrimitiveTopology::TriangleList;
             return data;
         }
 
@@ -0,0 +1,209 @@
+// Runs RenderingSystem::Render on a NullRenderDevice for a fixed number of frames over a synthetic scene and
+// reports the CPU cost per frame: culling, constant uploads and command recording, without a GPU or Windows.
+// A capture path also writes the last frame for CaptureReplay.
+//
+//   RenderBenchmark [frames] [objects] [capture.gfwcap]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "CubeMesh.h"
+#include "Meshlets.h"
+#include "OcclusionCuller.h"
+#include "PlaneMesh.h"
+#include "RenderingSystem.h"
+#include "framework/NullRenderDevice.h"
+
+using namespace gfw;
+
+namespace {
+    constexpr std::uint32_t kDefaultFrames = 300;
+    constexpr std::uint32_t kDefaultObjects = 2048;
+    constexpr std::uint32_t kWidth = 1920;
+    constexpr std::uint32_t kHeight = 1080;
+    constexpr float kSpacing = 3.0f;
+    // Every kDynamicStride-th cube bobs up and down, so the scene BVH has dynamic objects to refit.
+    constexpr std::uint32_t kDynamicStride = 8;
+    constexpr std::uint32_t kWallCount = 4;
+
+    // CubeMesh::ToMeshData leaves the bounds to the mesh loader; the unit cube spans [-1, 1].
+    MeshData CubeData() {
+        MeshData data = CubeMesh::CreateUnit().ToMeshData();
+        data.bounds_min = {-1.0f, -1.0f, -1.0f};
+        data.bounds_max = {1.0f, 1.0f, 1.0f};
+        Meshlets::Build(data);
+        return data;
+    }
+
+    // Positions are the first three floats of every CubeMesh vertex.
+    std::shared_ptr<OccluderMesh> CubeOccluder(const MeshData &data) {
+        auto occluder = std::make_shared<OccluderMesh>();
+        occluder->positions.resize(data.vertex_count);
+        for (std::uint32_t i = 0; i < data.vertex_count; ++i) {
+            std::memcpy(&occluder->positions[i], data.vertex_data.data() + i * data.vertex_stride,
+                        sizeof(DirectX::XMFLOAT3));
+        }
+        occluder->indices.assign(data.indices.begin(), data.indices.end());
+        return occluder;
+    }
+
+    RenderObject MakeObject(const MeshBuffers *mesh, const std::shared_ptr<Texture2D> &texture,
+                            const DirectX::XMMATRIX &world) {
+        RenderObject obj;
+        obj.mesh = mesh;
+        obj.texture = texture;
+        obj.DisableUVAnimation();
+        DirectX::XMStoreFloat4x4(&obj.world, world);
+        return obj;
+    }
+
+    struct FrameTimes {
+        double total_ms = 0.0;
+        double min_ms = 0.0;
+        double max_ms = 0.0;
+        std::uint32_t count = 0;
+
+        void Add(double ms) {
+            min_ms = count == 0 ? ms : std::min(min_ms, ms);
+            max_ms = std::max(max_ms, ms);
+            total_ms += ms;
+            ++count;
+        }
+    };
+}
+
+int main(int argc, char **argv) {
+    // RenderingSystem logs through cout and the device through wcout; unsynchronized streams keep both
+    // orientations working on one stdout.
+    std::ios::sync_with_stdio(false);
+
+    const std::uint32_t frames =
+        argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : kDefaultFrames;
+    const std::uint32_t object_count =
+        argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : kDefaultObjects;
+    const std::wstring capture_path = argc > 3 ? std::filesystem::path(argv[3]).wstring() : std::wstring();
+    if (frames == 0) {
+        std::cerr << "Usage: RenderBenchmark [frames] [objects] [capture.gfwcap]" << std::endl;
+        return -1;
+    }
+
+    NullRenderDevice device;
+    if (!device.Initialize(kWidth, kHeight)) {
+        return -1;
+    }
+
+    // A square grid of cubes on a ground plane, with a few wide walls across it that occlude the rows behind.
+    const MeshData cube_data = CubeData();
+    std::unique_ptr<MeshBuffers> cube = device.CreateMeshBuffers(cube_data);
+    std::unique_ptr<MeshBuffers> wall = device.CreateMeshBuffers(cube_data);
+    MeshData plane_data = PlaneMesh::CreateUnit().ToMeshData();
+    plane_data.bounds_min = {-0.5f, 0.0f, -0.5f};
+    plane_data.bounds_max = {0.5f, 0.0f, 0.5f};
+    std::unique_ptr<MeshBuffers> plane = device.CreateMeshBuffers(plane_data);
+    if (!cube || !wall || !plane) {
+        return -1;
+    }
+    wall->occluder = CubeOccluder(cube_data);
+    const std::shared_ptr<Texture2D> texture = device.CreateSolidTexture({0.8f, 0.8f, 0.8f, 1.0f});
+    device.FlushUploads();
+
+    const auto side = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(object_count))));
+    const float extent = static_cast<float>(side) * kSpacing;
+    const float origin = -0.5f * (extent - kSpacing);
+    std::vector<RenderObject> objects;
+    objects.reserve(object_count + kWallCount + 1);
+    objects.push_back(MakeObject(plane.get(), texture, DirectX::XMMatrixScaling(extent, 1.0f, extent)));
+    for (std::uint32_t i = 0; i < object_count; ++i) {
+        const float x = origin + static_cast<float>(i % side) * kSpacing;
+        const float z = origin + static_cast<float>(i / side) * kSpacing;
+        RenderObject obj = MakeObject(cube.get(), texture, DirectX::XMMatrixTranslation(x, 1.0f, z));
+        const float shade = static_cast<float>(i % 7) / 6.0f;
+        obj.albedo = {0.3f + 0.7f * shade, 0.4f, 1.0f - 0.7f * shade, 1.0f};
+        obj.dynamic = i % kDynamicStride == 0;
+        objects.push_back(obj);
+    }
+    for (std::uint32_t i = 0; i < kWallCount; ++i) {
+        const float x = -0.5f * extent + (static_cast<float>(i) + 0.5f) * extent / kWallCount;
+        const DirectX::XMMATRIX world = DirectX::XMMatrixScaling(extent / (2.0f * kWallCount), 4.0f, 0.5f) *
+                                        DirectX::XMMatrixTranslation(x, 4.0f, origin + 0.25f * extent);
+        objects.push_back(MakeObject(wall.get(), texture, world));
+    }
+
+    Camera camera;
+    camera.position = {0.0f, 12.0f, origin - 12.0f};
+    camera.target = {0.0f, 0.0f, 0.0f};
+    device.SetCamera(camera);
+
+    RenderingSystem rendering;
+    if (!rendering.Initialize(&device, kWidth, kHeight)) {
+        return -1;
+    }
+    rendering.SetDirectionalLight(DirectionalLight{});
+    std::vector<PointLight> point_lights(RenderingSystem::kMaxPointLights);
+    for (std::uint32_t i = 0; i < point_lights.size(); ++i) {
+        point_lights[i].position = {origin + static_cast<float>(i) * extent / RenderingSystem::kMaxPointLights, 2.0f,
+                                    0.0f};
+    }
+    rendering.SetPointLights(point_lights);
+    rendering.SetSpotLights(std::vector<SpotLight>(2));
+    rendering.PrewarmPipelines(objects);
+    if (!rendering.FinishPipelineStartup()) {
+        return -1;
+    }
+
+    // The first frames build the scene BVH and fill the pipeline of frames in flight, so they are not timed.
+    const std::uint32_t warmup = device.GetFramesInFlight();
+    FrameTimes times;
+    std::uint64_t commands = 0;
+    std::uint64_t draws = 0;
+    std::uint64_t bytes = 0;
+    for (std::uint32_t frame = 0; frame < warmup + frames; ++frame) {
+        const float time = static_cast<float>(frame) / 60.0f;
+        for (std::uint32_t i = 0; i < object_count; i += kDynamicStride) {
+            RenderObject &obj = objects[1 + i];
+            obj.world._42 = 1.0f + std::sin(time + static_cast<float>(i));
+        }
+        if (frame + 1 == warmup + frames && !capture_path.empty()) {
+            device.CaptureNextFrame(capture_path);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        device.BeginFrame();
+        rendering.Render(objects, time);
+        device.EndFrame();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (frame < warmup) {
+            continue;
+        }
+        times.Add(ms);
+        const CommandStream &stream = device.GetSubmittedCommands();
+        commands += stream.CommandCount();
+        draws += stream.DrawCount();
+        bytes += stream.SizeBytes();
+    }
+
+    const RenderingSystem::FrustumCullStats cull = rendering.GetFrustumCullStats();
+    const double count = static_cast<double>(times.count);
+    std::wcout << L"Rendered " << times.count << L" frames of " << objects.size() << L" objects at " << kWidth << L"x"
+               << kHeight << L": " << times.total_ms / count << L" ms/frame CPU (min " << times.min_ms << L", max "
+               << times.max_ms << L"), " << static_cast<double>(commands) / count << L" commands and "
+               << static_cast<double>(draws) / count << L" draws per frame ("
+               << static_cast<double>(bytes) / (count * 1024.0) << L" KB), last frame drew " << cull.visible << L" of "
+               << cull.objects << L" objects with " << cull.occluded << L" occluded" << std::endl;
+    device.LogMemoryStats();
+
+    rendering.Shutdown();
+    device.ReleaseMeshBuffers(*cube);
+    device.ReleaseMeshBuffers(*wall);
+    device.ReleaseMeshBuffers(*plane);
+    device.ReleaseTexture(texture);
+    device.Shutdown();
+    return draws > 0 ? 0 : -1;
+}
@@ -1,83 +1,146 @@
 #include "RenderingSystem.h"
+#include "framework/ParallelFor.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
 #include <cstring>
-#include <vector>
-#include <d3dcompiler.h>
 #include <iostream>
-
-#include "framework/FrameworkInternal.h"
+#include <numeric>
+#include <tuple>
+#include <vector>
 
 namespace gfw {
 namespace {
-constexpr UINT kCbAlign = 256;
-UINT AlignCb(UINT size) {
-    return (size + (kCbAlign - 1u)) & ~(kCbAlign - 1u);
+// PermutationKey::pass of each pipeline; only the GBuffer pass has feature bits.
+constexpr std::uint32_t kGeometryPass = 0;
+constexpr std::uint32_t kLightingPass = 1;
+constexpr std::uint32_t kGBufferDebugPass = 2;
+
+// Bits a GBuffer draw keeps when its own permutation is still compiling: the vertex layout must match the
+// mesh, and dropping the alpha test would draw cut-out texels.
+constexpr std::uint32_t kGeometryFallbackFeatures =
+    kGeometryAlphaTest | kGeometryQuantizedVertex | kGeometryVertexTangents;
+
+// GBuffer rasterizer culling. Scene meshes include two-sided geometry, so both windings are drawn; meshlet
+// normal cones may only drop clusters the rasterizer would drop too.
+constexpr CullMode kGeometryCullMode = CullMode::None;
+constexpr bool kMeshletConeCulling = kGeometryCullMode == CullMode::Back;
+
+// VertexFormat::Float32, optionally followed by a float4 tangent.
+constexpr std::array<InputElement, 4> kFloatInputLayout = {
+    InputElement{"POSITION", Format::R32G32B32Float, 0},
+    InputElement{"NORMAL", Format::R32G32B32Float, 12},
+    InputElement{"TEXCOORD", Format::R32G32Float, 24},
+    InputElement{"TANGENT", Format::R32G32B32A32Float, 32},
+};
+
+// VertexFormat::Quantized (see VertexQuantizer.h), optionally followed by an octahedral tangent.
+constexpr std::array<InputElement, 4> kQuantizedInputLayout = {
+    InputElement{"POSITION", Format::R16G16B16A16Unorm, 0},
+    InputElement{"NORMAL", Format::R16G16Snorm, 8},
+    InputElement{"TEXCOORD", Format::R16G16Float, 12},
+    InputElement{"TANGENT", Format::R16G16Snorm, 16},
+};
+
+static_assert(std::tuple_size_v<decltype(StageDefines::names)> <= ShaderStage::kMaxDefines);
+
+void SetGeometryInputLayout(std::uint32_t features, PipelineDesc &desc) {
+    const auto &elements = (features & kGeometryQuantizedVertex) ? kQuantizedInputLayout : kFloatInputLayout;
+    desc.input_count = (features & kGeometryVertexTangents) ? 4u : 3u;
+    std::copy_n(elements.begin(), desc.input_count, desc.input_layout.begin());
 }
+
+// The permutation of a GBuffer stage selected by features.
+ShaderStage GeometryShader(const char *file, const char *entry, const char *fallback_profile, std::uint32_t features,
+                           GeometryStage stage) {
+    const StageDefines defines = GeometryStageDefines(features, stage);
+    ShaderStage shader = {file, entry, fallback_profile};
+    std::copy_n(defines.names.begin(), defines.count, shader.defines.begin());
+    shader.define_count = defines.count;
+    return shader;
 }
 
-bool RenderingSystem::Initialize(Framework *framework, UINT width, UINT height) {
-    framework_ = framework;
-    if (!framework_ || !framework_->GetDevice()) {
-        return false;
+// World bounds of an object for the scene BVH; empty (min > max) when its mesh has none.
+SceneBvh::Bounds ObjectBounds(const RenderObject &obj, float margin) {
+    if (!obj.mesh || obj.mesh->bounds_radius <= 0.0f) {
+        return {{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
     }
-    std::cout << "Initializing GBuffer..." << std::endl;
-    if (!gbuffer_.Initialize(framework_->GetDevice(), width, height)) {
-        return false;
-    }
-    std::cout << "Creating geometry pipeline..." << std::endl;
-    if (!CreateGeometryPipeline()) {
-        return false;
-    }
-    std::cout << "Creating geometry tess pipeline..." << std::endl;
-    if (!CreateGeometryTessPipeline()) {
+    return SceneBvh::WorldBounds(obj.mesh->bounds_min, obj.mesh->bounds_max, obj.world, margin);
+}
+}
+
+bool RenderingSystem::Initialize(RenderDevice *device, std::uint32_t width, std::uint32_t height) {
+    device_ = device;
+    if (!device_ || !device_->IsInitialized()) {
         return false;
     }
-    std::cout << "Creating lighting pipeline..." << std::endl;
-    if (!CreateLightingPipeline()) {
+    std::cout << "Initializing GBuffer..." << std::endl;
+    if (!gbuffer_.Initialize(*device_, width, height)) {
         return false;
     }
-    std::cout << "Creating GBuffer debug pipeline..." << std::endl;
-    if (!CreateGBufferDebugPipeline()) {
+    std::cout << "Creating root signatures..." << std::endl;
+    if (!CreateRootSignatures()) {
         return false;
     }
-    std::cout << "Creating constant buffers..." << std::endl;
-    if (!CreateConstantBuffers()) {
+    // Workers beyond a handful rarely pay for their thread start-up at this scene size.
+    if (!recorder_.Initialize(*device_, std::min(DefaultWorkerCount(), kMaxRecordingWorkers),
+                              device_->GetFramesInFlight())) {
         return false;
     }
-    fallback_white_ = framework_->CreateSolidTexture({1.0f, 1.0f, 1.0f, 1.0f});
+
+    // Shader lookup and driver compilation overlap scene loading. The first frame needs the lighting pipeline
+    // and the plain GBuffer one (every draw can fall back to it); the debug view and wireframe variants are
+    // created in the background the first time they are asked for.
+    pipelines_.Start(std::clamp(DefaultWorkerCount() / 2, 1u, kMaxPipelineThreads),
+                     [this](const PermutationKey &key) { return CreatePipeline(key); });
+    pipelines_.Request({kLightingPass, 0}, PipelineStates::Priority::Startup);
+    pipelines_.Request({kGeometryPass, 0}, PipelineStates::Priority::Startup);
+    std::cout << "Compiling pipelines on " << pipelines_.ThreadCount() << " threads..." << std::endl;
     std::cout << "RenderingSystem initialized successfully." << std::endl;
     return true;
 }
 
 void RenderingSystem::Shutdown() {
-    if (geometry_cb_) {
-        geometry_cb_->Unmap(0, nullptr);
-    }
-    if (lighting_cb_) {
-        lighting_cb_->Unmap(0, nullptr);
-    }
-    if (gbuffer_debug_cb_) {
-        gbuffer_debug_cb_->Unmap(0, nullptr);
-    }
-    geometry_cb_mapped_ = nullptr;
-    lighting_cb_mapped_ = nullptr;
-    gbuffer_debug_cb_mapped_ = nullptr;
-    geometry_cb_.Reset();
-    lighting_cb_.Reset();
-    gbuffer_debug_cb_.Reset();
-    geometry_pso_.Reset();
-    geometry_pso_wireframe_.Reset();
+    // Workers read the root signatures, so they stop first.
+    pipelines_.Stop();
+    pipelines_.Clear();
     geometry_root_sig_.Reset();
-    geometry_tess_pso_.Reset();
-    geometry_tess_pso_wireframe_.Reset();
-    lighting_pso_.Reset();
     lighting_root_sig_.Reset();
-    gbuffer_debug_pso_.Reset();
     gbuffer_debug_root_sig_.Reset();
+    recorder_.Shutdown();
     gbuffer_.Shutdown();
-    fallback_white_.reset();
-    framework_ = nullptr;
+    device_ = nullptr;
+}
+
+void RenderingSystem::PrewarmPipelines(const std::vector<RenderObject> &objects) {
+    for (const RenderObject &obj : objects) {
+        if (!obj.mesh) {
+            continue;
+        }
+        // With its maps resident, and while they still stream in.
+        const std::uint32_t resident = GeometryFeatures(obj, obj.normal_texture != nullptr,
+                                                        obj.displacement_texture != nullptr);
+        const std::uint32_t streaming = GeometryFeatures(obj, false, false);
+        for (const std::uint32_t features : {resident, streaming, streaming & kGeometryFallbackFeatures}) {
+            pipelines_.Request({kGeometryPass, features}, PipelineStates::Priority::Startup);
+        }
+    }
+}
+
+bool RenderingSystem::FinishPipelineStartup() {
+    const auto start = std::chrono::steady_clock::now();
+    const bool ready = pipelines_.WaitForStartup();
+    const double waited_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const PipelineStates::Stats stats = pipelines_.GetStats();
+    std::cout << "Pipelines: " << stats.ready << " ready, " << stats.pending << " pending, " << stats.failed
+              << " failed; " << stats.create_ms << " ms of creation on " << pipelines_.ThreadCount()
+              << " threads, render thread waited " << waited_ms << " ms" << std::endl;
+    if (!ready) {
+        std::cerr << "Failed to create the pipelines needed for the first frame." << std::endl;
+    }
+    return ready;
 }
 
 void RenderingSystem::SetDirectionalLight(const DirectionalLight &light) {
@@ -99,715 +162,449 @@ void RenderingSystem::SetSpotLights(const std::vector<SpotLight> &lights) {
 }
 
 void RenderingSystem::Render(const std::vector<RenderObject> &objects, float) {
-    if (!framework_ || !framework_->GetCommandList()) {
+    if (!device_ || !device_->IsInitialized()) {
         return;
     }
     GeometryPass(objects);
 
-    if (gbuffer_debug_mode_ != GBufferDebugMode::None) {
-        GBufferDebugPass();
+    // Until the debug pipeline has compiled the lit image stays on screen.
+    const auto *debug_pso =
+        gbuffer_debug_mode_ != GBufferDebugMode::None ? pipelines_.Acquire({kGBufferDebugPass, 0}) : nullptr;
+    if (debug_pso) {
+        GBufferDebugPass(debug_pso->Get());
     } else {
         LightingPass();
     }
 }
 
-bool RenderingSystem::CreateGeometryPipeline() {
-    ID3D12Device *device = framework_->GetDevice();
-    UINT flags = 0;
-#ifdef _DEBUG
-    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-    Microsoft::WRL::ComPtr<ID3DBlob> vs_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> ps_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> error_blob;
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferVertex.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_0",
-                                  flags, 0, &vs_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
-    }
-    error_blob.Reset();
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferPixel.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_0",
-                                  flags, 0, &ps_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
-    }
-
-    // One table per texture (t0, t1). A single table with NumDescriptors=2 requires adjacent heap
-    // slots; textures are allocated non-contiguously, so t1 would sample the wrong resource.
-    D3D12_DESCRIPTOR_RANGE albedo_range = {};
-    albedo_range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    albedo_range.NumDescriptors = 1;
-    albedo_range.BaseShaderRegister = 0;
-    albedo_range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-    D3D12_DESCRIPTOR_RANGE normal_range = {};
-    normal_range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    normal_range.NumDescriptors = 1;
-    normal_range.BaseShaderRegister = 1;
-    normal_range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    D3D12_ROOT_PARAMETER root_params[3] = {};
-    root_params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-    root_params[0].Descriptor.ShaderRegister = 0;
-    root_params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    root_params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[1].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[1].DescriptorTable.pDescriptorRanges = &albedo_range;
-    root_params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    root_params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[2].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[2].DescriptorTable.pDescriptorRanges = &normal_range;
-    root_params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-    D3D12_STATIC_SAMPLER_DESC sampler = {};
-    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-    sampler.MaxLOD = D3D12_FLOAT32_MAX;
-    sampler.ShaderRegister = 0;
-    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-    D3D12_ROOT_SIGNATURE_DESC rs_desc = {};
-    rs_desc.NumParameters = 3;
-    rs_desc.pParameters = root_params;
-    rs_desc.NumStaticSamplers = 1;
-    rs_desc.pStaticSamplers = &sampler;
-    rs_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-    Microsoft::WRL::ComPtr<ID3DBlob> signature_blob;
-    if (FAILED(D3D12SerializeRootSignature(&rs_desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature_blob, &error_blob))) {
-        return false;
-    }
-    if (FAILED(device->CreateRootSignature(0, signature_blob->GetBufferPointer(), signature_blob->GetBufferSize(),
-                                           IID_PPV_ARGS(&geometry_root_sig_)))) {
-        return false;
-    }
-
-    const std::array<D3D12_INPUT_ELEMENT_DESC, 3> input_layout = {
-        D3D12_INPUT_ELEMENT_DESC{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        D3D12_INPUT_ELEMENT_DESC{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        D3D12_INPUT_ELEMENT_DESC{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-    };
-
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso = {};
-    pso.pRootSignature = geometry_root_sig_.Get();
-    pso.VS = {vs_blob->GetBufferPointer(), vs_blob->GetBufferSize()};
-    pso.PS = {ps_blob->GetBufferPointer(), ps_blob->GetBufferSize()};
-    pso.InputLayout = {input_layout.data(), static_cast<UINT>(input_layout.size())};
-    pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-    pso.SampleMask = UINT_MAX;
-    pso.SampleDesc.Count = 1;
-    pso.NumRenderTargets = GBuffer::kTargetCount;
-    pso.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    pso.RTVFormats[1] = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    pso.RTVFormats[2] = DXGI_FORMAT_R8G8B8A8_UNORM;
-    pso.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-
-    D3D12_RASTERIZER_DESC rasterizer = {};
-    rasterizer.FillMode = D3D12_FILL_MODE_SOLID;
-    rasterizer.CullMode = D3D12_CULL_MODE_NONE;
-    rasterizer.FrontCounterClockwise = FALSE;
-    rasterizer.DepthClipEnable = TRUE;
-    rasterizer.MultisampleEnable = FALSE;
-    rasterizer.AntialiasedLineEnable = FALSE;
-    rasterizer.ForcedSampleCount = 0;
-    rasterizer.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-    pso.RasterizerState = rasterizer;
-
-    D3D12_BLEND_DESC blend = {};
-    blend.AlphaToCoverageEnable = FALSE;
-    blend.IndependentBlendEnable = FALSE;
-    D3D12_RENDER_TARGET_BLEND_DESC rt_blend = {};
-    rt_blend.BlendEnable = FALSE;
-    rt_blend.LogicOpEnable = FALSE;
-    rt_blend.SrcBlend = D3D12_BLEND_ONE;
-    rt_blend.DestBlend = D3D12_BLEND_ZERO;
-    rt_blend.BlendOp = D3D12_BLEND_OP_ADD;
-    rt_blend.SrcBlendAlpha = D3D12_BLEND_ONE;
-    rt_blend.DestBlendAlpha = D3D12_BLEND_ZERO;
-    rt_blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
-    rt_blend.LogicOp = D3D12_LOGIC_OP_NOOP;
-    rt_blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
-    for (UINT i = 0; i < 8; ++i) {
-        blend.RenderTarget[i] = rt_blend;
-    }
-    pso.BlendState = blend;
-
-    D3D12_DEPTH_STENCIL_DESC depth = {};
-    depth.DepthEnable = TRUE;
-    depth.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-    depth.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-    depth.StencilEnable = FALSE;
-    pso.DepthStencilState = depth;
-
-    std::cout << "Creating solid pipeline state..." << std::endl;
-    if (!SUCCEEDED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&geometry_pso_)))) {
-        std::cerr << "Failed to create solid pipeline state." << std::endl;
-        return false;
-    }
-
-    // Create wireframe version
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_wireframe = pso;
-    pso_wireframe.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
-    std::cout << "Creating wireframe pipeline state..." << std::endl;
-    if (!SUCCEEDED(device->CreateGraphicsPipelineState(&pso_wireframe, IID_PPV_ARGS(&geometry_pso_wireframe_)))) {
-        std::cerr << "Failed to create wireframe pipeline state." << std::endl;
-        return false;
-    }
-
-    return true;
+bool RenderingSystem::CreateRootSignatures() {
+    // One bindless table for every material texture, bound once per pass: an unbounded Texture2D[] at t0,
+    // space1 over the device's SRV heap that GeometryCB::texture_indices indexes. Needs shader model 5.1.
+    RootSignatureDesc geometry = {};
+    geometry.visibility = ShaderVisibility::All;
+    geometry.table_size = RootSignatureDesc::kUnboundedTable;
+    geometry.table_space = 1;
+    geometry.sampler_address = SamplerAddress::Wrap;
+    geometry_root_sig_ = RootSignatureObject(device_, device_->CreateRootSignature(geometry));
+
+    // The three GBuffer targets at t0-t2.
+    RootSignatureDesc fullscreen = {};
+    fullscreen.visibility = ShaderVisibility::Pixel;
+    fullscreen.table_size = GBuffer::kTargetCount;
+    fullscreen.sampler_address = SamplerAddress::Clamp;
+    lighting_root_sig_ = RootSignatureObject(device_, device_->CreateRootSignature(fullscreen));
+    gbuffer_debug_root_sig_ = RootSignatureObject(device_, device_->CreateRootSignature(fullscreen));
+    return geometry_root_sig_ && lighting_root_sig_ && gbuffer_debug_root_sig_;
 }
 
-bool RenderingSystem::CreateGeometryTessPipeline() {
-    ID3D12Device *device = framework_->GetDevice();
-    UINT flags = 0;
-#ifdef _DEBUG
-    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    Microsoft::WRL::ComPtr<ID3DBlob> vs_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> hs_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> ds_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> ps_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> error_blob;
-
-    std::cout << "Compiling vertex shader..." << std::endl;
-    // Compile vertex shader
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferVertex.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_0",
-                                  flags, 0, &vs_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
+PipelineObject RenderingSystem::CreatePipeline(const PermutationKey &key) const {
+    switch (key.pass) {
+        case kGeometryPass:
+            return CreateGeometryPipeline(key.features);
+        case kLightingPass:
+            return CreateFullscreenPipeline("DeferredLighting.hlsl", lighting_root_sig_.Get());
+        case kGBufferDebugPass:
+            return CreateFullscreenPipeline("GBufferDebug.hlsl", gbuffer_debug_root_sig_.Get());
+        default:
+            return {};
     }
-    error_blob.Reset();
+}
 
-    std::cout << "Compiling hull shader..." << std::endl;
-    // Compile hull shader
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferTessHull.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "HSMain", "hs_5_0",
-                                  flags, 0, &hs_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
+PipelineHandle RenderingSystem::AcquireGeometryPipeline(std::uint32_t &features) {
+    for (const std::uint32_t candidate : {features, features & kGeometryFallbackFeatures}) {
+        if (const auto *pipeline = pipelines_.Acquire({kGeometryPass, candidate})) {
+            features = candidate;
+            return pipeline->Get();
+        }
     }
-    error_blob.Reset();
+    return {};
+}
 
-    std::cout << "Compiling domain shader..." << std::endl;
-    // Compile domain shader
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferTessDomain.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "DSMain", "ds_5_0",
-                                  flags, 0, &ds_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
-    }
-    error_blob.Reset();
+PipelineObject RenderingSystem::CreateGeometryPipeline(std::uint32_t features) const {
+    const bool tessellated = (features & kGeometryTessellation) != 0;
+    PipelineDesc desc = {};
+    desc.root_signature = geometry_root_sig_.Get();
+    desc.vs = GeometryShader("GBufferVertex.hlsl", "VSMain", "vs_5_1", features, GeometryStage::Vertex);
+    desc.ps = GeometryShader("GBufferPixel.hlsl", "PSMain", "ps_5_1", features, GeometryStage::Pixel);
+    if (tessellated) {
+        desc.hs = GeometryShader("GBufferTessHull.hlsl", "HSMain", "hs_5_1", features, GeometryStage::Hull);
+        desc.ds = GeometryShader("GBufferTessDomain.hlsl", "DSMain", "ds_5_1", features, GeometryStage::Domain);
+    }
+    SetGeometryInputLayout(features, desc);
+    desc.primitive = tessellated ? PrimitiveType::Patch : PrimitiveType::Triangle;
+    desc.rtv_count = GBuffer::kTargetCount;
+    std::copy(GBuffer::kFormats.begin(), GBuffer::kFormats.end(), desc.rtv_formats.begin());
+    desc.dsv_format = Format::D32Float;
+    desc.wireframe = (features & kGeometryWireframe) != 0;
+    desc.cull = kGeometryCullMode;
+
+    PipelineObject pipeline(device_, device_->CreatePipeline(desc));
+    if (!pipeline) {
+        std::cerr << "Failed to create geometry pipeline state for features 0x" << std::hex << features << std::dec
+                  << "." << std::endl;
+        return {};
+    }
+    std::cout << "Created geometry pipeline permutation 0x" << std::hex << features << std::dec << std::endl;
+    return pipeline;
+}
 
-    std::cout << "Compiling pixel shader..." << std::endl;
-    // Compile pixel shader
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferPixel.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_0",
-                                  flags, 0, &ps_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
-    }
+PipelineObject RenderingSystem::CreateFullscreenPipeline(const char *file, RootSignatureHandle root_signature) const {
+    PipelineDesc desc = {};
+    desc.root_signature = root_signature;
+    desc.vs = {file, "VSMain", "vs_5_0"};
+    desc.ps = {file, "PSMain", "ps_5_0"};
+    desc.rtv_count = 1;
+    desc.rtv_formats[0] = Format::R8G8B8A8Unorm;
 
-    std::cout << "Shaders compiled successfully." << std::endl;
-
-    // Texture2D SRVs must use descriptor tables; root SRV slots only support buffer SRVs.
-    D3D12_DESCRIPTOR_RANGE srv_range_t0 = {};
-    srv_range_t0.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    srv_range_t0.NumDescriptors = 1;
-    srv_range_t0.BaseShaderRegister = 0;
-    srv_range_t0.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-    D3D12_DESCRIPTOR_RANGE srv_range_t1 = {};
-    srv_range_t1.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    srv_range_t1.NumDescriptors = 1;
-    srv_range_t1.BaseShaderRegister = 1;
-    srv_range_t1.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-    D3D12_DESCRIPTOR_RANGE srv_range_t2 = {};
-    srv_range_t2.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    srv_range_t2.NumDescriptors = 1;
-    srv_range_t2.BaseShaderRegister = 2;
-    srv_range_t2.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    D3D12_ROOT_PARAMETER root_params[4] = {};
-    root_params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-    root_params[0].Descriptor.ShaderRegister = 0;
-    root_params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    root_params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[1].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[1].DescriptorTable.pDescriptorRanges = &srv_range_t0;
-    root_params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    root_params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[2].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[2].DescriptorTable.pDescriptorRanges = &srv_range_t1;
-    root_params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    root_params[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[3].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[3].DescriptorTable.pDescriptorRanges = &srv_range_t2;
-    root_params[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-    D3D12_STATIC_SAMPLER_DESC sampler = {};
-    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-    sampler.MaxLOD = D3D12_FLOAT32_MAX;
-    sampler.ShaderRegister = 0;
-    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-    D3D12_ROOT_SIGNATURE_DESC rs_desc = {};
-    rs_desc.NumParameters = 4;
-    rs_desc.pParameters = root_params;
-    rs_desc.NumStaticSamplers = 1;
-    rs_desc.pStaticSamplers = &sampler;
-    rs_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-    std::cout << "Creating root signature..." << std::endl;
-    Microsoft::WRL::ComPtr<ID3DBlob> signature_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> rs_error_blob;
-    if (FAILED(D3D12SerializeRootSignature(&rs_desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature_blob, &rs_error_blob))) {
-        if (rs_error_blob) std::cerr << static_cast<const char *>(rs_error_blob->GetBufferPointer()) << std::endl;
-        return false;
-    }
-    if (FAILED(device->CreateRootSignature(0, signature_blob->GetBufferPointer(), signature_blob->GetBufferSize(),
-                                           IID_PPV_ARGS(&geometry_tess_root_sig_)))) {
-        std::cerr << "Failed to create root signature." << std::endl;
-        return false;
+    PipelineObject pipeline(device_, device_->CreatePipeline(desc));
+    if (!pipeline) {
+        std::cerr << "Failed to create pipeline state for " << file << "." << std::endl;
     }
+    return pipeline;
+}
 
-    std::cout << "Root signature created successfully." << std::endl;
-
-    const std::array<D3D12_INPUT_ELEMENT_DESC, 3> input_layout = {
-        D3D12_INPUT_ELEMENT_DESC{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        D3D12_INPUT_ELEMENT_DESC{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        D3D12_INPUT_ELEMENT_DESC{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-    };
+void RenderingSystem::GeometryPass(const std::vector<RenderObject> &objects) {
+    // Stays valid across InsertCommandLists, which moves it on to the next segment.
+    CommandRecorder &cmd = device_->GetRecorder();
+    const auto &scene = device_->GetSceneState();
 
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso = {};
-    pso.pRootSignature = geometry_tess_root_sig_.Get();
-    pso.VS = {vs_blob->GetBufferPointer(), vs_blob->GetBufferSize()};
-    pso.HS = {hs_blob->GetBufferPointer(), hs_blob->GetBufferSize()};
-    pso.DS = {ds_blob->GetBufferPointer(), ds_blob->GetBufferSize()};
-    pso.PS = {ps_blob->GetBufferPointer(), ps_blob->GetBufferSize()};
-    pso.InputLayout = {input_layout.data(), static_cast<UINT>(input_layout.size())};
-    pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH;
-    pso.SampleMask = UINT_MAX;
-    pso.SampleDesc.Count = 1;
-    pso.NumRenderTargets = GBuffer::kTargetCount;
-    pso.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    pso.RTVFormats[1] = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    pso.RTVFormats[2] = DXGI_FORMAT_R8G8B8A8_UNORM;
-    pso.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-
-    D3D12_RASTERIZER_DESC rasterizer = {};
-    rasterizer.FillMode = D3D12_FILL_MODE_SOLID;
-    rasterizer.CullMode = D3D12_CULL_MODE_NONE;
-    rasterizer.FrontCounterClockwise = FALSE;
-    rasterizer.DepthClipEnable = TRUE;
-    rasterizer.MultisampleEnable = FALSE;
-    rasterizer.AntialiasedLineEnable = FALSE;
-    rasterizer.ForcedSampleCount = 0;
-    rasterizer.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-    pso.RasterizerState = rasterizer;
-
-    D3D12_BLEND_DESC blend = {};
-    blend.AlphaToCoverageEnable = FALSE;
-    blend.IndependentBlendEnable = FALSE;
-    D3D12_RENDER_TARGET_BLEND_DESC rt_blend = {};
-    rt_blend.BlendEnable = FALSE;
-    rt_blend.LogicOpEnable = FALSE;
-    rt_blend.SrcBlend = D3D12_BLEND_ONE;
-    rt_blend.DestBlend = D3D12_BLEND_ZERO;
-    rt_blend.BlendOp = D3D12_BLEND_OP_ADD;
-    rt_blend.SrcBlendAlpha = D3D12_BLEND_ONE;
-    rt_blend.DestBlendAlpha = D3D12_BLEND_ZERO;
-    rt_blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
-    rt_blend.LogicOp = D3D12_LOGIC_OP_NOOP;
-    rt_blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
-    for (UINT i = 0; i < 8; ++i) {
-        blend.RenderTarget[i] = rt_blend;
-    }
-    pso.BlendState = blend;
-
-    D3D12_DEPTH_STENCIL_DESC depth = {};
-    depth.DepthEnable = TRUE;
-    depth.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-    depth.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-    depth.StencilEnable = FALSE;
-    pso.DepthStencilState = depth;
-
-    std::cout << "Creating solid pipeline state..." << std::endl;
-    if (!SUCCEEDED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&geometry_tess_pso_)))) {
-        std::cerr << "Failed to create solid pipeline state." << std::endl;
-        return false;
-    }
+    gbuffer_.TransitionToRenderTargets(cmd);
+    BindGeometryTargets(cmd);
+    gbuffer_.Clear(cmd);
+    cmd.ClearDepth(device_->GetDepthDsv(), 1.0f);
+
+    const Viewport viewport = device_->GetViewport();
+    const float aspect = viewport.width / viewport.height;
+    GeometryView geometry_view = {};
+    geometry_view.view = scene.camera.ViewMatrix();
+    geometry_view.proj = scene.projection.Matrix(aspect);
+    geometry_view.view_proj = geometry_view.view * geometry_view.proj;
+    geometry_view.pixels_per_unit = viewport.height /
+                                    (2.0f * std::tan(DirectX::XMConvertToRadians(scene.projection.fov_y_degrees) * 0.5f));
+
+    CullObjects(objects, geometry_view.view_proj, aspect);
+
+    // Constants and residency go through the device's single-threaded upload ring and streaming timeline,
+    // so they are resolved here; workers only record.
+    geometry_draws_.clear();
+    const std::uint32_t fallback_index = device_->GetBindlessIndex(nullptr);
+    for (const std::uint32_t index : visible_objects_) {
+        const RenderObject &obj = objects[index];
+        if (!obj.mesh || !device_->UseMesh(*obj.mesh)) {
+            continue;
+        }
 
-    // Create wireframe version
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_wireframe = pso;
-    pso_wireframe.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
-    std::cout << "Creating wireframe pipeline state..." << std::endl;
-    if (!SUCCEEDED(device->CreateGraphicsPipelineState(&pso_wireframe, IID_PPV_ARGS(&geometry_tess_pso_wireframe_)))) {
-        std::cerr << "Failed to create wireframe pipeline state." << std::endl;
-        return false;
+        GeometryCB cb = {};
+        DirectX::XMStoreFloat4x4(&cb.world, DirectX::XMLoadFloat4x4(&obj.world));
+        DirectX::XMStoreFloat4x4(&cb.view, geometry_view.view);
+        DirectX::XMStoreFloat4x4(&cb.proj, geometry_view.proj);
+        cb.albedo = obj.albedo;
+        cb.tess_params = {tessellation_min_, tessellation_max_, tessellation_near_dist_, tessellation_far_dist_};
+        cb.camera_pos = {scene.camera.position.x, scene.camera.position.y, scene.camera.position.z, 0.0f};
+        cb.quant_offset = {obj.mesh->quant_offset.x, obj.mesh->quant_offset.y, obj.mesh->quant_offset.z, 0.0f};
+        cb.quant_scale = {obj.mesh->quant_scale.x, obj.mesh->quant_scale.y, obj.mesh->quant_scale.z, 0.0f};
+        cb.texture_indices = {device_->GetBindlessIndex(obj.texture.get()),
+                              device_->GetBindlessIndex(obj.normal_texture.get()),
+                              device_->GetBindlessIndex(obj.displacement_texture.get()), 0};
+        // Each draw gets its own slice so it reads its own constants, not the last object's.
+        const GpuAddress cb_address = device_->UploadConstants(cb);
+        // Maps that are missing or still streaming resolve to the fallback texture and compile out.
+        std::uint32_t features = GeometryFeatures(obj, cb.texture_indices.y != fallback_index,
+                                                  cb.texture_indices.z != fallback_index);
+        const PipelineHandle pso = AcquireGeometryPipeline(features);
+        if (!cb_address || !pso) {
+            continue;
+        }
+        geometry_draws_.push_back({&obj, pso, cb_address, features});
     }
 
-    return true;
-}
-
-bool RenderingSystem::CreateLightingPipeline() {
-    ID3D12Device *device = framework_->GetDevice();
-    UINT flags = 0;
-#ifdef _DEBUG
-    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    Microsoft::WRL::ComPtr<ID3DBlob> vs_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> ps_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> error_blob;
-    if (FAILED(D3DCompileFromFile(L"shaders/DeferredLighting.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_0",
-                                  flags, 0, &vs_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
+    const size_t draw_count = geometry_draws_.size();
+    std::uint32_t list_count = 1;
+    if (parallel_recording_enabled_) {
+        const size_t wanted = (draw_count + kMinDrawsPerList - 1) / kMinDrawsPerList;
+        list_count = static_cast<std::uint32_t>(std::min<size_t>(wanted, recorder_.WorkerCount()));
     }
-    error_blob.Reset();
-    if (FAILED(D3DCompileFromFile(L"shaders/DeferredLighting.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_0",
-                                  flags, 0, &ps_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
+    if (worker_ranges_.size() < std::max(1u, list_count)) {
+        worker_ranges_.resize(std::max(1u, list_count));
     }
 
-    D3D12_DESCRIPTOR_RANGE srv_range = {};
-    srv_range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    srv_range.NumDescriptors = 3;
-    srv_range.BaseShaderRegister = 0;
-    srv_range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    D3D12_ROOT_PARAMETER root_params[2] = {};
-    root_params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-    root_params[0].Descriptor.ShaderRegister = 0;
-    root_params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-    root_params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[1].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[1].DescriptorTable.pDescriptorRanges = &srv_range;
-    root_params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-
-    D3D12_STATIC_SAMPLER_DESC sampler = {};
-    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-    sampler.MaxLOD = D3D12_FLOAT32_MAX;
-    sampler.ShaderRegister = 0;
-    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-
-    D3D12_ROOT_SIGNATURE_DESC rs_desc = {};
-    rs_desc.NumParameters = 2;
-    rs_desc.pParameters = root_params;
-    rs_desc.NumStaticSamplers = 1;
-    rs_desc.pStaticSamplers = &sampler;
-    rs_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-    Microsoft::WRL::ComPtr<ID3DBlob> signature_blob;
-    if (FAILED(D3D12SerializeRootSignature(&rs_desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature_blob, &error_blob))) {
-        return false;
-    }
-    if (FAILED(device->CreateRootSignature(0, signature_blob->GetBufferPointer(), signature_blob->GetBufferSize(),
-                                           IID_PPV_ARGS(&lighting_root_sig_)))) {
-        return false;
+    // A frame capture needs the worker lists' commands too; D3D12 lists only keep them on request.
+    recorder_.SetCapture(device_->IsCapturing());
+    if (list_count <= 1 || !recorder_.Begin(device_->GetFrameSlot(), list_count)) {
+        BindGeometryState(cmd);
+        RecordGeometryDraws(cmd, 0, draw_count, geometry_view, worker_ranges_[0]);
+    } else {
+        // Contiguous chunks keep the serial draw order once the lists execute back to back.
+        const size_t chunk = (draw_count + list_count - 1) / list_count;
+        recorder_.Record([&](size_t i) {
+            CommandRecorder &list = recorder_.GetRecorder(static_cast<std::uint32_t>(i));
+            BindGeometryTargets(list);
+            BindGeometryState(list);
+            const size_t begin = std::min(draw_count, i * chunk);
+            RecordGeometryDraws(list, begin, std::min(draw_count, begin + chunk), geometry_view, worker_ranges_[i]);
+        });
+        recorded_lists_.clear();
+        recorder_.Close(recorded_lists_);
+        device_->InsertCommandLists(recorded_lists_);
     }
-
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso = {};
-    pso.pRootSignature = lighting_root_sig_.Get();
-    pso.VS = {vs_blob->GetBufferPointer(), vs_blob->GetBufferSize()};
-    pso.PS = {ps_blob->GetBufferPointer(), ps_blob->GetBufferSize()};
-    pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-    pso.SampleMask = UINT_MAX;
-    pso.SampleDesc.Count = 1;
-    pso.NumRenderTargets = 1;
-    pso.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-    D3D12_RASTERIZER_DESC rasterizer = {};
-    rasterizer.FillMode = D3D12_FILL_MODE_SOLID;
-    rasterizer.CullMode = D3D12_CULL_MODE_NONE;
-    rasterizer.FrontCounterClockwise = FALSE;
-    rasterizer.DepthClipEnable = TRUE;
-    pso.RasterizerState = rasterizer;
-
-    D3D12_BLEND_DESC blend = {};
-    blend.AlphaToCoverageEnable = FALSE;
-    blend.IndependentBlendEnable = FALSE;
-    D3D12_RENDER_TARGET_BLEND_DESC rt_blend = {};
-    rt_blend.BlendEnable = FALSE;
-    rt_blend.LogicOpEnable = FALSE;
-    rt_blend.SrcBlend = D3D12_BLEND_ONE;
-    rt_blend.DestBlend = D3D12_BLEND_ZERO;
-    rt_blend.BlendOp = D3D12_BLEND_OP_ADD;
-    rt_blend.SrcBlendAlpha = D3D12_BLEND_ONE;
-    rt_blend.DestBlendAlpha = D3D12_BLEND_ZERO;
-    rt_blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
-    rt_blend.LogicOp = D3D12_LOGIC_OP_NOOP;
-    rt_blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
-    blend.RenderTarget[0] = rt_blend;
-    pso.BlendState = blend;
-
-    D3D12_DEPTH_STENCIL_DESC depth = {};
-    depth.DepthEnable = FALSE;
-    depth.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
-    depth.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-    depth.StencilEnable = FALSE;
-    pso.DepthStencilState = depth;
-
-    return SUCCEEDED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&lighting_pso_)));
+    gbuffer_.TransitionToShaderResources(cmd);
 }
 
-bool RenderingSystem::CreateGBufferDebugPipeline() {
-    ID3D12Device *device = framework_->GetDevice();
-    UINT flags = 0;
-#ifdef _DEBUG
-    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    Microsoft::WRL::ComPtr<ID3DBlob> vs_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> ps_blob;
-    Microsoft::WRL::ComPtr<ID3DBlob> error_blob;
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferDebug.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_0",
-                                  flags, 0, &vs_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
-    }
-    error_blob.Reset();
-    if (FAILED(D3DCompileFromFile(L"shaders/GBufferDebug.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_0",
-                                  flags, 0, &ps_blob, &error_blob))) {
-        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-        return false;
+void RenderingSystem::CullObjects(const std::vector<RenderObject> &objects, const DirectX::XMMATRIX &view_proj,
+                                  float aspect) {
+    if (!frustum_culling_enabled_) {
+        visible_objects_.resize(objects.size());
+        std::iota(visible_objects_.begin(), visible_objects_.end(), 0u);
+        frustum_cull_stats_ = {objects.size(), objects.size()};
+        return;
     }
 
-    D3D12_DESCRIPTOR_RANGE srv_range = {};
-    srv_range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    srv_range.NumDescriptors = 3;
-    srv_range.BaseShaderRegister = 0;
-    srv_range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    D3D12_ROOT_PARAMETER root_params[2] = {};
-    root_params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-    root_params[0].Descriptor.ShaderRegister = 0;
-    root_params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-    root_params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    root_params[1].DescriptorTable.NumDescriptorRanges = 1;
-    root_params[1].DescriptorTable.pDescriptorRanges = &srv_range;
-    root_params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-
-    D3D12_STATIC_SAMPLER_DESC sampler = {};
-    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-    sampler.MaxLOD = D3D12_FLOAT32_MAX;
-    sampler.ShaderRegister = 0;
-    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-
-    D3D12_ROOT_SIGNATURE_DESC rs_desc = {};
-    rs_desc.NumParameters = 2;
-    rs_desc.pParameters = root_params;
-    rs_desc.NumStaticSamplers = 1;
-    rs_desc.pStaticSamplers = &sampler;
-    rs_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-    Microsoft::WRL::ComPtr<ID3DBlob> signature_blob;
-    if (FAILED(D3D12SerializeRootSignature(&rs_desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature_blob, &error_blob))) {
-        return false;
-    }
-    if (FAILED(device->CreateRootSignature(0, signature_blob->GetBufferPointer(), signature_blob->GetBufferSize(),
-                                           IID_PPV_ARGS(&gbuffer_debug_root_sig_)))) {
-        return false;
+    // Displacement moves tessellated surfaces off the mesh by up to this much, in object space.
+    const float margin = tessellation_enabled_ ? displacement_scale_ + normal_displacement_scale_ : 0.0f;
+    DirectX::XMFLOAT4X4 frustum_matrix;
+    DirectX::XMStoreFloat4x4(&frustum_matrix, view_proj);
+    const FrustumCuller::Frustum frustum = FrustumCuller::ExtractFrustum(frustum_matrix);
+
+    if (scene_bvh_enabled_) {
+        UpdateSceneBvh(objects, margin);
+        visible_objects_.clear();
+        scene_bvh_.QueryFrustum(frustum, visible_objects_);
+        visible_objects_.insert(visible_objects_.end(), unbounded_objects_.begin(), unbounded_objects_.end());
+        for (const std::uint32_t index : dynamic_objects_) {
+            if (SceneBvh::IsEmpty(scene_bounds_[index])) {
+                visible_objects_.push_back(index);
+            }
+        }
+        // Tree order jumps around the scene; object order keeps the draws, and captures, as without the tree.
+        std::sort(visible_objects_.begin(), visible_objects_.end());
+    } else {
+        frustum_culler_.Resize(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i) {
+            const MeshBuffers *mesh = objects[i].mesh;
+            if (!mesh || mesh->bounds_radius <= 0.0f) {
+                frustum_culler_.SetUnbounded(i);
+                continue;
+            }
+            frustum_culler_.SetBounds(i, mesh->bounds_min, mesh->bounds_max, mesh->bounds_radius, objects[i].world,
+                                      margin);
+        }
+        frustum_culler_.Cull(frustum, visible_objects_);
     }
+    frustum_cull_stats_ = {objects.size(), visible_objects_.size()};
 
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso = {};
-    pso.pRootSignature = gbuffer_debug_root_sig_.Get();
-    pso.VS = {vs_blob->GetBufferPointer(), vs_blob->GetBufferSize()};
-    pso.PS = {ps_blob->GetBufferPointer(), ps_blob->GetBufferSize()};
-    pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-    pso.SampleMask = UINT_MAX;
-    pso.SampleDesc.Count = 1;
-    pso.NumRenderTargets = 1;
-    pso.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-
-    D3D12_RASTERIZER_DESC rasterizer = {};
-    rasterizer.FillMode = D3D12_FILL_MODE_SOLID;
-    rasterizer.CullMode = D3D12_CULL_MODE_NONE;
-    rasterizer.FrontCounterClockwise = FALSE;
-    rasterizer.DepthClipEnable = TRUE;
-    rasterizer.MultisampleEnable = FALSE;
-    rasterizer.AntialiasedLineEnable = FALSE;
-    rasterizer.ForcedSampleCount = 0;
-    rasterizer.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-    pso.RasterizerState = rasterizer;
-
-    D3D12_BLEND_DESC blend = {};
-    blend.AlphaToCoverageEnable = FALSE;
-    blend.IndependentBlendEnable = FALSE;
-    D3D12_RENDER_TARGET_BLEND_DESC rt_blend = {};
-    rt_blend.BlendEnable = FALSE;
-    rt_blend.LogicOpEnable = FALSE;
-    rt_blend.SrcBlend = D3D12_BLEND_ONE;
-    rt_blend.DestBlend = D3D12_BLEND_ZERO;
-    rt_blend.BlendOp = D3D12_BLEND_OP_ADD;
-    rt_blend.SrcBlendAlpha = D3D12_BLEND_ONE;
-    rt_blend.DestBlendAlpha = D3D12_BLEND_ZERO;
-    rt_blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
-    rt_blend.LogicOp = D3D12_LOGIC_OP_NOOP;
-    rt_blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
-    blend.RenderTarget[0] = rt_blend;
-    pso.BlendState = blend;
-
-    D3D12_DEPTH_STENCIL_DESC depth = {};
-    depth.DepthEnable = FALSE;
-    depth.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
-    depth.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-    depth.StencilEnable = FALSE;
-    pso.DepthStencilState = depth;
-
-    return SUCCEEDED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&gbuffer_debug_pso_)));
+    if (occlusion_culling_enabled_) {
+        OccludeObjects(objects, view_proj, aspect, margin);
+    }
 }
 
-bool RenderingSystem::CreateConstantBuffers() {
-    const D3D12_HEAP_PROPERTIES heap = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-
-    const UINT geometry_size = AlignCb(sizeof(GeometryCB));
-    D3D12_RESOURCE_DESC g_desc = detail::BufferDesc(geometry_size);
-    if (FAILED(framework_->GetDevice()->CreateCommittedResource(
-            &heap, D3D12_HEAP_FLAG_NONE, &g_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&geometry_cb_)))) {
-        return false;
+void RenderingSystem::OccludeObjects(const std::vector<RenderObject> &objects, const DirectX::XMMATRIX &view_proj,
+                                     float aspect, float margin) {
+    DirectX::XMFLOAT4X4 occlusion_matrix;
+    DirectX::XMStoreFloat4x4(&occlusion_matrix, view_proj);
+    occlusion_culler_.BeginFrame(occlusion_matrix);
+    for (const std::uint32_t index : visible_objects_) {
+        const RenderObject &obj = objects[index];
+        // Alpha-tested materials have holes the occluder mesh does not.
+        if (obj.mesh && obj.mesh->occluder && (obj.material_features & kGeometryAlphaTest) == 0) {
+            occlusion_culler_.AddOccluder(*obj.mesh->occluder, obj.world);
+        }
     }
-    void *g_mapped = nullptr;
-    if (FAILED(geometry_cb_->Map(0, nullptr, &g_mapped))) {
-        return false;
+    if (!occlusion_culler_.HasOccluders()) {
+        return;
     }
-    geometry_cb_mapped_ = static_cast<std::uint8_t *>(g_mapped);
 
-    const UINT lighting_size = AlignCb(sizeof(LightingCB));
-    D3D12_RESOURCE_DESC l_desc = detail::BufferDesc(lighting_size);
-    if (FAILED(framework_->GetDevice()->CreateCommittedResource(
-            &heap, D3D12_HEAP_FLAG_NONE, &l_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&lighting_cb_)))) {
-        return false;
-    }
-    void *l_mapped = nullptr;
-    if (FAILED(lighting_cb_->Map(0, nullptr, &l_mapped))) {
-        return false;
-    }
-    lighting_cb_mapped_ = static_cast<std::uint8_t *>(l_mapped);
+    occlusion_culler_.Resize(kOcclusionWidth,
+                             static_cast<std::uint32_t>(static_cast<float>(kOcclusionWidth) / std::max(aspect, 0.1f)));
+    occlusion_culler_.Rasterize(DefaultWorkerCount());
 
-    const UINT gbuffer_debug_size = AlignCb(sizeof(GBufferDebugCB));
-    D3D12_RESOURCE_DESC gb_desc = detail::BufferDesc(gbuffer_debug_size);
-    if (FAILED(framework_->GetDevice()->CreateCommittedResource(
-            &heap, D3D12_HEAP_FLAG_NONE, &gb_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&gbuffer_debug_cb_)))) {
-        return false;
-    }
-    void *gb_mapped = nullptr;
-    if (FAILED(gbuffer_debug_cb_->Map(0, nullptr, &gb_mapped))) {
-        return false;
+    // Occluders test against their own depth too; their nearest corner is in front of their own surface.
+    occlusion_bounds_.resize(visible_objects_.size());
+    for (size_t i = 0; i < visible_objects_.size(); ++i) {
+        occlusion_bounds_[i] = ObjectBounds(objects[visible_objects_[i]], margin);
     }
-    gbuffer_debug_cb_mapped_ = static_cast<std::uint8_t *>(gb_mapped);
-
-    return true;
+    const size_t occluded = occlusion_culler_.Cull(occlusion_bounds_, visible_objects_, DefaultWorkerCount());
+    frustum_cull_stats_.visible = visible_objects_.size();
+    frustum_cull_stats_.occluded = occluded;
 }
 
-void RenderingSystem::GeometryPass(const std::vector<RenderObject> &objects) {
-    ID3D12GraphicsCommandList *cmd = framework_->GetCommandList();
-    const auto &scene = framework_->GetSceneState();
-
-    gbuffer_.TransitionToRenderTargets(cmd);
-    const std::array<D3D12_CPU_DESCRIPTOR_HANDLE, GBuffer::kTargetCount> rtvs = {
-        gbuffer_.GetRtv(0), gbuffer_.GetRtv(1), gbuffer_.GetRtv(2)
-    };
-    const D3D12_CPU_DESCRIPTOR_HANDLE dsv = framework_->GetDepthDsvHandle();
-    cmd->OMSetRenderTargets(static_cast<UINT>(rtvs.size()), rtvs.data(), FALSE, &dsv);
-    gbuffer_.Clear(cmd);
-    cmd->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-
-    // Choose pipeline based on tessellation setting
-    if (tessellation_enabled_) {
-        cmd->SetGraphicsRootSignature(geometry_tess_root_sig_.Get());
-        if (render_mode_ == RenderMode::Wireframe) {
-            cmd->SetPipelineState(geometry_tess_pso_wireframe_.Get());
-        } else {
-            cmd->SetPipelineState(geometry_tess_pso_.Get());
+void RenderingSystem::UpdateSceneBvh(const std::vector<RenderObject> &objects, float margin) {
+    if (scene_bvh_valid_ && scene_bvh_.ObjectCount() == objects.size()) {
+        // A new displacement margin moves every object's bounds, but not the objects, so the tree shape holds.
+        if (scene_bvh_margin_ != margin) {
+            for (std::uint32_t i = 0; i < objects.size(); ++i) {
+                scene_bounds_[i] = ObjectBounds(objects[i], margin);
+                scene_bvh_.Update(i, scene_bounds_[i]);
+            }
+            scene_bvh_margin_ = margin;
         }
-    } else {
-        cmd->SetGraphicsRootSignature(geometry_root_sig_.Get());
-        if (render_mode_ == RenderMode::Wireframe) {
-            cmd->SetPipelineState(geometry_pso_wireframe_.Get());
-        } else {
-            cmd->SetPipelineState(geometry_pso_.Get());
+        for (const std::uint32_t index : dynamic_objects_) {
+            scene_bounds_[index] = ObjectBounds(objects[index], margin);
+            scene_bvh_.Update(index, scene_bounds_[index]);
         }
+        scene_bvh_.Refit();
+        return;
     }
 
-    ID3D12DescriptorHeap *heaps[] = {framework_->GetSrvHeap()};
-    cmd->SetDescriptorHeaps(1, heaps);
-
-    const float aspect = framework_->GetViewport().Width / framework_->GetViewport().Height;
-    const DirectX::XMMATRIX view = scene.camera.ViewMatrix();
-    const DirectX::XMMATRIX proj = scene.projection.Matrix(aspect);
-
-    for (const RenderObject &obj : objects) {
-        if (!obj.mesh) {
-            continue;
+    const auto start = std::chrono::steady_clock::now();
+    scene_bounds_.resize(objects.size());
+    dynamic_objects_.clear();
+    unbounded_objects_.clear();
+    for (std::uint32_t i = 0; i < objects.size(); ++i) {
+        scene_bounds_[i] = ObjectBounds(objects[i], margin);
+        if (objects[i].dynamic) {
+            dynamic_objects_.push_back(i);
+        } else if (SceneBvh::IsEmpty(scene_bounds_[i])) {
+            unbounded_objects_.push_back(i);
         }
+    }
+    scene_bvh_.Build(scene_bounds_);
+    scene_bvh_valid_ = true;
+    scene_bvh_margin_ = margin;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Built scene BVH: " << objects.size() << " objects (" << dynamic_objects_.size() << " dynamic), "
+              << scene_bvh_.NodeCount() << " nodes in " << ms << " ms" << std::endl;
+}
 
-        GeometryCB cb = {};
-        DirectX::XMStoreFloat4x4(&cb.world, DirectX::XMLoadFloat4x4(&obj.world));
-        DirectX::XMStoreFloat4x4(&cb.view, view);
-        DirectX::XMStoreFloat4x4(&cb.proj, proj);
-        cb.albedo = obj.albedo;
-        cb.tess_params = {tessellation_min_, tessellation_max_, tessellation_near_dist_, tessellation_far_dist_};
-        cb.camera_pos = {scene.camera.position.x, scene.camera.position.y, scene.camera.position.z, 0.0f};
-        std::memcpy(geometry_cb_mapped_, &cb, sizeof(cb));
-
-        cmd->SetGraphicsRootConstantBufferView(0, geometry_cb_->GetGPUVirtualAddress());
+void RenderingSystem::BindGeometryTargets(CommandRecorder &cmd) const {
+    const std::array<CpuDescriptor, GBuffer::kTargetCount> rtvs = {
+        gbuffer_.GetRtv(0), gbuffer_.GetRtv(1), gbuffer_.GetRtv(2)
+    };
+    cmd.SetRenderTargets(rtvs.data(), static_cast<std::uint32_t>(rtvs.size()), device_->GetDepthDsv());
+    cmd.SetViewport(device_->GetViewport());
+    cmd.SetScissor(device_->GetScissorRect());
+}
 
-        // Bind textures based on pipeline type
-        D3D12_GPU_DESCRIPTOR_HANDLE base_srv = (obj.texture ? obj.texture : fallback_white_)->srv_gpu;
+void RenderingSystem::BindGeometryState(CommandRecorder &cmd) const {
+    // Every permutation shares one root signature, so draws with different features can follow each other.
+    cmd.SetRootSignature(geometry_root_sig_.Get());
+    cmd.SetDescriptorHeap(device_->GetBindlessHeap());
+    cmd.SetDescriptorTable(1, device_->GetBindlessTable());
+}
 
-        if (tessellation_enabled_) {
-            // For tessellation pipeline: bind base color, normal, and displacement textures
-            D3D12_GPU_DESCRIPTOR_HANDLE normal_srv = (obj.normal_texture ? obj.normal_texture : fallback_white_)->srv_gpu;
-            D3D12_GPU_DESCRIPTOR_HANDLE displacement_srv = (obj.displacement_texture ? obj.displacement_texture : fallback_white_)->srv_gpu;
-            cmd->SetGraphicsRootDescriptorTable(1, base_srv);
-            cmd->SetGraphicsRootDescriptorTable(2, normal_srv);
-            cmd->SetGraphicsRootDescriptorTable(3, displacement_srv);
-        } else {
-            D3D12_GPU_DESCRIPTOR_HANDLE normal_srv = (obj.normal_texture ? obj.normal_texture : fallback_white_)->srv_gpu;
-            cmd->SetGraphicsRootDescriptorTable(1, base_srv);
-            cmd->SetGraphicsRootDescriptorTable(2, normal_srv);
+void RenderingSystem::RecordGeometryDraws(CommandRecorder &cmd, size_t begin, size_t end,
+                                          const GeometryView &geometry_view,
+                                          std::vector<MeshletDrawRange> &visible_ranges) const {
+    const auto &scene = device_->GetSceneState();
+    PipelineHandle bound_pso;
+    for (size_t i = begin; i < end; ++i) {
+        const GeometryDraw &draw = geometry_draws_[i];
+        const RenderObject &obj = *draw.object;
+        if (draw.pso != bound_pso) {
+            cmd.SetPipeline(draw.pso);
+            bound_pso = draw.pso;
         }
+        cmd.SetConstantBuffer(0, draw.constants);
 
-        // Set primitive topology based on tessellation state
-        D3D_PRIMITIVE_TOPOLOGY topo = obj.mesh->topology;
-        if (tessellation_enabled_) {
+        // Set primitive topology based on the permutation
+        const bool tessellated = (draw.features & kGeometryTessellation) != 0;
+        PrimitiveTopology topo = obj.mesh->topology;
+        if (tessellated) {
             // Use 3-control-point patch list for triangle tessellation
-            topo = D3D_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST;
+            topo = PrimitiveTopology::PatchList3;
         }
-        cmd->IASetPrimitiveTopology(topo);
-        cmd->IASetVertexBuffers(0, 1, &obj.mesh->vertex_buffer_view);
-
-        if (obj.mesh->index_buffer) {
-            cmd->IASetIndexBuffer(&obj.mesh->index_buffer_view);
-            cmd->DrawIndexedInstanced(obj.mesh->index_count, 1, 0, 0, 0);
+        cmd.SetTopology(topo);
+        cmd.SetVertexBuffer(obj.mesh->vertex_buffer_view);
+
+        const size_t lod = SelectLod(obj, geometry_view.pixels_per_unit);
+        if (obj.mesh->index_buffer && lod > 0) {
+            const MeshLod &range = obj.mesh->lods[lod];
+            cmd.SetIndexBuffer(obj.mesh->index_buffer_view);
+            cmd.DrawIndexed(range.index_count, range.index_offset, 0);
+        } else if (obj.mesh->index_buffer && cluster_culling_enabled_ && !tessellated && !obj.mesh->meshlets.empty()) {
+            const MeshletCullView cull_view = Meshlets::MakeCullView(DirectX::XMLoadFloat4x4(&obj.world),
+                                                                     geometry_view.view_proj, scene.camera.position);
+            visible_ranges.clear();
+            Meshlets::Cull(obj.mesh->meshlets, cull_view, kMeshletConeCulling, visible_ranges);
+            if (visible_ranges.empty()) {
+                continue;
+            }
+            cmd.SetIndexBuffer(obj.mesh->index_buffer_view);
+            for (const MeshletDrawRange &range : visible_ranges) {
+                cmd.DrawIndexed(range.index_count, range.index_offset, 0);
+            }
+        } else if (obj.mesh->index_buffer) {
+            cmd.SetIndexBuffer(obj.mesh->index_buffer_view);
+            cmd.DrawIndexed(obj.mesh->index_count, 0, 0);
         } else {
-            cmd->DrawInstanced(obj.mesh->vertex_count, 1, 0, 0);
+            cmd.Draw(obj.mesh->vertex_count, 0);
         }
     }
-    gbuffer_.TransitionToShaderResources(cmd);
+}
+
+std::uint32_t RenderingSystem::GeometryFeatures(const RenderObject &obj, bool normal_map, bool displacement) const {
+    std::uint32_t features = obj.material_features;
+    if (obj.normal_texture && normal_map) {
+        features |= kGeometryNormalMap;
+    }
+    if (obj.displacement_texture && displacement) {
+        features |= kGeometryDisplacement;
+    }
+    // Tessellation only pays off when the domain shader has a map to displace with.
+    if (tessellation_enabled_ && (features & (kGeometryNormalMap | kGeometryDisplacement | kGeometryTessellation))) {
+        features |= kGeometryTessellation;
+    } else {
+        features &= ~kGeometryTessellation;
+    }
+    if (render_mode_ == RenderMode::Wireframe) {
+        features |= kGeometryWireframe;
+    }
+    if (obj.mesh->vertex_format == VertexFormat::Quantized) {
+        features |= kGeometryQuantizedVertex;
+    }
+    if (obj.mesh->has_tangents) {
+        features |= kGeometryVertexTangents;
+    }
+    return NormalizeGeometryFeatures(features);
+}
+
+size_t RenderingSystem::SelectLod(const RenderObject &obj, float pixels_per_unit_at_unit_distance) const {
+    const MeshBuffers &mesh = *obj.mesh;
+    if (!lod_selection_enabled_ || mesh.lods.size() < 2) {
+        return 0;
+    }
+    const auto &scene = device_->GetSceneState();
+    const DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&obj.world);
+
+    // Bounding sphere of the mesh in world space; the largest axis scale keeps it conservative.
+    const DirectX::XMVECTOR bounds_min = DirectX::XMLoadFloat3(&mesh.bounds_min);
+    const DirectX::XMVECTOR bounds_max = DirectX::XMLoadFloat3(&mesh.bounds_max);
+    const DirectX::XMVECTOR center = DirectX::XMVector3TransformCoord(
+            DirectX::XMVectorScale(DirectX::XMVectorAdd(bounds_min, bounds_max), 0.5f), world);
+    const float scale = std::max({DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[0])),
+                                  DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[1])),
+                                  DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[2]))});
+    const float radius = 0.5f * scale * DirectX::XMVectorGetX(
+            DirectX::XMVector3Length(DirectX::XMVectorSubtract(bounds_max, bounds_min)));
+    const float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(
+            DirectX::XMVectorSubtract(center, DirectX::XMLoadFloat3(&scene.camera.position)))) - radius;
+    if (distance <= scene.projection.near_z) {
+        return 0;
+    }
+
+    const float pixels_per_unit = pixels_per_unit_at_unit_distance / distance;
+    size_t selected = 0;
+    for (size_t i = 1; i < mesh.lods.size(); ++i) {
+        if (mesh.lods[i].error * scale * pixels_per_unit > lod_pixel_error_) {
+            break;
+        }
+        selected = i;
+    }
+    return selected;
 }
 
 void RenderingSystem::LightingPass() {
-    ID3D12GraphicsCommandList *cmd = framework_->GetCommandList();
-    const auto &scene = framework_->GetSceneState();
+    CommandRecorder &cmd = device_->GetRecorder();
+    const auto *lighting_pso = pipelines_.Acquire({kLightingPass, 0});
+    if (!lighting_pso) {
+        return;
+    }
+    const auto &scene = device_->GetSceneState();
     const DirectX::XMMATRIX view = scene.camera.ViewMatrix();
 
-    D3D12_CPU_DESCRIPTOR_HANDLE back_rtv = framework_->GetCurrentBackBufferRtv();
-    cmd->OMSetRenderTargets(1, &back_rtv, FALSE, nullptr);
+    const CpuDescriptor back_rtv = device_->GetBackBufferRtv();
+    cmd.SetRenderTargets(&back_rtv, 1, {});
     const float clear_color[4] = {0.02f, 0.02f, 0.03f, 1.0f};
-    cmd->ClearRenderTargetView(back_rtv, clear_color, 0, nullptr);
+    cmd.ClearRenderTarget(back_rtv, clear_color);
 
     LightingCB cb = {};
 
@@ -829,11 +626,11 @@ void RenderingSystem::LightingPass() {
     cb.dir_light_dir = {dir_view_f3.x, dir_view_f3.y, dir_view_f3.z, 0.0f};
     cb.dir_light_color_intensity = {directional_light_.color.x, directional_light_.color.y, directional_light_.color.z, 1.0f};
     cb.ambient_color = directional_light_.ambient;
-    cb.point_count = static_cast<UINT>(point_lights_.size());
-    cb.spot_count = static_cast<UINT>(spot_lights_.size());
+    cb.point_count = static_cast<std::uint32_t>(point_lights_.size());
+    cb.spot_count = static_cast<std::uint32_t>(spot_lights_.size());
 
     // Transform point light positions from world-space to view-space
-    for (UINT i = 0; i < cb.point_count; ++i) {
+    for (std::uint32_t i = 0; i < cb.point_count; ++i) {
         const DirectX::XMVECTOR point_world = DirectX::XMVectorSet(
             point_lights_[i].position.x,
             point_lights_[i].position.y,
@@ -847,7 +644,7 @@ void RenderingSystem::LightingPass() {
     }
 
     // Transform spot light positions and directions from world-space to view-space
-    for (UINT i = 0; i < cb.spot_count; ++i) {
+    for (std::uint32_t i = 0; i < cb.spot_count; ++i) {
         const DirectX::XMVECTOR spot_pos_world = DirectX::XMVectorSet(
             spot_lights_[i].position.x,
             spot_lights_[i].position.y,
@@ -869,40 +666,44 @@ void RenderingSystem::LightingPass() {
         cb.spot_lights[i].dir_angle_cos = {spot_dir_view_f3.x, spot_dir_view_f3.y, spot_dir_view_f3.z, spot_lights_[i].angle_cos};
         cb.spot_lights[i].color_intensity = {spot_lights_[i].color.x, spot_lights_[i].color.y, spot_lights_[i].color.z, spot_lights_[i].intensity};
     }
-    std::memcpy(lighting_cb_mapped_, &cb, sizeof(cb));
+    const GpuAddress cb_address = device_->UploadConstants(cb);
+    if (!cb_address) {
+        return;
+    }
 
-    cmd->SetGraphicsRootSignature(lighting_root_sig_.Get());
-    cmd->SetPipelineState(lighting_pso_.Get());
-    ID3D12DescriptorHeap *heaps[] = {gbuffer_.GetSrvHeap()};
-    cmd->SetDescriptorHeaps(1, heaps);
-    cmd->SetGraphicsRootConstantBufferView(0, lighting_cb_->GetGPUVirtualAddress());
-    cmd->SetGraphicsRootDescriptorTable(1, gbuffer_.GetSrv(0));
-    cmd->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    cmd->DrawInstanced(3, 1, 0, 0);
+    cmd.SetRootSignature(lighting_root_sig_.Get());
+    cmd.SetPipeline(lighting_pso->Get());
+    cmd.SetDescriptorHeap(gbuffer_.GetSrvHeap());
+    cmd.SetConstantBuffer(0, cb_address);
+    cmd.SetDescriptorTable(1, gbuffer_.GetSrv(0));
+    cmd.SetTopology(PrimitiveTopology::TriangleList);
+    cmd.Draw(3, 0);
 }
 
-void RenderingSystem::GBufferDebugPass() {
-    ID3D12GraphicsCommandList *cmd = framework_->GetCommandList();
+void RenderingSystem::GBufferDebugPass(PipelineHandle pso) {
+    CommandRecorder &cmd = device_->GetRecorder();
 
-    D3D12_CPU_DESCRIPTOR_HANDLE back_rtv = framework_->GetCurrentBackBufferRtv();
-    cmd->OMSetRenderTargets(1, &back_rtv, FALSE, nullptr);
+    const CpuDescriptor back_rtv = device_->GetBackBufferRtv();
+    cmd.SetRenderTargets(&back_rtv, 1, {});
     const float clear_color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
-    cmd->ClearRenderTargetView(back_rtv, clear_color, 0, nullptr);
+    cmd.ClearRenderTarget(back_rtv, clear_color);
 
     GBufferDebugCB cb = {};
-    cb.mode = static_cast<INT>(gbuffer_debug_mode_);
-    std::memcpy(gbuffer_debug_cb_mapped_, &cb, sizeof(cb));
-
-    cmd->SetGraphicsRootSignature(gbuffer_debug_root_sig_.Get());
-    cmd->SetPipelineState(gbuffer_debug_pso_.Get());
-    ID3D12DescriptorHeap *heaps[] = {gbuffer_.GetSrvHeap()};
-    cmd->SetDescriptorHeaps(1, heaps);
-    cmd->SetGraphicsRootConstantBufferView(0, gbuffer_debug_cb_->GetGPUVirtualAddress());
+    cb.mode = static_cast<std::int32_t>(gbuffer_debug_mode_);
+    const GpuAddress cb_address = device_->UploadConstants(cb);
+    if (!cb_address) {
+        return;
+    }
+
+    cmd.SetRootSignature(gbuffer_debug_root_sig_.Get());
+    cmd.SetPipeline(pso);
+    cmd.SetDescriptorHeap(gbuffer_.GetSrvHeap());
+    cmd.SetConstantBuffer(0, cb_address);
     // Pass all three GBuffer textures (Position, Normal, Albedo) at once
     // The descriptor table starts at index 0 which contains all three SRVs
-    cmd->SetGraphicsRootDescriptorTable(1, gbuffer_.GetSrv(0));
-    cmd->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    cmd->DrawInstanced(3, 1, 0, 0);
+    cmd.SetDescriptorTable(1, gbuffer_.GetSrv(0));
+    cmd.SetTopology(PrimitiveTopology::TriangleList);
+    cmd.Draw(3, 0);
 }
 
 void PushLightsToRenderingSystem(const LightControlState &state, RenderingSystem &rendering) {
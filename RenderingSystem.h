@@ -1,18 +1,33 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <vector>
 
+#include "FrustumCuller.h"
 #include "GBuffer.h"
+#include "GeometryPermutations.h"
+#include "Meshlets.h"
+#include "OcclusionCuller.h"
+#include "SceneBvh.h"
 #include "SceneLighting.h"
-#include "framework/Framework.h"
+#include "framework/ParallelCommandRecorder.h"
+#include "framework/PipelineCompiler.h"
+#include "framework/RenderDevice.h"
 
 namespace gfw {
 
 class RenderingSystem {
 public:
-    static constexpr UINT kMaxPointLights = 16;
-    static constexpr UINT kMaxSpotLights = 8;
+    static constexpr std::uint32_t kMaxPointLights = 16;
+    static constexpr std::uint32_t kMaxSpotLights = 8;
+    // GBuffer recording is split across worker command lists once each list gets at least this many draws.
+    static constexpr size_t kMinDrawsPerList = 64;
+    static constexpr unsigned kMaxRecordingWorkers = 8;
+    // Pipeline creation shares the cores with asset loading at startup, so it gets at most half of them.
+    static constexpr unsigned kMaxPipelineThreads = 4;
+    // Width of the occlusion depth buffer; its height follows the viewport's aspect ratio.
+    static constexpr std::uint32_t kOcclusionWidth = 256;
 
     // GBuffer visualization modes
     enum class GBufferDebugMode {
@@ -29,9 +44,17 @@ public:
         Wireframe = 1
     };
 
-    bool Initialize(Framework *framework, UINT width, UINT height);
+    // Creates root signatures and starts compiling the core pipelines on background threads, so it should run
+    // before the scene loads; PrewarmPipelines and FinishPipelineStartup complete the startup before frame one.
+    // Everything is created through device, which must outlive the RenderingSystem or its Shutdown.
+    bool Initialize(RenderDevice *device, std::uint32_t width, std::uint32_t height);
     void Shutdown();
 
+    // Queues the GBuffer permutations the objects will draw with as startup work.
+    void PrewarmPipelines(const std::vector<RenderObject> &objects);
+    // Blocks until the startup pipelines exist and logs the compile statistics; false if any failed.
+    bool FinishPipelineStartup();
+
     void SetDirectionalLight(const DirectionalLight &light);
     void SetPointLights(const std::vector<PointLight> &lights);
     void SetSpotLights(const std::vector<SpotLight> &lights);
@@ -53,6 +76,16 @@ public:
     }
     bool IsTessellationEnabled() const { return tessellation_enabled_; }
 
+    // Meshlet culling; only applies to the non-tessellated path since displacement moves geometry
+    // outside the precomputed bounds.
+    void SetClusterCullingEnabled(bool enabled) { cluster_culling_enabled_ = enabled; }
+    bool IsClusterCullingEnabled() const { return cluster_culling_enabled_; }
+
+    // LOD selection picks the coarsest level whose error projects to at most pixel_error pixels.
+    void SetLodSelectionEnabled(bool enabled) { lod_selection_enabled_ = enabled; }
+    bool IsLodSelectionEnabled() const { return lod_selection_enabled_; }
+    void SetLodPixelError(float pixel_error) { lod_pixel_error_ = pixel_error; }
+
     // GBuffer visualization
     void SetGBufferDebugMode(GBufferDebugMode mode) { gbuffer_debug_mode_ = mode; }
     GBufferDebugMode GetGBufferDebugMode() const { return gbuffer_debug_mode_; }
@@ -62,6 +95,38 @@ public:
     RenderMode GetRenderMode() const { return render_mode_; }
     void ToggleRenderMode() { render_mode_ = (render_mode_ == RenderMode::Solid) ? RenderMode::Wireframe : RenderMode::Solid; }
 
+    // Object frustum culling ahead of the geometry pass; see FrustumCuller.
+    void SetFrustumCullingEnabled(bool enabled) { frustum_culling_enabled_ = enabled; }
+    bool IsFrustumCullingEnabled() const { return frustum_culling_enabled_; }
+
+    // Objects considered by the last geometry pass, how many of them it drew and how many of those inside the
+    // frustum it skipped as occluded.
+    struct FrustumCullStats {
+        size_t objects = 0;
+        size_t visible = 0;
+        size_t occluded = 0;
+    };
+    [[nodiscard]] FrustumCullStats GetFrustumCullStats() const { return frustum_cull_stats_; }
+
+    // Frustum culling through a BVH over the objects' world bounds instead of testing every object. The tree is
+    // rebuilt when the number of objects changes; call InvalidateSceneBvh after other edits to the list or to a
+    // static object. Indices are into the objects last passed to Render, and GetSceneBvh also serves sphere and
+    // ray queries against them.
+    void SetSceneBvhEnabled(bool enabled) { scene_bvh_enabled_ = enabled; }
+    bool IsSceneBvhEnabled() const { return scene_bvh_enabled_; }
+    void InvalidateSceneBvh() { scene_bvh_valid_ = false; }
+    [[nodiscard]] const SceneBvh &GetSceneBvh() const { return scene_bvh_; }
+
+    // Skips objects in the frustum hidden behind the occluder meshes (MeshBuffers::occluder) of other objects in
+    // it; see OcclusionCuller. Only applies while frustum culling is enabled.
+    void SetOcclusionCullingEnabled(bool enabled) { occlusion_culling_enabled_ = enabled; }
+    bool IsOcclusionCullingEnabled() const { return occlusion_culling_enabled_; }
+    [[nodiscard]] const OcclusionCuller::Stats &GetOcclusionStats() const { return occlusion_culler_.GetStats(); }
+
+    // Multi-threaded GBuffer command recording
+    void SetParallelRecordingEnabled(bool enabled) { parallel_recording_enabled_ = enabled; }
+    bool IsParallelRecordingEnabled() const { return parallel_recording_enabled_; }
+
 private:
     struct GeometryCB {
         DirectX::XMFLOAT4X4 world = {};
@@ -70,6 +135,25 @@ private:
         DirectX::XMFLOAT4 albedo = {1.0f, 1.0f, 1.0f, 1.0f};
         DirectX::XMFLOAT4 tess_params = {1.0f, 16.0f, 0.0f, 0.0f};
         DirectX::XMFLOAT4 camera_pos = {};
+        DirectX::XMFLOAT4 quant_offset = {0.0f, 0.0f, 0.0f, 0.0f};
+        DirectX::XMFLOAT4 quant_scale = {1.0f, 1.0f, 1.0f, 0.0f};
+        // Bindless table indices: x base color, y normal map, z displacement.
+        DirectX::XMUINT4 texture_indices = {};
+    };
+
+    // A visible object with its constants already uploaded; recorded by whichever worker owns its range.
+    struct GeometryDraw {
+        const RenderObject *object = nullptr;
+        PipelineHandle pso;
+        GpuAddress constants = 0;
+        std::uint32_t features = 0; // GeometryFeature bits the pipeline was built for
+    };
+
+    struct GeometryView {
+        DirectX::XMMATRIX view;
+        DirectX::XMMATRIX proj;
+        DirectX::XMMATRIX view_proj;
+        float pixels_per_unit = 0.0f;
     };
 
     struct PointLightGpu {
@@ -89,47 +173,55 @@ private:
         DirectX::XMFLOAT4 ambient_color = {};
         std::array<PointLightGpu, kMaxPointLights> point_lights = {};
         std::array<SpotLightGpu, kMaxSpotLights> spot_lights = {};
-        UINT point_count = 0;
-        UINT spot_count = 0;
+        std::uint32_t point_count = 0;
+        std::uint32_t spot_count = 0;
         DirectX::XMFLOAT2 _pad = {};
     };
 
-    bool CreateGeometryPipeline();
-    bool CreateGeometryTessPipeline();
-    bool CreateLightingPipeline();
-    bool CreateGBufferDebugPipeline();
-    bool CreateConstantBuffers();
+    using PipelineStates = PipelineCompiler<PipelineObject>;
+
+    bool CreateRootSignatures();
+    // Runs on the compiler threads; only reads the root signatures and settings fixed at Initialize.
+    PipelineObject CreatePipeline(const PermutationKey &key) const;
+    PipelineObject CreateGeometryPipeline(std::uint32_t features) const;
+    // The lighting and GBuffer debug passes: a fullscreen triangle into the back buffer.
+    PipelineObject CreateFullscreenPipeline(const char *file, RootSignatureHandle root_signature) const;
+    // The ready pipeline for features, or a plainer ready one (features is updated to match); null skips the draw.
+    PipelineHandle AcquireGeometryPipeline(std::uint32_t &features);
+    std::uint32_t GeometryFeatures(const RenderObject &obj, bool normal_map, bool displacement) const;
 
+    // Fills visible_objects_ with the indices of objects that may intersect the view_proj frustum and are not
+    // occluded.
+    void CullObjects(const std::vector<RenderObject> &objects, const DirectX::XMMATRIX &view_proj, float aspect);
+    // Rebuilds scene_bvh_ when the objects changed, otherwise refits the dynamic objects (all of them for a new
+    // displacement margin).
+    void UpdateSceneBvh(const std::vector<RenderObject> &objects, float margin);
+    // Removes the objects of visible_objects_ that the occluders among them hide.
+    void OccludeObjects(const std::vector<RenderObject> &objects, const DirectX::XMMATRIX &view_proj, float aspect,
+                        float margin);
     void GeometryPass(const std::vector<RenderObject> &objects);
+    void BindGeometryTargets(CommandRecorder &cmd) const;
+    void BindGeometryState(CommandRecorder &cmd) const;
+    void RecordGeometryDraws(CommandRecorder &cmd, size_t begin, size_t end,
+                             const GeometryView &geometry_view, std::vector<MeshletDrawRange> &visible_ranges) const;
+    size_t SelectLod(const RenderObject &obj, float pixels_per_unit_at_unit_distance) const;
     void LightingPass();
-    void GBufferDebugPass();
+    void GBufferDebugPass(PipelineHandle pso);
 
-    Framework *framework_ = nullptr;
+    RenderDevice *device_ = nullptr;
     GBuffer gbuffer_ = {};
     DirectionalLight directional_light_ = {};
     std::vector<PointLight> point_lights_ = {};
     std::vector<SpotLight> spot_lights_ = {};
 
-    Microsoft::WRL::ComPtr<ID3D12RootSignature> geometry_root_sig_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> geometry_pso_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> geometry_pso_wireframe_;
-    Microsoft::WRL::ComPtr<ID3D12RootSignature> geometry_tess_root_sig_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> geometry_tess_pso_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> geometry_tess_pso_wireframe_;
-    Microsoft::WRL::ComPtr<ID3D12RootSignature> lighting_root_sig_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> lighting_pso_;
-    Microsoft::WRL::ComPtr<ID3D12RootSignature> gbuffer_debug_root_sig_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> gbuffer_debug_pso_;
-    Microsoft::WRL::ComPtr<ID3D12Resource> geometry_cb_;
-    Microsoft::WRL::ComPtr<ID3D12Resource> lighting_cb_;
-    Microsoft::WRL::ComPtr<ID3D12Resource> gbuffer_debug_cb_;
-    std::uint8_t *geometry_cb_mapped_ = nullptr;
-    std::uint8_t *lighting_cb_mapped_ = nullptr;
-    std::uint8_t *gbuffer_debug_cb_mapped_ = nullptr;
-    std::shared_ptr<Texture2D> fallback_white_ = {};
+    RootSignatureObject geometry_root_sig_;
+    RootSignatureObject lighting_root_sig_;
+    RootSignatureObject gbuffer_debug_root_sig_;
+    // Every pipeline of the renderer, keyed by pass and GeometryFeature bits.
+    PipelineStates pipelines_;
 
     struct GBufferDebugCB {
-        INT mode = -1;
+        std::int32_t mode = -1;
         DirectX::XMFLOAT3 _pad = {};
     };
 
@@ -142,5 +234,30 @@ private:
     float tessellation_far_dist_ = 1.0f;
     GBufferDebugMode gbuffer_debug_mode_ = GBufferDebugMode::None;
     RenderMode render_mode_ = RenderMode::Solid;
+    bool cluster_culling_enabled_ = false;
+    bool lod_selection_enabled_ = true;
+    float lod_pixel_error_ = 1.0f;
+    bool parallel_recording_enabled_ = true;
+    bool frustum_culling_enabled_ = true;
+    // World-space bounds of the objects passed to Render, rebuilt every frame since any world matrix may move.
+    FrustumCuller frustum_culler_;
+    std::vector<std::uint32_t> visible_objects_ = {};
+    FrustumCullStats frustum_cull_stats_ = {};
+    bool scene_bvh_enabled_ = true;
+    bool scene_bvh_valid_ = false;
+    float scene_bvh_margin_ = 0.0f;
+    SceneBvh scene_bvh_;
+    std::vector<SceneBvh::Bounds> scene_bounds_ = {};
+    std::vector<std::uint32_t> dynamic_objects_ = {};
+    // Static objects without bounds, which the tree leaves out and every frame draws.
+    std::vector<std::uint32_t> unbounded_objects_ = {};
+    bool occlusion_culling_enabled_ = true;
+    OcclusionCuller occlusion_culler_;
+    std::vector<SceneBvh::Bounds> occlusion_bounds_ = {}; // per entry of visible_objects_
+    ParallelCommandRecorder recorder_;
+    std::vector<GeometryDraw> geometry_draws_ = {};
+    // Meshlet culling scratch, one per worker list.
+    std::vector<std::vector<MeshletDrawRange>> worker_ranges_ = {};
+    std::vector<CommandRecorder *> recorded_lists_ = {};
 };
 }
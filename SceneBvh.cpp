@@ -0,0 +1,474 @@
+#include "SceneBvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+
+namespace gfw {
+    namespace {
+        constexpr std::uint32_t kBinCount = 16;
+        // Leaves stop growing here even when SAH would rather test more objects than split.
+        constexpr std::uint32_t kMaxLeafSize = 8;
+        // SAH cost of visiting a node relative to testing one object's bounds.
+        constexpr float kTraversalCost = 1.0f;
+        // Below this depth splits fall back to the centroid median, which halves every level, so no path is deeper
+        // than kMaxSahDepth + 32 and the query stacks below cannot overflow.
+        constexpr std::uint32_t kMaxSahDepth = 32;
+        constexpr std::size_t kStackSize = kMaxSahDepth + 33;
+
+        struct Box {
+            float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                            std::numeric_limits<float>::max()};
+            float max[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+                            -std::numeric_limits<float>::max()};
+
+            void Grow(const float (&p_min)[3], const float (&p_max)[3]) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    min[axis] = std::min(min[axis], p_min[axis]);
+                    max[axis] = std::max(max[axis], p_max[axis]);
+                }
+            }
+            // Half the surface area; SAH only compares ratios.
+            [[nodiscard]] float Area() const {
+                const float x = max[0] - min[0];
+                const float y = max[1] - min[1];
+                const float z = max[2] - min[2];
+                return x >= 0.0f ? x * y + y * z + z * x : 0.0f;
+            }
+        };
+
+        // Fraction of the way along the ray where it enters the box, clamped to [0, limit]; a miss returns infinity.
+        // An axis the ray is parallel to gives 0 * inf = NaN at a face, which fmin/fmax and the max/min below skip,
+        // so rays in a face plane count as inside along that axis.
+        float EnterBox(const XMFLOAT3 &min, const XMFLOAT3 &max, const float (&origin)[3], const float (&inv_dir)[3],
+                       float limit) {
+            const float lo[3] = {min.x, min.y, min.z};
+            const float hi[3] = {max.x, max.y, max.z};
+            float t_near = 0.0f;
+            float t_far = limit;
+            for (int axis = 0; axis < 3; ++axis) {
+                const float t0 = (lo[axis] - origin[axis]) * inv_dir[axis];
+                const float t1 = (hi[axis] - origin[axis]) * inv_dir[axis];
+                t_near = std::max(t_near, std::fmin(t0, t1));
+                t_far = std::min(t_far, std::fmax(t0, t1));
+            }
+            return t_near <= t_far ? t_near : std::numeric_limits<float>::infinity();
+        }
+
+        float DistanceSq(const XMFLOAT3 &min, const XMFLOAT3 &max, const XMFLOAT3 &p) {
+            const float dx = std::max({min.x - p.x, 0.0f, p.x - max.x});
+            const float dy = std::max({min.y - p.y, 0.0f, p.y - max.y});
+            const float dz = std::max({min.z - p.z, 0.0f, p.z - max.z});
+            return dx * dx + dy * dy + dz * dz;
+        }
+    }
+
+    SceneBvh::Bounds SceneBvh::WorldBounds(const XMFLOAT3 &aabb_min, const XMFLOAT3 &aabb_max, const XMFLOAT4X4 &world,
+                                           float margin) {
+        const float center[3] = {(aabb_min.x + aabb_max.x) * 0.5f, (aabb_min.y + aabb_max.y) * 0.5f,
+                                 (aabb_min.z + aabb_max.z) * 0.5f};
+        const float extent[3] = {(aabb_max.x - aabb_min.x) * 0.5f + margin, (aabb_max.y - aabb_min.y) * 0.5f + margin,
+                                 (aabb_max.z - aabb_min.z) * 0.5f + margin};
+        const float rows[4][3] = {{world._11, world._12, world._13},
+                                  {world._21, world._22, world._23},
+                                  {world._31, world._32, world._33},
+                                  {world._41, world._42, world._43}};
+        float world_center[3];
+        float world_extent[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            world_center[axis] = rows[3][axis];
+            world_extent[axis] = 0.0f;
+            for (int row = 0; row < 3; ++row) {
+                world_center[axis] += center[row] * rows[row][axis];
+                // Arvo: the absolute matrix takes the extent.
+                world_extent[axis] += extent[row] * std::abs(rows[row][axis]);
+            }
+        }
+        return {{world_center[0] - world_extent[0], world_center[1] - world_extent[1],
+                 world_center[2] - world_extent[2]},
+                {world_center[0] + world_extent[0], world_center[1] + world_extent[1],
+                 world_center[2] + world_extent[2]}};
+    }
+
+    void SceneBvh::Build(const std::vector<Bounds> &bounds) {
+        bounds_ = bounds;
+        nodes_.clear();
+        order_.clear();
+        parents_.clear();
+        leaves_.assign(bounds_.size(), kNone);
+        dirty_leaves_.clear();
+        rebuild_ = false;
+
+        // Partitioned in place of order_ so every pass over a node's objects reads them sequentially.
+        struct Item {
+            Box box;
+            float centroid[3];
+            std::uint32_t object;
+        };
+        std::vector<Item> items;
+        items.reserve(bounds_.size());
+        for (std::uint32_t i = 0; i < bounds_.size(); ++i) {
+            const Bounds &b = bounds_[i];
+            if (IsEmpty(b)) {
+                continue;
+            }
+            items.push_back({{{b.min.x, b.min.y, b.min.z}, {b.max.x, b.max.y, b.max.z}},
+                             {(b.min.x + b.max.x) * 0.5f, (b.min.y + b.max.y) * 0.5f, (b.min.z + b.max.z) * 0.5f},
+                             i});
+        }
+        if (items.empty()) {
+            dirty_.clear();
+            return;
+        }
+        nodes_.reserve(items.size() * 2 - 1);
+
+        struct Task {
+            std::uint32_t begin;
+            std::uint32_t end;
+            std::uint32_t parent;
+            std::uint32_t depth;
+            bool right;
+        };
+        std::vector<Task> tasks = {{0, static_cast<std::uint32_t>(items.size()), kNone, 0, false}};
+        Box bins[3][kBinCount];
+        std::uint32_t bin_counts[3][kBinCount];
+        while (!tasks.empty()) {
+            const Task task = tasks.back();
+            tasks.pop_back();
+            const std::uint32_t index = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.push_back({});
+            parents_.push_back(task.parent);
+            if (task.right) {
+                nodes_[task.parent].first = index;
+            }
+
+            Box box;
+            Box centroid_box;
+            for (std::uint32_t i = task.begin; i < task.end; ++i) {
+                box.Grow(items[i].box.min, items[i].box.max);
+                centroid_box.Grow(items[i].centroid, items[i].centroid);
+            }
+            Node &node = nodes_[index];
+            node.min = {box.min[0], box.min[1], box.min[2]};
+            node.max = {box.max[0], box.max[1], box.max[2]};
+
+            const std::uint32_t count = task.end - task.begin;
+            std::uint32_t mid = task.end;
+            if (count > 1 && task.depth < kMaxSahDepth) {
+                // Small nodes have fewer candidate splits than bins; fewer bins keep the bottom levels cheap.
+                const std::uint32_t bin_count = std::min(kBinCount, count);
+                float scale[3];
+                for (int axis = 0; axis < 3; ++axis) {
+                    const float extent = centroid_box.max[axis] - centroid_box.min[axis];
+                    scale[axis] = extent > 0.0f ? static_cast<float>(bin_count) / extent : 0.0f;
+                    std::fill_n(bins[axis], bin_count, Box{});
+                    std::fill_n(bin_counts[axis], bin_count, 0u);
+                }
+                const auto bin_of = [&](const Item &item, int axis) {
+                    return std::min(static_cast<std::uint32_t>((item.centroid[axis] - centroid_box.min[axis]) * scale[axis]),
+                                    bin_count - 1);
+                };
+
+                for (std::uint32_t i = task.begin; i < task.end; ++i) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        const std::uint32_t bin = bin_of(items[i], axis);
+                        bins[axis][bin].Grow(items[i].box.min, items[i].box.max);
+                        ++bin_counts[axis][bin];
+                    }
+                }
+
+                const float inv_area = box.Area() > 0.0f ? 1.0f / box.Area() : 0.0f;
+                float best_cost = std::numeric_limits<float>::infinity();
+                int best_axis = -1;
+                std::uint32_t best_bin = 0;
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (scale[axis] == 0.0f) {
+                        continue;
+                    }
+                    // Right-hand sweep first so the left-hand one can price each split as it goes.
+                    float right_cost[kBinCount] = {};
+                    Box right;
+                    std::uint32_t right_count = 0;
+                    for (std::uint32_t bin = bin_count - 1; bin > 0; --bin) {
+                        right.Grow(bins[axis][bin].min, bins[axis][bin].max);
+                        right_count += bin_counts[axis][bin];
+                        right_cost[bin] = right_count > 0 ? right.Area() * static_cast<float>(right_count) : -1.0f;
+                    }
+                    Box left;
+                    std::uint32_t left_count = 0;
+                    for (std::uint32_t bin = 1; bin < bin_count; ++bin) {
+                        left.Grow(bins[axis][bin - 1].min, bins[axis][bin - 1].max);
+                        left_count += bin_counts[axis][bin - 1];
+                        if (left_count == 0 || right_cost[bin] < 0.0f) {
+                            continue;
+                        }
+                        const float cost = kTraversalCost +
+                                           (left.Area() * static_cast<float>(left_count) + right_cost[bin]) * inv_area;
+                        if (cost < best_cost) {
+                            best_cost = cost;
+                            best_axis = axis;
+                            best_bin = bin;
+                        }
+                    }
+                }
+                // Testing every object costs count; oversized leaves split even when that is cheaper.
+                if (best_axis >= 0 && (best_cost < static_cast<float>(count) || count > kMaxLeafSize)) {
+                    mid = static_cast<std::uint32_t>(
+                        std::partition(items.begin() + task.begin, items.begin() + task.end,
+                                       [&](const Item &item) { return bin_of(item, best_axis) < best_bin; }) -
+                        items.begin());
+                }
+            }
+            if (mid == task.end && count > kMaxLeafSize) {
+                // Too deep for SAH or every centroid in one spot: halve along the widest centroid axis.
+                int axis = 0;
+                for (int i = 1; i < 3; ++i) {
+                    if (centroid_box.max[i] - centroid_box.min[i] > centroid_box.max[axis] - centroid_box.min[axis]) {
+                        axis = i;
+                    }
+                }
+                mid = task.begin + count / 2;
+                std::nth_element(items.begin() + task.begin, items.begin() + mid, items.begin() + task.end,
+                                 [axis](const Item &a, const Item &b) { return a.centroid[axis] < b.centroid[axis]; });
+            }
+
+            if (mid == task.end) {
+                node.first = task.begin;
+                node.count = count;
+                for (std::uint32_t i = task.begin; i < task.end; ++i) {
+                    leaves_[items[i].object] = index;
+                }
+                continue;
+            }
+            node.count = 0;
+            // The left child is popped next, so it lands right after its parent.
+            tasks.push_back({mid, task.end, index, task.depth + 1, true});
+            tasks.push_back({task.begin, mid, index, task.depth + 1, false});
+        }
+
+        order_.resize(items.size());
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            order_[i] = items[i].object;
+        }
+        dirty_.assign(nodes_.size(), 0);
+    }
+
+    void SceneBvh::Update(std::uint32_t object, const Bounds &bounds) {
+        bounds_[object] = bounds;
+        const std::uint32_t leaf = leaves_[object];
+        if ((leaf == kNone) != IsEmpty(bounds)) {
+            rebuild_ = true;
+        } else if (leaf != kNone && !dirty_[leaf]) {
+            dirty_[leaf] = 1;
+            dirty_leaves_.push_back(leaf);
+        }
+    }
+
+    void SceneBvh::FitLeaf(Node &leaf) const {
+        Bounds fit = bounds_[order_[leaf.first]];
+        for (std::uint32_t i = leaf.first + 1; i < leaf.first + leaf.count; ++i) {
+            const Bounds &b = bounds_[order_[i]];
+            fit.min = {std::min(fit.min.x, b.min.x), std::min(fit.min.y, b.min.y), std::min(fit.min.z, b.min.z)};
+            fit.max = {std::max(fit.max.x, b.max.x), std::max(fit.max.y, b.max.y), std::max(fit.max.z, b.max.z)};
+        }
+        leaf.min = fit.min;
+        leaf.max = fit.max;
+    }
+
+    size_t SceneBvh::Refit() {
+        if (rebuild_) {
+            Build(std::vector<Bounds>(bounds_));
+            return nodes_.size();
+        }
+        size_t refit = 0;
+        for (const std::uint32_t leaf : dirty_leaves_) {
+            dirty_[leaf] = 0;
+            FitLeaf(nodes_[leaf]);
+            ++refit;
+            // Every ancestor is the union of its two children; once one comes out unchanged, so do those above it.
+            for (std::uint32_t index = parents_[leaf]; index != kNone; index = parents_[index]) {
+                const Node &left = nodes_[index + 1];
+                const Node &right = nodes_[nodes_[index].first];
+                const XMFLOAT3 min = {std::min(left.min.x, right.min.x), std::min(left.min.y, right.min.y),
+                                      std::min(left.min.z, right.min.z)};
+                const XMFLOAT3 max = {std::max(left.max.x, right.max.x), std::max(left.max.y, right.max.y),
+                                      std::max(left.max.z, right.max.z)};
+                Node &node = nodes_[index];
+                if (min.x == node.min.x && min.y == node.min.y && min.z == node.min.z && max.x == node.max.x &&
+                    max.y == node.max.y && max.z == node.max.z) {
+                    break;
+                }
+                node.min = min;
+                node.max = max;
+                ++refit;
+            }
+        }
+        dirty_leaves_.clear();
+        return refit;
+    }
+
+    void SceneBvh::SubtreeObjects(std::uint32_t node, std::uint32_t &begin, std::uint32_t &end) const {
+        std::uint32_t first = node;
+        while (nodes_[first].count == 0) {
+            ++first;
+        }
+        std::uint32_t last = node;
+        while (nodes_[last].count == 0) {
+            last = nodes_[last].first;
+        }
+        begin = nodes_[first].first;
+        end = nodes_[last].first + nodes_[last].count;
+    }
+
+    void SceneBvh::QueryFrustum(const FrustumCuller::Frustum &frustum, std::vector<std::uint32_t> &out) const {
+        if (nodes_.empty()) {
+            return;
+        }
+        float abs_planes[6][3];
+        for (int p = 0; p < 6; ++p) {
+            abs_planes[p][0] = std::abs(frustum.planes[p].x);
+            abs_planes[p][1] = std::abs(frustum.planes[p].y);
+            abs_planes[p][2] = std::abs(frustum.planes[p].z);
+        }
+        // Drops the planes min..max is entirely inside of from mask; false when it is entirely outside one.
+        const auto classify = [&](const XMFLOAT3 &min, const XMFLOAT3 &max, std::uint32_t &mask) {
+            const float cx = (min.x + max.x) * 0.5f, cy = (min.y + max.y) * 0.5f, cz = (min.z + max.z) * 0.5f;
+            const float ex = (max.x - min.x) * 0.5f, ey = (max.y - min.y) * 0.5f, ez = (max.z - min.z) * 0.5f;
+            for (std::uint32_t p = 0; p < 6; ++p) {
+                if (!(mask & (1u << p))) {
+                    continue;
+                }
+                const XMFLOAT4 &plane = frustum.planes[p];
+                const float distance = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+                const float reach = abs_planes[p][0] * ex + abs_planes[p][1] * ey + abs_planes[p][2] * ez;
+                if (distance < -reach) {
+                    return false;
+                }
+                if (distance >= reach) {
+                    mask &= ~(1u << p);
+                }
+            }
+            return true;
+        };
+
+        // Children inherit the planes their parent was not entirely inside of; a node inside all six takes its
+        // whole object range untested.
+        struct Entry {
+            std::uint32_t node;
+            std::uint32_t mask;
+        };
+        Entry stack[kStackSize];
+        std::size_t top = 0;
+        stack[top++] = {0, 0x3fu};
+        while (top > 0) {
+            const Entry entry = stack[--top];
+            const Node &node = nodes_[entry.node];
+            std::uint32_t mask = entry.mask;
+            if (!classify(node.min, node.max, mask)) {
+                continue;
+            }
+            if (mask == 0) {
+                std::uint32_t begin, end;
+                SubtreeObjects(entry.node, begin, end);
+                out.insert(out.end(), order_.begin() + begin, order_.begin() + end);
+                continue;
+            }
+            if (node.count > 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    std::uint32_t object_mask = mask;
+                    if (classify(bounds_[order_[i]].min, bounds_[order_[i]].max, object_mask)) {
+                        out.push_back(order_[i]);
+                    }
+                }
+                continue;
+            }
+            stack[top++] = {node.first, mask};
+            stack[top++] = {entry.node + 1, mask};
+        }
+    }
+
+    void SceneBvh::QuerySphere(const XMFLOAT3 &center, float radius, std::vector<std::uint32_t> &out) const {
+        if (nodes_.empty()) {
+            return;
+        }
+        const float radius_sq = radius * radius;
+        std::uint32_t stack[kStackSize];
+        std::size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const std::uint32_t index = stack[--top];
+            const Node &node = nodes_[index];
+            if (DistanceSq(node.min, node.max, center) > radius_sq) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const Bounds &b = bounds_[order_[i]];
+                    if (DistanceSq(b.min, b.max, center) <= radius_sq) {
+                        out.push_back(order_[i]);
+                    }
+                }
+                continue;
+            }
+            stack[top++] = node.first;
+            stack[top++] = index + 1;
+        }
+    }
+
+    bool SceneBvh::QueryRay(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float max_distance, RayHit &hit) const {
+        if (nodes_.empty()) {
+            return false;
+        }
+        const float o[3] = {origin.x, origin.y, origin.z};
+        const float inv_dir[3] = {1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z};
+        float best = max_distance;
+        bool found = false;
+
+        struct Entry {
+            std::uint32_t node;
+            float distance;
+        };
+        Entry stack[kStackSize];
+        std::size_t top = 0;
+        const float root = EnterBox(nodes_[0].min, nodes_[0].max, o, inv_dir, best);
+        if (root <= best) {
+            stack[top++] = {0, root};
+        }
+        while (top > 0) {
+            const Entry entry = stack[--top];
+            if (entry.distance > best) {
+                continue;
+            }
+            const Node &node = nodes_[entry.node];
+            if (node.count > 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const Bounds &b = bounds_[order_[i]];
+                    const float t = EnterBox(b.min, b.max, o, inv_dir, best);
+                    if (t <= best && (!found || t < best)) {
+                        best = t;
+                        hit = {order_[i], t};
+                        found = true;
+                    }
+                }
+                continue;
+            }
+            // Nearer child on top so its hits prune the farther one.
+            const Node &left = nodes_[entry.node + 1];
+            const Node &right = nodes_[node.first];
+            Entry closer = {entry.node + 1, EnterBox(left.min, left.max, o, inv_dir, best)};
+            Entry farther = {node.first, EnterBox(right.min, right.max, o, inv_dir, best)};
+            if (farther.distance < closer.distance) {
+                std::swap(closer, farther);
+            }
+            if (farther.distance <= best) {
+                stack[top++] = farther;
+            }
+            if (closer.distance <= best) {
+                stack[top++] = closer;
+            }
+        }
+        return found;
+    }
+}
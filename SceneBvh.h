@@ -0,0 +1,82 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FrustumCuller.h"
+
+namespace gfw {
+    // Bounding volume hierarchy over the world-space AABBs of a scene's objects, built top-down with binned SAH.
+    // Objects that move keep their place in the tree and only the nodes above them are refit, so the tree is
+    // rebuilt only when objects are added or removed. Nodes are stored depth-first: an inner node's left child
+    // follows it, so the objects below any node are one contiguous range.
+    class SceneBvh {
+    public:
+        struct Bounds {
+            DirectX::XMFLOAT3 min = {};
+            DirectX::XMFLOAT3 max = {};
+        };
+
+        struct RayHit {
+            std::uint32_t object = 0;
+            float distance = 0.0f; // in units of the ray direction
+        };
+
+        // World AABB of an object-space AABB placed by world (row vectors), grown by margin in object space.
+        static Bounds WorldBounds(const DirectX::XMFLOAT3 &aabb_min, const DirectX::XMFLOAT3 &aabb_max,
+                                  const DirectX::XMFLOAT4X4 &world, float margin = 0.0f);
+
+        // True for bounds with min > max or NaN on any axis.
+        static bool IsEmpty(const Bounds &bounds) {
+            return !(bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y && bounds.min.z <= bounds.max.z);
+        }
+
+        // Replaces the tree with one over bounds[i] for object i. Objects with empty or NaN bounds are left out
+        // and no query returns them.
+        void Build(const std::vector<Bounds> &bounds);
+
+        // Moves an object; takes effect at the next Refit.
+        void Update(std::uint32_t object, const Bounds &bounds);
+
+        // Grows and shrinks the nodes above the objects updated since the last call, stopping at the first node
+        // whose bounds stay the same. An object entering or leaving the tree rebuilds it instead. Returns the
+        // number of nodes refit.
+        size_t Refit();
+
+        [[nodiscard]] size_t ObjectCount() const { return bounds_.size(); }
+        [[nodiscard]] size_t NodeCount() const { return nodes_.size(); }
+
+        // Append the objects whose bounds may intersect the frustum or the sphere to out, in tree order.
+        void QueryFrustum(const FrustumCuller::Frustum &frustum, std::vector<std::uint32_t> &out) const;
+        void QuerySphere(const DirectX::XMFLOAT3 &center, float radius, std::vector<std::uint32_t> &out) const;
+
+        // Nearest object whose bounds the ray enters within [0, max_distance]; a ray starting inside bounds hits
+        // them at 0. direction does not have to be normalized.
+        bool QueryRay(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float max_distance,
+                      RayHit &hit) const;
+
+    private:
+        struct Node {
+            DirectX::XMFLOAT3 min;
+            std::uint32_t first; // leaf: first entry of order_; inner: index of the right child
+            DirectX::XMFLOAT3 max;
+            std::uint32_t count; // leaf: entries of order_; inner: 0
+        };
+
+        static constexpr std::uint32_t kNone = ~0u;
+
+        // Range of order_ below node.
+        void SubtreeObjects(std::uint32_t node, std::uint32_t &begin, std::uint32_t &end) const;
+        void FitLeaf(Node &leaf) const;
+
+        std::vector<Node> nodes_;
+        std::vector<Bounds> bounds_;
+        std::vector<std::uint32_t> order_;   // object indices, grouped by leaf
+        std::vector<std::uint32_t> parents_; // per node; kNone for the root
+        std::vector<std::uint32_t> leaves_;  // per object; kNone for objects outside the tree
+        std::vector<std::uint32_t> dirty_leaves_;
+        std::vector<std::uint8_t> dirty_;    // per node, for leaves in dirty_leaves_
+        bool rebuild_ = false;
+    };
+}
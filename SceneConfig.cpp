@@ -11,6 +11,7 @@ void AddObjectsToConfig(AppConfig &config) {
     sponza_object.material_mode = MaterialMode::Texture;
     sponza_object.position = {0.0f, 0.0f, 0.0f};
     sponza_object.scale = {1.0f, 1.0f, 1.0f};
+    sponza_object.occluder_min_extent = 5.0f;
     config.objects.push_back(sponza_object);*/
 
      // Brick plane
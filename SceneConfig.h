@@ -28,6 +28,9 @@ struct SceneObjectConfig {
     DirectX::XMFLOAT3 position = {0.0f, 0.0f, 0.0f};
     DirectX::XMFLOAT3 scale = {1.0f, 1.0f, 1.0f};
     float rainbow_speed = 1.0f;
+    // Submeshes whose world-space AABB (loaded positions times scale) is at least this large along its two
+    // longest axes occlude other objects (walls, floors, columns); 0 makes none of them occluders.
+    float occluder_min_extent = 0.0f;
 };
 
 struct RenderSettings {
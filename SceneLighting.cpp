@@ -42,10 +42,19 @@ void PrintTessellationAndDebugHelp() {
     std::wcout << L"\nTessellation and Debug Visualization:\n"
                << L"  T - toggle tessellation (starts ON; displacement only works with tessellation)\n"
                << L"  V - toggle wireframe mode\n"
+               << L"  C - toggle meshlet frustum culling (non-tessellated path)\n"
+               << L"  B - toggle distance-based LOD selection (starts ON)\n"
+               << L"  M - toggle multi-threaded GBuffer recording (starts ON)\n"
+               << L"  N - toggle object frustum culling (starts ON)\n"
+               << L"  H - toggle culling through the scene BVH instead of every object (starts ON)\n"
+               << L"  X - toggle CPU occlusion culling behind occluder meshes (starts ON)\n"
                << L"  0 - normal lighting (exit debug mode)\n"
                << L"  1 - visualize Position buffer\n"
                << L"  2 - visualize Normal buffer\n"
-               << L"  3 - visualize Albedo buffer\n";
+               << L"  3 - visualize Albedo buffer\n"
+               << L"  P - print frame pacing stats (CPU/GPU overlap)\n"
+               << L"  F9 - capture the next frame to frame.gfwcap\n"
+               << L"  F10 - replay the last capture 1000 times and print its CPU cost\n";
 }
 
 void SetupDefaultLocalLights(LightControlState &state) {
@@ -0,0 +1,184 @@
+#include "TangentGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace gfw {
+
+namespace {
+    struct FloatVertex {
+        XMFLOAT3 position;
+        XMFLOAT3 normal;
+        XMFLOAT2 uv;
+    };
+    static_assert(sizeof(FloatVertex) == 32);
+
+    struct TangentVertex {
+        FloatVertex base;
+        XMFLOAT4 tangent;
+    };
+    static_assert(sizeof(TangentVertex) == 48);
+
+    XMFLOAT3 Sub(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    XMFLOAT3 Scale(const XMFLOAT3 &a, float s) {
+        return {a.x * s, a.y * s, a.z * s};
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // Normalizes v; returns false and leaves it unchanged when it is (nearly) zero.
+    bool Normalize(XMFLOAT3 &v) {
+        const float length = std::sqrt(Dot(v, v));
+        if (length <= 1e-20f) {
+            return false;
+        }
+        v = Scale(v, 1.0f / length);
+        return true;
+    }
+
+    // v with its component along unit n removed.
+    XMFLOAT3 Project(const XMFLOAT3 &v, const XMFLOAT3 &n) {
+        return Sub(v, Scale(n, Dot(v, n)));
+    }
+
+    // Any unit vector perpendicular to n, for vertices without usable UVs.
+    XMFLOAT3 AnyPerpendicular(const XMFLOAT3 &n) {
+        XMFLOAT3 t = std::fabs(n.x) < 0.9f ? Cross({1.0f, 0.0f, 0.0f}, n) : Cross({0.0f, 1.0f, 0.0f}, n);
+        if (!Normalize(t)) {
+            t = {1.0f, 0.0f, 0.0f};
+        }
+        return t;
+    }
+
+    // Tangent sums for one handedness of one vertex.
+    struct TangentGroup {
+        XMFLOAT3 sum = {0.0f, 0.0f, 0.0f};
+        bool used = false;
+        std::uint32_t output = 0;
+    };
+
+    constexpr std::uint8_t kPositive = 0;
+    constexpr std::uint8_t kNegative = 1;
+    constexpr std::uint8_t kUndetermined = 2;
+}
+
+bool TangentGenerator::Generate(MeshData &mesh) {
+    if (mesh.vertex_format != VertexFormat::Float32 || mesh.has_tangents || mesh.vertex_stride != sizeof(FloatVertex) ||
+        mesh.topology != PrimitiveTopology::TriangleList || mesh.vertex_count == 0 ||
+        mesh.vertex_data.size() < std::size_t{mesh.vertex_count} * sizeof(FloatVertex)) {
+        return false;
+    }
+    std::vector<FloatVertex> vertices(mesh.vertex_count);
+    std::memcpy(vertices.data(), mesh.vertex_data.data(), vertices.size() * sizeof(FloatVertex));
+    std::vector<XMFLOAT3> normals(mesh.vertex_count);
+    for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+        normals[v] = vertices[v].normal;
+        if (!Normalize(normals[v])) {
+            normals[v] = {0.0f, 1.0f, 0.0f};
+        }
+    }
+
+    std::vector<TangentGroup> groups(std::size_t{mesh.vertex_count} * 2);
+    std::vector<std::uint8_t> corner_sign(mesh.indices.size(), kUndetermined);
+    for (std::size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+        const std::uint32_t *tri = &mesh.indices[t];
+        const FloatVertex &v0 = vertices[tri[0]];
+        const XMFLOAT3 e1 = Sub(vertices[tri[1]].position, v0.position);
+        const XMFLOAT3 e2 = Sub(vertices[tri[2]].position, v0.position);
+        const float du1 = vertices[tri[1]].uv.x - v0.uv.x;
+        const float dv1 = vertices[tri[1]].uv.y - v0.uv.y;
+        const float du2 = vertices[tri[2]].uv.x - v0.uv.x;
+        const float dv2 = vertices[tri[2]].uv.y - v0.uv.y;
+        const float det = du1 * dv2 - du2 * dv1;
+        if (std::fabs(det) <= 1e-20f) {
+            continue;
+        }
+        // dP/du and dP/dv of the triangle; only their directions matter.
+        const XMFLOAT3 dpdu = Sub(Scale(e1, dv2), Scale(e2, dv1));
+        const XMFLOAT3 dpdv = Sub(Scale(e2, du1), Scale(e1, du2));
+        const float orientation = det > 0.0f ? 1.0f : -1.0f;
+
+        for (int k = 0; k < 3; ++k) {
+            const std::uint32_t v = tri[k];
+            const XMFLOAT3 &n = normals[v];
+            XMFLOAT3 tangent = Scale(Project(dpdu, n), orientation);
+            XMFLOAT3 bitangent = Scale(Project(dpdv, n), orientation);
+            if (!Normalize(tangent)) {
+                continue;
+            }
+            Normalize(bitangent);
+
+            XMFLOAT3 a = Sub(vertices[tri[(k + 1) % 3]].position, vertices[v].position);
+            XMFLOAT3 b = Sub(vertices[tri[(k + 2) % 3]].position, vertices[v].position);
+            if (!Normalize(a) || !Normalize(b)) {
+                continue;
+            }
+            const float angle = std::acos(std::clamp(Dot(a, b), -1.0f, 1.0f));
+
+            const std::uint8_t sign = Dot(Cross(n, tangent), bitangent) >= 0.0f ? kPositive : kNegative;
+            corner_sign[t + k] = sign;
+            TangentGroup &group = groups[std::size_t{v} * 2 + sign];
+            group.sum = {group.sum.x + tangent.x * angle, group.sum.y + tangent.y * angle,
+                         group.sum.z + tangent.z * angle};
+            group.used = true;
+        }
+    }
+
+    // The first used group keeps the vertex id; a second handedness gets a copy appended at the end.
+    std::uint32_t next_vertex = mesh.vertex_count;
+    for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+        TangentGroup &positive = groups[std::size_t{v} * 2 + kPositive];
+        TangentGroup &negative = groups[std::size_t{v} * 2 + kNegative];
+        positive.output = v;
+        negative.output = positive.used && negative.used ? next_vertex++ : v;
+    }
+
+    std::vector<TangentVertex> output(next_vertex);
+    for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+        bool written = false;
+        for (std::uint8_t sign: {kPositive, kNegative}) {
+            const TangentGroup &group = groups[std::size_t{v} * 2 + sign];
+            if (!group.used) {
+                continue;
+            }
+            XMFLOAT3 tangent = Project(group.sum, normals[v]);
+            if (!Normalize(tangent)) {
+                tangent = AnyPerpendicular(normals[v]);
+            }
+            output[group.output] = {vertices[v], {tangent.x, tangent.y, tangent.z, sign == kPositive ? 1.0f : -1.0f}};
+            written = true;
+        }
+        if (!written) {
+            const XMFLOAT3 tangent = AnyPerpendicular(normals[v]);
+            output[v] = {vertices[v], {tangent.x, tangent.y, tangent.z, 1.0f}};
+        }
+    }
+
+    for (std::size_t i = 0; i < mesh.indices.size(); ++i) {
+        if (corner_sign[i] == kNegative) {
+            mesh.indices[i] = groups[std::size_t{mesh.indices[i]} * 2 + kNegative].output;
+        }
+    }
+
+    mesh.vertex_data.resize(output.size() * sizeof(TangentVertex));
+    std::memcpy(mesh.vertex_data.data(), output.data(), mesh.vertex_data.size());
+    mesh.vertex_stride = sizeof(TangentVertex);
+    mesh.vertex_count = next_vertex;
+    mesh.has_tangents = true;
+    return true;
+}
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "MeshData.h"
+
+namespace gfw {
+    // Per-vertex tangent frames in the MikkTSpace convention: corner-angle weighted UV tangents projected
+    // onto the vertex normal, with bitangent = w * cross(normal, tangent). Vertices whose triangles
+    // disagree on handedness (mirrored UVs) are split so each copy has a single frame.
+    class TangentGenerator {
+    public:
+        // Appends a float4 tangent to every vertex of a Float32 triangle-list mesh (stride 32 -> 48) and
+        // sets has_tangents. Returns false and leaves other layouts untouched.
+        static bool Generate(MeshData &mesh);
+    };
+}
@@ -3,7 +3,7 @@
 
 namespace gfw {
 
-TextureResolver::TextureResolver(Framework &framework) : framework_(framework) {}
+TextureResolver::TextureResolver(RenderDevice &device) : device_(device) {}
 
 std::shared_ptr<Texture2D> TextureResolver::ResolveDiffuse(
     const SceneObjectConfig &config,
@@ -15,7 +15,7 @@ std::shared_ptr<Texture2D> TextureResolver::ResolveDiffuse(
     }
 
     if (effective_path.empty()) {
-        return framework_.CreateSolidTexture({1.0f, 1.0f, 1.0f, 1.0f});
+        return device_.CreateSolidTexture({1.0f, 1.0f, 1.0f, 1.0f});
     }
 
     // Проверяем кеш
@@ -25,9 +25,9 @@ std::shared_ptr<Texture2D> TextureResolver::ResolveDiffuse(
     }
 
     // Загружаем и кешируем
-    std::shared_ptr<Texture2D> texture = framework_.CreateTextureFromFile(effective_path);
+    std::shared_ptr<Texture2D> texture = device_.CreateTextureFromFile(effective_path);
     cache_[effective_path] = texture;
-    return texture ? texture : framework_.CreateSolidTexture({1.0f, 1.0f, 1.0f, 1.0f});
+    return texture ? texture : device_.CreateSolidTexture({1.0f, 1.0f, 1.0f, 1.0f});
 }
 
 std::wstring TextureResolver::ExtractFileStem(const std::wstring &full_path) {
@@ -55,7 +55,7 @@ std::shared_ptr<Texture2D> TextureResolver::TryLoadTexture(
         }
 
         // Пытаемся загрузить
-        std::shared_ptr<Texture2D> texture = framework_.CreateTextureFromFile(test_path);
+        std::shared_ptr<Texture2D> texture = device_.CreateTextureFromFile(test_path);
         if (texture) {
             cache_[test_path] = texture;
             return texture;
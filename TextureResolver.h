@@ -4,16 +4,16 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
-#include "framework/Framework.h"
+#include "framework/RenderDevice.h"
 
 namespace gfw {
 
 struct SceneObjectConfig;
-class Framework;
+class RenderDevice;
 
 class TextureResolver {
 public:
-    explicit TextureResolver(Framework &framework);
+    explicit TextureResolver(RenderDevice &device);
 
     // Разрешает диффузную текстуру с кешированием
     std::shared_ptr<Texture2D> ResolveDiffuse(
@@ -30,7 +30,7 @@ public:
     void ClearCache() { cache_.clear(); }
 
 private:
-    Framework &framework_;
+    RenderDevice &device_;
     std::unordered_map<std::wstring, std::shared_ptr<Texture2D>> cache_;
 
     // Вспомогательный метод для поиска файла с несколькими расширениями
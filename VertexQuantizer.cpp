@@ -0,0 +1,194 @@
+#include "VertexQuantizer.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace gfw {
+
+namespace {
+    std::uint16_t ToUnorm16(float value) {
+        return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    std::int16_t ToSnorm16(float value) {
+        return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    float FromSnorm16(std::int16_t value) {
+        return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
+    float SignNotZero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Octahedral mapping: project onto |x|+|y|+|z| = 1 and fold the lower hemisphere over the diagonals.
+    void EncodeOctahedral(const float v[3], std::int16_t &x, std::int16_t &y) {
+        const float l1 = std::fabs(v[0]) + std::fabs(v[1]) + std::fabs(v[2]);
+        float ox = 0.0f;
+        float oy = 0.0f;
+        if (l1 > 0.0f) {
+            ox = v[0] / l1;
+            oy = v[1] / l1;
+            if (v[2] < 0.0f) {
+                const float fx = (1.0f - std::fabs(oy)) * SignNotZero(ox);
+                const float fy = (1.0f - std::fabs(ox)) * SignNotZero(oy);
+                ox = fx;
+                oy = fy;
+            }
+        }
+        x = ToSnorm16(ox);
+        y = ToSnorm16(oy);
+    }
+
+    // Mirrors OctDecode in GBufferVertex.hlsl.
+    void DecodeOctahedral(std::int16_t ex, std::int16_t ey, float v[3]) {
+        float x = FromSnorm16(ex);
+        float y = FromSnorm16(ey);
+        const float z = 1.0f - std::fabs(x) - std::fabs(y);
+        const float t = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        const float length = std::sqrt(x * x + y * y + z * z);
+        v[0] = x / length;
+        v[1] = y / length;
+        v[2] = z / length;
+    }
+
+    // Angle in degrees between a (any length) and unit b; 0 when a is zero.
+    float AngleDegrees(const float a[3], const float b[3]) {
+        const float length = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        if (length <= 0.0f) {
+            return 0.0f;
+        }
+        const float cosine = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / length;
+        return XMConvertToDegrees(std::acos(std::clamp(cosine, -1.0f, 1.0f)));
+    }
+
+    // VertexFormat::Float32: position, normal and UV as consecutive floats, then the optional tangent.
+    struct FloatVertex {
+        float px, py, pz;
+        float nx, ny, nz;
+        float u, v;
+    };
+    static_assert(sizeof(FloatVertex) == 32);
+    constexpr std::uint32_t kFloatTangentStride = sizeof(FloatVertex) + 4 * sizeof(float);
+}
+
+QuantizedVertex VertexQuantizer::Encode(const float position[3], const float normal[3], const float uv[2],
+                                        const XMFLOAT3 &offset, const XMFLOAT3 &inv_scale) {
+    QuantizedVertex out = {};
+    out.px = ToUnorm16((position[0] - offset.x) * inv_scale.x);
+    out.py = ToUnorm16((position[1] - offset.y) * inv_scale.y);
+    out.pz = ToUnorm16((position[2] - offset.z) * inv_scale.z);
+
+    EncodeOctahedral(normal, out.nx, out.ny);
+
+    out.u = PackedVector::XMConvertFloatToHalf(uv[0]);
+    out.v = PackedVector::XMConvertFloatToHalf(uv[1]);
+    return out;
+}
+
+QuantizedTangent VertexQuantizer::EncodeTangent(const float tangent[4], QuantizedVertex &vertex) {
+    QuantizedTangent out = {};
+    EncodeOctahedral(tangent, out.tx, out.ty);
+    vertex.pw = tangent[3] < 0.0f ? 0 : 0xffff;
+    return out;
+}
+
+void VertexQuantizer::DecodeTangent(const QuantizedTangent &encoded, const QuantizedVertex &vertex, float tangent[4]) {
+    DecodeOctahedral(encoded.tx, encoded.ty, tangent);
+    tangent[3] = vertex.pw >= 0x8000 ? 1.0f : -1.0f;
+}
+
+void VertexQuantizer::Decode(const QuantizedVertex &vertex, const XMFLOAT3 &offset, const XMFLOAT3 &scale,
+                             float position[3], float normal[3], float uv[2]) {
+    position[0] = offset.x + static_cast<float>(vertex.px) / 65535.0f * scale.x;
+    position[1] = offset.y + static_cast<float>(vertex.py) / 65535.0f * scale.y;
+    position[2] = offset.z + static_cast<float>(vertex.pz) / 65535.0f * scale.z;
+
+    DecodeOctahedral(vertex.nx, vertex.ny, normal);
+
+    uv[0] = PackedVector::XMConvertHalfToFloat(vertex.u);
+    uv[1] = PackedVector::XMConvertHalfToFloat(vertex.v);
+}
+
+bool VertexQuantizer::Quantize(MeshData &mesh, QuantizationStats *stats) {
+    const std::uint32_t source_stride = mesh.has_tangents ? kFloatTangentStride : sizeof(FloatVertex);
+    if (mesh.vertex_format != VertexFormat::Float32 || mesh.vertex_stride != source_stride || mesh.vertex_count == 0 ||
+        mesh.vertex_data.size() < std::size_t{mesh.vertex_count} * source_stride) {
+        return false;
+    }
+    const auto load = [&](std::uint32_t i) {
+        FloatVertex v;
+        std::memcpy(&v, mesh.vertex_data.data() + std::size_t{i} * source_stride, sizeof(v));
+        return v;
+    };
+
+    FloatVertex first = load(0);
+    XMFLOAT3 lo = {first.px, first.py, first.pz};
+    XMFLOAT3 hi = lo;
+    for (std::uint32_t i = 1; i < mesh.vertex_count; ++i) {
+        const FloatVertex v = load(i);
+        lo = {std::min(lo.x, v.px), std::min(lo.y, v.py), std::min(lo.z, v.pz)};
+        hi = {std::max(hi.x, v.px), std::max(hi.y, v.py), std::max(hi.z, v.pz)};
+    }
+    const XMFLOAT3 scale = {hi.x - lo.x, hi.y - lo.y, hi.z - lo.z};
+    const XMFLOAT3 inv_scale = {scale.x > 0.0f ? 1.0f / scale.x : 0.0f, scale.y > 0.0f ? 1.0f / scale.y : 0.0f,
+                                scale.z > 0.0f ? 1.0f / scale.z : 0.0f};
+
+    const std::uint32_t stride = sizeof(QuantizedVertex) + (mesh.has_tangents ? sizeof(QuantizedTangent) : 0);
+    std::vector<std::uint8_t> encoded(std::size_t{mesh.vertex_count} * stride);
+    QuantizationStats local;
+    for (std::uint32_t i = 0; i < mesh.vertex_count; ++i) {
+        const FloatVertex v = load(i);
+        const float position[3] = {v.px, v.py, v.pz};
+        const float normal[3] = {v.nx, v.ny, v.nz};
+        const float uv[2] = {v.u, v.v};
+        QuantizedVertex q = Encode(position, normal, uv, lo, inv_scale);
+
+        float decoded_position[3];
+        float decoded_normal[3];
+        float decoded_uv[2];
+        Decode(q, lo, scale, decoded_position, decoded_normal, decoded_uv);
+        const float dx = decoded_position[0] - position[0];
+        const float dy = decoded_position[1] - position[1];
+        const float dz = decoded_position[2] - position[2];
+        local.max_position_error = std::max(local.max_position_error, std::sqrt(dx * dx + dy * dy + dz * dz));
+        local.max_normal_error = std::max(local.max_normal_error, AngleDegrees(normal, decoded_normal));
+        local.max_uv_error = std::max({local.max_uv_error, std::fabs(decoded_uv[0] - uv[0]),
+                                       std::fabs(decoded_uv[1] - uv[1])});
+
+        std::uint8_t *dst = encoded.data() + std::size_t{i} * stride;
+        if (mesh.has_tangents) {
+            float tangent[4];
+            std::memcpy(tangent, mesh.vertex_data.data() + std::size_t{i} * source_stride + sizeof(FloatVertex),
+                        sizeof(tangent));
+            const QuantizedTangent t = EncodeTangent(tangent, q);
+            float decoded_tangent[4];
+            DecodeTangent(t, q, decoded_tangent);
+            local.max_tangent_error = std::max(local.max_tangent_error, AngleDegrees(tangent, decoded_tangent));
+            std::memcpy(dst + sizeof(QuantizedVertex), &t, sizeof(t));
+        }
+        std::memcpy(dst, &q, sizeof(q));
+    }
+
+    local.bytes_before = mesh.vertex_data.size() + mesh.indices.size() * sizeof(std::uint32_t);
+    mesh.vertex_data = std::move(encoded);
+    mesh.vertex_stride = stride;
+    mesh.vertex_format = VertexFormat::Quantized;
+    mesh.bounds_min = lo;
+    mesh.bounds_max = hi;
+    local.bytes_after = mesh.vertex_data.size() + mesh.indices.size() * IndexSize(mesh.vertex_count);
+    if (stats) {
+        *stats = local;
+    }
+    return true;
+}
+
+}
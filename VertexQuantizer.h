@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MeshData.h"
+#include <cstdint>
+
+namespace gfw {
+    // 16-byte vertex: POSITION R16G16B16A16_UNORM (xyz relative to the AABB, w tangent handedness with
+    // 0 for -1 and 1 for +1), NORMAL R16G16_SNORM (octahedral), TEXCOORD R16G16_FLOAT.
+    struct QuantizedVertex {
+        std::uint16_t px, py, pz, pw;
+        std::int16_t nx, ny;
+        std::uint16_t u, v;
+    };
+    static_assert(sizeof(QuantizedVertex) == 16);
+
+    // Optional TANGENT R16G16_SNORM (octahedral) following a QuantizedVertex.
+    struct QuantizedTangent {
+        std::int16_t tx, ty;
+    };
+
+    // Worst round-trip deviation of an encoded mesh and the buffer sizes before and after.
+    struct QuantizationStats {
+        float max_position_error = 0.0f; // object-space units
+        float max_normal_error = 0.0f;   // degrees
+        float max_uv_error = 0.0f;
+        float max_tangent_error = 0.0f;  // degrees
+        std::uint64_t bytes_before = 0;  // vertex + index buffer
+        std::uint64_t bytes_after = 0;
+    };
+
+    class VertexQuantizer {
+    public:
+        // Re-encodes a Float32 mesh (with or without tangents) in place and sets its bounds to the exact
+        // vertex AABB. Returns false and leaves the mesh untouched for any other layout.
+        static bool Quantize(MeshData &mesh, QuantizationStats *stats = nullptr);
+
+        static QuantizedVertex Encode(const float position[3], const float normal[3], const float uv[2],
+                                      const DirectX::XMFLOAT3 &offset, const DirectX::XMFLOAT3 &inv_scale);
+
+        static void Decode(const QuantizedVertex &vertex, const DirectX::XMFLOAT3 &offset,
+                           const DirectX::XMFLOAT3 &scale, float position[3], float normal[3], float uv[2]);
+
+        // tangent is xyz plus the handedness in w; the handedness is stored in vertex.pw.
+        static QuantizedTangent EncodeTangent(const float tangent[4], QuantizedVertex &vertex);
+
+        static void DecodeTangent(const QuantizedTangent &encoded, const QuantizedVertex &vertex, float tangent[4]);
+
+        // Bytes per index of the GPU index buffer for a mesh with this many vertices.
+        static std::uint32_t IndexSize(std::uint32_t vertex_count) { return vertex_count < 0x10000u ? 2u : 4u; }
+    };
+}
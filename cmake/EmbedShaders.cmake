@@ -0,0 +1,107 @@
+# Ahead-of-time shader compilation. Every gfw_add_shader entry is compiled with DXC into a C header holding
+# its DXIL, and gfw_embed_shaders writes ShaderTable.inc, which framework/ShaderLibrary.cpp includes to look
+# the blobs up by file, entry point and defines. Only CMake and dxc are involved, so it runs on any host DXC
+# supports (Windows and Linux).
+
+set(GFW_SHADER_DIR "${CMAKE_CURRENT_LIST_DIR}/../shaders")
+cmake_path(NORMAL_PATH GFW_SHADER_DIR)
+set(GFW_SHADER_OUTPUT_DIR "${CMAKE_BINARY_DIR}/generated/shaders")
+
+set_property(GLOBAL PROPERTY GFW_SHADER_HEADERS "")
+set_property(GLOBAL PROPERTY GFW_SHADER_ENTRIES "")
+
+# Sets DXC_EXECUTABLE, or leaves it unset when no dxc is installed.
+function(gfw_find_dxc)
+    if (DXC_EXECUTABLE)
+        return()
+    endif ()
+    # Windows SDK, Vulkan SDK and distribution packages all ship a dxc binary.
+    set(hints "$ENV{VULKAN_SDK}/bin")
+    if (WIN32)
+        file(GLOB sdk_bins LIST_DIRECTORIES true "$ENV{ProgramFiles\(x86\)}/Windows Kits/10/bin/*/x64")
+        list(SORT sdk_bins ORDER DESCENDING)
+        list(APPEND hints ${sdk_bins})
+    endif ()
+    find_program(DXC_EXECUTABLE NAMES dxc HINTS ${hints})
+    if (DXC_EXECUTABLE)
+        message(STATUS "Compiling shaders with ${DXC_EXECUTABLE}")
+    endif ()
+endfunction()
+
+# gfw_add_shader(<file.hlsl> ENTRY <name> PROFILE <target> [DEFINES NAME=VALUE...])
+# DEFINES must be listed in the order the runtime passes them to LoadShader; they are part of the lookup key.
+function(gfw_add_shader file)
+    cmake_parse_arguments(ARG "" "ENTRY;PROFILE" "DEFINES" ${ARGN})
+    if (NOT ARG_ENTRY OR NOT ARG_PROFILE)
+        message(FATAL_ERROR "gfw_add_shader(${file}) needs ENTRY and PROFILE")
+    endif ()
+
+    cmake_path(GET file STEM stem)
+    string(JOIN "_" name ${stem} ${ARG_ENTRY} ${ARG_DEFINES})
+    string(MAKE_C_IDENTIFIER "g_${name}" symbol)
+    set(header "${GFW_SHADER_OUTPUT_DIR}/${symbol}.h")
+
+    set(define_args "")
+    foreach (define IN LISTS ARG_DEFINES)
+        list(APPEND define_args -D ${define})
+    endforeach ()
+
+    file(MAKE_DIRECTORY "${GFW_SHADER_OUTPUT_DIR}")
+    # Sources include each other freely, so any .hlsl change recompiles every entry.
+    file(GLOB shader_sources CONFIGURE_DEPENDS "${GFW_SHADER_DIR}/*.hlsl")
+    add_custom_command(
+            OUTPUT "${header}"
+            COMMAND "${DXC_EXECUTABLE}" -nologo -HV 2018 -T ${ARG_PROFILE} -E ${ARG_ENTRY} ${define_args}
+                    -I "${GFW_SHADER_DIR}" "$<IF:$<CONFIG:Debug>,-Od;-Zi;-Qembed_debug,-O3>"
+                    -Vn ${symbol} -Fh "${header}" "${GFW_SHADER_DIR}/${file}"
+            DEPENDS ${shader_sources}
+            COMMENT "DXC ${file}:${ARG_ENTRY} ${ARG_PROFILE} ${ARG_DEFINES}"
+            COMMAND_EXPAND_LISTS
+            VERBATIM)
+
+    string(JOIN ";" key_defines ${ARG_DEFINES})
+    set_property(GLOBAL APPEND PROPERTY GFW_SHADER_HEADERS "${header}")
+    set_property(GLOBAL APPEND_STRING PROPERTY GFW_SHADER_ENTRIES
+                 "    {\"${file}\", \"${ARG_ENTRY}\", \"${key_defines}\", ${symbol}, sizeof(${symbol})},\n")
+endfunction()
+
+# gfw_add_shader_permutations(<file.hlsl> ENTRY <name> PROFILE <target> FEATURES <DEFINE>...)
+# Adds one entry per subset of FEATURES, each define set to 1 and kept in the listed order.
+function(gfw_add_shader_permutations file)
+    cmake_parse_arguments(ARG "" "ENTRY;PROFILE" "FEATURES" ${ARGN})
+    list(LENGTH ARG_FEATURES feature_count)
+    math(EXPR subset_end "(1 << ${feature_count}) - 1")
+    foreach (subset RANGE ${subset_end})
+        set(defines "")
+        set(index 0)
+        foreach (feature IN LISTS ARG_FEATURES)
+            math(EXPR bit "(${subset} >> ${index}) & 1")
+            if (bit)
+                list(APPEND defines ${feature}=1)
+            endif ()
+            math(EXPR index "${index} + 1")
+        endforeach ()
+        gfw_add_shader(${file} ENTRY ${ARG_ENTRY} PROFILE ${ARG_PROFILE} DEFINES ${defines})
+    endforeach ()
+endfunction()
+
+# Writes ShaderTable.inc for every shader added so far and makes target build the headers first.
+function(gfw_embed_shaders target)
+    get_property(headers GLOBAL PROPERTY GFW_SHADER_HEADERS)
+    get_property(entries GLOBAL PROPERTY GFW_SHADER_ENTRIES)
+
+    set(content "// Generated by cmake/EmbedShaders.cmake from shaders/Shaders.cmake; do not edit.\n")
+    foreach (header IN LISTS headers)
+        cmake_path(GET header FILENAME header_name)
+        string(APPEND content "#include \"shaders/${header_name}\"\n")
+    endforeach ()
+    string(APPEND content "\nconst EmbeddedShader kEmbeddedShaders[] = {\n${entries}};\n")
+    file(CONFIGURE OUTPUT "${CMAKE_BINARY_DIR}/generated/ShaderTable.inc" CONTENT "${content}")
+
+    add_custom_target(${target}Shaders DEPENDS ${headers})
+    if (TARGET ${target})
+        add_dependencies(${target} ${target}Shaders)
+        target_include_directories(${target} PRIVATE "${CMAKE_BINARY_DIR}/generated")
+        target_compile_definitions(${target} PRIVATE GFW_EMBEDDED_SHADERS=1)
+    endif ()
+endfunction()
@@ -0,0 +1,361 @@
+#include "AssetStreamer.h"
+#include "D3D12CommandRecorder.h"
+#include "FrameworkInternal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <objbase.h>
+
+namespace gfw {
+
+bool AssetStreamer::Initialize(ID3D12Device *device, GpuMemoryAllocator *memory, std::uint64_t staging_capacity,
+                               TextureDecoder decoder) {
+    device_ = device;
+    memory_ = memory;
+    decoder_ = std::move(decoder);
+
+    D3D12_COMMAND_QUEUE_DESC queue_desc = {};
+    queue_desc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    queue_desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    if (detail::CheckFailed(device_->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&queue_)),
+                            L"Failed to create streaming Copy Queue!")) {
+        return false;
+    }
+    if (detail::CheckFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator_)),
+                            L"Failed to create streaming Command Allocator!")) {
+        return false;
+    }
+    if (detail::CheckFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, allocator_.Get(), nullptr,
+                                                       IID_PPV_ARGS(&command_list_)),
+                            L"Failed to create streaming Command List!")) {
+        return false;
+    }
+    command_list_->Close();
+
+    if (detail::CheckFailed(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)),
+                            L"Failed to create streaming Fence!")) {
+        return false;
+    }
+    fence_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!fence_event_) {
+        std::wcerr << L"Failed to create streaming Fence Event!" << std::endl;
+        return false;
+    }
+
+    const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    const D3D12_RESOURCE_DESC desc = detail::BufferDesc(staging_capacity);
+    if (detail::CheckFailed(device_->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc,
+                                                             D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                                             IID_PPV_ARGS(&staging_)),
+                            L"Failed to create streaming staging buffer!")) {
+        return false;
+    }
+    void *mapped = nullptr;
+    if (detail::CheckFailed(staging_->Map(0, nullptr, &mapped), L"Failed to map streaming staging buffer!")) {
+        return false;
+    }
+    staging_mapped_ = static_cast<std::uint8_t *>(mapped);
+    ring_ = RingAllocator(staging_capacity);
+
+    stop_ = false;
+    worker_ = std::thread(&AssetStreamer::WorkerMain, this);
+    return true;
+}
+
+void AssetStreamer::Shutdown() {
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            requests_.clear();
+        }
+        wake_.notify_all();
+        worker_.join();
+    }
+    if (fence_ && fence_event_) {
+        WaitForFence(last_signaled_);
+    }
+    if (fence_event_) {
+        CloseHandle(fence_event_);
+        fence_event_ = nullptr;
+    }
+    if (staging_) {
+        staging_->Unmap(0, nullptr);
+    }
+    staging_mapped_ = nullptr;
+    staging_.Reset();
+    for (PendingRelease &pending : oversized_) {
+        pending.buffer->Unmap(0, nullptr);
+    }
+    oversized_.clear();
+    batch_.clear();
+    completed_.clear();
+    command_list_.Reset();
+    allocator_.Reset();
+    fence_.Reset();
+    queue_.Reset();
+    ring_ = RingAllocator();
+    last_signaled_ = 0;
+    recording_ = false;
+    decoder_ = nullptr;
+    memory_ = nullptr;
+    device_ = nullptr;
+}
+
+void AssetStreamer::RequestTexture(const std::shared_ptr<Texture2D> &texture, const std::wstring &path) {
+    Request request;
+    request.texture = texture;
+    request.path = path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(std::move(request));
+    }
+    wake_.notify_one();
+}
+
+void AssetStreamer::RequestMesh(const std::shared_ptr<MeshBuffers> &mesh, std::vector<std::uint8_t> vertex_data,
+                                std::vector<std::uint8_t> index_data) {
+    Request request;
+    request.mesh = mesh;
+    request.vertex_data = std::move(vertex_data);
+    request.index_data = std::move(index_data);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(std::move(request));
+    }
+    wake_.notify_one();
+}
+
+void AssetStreamer::CollectCompleted(std::vector<Completion> &out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::move(completed_.begin(), completed_.end(), std::back_inserter(out));
+    completed_.clear();
+}
+
+AssetStreamer::Stats AssetStreamer::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void AssetStreamer::WorkerMain() {
+    // WIC decoding needs COM on this thread too.
+    const HRESULT co_hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    std::deque<Request> pending;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || !requests_.empty(); });
+            if (stop_) {
+                break;
+            }
+            pending.swap(requests_);
+        }
+        // Everything queued while the previous batch was recorded goes into one submission.
+        for (Request &request : pending) {
+            RecordRequest(request);
+        }
+        pending.clear();
+        SubmitBatch();
+    }
+
+    if (SUCCEEDED(co_hr)) {
+        CoUninitialize();
+    }
+}
+
+void AssetStreamer::RecordRequest(Request &request) {
+    if (const auto mesh = request.mesh.lock()) {
+        if (!RecordBuffer(FromHandle<ID3D12Resource>(mesh->vertex_buffer.value), request.vertex_data) ||
+            !RecordBuffer(FromHandle<ID3D12Resource>(mesh->index_buffer.value), request.index_data)) {
+            std::wcerr << L"Failed to stream mesh buffers!" << std::endl;
+            return;
+        }
+        Completion completion;
+        completion.mesh = mesh;
+        batch_.push_back(std::move(completion));
+        return;
+    }
+
+    if (request.texture.expired()) {
+        return; // dropped before the worker got to it
+    }
+    DecodedTexture image;
+    if (!decoder_ || !decoder_(request.path, image)) {
+        std::wcerr << L"Failed to stream texture: " << request.path << std::endl;
+        return;
+    }
+
+    // Created in COMMON: the copy queue promotes it to COPY_DEST and the frame's queue to a read state.
+    const D3D12_RESOURCE_DESC desc = detail::Texture2DDesc(image.width, image.height, DXGI_FORMAT_R8G8B8A8_UNORM);
+    ComPtr<ID3D12Resource> resource;
+    GpuAllocation memory;
+    if (!memory_->CreateResource(MemoryCategory::Texture, desc, D3D12_RESOURCE_STATE_COMMON, nullptr, memory,
+                                 resource)) {
+        std::wcerr << L"Failed to create streamed texture!" << std::endl;
+        return;
+    }
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    UINT num_rows = 0;
+    UINT64 row_size_in_bytes = 0;
+    UINT64 upload_size = 0;
+    device_->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, &num_rows, &row_size_in_bytes, &upload_size);
+
+    Staging staging;
+    if (!Reserve(upload_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, staging) || !BeginBatch()) {
+        memory_->Release(memory, 0); // never referenced by a command list
+        return;
+    }
+    const UINT src_row_pitch = image.width * 4;
+    for (UINT y = 0; y < image.height; ++y) {
+        std::memcpy(staging.cpu + static_cast<size_t>(y) * footprint.Footprint.RowPitch,
+                    image.rgba.data() + static_cast<size_t>(y) * src_row_pitch, src_row_pitch);
+    }
+    footprint.Offset = staging.offset;
+
+    D3D12_TEXTURE_COPY_LOCATION dst_location = {};
+    dst_location.pResource = resource.Get();
+    dst_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dst_location.SubresourceIndex = 0;
+
+    D3D12_TEXTURE_COPY_LOCATION src_location = {};
+    src_location.pResource = staging.buffer;
+    src_location.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    src_location.PlacedFootprint = footprint;
+
+    command_list_->CopyTextureRegion(&dst_location, 0, 0, 0, &src_location, nullptr);
+    batch_bytes_ += upload_size;
+
+    Completion completion;
+    completion.texture = request.texture;
+    completion.resource = std::move(resource);
+    completion.memory = memory;
+    batch_.push_back(std::move(completion));
+}
+
+bool AssetStreamer::RecordBuffer(ID3D12Resource *dst, const std::vector<std::uint8_t> &data) {
+    if (!dst || data.empty()) {
+        return true; // e.g. a mesh without indices
+    }
+    Staging staging;
+    if (!Reserve(data.size(), 16, staging) || !BeginBatch()) {
+        return false;
+    }
+    std::memcpy(staging.cpu, data.data(), data.size());
+    // No barriers: COPY lists can't issue them, and buffers promote from and decay to COMMON implicitly.
+    command_list_->CopyBufferRegion(dst, 0, staging.buffer, staging.offset, data.size());
+    batch_bytes_ += data.size();
+    return true;
+}
+
+void AssetStreamer::Retire() {
+    const std::uint64_t completed = fence_->GetCompletedValue();
+    ring_.Retire(completed);
+    oversized_.erase(std::remove_if(oversized_.begin(), oversized_.end(),
+                                    [&](PendingRelease &pending) {
+                                        if (pending.fence_value > completed) {
+                                            return false;
+                                        }
+                                        pending.buffer->Unmap(0, nullptr);
+                                        return true;
+                                    }),
+                     oversized_.end());
+}
+
+bool AssetStreamer::Reserve(std::uint64_t size, std::uint64_t alignment, Staging &out) {
+    if (size > ring_.Capacity()) {
+        const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+        const D3D12_RESOURCE_DESC desc = detail::BufferDesc(size);
+        PendingRelease pending;
+        if (detail::CheckFailed(device_->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc,
+                                                                 D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                                                 IID_PPV_ARGS(&pending.buffer)),
+                                L"Failed to create oversized streaming buffer!")) {
+            return false;
+        }
+        void *mapped = nullptr;
+        if (detail::CheckFailed(pending.buffer->Map(0, nullptr, &mapped), L"Failed to map oversized streaming buffer!")) {
+            return false;
+        }
+        pending.fence_value = last_signaled_ + 1;
+        out = {static_cast<std::uint8_t *>(mapped), pending.buffer.Get(), 0};
+        oversized_.push_back(std::move(pending));
+        return true;
+    }
+
+    Retire();
+    std::uint64_t offset = 0;
+    if (!ring_.Allocate(size, alignment, offset)) {
+        // The ring is full of this batch and earlier ones: submit and drain them, then start over.
+        SubmitBatch();
+        WaitForFence(last_signaled_);
+        Retire();
+        if (!ring_.Allocate(size, alignment, offset)) {
+            std::wcerr << L"Failed to reserve streaming staging memory!" << std::endl;
+            return false;
+        }
+    }
+    out = {staging_mapped_ + offset, staging_.Get(), offset};
+    return true;
+}
+
+bool AssetStreamer::BeginBatch() {
+    if (recording_) {
+        return true;
+    }
+    // One allocator is enough: batches are serialized on the copy queue and each one waits for its predecessor.
+    WaitForFence(last_signaled_);
+    if (FAILED(allocator_->Reset()) || FAILED(command_list_->Reset(allocator_.Get(), nullptr))) {
+        std::wcerr << L"Failed to reset streaming Command List!" << std::endl;
+        return false;
+    }
+    recording_ = true;
+    return true;
+}
+
+void AssetStreamer::SubmitBatch() {
+    if (!recording_) {
+        return;
+    }
+    recording_ = false;
+    if (FAILED(command_list_->Close())) {
+        std::wcerr << L"Failed to close streaming Command List!" << std::endl;
+        batch_.clear();
+        return;
+    }
+    ID3D12CommandList *lists[] = {command_list_.Get()};
+    queue_->ExecuteCommandLists(static_cast<UINT>(std::size(lists)), lists);
+
+    const std::uint64_t fence_value = ++last_signaled_;
+    if (FAILED(queue_->Signal(fence_.Get(), fence_value))) {
+        std::wcerr << L"Failed to signal streaming Fence!" << std::endl;
+    }
+    ring_.FinishFrame(fence_value);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.batches;
+    stats_.resources += batch_.size();
+    stats_.bytes += batch_bytes_;
+    stats_.last_resources = batch_.size();
+    stats_.last_bytes = batch_bytes_;
+    batch_bytes_ = 0;
+    for (Completion &completion : batch_) {
+        completion.fence_value = fence_value;
+        completed_.push_back(std::move(completion));
+    }
+    batch_.clear();
+}
+
+void AssetStreamer::WaitForFence(std::uint64_t value) {
+    if (fence_->GetCompletedValue() >= value) {
+        return;
+    }
+    if (FAILED(fence_->SetEventOnCompletion(value, fence_event_))) {
+        return;
+    }
+    WaitForSingleObject(fence_event_, INFINITE);
+}
+
+}
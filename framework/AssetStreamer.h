@@ -0,0 +1,145 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <windows.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameworkTypes.h"
+#include "GpuMemoryAllocator.h"
+#include "RingAllocator.h"
+
+namespace gfw {
+
+struct DecodedTexture {
+    UINT width = 0;
+    UINT height = 0;
+    std::vector<std::uint8_t> rgba;
+};
+
+// Background uploader on a COPY queue. A worker thread decodes requested files, records their copies into
+// one COPY command list per batch and signals a timeline fence, so streaming never touches the frame's
+// queue. Finished work is handed back through CollectCompleted on the render thread, which owns the
+// descriptor heap and the residency state of Texture2D and MeshBuffers.
+class AssetStreamer {
+public:
+    // Runs on the worker thread; returns false when the file cannot be decoded.
+    using TextureDecoder = std::function<bool(const std::wstring &path, DecodedTexture &out)>;
+
+    struct Completion {
+        std::weak_ptr<Texture2D> texture;
+        std::weak_ptr<MeshBuffers> mesh;
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource; // the created texture; null for meshes
+        GpuAllocation memory = {};
+        std::uint64_t fence_value = 0;
+    };
+
+    // Totals over every submitted batch, and the last one.
+    struct Stats {
+        std::uint64_t batches = 0;
+        std::uint64_t resources = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t last_resources = 0;
+        std::uint64_t last_bytes = 0;
+    };
+
+    AssetStreamer() = default;
+    ~AssetStreamer() { Shutdown(); }
+
+    AssetStreamer(const AssetStreamer &) = delete;
+    AssetStreamer &operator=(const AssetStreamer &) = delete;
+
+    // Streamed textures are placed into memory, which must outlive the streamer.
+    bool Initialize(ID3D12Device *device, GpuMemoryAllocator *memory, std::uint64_t staging_capacity,
+                    TextureDecoder decoder);
+
+    // Stops the worker after its current batch and waits for the copy queue to go idle.
+    void Shutdown();
+
+    // The texture's resource is created by the worker once the file is decoded.
+    void RequestTexture(const std::shared_ptr<Texture2D> &texture, const std::wstring &path);
+
+    // The mesh's DEFAULT-heap buffers must already exist; vertex_data and index_data are copied into them.
+    void RequestMesh(const std::shared_ptr<MeshBuffers> &mesh, std::vector<std::uint8_t> vertex_data,
+                     std::vector<std::uint8_t> index_data);
+
+    // Moves every batch submitted since the last call into out.
+    void CollectCompleted(std::vector<Completion> &out);
+
+    [[nodiscard]] ID3D12Fence *GetFence() const { return fence_.Get(); }
+    [[nodiscard]] std::uint64_t CompletedValue() const { return fence_ ? fence_->GetCompletedValue() : 0; }
+    [[nodiscard]] bool IsValid() const { return worker_.joinable(); }
+
+    // Safe to call from the render thread while the worker streams.
+    [[nodiscard]] Stats GetStats() const;
+
+private:
+    struct Request {
+        std::weak_ptr<Texture2D> texture;
+        std::wstring path;
+        std::weak_ptr<MeshBuffers> mesh;
+        std::vector<std::uint8_t> vertex_data;
+        std::vector<std::uint8_t> index_data;
+    };
+
+    struct Staging {
+        std::uint8_t *cpu = nullptr;
+        ID3D12Resource *buffer = nullptr;
+        std::uint64_t offset = 0;
+    };
+
+    struct PendingRelease {
+        Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+        std::uint64_t fence_value = 0;
+    };
+
+    void WorkerMain();
+    void RecordRequest(Request &request);
+    bool Reserve(std::uint64_t size, std::uint64_t alignment, Staging &out);
+    bool RecordBuffer(ID3D12Resource *dst, const std::vector<std::uint8_t> &data);
+    bool BeginBatch();
+    void SubmitBatch();
+    void Retire();
+    void WaitForFence(std::uint64_t value);
+
+    ID3D12Device *device_ = nullptr;
+    GpuMemoryAllocator *memory_ = nullptr;
+    TextureDecoder decoder_;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> queue_;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator_;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> command_list_;
+    Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+    HANDLE fence_event_ = nullptr;
+
+    // Worker-thread state.
+    std::uint64_t last_signaled_ = 0;
+    bool recording_ = false;
+    Microsoft::WRL::ComPtr<ID3D12Resource> staging_;
+    std::uint8_t *staging_mapped_ = nullptr;
+    RingAllocator ring_;
+    // Uploads larger than the ring get their own buffer, released when their batch completes.
+    std::vector<PendingRelease> oversized_;
+    std::vector<Completion> batch_;
+    std::uint64_t batch_bytes_ = 0;
+
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Request> requests_;
+    std::vector<Completion> completed_;
+    Stats stats_;
+    bool stop_ = false;
+};
+
+}
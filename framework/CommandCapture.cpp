@@ -0,0 +1,381 @@
+#include "CommandCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace gfw {
+
+namespace {
+    constexpr char kMagic[8] = {'G', 'F', 'W', 'C', 'A', 'P', '\0', '\0'};
+    constexpr std::uint32_t kVersion = 1;
+    // Barriers are replayed in batches of this size, like the D3D12 recorder submits them.
+    constexpr std::uint32_t kBarrierBatch = 16;
+
+    // File layout: header, ConstantBlock[constant_count], constant data padded to 8 bytes, stream bytes.
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t constant_count;
+        std::uint64_t constant_bytes;
+        std::uint64_t stream_bytes;
+        std::uint64_t file_size;
+        std::uint32_t handle_counts[8];
+    };
+    static_assert(sizeof(FileHeader) == 72);
+    static_assert(sizeof(CommandCapture::ConstantBlock) == 8);
+
+    template <typename T>
+    T ReadPayload(const void *payload) {
+        T value;
+        std::memcpy(&value, payload, sizeof(T));
+        return value;
+    }
+
+    // Payload size a packet of op has to have; 0 for Barriers, whose size is a multiple of the barrier size.
+    std::size_t PayloadSize(CommandOp op) {
+        switch (op) {
+            case CommandOp::Barriers: return 0;
+            case CommandOp::SetViewport: return sizeof(Viewport);
+            case CommandOp::SetScissor: return sizeof(ScissorRect);
+            case CommandOp::SetRenderTargets: return sizeof(CommandStream::RenderTargetsPacket);
+            case CommandOp::ClearRenderTarget: return sizeof(CommandStream::ClearRenderTargetPacket);
+            case CommandOp::ClearDepth: return sizeof(CommandStream::ClearDepthPacket);
+            case CommandOp::SetDescriptorHeap: return sizeof(DescriptorHeapHandle);
+            case CommandOp::SetRootSignature: return sizeof(RootSignatureHandle);
+            case CommandOp::SetPipeline: return sizeof(PipelineHandle);
+            case CommandOp::SetConstantBuffer:
+            case CommandOp::SetDescriptorTable: return sizeof(CommandStream::RootArgumentPacket);
+            case CommandOp::SetTopology: return sizeof(PrimitiveTopology);
+            case CommandOp::SetVertexBuffer: return sizeof(VertexBufferView);
+            case CommandOp::SetIndexBuffer: return sizeof(IndexBufferView);
+            case CommandOp::Draw:
+            case CommandOp::DrawIndexed: return sizeof(CommandStream::DrawPacket);
+            case CommandOp::Count: break;
+        }
+        return 0;
+    }
+}
+
+// Calls fn(kind, value) for every handle in a packet payload and writes the values back. SetConstantBuffer
+// is left to the caller, its value is either a constants index or a buffer address.
+template <typename Fn>
+void CommandCapture::VisitHandles(CommandOp op, std::uint8_t *payload, std::size_t size, Fn &&fn) {
+    auto visit = [&](auto packet, auto &&fields) {
+        std::memcpy(&packet, payload, sizeof(packet));
+        fields(packet);
+        std::memcpy(payload, &packet, sizeof(packet));
+    };
+    switch (op) {
+        case CommandOp::Barriers:
+            for (std::size_t offset = 0; offset + sizeof(ResourceBarrier) <= size; offset += sizeof(ResourceBarrier)) {
+                ResourceBarrier barrier = ReadPayload<ResourceBarrier>(payload + offset);
+                fn(Resource, barrier.resource.value);
+                std::memcpy(payload + offset, &barrier, sizeof(barrier));
+            }
+            break;
+        case CommandOp::SetRenderTargets:
+            visit(CommandStream::RenderTargetsPacket{}, [&](CommandStream::RenderTargetsPacket &packet) {
+                fn(CpuDescriptorKind, packet.dsv.value);
+                for (std::uint32_t i = 0; i < std::min(packet.count, CommandRecorder::kMaxRenderTargets); ++i) {
+                    fn(CpuDescriptorKind, packet.rtvs[i].value);
+                }
+            });
+            break;
+        case CommandOp::ClearRenderTarget:
+            visit(CommandStream::ClearRenderTargetPacket{},
+                  [&](CommandStream::ClearRenderTargetPacket &packet) { fn(CpuDescriptorKind, packet.rtv.value); });
+            break;
+        case CommandOp::ClearDepth:
+            visit(CommandStream::ClearDepthPacket{},
+                  [&](CommandStream::ClearDepthPacket &packet) { fn(CpuDescriptorKind, packet.dsv.value); });
+            break;
+        case CommandOp::SetDescriptorHeap:
+            visit(DescriptorHeapHandle{}, [&](DescriptorHeapHandle &heap) { fn(DescriptorHeap, heap.value); });
+            break;
+        case CommandOp::SetRootSignature:
+            visit(RootSignatureHandle{}, [&](RootSignatureHandle &signature) { fn(RootSignature, signature.value); });
+            break;
+        case CommandOp::SetPipeline:
+            visit(PipelineHandle{}, [&](PipelineHandle &pipeline) { fn(Pipeline, pipeline.value); });
+            break;
+        case CommandOp::SetDescriptorTable:
+            visit(CommandStream::RootArgumentPacket{},
+                  [&](CommandStream::RootArgumentPacket &packet) { fn(GpuDescriptorKind, packet.value); });
+            break;
+        case CommandOp::SetVertexBuffer:
+            visit(VertexBufferView{}, [&](VertexBufferView &view) { fn(BufferAddress, view.address); });
+            break;
+        case CommandOp::SetIndexBuffer:
+            visit(IndexBufferView{}, [&](IndexBufferView &view) { fn(BufferAddress, view.address); });
+            break;
+        default:
+            break;
+    }
+}
+
+void CommandCapture::Begin() {
+    stream_.Clear();
+    constant_blocks_.clear();
+    constant_data_.clear();
+    constant_indices_.clear();
+    handle_counts_ = {};
+    for (std::size_t kind = 0; kind < HandleKindCount; ++kind) {
+        handles_[kind].clear();
+        ids_[kind].clear();
+    }
+    live_ = false;
+}
+
+void CommandCapture::RecordConstants(GpuAddress address, const void *data, std::uint32_t size) {
+    const auto offset = static_cast<std::uint32_t>(constant_data_.size());
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    constant_data_.insert(constant_data_.end(), bytes, bytes + size);
+    constant_data_.resize(CommandStream::PaddedSize(constant_data_.size()), 0);
+    constant_indices_[address] = static_cast<std::uint32_t>(constant_blocks_.size());
+    constant_blocks_.push_back({offset, size});
+}
+
+std::uint64_t CommandCapture::Renumber(HandleKind kind, std::uint64_t handle) {
+    if (handle == 0) {
+        return 0;
+    }
+    const auto [it, inserted] = ids_[kind].try_emplace(handle, handles_[kind].size() + 1);
+    if (inserted) {
+        handles_[kind].push_back(handle);
+        ++handle_counts_[kind];
+    }
+    return it->second;
+}
+
+void CommandCapture::Finish(const CommandStream &frame) {
+    std::vector<std::uint8_t> payload;
+    frame.ForEach([&](CommandOp op, const void *data, std::size_t size) {
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        payload.assign(bytes, bytes + size);
+        if (op == CommandOp::SetConstantBuffer) {
+            auto packet = ReadPayload<CommandStream::RootArgumentPacket>(payload.data());
+            if (const auto it = constant_indices_.find(packet.value); it != constant_indices_.end()) {
+                packet.reserved = kCapturedConstants;
+                packet.value = it->second;
+            } else {
+                packet.value = Renumber(BufferAddress, packet.value);
+            }
+            std::memcpy(payload.data(), &packet, sizeof(packet));
+        } else {
+            VisitHandles(op, payload.data(), payload.size(),
+                         [&](HandleKind kind, std::uint64_t &value) { value = Renumber(kind, value); });
+        }
+        stream_.Append(op, payload.data(), payload.size());
+    });
+    constant_indices_.clear();
+    live_ = true;
+}
+
+bool CommandCapture::Validate() const {
+    bool valid = true;
+    std::vector<std::uint8_t> payload;
+    stream_.ForEach([&](CommandOp op, const void *data, std::size_t size) {
+        const std::size_t expected = PayloadSize(op);
+        if (expected != 0 ? size != expected : size % sizeof(ResourceBarrier) != 0) {
+            valid = false;
+            return;
+        }
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        payload.assign(bytes, bytes + size);
+        if (op == CommandOp::SetConstantBuffer) {
+            const auto packet = ReadPayload<CommandStream::RootArgumentPacket>(payload.data());
+            valid &= packet.reserved == kCapturedConstants ? packet.value < constant_blocks_.size()
+                                                           : packet.value <= handle_counts_[BufferAddress];
+        } else if (op == CommandOp::SetRenderTargets) {
+            valid &= ReadPayload<CommandStream::RenderTargetsPacket>(payload.data()).count <=
+                     CommandRecorder::kMaxRenderTargets;
+        }
+        VisitHandles(op, payload.data(), payload.size(),
+                     [&](HandleKind kind, std::uint64_t &value) { valid &= value <= handle_counts_[kind]; });
+    });
+    return valid;
+}
+
+bool CommandCapture::Save(const std::wstring &filename) const {
+    static_assert(HandleKindCount <= sizeof(FileHeader::handle_counts) / sizeof(std::uint32_t));
+    const std::size_t blocks_offset = sizeof(FileHeader);
+    const std::size_t data_offset = blocks_offset + constant_blocks_.size() * sizeof(ConstantBlock);
+    const std::size_t stream_offset = data_offset + constant_data_.size();
+
+    std::vector<char> data(stream_offset + stream_.SizeBytes(), 0);
+    FileHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.constant_count = static_cast<std::uint32_t>(constant_blocks_.size());
+    header.constant_bytes = constant_data_.size();
+    header.stream_bytes = stream_.SizeBytes();
+    header.file_size = data.size();
+    std::copy(handle_counts_.begin(), handle_counts_.end(), header.handle_counts);
+    std::memcpy(data.data(), &header, sizeof(header));
+    if (!constant_blocks_.empty()) {
+        std::memcpy(data.data() + blocks_offset, constant_blocks_.data(), constant_blocks_.size() * sizeof(ConstantBlock));
+    }
+    if (!constant_data_.empty()) {
+        std::memcpy(data.data() + data_offset, constant_data_.data(), constant_data_.size());
+    }
+    if (stream_.SizeBytes() > 0) {
+        std::memcpy(data.data() + stream_offset, stream_.Data(), stream_.SizeBytes());
+    }
+
+    std::ofstream out(std::filesystem::path(filename), std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+        std::wcerr << L"Failed to write frame capture: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CommandCapture::Load(const std::wstring &filename) {
+    Begin();
+
+    std::ifstream in(std::filesystem::path(filename), std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        std::wcerr << L"Failed to open frame capture: " << filename << std::endl;
+        return false;
+    }
+    const auto file_size = static_cast<std::size_t>(in.tellg());
+    std::vector<std::uint8_t> data(file_size);
+    in.seekg(0);
+    if (file_size < sizeof(FileHeader) ||
+        !in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(file_size))) {
+        std::wcerr << L"Failed to read frame capture: " << filename << std::endl;
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    const std::uint64_t blocks_bytes = static_cast<std::uint64_t>(header.constant_count) * sizeof(ConstantBlock);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.file_size != file_size || blocks_bytes > file_size || header.constant_bytes > file_size ||
+        header.stream_bytes > file_size ||
+        sizeof(FileHeader) + blocks_bytes + header.constant_bytes + header.stream_bytes != file_size) {
+        std::wcerr << L"Not a frame capture of this version: " << filename << std::endl;
+        return false;
+    }
+
+    const std::uint8_t *blocks = data.data() + sizeof(FileHeader);
+    const std::uint8_t *constants = blocks + blocks_bytes;
+    const std::uint8_t *stream = constants + header.constant_bytes;
+    constant_blocks_.resize(header.constant_count);
+    if (!constant_blocks_.empty()) {
+        std::memcpy(constant_blocks_.data(), blocks, blocks_bytes);
+    }
+    constant_data_.assign(constants, constants + header.constant_bytes);
+    std::copy_n(header.handle_counts, handle_counts_.size(), handle_counts_.begin());
+
+    const bool blocks_valid = std::all_of(constant_blocks_.begin(), constant_blocks_.end(), [&](const ConstantBlock &block) {
+        return block.offset <= constant_data_.size() && block.size <= constant_data_.size() - block.offset;
+    });
+    if (!blocks_valid || !stream_.Assign(stream, header.stream_bytes) || !Validate()) {
+        std::wcerr << L"Corrupt frame capture: " << filename << std::endl;
+        Begin();
+        return false;
+    }
+    return true;
+}
+
+void CommandCapture::Replay(CommandRecorder &recorder, const std::vector<GpuAddress> &constants) const {
+    stream_.ForEach([&](CommandOp op, const void *data, std::size_t size) {
+        const auto *payload = static_cast<const std::uint8_t *>(data);
+        switch (op) {
+            case CommandOp::Barriers: {
+                ResourceBarrier batch[kBarrierBatch];
+                const auto count = static_cast<std::uint32_t>(size / sizeof(ResourceBarrier));
+                for (std::uint32_t first = 0; first < count; first += kBarrierBatch) {
+                    const std::uint32_t batch_count = std::min(kBarrierBatch, count - first);
+                    std::memcpy(batch, payload + first * sizeof(ResourceBarrier), batch_count * sizeof(ResourceBarrier));
+                    for (std::uint32_t i = 0; i < batch_count; ++i) {
+                        batch[i].resource.value = Resolve(Resource, batch[i].resource.value);
+                    }
+                    recorder.Barriers(batch, batch_count);
+                }
+                break;
+            }
+            case CommandOp::SetViewport:
+                recorder.SetViewport(ReadPayload<Viewport>(payload));
+                break;
+            case CommandOp::SetScissor:
+                recorder.SetScissor(ReadPayload<ScissorRect>(payload));
+                break;
+            case CommandOp::SetRenderTargets: {
+                auto packet = ReadPayload<CommandStream::RenderTargetsPacket>(payload);
+                for (std::uint32_t i = 0; i < packet.count; ++i) {
+                    packet.rtvs[i].value = Resolve(CpuDescriptorKind, packet.rtvs[i].value);
+                }
+                recorder.SetRenderTargets(packet.rtvs, packet.count,
+                                          CpuDescriptor{Resolve(CpuDescriptorKind, packet.dsv.value)});
+                break;
+            }
+            case CommandOp::ClearRenderTarget: {
+                const auto packet = ReadPayload<CommandStream::ClearRenderTargetPacket>(payload);
+                recorder.ClearRenderTarget(CpuDescriptor{Resolve(CpuDescriptorKind, packet.rtv.value)}, packet.color);
+                break;
+            }
+            case CommandOp::ClearDepth: {
+                const auto packet = ReadPayload<CommandStream::ClearDepthPacket>(payload);
+                recorder.ClearDepth(CpuDescriptor{Resolve(CpuDescriptorKind, packet.dsv.value)}, packet.depth);
+                break;
+            }
+            case CommandOp::SetDescriptorHeap:
+                recorder.SetDescriptorHeap(
+                    DescriptorHeapHandle{Resolve(DescriptorHeap, ReadPayload<DescriptorHeapHandle>(payload).value)});
+                break;
+            case CommandOp::SetRootSignature:
+                recorder.SetRootSignature(
+                    RootSignatureHandle{Resolve(RootSignature, ReadPayload<RootSignatureHandle>(payload).value)});
+                break;
+            case CommandOp::SetPipeline:
+                recorder.SetPipeline(PipelineHandle{Resolve(Pipeline, ReadPayload<PipelineHandle>(payload).value)});
+                break;
+            case CommandOp::SetConstantBuffer: {
+                const auto packet = ReadPayload<CommandStream::RootArgumentPacket>(payload);
+                recorder.SetConstantBuffer(packet.slot, packet.reserved == kCapturedConstants
+                                                            ? constants[packet.value]
+                                                            : Resolve(BufferAddress, packet.value));
+                break;
+            }
+            case CommandOp::SetDescriptorTable: {
+                const auto packet = ReadPayload<CommandStream::RootArgumentPacket>(payload);
+                recorder.SetDescriptorTable(packet.slot, GpuDescriptor{Resolve(GpuDescriptorKind, packet.value)});
+                break;
+            }
+            case CommandOp::SetTopology:
+                recorder.SetTopology(ReadPayload<PrimitiveTopology>(payload));
+                break;
+            case CommandOp::SetVertexBuffer: {
+                auto view = ReadPayload<VertexBufferView>(payload);
+                view.address = Resolve(BufferAddress, view.address);
+                recorder.SetVertexBuffer(view);
+                break;
+            }
+            case CommandOp::SetIndexBuffer: {
+                auto view = ReadPayload<IndexBufferView>(payload);
+                view.address = Resolve(BufferAddress, view.address);
+                recorder.SetIndexBuffer(view);
+                break;
+            }
+            case CommandOp::Draw: {
+                const auto packet = ReadPayload<CommandStream::DrawPacket>(payload);
+                recorder.Draw(packet.count, packet.first);
+                break;
+            }
+            case CommandOp::DrawIndexed: {
+                const auto packet = ReadPayload<CommandStream::DrawPacket>(payload);
+                recorder.DrawIndexed(packet.count, packet.first, packet.base_vertex);
+                break;
+            }
+            case CommandOp::Count:
+                break;
+        }
+    });
+}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CommandRecorder.h"
+#include "NullRenderBackend.h"
+
+namespace gfw {
+
+// One frame of recorded commands plus the contents of every constant buffer uploaded for it, as written to and
+// read from a .gfwcap file. Finish renumbers handles in order of first use and turns constant buffer addresses
+// into indices of the captured constants, so capturing the same frame twice gives the same bytes. The original
+// handles are kept only in memory: a capture is live in the process that recorded it and can be replayed on
+// D3D12 there, while a loaded one replays with the renumbered handles, which only a null target accepts.
+class CommandCapture {
+public:
+    struct ConstantBlock {
+        std::uint32_t offset; // into the constant data
+        std::uint32_t size;
+    };
+
+    // Starts a new capture; the previous one is dropped.
+    void Begin();
+
+    // Copies the contents of a constant buffer uploaded for the frame being captured.
+    void RecordConstants(GpuAddress address, const void *data, std::uint32_t size);
+
+    // Takes the frame's commands; RecordConstants has to have seen every upload they bind.
+    void Finish(const CommandStream &frame);
+
+    bool Save(const std::wstring &filename) const;
+    bool Load(const std::wstring &filename);
+
+    // Re-records the frame into recorder. constants[i] is where the caller placed ConstantData(i) for this
+    // replay, e.g. a fresh upload ring slice; it needs ConstantCount() entries.
+    void Replay(CommandRecorder &recorder, const std::vector<GpuAddress> &constants) const;
+
+    [[nodiscard]] bool IsLive() const { return live_; }
+    [[nodiscard]] bool IsEmpty() const { return stream_.CommandCount() == 0; }
+    [[nodiscard]] const CommandStream &Stream() const { return stream_; }
+
+    [[nodiscard]] std::size_t ConstantCount() const { return constant_blocks_.size(); }
+    [[nodiscard]] std::size_t ConstantBytes() const { return constant_data_.size(); }
+    [[nodiscard]] const std::uint8_t *ConstantData(std::size_t index) const {
+        return constant_data_.data() + constant_blocks_[index].offset;
+    }
+    [[nodiscard]] std::uint32_t ConstantSize(std::size_t index) const { return constant_blocks_[index].size; }
+
+    // Distinct pipelines and root signatures the frame binds.
+    [[nodiscard]] std::size_t PipelineCount() const { return handle_counts_[Pipeline]; }
+    [[nodiscard]] std::size_t RootSignatureCount() const { return handle_counts_[RootSignature]; }
+
+private:
+    enum HandleKind : std::uint32_t {
+        Pipeline,
+        RootSignature,
+        DescriptorHeap,
+        Resource,
+        CpuDescriptorKind,
+        GpuDescriptorKind,
+        BufferAddress, // vertex, index and constant buffers that were not uploaded during the capture
+        HandleKindCount
+    };
+
+    // RootArgumentPacket::reserved of a SetConstantBuffer whose value is a constants index, not a handle.
+    static constexpr std::uint32_t kCapturedConstants = 1;
+
+    // Captured id (1-based, 0 stays null) from an original handle, and back.
+    std::uint64_t Renumber(HandleKind kind, std::uint64_t handle);
+    [[nodiscard]] std::uint64_t Resolve(HandleKind kind, std::uint64_t id) const {
+        return live_ && id != 0 ? handles_[kind][id - 1] : id;
+    }
+
+    // Calls fn(kind, value) on every handle of a packet payload except SetConstantBuffer's.
+    template <typename Fn>
+    static void VisitHandles(CommandOp op, std::uint8_t *payload, std::size_t size, Fn &&fn);
+
+    // Checks every payload size, constants index and handle id of a loaded stream.
+    [[nodiscard]] bool Validate() const;
+
+    CommandStream stream_;
+    std::vector<ConstantBlock> constant_blocks_;
+    std::vector<std::uint8_t> constant_data_;
+    std::unordered_map<GpuAddress, std::uint32_t> constant_indices_;
+    std::array<std::uint32_t, HandleKindCount> handle_counts_ = {};
+    // Live captures only: original handles by kind, indexed by id - 1, and the reverse lookup Finish builds.
+    std::array<std::vector<std::uint64_t>, HandleKindCount> handles_;
+    std::array<std::unordered_map<std::uint64_t, std::uint64_t>, HandleKindCount> ids_;
+    bool live_ = false;
+};
+
+}
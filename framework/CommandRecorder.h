@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gfw {
+
+enum class RenderBackend : std::uint32_t {
+    D3D12, // records into ID3D12GraphicsCommandLists and presents to a window
+    Null   // records into in-memory CommandStreams; no window, no submission (see NullRenderBackend.h)
+};
+
+// Opaque backend object. The D3D12 backend stores the interface pointer, descriptor handle or GPU virtual
+// address in value (see D3D12CommandRecorder.h); the null backend only records it.
+template <typename Tag>
+struct RenderHandle {
+    std::uint64_t value = 0;
+
+    explicit operator bool() const { return value != 0; }
+    bool operator==(const RenderHandle &other) const = default;
+};
+
+using PipelineHandle = RenderHandle<struct PipelineTag>;
+using RootSignatureHandle = RenderHandle<struct RootSignatureTag>;
+using DescriptorHeapHandle = RenderHandle<struct DescriptorHeapTag>;
+using ResourceHandle = RenderHandle<struct ResourceTag>;
+using CpuDescriptor = RenderHandle<struct CpuDescriptorTag>;
+using GpuDescriptor = RenderHandle<struct GpuDescriptorTag>;
+using GpuAddress = std::uint64_t;
+
+// Values match D3D_PRIMITIVE_TOPOLOGY.
+enum class PrimitiveTopology : std::uint32_t {
+    Undefined = 0,
+    PointList = 1,
+    LineList = 2,
+    LineStrip = 3,
+    TriangleList = 4,
+    TriangleStrip = 5,
+    PatchList3 = 35
+};
+
+enum class IndexFormat : std::uint32_t { Uint16, Uint32 };
+
+// The resource states the renderer transitions between.
+enum class ResourceState : std::uint32_t { Present, RenderTarget, PixelShaderResource, DepthWrite };
+
+// Everything below has a fixed layout without implicit padding, so a recorded stream is plain bytes.
+struct Viewport {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    float min_depth = 0.0f;
+    float max_depth = 1.0f;
+};
+
+struct ScissorRect {
+    std::int32_t left = 0;
+    std::int32_t top = 0;
+    std::int32_t right = 0;
+    std::int32_t bottom = 0;
+};
+
+struct VertexBufferView {
+    GpuAddress address = 0;
+    std::uint32_t size = 0;
+    std::uint32_t stride = 0;
+};
+
+struct IndexBufferView {
+    GpuAddress address = 0;
+    std::uint32_t size = 0;
+    IndexFormat format = IndexFormat::Uint32;
+};
+
+struct ResourceBarrier {
+    ResourceHandle resource;
+    ResourceState before = ResourceState::Present;
+    ResourceState after = ResourceState::Present;
+};
+
+// Graphics command recording, the part of the render hardware interface the frame loop runs through. One
+// recorder is used by one thread at a time; root parameter slots follow the bound root signature.
+class CommandRecorder {
+public:
+    static constexpr std::uint32_t kMaxRenderTargets = 8;
+
+    virtual ~CommandRecorder() = default;
+
+    [[nodiscard]] virtual RenderBackend Backend() const = 0;
+
+    virtual void Barriers(const ResourceBarrier *barriers, std::uint32_t count) = 0;
+    virtual void SetViewport(const Viewport &viewport) = 0;
+    virtual void SetScissor(const ScissorRect &scissor) = 0;
+    // A null dsv binds no depth target.
+    virtual void SetRenderTargets(const CpuDescriptor *rtvs, std::uint32_t count, CpuDescriptor dsv) = 0;
+    virtual void ClearRenderTarget(CpuDescriptor rtv, const float color[4]) = 0;
+    virtual void ClearDepth(CpuDescriptor dsv, float depth) = 0;
+
+    virtual void SetDescriptorHeap(DescriptorHeapHandle heap) = 0;
+    virtual void SetRootSignature(RootSignatureHandle root_signature) = 0;
+    virtual void SetPipeline(PipelineHandle pipeline) = 0;
+    virtual void SetConstantBuffer(std::uint32_t slot, GpuAddress address) = 0;
+    virtual void SetDescriptorTable(std::uint32_t slot, GpuDescriptor table) = 0;
+
+    virtual void SetTopology(PrimitiveTopology topology) = 0;
+    virtual void SetVertexBuffer(const VertexBufferView &view) = 0;
+    virtual void SetIndexBuffer(const IndexBufferView &view) = 0;
+    virtual void Draw(std::uint32_t vertex_count, std::uint32_t first_vertex) = 0;
+    virtual void DrawIndexed(std::uint32_t index_count, std::uint32_t first_index, std::int32_t base_vertex) = 0;
+
+    void Barrier(ResourceHandle resource, ResourceState before, ResourceState after) {
+        const ResourceBarrier barrier = {resource, before, after};
+        Barriers(&barrier, 1);
+    }
+};
+
+}
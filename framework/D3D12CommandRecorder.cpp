@@ -0,0 +1,190 @@
+#include "D3D12CommandRecorder.h"
+#include "FrameworkInternal.h"
+
+#include <algorithm>
+#include <array>
+
+namespace gfw {
+namespace {
+    static_assert(static_cast<UINT>(PrimitiveTopology::TriangleList) == D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    static_assert(static_cast<UINT>(PrimitiveTopology::PatchList3) == D3D_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
+    // Barrier batches larger than this are split.
+    constexpr std::uint32_t kMaxBarrierBatch = 16;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE ToD3D12(CpuDescriptor handle) {
+        return {static_cast<SIZE_T>(handle.value)};
+    }
+}
+
+void D3D12CommandRecorder::Barriers(const ResourceBarrier *barriers, std::uint32_t count) {
+    if (capture_) {
+        capture_->Barriers(barriers, count);
+    }
+    std::array<D3D12_RESOURCE_BARRIER, kMaxBarrierBatch> batch = {};
+    for (std::uint32_t begin = 0; begin < count; begin += kMaxBarrierBatch) {
+        const std::uint32_t size = std::min(kMaxBarrierBatch, count - begin);
+        for (std::uint32_t i = 0; i < size; ++i) {
+            const ResourceBarrier &barrier = barriers[begin + i];
+            batch[i] = detail::TransitionBarrier(FromHandle<ID3D12Resource>(barrier.resource.value),
+                                                 ToD3D12(barrier.before), ToD3D12(barrier.after));
+        }
+        list_->ResourceBarrier(size, batch.data());
+    }
+}
+
+void D3D12CommandRecorder::SetViewport(const Viewport &viewport) {
+    if (capture_) {
+        capture_->SetViewport(viewport);
+    }
+    const D3D12_VIEWPORT d3d_viewport = {viewport.x, viewport.y, viewport.width, viewport.height,
+                                         viewport.min_depth, viewport.max_depth};
+    list_->RSSetViewports(1, &d3d_viewport);
+}
+
+void D3D12CommandRecorder::SetScissor(const ScissorRect &scissor) {
+    if (capture_) {
+        capture_->SetScissor(scissor);
+    }
+    const D3D12_RECT rect = {scissor.left, scissor.top, scissor.right, scissor.bottom};
+    list_->RSSetScissorRects(1, &rect);
+}
+
+void D3D12CommandRecorder::SetRenderTargets(const CpuDescriptor *rtvs, std::uint32_t count, CpuDescriptor dsv) {
+    if (capture_) {
+        capture_->SetRenderTargets(rtvs, count, dsv);
+    }
+    std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kMaxRenderTargets> handles = {};
+    count = std::min(count, kMaxRenderTargets);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        handles[i] = ToD3D12(rtvs[i]);
+    }
+    const D3D12_CPU_DESCRIPTOR_HANDLE depth = ToD3D12(dsv);
+    list_->OMSetRenderTargets(count, handles.data(), FALSE, dsv ? &depth : nullptr);
+}
+
+void D3D12CommandRecorder::ClearRenderTarget(CpuDescriptor rtv, const float color[4]) {
+    if (capture_) {
+        capture_->ClearRenderTarget(rtv, color);
+    }
+    list_->ClearRenderTargetView(ToD3D12(rtv), color, 0, nullptr);
+}
+
+void D3D12CommandRecorder::ClearDepth(CpuDescriptor dsv, float depth) {
+    if (capture_) {
+        capture_->ClearDepth(dsv, depth);
+    }
+    list_->ClearDepthStencilView(ToD3D12(dsv), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void D3D12CommandRecorder::SetDescriptorHeap(DescriptorHeapHandle heap) {
+    if (capture_) {
+        capture_->SetDescriptorHeap(heap);
+    }
+    ID3D12DescriptorHeap *heaps[] = {FromHandle<ID3D12DescriptorHeap>(heap.value)};
+    list_->SetDescriptorHeaps(1, heaps);
+}
+
+void D3D12CommandRecorder::SetRootSignature(RootSignatureHandle root_signature) {
+    if (capture_) {
+        capture_->SetRootSignature(root_signature);
+    }
+    list_->SetGraphicsRootSignature(FromHandle<ID3D12RootSignature>(root_signature.value));
+}
+
+void D3D12CommandRecorder::SetPipeline(PipelineHandle pipeline) {
+    if (capture_) {
+        capture_->SetPipeline(pipeline);
+    }
+    list_->SetPipelineState(FromHandle<ID3D12PipelineState>(pipeline.value));
+}
+
+void D3D12CommandRecorder::SetConstantBuffer(std::uint32_t slot, GpuAddress address) {
+    if (capture_) {
+        capture_->SetConstantBuffer(slot, address);
+    }
+    list_->SetGraphicsRootConstantBufferView(slot, address);
+}
+
+void D3D12CommandRecorder::SetDescriptorTable(std::uint32_t slot, GpuDescriptor table) {
+    if (capture_) {
+        capture_->SetDescriptorTable(slot, table);
+    }
+    list_->SetGraphicsRootDescriptorTable(slot, D3D12_GPU_DESCRIPTOR_HANDLE{table.value});
+}
+
+void D3D12CommandRecorder::SetTopology(PrimitiveTopology topology) {
+    if (capture_) {
+        capture_->SetTopology(topology);
+    }
+    list_->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+void D3D12CommandRecorder::SetVertexBuffer(const VertexBufferView &view) {
+    if (capture_) {
+        capture_->SetVertexBuffer(view);
+    }
+    const D3D12_VERTEX_BUFFER_VIEW d3d_view = {view.address, view.size, view.stride};
+    list_->IASetVertexBuffers(0, 1, &d3d_view);
+}
+
+void D3D12CommandRecorder::SetIndexBuffer(const IndexBufferView &view) {
+    if (capture_) {
+        capture_->SetIndexBuffer(view);
+    }
+    const D3D12_INDEX_BUFFER_VIEW d3d_view = {
+        view.address, view.size, view.format == IndexFormat::Uint16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT};
+    list_->IASetIndexBuffer(&d3d_view);
+}
+
+void D3D12CommandRecorder::Draw(std::uint32_t vertex_count, std::uint32_t first_vertex) {
+    if (capture_) {
+        capture_->Draw(vertex_count, first_vertex);
+    }
+    list_->DrawInstanced(vertex_count, 1, first_vertex, 0);
+}
+
+void D3D12CommandRecorder::DrawIndexed(std::uint32_t index_count, std::uint32_t first_index, std::int32_t base_vertex) {
+    if (capture_) {
+        capture_->DrawIndexed(index_count, first_index, base_vertex);
+    }
+    list_->DrawIndexedInstanced(index_count, 1, first_index, base_vertex, 0);
+}
+
+bool D3D12CommandList::Initialize(ID3D12Device *device, std::uint32_t frame_slots) {
+    allocators_.resize(std::max(1u, frame_slots));
+    for (auto &allocator : allocators_) {
+        if (detail::CheckFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)),
+                                L"Failed to create worker Command Allocator!")) {
+            return false;
+        }
+    }
+    if (detail::CheckFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocators_[0].Get(), nullptr,
+                                                      IID_PPV_ARGS(&list_)),
+                            L"Failed to create worker Command List!")) {
+        return false;
+    }
+    list_->Close();
+    recorder_.Bind(list_.Get());
+    return true;
+}
+
+bool D3D12CommandList::Begin(std::uint32_t slot) {
+    capture_stream_.Stream().Clear();
+    recorder_.SetCapture(capture_ ? &capture_stream_ : nullptr);
+    ID3D12CommandAllocator *allocator = allocators_[slot % allocators_.size()].Get();
+    if (FAILED(allocator->Reset()) || FAILED(list_->Reset(allocator, nullptr))) {
+        std::wcerr << L"Failed to reset worker Command List!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool D3D12CommandList::Close() {
+    if (FAILED(list_->Close())) {
+        std::wcerr << L"Failed to close worker Command List!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <vector>
+#include "CommandRecorder.h"
+#include "NullRenderBackend.h"
+#include "RenderDevice.h"
+
+namespace gfw {
+
+// RenderHandles of D3D12 objects: interface pointers and descriptor handles as integers.
+inline PipelineHandle ToHandle(ID3D12PipelineState *pipeline) {
+    return PipelineHandle{reinterpret_cast<std::uintptr_t>(pipeline)};
+}
+inline RootSignatureHandle ToHandle(ID3D12RootSignature *root_signature) {
+    return RootSignatureHandle{reinterpret_cast<std::uintptr_t>(root_signature)};
+}
+inline DescriptorHeapHandle ToHandle(ID3D12DescriptorHeap *heap) {
+    return DescriptorHeapHandle{reinterpret_cast<std::uintptr_t>(heap)};
+}
+inline ResourceHandle ToHandle(ID3D12Resource *resource) {
+    return ResourceHandle{reinterpret_cast<std::uintptr_t>(resource)};
+}
+inline CpuDescriptor ToHandle(D3D12_CPU_DESCRIPTOR_HANDLE handle) { return CpuDescriptor{handle.ptr}; }
+inline GpuDescriptor ToHandle(D3D12_GPU_DESCRIPTOR_HANDLE handle) { return GpuDescriptor{handle.ptr}; }
+
+// The D3D12 object behind a handle; Framework hands out interface pointers as handle values.
+template <typename T>
+T *FromHandle(std::uint64_t value) {
+    return reinterpret_cast<T *>(static_cast<std::uintptr_t>(value));
+}
+
+inline D3D12_RESOURCE_STATES ToD3D12(ResourceState state) {
+    switch (state) {
+        case ResourceState::RenderTarget:
+            return D3D12_RESOURCE_STATE_RENDER_TARGET;
+        case ResourceState::PixelShaderResource:
+            return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        case ResourceState::DepthWrite:
+            return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+        case ResourceState::Present:
+        default:
+            return D3D12_RESOURCE_STATE_PRESENT;
+    }
+}
+
+inline DXGI_FORMAT ToD3D12(Format format) {
+    switch (format) {
+        case Format::R8G8B8A8Unorm:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case Format::R16G16B16A16Float:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case Format::R16G16B16A16Unorm:
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case Format::R16G16Float:
+            return DXGI_FORMAT_R16G16_FLOAT;
+        case Format::R16G16Snorm:
+            return DXGI_FORMAT_R16G16_SNORM;
+        case Format::R32G32Float:
+            return DXGI_FORMAT_R32G32_FLOAT;
+        case Format::R32G32B32Float:
+            return DXGI_FORMAT_R32G32B32_FLOAT;
+        case Format::R32G32B32A32Float:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case Format::D32Float:
+            return DXGI_FORMAT_D32_FLOAT;
+        case Format::Unknown:
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+// The D3D12 backend: forwards every command to the bound command list. Bind again whenever the caller moves
+// on to another list (e.g. the next segment after Framework::InsertCommandLists). While a capture list is set,
+// every command is also recorded into it (see CommandCapture).
+class D3D12CommandRecorder final : public CommandRecorder {
+public:
+    void Bind(ID3D12GraphicsCommandList *list) { list_ = list; }
+    [[nodiscard]] ID3D12GraphicsCommandList *GetList() const { return list_; }
+
+    void SetCapture(RecordingCommandList *capture) { capture_ = capture; }
+    [[nodiscard]] RecordingCommandList *GetCapture() const { return capture_; }
+
+    [[nodiscard]] RenderBackend Backend() const override { return RenderBackend::D3D12; }
+
+    void Barriers(const ResourceBarrier *barriers, std::uint32_t count) override;
+    void SetViewport(const Viewport &viewport) override;
+    void SetScissor(const ScissorRect &scissor) override;
+    void SetRenderTargets(const CpuDescriptor *rtvs, std::uint32_t count, CpuDescriptor dsv) override;
+    void ClearRenderTarget(CpuDescriptor rtv, const float color[4]) override;
+    void ClearDepth(CpuDescriptor dsv, float depth) override;
+    void SetDescriptorHeap(DescriptorHeapHandle heap) override;
+    void SetRootSignature(RootSignatureHandle root_signature) override;
+    void SetPipeline(PipelineHandle pipeline) override;
+    void SetConstantBuffer(std::uint32_t slot, GpuAddress address) override;
+    void SetDescriptorTable(std::uint32_t slot, GpuDescriptor table) override;
+    void SetTopology(PrimitiveTopology topology) override;
+    void SetVertexBuffer(const VertexBufferView &view) override;
+    void SetIndexBuffer(const IndexBufferView &view) override;
+    void Draw(std::uint32_t vertex_count, std::uint32_t first_vertex) override;
+    void DrawIndexed(std::uint32_t index_count, std::uint32_t first_index, std::int32_t base_vertex) override;
+
+private:
+    ID3D12GraphicsCommandList *list_ = nullptr;
+    RecordingCommandList *capture_ = nullptr;
+};
+
+// Framework's DeviceCommandList: a direct command list with one allocator per frame slot, recorded through a
+// D3D12CommandRecorder. With capture on, Begin also points the recorder at a stream Framework::InsertCommandLists
+// appends to the frame capture.
+class D3D12CommandList final : public DeviceCommandList {
+public:
+    bool Initialize(ID3D12Device *device, std::uint32_t frame_slots);
+
+    bool Begin(std::uint32_t slot) override;
+    bool Close() override;
+    [[nodiscard]] CommandRecorder &Recorder() override { return recorder_; }
+    void SetCapture(bool capture) override { capture_ = capture; }
+
+private:
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> allocators_;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> list_;
+    D3D12CommandRecorder recorder_;
+    RecordingCommandList capture_stream_;
+    bool capture_ = false;
+};
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace gfw {
+
+// Slot in a descriptor heap. The generation changes every time the slot is released, so a handle kept
+// after its texture was freed is detected as stale instead of silently aliasing the slot's next owner.
+struct DescriptorHandle {
+    static constexpr std::uint32_t kInvalidIndex = 0xffffffffu;
+
+    std::uint32_t index = kInvalidIndex;
+    std::uint32_t generation = 0;
+
+    [[nodiscard]] bool IsValid() const { return index != kInvalidIndex; }
+};
+
+// Free-list bookkeeping for descriptor heap slots. Released slots are only reused once the fence value
+// passed to Release has completed, because in-flight command lists may still read them. Pure logic so it
+// can be driven by any fence, real or fake.
+class DescriptorAllocator {
+public:
+    DescriptorAllocator() = default;
+
+    explicit DescriptorAllocator(std::uint32_t capacity) { Grow(capacity); }
+
+    // Returns false when every slot is live or pending; the caller grows the heap and retries.
+    bool Allocate(DescriptorHandle &out) {
+        if (free_.empty()) {
+            return false;
+        }
+        const std::uint32_t index = free_.back();
+        free_.pop_back();
+        slots_[index].live = true;
+        out = {index, slots_[index].generation};
+        ++live_count_;
+        return true;
+    }
+
+    // Invalidates the handle now and recycles its slot once fence_value has completed.
+    bool Release(const DescriptorHandle &handle, std::uint64_t fence_value) {
+        if (!IsAlive(handle)) {
+            return false;
+        }
+        Slot &slot = slots_[handle.index];
+        slot.live = false;
+        ++slot.generation;
+        --live_count_;
+        pending_.push_back({fence_value, handle.index});
+        return true;
+    }
+
+    void Retire(std::uint64_t completed_fence_value) {
+        while (!pending_.empty() && pending_.front().fence_value <= completed_fence_value) {
+            free_.push_back(pending_.front().index);
+            pending_.pop_front();
+        }
+    }
+
+    // Adds slots [Capacity(), capacity) to the free list; existing handles stay valid.
+    void Grow(std::uint32_t capacity) {
+        const auto old_capacity = static_cast<std::uint32_t>(slots_.size());
+        if (capacity <= old_capacity) {
+            return;
+        }
+        slots_.resize(capacity);
+        // Pushed in reverse so fresh slots are handed out in ascending order.
+        for (std::uint32_t i = capacity; i > old_capacity; --i) {
+            free_.push_back(i - 1);
+        }
+    }
+
+    [[nodiscard]] bool IsAlive(const DescriptorHandle &handle) const {
+        return handle.index < slots_.size() && slots_[handle.index].live &&
+               slots_[handle.index].generation == handle.generation;
+    }
+
+    [[nodiscard]] std::uint32_t Capacity() const { return static_cast<std::uint32_t>(slots_.size()); }
+    [[nodiscard]] std::uint32_t LiveCount() const { return live_count_; }
+    [[nodiscard]] std::size_t PendingCount() const { return pending_.size(); }
+
+private:
+    struct Slot {
+        std::uint32_t generation = 0;
+        bool live = false;
+    };
+
+    struct Pending {
+        std::uint64_t fence_value;
+        std::uint32_t index;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<std::uint32_t> free_;
+    std::deque<Pending> pending_;
+    std::uint32_t live_count_ = 0;
+};
+
+}
@@ -0,0 +1,97 @@
+#include "DescriptorHeap.h"
+#include "FrameworkInternal.h"
+
+#include <algorithm>
+
+namespace gfw {
+
+bool DescriptorHeap::Initialize(ID3D12Device *device, D3D12_DESCRIPTOR_HEAP_TYPE type, std::uint32_t capacity) {
+    device_ = device;
+    type_ = type;
+    descriptor_size_ = device_->GetDescriptorHandleIncrementSize(type_);
+    return Grow(capacity, 0);
+}
+
+void DescriptorHeap::Shutdown() {
+    retired_.clear();
+    shader_visible_.Reset();
+    staging_.Reset();
+    allocator_ = DescriptorAllocator();
+    device_ = nullptr;
+}
+
+bool DescriptorHeap::Grow(std::uint32_t capacity, std::uint64_t pending_fence_value) {
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.Type = type_;
+    desc.NumDescriptors = capacity;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    desc.NodeMask = 0;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> staging;
+    if (detail::CheckFailed(device_->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&staging)),
+                            L"Failed to create staging descriptor heap!")) {
+        return false;
+    }
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> shader_visible;
+    if (detail::CheckFailed(device_->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&shader_visible)),
+                            L"Failed to create shader-visible descriptor heap!")) {
+        return false;
+    }
+
+    const std::uint32_t old_capacity = allocator_.Capacity();
+    if (old_capacity > 0) {
+        device_->CopyDescriptorsSimple(old_capacity, staging->GetCPUDescriptorHandleForHeapStart(),
+                                       staging_->GetCPUDescriptorHandleForHeapStart(), type_);
+        device_->CopyDescriptorsSimple(old_capacity, shader_visible->GetCPUDescriptorHandleForHeapStart(),
+                                       staging->GetCPUDescriptorHandleForHeapStart(), type_);
+        retired_.push_back({shader_visible_, pending_fence_value});
+        std::wcout << L"Descriptor heap grown from " << old_capacity << L" to " << capacity << L" descriptors" << std::endl;
+    }
+    staging_ = staging;
+    shader_visible_ = shader_visible;
+    allocator_.Grow(capacity);
+    return true;
+}
+
+bool DescriptorHeap::Allocate(DescriptorHandle &out, std::uint64_t pending_fence_value) {
+    if (!shader_visible_) {
+        return false;
+    }
+    if (allocator_.Allocate(out)) {
+        return true;
+    }
+    return Grow(std::max(allocator_.Capacity() * 2, 1u), pending_fence_value) && allocator_.Allocate(out);
+}
+
+void DescriptorHeap::Release(const DescriptorHandle &handle, std::uint64_t pending_fence_value) {
+    allocator_.Release(handle, pending_fence_value);
+}
+
+void DescriptorHeap::Retire(std::uint64_t completed_fence_value) {
+    allocator_.Retire(completed_fence_value);
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [&](const RetiredHeap &retired) {
+                                      return retired.fence_value <= completed_fence_value;
+                                  }),
+                   retired_.end());
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::StagingHandle(const DescriptorHandle &handle) const {
+    D3D12_CPU_DESCRIPTOR_HANDLE cpu = staging_->GetCPUDescriptorHandleForHeapStart();
+    cpu.ptr += static_cast<SIZE_T>(handle.index) * descriptor_size_;
+    return cpu;
+}
+
+void DescriptorHeap::Publish(const DescriptorHandle &handle) {
+    D3D12_CPU_DESCRIPTOR_HANDLE dst = shader_visible_->GetCPUDescriptorHandleForHeapStart();
+    dst.ptr += static_cast<SIZE_T>(handle.index) * descriptor_size_;
+    device_->CopyDescriptorsSimple(1, dst, StagingHandle(handle), type_);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::GpuHandle(const DescriptorHandle &handle) const {
+    D3D12_GPU_DESCRIPTOR_HANDLE gpu = shader_visible_->GetGPUDescriptorHandleForHeapStart();
+    gpu.ptr += static_cast<UINT64>(handle.index) * descriptor_size_;
+    return gpu;
+}
+
+}
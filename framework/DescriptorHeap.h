@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include "DescriptorAllocator.h"
+
+namespace gfw {
+
+// Growable descriptor heap pair: views are written into a CPU-only staging heap and copied into the
+// shader-visible heap, which can then be bound once as a bindless table. When the allocator runs out of
+// slots both heaps are recreated at twice the size; the staging heap is the source for that copy because
+// shader-visible heaps must not be read by the CPU.
+class DescriptorHeap {
+public:
+    DescriptorHeap() = default;
+    ~DescriptorHeap() { Shutdown(); }
+
+    DescriptorHeap(const DescriptorHeap &) = delete;
+    DescriptorHeap &operator=(const DescriptorHeap &) = delete;
+
+    bool Initialize(ID3D12Device *device, D3D12_DESCRIPTOR_HEAP_TYPE type, std::uint32_t capacity);
+
+    void Shutdown();
+
+    // pending_fence_value is the fence value that retires the command lists recorded so far; a heap
+    // replaced by growth is kept alive until it completes.
+    bool Allocate(DescriptorHandle &out, std::uint64_t pending_fence_value);
+
+    // The slot is reused once pending_fence_value has completed.
+    void Release(const DescriptorHandle &handle, std::uint64_t pending_fence_value);
+
+    void Retire(std::uint64_t completed_fence_value);
+
+    // Write the view here, then Publish it to the shader-visible heap.
+    [[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE StagingHandle(const DescriptorHandle &handle) const;
+
+    void Publish(const DescriptorHandle &handle);
+
+    // Only valid until the next growth; store the handle, not this.
+    [[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GpuHandle(const DescriptorHandle &handle) const;
+
+    [[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GpuStart() const { return shader_visible_->GetGPUDescriptorHandleForHeapStart(); }
+    [[nodiscard]] ID3D12DescriptorHeap *ShaderVisibleHeap() const { return shader_visible_.Get(); }
+    [[nodiscard]] bool IsAlive(const DescriptorHandle &handle) const { return allocator_.IsAlive(handle); }
+    [[nodiscard]] bool IsValid() const { return shader_visible_ != nullptr; }
+    [[nodiscard]] std::uint32_t Capacity() const { return allocator_.Capacity(); }
+    [[nodiscard]] std::uint32_t LiveCount() const { return allocator_.LiveCount(); }
+    [[nodiscard]] UINT DescriptorSize() const { return descriptor_size_; }
+
+private:
+    struct RetiredHeap {
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+        std::uint64_t fence_value = 0;
+    };
+
+    bool Grow(std::uint32_t capacity, std::uint64_t pending_fence_value);
+
+    ID3D12Device *device_ = nullptr;
+    D3D12_DESCRIPTOR_HEAP_TYPE type_ = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    UINT descriptor_size_ = 0;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> staging_;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> shader_visible_;
+    DescriptorAllocator allocator_;
+    std::vector<RetiredHeap> retired_;
+};
+
+}
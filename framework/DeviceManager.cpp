@@ -34,6 +34,15 @@ bool DeviceManager::Initialize() {
         return false;
     }
 
+    DXGI_ADAPTER_DESC1 adapter_desc = {};
+    hardwareAdapter->GetDesc1(&adapter_desc);
+    adapter_identity_ = {adapter_desc.VendorId, adapter_desc.DeviceId, adapter_desc.SubSysId, adapter_desc.Revision, 0};
+    // The user-mode driver version; DXGI only reports it through the IDXGIDevice interface check.
+    LARGE_INTEGER umd_version = {};
+    if (SUCCEEDED(hardwareAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umd_version))) {
+        adapter_identity_.driver_version = static_cast<std::uint64_t>(umd_version.QuadPart);
+    }
+
     hr = D3D12CreateDevice(
         hardwareAdapter.Get(),
         D3D_FEATURE_LEVEL_11_0,
@@ -4,6 +4,7 @@
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include "FrameworkInternal.h"
+#include "PipelineCache.h"
 
 namespace gfw {
 
@@ -24,10 +25,14 @@ public:
     // Check if the device is valid
     bool IsValid() const { return device_ != nullptr; }
 
+    // Adapter and user-mode driver the device runs on; cached driver blobs are only valid for this identity.
+    const AdapterIdentity &GetAdapterIdentity() const { return adapter_identity_; }
+
 private:
     static Microsoft::WRL::ComPtr<IDXGIAdapter1> GetHardwareAdapter(IDXGIFactory1* pFactory);
     Microsoft::WRL::ComPtr<IDXGIFactory4> factory_;
     Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    AdapterIdentity adapter_identity_ = {};
 };
 
 } // namespace gfw
\ No newline at end of file
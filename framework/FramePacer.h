@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace gfw {
+
+// CPU side of N-frames-in-flight pacing on one queue and one fence. Each back buffer slot remembers the fence
+// value its last frame signalled; before a slot is recorded into again only that value has to complete, so the
+// CPU can run up to frames_in_flight - 1 frames ahead of the GPU instead of draining it every frame. Also keeps
+// a rolling frame timeline (CPU time, time blocked on the fence, GPU lag). Pure logic so it can be driven by
+// any fence, real or simulated.
+class FramePacer {
+public:
+    static constexpr std::uint32_t kMinFramesInFlight = 2;
+    static constexpr std::uint32_t kMaxFramesInFlight = 4;
+
+    struct Timeline {
+        double cpu_frame_ms = 0.0;    // BeginFrame to BeginFrame
+        double fence_wait_ms = 0.0;   // time BeginFrame blocked on the slot's fence
+        double frames_in_flight = 0.0; // submitted but not completed frames when a new one begins
+        std::uint64_t frame_count = 0;
+
+        // Fraction of CPU frame time not spent waiting for the GPU; 1 means full overlap.
+        [[nodiscard]] double Overlap() const {
+            return cpu_frame_ms > 0.0 ? 1.0 - std::min(fence_wait_ms / cpu_frame_ms, 1.0) : 0.0;
+        }
+    };
+
+    FramePacer() = default;
+
+    explicit FramePacer(std::uint32_t frames_in_flight)
+        : frames_in_flight_(std::clamp(frames_in_flight, kMinFramesInFlight, kMaxFramesInFlight)) {}
+
+    // Fence value that has to complete before slot can be recorded into again; 0 when it was never used.
+    [[nodiscard]] std::uint64_t WaitValue(std::uint32_t slot) const { return slot_fence_values_[slot]; }
+
+    // Value the next Signal will use, i.e. the one that retires the frame being recorded.
+    [[nodiscard]] std::uint64_t PendingFenceValue() const { return next_fence_value_; }
+
+    // Returns the value to Signal after the frame recorded into slot was submitted.
+    std::uint64_t EndFrame(std::uint32_t slot) {
+        slot_fence_values_[slot] = next_fence_value_;
+        return ClaimFenceValue();
+    }
+
+    // Returns a value to Signal outside of a frame, e.g. to drain the queue before shutdown.
+    std::uint64_t ClaimFenceValue() { return next_fence_value_++; }
+
+    // Folds one frame into the timeline; completed_fence_value is sampled after the slot wait.
+    void RecordFrame(double cpu_frame_ms, double fence_wait_ms, std::uint64_t completed_fence_value) {
+        const std::uint64_t submitted = next_fence_value_ - 1;
+        const double in_flight = submitted > completed_fence_value ? static_cast<double>(submitted - completed_fence_value) : 0.0;
+        // Exponential moving average: recent enough to react, smooth enough to read.
+        const double weight = timeline_.frame_count == 0 ? 1.0 : kTimelineWeight;
+        timeline_.cpu_frame_ms += (cpu_frame_ms - timeline_.cpu_frame_ms) * weight;
+        timeline_.fence_wait_ms += (fence_wait_ms - timeline_.fence_wait_ms) * weight;
+        timeline_.frames_in_flight += (in_flight - timeline_.frames_in_flight) * weight;
+        ++timeline_.frame_count;
+    }
+
+    [[nodiscard]] const Timeline &GetTimeline() const { return timeline_; }
+    [[nodiscard]] std::uint32_t FramesInFlight() const { return frames_in_flight_; }
+
+private:
+    static constexpr double kTimelineWeight = 0.05;
+
+    std::uint32_t frames_in_flight_ = kMinFramesInFlight;
+    std::uint64_t next_fence_value_ = 1;
+    std::array<std::uint64_t, kMaxFramesInFlight> slot_fence_values_ = {};
+    Timeline timeline_;
+};
+
+}
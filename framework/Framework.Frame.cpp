@@ -1,13 +1,58 @@
 #include "Framework.h"
 #include "FrameworkInternal.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iterator>
+#include <utility>
 
 namespace gfw {
+    namespace {
+        double ElapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        }
+    }
+
     void Framework::BeginFrame() {
-        WaitForPreviousFrame();
+        // Copies queued since the last frame run on the same queue ahead of this frame's command list.
+        uploads_.Flush();
 
         frame_index_ = swap_chain_->GetCurrentBackBufferIndex();
+        // Only the frame that last used this back buffer and allocator has to be finished; the others
+        // keep the GPU busy while this one is recorded.
+        const auto frame_start = std::chrono::steady_clock::now();
+        WaitForFence(pacer_.WaitValue(frame_index_));
+        const auto wait_end = std::chrono::steady_clock::now();
+        const UINT64 completed = fence_->GetCompletedValue();
+        if (frame_start_ != std::chrono::steady_clock::time_point{}) {
+            pacer_.RecordFrame(ElapsedMs(frame_start_, frame_start), ElapsedMs(frame_start, wait_end), completed);
+        }
+        frame_start_ = frame_start;
+
+        upload_ring_.Retire(completed);
+        srv_descriptors_.Retire(completed);
+        memory_.Retire(completed);
+        {
+            std::lock_guard lock(objects_mutex_);
+            released_resources_.erase(std::remove_if(released_resources_.begin(), released_resources_.end(),
+                                                      [&](const auto &released) { return released.first <= completed; }),
+                                       released_resources_.end());
+        }
+        stream_timeline_.BeginFrame(streamer_.CompletedValue());
+        ProcessStreamingCompletions();
+
+        capturing_ = capture_requested_;
+        capture_requested_ = false;
+        if (capturing_) {
+            capture_.Begin();
+            capture_list_.Stream().Clear();
+        }
+        d3d12_recorder_.SetCapture(capturing_ ? &capture_list_ : nullptr);
+
+        command_list_segment_ = 0;
+        command_list_ = command_list_segments_[0];
+        d3d12_recorder_.Bind(command_list_.Get());
+        frame_submission_.clear();
 
         if (FAILED(command_allocator_[frame_index_]->Reset())) {
             std::wcerr << L"Failed to reset Command Allocator!" << std::endl;
@@ -19,69 +64,176 @@ namespace gfw {
             return;
         }
 
-        const auto barrier = detail::TransitionBarrier(
-                render_targets_[frame_index_].Get(),
-                D3D12_RESOURCE_STATE_PRESENT,
-                D3D12_RESOURCE_STATE_RENDER_TARGET);
-        command_list_->ResourceBarrier(1, &barrier);
-
-        command_list_->RSSetViewports(1, &viewport_);
-        command_list_->RSSetScissorRects(1, &scissor_rect_);
+        CommandRecorder &cmd = GetRecorder();
+        cmd.Barrier(ToHandle(render_targets_[frame_index_].Get()), ResourceState::Present, ResourceState::RenderTarget);
+        cmd.SetViewport(viewport_);
+        cmd.SetScissor(scissor_rect_);
     }
 
     void Framework::ClearRenderTarget(float r, float g, float b, float a) {
-        D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = rtv_heap_->GetCPUDescriptorHandleForHeapStart();
-        rtv_handle.ptr += frame_index_ * rtv_descriptor_size_;
-
-        D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle = {};
-        if (dsv_heap_) {
-            dsv_handle = dsv_heap_->GetCPUDescriptorHandleForHeapStart();
-            command_list_->OMSetRenderTargets(1, &rtv_handle, FALSE, &dsv_handle);
-        } else {
-            command_list_->OMSetRenderTargets(1, &rtv_handle, FALSE, nullptr);
-        }
+        CommandRecorder &cmd = GetRecorder();
+        const CpuDescriptor rtv_handle = GetBackBufferRtv();
+        const CpuDescriptor dsv_handle = GetDepthDsv();
+        cmd.SetRenderTargets(&rtv_handle, 1, dsv_handle);
 
         const float clear_color[] = {r, g, b, a};
-        command_list_->ClearRenderTargetView(rtv_handle, clear_color, 0, nullptr);
+        cmd.ClearRenderTarget(rtv_handle, clear_color);
 
-        if (dsv_heap_) {
-            command_list_->ClearDepthStencilView(dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+        if (dsv_handle) {
+            cmd.ClearDepth(dsv_handle, 1.0f);
         }
     }
 
     void Framework::EndFrame() {
-        const auto barrier = detail::TransitionBarrier(
-                render_targets_[frame_index_].Get(),
-                D3D12_RESOURCE_STATE_RENDER_TARGET,
-                D3D12_RESOURCE_STATE_PRESENT);
-        command_list_->ResourceBarrier(1, &barrier);
+        GetRecorder().Barrier(ToHandle(render_targets_[frame_index_].Get()), ResourceState::RenderTarget,
+                              ResourceState::Present);
+        if (capturing_) {
+            FinishCapture();
+        }
 
         if (FAILED(command_list_->Close())) {
             std::wcerr << L"Failed to close Command List!" << std::endl;
             return;
         }
 
-        ID3D12CommandList *command_lists[] = {command_list_.Get()};
-        command_queue_->ExecuteCommandLists(static_cast<UINT>(std::size(command_lists)), command_lists);
+        // GPU-side wait, and only up to the newest streamed copy this frame referenced.
+        if (const UINT64 stream_wait = stream_timeline_.WaitValue()) {
+            command_queue_->Wait(streamer_.GetFence(), stream_wait);
+        }
+        frame_submission_.push_back(command_list_.Get());
+        command_queue_->ExecuteCommandLists(static_cast<UINT>(frame_submission_.size()), frame_submission_.data());
+        // The pending fence value marks this frame's constants as consumed.
+        upload_ring_.FinishFrame(pacer_.PendingFenceValue());
 
         if (FAILED(swap_chain_->Present(1, 0))) {
             std::wcerr << L"Failed to present SwapChain!" << std::endl;
         }
+        if (FAILED(command_queue_->Signal(fence_.Get(), pacer_.EndFrame(frame_index_)))) {
+            std::wcerr << L"Failed to signal frame Fence!" << std::endl;
+        }
     }
 
-    void Framework::WaitForPreviousFrame() {
-        const UINT64 fence = fence_value_;
-        if (FAILED(command_queue_->Signal(fence_.Get(), fence))) {
-            return;
+    bool Framework::InsertCommandLists(const std::vector<CommandRecorder *> &lists) {
+        for (const CommandRecorder *list : lists) {
+            if (list->Backend() != RenderBackend::D3D12) {
+                std::wcerr << L"InsertCommandLists: list was recorded for another backend!" << std::endl;
+                return false;
+            }
         }
-        fence_value_++;
 
-        if (fence_->GetCompletedValue() < fence) {
-            if (FAILED(fence_->SetEventOnCompletion(fence, fence_event_))) {
-                return;
+        if (FAILED(command_list_->Close())) {
+            std::wcerr << L"Failed to close Command List segment!" << std::endl;
+            return false;
+        }
+        frame_submission_.push_back(command_list_.Get());
+        for (CommandRecorder *list : lists) {
+            const auto *recorder = static_cast<D3D12CommandRecorder *>(list);
+            frame_submission_.push_back(recorder->GetList());
+            if (capturing_ && recorder->GetCapture()) {
+                capture_list_.Stream().Append(recorder->GetCapture()->Stream());
             }
-            WaitForSingleObject(fence_event_, INFINITE);
         }
+
+        ID3D12CommandAllocator *allocator = command_allocator_[frame_index_].Get();
+        if (++command_list_segment_ == command_list_segments_.size()) {
+            ComPtr<ID3D12GraphicsCommandList> segment;
+            if (detail::CheckFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator, nullptr,
+                                                               IID_PPV_ARGS(&segment)),
+                                    L"Failed to create Command List segment!")) {
+                return false;
+            }
+            command_list_segments_.push_back(segment);
+        } else if (FAILED(command_list_segments_[command_list_segment_]->Reset(allocator, nullptr))) {
+            std::wcerr << L"Failed to reset Command List segment!" << std::endl;
+            return false;
+        }
+        command_list_ = command_list_segments_[command_list_segment_];
+        d3d12_recorder_.Bind(command_list_.Get());
+        d3d12_recorder_.SetViewport(viewport_);
+        d3d12_recorder_.SetScissor(scissor_rect_);
+        return true;
+    }
+
+    std::unique_ptr<DeviceCommandList> Framework::CreateCommandList(std::uint32_t frame_slots) {
+        auto list = std::make_unique<D3D12CommandList>();
+        if (!list->Initialize(device_.Get(), frame_slots)) {
+            return nullptr;
+        }
+        return list;
+    }
+
+    void Framework::FinishCapture() {
+        capturing_ = false;
+        d3d12_recorder_.SetCapture(nullptr);
+        capture_.Finish(capture_list_.Stream());
+        capture_list_.Stream().Clear();
+
+        const CommandStream &stream = capture_.Stream();
+        std::wcout << L"Captured frame: " << stream.CommandCount() << L" commands, " << stream.DrawCount()
+                   << L" draws, " << capture_.PipelineCount() << L" pipelines, " << capture_.ConstantCount()
+                   << L" constant buffers (" << capture_.ConstantBytes() / 1024 << L" KB)" << std::endl;
+        if (!capture_path_.empty() && capture_.Save(capture_path_)) {
+            std::wcout << L"Wrote frame capture " << capture_path_ << std::endl;
+        }
+    }
+
+    bool Framework::ReplayCapture(const CommandCapture &capture, UINT iterations) {
+        if (!capture.IsLive()) {
+            std::wcerr << L"ReplayCapture: a loaded capture has no live handles; replay it with CaptureReplay."
+                       << std::endl;
+            return false;
+        }
+        // Every frame has finished, so the captured back buffer is in the state the capture starts from.
+        WaitForFence(pacer_.PendingFenceValue() - 1);
+
+        std::vector<GpuAddress> constants(capture.ConstantCount());
+        for (UINT iteration = 0; iteration < iterations; ++iteration) {
+            const UINT slot = iteration % pacer_.FramesInFlight();
+            WaitForFence(pacer_.WaitValue(slot));
+            upload_ring_.Retire(fence_->GetCompletedValue());
+            for (size_t i = 0; i < constants.size(); ++i) {
+                constants[i] = UploadConstants(capture.ConstantData(i), capture.ConstantSize(i));
+            }
+
+            ID3D12GraphicsCommandList *list = command_list_segments_[0].Get();
+            if (FAILED(command_allocator_[slot]->Reset()) || FAILED(list->Reset(command_allocator_[slot].Get(), nullptr))) {
+                std::wcerr << L"ReplayCapture: failed to reset Command List!" << std::endl;
+                return false;
+            }
+            d3d12_recorder_.Bind(list);
+            capture.Replay(d3d12_recorder_, constants);
+            if (FAILED(list->Close())) {
+                std::wcerr << L"ReplayCapture: failed to close Command List!" << std::endl;
+                return false;
+            }
+            ID3D12CommandList *lists[] = {list};
+            command_queue_->ExecuteCommandLists(1, lists);
+            upload_ring_.FinishFrame(pacer_.PendingFenceValue());
+            if (FAILED(command_queue_->Signal(fence_.Get(), pacer_.EndFrame(slot)))) {
+                std::wcerr << L"ReplayCapture: failed to signal frame Fence!" << std::endl;
+                return false;
+            }
+        }
+        WaitForFence(pacer_.PendingFenceValue() - 1);
+        return true;
+    }
+
+    void Framework::WaitForFence(UINT64 value) {
+        if (fence_->GetCompletedValue() >= value) {
+            return;
+        }
+        if (FAILED(fence_->SetEventOnCompletion(value, fence_event_))) {
+            return;
+        }
+        WaitForSingleObject(fence_event_, INFINITE);
+    }
+
+    void Framework::WaitForGpu() {
+        const UINT64 value = pacer_.ClaimFenceValue();
+        if (FAILED(command_queue_->Signal(fence_.Get(), value))) {
+            return;
+        }
+        WaitForFence(value);
     }
 }
 
@@ -12,13 +12,17 @@ namespace gfw {
         Shutdown();
     }
 
-bool Framework::Initialize(Window *window) {
+bool Framework::Initialize(Window *window, UINT frames_in_flight) {
         if (!window) {
             std::wcerr << L"Framework::Initialize: Window pointer is null!" << std::endl;
             return false;
         }
 
         window_ = window;
+        width_ = window->GetWidth();
+        height_ = window->GetHeight();
+        pacer_ = FramePacer(frames_in_flight);
+        const UINT frame_count = pacer_.FramesInFlight();
 
         HRESULT co_hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
         if (SUCCEEDED(co_hr)) {
@@ -36,6 +40,10 @@ bool Framework::Initialize(Window *window) {
         factory_ = device_manager_.GetFactory();
         device_ = device_manager_.GetDevice();
 
+        if (pipeline_cache_.Load(kPipelineCacheFile, device_manager_.GetAdapterIdentity())) {
+            std::wcout << L"Pipeline cache: " << pipeline_cache_.Size() << L" pipelines" << std::endl;
+        }
+
         D3D12_COMMAND_QUEUE_DESC queue_desc = {};
         queue_desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
         queue_desc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
@@ -43,76 +51,39 @@ bool Framework::Initialize(Window *window) {
         if (detail::CheckFailed(device_->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&command_queue_)), L"Failed to create Command Queue!"))
             return false;
 
-        DXGI_SWAP_CHAIN_DESC1 swap_chain_desc = {};
-        swap_chain_desc.BufferCount = FRAME_COUNT;
-        swap_chain_desc.Width = window_->GetWidth();
-        swap_chain_desc.Height = window_->GetHeight();
-        swap_chain_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        swap_chain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-        swap_chain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-        swap_chain_desc.SampleDesc.Count = 1;
-
-        ComPtr<IDXGISwapChain1> swap_chain1;
-        if (detail::CheckFailed(factory_->CreateSwapChainForHwnd(
-                command_queue_.Get(), window_->GetHandle(), &swap_chain_desc, nullptr, nullptr, &swap_chain1), L"Failed to create SwapChain!"))
-            return false;
-        if (detail::CheckFailed(swap_chain1.As(&swap_chain_), L"Failed to query SwapChain3!"))
-            return false;
-
-        if (FAILED(factory_->MakeWindowAssociation(window_->GetHandle(), DXGI_MWA_NO_ALT_ENTER))) {
-            std::wcerr << L"Warning: Failed to disable Alt+Enter!" << std::endl;
+        for (UINT type = 0; type < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++type) {
+            descriptor_sizes_[type] =
+                device_->GetDescriptorHandleIncrementSize(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(type));
         }
 
-        frame_index_ = swap_chain_->GetCurrentBackBufferIndex();
-
-        D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
-        rtv_heap_desc.NumDescriptors = FRAME_COUNT;
-        rtv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-        rtv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-
-        if (detail::CheckFailed(device_->CreateDescriptorHeap(&rtv_heap_desc, IID_PPV_ARGS(&rtv_heap_)), L"Failed to create RTV Descriptor Heap!"))
+        if (!CreateBackBuffers(frame_count)) {
             return false;
-
-        rtv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-        D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = rtv_heap_->GetCPUDescriptorHandleForHeapStart();
-        render_targets_.resize(FRAME_COUNT);
-
-        for (UINT n = 0; n < FRAME_COUNT; n++) {
-            if (detail::CheckFailed(swap_chain_->GetBuffer(n, IID_PPV_ARGS(&render_targets_[n])), L"Failed to get SwapChain buffer!"))
-                return false;
-            device_->CreateRenderTargetView(render_targets_[n].Get(), nullptr, rtv_handle);
-            rtv_handle.ptr += rtv_descriptor_size_;
         }
 
-        for (UINT n = 0; n < FRAME_COUNT; n++) {
+        for (UINT n = 0; n < frame_count; n++) {
             if (detail::CheckFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocator_[n])), L"Failed to create Command Allocator!"))
                 return false;
         }
         if (detail::CheckFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocator_[frame_index_].Get(), nullptr, IID_PPV_ARGS(&command_list_)), L"Failed to create Command List!"))
             return false;
         command_list_->Close();
+        command_list_segments_.push_back(command_list_);
+        d3d12_recorder_.Bind(command_list_.Get());
 
         if (detail::CheckFailed(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)), L"Failed to create Fence!"))
             return false;
-        fence_value_ = 1;
         fence_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
         if (!fence_event_) {
             std::wcerr << L"Failed to create Fence Event!" << std::endl;
             return false;
         }
 
-        viewport_.TopLeftX = 0.0f;
-        viewport_.TopLeftY = 0.0f;
-        viewport_.Width = static_cast<float>(window_->GetWidth());
-        viewport_.Height = static_cast<float>(window_->GetHeight());
-        viewport_.MinDepth = 0.0f;
-        viewport_.MaxDepth = 1.0f;
+        viewport_ = {0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_), 0.0f, 1.0f};
+        scissor_rect_ = {0, 0, static_cast<std::int32_t>(width_), static_cast<std::int32_t>(height_)};
 
-        scissor_rect_.left = 0;
-        scissor_rect_.top = 0;
-        scissor_rect_.right = static_cast<LONG>(window_->GetWidth());
-        scissor_rect_.bottom = static_cast<LONG>(window_->GetHeight());
+        if (!memory_.Initialize(device_.Get(), kGpuMemoryBlockSize)) {
+            return false;
+        }
 
         if (!CreateDepthResources()) {
             return false;
@@ -122,14 +93,19 @@ bool Framework::Initialize(Window *window) {
             return false;
         }
 
-        if (!CreateConstantBuffer()) {
+        if (!upload_ring_.Initialize(device_.Get(), kUploadRingSize)) {
+            return false;
+        }
+
+        if (!uploads_.Initialize(device_.Get(), command_queue_.Get(), kUploadStagingSize)) {
             return false;
         }
 
-        srv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        next_srv_index_ = 0;
+        if (!srv_descriptors_.Initialize(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kInitialSrvDescriptors)) {
+            return false;
+        }
 
-        if (!CreateSrvHeap(64)) {
+        if (!streamer_.Initialize(device_.Get(), &memory_, kStreamingStagingSize, &Framework::DecodeTextureFile)) {
             return false;
         }
 
@@ -142,23 +118,78 @@ bool Framework::Initialize(Window *window) {
         return true;
     }
 
+    bool Framework::CreateBackBuffers(UINT frame_count) {
+        DXGI_SWAP_CHAIN_DESC1 swap_chain_desc = {};
+        swap_chain_desc.BufferCount = frame_count;
+        swap_chain_desc.Width = width_;
+        swap_chain_desc.Height = height_;
+        swap_chain_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        swap_chain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        swap_chain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+        swap_chain_desc.SampleDesc.Count = 1;
+
+        ComPtr<IDXGISwapChain1> swap_chain1;
+        if (detail::CheckFailed(factory_->CreateSwapChainForHwnd(
+                command_queue_.Get(), window_->GetHandle(), &swap_chain_desc, nullptr, nullptr, &swap_chain1), L"Failed to create SwapChain!"))
+            return false;
+        if (detail::CheckFailed(swap_chain1.As(&swap_chain_), L"Failed to query SwapChain3!"))
+            return false;
+
+        if (FAILED(factory_->MakeWindowAssociation(window_->GetHandle(), DXGI_MWA_NO_ALT_ENTER))) {
+            std::wcerr << L"Warning: Failed to disable Alt+Enter!" << std::endl;
+        }
+
+        frame_index_ = swap_chain_->GetCurrentBackBufferIndex();
+
+        D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
+        rtv_heap_desc.NumDescriptors = frame_count;
+        rtv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        rtv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+        if (detail::CheckFailed(device_->CreateDescriptorHeap(&rtv_heap_desc, IID_PPV_ARGS(&rtv_heap_)), L"Failed to create RTV Descriptor Heap!"))
+            return false;
+
+        rtv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = rtv_heap_->GetCPUDescriptorHandleForHeapStart();
+        render_targets_.resize(frame_count);
+
+        for (UINT n = 0; n < frame_count; n++) {
+            if (detail::CheckFailed(swap_chain_->GetBuffer(n, IID_PPV_ARGS(&render_targets_[n])), L"Failed to get SwapChain buffer!"))
+                return false;
+            device_->CreateRenderTargetView(render_targets_[n].Get(), nullptr, rtv_handle);
+            rtv_handle.ptr += rtv_descriptor_size_;
+        }
+        return true;
+    }
+
     void Framework::Shutdown() {
+        streamer_.Shutdown();
+        streaming_completions_.clear();
         if (fence_event_) {
-            WaitForPreviousFrame();
+            WaitForGpu();
             CloseHandle(fence_event_);
             fence_event_ = nullptr;
         }
 
-        if (constant_buffer_) {
-            constant_buffer_->Unmap(0, nullptr);
-            constant_buffer_mapped_ = nullptr;
-        }
-
-        constant_buffer_.Reset();
+        uploads_.Shutdown();
+        upload_ring_.Shutdown();
         default_texture_.reset();
         textures_.clear();
-        srv_heap_.Reset();
+        released_resources_.clear();
+        {
+            // Objects the owner never released; placed resources go before the heaps they live in.
+            std::lock_guard lock(objects_mutex_);
+            objects_.clear();
+        }
+        srv_descriptors_.Shutdown();
         depth_stencil_.Reset();
+        memory_.Shutdown();
+        if (pipeline_cache_.IsDirty() && pipeline_cache_.Save(kPipelineCacheFile)) {
+            std::wcout << L"Pipeline cache: " << pipeline_cache_hits_.load() << L" hits, "
+                       << pipeline_cache_misses_.load() << L" misses; saved " << pipeline_cache_.Size()
+                       << L" pipelines" << std::endl;
+        }
         pipeline_state_rainbow_.Reset();
         pipeline_state_transparent_.Reset();
         pipeline_state_.Reset();
@@ -167,10 +198,20 @@ bool Framework::Initialize(Window *window) {
 
         render_targets_.clear();
         command_list_.Reset();
+        command_list_segments_.clear();
+        frame_submission_.clear();
+        d3d12_recorder_.Bind(nullptr);
+        d3d12_recorder_.SetCapture(nullptr);
+        capture_list_.Stream().Clear();
+        capture_.Begin();
+        capture_path_.clear();
+        capture_requested_ = false;
+        capturing_ = false;
 
-        for (UINT n = 0; n < FRAME_COUNT; n++) {
-            command_allocator_[n].Reset();
+        for (auto &allocator : command_allocator_) {
+            allocator.Reset();
         }
+        frame_start_ = {};
 
         rtv_heap_.Reset();
         swap_chain_.Reset();
@@ -183,6 +224,8 @@ bool Framework::Initialize(Window *window) {
         }
 
         window_ = nullptr;
+        width_ = 0;
+        height_ = 0;
     }
 }
 
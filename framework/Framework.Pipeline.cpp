@@ -1,56 +1,207 @@
 #include "Framework.h"
+#include "ShaderLibrary.h"
+
+#include <array>
+#include <climits>
 
 namespace gfw {
-    bool Framework::CreatePhongPipeline() {
-        UINT compile_flags = 0;
-    #ifdef _DEBUG
-        compile_flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-    #endif
-
-        ComPtr<ID3DBlob> vs_blob;
-        ComPtr<ID3DBlob> ps_blob;
-        ComPtr<ID3DBlob> ps_rainbow_blob;
-        ComPtr<ID3DBlob> error_blob;
+namespace {
+    // Private data slot of a root signature holding the hash of its serialized form.
+    // {6C1B9E52-3F0A-4D8B-9A57-2E4F1D7C8B30}
+    const GUID kRootSignatureHashGuid = {0x6c1b9e52, 0x3f0a, 0x4d8b, {0x9a, 0x57, 0x2e, 0x4f, 0x1d, 0x7c, 0x8b, 0x30}};
+
+    void HashShader(PipelineHasher &hasher, const D3D12_SHADER_BYTECODE &shader) {
+        hasher.AddBytes(shader.pShaderBytecode, shader.pShaderBytecode ? shader.BytecodeLength : 0);
+    }
+
+    void HashStencilOp(PipelineHasher &hasher, const D3D12_DEPTH_STENCILOP_DESC &op) {
+        hasher.Add(op.StencilFailOp);
+        hasher.Add(op.StencilDepthFailOp);
+        hasher.Add(op.StencilPassOp);
+        hasher.Add(op.StencilFunc);
+    }
+
+    // Every field that reaches the driver, pointers replaced by what they point to; CachedPSO is the value
+    // being looked up and stays out.
+    std::uint64_t HashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc,
+                                           std::uint64_t root_signature_hash) {
+        PipelineHasher hasher;
+        hasher.Add(root_signature_hash);
+        for (const D3D12_SHADER_BYTECODE *shader : {&desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS}) {
+            HashShader(hasher, *shader);
+        }
+
+        const D3D12_STREAM_OUTPUT_DESC &stream_output = desc.StreamOutput;
+        hasher.Add(stream_output.NumEntries);
+        for (UINT i = 0; stream_output.pSODeclaration && i < stream_output.NumEntries; ++i) {
+            const D3D12_SO_DECLARATION_ENTRY &entry = stream_output.pSODeclaration[i];
+            hasher.Add(entry.Stream);
+            hasher.AddString(entry.SemanticName);
+            hasher.Add(entry.SemanticIndex);
+            hasher.Add(entry.StartComponent);
+            hasher.Add(entry.ComponentCount);
+            hasher.Add(entry.OutputSlot);
+        }
+        hasher.Add(stream_output.NumStrides);
+        for (UINT i = 0; stream_output.pBufferStrides && i < stream_output.NumStrides; ++i) {
+            hasher.Add(stream_output.pBufferStrides[i]);
+        }
+        hasher.Add(stream_output.RasterizedStream);
+
+        hasher.Add(desc.BlendState.AlphaToCoverageEnable);
+        hasher.Add(desc.BlendState.IndependentBlendEnable);
+        for (const D3D12_RENDER_TARGET_BLEND_DESC &target : desc.BlendState.RenderTarget) {
+            hasher.Add(target.BlendEnable);
+            hasher.Add(target.LogicOpEnable);
+            hasher.Add(target.SrcBlend);
+            hasher.Add(target.DestBlend);
+            hasher.Add(target.BlendOp);
+            hasher.Add(target.SrcBlendAlpha);
+            hasher.Add(target.DestBlendAlpha);
+            hasher.Add(target.BlendOpAlpha);
+            hasher.Add(target.LogicOp);
+            hasher.Add(target.RenderTargetWriteMask);
+        }
+        hasher.Add(desc.SampleMask);
+
+        const D3D12_RASTERIZER_DESC &rasterizer = desc.RasterizerState;
+        hasher.Add(rasterizer.FillMode);
+        hasher.Add(rasterizer.CullMode);
+        hasher.Add(rasterizer.FrontCounterClockwise);
+        hasher.Add(rasterizer.DepthBias);
+        hasher.Add(rasterizer.DepthBiasClamp);
+        hasher.Add(rasterizer.SlopeScaledDepthBias);
+        hasher.Add(rasterizer.DepthClipEnable);
+        hasher.Add(rasterizer.MultisampleEnable);
+        hasher.Add(rasterizer.AntialiasedLineEnable);
+        hasher.Add(rasterizer.ForcedSampleCount);
+        hasher.Add(rasterizer.ConservativeRaster);
+
+        const D3D12_DEPTH_STENCIL_DESC &depth = desc.DepthStencilState;
+        hasher.Add(depth.DepthEnable);
+        hasher.Add(depth.DepthWriteMask);
+        hasher.Add(depth.DepthFunc);
+        hasher.Add(depth.StencilEnable);
+        hasher.Add(depth.StencilReadMask);
+        hasher.Add(depth.StencilWriteMask);
+        HashStencilOp(hasher, depth.FrontFace);
+        HashStencilOp(hasher, depth.BackFace);
 
-        // Compile vertex shader from file
-        HRESULT hr_vs = D3DCompileFromFile(L"shaders/VertexShader.hlsl",
-                                            nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-                                            "VSMain", "vs_5_0",
-                                            compile_flags, 0,
-                                            &vs_blob, &error_blob);
-        if (FAILED(hr_vs)) {
-            if (error_blob) {
+        hasher.Add(desc.InputLayout.NumElements);
+        for (UINT i = 0; desc.InputLayout.pInputElementDescs && i < desc.InputLayout.NumElements; ++i) {
+            const D3D12_INPUT_ELEMENT_DESC &element = desc.InputLayout.pInputElementDescs[i];
+            hasher.AddString(element.SemanticName);
+            hasher.Add(element.SemanticIndex);
+            hasher.Add(element.Format);
+            hasher.Add(element.InputSlot);
+            hasher.Add(element.AlignedByteOffset);
+            hasher.Add(element.InputSlotClass);
+            hasher.Add(element.InstanceDataStepRate);
+        }
+
+        hasher.Add(desc.IBStripCutValue);
+        hasher.Add(desc.PrimitiveTopologyType);
+        hasher.Add(desc.NumRenderTargets);
+        for (const DXGI_FORMAT format : desc.RTVFormats) {
+            hasher.Add(format);
+        }
+        hasher.Add(desc.DSVFormat);
+        hasher.Add(desc.SampleDesc.Count);
+        hasher.Add(desc.SampleDesc.Quality);
+        hasher.Add(desc.NodeMask);
+        hasher.Add(desc.Flags);
+        return hasher.Value();
+    }
+
+    // Loads a stage of a PipelineDesc with its defines; a stage without a file stays empty.
+    bool LoadStage(const ShaderStage &stage, ShaderBytecode &out) {
+        if (!stage.file) {
+            return true;
+        }
+        std::array<D3D_SHADER_MACRO, ShaderStage::kMaxDefines + 1> macros = {};
+        for (std::uint32_t i = 0; i < stage.define_count && i < ShaderStage::kMaxDefines; ++i) {
+            macros[i] = {stage.defines[i], "1"};
+        }
+        return LoadShader(stage.file, stage.entry, stage.profile, macros.data(), out);
+    }
+
+    D3D12_SHADER_VISIBILITY ToD3D12(ShaderVisibility visibility) {
+        return visibility == ShaderVisibility::Pixel ? D3D12_SHADER_VISIBILITY_PIXEL : D3D12_SHADER_VISIBILITY_ALL;
+    }
+}
+
+    bool Framework::CreateD3D12RootSignature(const D3D12_ROOT_SIGNATURE_DESC &desc,
+                                             ComPtr<ID3D12RootSignature> &out) {
+        ComPtr<ID3DBlob> signature_blob;
+        ComPtr<ID3DBlob> error_blob;
+        if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature_blob, &error_blob))) {
+            if (error_blob)
                 std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-            }
-            std::wcerr << L"Failed to compile vertex shader from file!" << std::endl;
+            std::wcerr << L"Failed to serialize RootSignature!" << std::endl;
             return false;
         }
 
-        error_blob.Reset();
-        HRESULT hr_ps = D3DCompileFromFile(L"shaders/PixelShader.hlsl",
-                                            nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-                                            "PSMain", "ps_5_0",
-                                            compile_flags, 0,
-                                            &ps_blob, &error_blob);
-        if (FAILED(hr_ps)) {
-            if (error_blob) {
-                std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-            }
-            std::wcerr << L"Failed to compile pixel shader from file!" << std::endl;
+        if (FAILED(device_->CreateRootSignature(0, signature_blob->GetBufferPointer(), signature_blob->GetBufferSize(),
+                                                IID_PPV_ARGS(&out)))) {
+            std::wcerr << L"Failed to create RootSignature!" << std::endl;
             return false;
         }
 
-        error_blob.Reset();
-        HRESULT hr_ps_rainbow = D3DCompileFromFile(L"shaders/PixelShader.hlsl",
-                                                   nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-                                                   "PSRainbow", "ps_5_0",
-                                                   compile_flags, 0,
-                                                   &ps_rainbow_blob, &error_blob);
-        if (FAILED(hr_ps_rainbow)) {
-            if (error_blob) {
-                std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
+        PipelineHasher hasher;
+        hasher.AddBytes(signature_blob->GetBufferPointer(), signature_blob->GetBufferSize());
+        const std::uint64_t hash = hasher.Value();
+        out->SetPrivateData(kRootSignatureHashGuid, sizeof(hash), &hash);
+        return true;
+    }
+
+    bool Framework::CreateD3D12Pipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc,
+                                        ComPtr<ID3D12PipelineState> &out) {
+        std::uint64_t root_signature_hash = 0;
+        UINT hash_size = sizeof(root_signature_hash);
+        if (!desc.pRootSignature ||
+            FAILED(desc.pRootSignature->GetPrivateData(kRootSignatureHashGuid, &hash_size, &root_signature_hash))) {
+            // Not created through CreateD3D12RootSignature, so there is no stable key for it.
+            return SUCCEEDED(device_->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&out)));
+        }
+
+        const std::uint64_t key = HashGraphicsPipelineDesc(desc, root_signature_hash);
+        std::vector<std::uint8_t> blob;
+        if (pipeline_cache_.Find(key, blob)) {
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC cached_desc = desc;
+            cached_desc.CachedPSO = {blob.data(), blob.size()};
+            if (SUCCEEDED(device_->CreateGraphicsPipelineState(&cached_desc, IID_PPV_ARGS(&out)))) {
+                ++pipeline_cache_hits_;
+                return true;
             }
-            std::wcerr << L"Failed to compile rainbow pixel shader from file!" << std::endl;
+            // The driver rejects blobs it cannot use (D3D12_ERROR_DRIVER_VERSION_MISMATCH and friends).
+            pipeline_cache_.Erase(key);
+        }
+
+        ++pipeline_cache_misses_;
+        if (FAILED(device_->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&out)))) {
+            return false;
+        }
+        ComPtr<ID3DBlob> cached_blob;
+        if (SUCCEEDED(out->GetCachedBlob(&cached_blob))) {
+            pipeline_cache_.Store(key, cached_blob->GetBufferPointer(), cached_blob->GetBufferSize());
+        }
+        return true;
+    }
+
+    bool Framework::CreatePhongPipeline() {
+        ShaderBytecode vs_blob;
+        ShaderBytecode ps_blob;
+        ShaderBytecode ps_rainbow_blob;
+        if (!LoadShader("VertexShader.hlsl", "VSMain", "vs_5_0", nullptr, vs_blob)) {
+            std::wcerr << L"Failed to load vertex shader!" << std::endl;
+            return false;
+        }
+        if (!LoadShader("PixelShader.hlsl", "PSMain", "ps_5_0", nullptr, ps_blob)) {
+            std::wcerr << L"Failed to load pixel shader!" << std::endl;
+            return false;
+        }
+        if (!LoadShader("PixelShader.hlsl", "PSRainbow", "ps_5_0", nullptr, ps_rainbow_blob)) {
+            std::wcerr << L"Failed to load rainbow pixel shader!" << std::endl;
             return false;
         }
 
@@ -94,18 +245,7 @@ namespace gfw {
         root_desc.pStaticSamplers = &sampler;
         root_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
-        ComPtr<ID3DBlob> signature_blob;
-        if (FAILED(D3D12SerializeRootSignature(&root_desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature_blob,
-                                                &error_blob))) {
-            if (error_blob)
-                std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
-            std::wcerr << L"Failed to serialize RootSignature!" << std::endl;
-            return false;
-        }
-
-        if (FAILED(device_->CreateRootSignature(0, signature_blob->GetBufferPointer(), signature_blob->GetBufferSize(),
-                                                IID_PPV_ARGS(&root_signature_)))) {
-            std::wcerr << L"Failed to create RootSignature!" << std::endl;
+        if (!CreateD3D12RootSignature(root_desc, root_signature_)) {
             return false;
         }
 
@@ -159,8 +299,8 @@ namespace gfw {
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc = {};
         pso_desc.pRootSignature = root_signature_.Get();
-        pso_desc.VS = {vs_blob->GetBufferPointer(), vs_blob->GetBufferSize()};
-        pso_desc.PS = {ps_blob->GetBufferPointer(), ps_blob->GetBufferSize()};
+        pso_desc.VS = vs_blob.Get();
+        pso_desc.PS = ps_blob.Get();
         pso_desc.BlendState = blend;
         pso_desc.SampleMask = UINT_MAX;
         pso_desc.RasterizerState = rasterizer;
@@ -172,14 +312,14 @@ namespace gfw {
         pso_desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
         pso_desc.SampleDesc.Count = 1;
 
-        if (FAILED(device_->CreateGraphicsPipelineState(&pso_desc, IID_PPV_ARGS(&pipeline_state_)))) {
+        if (!CreateD3D12Pipeline(pso_desc, pipeline_state_)) {
             std::wcerr << L"Failed to create PSO!" << std::endl;
             return false;
         }
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc_rainbow = pso_desc;
-        pso_desc_rainbow.PS = {ps_rainbow_blob->GetBufferPointer(), ps_rainbow_blob->GetBufferSize()};
-        if (FAILED(device_->CreateGraphicsPipelineState(&pso_desc_rainbow, IID_PPV_ARGS(&pipeline_state_rainbow_)))) {
+        pso_desc_rainbow.PS = ps_rainbow_blob.Get();
+        if (!CreateD3D12Pipeline(pso_desc_rainbow, pipeline_state_rainbow_)) {
             std::wcerr << L"Failed to create rainbow PSO!" << std::endl;
             return false;
         }
@@ -203,13 +343,141 @@ namespace gfw {
         pso_desc_transparent.BlendState = blend_transparent;
         pso_desc_transparent.DepthStencilState = depth_stencil_transparent;
 
-        if (FAILED(device_->CreateGraphicsPipelineState(&pso_desc_transparent,
-                                                        IID_PPV_ARGS(&pipeline_state_transparent_)))) {
+        if (!CreateD3D12Pipeline(pso_desc_transparent, pipeline_state_transparent_)) {
             std::wcerr << L"Failed to create transparent PSO!" << std::endl;
             return false;
         }
 
         return true;
     }
-}
 
+    RootSignatureHandle Framework::CreateRootSignature(const RootSignatureDesc &desc) {
+        if (desc.table_size == 0) {
+            std::wcerr << L"CreateRootSignature: empty descriptor table!" << std::endl;
+            return {};
+        }
+        const D3D12_SHADER_VISIBILITY visibility = ToD3D12(desc.visibility);
+
+        D3D12_DESCRIPTOR_RANGE srv_range = {};
+        srv_range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        srv_range.NumDescriptors = desc.table_size == RootSignatureDesc::kUnboundedTable ? UINT_MAX : desc.table_size;
+        srv_range.BaseShaderRegister = 0;
+        srv_range.RegisterSpace = desc.table_space;
+        srv_range.OffsetInDescriptorsFromTableStart = 0;
+
+        D3D12_ROOT_PARAMETER root_params[2] = {};
+        root_params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+        root_params[0].Descriptor.ShaderRegister = 0;
+        root_params[0].ShaderVisibility = visibility;
+        root_params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        root_params[1].DescriptorTable.NumDescriptorRanges = 1;
+        root_params[1].DescriptorTable.pDescriptorRanges = &srv_range;
+        root_params[1].ShaderVisibility = visibility;
+
+        const D3D12_TEXTURE_ADDRESS_MODE address = desc.sampler_address == SamplerAddress::Clamp
+                                                       ? D3D12_TEXTURE_ADDRESS_MODE_CLAMP
+                                                       : D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        D3D12_STATIC_SAMPLER_DESC sampler = {};
+        sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+        sampler.AddressU = address;
+        sampler.AddressV = address;
+        sampler.AddressW = address;
+        sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+        sampler.MaxLOD = D3D12_FLOAT32_MAX;
+        sampler.ShaderRegister = 0;
+        sampler.ShaderVisibility = visibility;
+
+        D3D12_ROOT_SIGNATURE_DESC rs_desc = {};
+        rs_desc.NumParameters = static_cast<UINT>(std::size(root_params));
+        rs_desc.pParameters = root_params;
+        rs_desc.NumStaticSamplers = 1;
+        rs_desc.pStaticSamplers = &sampler;
+        rs_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+        ComPtr<ID3D12RootSignature> root_signature;
+        if (!CreateD3D12RootSignature(rs_desc, root_signature)) {
+            return {};
+        }
+        return RootSignatureHandle{RegisterObject(std::move(root_signature))};
+    }
+
+    PipelineHandle Framework::CreatePipeline(const PipelineDesc &desc) {
+        const bool patches = desc.primitive == PrimitiveType::Patch;
+        if (!desc.root_signature || !desc.vs.file || desc.input_count > PipelineDesc::kMaxInputElements ||
+            desc.rtv_count > CommandRecorder::kMaxRenderTargets || (patches && (!desc.hs.file || !desc.ds.file))) {
+            std::wcerr << L"CreatePipeline: invalid pipeline description!" << std::endl;
+            return {};
+        }
+
+        ShaderBytecode vs_blob;
+        ShaderBytecode hs_blob;
+        ShaderBytecode ds_blob;
+        ShaderBytecode ps_blob;
+        if (!LoadStage(desc.vs, vs_blob) || !LoadStage(desc.hs, hs_blob) || !LoadStage(desc.ds, ds_blob) ||
+            !LoadStage(desc.ps, ps_blob)) {
+            return {};
+        }
+
+        std::array<D3D12_INPUT_ELEMENT_DESC, PipelineDesc::kMaxInputElements> input_layout = {};
+        for (std::uint32_t i = 0; i < desc.input_count; ++i) {
+            const InputElement &element = desc.input_layout[i];
+            input_layout[i] = {element.semantic, 0, ToD3D12(element.format), 0, element.offset,
+                               D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0};
+        }
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC pso = {};
+        pso.pRootSignature = FromHandle<ID3D12RootSignature>(desc.root_signature.value);
+        pso.VS = vs_blob.Get();
+        pso.HS = hs_blob.Get();
+        pso.DS = ds_blob.Get();
+        pso.PS = ps_blob.Get();
+        pso.InputLayout = {input_layout.data(), desc.input_count};
+        pso.PrimitiveTopologyType = patches ? D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH : D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        pso.SampleMask = UINT_MAX;
+        pso.SampleDesc.Count = 1;
+        pso.NumRenderTargets = desc.rtv_count;
+        for (std::uint32_t i = 0; i < desc.rtv_count; ++i) {
+            pso.RTVFormats[i] = ToD3D12(desc.rtv_formats[i]);
+        }
+        pso.DSVFormat = ToD3D12(desc.dsv_format);
+
+        D3D12_RASTERIZER_DESC rasterizer = {};
+        rasterizer.FillMode = desc.wireframe ? D3D12_FILL_MODE_WIREFRAME : D3D12_FILL_MODE_SOLID;
+        rasterizer.CullMode = desc.cull == CullMode::Back ? D3D12_CULL_MODE_BACK : D3D12_CULL_MODE_NONE;
+        rasterizer.FrontCounterClockwise = FALSE;
+        rasterizer.DepthClipEnable = TRUE;
+        rasterizer.MultisampleEnable = FALSE;
+        rasterizer.AntialiasedLineEnable = FALSE;
+        rasterizer.ForcedSampleCount = 0;
+        rasterizer.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+        pso.RasterizerState = rasterizer;
+
+        D3D12_RENDER_TARGET_BLEND_DESC rt_blend = {};
+        rt_blend.BlendEnable = FALSE;
+        rt_blend.LogicOpEnable = FALSE;
+        rt_blend.SrcBlend = D3D12_BLEND_ONE;
+        rt_blend.DestBlend = D3D12_BLEND_ZERO;
+        rt_blend.BlendOp = D3D12_BLEND_OP_ADD;
+        rt_blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+        rt_blend.DestBlendAlpha = D3D12_BLEND_ZERO;
+        rt_blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+        rt_blend.LogicOp = D3D12_LOGIC_OP_NOOP;
+        rt_blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        for (D3D12_RENDER_TARGET_BLEND_DESC &target : pso.BlendState.RenderTarget) {
+            target = rt_blend;
+        }
+
+        D3D12_DEPTH_STENCIL_DESC depth = {};
+        depth.DepthEnable = desc.dsv_format != Format::Unknown ? TRUE : FALSE;
+        depth.DepthWriteMask = depth.DepthEnable ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+        depth.DepthFunc = depth.DepthEnable ? D3D12_COMPARISON_FUNC_LESS : D3D12_COMPARISON_FUNC_ALWAYS;
+        depth.StencilEnable = FALSE;
+        pso.DepthStencilState = depth;
+
+        ComPtr<ID3D12PipelineState> pipeline;
+        if (!CreateD3D12Pipeline(pso, pipeline)) {
+            return {};
+        }
+        return PipelineHandle{RegisterObject(std::move(pipeline))};
+    }
+}
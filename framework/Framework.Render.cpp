@@ -1,46 +1,52 @@
 #include "Framework.h"
 
-#include <iterator>
-
 namespace gfw {
     bool Framework::IsRenderReady() const {
-        return pipeline_state_ && root_signature_ && constant_buffer_ && srv_heap_ && default_texture_;
+        return pipeline_state_ && root_signature_ && upload_ring_.IsValid() && srv_descriptors_.IsValid() && default_texture_;
     }
 
     void Framework::RenderMeshImpl(const MeshBuffers &buffers, const SceneConstants &constants,
-                                   D3D12_GPU_DESCRIPTOR_HANDLE texture_srv, bool transparent) {
-        std::memcpy(constant_buffer_mapped_, &constants, sizeof(constants));
+                                   const Texture2D *texture, bool transparent) {
+        if (!UseMesh(buffers)) {
+            return;
+        }
+        const GpuAddress constants_address = UploadConstants(constants);
+        if (!constants_address) {
+            return;
+        }
 
-        ID3D12DescriptorHeap *heaps[] = {srv_heap_.Get()};
-        command_list_->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), heaps);
+        CommandRecorder &cmd = GetRecorder();
+        cmd.SetDescriptorHeap(ToHandle(srv_descriptors_.ShaderVisibleHeap()));
 
-        command_list_->SetGraphicsRootSignature(root_signature_.Get());
+        cmd.SetRootSignature(ToHandle(root_signature_.Get()));
         const bool rainbow_enabled = constants.effect_params.x > 0.99f && constants.effect_params.x < 1.01f;
         if (rainbow_enabled && pipeline_state_rainbow_) {
-            command_list_->SetPipelineState(pipeline_state_rainbow_.Get());
+            cmd.SetPipeline(ToHandle(pipeline_state_rainbow_.Get()));
         } else if (transparent && pipeline_state_transparent_) {
-            command_list_->SetPipelineState(pipeline_state_transparent_.Get());
+            cmd.SetPipeline(ToHandle(pipeline_state_transparent_.Get()));
         } else {
-            command_list_->SetPipelineState(pipeline_state_.Get());
+            cmd.SetPipeline(ToHandle(pipeline_state_.Get()));
         }
-        command_list_->IASetPrimitiveTopology(buffers.topology);
-        command_list_->IASetVertexBuffers(0, 1, &buffers.vertex_buffer_view);
+        cmd.SetTopology(buffers.topology);
+        cmd.SetVertexBuffer(buffers.vertex_buffer_view);
 
-        command_list_->SetGraphicsRootConstantBufferView(0, constant_buffer_->GetGPUVirtualAddress());
-        command_list_->SetGraphicsRootDescriptorTable(1, texture_srv);
+        cmd.SetConstantBuffer(0, constants_address);
+        const GpuDescriptor texture_srv{GetBindlessTable().value +
+                                        static_cast<UINT64>(GetBindlessIndex(texture)) * GetSrvDescriptorSize()};
+        cmd.SetDescriptorTable(1, texture_srv);
 
         if (buffers.index_buffer) {
-            command_list_->IASetIndexBuffer(&buffers.index_buffer_view);
-            command_list_->DrawIndexedInstanced(buffers.index_count, 1, 0, 0, 0);
+            cmd.SetIndexBuffer(buffers.index_buffer_view);
+            cmd.DrawIndexed(buffers.index_count, 0, 0);
         } else {
-            command_list_->DrawInstanced(buffers.index_count, 1, 0, 0);
+            cmd.Draw(buffers.index_count, 0);
         }
     }
 
     void Framework::RenderMesh(const MeshBuffers &buffers, const DirectX::XMMATRIX &world_matrix, double total_time) {
         if (!IsRenderReady()) return;
 
-        const float aspect = static_cast<float>(window_->GetWidth()) / static_cast<float>(window_->GetHeight());
+        const float aspect = static_cast<float>(width_) / static_cast<float>(height_);
         const SceneConstants constants = MakeSceneConstants(world_matrix, scene_state_, aspect,
                                                            static_cast<float>(total_time));
         RenderMesh(buffers, constants);
@@ -49,23 +55,20 @@ namespace gfw {
     void Framework::RenderMesh(const MeshBuffers &buffers, const SceneConstants &constants) {
         if (!IsRenderReady()) return;
         const bool transparent = constants.albedo.w < 0.999f;
-        RenderMeshImpl(buffers, constants, default_texture_->srv_gpu, transparent);
+        RenderMeshImpl(buffers, constants, default_texture_.get(), transparent);
     }
 
     void Framework::RenderObject(const ::gfw::RenderObject &object, double total_time) {
         if (!object.mesh || !IsRenderReady()) return;
 
-        const float aspect = static_cast<float>(window_->GetWidth()) / static_cast<float>(window_->GetHeight());
+        const float aspect = static_cast<float>(width_) / static_cast<float>(height_);
         const DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&object.world);
         SceneConstants constants = MakeSceneConstants(world, scene_state_, aspect, static_cast<float>(total_time));
         constants.albedo = object.albedo;
         constants.uv_params = object.uv_params;
         constants.effect_params = object.effect_params;
 
-        const D3D12_GPU_DESCRIPTOR_HANDLE texture_srv =
-                object.texture ? object.texture->srv_gpu : default_texture_->srv_gpu;
-
         const bool transparent = constants.albedo.w < 0.999f;
-        RenderMeshImpl(*object.mesh, constants, texture_srv, transparent);
+        RenderMeshImpl(*object.mesh, constants, object.texture.get(), transparent);
     }
 }
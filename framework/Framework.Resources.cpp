@@ -9,12 +9,6 @@
 
 namespace gfw {
     namespace {
-        struct DecodedImage {
-            UINT width = 0;
-            UINT height = 0;
-            std::vector<std::uint8_t> rgba;
-        };
-
         static bool EndsWithTga(const std::wstring &filename) {
             size_t dot_pos = filename.find_last_of(L'.');
             if (dot_pos == std::wstring::npos) {
@@ -32,7 +26,7 @@ namespace gfw {
             return static_cast<std::uint16_t>(ptr[0] | (static_cast<std::uint16_t>(ptr[1]) << 8u));
         }
 
-        static bool LoadTgaImage(const std::wstring &filename, DecodedImage &out_image) {
+        static bool LoadTgaImage(const std::wstring &filename, DecodedTexture &out_image) {
             std::ifstream file(filename, std::ios::binary);
             if (!file.is_open()) {
                 return false;
@@ -160,21 +154,6 @@ namespace gfw {
 
             return (a << 24u) | (b << 16u) | (g << 8u) | r;
         }
-
-        bool CreateUploadBuffer(ID3D12Device *device, UINT size, const void *data,
-                               ComPtr<ID3D12Resource> &out_resource) {
-            const D3D12_HEAP_PROPERTIES heap = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-            const D3D12_RESOURCE_DESC desc = detail::BufferDesc(size);
-            if (FAILED(device->CreateCommittedResource(&heap, D3D12_HEAP_FLAG_NONE, &desc,
-                    D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&out_resource))))
-                return false;
-            void *mapped = nullptr;
-            if (FAILED(out_resource->Map(0, nullptr, &mapped)))
-                return false;
-            std::memcpy(mapped, data, size);
-            out_resource->Unmap(0, nullptr);
-            return true;
-        }
     }
 
     bool Framework::CreateDepthResources() {
@@ -191,8 +170,8 @@ namespace gfw {
         D3D12_RESOURCE_DESC depth_desc = {};
         depth_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
         depth_desc.Alignment = 0;
-        depth_desc.Width = window_->GetWidth();
-        depth_desc.Height = window_->GetHeight();
+        depth_desc.Width = width_;
+        depth_desc.Height = height_;
         depth_desc.DepthOrArraySize = 1;
         depth_desc.MipLevels = 1;
         depth_desc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -206,14 +185,8 @@ namespace gfw {
         clear_value.DepthStencil.Depth = 1.0f;
         clear_value.DepthStencil.Stencil = 0;
 
-        const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
-        if (FAILED(device_->CreateCommittedResource(
-                &heap_props,
-                D3D12_HEAP_FLAG_NONE,
-                &depth_desc,
-                D3D12_RESOURCE_STATE_DEPTH_WRITE,
-                &clear_value,
-                IID_PPV_ARGS(&depth_stencil_)))) {
+        if (!memory_.CreateResource(MemoryCategory::RenderTarget, depth_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE,
+                                    &clear_value, depth_stencil_memory_, depth_stencil_)) {
             std::wcerr << L"Failed to create Depth Stencil resource!" << std::endl;
             return false;
         }
@@ -228,194 +201,183 @@ namespace gfw {
         return true;
     }
 
-    bool Framework::CreateConstantBuffer() {
-        const UINT cb_size = detail::Align256(sizeof(SceneConstants));
-
-        const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-        const D3D12_RESOURCE_DESC cb_desc = detail::BufferDesc(cb_size);
-        if (FAILED(device_->CreateCommittedResource(
-                &heap_props,
-                D3D12_HEAP_FLAG_NONE,
-                &cb_desc,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&constant_buffer_)))) {
-            std::wcerr << L"Failed to create constant buffer!" << std::endl;
-            return false;
+    GpuAddress Framework::UploadConstants(const void *data, std::uint32_t size) {
+        UploadRing::Allocation allocation;
+        if (!upload_ring_.Allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, allocation)) {
+            std::wcerr << L"Failed to allocate constants from the upload ring!" << std::endl;
+            return 0;
         }
-
-        void *mapped = nullptr;
-        if (FAILED(constant_buffer_->Map(0, nullptr, &mapped))) {
-            std::wcerr << L"Failed to map constant buffer!" << std::endl;
-            return false;
+        std::memcpy(allocation.cpu, data, size);
+        if (capturing_) {
+            capture_.RecordConstants(allocation.gpu, data, size);
         }
+        return allocation.gpu;
+    }
 
-        constant_buffer_mapped_ = static_cast<std::uint8_t *>(mapped);
-        std::memset(constant_buffer_mapped_, 0, cb_size);
-        return true;
+    // Static geometry lives in video memory; UploadBatcher or AssetStreamer fills it.
+    ResourceHandle Framework::CreateDefaultBuffer(UINT size, D3D12_RESOURCE_STATES initial_state, GpuAddress &address) {
+        ComPtr<ID3D12Resource> buffer;
+        GpuAllocation memory;
+        if (!memory_.CreateResource(MemoryCategory::Buffer, detail::BufferDesc(size), initial_state, nullptr, memory,
+                                    buffer)) {
+            return {};
+        }
+        address = buffer->GetGPUVirtualAddress();
+        return ResourceHandle{RegisterObject(std::move(buffer), memory)};
     }
 
-    std::unique_ptr<MeshBuffers> Framework::CreateMeshBuffers(const MeshData &mesh_data) {
-        if (mesh_data.vertex_data.empty()) {
+    bool Framework::CreateMeshResources(const MeshData &mesh_data, MeshBuffers &buffers,
+                                        std::vector<std::uint8_t> &index_bytes, const std::uint8_t *&index_data,
+                                        D3D12_RESOURCE_STATES initial_state) {
+        if (mesh_data.VertexByteSize() == 0) {
             std::wcerr << L"CreateMeshBuffers: Empty vertex data!" << std::endl;
-            return nullptr;
+            return false;
         }
 
-        auto buffers = std::make_unique<MeshBuffers>();
-        buffers->topology = mesh_data.topology;
-        buffers->vertex_count = mesh_data.vertex_count;  // Store vertex count for non-indexed draws
-
-        const UINT vb_size = static_cast<UINT>(mesh_data.vertex_data.size());
-        if (!CreateUploadBuffer(device_.Get(), vb_size, mesh_data.vertex_data.data(), buffers->vertex_buffer)) {
+        buffers.SetDrawInfo(mesh_data);
+        const UINT vb_size = static_cast<UINT>(mesh_data.VertexByteSize());
+        buffers.vertex_buffer = CreateDefaultBuffer(vb_size, initial_state, buffers.vertex_buffer_view.address);
+        if (!buffers.vertex_buffer) {
             std::wcerr << L"Failed to create vertex buffer!" << std::endl;
-            return nullptr;
+            return false;
         }
-        buffers->vertex_buffer_view.BufferLocation = buffers->vertex_buffer->GetGPUVirtualAddress();
-        buffers->vertex_buffer_view.SizeInBytes = vb_size;
-        buffers->vertex_buffer_view.StrideInBytes = mesh_data.vertex_stride;
-
-        if (!mesh_data.indices.empty()) {
-            const UINT ib_size = static_cast<UINT>(mesh_data.indices.size() * sizeof(std::uint32_t));
-            if (!CreateUploadBuffer(device_.Get(), ib_size, mesh_data.indices.data(), buffers->index_buffer)) {
+        buffers.vertex_buffer_view.size = vb_size;
+        buffers.vertex_buffer_view.stride = mesh_data.vertex_stride;
+
+        index_bytes.clear();
+        index_data = nullptr;
+        const std::uint32_t index_count = mesh_data.IndexCount();
+        if (index_count > 0) {
+            // Indices a cached mesh already stores at the buffer's width are uploaded straight from the mapped file.
+            const IndexFormat format = MeshBuffers::IndexFormatFor(mesh_data);
+            const std::uint32_t index_size = format == IndexFormat::Uint16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+            if (index_size == mesh_data.IndexSize()) {
+                index_data = mesh_data.IndexBytes();
+            } else {
+                index_bytes.resize(std::size_t{index_count} * sizeof(std::uint16_t));
+                auto *narrow_indices = reinterpret_cast<std::uint16_t *>(index_bytes.data());
+                std::transform(mesh_data.indices.begin(), mesh_data.indices.end(), narrow_indices,
+                               [](std::uint32_t index) { return static_cast<std::uint16_t>(index); });
+                index_data = index_bytes.data();
+            }
+            const UINT ib_size = index_count * index_size;
+            buffers.index_buffer = CreateDefaultBuffer(ib_size, initial_state, buffers.index_buffer_view.address);
+            if (!buffers.index_buffer) {
                 std::wcerr << L"Failed to create index buffer!" << std::endl;
-                return nullptr;
+                ReleaseMeshBuffers(buffers);
+                return false;
             }
-            buffers->index_buffer_view.BufferLocation = buffers->index_buffer->GetGPUVirtualAddress();
-            buffers->index_buffer_view.SizeInBytes = ib_size;
-            buffers->index_buffer_view.Format = DXGI_FORMAT_R32_UINT;
-            buffers->index_count = static_cast<UINT>(mesh_data.indices.size());
-        }
-
-        return buffers;
-    }
-
-    bool Framework::CreateSrvHeap(UINT descriptor_count) {
-        D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-        desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        desc.NumDescriptors = descriptor_count;
-        desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        desc.NodeMask = 0;
-
-        if (FAILED(device_->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&srv_heap_)))) {
-            std::wcerr << L"Failed to create SRV descriptor heap!" << std::endl;
-            return false;
+            buffers.index_buffer_view.size = ib_size;
+            buffers.index_buffer_view.format = format;
         }
-
         return true;
     }
 
-    std::shared_ptr<Texture2D> Framework::CreateSolidTexture(std::uint32_t rgba8) {
-        if (!device_ || !srv_heap_) {
-            return {};
+    std::unique_ptr<MeshBuffers> Framework::CreateMeshBuffers(const MeshData &mesh_data) {
+        auto buffers = std::make_unique<MeshBuffers>();
+        std::vector<std::uint8_t> index_bytes;
+        const std::uint8_t *index_data = nullptr;
+        if (!CreateMeshResources(mesh_data, *buffers, index_bytes, index_data, D3D12_RESOURCE_STATE_COPY_DEST)) {
+            return nullptr;
         }
 
-        const UINT heap_capacity = srv_heap_->GetDesc().NumDescriptors;
-        if (next_srv_index_ >= heap_capacity) {
-            return {};
+        buffers->upload_ticket = uploads_.EnqueueBuffer(FromHandle<ID3D12Resource>(buffers->vertex_buffer.value),
+                                                        mesh_data.VertexBytes(), mesh_data.VertexByteSize(),
+                                                        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        if (!buffers->upload_ticket) {
+            std::wcerr << L"Failed to upload vertex buffer!" << std::endl;
+            ReleaseMeshBuffers(*buffers);
+            return nullptr;
         }
-
-        D3D12_RESOURCE_DESC tex_desc = {};
-        tex_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-        tex_desc.Alignment = 0;
-        tex_desc.Width = 1;
-        tex_desc.Height = 1;
-        tex_desc.DepthOrArraySize = 1;
-        tex_desc.MipLevels = 1;
-        tex_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        tex_desc.SampleDesc.Count = 1;
-        tex_desc.SampleDesc.Quality = 0;
-        tex_desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-        tex_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-        const D3D12_HEAP_PROPERTIES default_heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
-
-        ComPtr<ID3D12Resource> resource;
-        HRESULT hr = device_->CreateCommittedResource(
-                &default_heap_props,
-                D3D12_HEAP_FLAG_NONE,
-                &tex_desc,
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                nullptr,
-                IID_PPV_ARGS(&resource));
-        if (FAILED(hr)) {
-            std::wcerr << L"Failed to create texture resource! hr=0x" << std::hex << hr << std::dec << std::endl;
-            return {};
+        if (buffers->index_buffer) {
+            buffers->upload_ticket = uploads_.EnqueueBuffer(FromHandle<ID3D12Resource>(buffers->index_buffer.value),
+                                                            index_data, buffers->index_buffer_view.size,
+                                                            D3D12_RESOURCE_STATE_INDEX_BUFFER);
+            if (!buffers->upload_ticket) {
+                std::wcerr << L"Failed to upload index buffer!" << std::endl;
+                ReleaseMeshBuffers(*buffers);
+                return nullptr;
+            }
         }
+        return buffers;
+    }
 
-        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
-        UINT num_rows = 0;
-        UINT64 row_size_in_bytes = 0;
-        UINT64 upload_size = 0;
-        device_->GetCopyableFootprints(&tex_desc, 0, 1, 0, &footprint, &num_rows, &row_size_in_bytes, &upload_size);
-
-        const D3D12_HEAP_PROPERTIES upload_heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-        const D3D12_RESOURCE_DESC upload_desc = detail::BufferDesc(upload_size);
-
-        ComPtr<ID3D12Resource> upload;
-        hr = device_->CreateCommittedResource(
-                &upload_heap_props,
-                D3D12_HEAP_FLAG_NONE,
-                &upload_desc,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&upload));
-        if (FAILED(hr)) {
-            std::wcerr << L"Failed to create texture upload buffer! hr=0x" << std::hex << hr << std::dec << std::endl;
-            return {};
+    std::shared_ptr<MeshBuffers> Framework::StreamMeshBuffers(const MeshData &mesh_data) {
+        if (!streamer_.IsValid()) {
+            return nullptr;
         }
-
-        void *mapped = nullptr;
-        hr = upload->Map(0, nullptr, &mapped);
-        if (FAILED(hr)) {
-            std::wcerr << L"Failed to map texture upload buffer! hr=0x" << std::hex << hr << std::dec << std::endl;
-            return {};
+        // COMMON so the copy queue can write the buffers and the frame queue can promote them on first use.
+        auto buffers = std::make_shared<MeshBuffers>();
+        std::vector<std::uint8_t> index_bytes;
+        const std::uint8_t *index_data = nullptr;
+        if (!CreateMeshResources(mesh_data, *buffers, index_bytes, index_data, D3D12_RESOURCE_STATE_COMMON)) {
+            return nullptr;
         }
-        std::memset(mapped, 0, static_cast<size_t>(upload_size));
-        std::memcpy(mapped, &rgba8, sizeof(rgba8));
-        upload->Unmap(0, nullptr);
-
-        if (FAILED(command_allocator_[frame_index_]->Reset())) {
-            return {};
+        // The copy queue reads these on its own thread, so the streamer gets copies it owns.
+        if (index_bytes.empty() && index_data) {
+            index_bytes.assign(index_data, index_data + buffers->index_buffer_view.size);
         }
+        buffers->resident_fence = StreamingTimeline::kNotResident;
+        streamer_.RequestMesh(buffers,
+                              std::vector<std::uint8_t>(mesh_data.VertexBytes(),
+                                                        mesh_data.VertexBytes() + mesh_data.VertexByteSize()),
+                              std::move(index_bytes));
+        return buffers;
+    }
 
-        if (FAILED(command_list_->Reset(command_allocator_[frame_index_].Get(), nullptr))) {
+    std::shared_ptr<Texture2D> Framework::StreamTextureFromFile(const std::wstring &filename) {
+        if (!streamer_.IsValid()) {
             return {};
         }
+        auto texture = std::make_shared<Texture2D>();
+        texture->resident_fence = StreamingTimeline::kNotResident;
+        streamer_.RequestTexture(texture, filename);
+        return texture;
+    }
 
-        D3D12_TEXTURE_COPY_LOCATION dst = {};
-        dst.pResource = resource.Get();
-        dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        dst.SubresourceIndex = 0;
-
-        D3D12_TEXTURE_COPY_LOCATION src = {};
-        src.pResource = upload.Get();
-        src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        src.PlacedFootprint = footprint;
+    void Framework::ProcessStreamingCompletions() {
+        streaming_completions_.clear();
+        streamer_.CollectCompleted(streaming_completions_);
+        for (AssetStreamer::Completion &completion : streaming_completions_) {
+            if (const auto texture = completion.texture.lock()) {
+                const DescriptorHandle srv = CreateTextureSrv(completion.resource.Get());
+                if (!srv.IsValid()) {
+                    continue;
+                }
+                texture->resource = ResourceHandle{RegisterObject(std::move(completion.resource), completion.memory)};
+                texture->srv = srv;
+                texture->resident_fence = completion.fence_value;
+                textures_.push_back(texture);
+            } else if (completion.resource) {
+                // Nobody wants it anymore; make this frame wait for the copy so the memory retires after it.
+                stream_timeline_.Use(completion.fence_value);
+                memory_.Release(completion.memory, pacer_.PendingFenceValue());
+                DeferRelease(std::move(completion.resource));
+            }
+            if (const auto mesh = completion.mesh.lock()) {
+                mesh->resident_fence = completion.fence_value;
+            }
+        }
+    }
 
-        command_list_->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    void Framework::ReleaseMeshBuffers(MeshBuffers &buffers) {
+        Release(buffers.vertex_buffer);
+        Release(buffers.index_buffer);
+        buffers.vertex_buffer = {};
+        buffers.index_buffer = {};
+    }
 
-        const auto barrier = detail::TransitionBarrier(
-                resource.Get(),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-        command_list_->ResourceBarrier(1, &barrier);
+    bool Framework::UseMesh(const MeshBuffers &mesh) {
+        return stream_timeline_.Use(mesh.resident_fence);
+    }
 
-        if (FAILED(command_list_->Close())) {
+    DescriptorHandle Framework::CreateTextureSrv(ID3D12Resource *resource) {
+        DescriptorHandle handle;
+        if (!srv_descriptors_.Allocate(handle, pacer_.PendingFenceValue())) {
+            std::wcerr << L"Failed to allocate texture SRV descriptor!" << std::endl;
             return {};
         }
 
-        ID3D12CommandList *lists[] = {command_list_.Get()};
-        command_queue_->ExecuteCommandLists(static_cast<UINT>(std::size(lists)), lists);
-        WaitForPreviousFrame();
-
-        const UINT descriptor_index = next_srv_index_++;
-
-        D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle = srv_heap_->GetCPUDescriptorHandleForHeapStart();
-        cpu_handle.ptr += static_cast<SIZE_T>(descriptor_index) * srv_descriptor_size_;
-
-        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle = srv_heap_->GetGPUDescriptorHandleForHeapStart();
-        gpu_handle.ptr += static_cast<UINT64>(descriptor_index) * srv_descriptor_size_;
-
         D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
         srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
         srv_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -423,26 +385,86 @@ namespace gfw {
         srv_desc.Texture2D.MostDetailedMip = 0;
         srv_desc.Texture2D.MipLevels = 1;
         srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
+        device_->CreateShaderResourceView(resource, &srv_desc, srv_descriptors_.StagingHandle(handle));
+        srv_descriptors_.Publish(handle);
+        return handle;
+    }
+
+    void Framework::ReleaseTexture(const std::shared_ptr<Texture2D> &texture) {
+        if (!texture || texture == default_texture_) {
+            return;
+        }
+        const auto it = std::find(textures_.begin(), textures_.end(), texture);
+        if (it == textures_.end()) {
+            return;
+        }
+        // The frame being recorded is retired by the pending fence value.
+        srv_descriptors_.Release(texture->srv, pacer_.PendingFenceValue());
+        Release(texture->resource);
+        textures_.erase(it);
+    }
 
-        device_->CreateShaderResourceView(resource.Get(), &srv_desc, cpu_handle);
+    UINT Framework::GetBindlessIndex(const Texture2D *texture) {
+        if (texture && stream_timeline_.Use(texture->resident_fence) && srv_descriptors_.IsAlive(texture->srv)) {
+            return texture->srv.index;
+        }
+        return default_texture_ ? default_texture_->srv.index : 0;
+    }
+
+    std::shared_ptr<Texture2D> Framework::CreateBindlessTexture(ComPtr<ID3D12Resource> resource,
+                                                                const GpuAllocation &memory, UploadTicket ticket) {
+        const DescriptorHandle srv = CreateTextureSrv(resource.Get());
+        if (!srv.IsValid()) {
+            GpuAllocation unused = memory;
+            memory_.Release(unused, pacer_.PendingFenceValue());
+            DeferRelease(std::move(resource));
+            return {};
+        }
 
         auto texture = std::make_shared<Texture2D>();
-        texture->resource = resource;
-        texture->srv_gpu = gpu_handle;
+        texture->resource = ResourceHandle{RegisterObject(std::move(resource), memory)};
+        texture->srv = srv;
+        texture->upload_ticket = ticket;
         textures_.push_back(texture);
         return texture;
     }
 
-    std::shared_ptr<Texture2D> Framework::CreateTextureFromFile(const std::wstring &filename) {
-        if (!device_ || !srv_heap_) {
+    std::shared_ptr<Texture2D> Framework::CreateSolidTexture(std::uint32_t rgba8) {
+        if (!device_ || !srv_descriptors_.IsValid()) {
+            return {};
+        }
+
+        D3D12_RESOURCE_DESC tex_desc = {};
+        tex_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        tex_desc.Alignment = 0;
+        tex_desc.Width = 1;
+        tex_desc.Height = 1;
+        tex_desc.DepthOrArraySize = 1;
+        tex_desc.MipLevels = 1;
+        tex_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        tex_desc.SampleDesc.Count = 1;
+        tex_desc.SampleDesc.Quality = 0;
+        tex_desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        tex_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+        ComPtr<ID3D12Resource> resource;
+        GpuAllocation memory;
+        if (!memory_.CreateResource(MemoryCategory::Texture, tex_desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+                                    memory, resource)) {
+            std::wcerr << L"Failed to create texture resource!" << std::endl;
             return {};
         }
 
-        const UINT heap_capacity = srv_heap_->GetDesc().NumDescriptors;
-        if (next_srv_index_ >= heap_capacity) {
+        const UploadTicket ticket = uploads_.EnqueueTexture(resource.Get(), &rgba8, 1, 1,
+                                                            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        if (!ticket) {
             return {};
         }
 
+        return CreateBindlessTexture(std::move(resource), memory, ticket);
+    }
+
+    bool Framework::DecodeTextureFile(const std::wstring &filename, DecodedTexture &out) {
         UINT width = 0;
         UINT height = 0;
         std::vector<std::uint8_t> rgba_data;
@@ -480,7 +502,7 @@ namespace gfw {
         }
 
         if (!loaded && EndsWithTga(filename)) {
-            DecodedImage tga;
+            DecodedTexture tga;
             if (LoadTgaImage(filename, tga)) {
                 width = tga.width;
                 height = tga.height;
@@ -490,10 +512,25 @@ namespace gfw {
         }
 
         if (!loaded || width == 0 || height == 0 || rgba_data.empty()) {
+            return false;
+        }
+        out.width = width;
+        out.height = height;
+        out.rgba = std::move(rgba_data);
+        return true;
+    }
+
+    std::shared_ptr<Texture2D> Framework::CreateTextureFromFile(const std::wstring &filename) {
+        if (!device_ || !srv_descriptors_.IsValid()) {
             return {};
         }
 
-        const UINT src_row_pitch = width * 4;
+        DecodedTexture image;
+        if (!DecodeTextureFile(filename, image)) {
+            return {};
+        }
+        const UINT width = image.width;
+        const UINT height = image.height;
 
         D3D12_RESOURCE_DESC tex_desc = {};
         tex_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -508,99 +545,138 @@ namespace gfw {
         tex_desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
         tex_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-        const D3D12_HEAP_PROPERTIES default_heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
         ComPtr<ID3D12Resource> resource;
-        if (FAILED(device_->CreateCommittedResource(
-                &default_heap_props, D3D12_HEAP_FLAG_NONE, &tex_desc,
-                D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource)))) {
+        GpuAllocation memory;
+        if (!memory_.CreateResource(MemoryCategory::Texture, tex_desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+                                    memory, resource)) {
             return {};
         }
 
-        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
-        UINT num_rows = 0;
-        UINT64 row_size_in_bytes = 0;
-        UINT64 upload_size = 0;
-        device_->GetCopyableFootprints(&tex_desc, 0, 1, 0, &footprint, &num_rows, &row_size_in_bytes, &upload_size);
-
-        const D3D12_HEAP_PROPERTIES upload_heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-        const D3D12_RESOURCE_DESC upload_desc = detail::BufferDesc(upload_size);
-        ComPtr<ID3D12Resource> upload;
-        if (FAILED(device_->CreateCommittedResource(
-                &upload_heap_props, D3D12_HEAP_FLAG_NONE, &upload_desc,
-                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&upload)))) {
+        const UploadTicket ticket = uploads_.EnqueueTexture(resource.Get(), image.rgba.data(), width, height,
+                                                            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        if (!ticket) {
             return {};
         }
 
-        void *mapped = nullptr;
-        if (FAILED(upload->Map(0, nullptr, &mapped))) {
+        return CreateBindlessTexture(std::move(resource), memory, ticket);
+    }
+
+    std::shared_ptr<Texture2D> Framework::CreateSolidTexture(const DirectX::XMFLOAT4 &color) {
+        return CreateSolidTexture(PackRGBA8(color));
+    }
+
+    ResourceHandle Framework::CreateTexture(const TextureDesc &desc) {
+        const DXGI_FORMAT format = ToD3D12(desc.format);
+        if (desc.width == 0 || desc.height == 0 || format == DXGI_FORMAT_UNKNOWN) {
+            std::wcerr << L"CreateTexture: invalid texture description!" << std::endl;
             return {};
         }
-        std::memset(mapped, 0, static_cast<size_t>(upload_size));
-        auto *dst_bytes = static_cast<std::uint8_t *>(mapped);
-        for (UINT y = 0; y < height; ++y) {
-            const auto *src_row = rgba_data.data() + static_cast<size_t>(y) * src_row_pitch;
-            auto *dst_row = dst_bytes + static_cast<size_t>(y) * footprint.Footprint.RowPitch;
-            std::memcpy(dst_row, src_row, src_row_pitch);
-        }
-        upload->Unmap(0, nullptr);
 
-        if (FAILED(command_allocator_[frame_index_]->Reset())) {
-            return {};
+        const bool depth = desc.format == Format::D32Float;
+        D3D12_RESOURCE_DESC tex_desc = detail::Texture2DDesc(desc.width, desc.height, format);
+        D3D12_CLEAR_VALUE clear_value = {};
+        clear_value.Format = format;
+        clear_value.DepthStencil.Depth = 1.0f;
+        const D3D12_CLEAR_VALUE *optimized_clear = nullptr;
+        if (depth) {
+            tex_desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+            optimized_clear = &clear_value;
+        } else if (desc.render_target) {
+            tex_desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+            optimized_clear = &clear_value;
         }
-        if (FAILED(command_list_->Reset(command_allocator_[frame_index_].Get(), nullptr))) {
+
+        ComPtr<ID3D12Resource> resource;
+        GpuAllocation memory;
+        const MemoryCategory category = optimized_clear ? MemoryCategory::RenderTarget : MemoryCategory::Texture;
+        if (!memory_.CreateResource(category, tex_desc, ToD3D12(desc.initial_state), optimized_clear, memory,
+                                    resource)) {
+            std::wcerr << L"Failed to create texture resource!" << std::endl;
             return {};
         }
+        return ResourceHandle{RegisterObject(std::move(resource), memory)};
+    }
 
-        D3D12_TEXTURE_COPY_LOCATION dst = {};
-        dst.pResource = resource.Get();
-        dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        dst.SubresourceIndex = 0;
-
-        D3D12_TEXTURE_COPY_LOCATION src = {};
-        src.pResource = upload.Get();
-        src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        src.PlacedFootprint = footprint;
-
-        command_list_->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-
-        const auto barrier = detail::TransitionBarrier(
-                resource.Get(),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-        command_list_->ResourceBarrier(1, &barrier);
+    DescriptorHeapHandle Framework::CreateDescriptorHeap(DescriptorHeapType type, std::uint32_t count) {
+        D3D12_DESCRIPTOR_HEAP_DESC heap_desc = {};
+        heap_desc.NumDescriptors = count;
+        if (type == DescriptorHeapType::RenderTarget) {
+            heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+            heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        } else {
+            heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+            heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        }
 
-        if (FAILED(command_list_->Close())) {
+        ComPtr<ID3D12DescriptorHeap> heap;
+        if (count == 0 || FAILED(device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(&heap)))) {
+            std::wcerr << L"Failed to create Descriptor Heap!" << std::endl;
             return {};
         }
+        return DescriptorHeapHandle{RegisterObject(std::move(heap))};
+    }
 
-        ID3D12CommandList *lists[] = {command_list_.Get()};
-        command_queue_->ExecuteCommandLists(static_cast<UINT>(std::size(lists)), lists);
-        WaitForPreviousFrame();
+    bool Framework::CreateRenderTargetView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                           Format format) {
+        auto *d3d_heap = FromHandle<ID3D12DescriptorHeap>(heap.value);
+        if (!d3d_heap || !resource || format == Format::Unknown || index >= d3d_heap->GetDesc().NumDescriptors) {
+            std::wcerr << L"CreateRenderTargetView: invalid view!" << std::endl;
+            return false;
+        }
+
+        D3D12_RENDER_TARGET_VIEW_DESC rtv_desc = {};
+        rtv_desc.Format = ToD3D12(format);
+        rtv_desc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
+        device_->CreateRenderTargetView(FromHandle<ID3D12Resource>(resource.value), &rtv_desc,
+                                        D3D12_CPU_DESCRIPTOR_HANDLE{GetCpuDescriptor(heap, index).value});
+        return true;
+    }
 
-        const UINT descriptor_index = next_srv_index_++;
-        D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle = srv_heap_->GetCPUDescriptorHandleForHeapStart();
-        cpu_handle.ptr += static_cast<SIZE_T>(descriptor_index) * srv_descriptor_size_;
-        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle = srv_heap_->GetGPUDescriptorHandleForHeapStart();
-        gpu_handle.ptr += static_cast<UINT64>(descriptor_index) * srv_descriptor_size_;
+    bool Framework::CreateShaderResourceView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                             Format format) {
+        auto *d3d_heap = FromHandle<ID3D12DescriptorHeap>(heap.value);
+        if (!d3d_heap || !resource || format == Format::Unknown || index >= d3d_heap->GetDesc().NumDescriptors) {
+            std::wcerr << L"CreateShaderResourceView: invalid view!" << std::endl;
+            return false;
+        }
 
         D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
         srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srv_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        srv_desc.Format = ToD3D12(format);
         srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        srv_desc.Texture2D.MostDetailedMip = 0;
         srv_desc.Texture2D.MipLevels = 1;
-        srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-        device_->CreateShaderResourceView(resource.Get(), &srv_desc, cpu_handle);
+        device_->CreateShaderResourceView(FromHandle<ID3D12Resource>(resource.value), &srv_desc,
+                                          D3D12_CPU_DESCRIPTOR_HANDLE{GetCpuDescriptor(heap, index).value});
+        return true;
+    }
 
-        auto texture = std::make_shared<Texture2D>();
-        texture->resource = resource;
-        texture->srv_gpu = gpu_handle;
-        textures_.push_back(texture);
-        return texture;
+    CpuDescriptor Framework::GetCpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const {
+        auto *d3d_heap = FromHandle<ID3D12DescriptorHeap>(heap.value);
+        if (!d3d_heap) {
+            return {};
+        }
+        const UINT stride = descriptor_sizes_[d3d_heap->GetDesc().Type];
+        return CpuDescriptor{d3d_heap->GetCPUDescriptorHandleForHeapStart().ptr + static_cast<SIZE_T>(index) * stride};
     }
 
-    std::shared_ptr<Texture2D> Framework::CreateSolidTexture(const DirectX::XMFLOAT4 &color) {
-        return CreateSolidTexture(PackRGBA8(color));
+    GpuDescriptor Framework::GetGpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const {
+        auto *d3d_heap = FromHandle<ID3D12DescriptorHeap>(heap.value);
+        if (!d3d_heap) {
+            return {};
+        }
+        const UINT stride = descriptor_sizes_[d3d_heap->GetDesc().Type];
+        return GpuDescriptor{d3d_heap->GetGPUDescriptorHandleForHeapStart().ptr + static_cast<UINT64>(index) * stride};
     }
-}
 
+    void Framework::ReleaseObject(std::uint64_t handle) {
+        std::lock_guard lock(objects_mutex_);
+        const auto it = objects_.find(handle);
+        if (it == objects_.end()) {
+            return;
+        }
+        // The frame being recorded may still use the object; it retires with that frame's fence value.
+        memory_.Release(it->second.memory, pacer_.PendingFenceValue());
+        released_resources_.emplace_back(pacer_.PendingFenceValue(), std::move(it->second.object));
+        objects_.erase(it);
+    }
+}
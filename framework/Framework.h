@@ -15,23 +15,54 @@
 #include <dxgi1_4.h>
 #include <wrl/client.h>
 #include <vector>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
 #include "Exports.h"
 #include "Window.h"
 #include "FrameworkTypes.h"
 #include "Constants.h"
 #include "DeviceManager.h"
+#include "UploadRing.h"
+#include "DescriptorHeap.h"
+#include "UploadBatcher.h"
+#include "GpuMemoryAllocator.h"
+#include "AssetStreamer.h"
+#include "StreamingTimeline.h"
+#include "FramePacer.h"
+#include "PipelineCache.h"
+#include "CommandRecorder.h"
+#include "D3D12CommandRecorder.h"
+#include "CommandCapture.h"
+#include "RenderDevice.h"
 
 using Microsoft::WRL::ComPtr;
 
 namespace gfw {
 
-class GAMEFRAMEWORK_API Framework {
+// The D3D12 RenderDevice: a window's swap chain, placed resources and the frame loop. Handles are the
+// interface pointers of the objects behind them.
+class GAMEFRAMEWORK_API Framework : public RenderDevice {
 private:
-    static constexpr UINT FRAME_COUNT = 2;
+    // Initial upload ring size; holds a few thousand GeometryCB slices before it has to grow.
+    static constexpr UINT64 kUploadRingSize = 1024 * 1024;
+    // Staging ring for texture and buffer uploads; larger uploads get a dedicated buffer.
+    static constexpr UINT64 kUploadStagingSize = 64ull * 1024 * 1024;
+    // Staging ring of the streaming copy queue; shared by all batches the worker has in flight.
+    static constexpr UINT64 kStreamingStagingSize = 32ull * 1024 * 1024;
+    // Placed-resource heap block size per memory category; larger resources get a dedicated block.
+    static constexpr UINT64 kGpuMemoryBlockSize = 64ull * 1024 * 1024;
+    // Initial SRV heap size; it doubles when a material set needs more.
+    static constexpr UINT kInitialSrvDescriptors = 256;
+    // Driver-compiled pipeline blobs, relative to the working directory like shaders/.
+    static constexpr const wchar_t *kPipelineCacheFile = L"PipelineCache.gfwpso";
 
     Window *window_ = nullptr;
+    UINT width_ = 0;
+    UINT height_ = 0;
 
     DeviceManager device_manager_;
     ComPtr<IDXGIFactory4> factory_;
@@ -40,59 +71,145 @@ private:
     ComPtr<IDXGISwapChain3> swap_chain_;
     ComPtr<ID3D12DescriptorHeap> rtv_heap_;
     ComPtr<ID3D12DescriptorHeap> dsv_heap_;
-    ComPtr<ID3D12DescriptorHeap> srv_heap_;
-    ComPtr<ID3D12CommandAllocator> command_allocator_[FRAME_COUNT];
+    // One per back buffer; reset only after the fence of the frame that last used it has completed.
+    ComPtr<ID3D12CommandAllocator> command_allocator_[FramePacer::kMaxFramesInFlight];
+    // Segment of the frame's command list being recorded. InsertCommandLists closes it and continues on the
+    // next segment, all on the frame's allocator; EndFrame submits every segment with one ExecuteCommandLists.
     ComPtr<ID3D12GraphicsCommandList> command_list_;
+    std::vector<ComPtr<ID3D12GraphicsCommandList>> command_list_segments_;
+    size_t command_list_segment_ = 0;
+    std::vector<ID3D12CommandList *> frame_submission_;
     ComPtr<ID3D12Fence> fence_;
+    // What GetRecorder() hands out; bound to command_list_.
+    D3D12CommandRecorder d3d12_recorder_;
+    // CaptureNextFrame: the frame being captured also records into capture_list_, and UploadConstants copies
+    // its constants into capture_.
+    CommandCapture capture_;
+    RecordingCommandList capture_list_;
+    std::wstring capture_path_;
+    bool capture_requested_ = false;
+    bool capturing_ = false;
 
     ComPtr<ID3D12RootSignature> root_signature_;
     ComPtr<ID3D12PipelineState> pipeline_state_;
     ComPtr<ID3D12PipelineState> pipeline_state_transparent_;
     ComPtr<ID3D12PipelineState> pipeline_state_rainbow_;
 
-    ComPtr<ID3D12Resource> depth_stencil_;
-
-    ComPtr<ID3D12Resource> constant_buffer_;
-    std::uint8_t *constant_buffer_mapped_ = nullptr;
+    // Backs CreateGraphicsPipeline; loaded in Initialize and written back in Shutdown when it changed.
+    PipelineCache pipeline_cache_;
+    std::atomic<UINT> pipeline_cache_hits_ = 0;
+    std::atomic<UINT> pipeline_cache_misses_ = 0;
 
-    SceneState scene_state_ = {};
+    // Every DEFAULT-heap texture, buffer and target is placed into blocks owned by this allocator.
+    GpuMemoryAllocator memory_;
+    ComPtr<ID3D12Resource> depth_stencil_;
+    GpuAllocation depth_stencil_memory_;
+
+    // Per-draw constants for this and the RenderingSystem passes; retired per frame by fence value.
+    UploadRing upload_ring_;
+    // Static geometry and texture uploads; batches are submitted on command_queue_ ahead of the next frame.
+    UploadBatcher uploads_;
+    // Runtime texture and mesh streaming on a dedicated copy queue; frames wait on its fence only when they
+    // reference something it filled and the GPU has not finished yet.
+    AssetStreamer streamer_;
+    StreamingTimeline stream_timeline_;
+    std::vector<AssetStreamer::Completion> streaming_completions_;
+
+    // Texture SRVs, indexed by the bindless Texture2D[] table of the GBuffer shaders.
+    DescriptorHeap srv_descriptors_;
     std::vector<std::shared_ptr<Texture2D>> textures_;
     std::shared_ptr<Texture2D> default_texture_;
-    UINT srv_descriptor_size_ = 0;
-    UINT next_srv_index_ = 0;
-
-    D3D12_VIEWPORT viewport_{};
-    D3D12_RECT scissor_rect_{};
+    // Everything a handle from CreateTexture, CreateDescriptorHeap, CreateRootSignature, CreatePipeline or the
+    // mesh and texture functions refers to, keyed by handle value, with the placed memory of resources.
+    struct RegisteredObject {
+        ComPtr<ID3D12DeviceChild> object;
+        GpuAllocation memory = {};
+    };
+    mutable std::mutex objects_mutex_;
+    std::unordered_map<std::uint64_t, RegisteredObject> objects_;
+    // Released objects stay alive until the fence value of the last frame that could use them completes.
+    std::vector<std::pair<UINT64, ComPtr<ID3D12DeviceChild>>> released_resources_;
+
+    Viewport viewport_ = {};
+    ScissorRect scissor_rect_ = {};
 
     UINT rtv_descriptor_size_ = 0;
+    UINT descriptor_sizes_[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] = {};
     UINT frame_index_ = 0;
-    UINT64 fence_value_ = 0;
+    FramePacer pacer_;
+    std::chrono::steady_clock::time_point frame_start_ = {};
     HANDLE fence_event_ = nullptr;
     bool com_initialized_ = false;
 
     std::vector<ComPtr<ID3D12Resource>> render_targets_;
 
-    void WaitForPreviousFrame();
+    bool CreateBackBuffers(UINT frame_count);
+
+    void WaitForFence(UINT64 value);
+
+    // Ends the capture of the frame being recorded and writes it to capture_path_.
+    void FinishCapture();
+
+    // Drains the queue; only used outside the frame loop.
+    void WaitForGpu();
 
     bool CreateDepthResources();
 
     bool CreatePhongPipeline();
 
-    bool CreateConstantBuffer();
+    // Serializes and creates a root signature, tagged with the hash of its serialized form so pipeline cache
+    // keys can refer to it.
+    bool CreateD3D12RootSignature(const D3D12_ROOT_SIGNATURE_DESC &desc, ComPtr<ID3D12RootSignature> &out);
+
+    // CreateGraphicsPipelineState through the on-disk pipeline cache, keyed by a hash of everything desc
+    // describes (shader bytecode, root signature, fixed-function state, formats, topology). Thread-safe.
+    bool CreateD3D12Pipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &out);
+
+    // Takes ownership of object (and memory) until Release; returns its handle value, the pointer to T.
+    template <typename T>
+    std::uint64_t RegisterObject(ComPtr<T> object, const GpuAllocation &memory = {}) {
+        const auto handle = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object.Get()));
+        std::lock_guard lock(objects_mutex_);
+        objects_[handle] = {std::move(object), memory};
+        return handle;
+    }
+
+    // Drops the registry entry of handle; the object and its memory retire with the frame being recorded.
+    void ReleaseObject(std::uint64_t handle);
+
+    DescriptorHandle CreateTextureSrv(ID3D12Resource *resource);
+
+    // index_data points at the bytes to upload into the index buffer: the mesh's own indices when they are
+    // already stored at the buffer's width, otherwise index_bytes holding the narrowed copy.
+    bool CreateMeshResources(const MeshData &mesh_data, MeshBuffers &buffers, std::vector<std::uint8_t> &index_bytes,
+                             const std::uint8_t *&index_data, D3D12_RESOURCE_STATES initial_state);
+
+    // A DEFAULT-heap buffer for static geometry, registered under the returned handle.
+    ResourceHandle CreateDefaultBuffer(UINT size, D3D12_RESOURCE_STATES initial_state, GpuAddress &address);
 
-    bool CreateSrvHeap(UINT descriptor_count);
+    // Registers resource and memory and fills in a bindless SRV for it.
+    std::shared_ptr<Texture2D> CreateBindlessTexture(ComPtr<ID3D12Resource> resource, const GpuAllocation &memory,
+                                                     UploadTicket ticket);
+
+    // Publishes SRVs and residency for everything the streamer finished since the last frame.
+    void ProcessStreamingCompletions();
+
+    // WIC for common formats, a built-in reader for TGA. Thread-safe; the streaming worker calls it too.
+    static bool DecodeTextureFile(const std::wstring &filename, DecodedTexture &out);
 
     std::shared_ptr<Texture2D> CreateSolidTexture(std::uint32_t rgba8);
 
     [[nodiscard]] bool IsRenderReady() const;
 
     void RenderMeshImpl(const MeshBuffers &buffers, const SceneConstants &constants,
-                        D3D12_GPU_DESCRIPTOR_HANDLE texture_srv, bool transparent);
+                        const Texture2D *texture, bool transparent);
 
 public:
+    static constexpr UINT kDefaultFramesInFlight = 2;
+
     Framework();
 
-    ~Framework();
+    ~Framework() override;
 
     Framework(const Framework &) = delete;
 
@@ -102,22 +219,147 @@ public:
 
     Framework &operator=(Framework &&) = delete;
 
-    bool Initialize(Window *window);
+    // frames_in_flight is clamped to FramePacer's 2-4 range; it is also the swap chain's buffer count.
+    bool Initialize(Window *window, UINT frames_in_flight = kDefaultFramesInFlight);
 
     void Shutdown();
 
-    void BeginFrame();
+    [[nodiscard]] RenderBackend GetBackend() const override { return RenderBackend::D3D12; }
+    [[nodiscard]] bool IsInitialized() const override { return device_manager_.IsValid(); }
+    [[nodiscard]] std::uint32_t GetWidth() const override { return width_; }
+    [[nodiscard]] std::uint32_t GetHeight() const override { return height_; }
+    [[nodiscard]] std::uint32_t GetFramesInFlight() const override { return pacer_.FramesInFlight(); }
+    // Back buffer slot of the frame being recorded; per-slot resources are safe to reuse after BeginFrame.
+    [[nodiscard]] std::uint32_t GetFrameSlot() const override { return frame_index_; }
+    // Fence value that retires the frame being recorded; pass it to deferred Release calls.
+    [[nodiscard]] std::uint64_t GetPendingFenceValue() const override { return pacer_.PendingFenceValue(); }
+
+    [[nodiscard]] Viewport GetViewport() const override { return viewport_; }
+    [[nodiscard]] ScissorRect GetScissorRect() const override { return scissor_rect_; }
+    [[nodiscard]] CpuDescriptor GetBackBufferRtv() const override {
+        return CpuDescriptor{rtv_heap_->GetCPUDescriptorHandleForHeapStart().ptr +
+                             static_cast<SIZE_T>(frame_index_) * rtv_descriptor_size_};
+    }
+    [[nodiscard]] CpuDescriptor GetDepthDsv() const override {
+        return dsv_heap_ ? ToHandle(dsv_heap_->GetCPUDescriptorHandleForHeapStart()) : CpuDescriptor{};
+    }
+
+    void BeginFrame() override;
 
     void ClearRenderTarget(float r, float g, float b, float a);
 
-    void EndFrame();
+    void EndFrame() override;
+
+    // Records into command_list_; valid between BeginFrame and EndFrame.
+    [[nodiscard]] CommandRecorder &GetRecorder() override { return d3d12_recorder_; }
+
+    [[nodiscard]] std::unique_ptr<DeviceCommandList> CreateCommandList(std::uint32_t frame_slots) override;
+
+    // Ends the current command list segment and queues lists (e.g. recorded by worker threads) right after it
+    // in this frame's submission. Recording continues on a fresh segment: rebind pipeline state; only viewport
+    // and scissor are restored.
+    bool InsertCommandLists(const std::vector<CommandRecorder *> &lists) override;
+
+    // Copies size bytes into this frame's slice of the upload ring and returns its 256-byte aligned address
+    // for a root CBV; 0 on failure. The memory stays valid until the GPU has finished the frame.
+    using RenderDevice::UploadConstants;
+    GpuAddress UploadConstants(const void *data, std::uint32_t size) override;
+
+    std::unique_ptr<MeshBuffers> CreateMeshBuffers(const MeshData &mesh_data) override;
+
+    // Like CreateMeshBuffers, but the data is copied on the streaming queue; draws skip the mesh until then.
+    std::shared_ptr<MeshBuffers> StreamMeshBuffers(const MeshData &mesh_data) override;
 
-    [[nodiscard]] bool IsInitialized() const { return device_manager_.IsValid(); }
+    // False while mesh is still streaming; otherwise makes this frame wait for its copy on the GPU if needed.
+    bool UseMesh(const MeshBuffers &mesh) override;
 
-    std::unique_ptr<MeshBuffers> CreateMeshBuffers(const MeshData &mesh_data);
+    // Returns the buffers' memory to the allocator once in-flight frames are done with it.
+    void ReleaseMeshBuffers(MeshBuffers &buffers) override;
 
-    std::shared_ptr<Texture2D> CreateSolidTexture(const DirectX::XMFLOAT4 &color);
-    std::shared_ptr<Texture2D> CreateTextureFromFile(const std::wstring &filename);
+    std::shared_ptr<Texture2D> CreateSolidTexture(const DirectX::XMFLOAT4 &color) override;
+    std::shared_ptr<Texture2D> CreateTextureFromFile(const std::wstring &filename) override;
+
+    // Returns immediately with a texture that samples as the default texture until the copy queue has filled
+    // it; decoding happens on the streaming worker.
+    std::shared_ptr<Texture2D> StreamTextureFromFile(const std::wstring &filename) override;
+
+    // Drops the framework's reference and recycles the SRV slot once in-flight frames are done with it.
+    void ReleaseTexture(const std::shared_ptr<Texture2D> &texture) override;
+
+    // Submits every upload enqueued by CreateMeshBuffers and the texture functions as one batch. BeginFrame
+    // does this too, so callers only need it to wait on or poll the returned ticket.
+    UploadTicket FlushUploads() override { return uploads_.Flush(); }
+
+    [[nodiscard]] bool IsUploadComplete(UploadTicket ticket) const { return uploads_.IsComplete(ticket); }
+
+    void WaitForUploads(UploadTicket ticket) { uploads_.Wait(ticket); }
+
+    // Index into the bindless table for texture; the default white texture for null, released or
+    // still-streaming ones.
+    [[nodiscard]] std::uint32_t GetBindlessIndex(const Texture2D *texture) override;
+
+    [[nodiscard]] DescriptorHeapHandle GetBindlessHeap() const override {
+        return ToHandle(srv_descriptors_.ShaderVisibleHeap());
+    }
+
+    // Start of the table covering every texture SRV; bind it once with GetBindlessHeap() set.
+    [[nodiscard]] GpuDescriptor GetBindlessTable() const override { return ToHandle(srv_descriptors_.GpuStart()); }
+
+    // Placed in the render target or texture blocks of the memory allocator; render targets clear to zero.
+    [[nodiscard]] ResourceHandle CreateTexture(const TextureDesc &desc) override;
+    [[nodiscard]] DescriptorHeapHandle CreateDescriptorHeap(DescriptorHeapType type, std::uint32_t count) override;
+    bool CreateRenderTargetView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                Format format) override;
+    bool CreateShaderResourceView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                  Format format) override;
+    [[nodiscard]] CpuDescriptor GetCpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const override;
+    [[nodiscard]] GpuDescriptor GetGpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const override;
+
+    [[nodiscard]] RootSignatureHandle CreateRootSignature(const RootSignatureDesc &desc) override;
+    // Loads the shaders (see ShaderLibrary) and creates the pipeline through the pipeline cache.
+    [[nodiscard]] PipelineHandle CreatePipeline(const PipelineDesc &desc) override;
+
+    void Release(ResourceHandle resource) override { ReleaseObject(resource.value); }
+    void Release(DescriptorHeapHandle heap) override { ReleaseObject(heap.value); }
+    void Release(RootSignatureHandle root_signature) override { ReleaseObject(root_signature.value); }
+    void Release(PipelineHandle pipeline) override { ReleaseObject(pipeline.value); }
+
+    // Keeps a transient resource alive until the frame being recorded has finished on the GPU.
+    void DeferRelease(ComPtr<ID3D12Resource> resource) {
+        std::lock_guard lock(objects_mutex_);
+        released_resources_.emplace_back(pacer_.PendingFenceValue(), std::move(resource));
+    }
+
+    [[nodiscard]] GpuMemoryAllocator &GetMemoryAllocator() { return memory_; }
+
+    // Rolling CPU/GPU overlap statistics of the frame loop.
+    [[nodiscard]] const FramePacer::Timeline &GetFrameTimeline() const { return pacer_.GetTimeline(); }
+
+    // Upload batches submitted by BeginFrame, Flush and the loaders so far.
+    [[nodiscard]] const UploadBatchState::Stats &GetUploadStats() const { return uploads_.GetStats(); }
+
+    // Batches the streaming worker has submitted on the copy queue so far.
+    [[nodiscard]] AssetStreamer::Stats GetStreamingStats() const { return streamer_.GetStats(); }
+
+    void LogMemoryStats() const override { memory_.LogStats(); }
+
+    // Captures the commands and constants of the next frame from BeginFrame to EndFrame, and writes them to
+    // filename (a .gfwcap; empty keeps the capture in memory only). See CommandCapture.
+    void CaptureNextFrame(const std::wstring &filename) override {
+        capture_path_ = filename;
+        capture_requested_ = true;
+    }
+
+    // True between BeginFrame and EndFrame of a captured frame.
+    [[nodiscard]] bool IsCapturing() const override { return capturing_; }
+
+    // The last finished capture; empty until one was taken.
+    [[nodiscard]] const CommandCapture &GetLastCapture() const override { return capture_; }
+
+    // Re-submits a live capture iterations times outside the frame loop: constants are uploaded again and the
+    // stream is recorded and executed like a frame, but nothing is presented. Call between EndFrame and
+    // BeginFrame while everything the capture references is still alive.
+    bool ReplayCapture(const CommandCapture &capture, std::uint32_t iterations) override;
 
     void RenderMesh(const MeshBuffers &buffers, const DirectX::XMMATRIX &world_matrix, double total_time);
 
@@ -125,24 +367,10 @@ public:
 
     void RenderObject(const ::gfw::RenderObject &object, double total_time);
 
-    [[nodiscard]] const SceneState &GetSceneState() const { return scene_state_; }
-
-    void SetCamera(const Camera& camera) { scene_state_.camera = camera; }
-
     [[nodiscard]] ID3D12Device *GetDevice() const { return device_.Get(); }
+    // The D3D12 list behind GetRecorder().
     [[nodiscard]] ID3D12GraphicsCommandList *GetCommandList() const { return command_list_.Get(); }
-    [[nodiscard]] ID3D12DescriptorHeap *GetSrvHeap() const { return srv_heap_.Get(); }
-    [[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetDepthDsvHandle() const {
-        return dsv_heap_ ? dsv_heap_->GetCPUDescriptorHandleForHeapStart() : D3D12_CPU_DESCRIPTOR_HANDLE{};
-    }
-    [[nodiscard]] D3D12_VIEWPORT GetViewport() const { return viewport_; }
-    [[nodiscard]] D3D12_RECT GetScissorRect() const { return scissor_rect_; }
-    [[nodiscard]] UINT GetSrvDescriptorSize() const { return srv_descriptor_size_; }
-    [[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetCurrentBackBufferRtv() const {
-        D3D12_CPU_DESCRIPTOR_HANDLE rtv = rtv_heap_->GetCPUDescriptorHandleForHeapStart();
-        rtv.ptr += static_cast<SIZE_T>(frame_index_) * rtv_descriptor_size_;
-        return rtv;
-    }
+    [[nodiscard]] UINT GetSrvDescriptorSize() const { return srv_descriptors_.DescriptorSize(); }
 
 };
 }
@@ -45,6 +45,22 @@ inline D3D12_RESOURCE_DESC BufferDesc(UINT64 size) {
     return desc;
 }
 
+inline D3D12_RESOURCE_DESC Texture2DDesc(UINT64 width, UINT height, DXGI_FORMAT format) {
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Alignment = 0;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    return desc;
+}
+
 inline D3D12_RESOURCE_BARRIER TransitionBarrier(
         ID3D12Resource *resource,
         D3D12_RESOURCE_STATES before,
@@ -1,19 +1,23 @@
 #pragma once
 
-#include <d3d12.h>
-#include <wrl/client.h>
 #include <DirectXMath.h>
+#include <cstdint>
 #include <memory>
-#include "Exports.h"
-#include "../MeshData.h"
-
-using Microsoft::WRL::ComPtr;
+#include "CommandRecorder.h"
+#include "DescriptorAllocator.h"
+#include "MeshBuffers.h"
 
 namespace gfw {
 
+// The resource belongs to the device that created the texture until RenderDevice::ReleaseTexture.
 struct Texture2D {
-    ComPtr<ID3D12Resource> resource;
-    D3D12_GPU_DESCRIPTOR_HANDLE srv_gpu = {};
+    ResourceHandle resource;
+    // Slot in the device's bindless SRV heap; see RenderDevice::GetBindlessIndex.
+    DescriptorHandle srv = {};
+    // UploadTicket of the batch that copies the pixels in; see RenderDevice::FlushUploads.
+    std::uint64_t upload_ticket = 0;
+    // Streaming-fence value the pixels are resident after; see RenderDevice::StreamTextureFromFile.
+    std::uint64_t resident_fence = 0;
 };
 
 struct RenderObject {
@@ -26,6 +30,12 @@ struct RenderObject {
     // Optional textures for advanced shading (can be null).
     std::shared_ptr<Texture2D> normal_texture = {};
     std::shared_ptr<Texture2D> displacement_texture = {};
+    // GeometryFeature bits (GeometryPermutations.h) the material asks for, e.g. alpha test. Normal map and
+    // displacement follow from the textures above; vertex format and fill mode are added by the renderer.
+    std::uint32_t material_features = 0;
+    // Set on objects whose world matrix changes between frames: the renderer's scene BVH refits their bounds
+    // every frame and treats every other object as static until the object list changes.
+    bool dynamic = false;
 
     // x=min tess, y=max tess, z=near distance, w=far distance
     DirectX::XMFLOAT4 tess_params = {1.0f, 8.0f, 2.0f, 25.0f};
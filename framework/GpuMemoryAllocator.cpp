@@ -0,0 +1,205 @@
+#include "GpuMemoryAllocator.h"
+#include "FrameworkInternal.h"
+
+#include <algorithm>
+
+namespace gfw {
+
+namespace {
+    // Blocks this sparsely used are worth emptying so Trim can give them back.
+    constexpr double kRelocationOccupancy = 0.25;
+
+    D3D12_HEAP_FLAGS HeapFlags(MemoryCategory category) {
+        switch (category) {
+            case MemoryCategory::Buffer:
+                return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            case MemoryCategory::Texture:
+                return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+            default:
+                return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+        }
+    }
+
+    const wchar_t *CategoryName(MemoryCategory category) {
+        switch (category) {
+            case MemoryCategory::Buffer:
+                return L"Buffers";
+            case MemoryCategory::Texture:
+                return L"Textures";
+            default:
+                return L"Render targets";
+        }
+    }
+}
+
+bool GpuMemoryAllocator::Initialize(ID3D12Device *device, std::uint64_t block_size) {
+    device_ = device;
+    block_size_ = block_size;
+    return device_ != nullptr && block_size_ > 0;
+}
+
+void GpuMemoryAllocator::Shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    for (auto &blocks : blocks_) {
+        blocks.clear();
+    }
+    device_ = nullptr;
+    block_size_ = 0;
+}
+
+bool GpuMemoryAllocator::CreateBlock(MemoryCategory category, std::uint64_t size, std::uint32_t &out_block) {
+    D3D12_HEAP_DESC desc = {};
+    desc.SizeInBytes = size;
+    desc.Properties = detail::HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    desc.Flags = HeapFlags(category);
+
+    Block block;
+    if (detail::CheckFailed(device_->CreateHeap(&desc, IID_PPV_ARGS(&block.heap)), L"Failed to create GPU memory block!")) {
+        return false;
+    }
+    block.ranges = TlsfAllocator(size);
+
+    std::vector<Block> &blocks = blocks_[static_cast<std::size_t>(category)];
+    const auto spare = std::find_if(blocks.begin(), blocks.end(), [](const Block &entry) { return !entry.heap; });
+    if (spare != blocks.end()) {
+        *spare = std::move(block);
+        out_block = static_cast<std::uint32_t>(spare - blocks.begin());
+    } else {
+        out_block = static_cast<std::uint32_t>(blocks.size());
+        blocks.push_back(std::move(block));
+    }
+    std::wcout << CategoryName(category) << L": reserved GPU memory block " << out_block << L" ("
+               << size / (1024 * 1024) << L" MB)" << std::endl;
+    return true;
+}
+
+bool GpuMemoryAllocator::AllocateRange(MemoryCategory category, const D3D12_RESOURCE_ALLOCATION_INFO &info,
+                                       GpuAllocation &out) {
+    out.category = category;
+    std::vector<Block> &blocks = blocks_[static_cast<std::size_t>(category)];
+    if (info.SizeInBytes <= block_size_) {
+        for (std::uint32_t i = 0; i < blocks.size(); ++i) {
+            if (blocks[i].heap && blocks[i].ranges.Allocate(info.SizeInBytes, info.Alignment, out.range)) {
+                out.block = i;
+                return true;
+            }
+        }
+    }
+    // A dedicated block for anything larger than the standard block size.
+    const std::uint64_t alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    const std::uint64_t size = std::max(block_size_, (info.SizeInBytes + alignment - 1) & ~(alignment - 1));
+    std::uint32_t block = 0;
+    if (!CreateBlock(category, size, block) || !blocks[block].ranges.Allocate(info.SizeInBytes, info.Alignment, out.range)) {
+        return false;
+    }
+    out.block = block;
+    return true;
+}
+
+bool GpuMemoryAllocator::CreateResource(MemoryCategory category, const D3D12_RESOURCE_DESC &desc,
+                                        D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE *clear_value,
+                                        GpuAllocation &out_allocation,
+                                        Microsoft::WRL::ComPtr<ID3D12Resource> &out_resource) {
+    if (!device_) {
+        return false;
+    }
+    const D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(0, 1, &desc);
+    if (info.SizeInBytes == UINT64_MAX) {
+        std::wcerr << L"Invalid resource description for placed resource!" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    GpuAllocation allocation;
+    if (!AllocateRange(category, info, allocation)) {
+        std::wcerr << L"Failed to allocate GPU memory!" << std::endl;
+        return false;
+    }
+    Block &block = blocks_[static_cast<std::size_t>(category)][allocation.block];
+    if (detail::CheckFailed(device_->CreatePlacedResource(block.heap.Get(), allocation.range.offset, &desc,
+                                                          initial_state, clear_value, IID_PPV_ARGS(&out_resource)),
+                            L"Failed to create placed resource!")) {
+        block.ranges.Free(allocation.range);
+        return false;
+    }
+    out_allocation = allocation;
+    return true;
+}
+
+void GpuMemoryAllocator::Release(GpuAllocation &allocation, std::uint64_t pending_fence_value) {
+    if (!allocation.IsValid()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back({allocation, pending_fence_value});
+    allocation = GpuAllocation{};
+}
+
+void GpuMemoryAllocator::Retire(std::uint64_t completed_fence_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [&](const PendingRelease &pending) {
+                                      if (pending.fence_value > completed_fence_value) {
+                                          return false;
+                                      }
+                                      const GpuAllocation &allocation = pending.allocation;
+                                      blocks_[static_cast<std::size_t>(allocation.category)][allocation.block]
+                                              .ranges.Free(allocation.range);
+                                      return true;
+                                  }),
+                   pending_.end());
+}
+
+void GpuMemoryAllocator::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::vector<Block> &blocks : blocks_) {
+        for (std::size_t i = 1; i < blocks.size(); ++i) {
+            if (blocks[i].heap && blocks[i].ranges.IsEmpty()) {
+                blocks[i] = Block{};
+            }
+        }
+    }
+}
+
+bool GpuMemoryAllocator::IsRelocationCandidate(const GpuAllocation &allocation) const {
+    if (!allocation.IsValid()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::vector<Block> &blocks = blocks_[static_cast<std::size_t>(allocation.category)];
+    const auto live_blocks = std::count_if(blocks.begin(), blocks.end(), [](const Block &block) { return block.heap; });
+    const TlsfAllocator &ranges = blocks[allocation.block].ranges;
+    return live_blocks > 1 &&
+           static_cast<double>(ranges.Used()) < kRelocationOccupancy * static_cast<double>(ranges.Capacity());
+}
+
+GpuMemoryAllocator::CategoryStats GpuMemoryAllocator::GetStats(MemoryCategory category) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CategoryStats stats;
+    for (const Block &block : blocks_[static_cast<std::size_t>(category)]) {
+        if (!block.heap) {
+            continue;
+        }
+        stats.reserved_bytes += block.ranges.Capacity();
+        stats.used_bytes += block.ranges.Used();
+        stats.largest_free_range = std::max(stats.largest_free_range, block.ranges.LargestFreeRange());
+        stats.allocation_count += block.ranges.AllocationCount();
+        ++stats.block_count;
+    }
+    return stats;
+}
+
+void GpuMemoryAllocator::LogStats() const {
+    for (std::size_t i = 0; i < static_cast<std::size_t>(MemoryCategory::Count); ++i) {
+        const auto category = static_cast<MemoryCategory>(i);
+        const CategoryStats stats = GetStats(category);
+        std::wcout << CategoryName(category) << L": " << stats.allocation_count << L" allocations, "
+                   << (stats.used_bytes + 1023) / 1024 << L" KB used of " << stats.reserved_bytes / 1024
+                   << L" KB in " << stats.block_count << L" blocks, largest free range "
+                   << stats.largest_free_range / 1024 << L" KB" << std::endl;
+    }
+}
+
+}
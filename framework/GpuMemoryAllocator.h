@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "TlsfAllocator.h"
+
+namespace gfw {
+
+// Heap tier 1 hardware cannot mix these in one heap, so each gets its own set of blocks.
+enum class MemoryCategory : std::uint8_t {
+    Buffer,
+    Texture,
+    RenderTarget, // render target and depth-stencil textures
+    Count
+};
+
+struct GpuAllocation {
+    MemoryCategory category = MemoryCategory::Buffer;
+    std::uint32_t block = 0;
+    TlsfAllocator::Allocation range = {};
+
+    [[nodiscard]] bool IsValid() const { return range.IsValid(); }
+};
+
+// Reserves large DEFAULT-heap ID3D12Heap blocks per category and places resources into them with a TLSF
+// sub-allocator, instead of paying for an implicit heap per CreateCommittedResource. Thread-safe, since the
+// streaming worker creates textures too. Resources larger than a block get a dedicated block of their own.
+class GpuMemoryAllocator {
+public:
+    struct CategoryStats {
+        std::uint64_t reserved_bytes = 0;
+        std::uint64_t used_bytes = 0;
+        std::uint64_t largest_free_range = 0;
+        std::uint32_t allocation_count = 0;
+        std::uint32_t block_count = 0;
+    };
+
+    GpuMemoryAllocator() = default;
+    ~GpuMemoryAllocator() { Shutdown(); }
+
+    GpuMemoryAllocator(const GpuMemoryAllocator &) = delete;
+    GpuMemoryAllocator &operator=(const GpuMemoryAllocator &) = delete;
+
+    bool Initialize(ID3D12Device *device, std::uint64_t block_size);
+
+    void Shutdown();
+
+    bool CreateResource(MemoryCategory category, const D3D12_RESOURCE_DESC &desc, D3D12_RESOURCE_STATES initial_state,
+                        const D3D12_CLEAR_VALUE *clear_value, GpuAllocation &out_allocation,
+                        Microsoft::WRL::ComPtr<ID3D12Resource> &out_resource);
+
+    // The range is reused once pending_fence_value has completed; allocation is reset.
+    void Release(GpuAllocation &allocation, std::uint64_t pending_fence_value);
+
+    void Retire(std::uint64_t completed_fence_value);
+
+    // Releases every block without live allocations, except the first of each category.
+    void Trim();
+
+    // Defragmentation hook: true when the allocation sits in a sparsely used block that Trim could release if
+    // its owner recreated the resource elsewhere (CreateResource, copy, Release).
+    [[nodiscard]] bool IsRelocationCandidate(const GpuAllocation &allocation) const;
+
+    [[nodiscard]] CategoryStats GetStats(MemoryCategory category) const;
+
+    void LogStats() const;
+
+    [[nodiscard]] bool IsValid() const { return device_ != nullptr; }
+
+private:
+    struct Block {
+        Microsoft::WRL::ComPtr<ID3D12Heap> heap; // null once trimmed; the slot is reused by the next block
+        TlsfAllocator ranges;
+    };
+
+    struct PendingRelease {
+        GpuAllocation allocation;
+        std::uint64_t fence_value = 0;
+    };
+
+    bool AllocateRange(MemoryCategory category, const D3D12_RESOURCE_ALLOCATION_INFO &info, GpuAllocation &out);
+    bool CreateBlock(MemoryCategory category, std::uint64_t size, std::uint32_t &out_block);
+
+    ID3D12Device *device_ = nullptr;
+    std::uint64_t block_size_ = 0;
+    mutable std::mutex mutex_;
+    std::array<std::vector<Block>, static_cast<std::size_t>(MemoryCategory::Count)> blocks_;
+    std::vector<PendingRelease> pending_;
+};
+
+}
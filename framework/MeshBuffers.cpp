@@ -0,0 +1,36 @@
+#include "MeshBuffers.h"
+
+#include <cmath>
+
+namespace gfw {
+    void MeshBuffers::SetDrawInfo(const MeshData &mesh_data) {
+        topology = mesh_data.topology;
+        vertex_count = mesh_data.vertex_count;  // Store vertex count for non-indexed draws
+        index_count = mesh_data.IndexCount() > 0 ? mesh_data.BaseIndexCount() : 0;
+        meshlets = mesh_data.meshlets;
+        lods = mesh_data.lods;
+        bounds_min = mesh_data.bounds_min;
+        bounds_max = mesh_data.bounds_max;
+        bounds_radius = mesh_data.bounds_radius;
+        if (bounds_radius <= 0.0f) {
+            // No sphere from the loader: the one through the AABB corners is the tightest the AABB guarantees.
+            const DirectX::XMFLOAT3 half = {(mesh_data.bounds_max.x - mesh_data.bounds_min.x) * 0.5f,
+                                            (mesh_data.bounds_max.y - mesh_data.bounds_min.y) * 0.5f,
+                                            (mesh_data.bounds_max.z - mesh_data.bounds_min.z) * 0.5f};
+            bounds_radius = std::sqrt(half.x * half.x + half.y * half.y + half.z * half.z);
+        }
+        vertex_format = mesh_data.vertex_format;
+        has_tangents = mesh_data.has_tangents;
+        if (mesh_data.vertex_format == VertexFormat::Quantized) {
+            quant_offset = mesh_data.bounds_min;
+            quant_scale = {mesh_data.bounds_max.x - mesh_data.bounds_min.x,
+                           mesh_data.bounds_max.y - mesh_data.bounds_min.y,
+                           mesh_data.bounds_max.z - mesh_data.bounds_min.z};
+        }
+    }
+
+    IndexFormat MeshBuffers::IndexFormatFor(const MeshData &mesh_data) {
+        const bool narrow = mesh_data.IndexSize() == sizeof(std::uint16_t) || mesh_data.vertex_count < 0x10000u;
+        return narrow ? IndexFormat::Uint16 : IndexFormat::Uint32;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "CommandRecorder.h"
+#include "../MeshData.h"
+
+namespace gfw {
+    struct OccluderMesh;
+
+    // GPU copy of a MeshData, created by RenderDevice::CreateMeshBuffers. The buffers belong to the device
+    // until RenderDevice::ReleaseMeshBuffers.
+    class MeshBuffers {
+    public:
+        MeshBuffers() = default;
+
+        ~MeshBuffers() = default;
+
+        MeshBuffers(const MeshBuffers &) = delete;
+
+        MeshBuffers &operator=(const MeshBuffers &) = delete;
+
+        MeshBuffers(MeshBuffers &&) = default;
+
+        MeshBuffers &operator=(MeshBuffers &&) = default;
+
+        // Copies what the renderer needs to draw and cull the mesh from mesh_data: everything but the buffers
+        // and their views.
+        void SetDrawInfo(const MeshData &mesh_data);
+
+        // Halves index fetch bandwidth whenever every index fits in 16 bits; indices a cached mesh already stores
+        // narrow stay that way.
+        [[nodiscard]] static IndexFormat IndexFormatFor(const MeshData &mesh_data);
+
+        ResourceHandle vertex_buffer;
+        ResourceHandle index_buffer;
+        VertexBufferView vertex_buffer_view = {};
+        IndexBufferView index_buffer_view = {};
+        std::uint32_t vertex_count = 0;  // Number of vertices (used for non-indexed draws)
+        std::uint32_t index_count = 0;   // Number of indices (used for indexed draws)
+        PrimitiveTopology topology = PrimitiveTopology::TriangleList;
+        VertexFormat vertex_format = VertexFormat::Float32;
+        bool has_tangents = false;
+        std::vector<Meshlet> meshlets; // empty when the mesh is drawn as a whole
+        std::vector<MeshLod> lods;     // empty when only full detail exists
+        DirectX::XMFLOAT3 bounds_min = {0.0f, 0.0f, 0.0f};
+        DirectX::XMFLOAT3 bounds_max = {0.0f, 0.0f, 0.0f};
+        // Sphere around the AABB center; 0 only when the AABB is unknown too (see FrustumCuller).
+        float bounds_radius = 0.0f;
+        // Dequantization: position = quant_offset + unorm16 * quant_scale (identity for Float32).
+        DirectX::XMFLOAT3 quant_offset = {0.0f, 0.0f, 0.0f};
+        DirectX::XMFLOAT3 quant_scale = {1.0f, 1.0f, 1.0f};
+        // UploadTicket of the batch that fills the DEFAULT-heap buffers; see RenderDevice::FlushUploads.
+        std::uint64_t upload_ticket = 0;
+        // Streaming-fence value the buffers are filled after; see RenderDevice::StreamMeshBuffers.
+        std::uint64_t resident_fence = 0;
+        // CPU copy the mesh occludes other objects with; null for meshes that are no occluders (see OcclusionCuller).
+        std::shared_ptr<const OccluderMesh> occluder;
+    };
+}
@@ -0,0 +1,151 @@
+#include "NullRenderBackend.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gfw {
+
+static_assert(sizeof(CommandStream::PacketHeader) == 8);
+static_assert(sizeof(CommandStream::RenderTargetsPacket) == 16 + 8 * CommandRecorder::kMaxRenderTargets);
+static_assert(sizeof(ResourceBarrier) == 16 && sizeof(VertexBufferView) == 16 && sizeof(IndexBufferView) == 16);
+static_assert(sizeof(Viewport) == 24 && sizeof(ScissorRect) == 16);
+
+void CommandStream::Append(CommandOp op, const void *payload, std::size_t size) {
+    const PacketHeader header = {op, static_cast<std::uint16_t>(size), 0};
+    const std::size_t offset = bytes_.size();
+    bytes_.resize(offset + sizeof(PacketHeader) + PaddedSize(size), 0);
+    std::memcpy(bytes_.data() + offset, &header, sizeof(header));
+    if (size > 0) {
+        std::memcpy(bytes_.data() + offset + sizeof(PacketHeader), payload, size);
+    }
+    ++command_count_;
+    if (op == CommandOp::Draw || op == CommandOp::DrawIndexed) {
+        ++draw_count_;
+    }
+}
+
+void CommandStream::Append(const CommandStream &other) {
+    bytes_.insert(bytes_.end(), other.bytes_.begin(), other.bytes_.end());
+    command_count_ += other.command_count_;
+    draw_count_ += other.draw_count_;
+}
+
+void CommandStream::Clear() {
+    // Keeps the capacity; a frame's stream is about the same size as the last one.
+    bytes_.clear();
+    command_count_ = 0;
+    draw_count_ = 0;
+}
+
+bool CommandStream::Assign(const std::uint8_t *data, std::size_t size) {
+    Clear();
+    std::size_t offset = 0;
+    std::size_t commands = 0;
+    std::size_t draws = 0;
+    while (offset < size) {
+        if (size - offset < sizeof(PacketHeader)) {
+            return false;
+        }
+        PacketHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        offset += sizeof(PacketHeader);
+        if (header.op >= CommandOp::Count || PaddedSize(header.size) > size - offset) {
+            return false;
+        }
+        offset += PaddedSize(header.size);
+        ++commands;
+        if (header.op == CommandOp::Draw || header.op == CommandOp::DrawIndexed) {
+            ++draws;
+        }
+    }
+    bytes_.assign(data, data + size);
+    command_count_ = commands;
+    draw_count_ = draws;
+    return true;
+}
+
+void RecordingCommandList::Barriers(const ResourceBarrier *barriers, std::uint32_t count) {
+    stream_.Append(CommandOp::Barriers, barriers, count * sizeof(ResourceBarrier));
+}
+
+void RecordingCommandList::SetViewport(const Viewport &viewport) {
+    stream_.Append(CommandOp::SetViewport, viewport);
+}
+
+void RecordingCommandList::SetScissor(const ScissorRect &scissor) {
+    stream_.Append(CommandOp::SetScissor, scissor);
+}
+
+void RecordingCommandList::SetRenderTargets(const CpuDescriptor *rtvs, std::uint32_t count, CpuDescriptor dsv) {
+    CommandStream::RenderTargetsPacket packet = {};
+    packet.count = std::min(count, kMaxRenderTargets);
+    packet.dsv = dsv;
+    std::copy_n(rtvs, packet.count, packet.rtvs);
+    stream_.Append(CommandOp::SetRenderTargets, packet);
+}
+
+void RecordingCommandList::ClearRenderTarget(CpuDescriptor rtv, const float color[4]) {
+    CommandStream::ClearRenderTargetPacket packet = {rtv, {color[0], color[1], color[2], color[3]}};
+    stream_.Append(CommandOp::ClearRenderTarget, packet);
+}
+
+void RecordingCommandList::ClearDepth(CpuDescriptor dsv, float depth) {
+    stream_.Append(CommandOp::ClearDepth, CommandStream::ClearDepthPacket{dsv, depth, 0});
+}
+
+void RecordingCommandList::SetDescriptorHeap(DescriptorHeapHandle heap) {
+    stream_.Append(CommandOp::SetDescriptorHeap, heap);
+}
+
+void RecordingCommandList::SetRootSignature(RootSignatureHandle root_signature) {
+    stream_.Append(CommandOp::SetRootSignature, root_signature);
+}
+
+void RecordingCommandList::SetPipeline(PipelineHandle pipeline) {
+    stream_.Append(CommandOp::SetPipeline, pipeline);
+}
+
+void RecordingCommandList::SetConstantBuffer(std::uint32_t slot, GpuAddress address) {
+    stream_.Append(CommandOp::SetConstantBuffer, CommandStream::RootArgumentPacket{slot, 0, address});
+}
+
+void RecordingCommandList::SetDescriptorTable(std::uint32_t slot, GpuDescriptor table) {
+    stream_.Append(CommandOp::SetDescriptorTable, CommandStream::RootArgumentPacket{slot, 0, table.value});
+}
+
+void RecordingCommandList::SetTopology(PrimitiveTopology topology) {
+    stream_.Append(CommandOp::SetTopology, topology);
+}
+
+void RecordingCommandList::SetVertexBuffer(const VertexBufferView &view) {
+    stream_.Append(CommandOp::SetVertexBuffer, view);
+}
+
+void RecordingCommandList::SetIndexBuffer(const IndexBufferView &view) {
+    stream_.Append(CommandOp::SetIndexBuffer, view);
+}
+
+void RecordingCommandList::Draw(std::uint32_t vertex_count, std::uint32_t first_vertex) {
+    stream_.Append(CommandOp::Draw, CommandStream::DrawPacket{vertex_count, first_vertex, 0, 0});
+}
+
+void RecordingCommandList::DrawIndexed(std::uint32_t index_count, std::uint32_t first_index, std::int32_t base_vertex) {
+    stream_.Append(CommandOp::DrawIndexed, CommandStream::DrawPacket{index_count, first_index, base_vertex, 0});
+}
+
+void SimulatedFence::Signal(std::uint64_t value) {
+    pending_.push_back(value);
+    while (pending_.size() > latency_) {
+        completed_ = std::max(completed_, pending_.front());
+        pending_.pop_front();
+    }
+}
+
+void SimulatedFence::Wait(std::uint64_t value) {
+    while (!pending_.empty() && pending_.front() <= value) {
+        completed_ = std::max(completed_, pending_.front());
+        pending_.pop_front();
+    }
+}
+
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "CommandRecorder.h"
+
+namespace gfw {
+
+enum class CommandOp : std::uint16_t {
+    Barriers,
+    SetViewport,
+    SetScissor,
+    SetRenderTargets,
+    ClearRenderTarget,
+    ClearDepth,
+    SetDescriptorHeap,
+    SetRootSignature,
+    SetPipeline,
+    SetConstantBuffer,
+    SetDescriptorTable,
+    SetTopology,
+    SetVertexBuffer,
+    SetIndexBuffer,
+    Draw,
+    DrawIndexed,
+    Count
+};
+
+// Recorded commands as packets of {CommandOp, payload size} followed by the payload, padded to 8 bytes. The
+// payloads are the CommandRecorder argument structs or the packets below, so a stream is position independent
+// and can be copied, appended or written out as is.
+class CommandStream {
+public:
+    struct PacketHeader {
+        CommandOp op;
+        std::uint16_t size; // payload bytes, without padding
+        std::uint32_t reserved;
+    };
+
+    struct RenderTargetsPacket {
+        std::uint32_t count;
+        std::uint32_t reserved;
+        CpuDescriptor dsv;
+        CpuDescriptor rtvs[CommandRecorder::kMaxRenderTargets];
+    };
+
+    struct ClearRenderTargetPacket {
+        CpuDescriptor rtv;
+        float color[4];
+    };
+
+    struct ClearDepthPacket {
+        CpuDescriptor dsv;
+        float depth;
+        std::uint32_t reserved;
+    };
+
+    struct RootArgumentPacket {
+        std::uint32_t slot;
+        std::uint32_t reserved;
+        std::uint64_t value; // GpuAddress or GpuDescriptor
+    };
+
+    struct DrawPacket {
+        std::uint32_t count;
+        std::uint32_t first;
+        std::int32_t base_vertex;
+        std::uint32_t reserved;
+    };
+
+    void Append(CommandOp op, const void *payload, std::size_t size);
+
+    template <typename T>
+    void Append(CommandOp op, const T &payload) {
+        Append(op, &payload, sizeof(T));
+    }
+
+    // Appends every command of other, e.g. a worker's list in submission order.
+    void Append(const CommandStream &other);
+
+    void Clear();
+
+    // Replaces the stream with size bytes of packets, e.g. read back from a file. Fails, leaving the stream
+    // empty, unless every packet is complete and has a known op.
+    bool Assign(const std::uint8_t *data, std::size_t size);
+
+    // Calls visit(op, payload, size) for each command in recording order.
+    template <typename Visitor>
+    void ForEach(Visitor &&visit) const {
+        std::size_t offset = 0;
+        while (offset + sizeof(PacketHeader) <= bytes_.size()) {
+            const auto *header = reinterpret_cast<const PacketHeader *>(bytes_.data() + offset);
+            offset += sizeof(PacketHeader);
+            visit(header->op, bytes_.data() + offset, static_cast<std::size_t>(header->size));
+            offset += PaddedSize(header->size);
+        }
+    }
+
+    [[nodiscard]] const std::uint8_t *Data() const { return bytes_.data(); }
+    [[nodiscard]] std::size_t SizeBytes() const { return bytes_.size(); }
+    [[nodiscard]] std::size_t CommandCount() const { return command_count_; }
+    [[nodiscard]] std::size_t DrawCount() const { return draw_count_; }
+
+    static constexpr std::size_t PaddedSize(std::size_t size) { return (size + 7) & ~std::size_t{7}; }
+
+private:
+    // operator new storage plus 8-byte padding keeps every packet header aligned.
+    std::vector<std::uint8_t> bytes_;
+    std::size_t command_count_ = 0;
+    std::size_t draw_count_ = 0;
+};
+
+// The null backend's command list: validates nothing and executes nothing, it only appends to its stream.
+class RecordingCommandList final : public CommandRecorder {
+public:
+    [[nodiscard]] RenderBackend Backend() const override { return RenderBackend::Null; }
+
+    void Barriers(const ResourceBarrier *barriers, std::uint32_t count) override;
+    void SetViewport(const Viewport &viewport) override;
+    void SetScissor(const ScissorRect &scissor) override;
+    void SetRenderTargets(const CpuDescriptor *rtvs, std::uint32_t count, CpuDescriptor dsv) override;
+    void ClearRenderTarget(CpuDescriptor rtv, const float color[4]) override;
+    void ClearDepth(CpuDescriptor dsv, float depth) override;
+    void SetDescriptorHeap(DescriptorHeapHandle heap) override;
+    void SetRootSignature(RootSignatureHandle root_signature) override;
+    void SetPipeline(PipelineHandle pipeline) override;
+    void SetConstantBuffer(std::uint32_t slot, GpuAddress address) override;
+    void SetDescriptorTable(std::uint32_t slot, GpuDescriptor table) override;
+    void SetTopology(PrimitiveTopology topology) override;
+    void SetVertexBuffer(const VertexBufferView &view) override;
+    void SetIndexBuffer(const IndexBufferView &view) override;
+    void Draw(std::uint32_t vertex_count, std::uint32_t first_vertex) override;
+    void DrawIndexed(std::uint32_t index_count, std::uint32_t first_index, std::int32_t base_vertex) override;
+
+    [[nodiscard]] CommandStream &Stream() { return stream_; }
+    [[nodiscard]] const CommandStream &Stream() const { return stream_; }
+
+private:
+    CommandStream stream_;
+};
+
+// Discards every command; a replay target that measures nothing but the cost of decoding and dispatching.
+class NullCommandSink final : public CommandRecorder {
+public:
+    [[nodiscard]] RenderBackend Backend() const override { return RenderBackend::Null; }
+
+    void Barriers(const ResourceBarrier *, std::uint32_t) override {}
+    void SetViewport(const Viewport &) override {}
+    void SetScissor(const ScissorRect &) override {}
+    void SetRenderTargets(const CpuDescriptor *, std::uint32_t, CpuDescriptor) override {}
+    void ClearRenderTarget(CpuDescriptor, const float[4]) override {}
+    void ClearDepth(CpuDescriptor, float) override {}
+    void SetDescriptorHeap(DescriptorHeapHandle) override {}
+    void SetRootSignature(RootSignatureHandle) override {}
+    void SetPipeline(PipelineHandle) override {}
+    void SetConstantBuffer(std::uint32_t, GpuAddress) override {}
+    void SetDescriptorTable(std::uint32_t, GpuDescriptor) override {}
+    void SetTopology(PrimitiveTopology) override {}
+    void SetVertexBuffer(const VertexBufferView &) override {}
+    void SetIndexBuffer(const IndexBufferView &) override {}
+    void Draw(std::uint32_t, std::uint32_t) override { ++draw_count_; }
+    void DrawIndexed(std::uint32_t, std::uint32_t, std::int32_t) override { ++draw_count_; }
+
+    // Draws received so far; keeps the calls observable.
+    [[nodiscard]] std::uint64_t DrawCount() const { return draw_count_; }
+
+private:
+    std::uint64_t draw_count_ = 0;
+};
+
+// Stands in for a GPU fence. A signalled value completes once latency newer values have been signalled, as
+// if the GPU ran that many submissions behind the CPU; Wait completes everything up to value at once, as if
+// the CPU had blocked until the GPU caught up.
+class SimulatedFence {
+public:
+    explicit SimulatedFence(std::uint32_t latency = 1) : latency_(latency) {}
+
+    void Signal(std::uint64_t value);
+    void Wait(std::uint64_t value);
+    [[nodiscard]] std::uint64_t CompletedValue() const { return completed_; }
+
+private:
+    std::uint32_t latency_ = 1;
+    std::deque<std::uint64_t> pending_;
+    std::uint64_t completed_ = 0;
+};
+
+}
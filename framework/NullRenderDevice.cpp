@@ -0,0 +1,411 @@
+#include "NullRenderDevice.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace gfw {
+    namespace {
+        class NullCommandList final : public DeviceCommandList {
+        public:
+            bool Begin(std::uint32_t) override {
+                list_.Stream().Clear();
+                return true;
+            }
+            bool Close() override { return true; }
+            [[nodiscard]] CommandRecorder &Recorder() override { return list_; }
+            // The stream is the list, so InsertCommandLists always has the commands.
+            void SetCapture(bool) override {}
+
+        private:
+            RecordingCommandList list_;
+        };
+
+        double ElapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        }
+    }
+
+    bool NullRenderDevice::Initialize(std::uint32_t width, std::uint32_t height, std::uint32_t frames_in_flight) {
+        if (initialized_ || width == 0 || height == 0) {
+            return false;
+        }
+        width_ = width;
+        height_ = height;
+        frame_index_ = 0;
+        pacer_ = FramePacer(frames_in_flight);
+        fence_ = SimulatedFence(pacer_.FramesInFlight() - 1);
+        frame_start_ = {};
+
+        back_buffer_heap_ = CreateDescriptorHeap(DescriptorHeapType::RenderTarget, pacer_.FramesInFlight());
+        back_buffers_.clear();
+        const TextureDesc back_buffer = {width, height, Format::R8G8B8A8Unorm, true, ResourceState::Present};
+        for (std::uint32_t i = 0; i < pacer_.FramesInFlight(); ++i) {
+            back_buffers_.push_back(CreateTexture(back_buffer));
+            CreateRenderTargetView(back_buffer_heap_, i, back_buffers_.back(), Format::R8G8B8A8Unorm);
+        }
+        depth_heap_ = CreateDescriptorHeap(DescriptorHeapType::RenderTarget, 1);
+        depth_buffer_ = CreateTexture({width, height, Format::D32Float, false, ResourceState::DepthWrite});
+
+        upload_ring_ = RingAllocator(kUploadRingSize);
+        upload_memory_.assign(kUploadRingSize, 0);
+        upload_base_ = kUploadAddressBase;
+
+        bindless_heap_ = CreateDescriptorHeap(DescriptorHeapType::ShaderResource, kInitialBindlessDescriptors);
+        bindless_slots_ = DescriptorAllocator(kInitialBindlessDescriptors);
+        initialized_ = true;
+        default_texture_ = CreateBindlessTexture();
+        std::wcout << L"Null render device: " << width_ << L"x" << height_ << L", " << pacer_.FramesInFlight()
+                   << L" frames in flight" << std::endl;
+        return default_texture_ != nullptr;
+    }
+
+    void NullRenderDevice::Shutdown() {
+        if (!initialized_) {
+            return;
+        }
+        textures_.clear();
+        default_texture_.reset();
+        {
+            std::lock_guard<std::mutex> lock(objects_mutex_);
+            objects_.clear();
+            released_objects_.clear();
+        }
+        back_buffers_.clear();
+        back_buffer_heap_ = {};
+        depth_buffer_ = {};
+        depth_heap_ = {};
+        bindless_heap_ = {};
+        bindless_slots_ = {};
+        upload_ring_ = {};
+        upload_memory_.clear();
+        frame_list_.Stream().Clear();
+        submitted_commands_.Clear();
+        capture_ = {};
+        capture_path_.clear();
+        capture_requested_ = false;
+        capturing_ = false;
+        next_buffer_address_ = kBufferAddressBase;
+        initialized_ = false;
+        width_ = 0;
+        height_ = 0;
+    }
+
+    Viewport NullRenderDevice::GetViewport() const {
+        return {0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_), 0.0f, 1.0f};
+    }
+
+    ScissorRect NullRenderDevice::GetScissorRect() const {
+        return {0, 0, static_cast<std::int32_t>(width_), static_cast<std::int32_t>(height_)};
+    }
+
+    CpuDescriptor NullRenderDevice::GetBackBufferRtv() const {
+        return GetCpuDescriptor(back_buffer_heap_, frame_index_);
+    }
+
+    CpuDescriptor NullRenderDevice::GetDepthDsv() const {
+        return GetCpuDescriptor(depth_heap_, 0);
+    }
+
+    void NullRenderDevice::BeginFrame() {
+        const auto frame_start = std::chrono::steady_clock::now();
+        fence_.Wait(pacer_.WaitValue(frame_index_));
+        const auto wait_end = std::chrono::steady_clock::now();
+        const std::uint64_t completed = fence_.CompletedValue();
+        if (frame_start_ != std::chrono::steady_clock::time_point{}) {
+            pacer_.RecordFrame(ElapsedMs(frame_start_, frame_start), ElapsedMs(frame_start, wait_end), completed);
+        }
+        frame_start_ = frame_start;
+
+        upload_ring_.Retire(completed);
+        bindless_slots_.Retire(completed);
+        RetireObjects(completed);
+
+        capturing_ = capture_requested_;
+        capture_requested_ = false;
+        if (capturing_) {
+            capture_.Begin();
+        }
+        frame_list_.Stream().Clear();
+        frame_list_.Barrier(back_buffers_[frame_index_], ResourceState::Present, ResourceState::RenderTarget);
+        frame_list_.SetViewport(GetViewport());
+        frame_list_.SetScissor(GetScissorRect());
+    }
+
+    void NullRenderDevice::EndFrame() {
+        frame_list_.Barrier(back_buffers_[frame_index_], ResourceState::RenderTarget, ResourceState::Present);
+        if (capturing_) {
+            FinishCapture();
+        }
+        // Nothing executes the stream; keep it for inspection and let the simulated GPU retire the frame.
+        std::swap(submitted_commands_, frame_list_.Stream());
+        upload_ring_.FinishFrame(pacer_.PendingFenceValue());
+        fence_.Signal(pacer_.EndFrame(frame_index_));
+        frame_index_ = (frame_index_ + 1) % pacer_.FramesInFlight();
+    }
+
+    std::unique_ptr<DeviceCommandList> NullRenderDevice::CreateCommandList(std::uint32_t) {
+        return std::make_unique<NullCommandList>();
+    }
+
+    bool NullRenderDevice::InsertCommandLists(const std::vector<CommandRecorder *> &lists) {
+        for (const CommandRecorder *list : lists) {
+            if (list->Backend() != RenderBackend::Null) {
+                std::wcerr << L"InsertCommandLists: list was recorded for another backend!" << std::endl;
+                return false;
+            }
+        }
+        for (CommandRecorder *list : lists) {
+            frame_list_.Stream().Append(static_cast<RecordingCommandList *>(list)->Stream());
+        }
+        frame_list_.SetViewport(GetViewport());
+        frame_list_.SetScissor(GetScissorRect());
+        return true;
+    }
+
+    GpuAddress NullRenderDevice::UploadConstants(const void *data, std::uint32_t size) {
+        std::uint64_t offset = 0;
+        if (!upload_ring_.Allocate(size, kConstantAlignment, offset)) {
+            // Like UploadRing: a ring twice as large, at addresses no unretired slice uses.
+            const std::uint64_t capacity = std::max(upload_ring_.Capacity() * 2, std::uint64_t{size} * 2);
+            upload_base_ += upload_ring_.Capacity();
+            upload_ring_ = RingAllocator(capacity);
+            upload_memory_.assign(capacity, 0);
+            if (!upload_ring_.Allocate(size, kConstantAlignment, offset)) {
+                std::wcerr << L"Failed to allocate constants from the upload ring!" << std::endl;
+                return 0;
+            }
+        }
+        std::memcpy(upload_memory_.data() + offset, data, size);
+        const GpuAddress address = upload_base_ + offset;
+        if (capturing_) {
+            capture_.RecordConstants(address, data, size);
+        }
+        return address;
+    }
+
+    std::unique_ptr<MeshBuffers> NullRenderDevice::CreateMeshBuffers(const MeshData &mesh_data) {
+        if (mesh_data.VertexByteSize() == 0) {
+            std::wcerr << L"CreateMeshBuffers: Empty vertex data!" << std::endl;
+            return nullptr;
+        }
+        auto buffers = std::make_unique<MeshBuffers>();
+        buffers->SetDrawInfo(mesh_data);
+        const auto vb_size = static_cast<std::uint32_t>(mesh_data.VertexByteSize());
+        buffers->vertex_buffer = CreateBuffer(vb_size, buffers->vertex_buffer_view.address);
+        buffers->vertex_buffer_view.size = vb_size;
+        buffers->vertex_buffer_view.stride = mesh_data.vertex_stride;
+        if (mesh_data.IndexCount() > 0) {
+            const IndexFormat format = MeshBuffers::IndexFormatFor(mesh_data);
+            const std::uint32_t ib_size = mesh_data.IndexCount() * static_cast<std::uint32_t>(
+                format == IndexFormat::Uint16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t));
+            buffers->index_buffer = CreateBuffer(ib_size, buffers->index_buffer_view.address);
+            buffers->index_buffer_view.size = ib_size;
+            buffers->index_buffer_view.format = format;
+        }
+        buffers->upload_ticket = upload_batch_;
+        return buffers;
+    }
+
+    std::shared_ptr<MeshBuffers> NullRenderDevice::StreamMeshBuffers(const MeshData &mesh_data) {
+        std::unique_ptr<MeshBuffers> buffers = CreateMeshBuffers(mesh_data);
+        return buffers ? std::shared_ptr<MeshBuffers>(std::move(buffers)) : nullptr;
+    }
+
+    void NullRenderDevice::ReleaseMeshBuffers(MeshBuffers &mesh) {
+        Release(mesh.vertex_buffer);
+        Release(mesh.index_buffer);
+        mesh.vertex_buffer = {};
+        mesh.index_buffer = {};
+    }
+
+    std::shared_ptr<Texture2D> NullRenderDevice::CreateSolidTexture(const DirectX::XMFLOAT4 &) {
+        return CreateBindlessTexture();
+    }
+
+    std::shared_ptr<Texture2D> NullRenderDevice::CreateTextureFromFile(const std::wstring &filename) {
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(filename, error)) {
+            std::wcerr << L"Failed to load texture: " << filename << std::endl;
+            return {};
+        }
+        return CreateBindlessTexture();
+    }
+
+    std::shared_ptr<Texture2D> NullRenderDevice::StreamTextureFromFile(const std::wstring &filename) {
+        return CreateTextureFromFile(filename);
+    }
+
+    void NullRenderDevice::ReleaseTexture(const std::shared_ptr<Texture2D> &texture) {
+        if (!texture || texture == default_texture_) {
+            return;
+        }
+        const auto it = std::find(textures_.begin(), textures_.end(), texture);
+        if (it == textures_.end()) {
+            return;
+        }
+        bindless_slots_.Release(texture->srv, pacer_.PendingFenceValue());
+        Release(texture->resource);
+        textures_.erase(it);
+    }
+
+    std::uint32_t NullRenderDevice::GetBindlessIndex(const Texture2D *texture) {
+        if (texture && bindless_slots_.IsAlive(texture->srv)) {
+            return texture->srv.index;
+        }
+        return default_texture_ ? default_texture_->srv.index : 0;
+    }
+
+    ResourceHandle NullRenderDevice::CreateTexture(const TextureDesc &desc) {
+        if (desc.width == 0 || desc.height == 0 || desc.format == Format::Unknown) {
+            std::wcerr << L"CreateTexture: invalid texture description!" << std::endl;
+            return {};
+        }
+        return ResourceHandle{CreateObject()};
+    }
+
+    DescriptorHeapHandle NullRenderDevice::CreateDescriptorHeap(DescriptorHeapType, std::uint32_t count) {
+        return count > 0 ? DescriptorHeapHandle{CreateObject()} : DescriptorHeapHandle{};
+    }
+
+    bool NullRenderDevice::CreateRenderTargetView(DescriptorHeapHandle heap, std::uint32_t, ResourceHandle resource,
+                                                  Format format) {
+        return heap && resource && format != Format::Unknown;
+    }
+
+    bool NullRenderDevice::CreateShaderResourceView(DescriptorHeapHandle heap, std::uint32_t, ResourceHandle resource,
+                                                    Format format) {
+        return heap && resource && format != Format::Unknown;
+    }
+
+    // Descriptors are the heap's handle in the upper and the index in the lower half.
+    CpuDescriptor NullRenderDevice::GetCpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const {
+        return CpuDescriptor{heap.value << 32 | index};
+    }
+
+    GpuDescriptor NullRenderDevice::GetGpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const {
+        return GpuDescriptor{heap.value << 32 | index};
+    }
+
+    RootSignatureHandle NullRenderDevice::CreateRootSignature(const RootSignatureDesc &desc) {
+        if (desc.table_size == 0) {
+            std::wcerr << L"CreateRootSignature: empty descriptor table!" << std::endl;
+            return {};
+        }
+        return RootSignatureHandle{CreateObject()};
+    }
+
+    PipelineHandle NullRenderDevice::CreatePipeline(const PipelineDesc &desc) {
+        if (!desc.root_signature || !desc.vs.file || desc.input_count > PipelineDesc::kMaxInputElements ||
+            desc.rtv_count > CommandRecorder::kMaxRenderTargets ||
+            (desc.primitive == PrimitiveType::Patch && (!desc.hs.file || !desc.ds.file))) {
+            std::wcerr << L"CreatePipeline: invalid pipeline description!" << std::endl;
+            return {};
+        }
+        return PipelineHandle{CreateObject()};
+    }
+
+    void NullRenderDevice::CaptureNextFrame(const std::wstring &filename) {
+        capture_path_ = filename;
+        capture_requested_ = true;
+    }
+
+    void NullRenderDevice::FinishCapture() {
+        capturing_ = false;
+        capture_.Finish(frame_list_.Stream());
+        const CommandStream &stream = capture_.Stream();
+        std::wcout << L"Captured frame: " << stream.CommandCount() << L" commands, " << stream.DrawCount()
+                   << L" draws, " << capture_.PipelineCount() << L" pipelines, " << capture_.ConstantCount()
+                   << L" constant buffers (" << capture_.ConstantBytes() / 1024 << L" KB)" << std::endl;
+        if (!capture_path_.empty() && capture_.Save(capture_path_)) {
+            std::wcout << L"Wrote frame capture " << capture_path_ << std::endl;
+        }
+    }
+
+    bool NullRenderDevice::ReplayCapture(const CommandCapture &capture, std::uint32_t iterations) {
+        // Loaded captures replay too: their renumbered handles are only recorded here.
+        fence_.Wait(pacer_.PendingFenceValue() - 1);
+        std::vector<GpuAddress> constants(capture.ConstantCount());
+        for (std::uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            const std::uint32_t slot = iteration % pacer_.FramesInFlight();
+            fence_.Wait(pacer_.WaitValue(slot));
+            upload_ring_.Retire(fence_.CompletedValue());
+            for (std::size_t i = 0; i < constants.size(); ++i) {
+                constants[i] = UploadConstants(capture.ConstantData(i), capture.ConstantSize(i));
+            }
+            frame_list_.Stream().Clear();
+            capture.Replay(frame_list_, constants);
+            upload_ring_.FinishFrame(pacer_.PendingFenceValue());
+            fence_.Signal(pacer_.EndFrame(slot));
+        }
+        std::swap(submitted_commands_, frame_list_.Stream());
+        fence_.Wait(pacer_.PendingFenceValue() - 1);
+        return true;
+    }
+
+    void NullRenderDevice::LogMemoryStats() const {
+        std::wcout << L"Null device: " << LiveObjectCount() << L" live objects, upload ring "
+                   << upload_ring_.Used() / 1024 << L" of " << upload_ring_.Capacity() / 1024 << L" KB in use, "
+                   << bindless_slots_.LiveCount() << L" of " << bindless_slots_.Capacity() << L" bindless slots"
+                   << std::endl;
+    }
+
+    std::size_t NullRenderDevice::LiveObjectCount() const {
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        return objects_.size();
+    }
+
+    std::uint64_t NullRenderDevice::CreateObject() {
+        const std::uint64_t handle = next_handle_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        objects_.insert(handle);
+        return handle;
+    }
+
+    void NullRenderDevice::ReleaseObject(std::uint64_t handle) {
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        if (handle != 0 && objects_.count(handle) != 0) {
+            released_objects_.emplace_back(pacer_.PendingFenceValue(), handle);
+        }
+    }
+
+    void NullRenderDevice::RetireObjects(std::uint64_t completed_fence_value) {
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        const auto retired = std::stable_partition(released_objects_.begin(), released_objects_.end(),
+                                                   [&](const auto &released) {
+                                                       return released.first > completed_fence_value;
+                                                   });
+        for (auto it = retired; it != released_objects_.end(); ++it) {
+            objects_.erase(it->second);
+        }
+        released_objects_.erase(retired, released_objects_.end());
+    }
+
+    ResourceHandle NullRenderDevice::CreateBuffer(std::uint64_t size, GpuAddress &address) {
+        address = next_buffer_address_;
+        next_buffer_address_ += (size + kBufferAlignment - 1) & ~(kBufferAlignment - 1);
+        return ResourceHandle{CreateObject()};
+    }
+
+    std::shared_ptr<Texture2D> NullRenderDevice::CreateBindlessTexture() {
+        if (!initialized_) {
+            return {};
+        }
+        DescriptorHandle srv;
+        if (!bindless_slots_.Allocate(srv)) {
+            bindless_slots_.Grow(bindless_slots_.Capacity() * 2);
+            if (!bindless_slots_.Allocate(srv)) {
+                std::wcerr << L"Failed to allocate texture SRV descriptor!" << std::endl;
+                return {};
+            }
+        }
+        auto texture = std::make_shared<Texture2D>();
+        texture->resource = CreateTexture({1, 1, Format::R8G8B8A8Unorm});
+        texture->srv = srv;
+        texture->upload_ticket = upload_batch_;
+        textures_.push_back(texture);
+        return texture;
+    }
+
+}
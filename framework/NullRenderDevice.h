@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "CommandCapture.h"
+#include "DescriptorAllocator.h"
+#include "FramePacer.h"
+#include "NullRenderBackend.h"
+#include "RenderDevice.h"
+#include "RingAllocator.h"
+
+namespace gfw {
+
+// The null backend's RenderDevice. Every Create call returns a fresh handle and nothing else: there is no
+// window, no GPU and no shader compiler, but handle lifetimes, the upload ring, bindless slots and frame pacing
+// behave as on D3D12, with a SimulatedFence standing in for the GPU. Each frame's commands are kept for
+// inspection (GetSubmittedCommands), which is what lets RenderingSystem run and be measured on any host.
+class NullRenderDevice final : public RenderDevice {
+public:
+    static constexpr std::uint32_t kDefaultFramesInFlight = 2;
+    static constexpr std::uint64_t kUploadRingSize = 1024 * 1024;
+    static constexpr std::uint32_t kInitialBindlessDescriptors = 256;
+
+    NullRenderDevice() = default;
+    ~NullRenderDevice() override { Shutdown(); }
+
+    NullRenderDevice(const NullRenderDevice &) = delete;
+    NullRenderDevice &operator=(const NullRenderDevice &) = delete;
+
+    // frames_in_flight is clamped like FramePacer's; the simulated GPU runs frames_in_flight - 1 frames behind.
+    bool Initialize(std::uint32_t width, std::uint32_t height, std::uint32_t frames_in_flight = kDefaultFramesInFlight);
+    void Shutdown();
+
+    [[nodiscard]] RenderBackend GetBackend() const override { return RenderBackend::Null; }
+    [[nodiscard]] bool IsInitialized() const override { return initialized_; }
+    [[nodiscard]] std::uint32_t GetWidth() const override { return width_; }
+    [[nodiscard]] std::uint32_t GetHeight() const override { return height_; }
+    [[nodiscard]] std::uint32_t GetFramesInFlight() const override { return pacer_.FramesInFlight(); }
+    [[nodiscard]] std::uint32_t GetFrameSlot() const override { return frame_index_; }
+    [[nodiscard]] std::uint64_t GetPendingFenceValue() const override { return pacer_.PendingFenceValue(); }
+
+    [[nodiscard]] Viewport GetViewport() const override;
+    [[nodiscard]] ScissorRect GetScissorRect() const override;
+    [[nodiscard]] CpuDescriptor GetBackBufferRtv() const override;
+    [[nodiscard]] CpuDescriptor GetDepthDsv() const override;
+
+    void BeginFrame() override;
+    void EndFrame() override;
+    [[nodiscard]] CommandRecorder &GetRecorder() override { return frame_list_; }
+    [[nodiscard]] std::unique_ptr<DeviceCommandList> CreateCommandList(std::uint32_t frame_slots) override;
+    bool InsertCommandLists(const std::vector<CommandRecorder *> &lists) override;
+
+    using RenderDevice::UploadConstants;
+    GpuAddress UploadConstants(const void *data, std::uint32_t size) override;
+
+    [[nodiscard]] std::unique_ptr<MeshBuffers> CreateMeshBuffers(const MeshData &mesh_data) override;
+    // Resident at once: there is no copy queue to wait for.
+    [[nodiscard]] std::shared_ptr<MeshBuffers> StreamMeshBuffers(const MeshData &mesh_data) override;
+    bool UseMesh(const MeshBuffers &) override { return true; }
+    void ReleaseMeshBuffers(MeshBuffers &mesh) override;
+    [[nodiscard]] std::shared_ptr<Texture2D> CreateSolidTexture(const DirectX::XMFLOAT4 &color) override;
+    // Only checks that the file exists; the pixels are never read.
+    [[nodiscard]] std::shared_ptr<Texture2D> CreateTextureFromFile(const std::wstring &filename) override;
+    [[nodiscard]] std::shared_ptr<Texture2D> StreamTextureFromFile(const std::wstring &filename) override;
+    void ReleaseTexture(const std::shared_ptr<Texture2D> &texture) override;
+    std::uint64_t FlushUploads() override { return upload_batch_++; }
+
+    [[nodiscard]] std::uint32_t GetBindlessIndex(const Texture2D *texture) override;
+    [[nodiscard]] DescriptorHeapHandle GetBindlessHeap() const override { return bindless_heap_; }
+    [[nodiscard]] GpuDescriptor GetBindlessTable() const override { return GetGpuDescriptor(bindless_heap_, 0); }
+
+    [[nodiscard]] ResourceHandle CreateTexture(const TextureDesc &desc) override;
+    [[nodiscard]] DescriptorHeapHandle CreateDescriptorHeap(DescriptorHeapType type, std::uint32_t count) override;
+    bool CreateRenderTargetView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                Format format) override;
+    bool CreateShaderResourceView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                  Format format) override;
+    [[nodiscard]] CpuDescriptor GetCpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const override;
+    [[nodiscard]] GpuDescriptor GetGpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const override;
+
+    [[nodiscard]] RootSignatureHandle CreateRootSignature(const RootSignatureDesc &desc) override;
+    // Fails like D3D12 would on a missing root signature or vertex shader; shaders are never loaded.
+    [[nodiscard]] PipelineHandle CreatePipeline(const PipelineDesc &desc) override;
+
+    void Release(ResourceHandle resource) override { ReleaseObject(resource.value); }
+    void Release(DescriptorHeapHandle heap) override { ReleaseObject(heap.value); }
+    void Release(RootSignatureHandle root_signature) override { ReleaseObject(root_signature.value); }
+    void Release(PipelineHandle pipeline) override { ReleaseObject(pipeline.value); }
+
+    void CaptureNextFrame(const std::wstring &filename) override;
+    [[nodiscard]] bool IsCapturing() const override { return capturing_; }
+    [[nodiscard]] const CommandCapture &GetLastCapture() const override { return capture_; }
+    bool ReplayCapture(const CommandCapture &capture, std::uint32_t iterations) override;
+
+    void LogMemoryStats() const override;
+
+    // Commands of the frame EndFrame submitted last, or of the last ReplayCapture iteration.
+    [[nodiscard]] const CommandStream &GetSubmittedCommands() const { return submitted_commands_; }
+    // Objects created and not destroyed yet; released ones count until the frame they were released in retires.
+    [[nodiscard]] std::size_t LiveObjectCount() const;
+    [[nodiscard]] std::uint64_t CompletedFenceValue() const { return fence_.CompletedValue(); }
+    [[nodiscard]] const FramePacer::Timeline &GetFrameTimeline() const { return pacer_.GetTimeline(); }
+
+private:
+    // The GPU addresses handed out for buffers and ring slices; any nonzero values would do.
+    static constexpr GpuAddress kBufferAddressBase = GpuAddress{1} << 40;
+    static constexpr GpuAddress kBufferAlignment = 64 * 1024;
+    static constexpr GpuAddress kUploadAddressBase = GpuAddress{1} << 48;
+    static constexpr std::uint64_t kConstantAlignment = 256;
+
+    std::uint64_t CreateObject();
+    void ReleaseObject(std::uint64_t handle);
+    // Destroys every released object whose frame has completed.
+    void RetireObjects(std::uint64_t completed_fence_value);
+    ResourceHandle CreateBuffer(std::uint64_t size, GpuAddress &address);
+    std::shared_ptr<Texture2D> CreateBindlessTexture();
+    void FinishCapture();
+
+    bool initialized_ = false;
+    std::uint32_t width_ = 0;
+    std::uint32_t height_ = 0;
+    std::uint32_t frame_index_ = 0;
+    FramePacer pacer_;
+    std::chrono::steady_clock::time_point frame_start_ = {};
+    SimulatedFence fence_;
+    RecordingCommandList frame_list_;
+    CommandStream submitted_commands_;
+    std::vector<ResourceHandle> back_buffers_;
+    DescriptorHeapHandle back_buffer_heap_;
+    ResourceHandle depth_buffer_;
+    DescriptorHeapHandle depth_heap_;
+
+    // Handles are never reused, so a stale one cannot alias a newer object.
+    std::atomic<std::uint64_t> next_handle_ = 1;
+    mutable std::mutex objects_mutex_;
+    std::unordered_set<std::uint64_t> objects_;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> released_objects_; // fence value, handle
+    GpuAddress next_buffer_address_ = kBufferAddressBase;
+
+    // Constants are copied like on D3D12, into CPU memory nothing reads.
+    RingAllocator upload_ring_;
+    std::vector<std::uint8_t> upload_memory_;
+    GpuAddress upload_base_ = kUploadAddressBase;
+    std::uint64_t upload_batch_ = 1;
+
+    DescriptorHeapHandle bindless_heap_;
+    DescriptorAllocator bindless_slots_;
+    std::vector<std::shared_ptr<Texture2D>> textures_;
+    std::shared_ptr<Texture2D> default_texture_;
+
+    CommandCapture capture_;
+    std::wstring capture_path_;
+    bool capture_requested_ = false;
+    bool capturing_ = false;
+};
+
+}
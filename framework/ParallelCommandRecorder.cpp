@@ -0,0 +1,59 @@
+#include "ParallelCommandRecorder.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace gfw {
+
+bool ParallelCommandRecorder::Initialize(RenderDevice &device, std::uint32_t worker_count,
+                                         std::uint32_t frame_slots) {
+    lists_.clear();
+    for (std::uint32_t i = 0; i < std::max(1u, worker_count); ++i) {
+        std::unique_ptr<DeviceCommandList> list = device.CreateCommandList(frame_slots);
+        if (!list) {
+            lists_.clear();
+            return false;
+        }
+        lists_.push_back(std::move(list));
+    }
+    pool_.Start(WorkerCount());
+    std::wcout << L"Parallel recording: " << lists_.size() << L" worker command lists" << std::endl;
+    return true;
+}
+
+void ParallelCommandRecorder::Shutdown() {
+    pool_.Stop();
+    lists_.clear();
+    open_count_ = 0;
+}
+
+void ParallelCommandRecorder::SetCapture(bool capture) {
+    for (const auto &list : lists_) {
+        list->SetCapture(capture);
+    }
+}
+
+bool ParallelCommandRecorder::Begin(std::uint32_t slot, std::uint32_t list_count) {
+    open_count_ = std::min(list_count, WorkerCount());
+    for (std::uint32_t i = 0; i < open_count_; ++i) {
+        if (!lists_[i]->Begin(slot)) {
+            open_count_ = i;
+            std::vector<CommandRecorder *> discarded;
+            Close(discarded);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParallelCommandRecorder::Close(std::vector<CommandRecorder *> &out_lists) {
+    bool ok = true;
+    for (std::uint32_t i = 0; i < open_count_; ++i) {
+        ok &= lists_[i]->Close();
+        out_lists.push_back(&GetRecorder(i));
+    }
+    open_count_ = 0;
+    return ok;
+}
+
+}
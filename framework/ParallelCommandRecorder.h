@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "ParallelFor.h"
+#include "RenderDevice.h"
+
+namespace gfw {
+
+// Command lists for splitting one pass across worker threads. Every worker owns a DeviceCommandList with an
+// allocator per frame slot, so a slot's allocators are only reset once the device has waited for the frame
+// that last used that slot. Lists inherit no state: workers bind render targets, root signature and descriptor
+// heaps themselves before drawing. Lists are recorded on a WorkerPool started once in Initialize.
+class ParallelCommandRecorder {
+public:
+    ParallelCommandRecorder() = default;
+    ~ParallelCommandRecorder() { Shutdown(); }
+
+    ParallelCommandRecorder(const ParallelCommandRecorder &) = delete;
+    ParallelCommandRecorder &operator=(const ParallelCommandRecorder &) = delete;
+
+    bool Initialize(RenderDevice &device, std::uint32_t worker_count, std::uint32_t frame_slots);
+
+    void Shutdown();
+
+    // While on, workers also keep their commands for RenderDevice::InsertCommandLists to append to a frame
+    // capture. Set it before Begin.
+    void SetCapture(bool capture);
+
+    // Opens the first list_count lists (at most WorkerCount()) on slot's allocators.
+    bool Begin(std::uint32_t slot, std::uint32_t list_count);
+
+    // Runs fn(i) for every list i opened by Begin, spread over the worker threads and the calling thread.
+    template <typename Fn>
+    void Record(Fn &&fn) {
+        pool_.Run(open_count_, std::forward<Fn>(fn));
+    }
+
+    [[nodiscard]] CommandRecorder &GetRecorder(std::uint32_t index) { return lists_[index]->Recorder(); }
+
+    // Closes the lists opened by Begin; they are returned in recording order for RenderDevice::InsertCommandLists.
+    bool Close(std::vector<CommandRecorder *> &out_lists);
+
+    [[nodiscard]] std::uint32_t WorkerCount() const { return static_cast<std::uint32_t>(lists_.size()); }
+
+private:
+    std::vector<std::unique_ptr<DeviceCommandList>> lists_;
+    WorkerPool pool_;
+    std::uint32_t open_count_ = 0;
+};
+
+}
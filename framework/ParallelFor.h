@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace gfw {
+
+[[nodiscard]] inline unsigned DefaultWorkerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs fn(i) for every i in [0, count) on up to thread_count threads (the caller included).
+// Items are handed out dynamically, so fn must not depend on which thread runs it.
+template <typename Fn>
+void ParallelFor(std::size_t count, unsigned thread_count, Fn &&fn) {
+    const std::size_t workers = std::min<std::size_t>(std::max(1u, thread_count), count);
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t t = 1; t < workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+// ParallelFor over threads that outlive the call: Start parks thread_count - 1 threads on a condition variable
+// and every Run wakes them, so per-frame work does not pay for creating and joining threads. Run is not
+// reentrant and must only be called from one thread at a time.
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    ~WorkerPool() { Stop(); }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void Start(unsigned thread_count) {
+        Stop();
+        stop_ = false;
+        for (unsigned t = 1; t < std::max(1u, thread_count); ++t) {
+            threads_.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto &thread: threads_) {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+    // The calling thread included.
+    [[nodiscard]] unsigned ThreadCount() const { return static_cast<unsigned>(threads_.size()) + 1; }
+
+    // Runs fn(i) for every i in [0, count) on the pool and the calling thread and returns once all are done.
+    // Items are handed out dynamically, so fn must not depend on which thread runs it.
+    template <typename Fn>
+    void Run(std::size_t count, Fn &&fn) {
+        if (count <= 1 || threads_.empty()) {
+            for (std::size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+        using Callable = std::remove_reference_t<Fn>;
+        Dispatch(count, [](void *context, std::size_t i) { (*static_cast<Callable *>(context))(i); },
+                 const_cast<void *>(static_cast<const void *>(&fn)));
+    }
+
+private:
+    using Task = void (*)(void *context, std::size_t i);
+
+    void Dispatch(std::size_t count, Task task, void *context) {
+        {
+            std::lock_guard lock(mutex_);
+            task_ = task;
+            context_ = context;
+            count_ = count;
+            next_.store(0, std::memory_order_relaxed);
+            busy_ = static_cast<unsigned>(threads_.size());
+            ++generation_;
+        }
+        wake_.notify_all();
+        Drain(task, context, count);
+        std::unique_lock lock(mutex_);
+        done_.wait(lock, [this] { return busy_ == 0; });
+    }
+
+    void Drain(Task task, void *context, std::size_t count) {
+        for (std::size_t i = next_.fetch_add(1); i < count; i = next_.fetch_add(1)) {
+            task(context, i);
+        }
+    }
+
+    void WorkerLoop() {
+        std::uint64_t seen = 0;
+        std::unique_lock lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            const Task task = task_;
+            void *const context = context_;
+            const std::size_t count = count_;
+            lock.unlock();
+            Drain(task, context, count);
+            lock.lock();
+            if (--busy_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    Task task_ = nullptr;
+    void *context_ = nullptr;
+    std::size_t count_ = 0;
+    std::atomic<std::size_t> next_{0};
+    unsigned busy_ = 0;
+    std::uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace gfw
@@ -0,0 +1,209 @@
+#include "PipelineCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace gfw {
+
+namespace {
+    constexpr char kMagic[8] = {'G', 'F', 'W', 'P', 'S', 'O', '\0', '\0'};
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::size_t kBlobAlignment = 16;
+    constexpr std::uint32_t kNullString = 0xFFFFFFFFu;
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entry_count;
+        std::uint32_t vendor_id;
+        std::uint32_t device_id;
+        std::uint32_t subsystem_id;
+        std::uint32_t revision;
+        std::uint64_t driver_version;
+        std::uint64_t file_size;
+    };
+    static_assert(sizeof(FileHeader) == 48);
+
+    // Offsets are from the start of the file.
+    struct EntryRecord {
+        std::uint64_t key;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+    static_assert(sizeof(EntryRecord) == 24);
+
+    std::size_t AlignUp(std::size_t value) {
+        return (value + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+    }
+
+    bool InRange(std::uint64_t offset, std::uint64_t bytes, std::size_t file_size) {
+        return offset <= file_size && bytes <= file_size - offset;
+    }
+}
+
+void PipelineHasher::Add(float value) {
+    if (value == 0.0f) {
+        value = 0.0f;
+    }
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    Add(bits);
+}
+
+void PipelineHasher::AddBytes(const void *data, std::size_t size) {
+    Add(static_cast<std::uint64_t>(size));
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        Mix(bytes[i]);
+    }
+}
+
+void PipelineHasher::AddString(const char *text) {
+    if (!text) {
+        Add(kNullString);
+        return;
+    }
+    const std::size_t length = std::strlen(text);
+    Add(static_cast<std::uint32_t>(length));
+    for (std::size_t i = 0; i < length; ++i) {
+        Mix(static_cast<std::uint8_t>(text[i]));
+    }
+}
+
+bool PipelineCache::Load(const std::wstring &filename, const AdapterIdentity &identity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    identity_ = identity;
+    blobs_.clear();
+    dirty_ = false;
+
+    std::ifstream in(std::filesystem::path(filename), std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    const auto file_size = static_cast<std::size_t>(in.tellg());
+    std::vector<char> data(file_size);
+    in.seekg(0);
+    if (file_size < sizeof(FileHeader) || !in.read(data.data(), static_cast<std::streamsize>(file_size))) {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.file_size != file_size) {
+        return false;
+    }
+    const AdapterIdentity stored = {header.vendor_id, header.device_id, header.subsystem_id, header.revision,
+                                    header.driver_version};
+    if (stored != identity) {
+        std::wcout << L"Pipeline cache was written for another adapter or driver; rebuilding it" << std::endl;
+        return false;
+    }
+    if (!InRange(sizeof(FileHeader), static_cast<std::uint64_t>(header.entry_count) * sizeof(EntryRecord),
+                 file_size)) {
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < header.entry_count; ++i) {
+        EntryRecord record;
+        std::memcpy(&record, data.data() + sizeof(FileHeader) + i * sizeof(EntryRecord), sizeof(record));
+        if (!InRange(record.offset, record.size, file_size)) {
+            blobs_.clear();
+            return false;
+        }
+        const char *blob = data.data() + record.offset;
+        blobs_[record.key].assign(blob, blob + record.size);
+    }
+    return true;
+}
+
+bool PipelineCache::Save(const std::wstring &filename) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<EntryRecord> records;
+    records.reserve(blobs_.size());
+    std::size_t offset = AlignUp(sizeof(FileHeader) + blobs_.size() * sizeof(EntryRecord));
+    for (const auto &[key, blob] : blobs_) {
+        records.push_back({key, offset, blob.size()});
+        offset = AlignUp(offset + blob.size());
+    }
+
+    std::vector<char> data(offset, 0);
+    FileHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.entry_count = static_cast<std::uint32_t>(records.size());
+    header.vendor_id = identity_.vendor_id;
+    header.device_id = identity_.device_id;
+    header.subsystem_id = identity_.subsystem_id;
+    header.revision = identity_.revision;
+    header.driver_version = identity_.driver_version;
+    header.file_size = data.size();
+    std::memcpy(data.data(), &header, sizeof(header));
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        std::memcpy(data.data() + sizeof(FileHeader) + i * sizeof(EntryRecord), &records[i], sizeof(EntryRecord));
+        const std::vector<std::uint8_t> &blob = blobs_.at(records[i].key);
+        if (!blob.empty()) {
+            std::memcpy(data.data() + records[i].offset, blob.data(), blob.size());
+        }
+    }
+
+    // Write a sibling temp file first so a crash never leaves a truncated cache behind.
+    const std::filesystem::path final_path(filename);
+    std::filesystem::path temp_path = final_path;
+    temp_path += L".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open() || !out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            std::wcerr << L"Failed to write pipeline cache: " << temp_path.wstring() << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, final_path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        std::wcerr << L"Failed to replace pipeline cache: " << filename << std::endl;
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool PipelineCache::Find(std::uint64_t key, std::vector<std::uint8_t> &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = blobs_.find(key);
+    if (it == blobs_.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+void PipelineCache::Store(std::uint64_t key, const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    std::lock_guard<std::mutex> lock(mutex_);
+    blobs_[key].assign(bytes, bytes + size);
+    dirty_ = true;
+}
+
+void PipelineCache::Erase(std::uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blobs_.erase(key) > 0) {
+        dirty_ = true;
+    }
+}
+
+std::size_t PipelineCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blobs_.size();
+}
+
+bool PipelineCache::IsDirty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirty_;
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace gfw {
+
+// Incremental FNV-1a over a canonical encoding: integers as little-endian bytes, floats by bit pattern with
+// -0 folded into +0, byte ranges and strings length-prefixed. Pointers never enter the hash, so a key is
+// stable across runs, processes and hosts; callers hash what a pointer refers to instead.
+class PipelineHasher {
+public:
+    void Add(std::uint8_t value) { Mix(value); }
+    void Add(std::uint32_t value) { AddLittleEndian(value, 4); }
+    void Add(std::int32_t value) { Add(static_cast<std::uint32_t>(value)); }
+    void Add(std::uint64_t value) { AddLittleEndian(value, 8); }
+    void Add(float value);
+
+    template <typename Enum>
+        requires std::is_enum_v<Enum>
+    void Add(Enum value) {
+        Add(static_cast<std::uint32_t>(value));
+    }
+
+    void AddBytes(const void *data, std::size_t size);
+    // Null and "" hash differently.
+    void AddString(const char *text);
+
+    [[nodiscard]] std::uint64_t Value() const { return hash_; }
+
+private:
+    void Mix(std::uint8_t byte) {
+        hash_ ^= byte;
+        hash_ *= 1099511628211ull;
+    }
+
+    void AddLittleEndian(std::uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            Mix(static_cast<std::uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    std::uint64_t hash_ = 14695981039346656037ull;
+};
+
+// Driver blobs are only valid for the adapter and driver that produced them.
+struct AdapterIdentity {
+    std::uint32_t vendor_id = 0;
+    std::uint32_t device_id = 0;
+    std::uint32_t subsystem_id = 0;
+    std::uint32_t revision = 0;
+    std::uint64_t driver_version = 0;
+
+    bool operator==(const AdapterIdentity &other) const = default;
+};
+
+// Compiled pipeline blobs by canonical description hash, persisted as one versioned file (.gfwpso). A file
+// written for another adapter, driver or format version is ignored as a whole. Thread-safe, so pipelines can
+// be created on several threads at once.
+class PipelineCache {
+public:
+    // Adopts identity either way; returns false (and starts empty) when the file is missing, stale or malformed.
+    bool Load(const std::wstring &filename, const AdapterIdentity &identity);
+
+    // Writes a sibling temp file and renames it over filename.
+    bool Save(const std::wstring &filename);
+
+    // Copies the blob stored for key into out; false if there is none.
+    bool Find(std::uint64_t key, std::vector<std::uint8_t> &out) const;
+    void Store(std::uint64_t key, const void *data, std::size_t size);
+    // Drops a blob the driver rejected.
+    void Erase(std::uint64_t key);
+
+    [[nodiscard]] std::size_t Size() const;
+    [[nodiscard]] bool IsDirty() const;
+
+private:
+    mutable std::mutex mutex_;
+    AdapterIdentity identity_ = {};
+    std::unordered_map<std::uint64_t, std::vector<std::uint8_t>> blobs_;
+    bool dirty_ = false;
+};
+
+}
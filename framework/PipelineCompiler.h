@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ShaderPermutation.h"
+
+namespace gfw {
+
+// Creates pipelines on worker threads so neither startup nor the first use of a variant stalls the render
+// thread. Startup jobs (needed for the first frame) run before background ones (variants asked for lazily);
+// while a pipeline is pending Acquire returns nullptr and the caller falls back or skips the draw for that
+// frame. Failed creations are remembered, so a broken variant is reported once instead of every frame.
+// Pipeline must be default-constructible, movable and test false when creation failed; the create function
+// runs on the workers and has to be thread-safe (ID3D12Device::CreateGraphicsPipelineState is).
+template <typename Pipeline>
+class PipelineCompiler {
+public:
+    enum class Priority { Startup, Background };
+
+    struct Stats {
+        std::size_t ready = 0;
+        std::size_t pending = 0;
+        std::size_t failed = 0;
+        double create_ms = 0.0; // summed over workers
+    };
+
+    using CreateFunction = std::function<Pipeline(const PermutationKey &)>;
+
+    PipelineCompiler() = default;
+    ~PipelineCompiler() { Stop(); }
+
+    PipelineCompiler(const PipelineCompiler &) = delete;
+    PipelineCompiler &operator=(const PipelineCompiler &) = delete;
+
+    // Jobs requested before Start wait for the workers. Does nothing while already started.
+    void Start(unsigned thread_count, CreateFunction create) {
+        if (!workers_.empty()) {
+            return;
+        }
+        create_ = std::move(create);
+        for (unsigned i = 0; i < std::max(1u, thread_count); ++i) {
+            workers_.emplace_back([this]() { WorkerMain(); });
+        }
+    }
+
+    // Joins the workers after their current job. Queued jobs are dropped; finished pipelines stay until Clear.
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+        for (const PermutationKey &key : startup_queue_) {
+            entries_.erase(key);
+        }
+        for (const PermutationKey &key : background_queue_) {
+            entries_.erase(key);
+        }
+        startup_queue_.clear();
+        background_queue_.clear();
+        startup_outstanding_ = 0;
+        done_cv_.notify_all();
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        create_ms_ = 0.0;
+    }
+
+    // Queues key unless it is known already; a queued background job is moved up when startup asks for it.
+    void Request(const PermutationKey &key, Priority priority) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = entries_.find(key);
+            if (it == entries_.end()) {
+                entries_.emplace(key, Entry{State::Queued, priority, Pipeline{}});
+                Enqueue(key, priority);
+            } else if (priority == Priority::Startup && it->second.state == State::Queued &&
+                       it->second.priority == Priority::Background) {
+                std::erase(background_queue_, key);
+                it->second.priority = Priority::Startup;
+                Enqueue(key, priority);
+            } else {
+                return;
+            }
+        }
+        work_cv_.notify_one();
+    }
+
+    // The pipeline if it is ready, otherwise nullptr; unknown keys are queued as background jobs. Never blocks.
+    const Pipeline *Acquire(const PermutationKey &key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                return it->second.state == State::Ready ? &it->second.pipeline : nullptr;
+            }
+        }
+        Request(key, Priority::Background);
+        return nullptr;
+    }
+
+    // Blocks until no startup job is queued or running; false if any startup job failed.
+    bool WaitForStartup() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this]() { return startup_outstanding_ == 0; });
+        for (const auto &[key, entry] : entries_) {
+            if (entry.priority == Priority::Startup && entry.state == State::Failed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats;
+        for (const auto &[key, entry] : entries_) {
+            switch (entry.state) {
+                case State::Ready:
+                    ++stats.ready;
+                    break;
+                case State::Failed:
+                    ++stats.failed;
+                    break;
+                default:
+                    ++stats.pending;
+                    break;
+            }
+        }
+        stats.create_ms = create_ms_;
+        return stats;
+    }
+
+    [[nodiscard]] unsigned ThreadCount() const { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    enum class State { Queued, Running, Ready, Failed };
+
+    struct Entry {
+        State state = State::Queued;
+        Priority priority = Priority::Background;
+        Pipeline pipeline;
+    };
+
+    // Caller holds mutex_.
+    void Enqueue(const PermutationKey &key, Priority priority) {
+        if (priority == Priority::Startup) {
+            startup_queue_.push_back(key);
+            ++startup_outstanding_;
+        } else {
+            background_queue_.push_back(key);
+        }
+    }
+
+    void WorkerMain() {
+        for (;;) {
+            PermutationKey key;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_cv_.wait(lock, [this]() { return stop_ || !startup_queue_.empty() || !background_queue_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                std::deque<PermutationKey> &queue = startup_queue_.empty() ? background_queue_ : startup_queue_;
+                key = queue.front();
+                queue.pop_front();
+                entries_[key].state = State::Running;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            Pipeline pipeline = create_(key);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Entry &entry = entries_[key];
+                entry.state = pipeline ? State::Ready : State::Failed;
+                entry.pipeline = std::move(pipeline);
+                create_ms_ += ms;
+                if (entry.priority == Priority::Startup) {
+                    --startup_outstanding_;
+                }
+            }
+            done_cv_.notify_all();
+        }
+    }
+
+    CreateFunction create_;
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::unordered_map<PermutationKey, Entry, PermutationKeyHash> entries_;
+    std::deque<PermutationKey> startup_queue_;
+    std::deque<PermutationKey> background_queue_;
+    std::size_t startup_outstanding_ = 0;
+    double create_ms_ = 0.0;
+    bool stop_ = false;
+};
+
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CommandRecorder.h"
+#include "Constants.h"
+#include "FrameworkTypes.h"
+#include "../MeshData.h"
+
+namespace gfw {
+
+class CommandCapture;
+
+// Texel and vertex element formats the renderer creates resources and input layouts with.
+enum class Format : std::uint32_t {
+    Unknown,
+    R8G8B8A8Unorm,
+    R16G16B16A16Float,
+    R16G16B16A16Unorm,
+    R16G16Float,
+    R16G16Snorm,
+    R32G32Float,
+    R32G32B32Float,
+    R32G32B32A32Float,
+    D32Float
+};
+
+enum class DescriptorHeapType : std::uint32_t {
+    RenderTarget,  // CPU-only, for SetRenderTargets
+    ShaderResource // shader visible, for SetDescriptorHeap and descriptor tables
+};
+
+// A single-mip 2D texture.
+struct TextureDesc {
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    Format format = Format::Unknown;
+    bool render_target = false; // also cleared to zero
+    ResourceState initial_state = ResourceState::PixelShaderResource;
+};
+
+enum class ShaderVisibility : std::uint32_t { All, Pixel };
+enum class SamplerAddress : std::uint32_t { Wrap, Clamp };
+
+// Every root signature of the renderer has the same shape: a root CBV at b0 in slot 0, a table of SRVs starting
+// at t0 in slot 1, and one linear static sampler at s0. Only these parts vary.
+struct RootSignatureDesc {
+    static constexpr std::uint32_t kUnboundedTable = UINT32_MAX;
+
+    ShaderVisibility visibility = ShaderVisibility::All;
+    std::uint32_t table_size = 1; // kUnboundedTable for a bindless array
+    std::uint32_t table_space = 0;
+    SamplerAddress sampler_address = SamplerAddress::Wrap;
+};
+
+// One shader of a pipeline; a null file leaves the stage out. Each define is compiled in as NAME=1.
+struct ShaderStage {
+    static constexpr std::uint32_t kMaxDefines = 4;
+
+    const char *file = nullptr;
+    const char *entry = nullptr;
+    const char *profile = nullptr; // used by the runtime compilation fallback
+    std::array<const char *, kMaxDefines> defines = {};
+    std::uint32_t define_count = 0;
+};
+
+// A per-vertex attribute of vertex buffer 0, semantic index 0.
+struct InputElement {
+    const char *semantic = nullptr;
+    Format format = Format::Unknown;
+    std::uint32_t offset = 0;
+};
+
+enum class CullMode : std::uint32_t { None, Back };
+enum class PrimitiveType : std::uint32_t { Triangle, Patch };
+
+// An opaque graphics pipeline without stencil. Depth testing (LESS, with writes) is on exactly when
+// dsv_format is set.
+struct PipelineDesc {
+    static constexpr std::uint32_t kMaxInputElements = 8;
+
+    RootSignatureHandle root_signature;
+    ShaderStage vs;
+    ShaderStage hs;
+    ShaderStage ds;
+    ShaderStage ps;
+    std::array<InputElement, kMaxInputElements> input_layout = {};
+    std::uint32_t input_count = 0;
+    PrimitiveType primitive = PrimitiveType::Triangle;
+    std::array<Format, CommandRecorder::kMaxRenderTargets> rtv_formats = {};
+    std::uint32_t rtv_count = 0;
+    Format dsv_format = Format::Unknown;
+    bool wireframe = false;
+    CullMode cull = CullMode::None;
+};
+
+// A command list with an allocator per frame slot for one recording thread, from RenderDevice::CreateCommandList.
+// Begin(slot) may only reuse slot's allocator once the frame that last used that slot has completed, which the
+// device's BeginFrame guarantees for GetFrameSlot(). The list inherits no state from the frame.
+class DeviceCommandList {
+public:
+    virtual ~DeviceCommandList() = default;
+
+    virtual bool Begin(std::uint32_t slot) = 0;
+    virtual bool Close() = 0;
+    [[nodiscard]] virtual CommandRecorder &Recorder() = 0;
+    // While on, the list's commands are also kept for RenderDevice::InsertCommandLists to add to a frame
+    // capture. Set it before Begin.
+    virtual void SetCapture(bool capture) = 0;
+};
+
+// Resource creation and the frame loop, the other half of the render hardware interface next to
+// CommandRecorder. Framework implements it on D3D12; NullRenderDevice hands out handles without a GPU, so the
+// renderer can run headless on any host. Every handle a Create call returns is owned by the device until it is
+// passed to Release, which keeps the object alive until the frame being recorded has completed; the device
+// frees whatever is left at shutdown.
+class RenderDevice {
+public:
+    virtual ~RenderDevice() = default;
+
+    [[nodiscard]] virtual RenderBackend GetBackend() const = 0;
+    [[nodiscard]] virtual bool IsInitialized() const = 0;
+    [[nodiscard]] virtual std::uint32_t GetWidth() const = 0;
+    [[nodiscard]] virtual std::uint32_t GetHeight() const = 0;
+    [[nodiscard]] virtual std::uint32_t GetFramesInFlight() const = 0;
+    // Back buffer and allocator slot of the frame being recorded.
+    [[nodiscard]] virtual std::uint32_t GetFrameSlot() const = 0;
+    // Fence value that retires the frame being recorded.
+    [[nodiscard]] virtual std::uint64_t GetPendingFenceValue() const = 0;
+
+    [[nodiscard]] virtual Viewport GetViewport() const = 0;
+    [[nodiscard]] virtual ScissorRect GetScissorRect() const = 0;
+    [[nodiscard]] virtual CpuDescriptor GetBackBufferRtv() const = 0;
+    [[nodiscard]] virtual CpuDescriptor GetDepthDsv() const = 0;
+
+    // Frame loop
+    virtual void BeginFrame() = 0;
+    virtual void EndFrame() = 0;
+    // Records into the frame's main command list between BeginFrame and EndFrame.
+    [[nodiscard]] virtual CommandRecorder &GetRecorder() = 0;
+    [[nodiscard]] virtual std::unique_ptr<DeviceCommandList> CreateCommandList(std::uint32_t frame_slots) = 0;
+    // Submits closed lists (DeviceCommandList::Recorder) after what the frame has recorded so far, in order;
+    // later GetRecorder commands follow them. Viewport and scissor are reset, other state has to be set again.
+    virtual bool InsertCommandLists(const std::vector<CommandRecorder *> &lists) = 0;
+
+    // Copies data into this frame's slice of the upload ring; returns its address, or 0 when the ring is full.
+    virtual GpuAddress UploadConstants(const void *data, std::uint32_t size) = 0;
+
+    template <typename T>
+    GpuAddress UploadConstants(const T &data) {
+        return UploadConstants(&data, static_cast<std::uint32_t>(sizeof(T)));
+    }
+
+    // Meshes and textures
+    [[nodiscard]] virtual std::unique_ptr<MeshBuffers> CreateMeshBuffers(const MeshData &mesh_data) = 0;
+    // Returns at once; the buffers become drawable once UseMesh says so.
+    [[nodiscard]] virtual std::shared_ptr<MeshBuffers> StreamMeshBuffers(const MeshData &mesh_data) = 0;
+    // True when the mesh can be drawn this frame.
+    virtual bool UseMesh(const MeshBuffers &mesh) = 0;
+    virtual void ReleaseMeshBuffers(MeshBuffers &mesh) = 0;
+    [[nodiscard]] virtual std::shared_ptr<Texture2D> CreateSolidTexture(const DirectX::XMFLOAT4 &color) = 0;
+    [[nodiscard]] virtual std::shared_ptr<Texture2D> CreateTextureFromFile(const std::wstring &filename) = 0;
+    // Returns at once; GetBindlessIndex falls back to the default texture until the pixels are resident.
+    [[nodiscard]] virtual std::shared_ptr<Texture2D> StreamTextureFromFile(const std::wstring &filename) = 0;
+    virtual void ReleaseTexture(const std::shared_ptr<Texture2D> &texture) = 0;
+    // Closes the batch of mesh and texture uploads queued so far; returns its UploadTicket.
+    virtual std::uint64_t FlushUploads() = 0;
+
+    // Bindless textures: one shader-visible heap the material textures live in.
+    [[nodiscard]] virtual std::uint32_t GetBindlessIndex(const Texture2D *texture) = 0;
+    [[nodiscard]] virtual DescriptorHeapHandle GetBindlessHeap() const = 0;
+    [[nodiscard]] virtual GpuDescriptor GetBindlessTable() const = 0;
+
+    // Render targets and their views
+    [[nodiscard]] virtual ResourceHandle CreateTexture(const TextureDesc &desc) = 0;
+    [[nodiscard]] virtual DescriptorHeapHandle CreateDescriptorHeap(DescriptorHeapType type, std::uint32_t count) = 0;
+    virtual bool CreateRenderTargetView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                        Format format) = 0;
+    virtual bool CreateShaderResourceView(DescriptorHeapHandle heap, std::uint32_t index, ResourceHandle resource,
+                                          Format format) = 0;
+    [[nodiscard]] virtual CpuDescriptor GetCpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const = 0;
+    [[nodiscard]] virtual GpuDescriptor GetGpuDescriptor(DescriptorHeapHandle heap, std::uint32_t index) const = 0;
+
+    // Pipelines; both may be called from several threads at once.
+    [[nodiscard]] virtual RootSignatureHandle CreateRootSignature(const RootSignatureDesc &desc) = 0;
+    [[nodiscard]] virtual PipelineHandle CreatePipeline(const PipelineDesc &desc) = 0;
+
+    virtual void Release(ResourceHandle resource) = 0;
+    virtual void Release(DescriptorHeapHandle heap) = 0;
+    virtual void Release(RootSignatureHandle root_signature) = 0;
+    virtual void Release(PipelineHandle pipeline) = 0;
+
+    // Frame capture (see CommandCapture)
+    virtual void CaptureNextFrame(const std::wstring &filename) = 0;
+    [[nodiscard]] virtual bool IsCapturing() const = 0;
+    [[nodiscard]] virtual const CommandCapture &GetLastCapture() const = 0;
+    virtual bool ReplayCapture(const CommandCapture &capture, std::uint32_t iterations) = 0;
+
+    virtual void LogMemoryStats() const = 0;
+
+    [[nodiscard]] const SceneState &GetSceneState() const { return scene_state_; }
+    void SetCamera(const Camera &camera) { scene_state_.camera = camera; }
+
+protected:
+    SceneState scene_state_ = {};
+};
+
+// Owns one device object and releases it through the device, like a ComPtr for handles.
+template <typename Handle>
+class DeviceObject {
+public:
+    DeviceObject() = default;
+    DeviceObject(RenderDevice *device, Handle handle) : device_(device), handle_(handle) {}
+    ~DeviceObject() { Reset(); }
+
+    DeviceObject(const DeviceObject &) = delete;
+    DeviceObject &operator=(const DeviceObject &) = delete;
+
+    DeviceObject(DeviceObject &&other) noexcept
+        : device_(std::exchange(other.device_, nullptr)), handle_(std::exchange(other.handle_, Handle{})) {}
+
+    DeviceObject &operator=(DeviceObject &&other) noexcept {
+        if (this != &other) {
+            Reset();
+            device_ = std::exchange(other.device_, nullptr);
+            handle_ = std::exchange(other.handle_, Handle{});
+        }
+        return *this;
+    }
+
+    void Reset() {
+        if (device_ && handle_) {
+            device_->Release(handle_);
+        }
+        device_ = nullptr;
+        handle_ = {};
+    }
+
+    [[nodiscard]] Handle Get() const { return handle_; }
+    explicit operator bool() const { return static_cast<bool>(handle_); }
+
+private:
+    RenderDevice *device_ = nullptr;
+    Handle handle_ = {};
+};
+
+using PipelineObject = DeviceObject<PipelineHandle>;
+using RootSignatureObject = DeviceObject<RootSignatureHandle>;
+
+}
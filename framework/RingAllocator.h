@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+namespace gfw {
+
+// Offset bookkeeping for a linear ring buffer shared by the frames in flight. Allocations made between two
+// FinishFrame calls belong to one frame and are released together once the fence value passed to FinishFrame
+// has completed. Pure logic so it can be driven by any fence, real or fake.
+class RingAllocator {
+public:
+    RingAllocator() = default;
+
+    explicit RingAllocator(std::uint64_t capacity) : capacity_(capacity) {}
+
+    // Returns false when the ring cannot fit size bytes (after padding to alignment) without overwriting
+    // memory still in use by an unretired frame. alignment must be a power of two.
+    bool Allocate(std::uint64_t size, std::uint64_t alignment, std::uint64_t &offset) {
+        if (size == 0 || size > capacity_) {
+            return false;
+        }
+        std::uint64_t start = (head_ + alignment - 1) & ~(alignment - 1);
+        if (start + size > capacity_) {
+            start = 0; // the tail of the buffer is skipped and counted as consumed
+        }
+        const std::uint64_t end = start + size;
+        const std::uint64_t consumed = start >= head_ ? end - head_ : (capacity_ - head_) + end;
+        if (used_ + consumed > capacity_) {
+            return false;
+        }
+        used_ += consumed;
+        frame_bytes_ += consumed;
+        head_ = end == capacity_ ? 0 : end;
+        offset = start;
+        return true;
+    }
+
+    // Closes the current frame; its allocations stay live until Retire sees fence_value completed.
+    void FinishFrame(std::uint64_t fence_value) {
+        if (frame_bytes_ > 0) {
+            frames_.push_back({fence_value, frame_bytes_});
+        }
+        frame_bytes_ = 0;
+    }
+
+    // Releases every finished frame whose fence value is <= completed_fence_value.
+    void Retire(std::uint64_t completed_fence_value) {
+        while (!frames_.empty() && frames_.front().fence_value <= completed_fence_value) {
+            used_ -= frames_.front().bytes;
+            frames_.pop_front();
+        }
+        if (used_ == 0) {
+            head_ = 0;
+        }
+    }
+
+    [[nodiscard]] std::uint64_t Capacity() const { return capacity_; }
+    [[nodiscard]] std::uint64_t Used() const { return used_; }
+    [[nodiscard]] std::uint64_t FrameBytes() const { return frame_bytes_; }
+    [[nodiscard]] std::size_t FramesInFlight() const { return frames_.size(); }
+
+private:
+    struct Frame {
+        std::uint64_t fence_value;
+        std::uint64_t bytes;
+    };
+
+    std::uint64_t capacity_ = 0;
+    std::uint64_t head_ = 0;
+    std::uint64_t used_ = 0;
+    std::uint64_t frame_bytes_ = 0;
+    std::deque<Frame> frames_;
+};
+
+}
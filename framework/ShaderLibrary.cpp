@@ -0,0 +1,91 @@
+#include "ShaderLibrary.h"
+
+#include <d3dcompiler.h>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if !GFW_EMBEDDED_SHADERS || defined(_DEBUG)
+#define GFW_RUNTIME_SHADER_FALLBACK 1
+#endif
+
+namespace gfw {
+namespace {
+#if GFW_EMBEDDED_SHADERS
+struct EmbeddedShader {
+    const char *file;
+    const char *entry;
+    const char *defines; // NAME=VALUE pairs joined with ';'
+    const unsigned char *data;
+    size_t size;
+};
+
+// Generated by gfw_embed_shaders: the dxc -Fh headers and kEmbeddedShaders.
+#include "ShaderTable.inc"
+#endif
+
+// Same encoding as the DEFINES key written by cmake/EmbedShaders.cmake.
+std::string DefinesKey(const D3D_SHADER_MACRO *defines) {
+    std::string key;
+    for (const D3D_SHADER_MACRO *macro = defines; macro && macro->Name; ++macro) {
+        if (!key.empty()) {
+            key += ';';
+        }
+        key += macro->Name;
+        key += '=';
+        key += macro->Definition ? macro->Definition : "";
+    }
+    return key;
+}
+
+#if GFW_RUNTIME_SHADER_FALLBACK
+bool CompileShaderFile(const char *file, const char *entry, const char *profile, const D3D_SHADER_MACRO *defines,
+                       ShaderBytecode &out) {
+    UINT flags = 0;
+#ifdef _DEBUG
+    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+    const std::string relative = std::string("shaders/") + file;
+    const std::wstring path(relative.begin(), relative.end());
+    Microsoft::WRL::ComPtr<ID3DBlob> error_blob;
+    if (FAILED(D3DCompileFromFile(path.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, entry, profile, flags, 0,
+                                  &out.blob, &error_blob))) {
+        if (error_blob) std::cerr << static_cast<const char *>(error_blob->GetBufferPointer()) << std::endl;
+        return false;
+    }
+    out.bytecode = {out.blob->GetBufferPointer(), out.blob->GetBufferSize()};
+    return true;
+}
+#endif
+}
+
+bool LoadShader(const char *file, const char *entry, const char *fallback_profile, const D3D_SHADER_MACRO *defines,
+                ShaderBytecode &out) {
+    const std::string defines_key = DefinesKey(defines);
+#if GFW_EMBEDDED_SHADERS
+    for (const EmbeddedShader &shader : kEmbeddedShaders) {
+        if (std::strcmp(shader.file, file) == 0 && std::strcmp(shader.entry, entry) == 0 &&
+            defines_key == shader.defines) {
+            out.blob.Reset();
+            out.bytecode = {shader.data, shader.size};
+            return true;
+        }
+    }
+#endif
+#if GFW_RUNTIME_SHADER_FALLBACK
+#if GFW_EMBEDDED_SHADERS
+    std::cerr << "Shader " << file << ':' << entry << " [" << defines_key
+              << "] is not in shaders/Shaders.cmake, compiling it at runtime" << std::endl;
+#endif
+    if (CompileShaderFile(file, entry, fallback_profile, defines, out)) {
+        return true;
+    }
+#else
+    (void)fallback_profile;
+#endif
+    std::cerr << "Failed to load shader " << file << ':' << entry << " [" << defines_key << "]" << std::endl;
+    return false;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <d3dcommon.h>
+
+namespace gfw {
+
+// Bytecode of one shader entry point: a view of a blob embedded at build time, or a runtime-compiled blob it
+// keeps alive.
+struct ShaderBytecode {
+    D3D12_SHADER_BYTECODE bytecode = {};
+    Microsoft::WRL::ComPtr<ID3DBlob> blob;
+
+    [[nodiscard]] D3D12_SHADER_BYTECODE Get() const { return bytecode; }
+};
+
+// Returns the DXC-compiled DXIL of file's (relative to shaders/) entry point built with defines, which must be
+// listed in the same order as in shaders/Shaders.cmake. Debug builds, and builds configured with
+// GFW_EMBED_SHADERS=OFF, compile the .hlsl at runtime for fallback_profile when no blob was embedded. A
+// pipeline must not mix such DXBC with embedded DXIL, so a debug fallback is only a stopgap until the manifest
+// has the entry.
+bool LoadShader(const char *file, const char *entry, const char *fallback_profile, const D3D_SHADER_MACRO *defines,
+                ShaderBytecode &out);
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gfw {
+
+// Identifies one pipeline variant: the pass it belongs to and the feature bits that were compiled in.
+struct PermutationKey {
+    std::uint32_t pass = 0;
+    std::uint32_t features = 0;
+
+    bool operator==(const PermutationKey &other) const = default;
+
+    // FNV-1a over both words. Stable across runs and platforms, so it can also name persisted pipelines.
+    [[nodiscard]] std::uint64_t Hash() const {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (const std::uint32_t word : {pass, features}) {
+            for (int byte = 0; byte < 4; ++byte) {
+                hash ^= (word >> (byte * 8)) & 0xFFu;
+                hash *= 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+};
+
+struct PermutationKeyHash {
+    std::size_t operator()(const PermutationKey &key) const { return static_cast<std::size_t>(key.Hash()); }
+};
+
+}
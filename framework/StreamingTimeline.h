@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace gfw {
+
+// Per-frame residency decisions for resources filled by the copy queue. Every streamed resource carries
+// the streaming-fence value it is resident after (kNotResident while its copy has not been submitted).
+// Draws skip or substitute resources that are still pending, and the frame's queue waits on the streaming
+// fence only up to the largest value among resources it actually used. Pure logic so it can be driven by
+// any fence, real or fake.
+class StreamingTimeline {
+public:
+    static constexpr std::uint64_t kNotResident = ~std::uint64_t{0};
+
+    // completed_fence_value is the streaming fence's completed value when recording starts.
+    void BeginFrame(std::uint64_t completed_fence_value) {
+        completed_ = completed_fence_value;
+        wait_value_ = 0;
+        placeholders_ = 0;
+    }
+
+    // Returns false when the resource must not be referenced this frame; otherwise records the wait it needs.
+    bool Use(std::uint64_t resident_fence) {
+        if (resident_fence == kNotResident) {
+            ++placeholders_;
+            return false;
+        }
+        if (resident_fence > completed_) {
+            wait_value_ = std::max(wait_value_, resident_fence);
+        }
+        return true;
+    }
+
+    // Streaming-fence value the frame's queue has to wait for before executing; 0 when none.
+    [[nodiscard]] std::uint64_t WaitValue() const { return wait_value_; }
+
+    // Resources rejected by Use since BeginFrame.
+    [[nodiscard]] std::uint32_t PlaceholderCount() const { return placeholders_; }
+
+private:
+    std::uint64_t completed_ = 0;
+    std::uint64_t wait_value_ = 0;
+    std::uint32_t placeholders_ = 0;
+};
+
+}
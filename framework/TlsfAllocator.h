@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace gfw {
+
+// Two-level segregated fit (TLSF) offset allocator. Free ranges are kept in size-class lists indexed by a
+// two-level bitmap, so Allocate and Free are O(1) regardless of how many ranges exist, and adjacent free
+// ranges are merged on Free to keep fragmentation low. Manages offsets only; pure logic so it can sub-allocate
+// any linear resource (an ID3D12Heap here) and be exercised without a device.
+class TlsfAllocator {
+public:
+    static constexpr std::uint32_t kInvalidNode = ~0u;
+
+    struct Allocation {
+        std::uint32_t node = kInvalidNode;
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+
+        [[nodiscard]] bool IsValid() const { return node != kInvalidNode; }
+    };
+
+    TlsfAllocator() { ResetHeads(); }
+
+    explicit TlsfAllocator(std::uint64_t capacity) : capacity_(capacity) {
+        ResetHeads();
+        if (capacity_ > 0) {
+            InsertFree(NewNode(0, capacity_, kInvalidNode, kInvalidNode));
+        }
+    }
+
+    // alignment must be a power of two. Returns false when no free range can hold size aligned bytes.
+    bool Allocate(std::uint64_t size, std::uint64_t alignment, Allocation &out) {
+        if (size == 0 || size > capacity_) {
+            return false;
+        }
+        // Searching for size + alignment - 1 guarantees any range found can be aligned without another search.
+        const std::uint64_t search = size + (alignment > 1 ? alignment - 1 : 0);
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+        MapSearch(search, fl, sl);
+        std::uint32_t node = FindFree(fl, sl);
+        if (node == kInvalidNode) {
+            return false;
+        }
+        RemoveFree(node);
+
+        const std::uint64_t aligned = (nodes_[node].offset + alignment - 1) & ~(alignment - 1);
+        const std::uint64_t padding = aligned - nodes_[node].offset;
+        if (padding > 0) {
+            // Give the leading padding back as its own free range; its physical predecessor is in use.
+            const std::uint32_t front = NewNode(nodes_[node].offset, padding, nodes_[node].prev_phys, node);
+            if (nodes_[front].prev_phys != kInvalidNode) {
+                nodes_[nodes_[front].prev_phys].next_phys = front;
+            }
+            nodes_[node].prev_phys = front;
+            nodes_[node].offset = aligned;
+            nodes_[node].size -= padding;
+            InsertFree(front);
+        }
+        if (nodes_[node].size > size) {
+            const std::uint32_t back = NewNode(aligned + size, nodes_[node].size - size, node, nodes_[node].next_phys);
+            if (nodes_[back].next_phys != kInvalidNode) {
+                nodes_[nodes_[back].next_phys].prev_phys = back;
+            }
+            nodes_[node].next_phys = back;
+            nodes_[node].size = size;
+            InsertFree(back);
+        }
+
+        used_ += size;
+        ++allocation_count_;
+        out = {node, aligned, size};
+        return true;
+    }
+
+    void Free(const Allocation &allocation) {
+        if (!allocation.IsValid() || allocation.node >= nodes_.size() || nodes_[allocation.node].free) {
+            return;
+        }
+        std::uint32_t node = allocation.node;
+        used_ -= nodes_[node].size;
+        --allocation_count_;
+
+        const std::uint32_t prev = nodes_[node].prev_phys;
+        if (prev != kInvalidNode && nodes_[prev].free) {
+            RemoveFree(prev);
+            nodes_[prev].size += nodes_[node].size;
+            Unlink(node, prev);
+            node = prev;
+        }
+        const std::uint32_t next = nodes_[node].next_phys;
+        if (next != kInvalidNode && nodes_[next].free) {
+            RemoveFree(next);
+            nodes_[node].size += nodes_[next].size;
+            Unlink(next, node);
+        }
+        InsertFree(node);
+    }
+
+    [[nodiscard]] std::uint64_t Capacity() const { return capacity_; }
+    [[nodiscard]] std::uint64_t Used() const { return used_; }
+    [[nodiscard]] std::uint64_t FreeBytes() const { return capacity_ - used_; }
+    [[nodiscard]] std::uint32_t AllocationCount() const { return allocation_count_; }
+    [[nodiscard]] bool IsEmpty() const { return allocation_count_ == 0; }
+
+    // Size of the largest range a single Allocate with alignment 1 is guaranteed to find.
+    [[nodiscard]] std::uint64_t LargestFreeRange() const {
+        if (fl_bitmap_ == 0) {
+            return 0;
+        }
+        const std::uint32_t fl = HighestBit(fl_bitmap_);
+        const std::uint32_t sl = HighestBit(sl_bitmap_[fl]);
+        std::uint64_t largest = 0;
+        for (std::uint32_t node = heads_[fl][sl]; node != kInvalidNode; node = nodes_[node].next_free) {
+            largest = nodes_[node].size > largest ? nodes_[node].size : largest;
+        }
+        return largest;
+    }
+
+    // 0 when all free memory is one range, approaching 1 as it splinters into small pieces.
+    [[nodiscard]] double Fragmentation() const {
+        const std::uint64_t free_bytes = FreeBytes();
+        return free_bytes == 0 ? 0.0 : 1.0 - static_cast<double>(LargestFreeRange()) / static_cast<double>(free_bytes);
+    }
+
+private:
+    static constexpr std::uint32_t kSlLog2 = 4;
+    static constexpr std::uint32_t kSlCount = 1u << kSlLog2;
+    static constexpr std::uint32_t kFlCount = 64 - kSlLog2 + 1;
+
+    struct Node {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+        std::uint32_t prev_phys = kInvalidNode;
+        std::uint32_t next_phys = kInvalidNode;
+        std::uint32_t prev_free = kInvalidNode;
+        std::uint32_t next_free = kInvalidNode;
+        bool free = false;
+    };
+
+    // value must be non-zero.
+    static std::uint32_t HighestBit(std::uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return static_cast<std::uint32_t>(index);
+#else
+        return 63u - static_cast<std::uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+    // value must be non-zero.
+    static std::uint32_t LowestBit(std::uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward64(&index, value);
+        return static_cast<std::uint32_t>(index);
+#else
+        return static_cast<std::uint32_t>(__builtin_ctzll(value));
+#endif
+    }
+
+    void ResetHeads() {
+        for (auto &row : heads_) {
+            for (std::uint32_t &head : row) {
+                head = kInvalidNode;
+            }
+        }
+    }
+
+    // Sizes below kSlCount share first level 0 with one exact class each; above that every power of two is
+    // split into kSlCount linear classes.
+    static void MapInsert(std::uint64_t size, std::uint32_t &fl, std::uint32_t &sl) {
+        if (size < kSlCount) {
+            fl = 0;
+            sl = static_cast<std::uint32_t>(size);
+            return;
+        }
+        const std::uint32_t msb = HighestBit(size);
+        fl = msb - kSlLog2 + 1;
+        sl = static_cast<std::uint32_t>(size >> (msb - kSlLog2)) ^ kSlCount;
+    }
+
+    // Rounds up to the next class boundary so every range in the resulting class is large enough.
+    static void MapSearch(std::uint64_t size, std::uint32_t &fl, std::uint32_t &sl) {
+        if (size >= kSlCount) {
+            const std::uint64_t round = (std::uint64_t{1} << (HighestBit(size) - kSlLog2)) - 1;
+            size = size + round < size ? size : size + round;
+        }
+        MapInsert(size, fl, sl);
+    }
+
+    std::uint32_t FindFree(std::uint32_t fl, std::uint32_t sl) const {
+        if (fl >= kFlCount) {
+            return kInvalidNode;
+        }
+        std::uint32_t sl_map = sl_bitmap_[fl] & (~0u << sl);
+        if (sl_map == 0) {
+            const std::uint64_t fl_map = fl + 1 < 64 ? fl_bitmap_ & (~std::uint64_t{0} << (fl + 1)) : 0;
+            if (fl_map == 0) {
+                return kInvalidNode;
+            }
+            fl = LowestBit(fl_map);
+            sl_map = sl_bitmap_[fl];
+        }
+        sl = LowestBit(sl_map);
+        return heads_[fl][sl];
+    }
+
+    void InsertFree(std::uint32_t node) {
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+        MapInsert(nodes_[node].size, fl, sl);
+        nodes_[node].free = true;
+        nodes_[node].prev_free = kInvalidNode;
+        nodes_[node].next_free = heads_[fl][sl];
+        if (heads_[fl][sl] != kInvalidNode) {
+            nodes_[heads_[fl][sl]].prev_free = node;
+        }
+        heads_[fl][sl] = node;
+        fl_bitmap_ |= std::uint64_t{1} << fl;
+        sl_bitmap_[fl] |= 1u << sl;
+    }
+
+    void RemoveFree(std::uint32_t node) {
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+        MapInsert(nodes_[node].size, fl, sl);
+        Node &entry = nodes_[node];
+        if (entry.prev_free != kInvalidNode) {
+            nodes_[entry.prev_free].next_free = entry.next_free;
+        } else {
+            heads_[fl][sl] = entry.next_free;
+        }
+        if (entry.next_free != kInvalidNode) {
+            nodes_[entry.next_free].prev_free = entry.prev_free;
+        }
+        entry.free = false;
+        entry.prev_free = kInvalidNode;
+        entry.next_free = kInvalidNode;
+        if (heads_[fl][sl] == kInvalidNode) {
+            sl_bitmap_[fl] &= ~(1u << sl);
+            if (sl_bitmap_[fl] == 0) {
+                fl_bitmap_ &= ~(std::uint64_t{1} << fl);
+            }
+        }
+    }
+
+    // Drops node, which was merged into its physical predecessor survivor.
+    void Unlink(std::uint32_t node, std::uint32_t survivor) {
+        const std::uint32_t next = nodes_[node].next_phys;
+        nodes_[survivor].next_phys = next;
+        if (next != kInvalidNode) {
+            nodes_[next].prev_phys = survivor;
+        }
+        nodes_[node] = Node{};
+        spare_nodes_.push_back(node);
+    }
+
+    std::uint32_t NewNode(std::uint64_t offset, std::uint64_t size, std::uint32_t prev_phys, std::uint32_t next_phys) {
+        std::uint32_t node = 0;
+        if (!spare_nodes_.empty()) {
+            node = spare_nodes_.back();
+            spare_nodes_.pop_back();
+        } else {
+            node = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[node].offset = offset;
+        nodes_[node].size = size;
+        nodes_[node].prev_phys = prev_phys;
+        nodes_[node].next_phys = next_phys;
+        return node;
+    }
+
+    std::uint64_t capacity_ = 0;
+    std::uint64_t used_ = 0;
+    std::uint32_t allocation_count_ = 0;
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> spare_nodes_;
+    std::uint64_t fl_bitmap_ = 0;
+    std::uint32_t sl_bitmap_[kFlCount] = {};
+    std::uint32_t heads_[kFlCount][kSlCount] = {};
+};
+
+}
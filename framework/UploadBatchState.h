@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include "RingAllocator.h"
+
+namespace gfw {
+
+// Fence value of the batch an upload was recorded into; the data is on the GPU once it has completed.
+using UploadTicket = std::uint64_t;
+
+// Staging and ticket bookkeeping of UploadBatcher without the device: where each upload goes in the staging
+// ring, which fence value the open batch will signal, and when earlier batches must drain first. Pure logic so
+// it can be driven by any fence, real or fake.
+class UploadBatchState {
+public:
+    enum class Placement {
+        Ring,      // offset is the upload's place in the staging ring
+        Oversized, // larger than the whole ring; needs its own buffer released with PendingTicket()
+        Full,      // submit, wait for the earlier batches, Retire, then reserve again
+    };
+
+    struct Batch {
+        UploadTicket ticket = 0;
+        std::uint32_t copies = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    // Totals over every submitted batch, and the last one.
+    struct Stats {
+        std::uint64_t batches = 0;
+        std::uint64_t copies = 0;
+        std::uint64_t bytes = 0;
+        Batch last;
+    };
+
+    UploadBatchState() = default;
+
+    explicit UploadBatchState(std::uint64_t staging_capacity) : ring_(staging_capacity) {}
+
+    Placement Reserve(std::uint64_t size, std::uint64_t alignment, std::uint64_t &offset) {
+        if (size > ring_.Capacity()) {
+            return Placement::Oversized;
+        }
+        return ring_.Allocate(size, alignment, offset) ? Placement::Ring : Placement::Full;
+    }
+
+    // Counts a copy of size bytes into the open batch and returns the ticket that covers it.
+    UploadTicket Record(std::uint64_t size) {
+        ++open_.copies;
+        open_.bytes += size;
+        return next_ticket_;
+    }
+
+    // Closes the open batch; its staging memory stays reserved until Retire sees its ticket completed.
+    Batch Submit() {
+        Batch batch = open_;
+        batch.ticket = next_ticket_++;
+        ring_.FinishFrame(batch.ticket);
+        open_ = {};
+        ++stats_.batches;
+        stats_.copies += batch.copies;
+        stats_.bytes += batch.bytes;
+        stats_.last = batch;
+        return batch;
+    }
+
+    void Retire(std::uint64_t completed_ticket) { ring_.Retire(completed_ticket); }
+
+    // Ticket the open batch will signal when submitted.
+    [[nodiscard]] UploadTicket PendingTicket() const { return next_ticket_; }
+    [[nodiscard]] UploadTicket LastSubmitted() const { return next_ticket_ - 1; }
+    [[nodiscard]] std::uint64_t StagingUsed() const { return ring_.Used(); }
+    [[nodiscard]] const Stats &GetStats() const { return stats_; }
+
+private:
+    RingAllocator ring_;
+    UploadTicket next_ticket_ = 1;
+    Batch open_;
+    Stats stats_;
+};
+
+}
@@ -0,0 +1,255 @@
+#include "UploadBatcher.h"
+#include "FrameworkInternal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace gfw {
+
+bool UploadBatcher::Initialize(ID3D12Device *device, ID3D12CommandQueue *queue, std::uint64_t staging_capacity) {
+    device_ = device;
+    queue_ = queue;
+
+    allocators_.emplace_back();
+    if (detail::CheckFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                            IID_PPV_ARGS(&allocators_[0].allocator)),
+                            L"Failed to create upload Command Allocator!")) {
+        return false;
+    }
+    if (detail::CheckFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocators_[0].allocator.Get(),
+                                                       nullptr, IID_PPV_ARGS(&command_list_)),
+                            L"Failed to create upload Command List!")) {
+        return false;
+    }
+    command_list_->Close();
+
+    if (detail::CheckFailed(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)),
+                            L"Failed to create upload Fence!")) {
+        return false;
+    }
+    fence_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!fence_event_) {
+        std::wcerr << L"Failed to create upload Fence Event!" << std::endl;
+        return false;
+    }
+
+    const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    const D3D12_RESOURCE_DESC desc = detail::BufferDesc(staging_capacity);
+    if (detail::CheckFailed(device_->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc,
+                                                             D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                                             IID_PPV_ARGS(&staging_)),
+                            L"Failed to create upload staging buffer!")) {
+        return false;
+    }
+    void *mapped = nullptr;
+    if (detail::CheckFailed(staging_->Map(0, nullptr, &mapped), L"Failed to map upload staging buffer!")) {
+        return false;
+    }
+    staging_mapped_ = static_cast<std::uint8_t *>(mapped);
+    state_ = UploadBatchState(staging_capacity);
+    return true;
+}
+
+void UploadBatcher::Shutdown() {
+    if (fence_ && fence_event_) {
+        Wait(Flush());
+    }
+    if (fence_event_) {
+        CloseHandle(fence_event_);
+        fence_event_ = nullptr;
+    }
+    if (staging_) {
+        staging_->Unmap(0, nullptr);
+    }
+    staging_mapped_ = nullptr;
+    staging_.Reset();
+    for (PendingRelease &pending : oversized_) {
+        pending.buffer->Unmap(0, nullptr);
+    }
+    oversized_.clear();
+    command_list_.Reset();
+    allocators_.clear();
+    fence_.Reset();
+    state_ = UploadBatchState();
+    recording_ = false;
+    device_ = nullptr;
+    queue_ = nullptr;
+}
+
+void UploadBatcher::Retire() {
+    const std::uint64_t completed = fence_->GetCompletedValue();
+    state_.Retire(completed);
+    oversized_.erase(std::remove_if(oversized_.begin(), oversized_.end(),
+                                    [&](PendingRelease &pending) {
+                                        if (pending.fence_value > completed) {
+                                            return false;
+                                        }
+                                        pending.buffer->Unmap(0, nullptr);
+                                        return true;
+                                    }),
+                     oversized_.end());
+}
+
+bool UploadBatcher::Reserve(std::uint64_t size, std::uint64_t alignment, Staging &out) {
+    Retire();
+    std::uint64_t offset = 0;
+    UploadBatchState::Placement placement = state_.Reserve(size, alignment, offset);
+    if (placement == UploadBatchState::Placement::Full) {
+        // The ring is full of this batch and earlier ones: submit and drain them, then start over.
+        Wait(Flush());
+        Retire();
+        placement = state_.Reserve(size, alignment, offset);
+    }
+    if (placement == UploadBatchState::Placement::Oversized) {
+        const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+        const D3D12_RESOURCE_DESC desc = detail::BufferDesc(size);
+        PendingRelease pending;
+        if (detail::CheckFailed(device_->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc,
+                                                                 D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                                                 IID_PPV_ARGS(&pending.buffer)),
+                                L"Failed to create oversized upload buffer!")) {
+            return false;
+        }
+        void *mapped = nullptr;
+        if (detail::CheckFailed(pending.buffer->Map(0, nullptr, &mapped), L"Failed to map oversized upload buffer!")) {
+            return false;
+        }
+        pending.fence_value = state_.PendingTicket();
+        out = {static_cast<std::uint8_t *>(mapped), pending.buffer.Get(), 0};
+        oversized_.push_back(std::move(pending));
+        return true;
+    }
+    if (placement != UploadBatchState::Placement::Ring) {
+        std::wcerr << L"Failed to reserve upload staging memory!" << std::endl;
+        return false;
+    }
+    out = {staging_mapped_ + offset, staging_.Get(), offset};
+    return true;
+}
+
+bool UploadBatcher::BeginBatch() {
+    if (recording_) {
+        return true;
+    }
+    const std::uint64_t completed = fence_->GetCompletedValue();
+    const auto reusable = std::find_if(allocators_.begin(), allocators_.end(), [&](const CommandAllocator &entry) {
+        return entry.fence_value <= completed;
+    });
+    if (reusable != allocators_.end()) {
+        current_allocator_ = static_cast<std::size_t>(std::distance(allocators_.begin(), reusable));
+    } else {
+        CommandAllocator entry;
+        if (detail::CheckFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                                IID_PPV_ARGS(&entry.allocator)),
+                                L"Failed to create upload Command Allocator!")) {
+            return false;
+        }
+        current_allocator_ = allocators_.size();
+        allocators_.push_back(std::move(entry));
+    }
+
+    ID3D12CommandAllocator *allocator = allocators_[current_allocator_].allocator.Get();
+    if (FAILED(allocator->Reset()) || FAILED(command_list_->Reset(allocator, nullptr))) {
+        std::wcerr << L"Failed to reset upload Command List!" << std::endl;
+        return false;
+    }
+    recording_ = true;
+    return true;
+}
+
+UploadTicket UploadBatcher::EnqueueBuffer(ID3D12Resource *dst, const void *data, std::uint64_t size,
+                                          D3D12_RESOURCE_STATES final_state) {
+    Staging staging;
+    if (!dst || size == 0 || !Reserve(size, 16, staging) || !BeginBatch()) {
+        return 0;
+    }
+    std::memcpy(staging.cpu, data, static_cast<size_t>(size));
+    command_list_->CopyBufferRegion(dst, 0, staging.buffer, staging.offset, size);
+    if (final_state != D3D12_RESOURCE_STATE_COPY_DEST) {
+        const auto barrier = detail::TransitionBarrier(dst, D3D12_RESOURCE_STATE_COPY_DEST, final_state);
+        command_list_->ResourceBarrier(1, &barrier);
+    }
+    return state_.Record(size);
+}
+
+UploadTicket UploadBatcher::EnqueueTexture(ID3D12Resource *dst, const void *rgba8, UINT width, UINT height,
+                                           D3D12_RESOURCE_STATES final_state) {
+    if (!dst || width == 0 || height == 0) {
+        return 0;
+    }
+    const D3D12_RESOURCE_DESC desc = dst->GetDesc();
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    UINT num_rows = 0;
+    UINT64 row_size_in_bytes = 0;
+    UINT64 upload_size = 0;
+    device_->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, &num_rows, &row_size_in_bytes, &upload_size);
+
+    Staging staging;
+    if (!Reserve(upload_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, staging) || !BeginBatch()) {
+        return 0;
+    }
+    const UINT src_row_pitch = width * 4;
+    const auto *src_bytes = static_cast<const std::uint8_t *>(rgba8);
+    for (UINT y = 0; y < height; ++y) {
+        std::memcpy(staging.cpu + static_cast<size_t>(y) * footprint.Footprint.RowPitch,
+                    src_bytes + static_cast<size_t>(y) * src_row_pitch, src_row_pitch);
+    }
+    footprint.Offset = staging.offset;
+
+    D3D12_TEXTURE_COPY_LOCATION dst_location = {};
+    dst_location.pResource = dst;
+    dst_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dst_location.SubresourceIndex = 0;
+
+    D3D12_TEXTURE_COPY_LOCATION src_location = {};
+    src_location.pResource = staging.buffer;
+    src_location.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    src_location.PlacedFootprint = footprint;
+
+    command_list_->CopyTextureRegion(&dst_location, 0, 0, 0, &src_location, nullptr);
+    if (final_state != D3D12_RESOURCE_STATE_COPY_DEST) {
+        const auto barrier = detail::TransitionBarrier(dst, D3D12_RESOURCE_STATE_COPY_DEST, final_state);
+        command_list_->ResourceBarrier(1, &barrier);
+    }
+    return state_.Record(upload_size);
+}
+
+UploadTicket UploadBatcher::Flush() {
+    if (!recording_) {
+        return state_.LastSubmitted();
+    }
+    recording_ = false;
+    if (FAILED(command_list_->Close())) {
+        std::wcerr << L"Failed to close upload Command List!" << std::endl;
+        return 0;
+    }
+    ID3D12CommandList *lists[] = {command_list_.Get()};
+    queue_->ExecuteCommandLists(static_cast<UINT>(std::size(lists)), lists);
+
+    const UploadBatchState::Batch batch = state_.Submit();
+    if (FAILED(queue_->Signal(fence_.Get(), batch.ticket))) {
+        std::wcerr << L"Failed to signal upload Fence!" << std::endl;
+    }
+    allocators_[current_allocator_].fence_value = batch.ticket;
+    return batch.ticket;
+}
+
+bool UploadBatcher::IsComplete(UploadTicket ticket) const {
+    return fence_->GetCompletedValue() >= ticket;
+}
+
+void UploadBatcher::Wait(UploadTicket ticket) {
+    if (recording_ && ticket >= state_.PendingTicket()) {
+        Flush();
+    }
+    if (fence_->GetCompletedValue() >= ticket) {
+        return;
+    }
+    if (FAILED(fence_->SetEventOnCompletion(ticket, fence_event_))) {
+        return;
+    }
+    WaitForSingleObject(fence_event_, INFINITE);
+}
+
+}
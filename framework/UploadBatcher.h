@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+#include "UploadBatchState.h"
+
+namespace gfw {
+
+// Collects buffer and texture uploads into a persistently mapped staging ring and records all of their
+// copies into one command list. Flush submits the batch with a single fence signal, so loading N assets
+// costs one GPU round-trip instead of N. Batches execute on the frame's queue, so anything flushed before
+// a frame's command list is submitted is visible to that frame without a CPU wait.
+class UploadBatcher {
+public:
+    UploadBatcher() = default;
+    ~UploadBatcher() { Shutdown(); }
+
+    UploadBatcher(const UploadBatcher &) = delete;
+    UploadBatcher &operator=(const UploadBatcher &) = delete;
+
+    bool Initialize(ID3D12Device *device, ID3D12CommandQueue *queue, std::uint64_t staging_capacity);
+
+    // Waits for every submitted batch before releasing the staging memory.
+    void Shutdown();
+
+    // dst must be in COPY_DEST or COMMON; it is transitioned to final_state after the copy. Returns 0 on failure.
+    UploadTicket EnqueueBuffer(ID3D12Resource *dst, const void *data, std::uint64_t size,
+                               D3D12_RESOURCE_STATES final_state);
+
+    // Uploads mip 0 of an RGBA8 texture created in COPY_DEST. Returns 0 on failure.
+    UploadTicket EnqueueTexture(ID3D12Resource *dst, const void *rgba8, UINT width, UINT height,
+                                D3D12_RESOURCE_STATES final_state);
+
+    // Submits the pending batch, if any, and returns the ticket covering everything enqueued so far.
+    UploadTicket Flush();
+
+    [[nodiscard]] bool IsComplete(UploadTicket ticket) const;
+
+    // Flushes if the ticket's batch is still pending, then blocks until it completes.
+    void Wait(UploadTicket ticket);
+
+    [[nodiscard]] bool IsValid() const { return fence_ != nullptr; }
+
+    // Batches, copies and bytes submitted so far; Flush does not log them.
+    [[nodiscard]] const UploadBatchState::Stats &GetStats() const { return state_.GetStats(); }
+
+private:
+    struct Staging {
+        std::uint8_t *cpu = nullptr;
+        ID3D12Resource *buffer = nullptr;
+        std::uint64_t offset = 0;
+    };
+
+    struct PendingRelease {
+        Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+        std::uint64_t fence_value = 0;
+    };
+
+    struct CommandAllocator {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+        std::uint64_t fence_value = 0;
+    };
+
+    bool Reserve(std::uint64_t size, std::uint64_t alignment, Staging &out);
+    bool BeginBatch();
+    void Retire();
+
+    ID3D12Device *device_ = nullptr;
+    ID3D12CommandQueue *queue_ = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> command_list_;
+    std::vector<CommandAllocator> allocators_;
+    std::size_t current_allocator_ = 0;
+    Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+    HANDLE fence_event_ = nullptr;
+    bool recording_ = false;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> staging_;
+    std::uint8_t *staging_mapped_ = nullptr;
+    // Staging ring offsets and the fence value the pending batch will signal.
+    UploadBatchState state_;
+    // Uploads larger than the ring get their own buffer, released when their batch completes.
+    std::vector<PendingRelease> oversized_;
+};
+
+}
@@ -0,0 +1,91 @@
+#include "UploadRing.h"
+#include "FrameworkInternal.h"
+
+#include <algorithm>
+
+namespace gfw {
+
+bool UploadRing::Initialize(ID3D12Device *device, std::uint64_t capacity) {
+    device_ = device;
+    return CreateBuffer(capacity);
+}
+
+void UploadRing::Shutdown() {
+    if (buffer_) {
+        buffer_->Unmap(0, nullptr);
+    }
+    mapped_ = nullptr;
+    buffer_.Reset();
+    for (RetiredBuffer &retired : retired_) {
+        retired.buffer->Unmap(0, nullptr);
+    }
+    retired_.clear();
+    ring_ = RingAllocator();
+    device_ = nullptr;
+}
+
+bool UploadRing::CreateBuffer(std::uint64_t capacity) {
+    const D3D12_HEAP_PROPERTIES heap_props = detail::HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    const D3D12_RESOURCE_DESC desc = detail::BufferDesc(capacity);
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+    if (detail::CheckFailed(device_->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc,
+                                                             D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                                             IID_PPV_ARGS(&buffer)),
+                            L"Failed to create upload ring buffer!")) {
+        return false;
+    }
+    void *mapped = nullptr;
+    if (detail::CheckFailed(buffer->Map(0, nullptr, &mapped), L"Failed to map upload ring buffer!")) {
+        return false;
+    }
+
+    // The upload heap stays mapped for its whole lifetime; the old buffer may still be read by the GPU.
+    if (buffer_) {
+        retired_.push_back({buffer_, 0});
+    }
+    buffer_ = buffer;
+    mapped_ = static_cast<std::uint8_t *>(mapped);
+    ring_ = RingAllocator(capacity);
+    return true;
+}
+
+bool UploadRing::Allocate(std::uint64_t size, std::uint64_t alignment, Allocation &out) {
+    if (!buffer_) {
+        return false;
+    }
+    std::uint64_t offset = 0;
+    if (!ring_.Allocate(size, alignment, offset)) {
+        const std::uint64_t capacity = std::max(ring_.Capacity() * 2, (size + alignment - 1) & ~(alignment - 1));
+        std::wcout << L"Upload ring full, growing to " << capacity / 1024 << L" KB" << std::endl;
+        if (!CreateBuffer(capacity) || !ring_.Allocate(size, alignment, offset)) {
+            return false;
+        }
+    }
+    out.cpu = mapped_ + offset;
+    out.gpu = buffer_->GetGPUVirtualAddress() + offset;
+    return true;
+}
+
+void UploadRing::FinishFrame(std::uint64_t fence_value) {
+    ring_.FinishFrame(fence_value);
+    for (RetiredBuffer &retired : retired_) {
+        if (retired.fence_value == 0) {
+            retired.fence_value = fence_value;
+        }
+    }
+}
+
+void UploadRing::Retire(std::uint64_t completed_fence_value) {
+    ring_.Retire(completed_fence_value);
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [&](RetiredBuffer &retired) {
+                                      if (retired.fence_value == 0 || retired.fence_value > completed_fence_value) {
+                                          return false;
+                                      }
+                                      retired.buffer->Unmap(0, nullptr);
+                                      return true;
+                                  }),
+                   retired_.end());
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include "RingAllocator.h"
+
+namespace gfw {
+
+// Persistently mapped upload-heap ring for per-draw constants. Every Allocate returns fresh memory that
+// stays valid until the GPU has passed the fence of the frame it was allocated in; when the ring is full
+// it is replaced by one twice as large and the old buffer is released once its last frame retires.
+class UploadRing {
+public:
+    struct Allocation {
+        std::uint8_t *cpu = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpu = 0;
+    };
+
+    UploadRing() = default;
+    ~UploadRing() { Shutdown(); }
+
+    UploadRing(const UploadRing &) = delete;
+    UploadRing &operator=(const UploadRing &) = delete;
+
+    bool Initialize(ID3D12Device *device, std::uint64_t capacity);
+
+    void Shutdown();
+
+    // alignment must be a power of two; constant buffer views need 256.
+    bool Allocate(std::uint64_t size, std::uint64_t alignment, Allocation &out);
+
+    // Call after the frame's command lists were submitted, with the value the next queue Signal will use.
+    void FinishFrame(std::uint64_t fence_value);
+
+    // Call with the fence's completed value before recording a new frame.
+    void Retire(std::uint64_t completed_fence_value);
+
+    [[nodiscard]] bool IsValid() const { return buffer_ != nullptr; }
+    [[nodiscard]] std::uint64_t Capacity() const { return ring_.Capacity(); }
+
+private:
+    struct RetiredBuffer {
+        Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+        std::uint64_t fence_value = 0; // 0 until the frame that replaced it is finished
+    };
+
+    bool CreateBuffer(std::uint64_t capacity);
+
+    ID3D12Device *device_ = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffer_;
+    std::uint8_t *mapped_ = nullptr;
+    RingAllocator ring_;
+    std::vector<RetiredBuffer> retired_;
+};
+
+}
@@ -1,4 +1,7 @@
 #include <windows.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 
 #include "AppRunner.h"
@@ -7,7 +10,20 @@
 
 using namespace gfw;
 
-int main() {
+namespace {
+constexpr std::uint32_t kHeadlessDefaultFrames = 600;
+}
+
+int main(int argc, char **argv) {
+    // --headless [frames] [capture.gfwcap]: no window or GPU submission, reports CPU ms/frame and optionally
+    // captures the last frame for CaptureReplay (see RunHeadless).
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+        const std::uint32_t frames =
+            argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : kHeadlessDefaultFrames;
+        const std::wstring capture_file = argc > 3 ? std::filesystem::path(argv[3]).wstring() : std::wstring();
+        return RunHeadless(frames, 1280, 720, capture_file) ? 0 : -1;
+    }
+
     Window window;
     Window::WindowDesc desc;
     desc.title = L"DirectX 12 Window";
@@ -7,10 +7,15 @@ cbuffer GeometryCB : register(b0)
     row_major float4x4 proj;
     float4 albedo;
     float4 tessParams;
+    float4 cameraPos;
+    float4 quantOffset;
+    float4 quantScale;
+    uint4 textureIndices; // bindless indices: x base color, y normal map, z displacement
 };
 
-Texture2D baseColorTex : register(t0);
-Texture2D normalMapTex : register(t1);
+// Every texture SRV of the framework heap; indexed with textureIndices (shader model 5.1).
+Texture2D materialTextures[] : register(t0, space1);
+
 SamplerState baseColorSampler : register(s0);
 
 struct PSInput
@@ -21,6 +26,9 @@ struct PSInput
     float2 uv : TEXCOORD2;
     float3 posW : TEXCOORD3;       // World-space position (unused but passed through)
     float3 normalW : TEXCOORD4;    // World-space normal (unused but passed through)
+#ifdef VERTEX_TANGENTS
+    float4 tangentW : TEXCOORD5;   // World-space tangent, w bitangent sign
+#endif
 };
 
 struct PSOutput
@@ -30,25 +38,30 @@ struct PSOutput
     float4 albedoOut : SV_TARGET2; // Store base color (independent of lighting)
 };
 
+// Permutation defines (see GeometryPermutations.h): NORMAL_MAP perturbs the normal with textureIndices.y,
+// VERTEX_TANGENTS uses the interpolated vertex frame for it, ALPHA_TEST discards texels below 0.5 alpha.
 PSOutput PSMain(PSInput input)
 {
     PSOutput o;
-    float4 tex = baseColorTex.Sample(baseColorSampler, input.uv);
-
-    float4 normalMapSample = normalMapTex.Sample(baseColorSampler, input.uv);
-    bool hasNormalMap = !(abs(normalMapSample.r - 1.0f) < 0.01f && abs(normalMapSample.g - 1.0f) < 0.01f && abs(normalMapSample.b - 1.0f) < 0.01f);
+    float4 tex = materialTextures[textureIndices.x].Sample(baseColorSampler, input.uv);
+#ifdef ALPHA_TEST
+    clip(tex.a - 0.5f);
+#endif
 
     float3 Nw = normalize(input.normalW);
-    float3 bumpW;
-    if (hasNormalMap)
-    {
-        float3 nTS = DecodeNormalMapSample(normalMapSample);
-        bumpW = NormalFromTsToWorld(Nw, input.posW, input.uv, nTS);
-    }
-    else
-    {
-        bumpW = Nw;
-    }
+#ifdef NORMAL_MAP
+    float3 nTS = DecodeNormalMapSample(materialTextures[textureIndices.y].Sample(baseColorSampler, input.uv));
+#ifdef VERTEX_TANGENTS
+    // Interpolated vertex frame, re-orthogonalized against the interpolated normal.
+    float3 Tw = normalize(input.tangentW.xyz - dot(input.tangentW.xyz, Nw) * Nw);
+    float3 Bw = cross(Nw, Tw) * input.tangentW.w;
+    float3 bumpW = NormalFromTsWithTBN(nTS, Nw, Tw, Bw);
+#else
+    float3 bumpW = NormalFromTsToWorld(Nw, input.posW, input.uv, nTS);
+#endif
+#else
+    float3 bumpW = Nw;
+#endif
 
     float3 normalV = normalize(mul(float4(bumpW, 0.0f), view).xyz);
 
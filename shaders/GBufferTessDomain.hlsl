@@ -7,10 +7,15 @@ cbuffer GeometryCB : register(b0)
     row_major float4x4 proj;
     float4 albedo;
     float4 tessParams;
+    float4 cameraPos;
+    float4 quantOffset;
+    float4 quantScale;
+    uint4 textureIndices; // bindless indices: x base color, y normal map, z displacement
 };
 
-Texture2D normalMapTex : register(t1);
-Texture2D displacementTex : register(t2);
+// Every texture SRV of the framework heap; indexed with textureIndices (shader model 5.1).
+Texture2D materialTextures[] : register(t0, space1);
+
 SamplerState baseColorSampler : register(s0);
 
 struct VSOutput
@@ -42,49 +47,35 @@ VSOutput DSMain(HSConstantData patch_data, const OutputPatch<VSOutput, 3> patch,
 
     float3 normalW = normalize(interpolated_normalW);
 
-    float3 p0 = patch[0].posW;
-    float3 p1 = patch[1].posW;
-    float3 p2 = patch[2].posW;
-    float2 uv0 = patch[0].uv;
-    float2 uv1 = patch[1].uv;
-    float2 uv2 = patch[2].uv;
+    // Permutation defines (see GeometryPermutations.h): NORMAL_MAP and DISPLACEMENT add their height terms.
+    float h = 0.0f;
+#ifdef NORMAL_MAP
     float3 T, B;
-    BuildTriangleTBN(p0, p1, p2, uv0, uv1, uv2, normalW, T, B);
-
-    float4 nmSample = normalMapTex.SampleLevel(baseColorSampler, interpolated_uv, 0);
-    bool hasNM = !(abs(nmSample.r - 1.0f) < 0.01f && abs(nmSample.g - 1.0f) < 0.01f && abs(nmSample.b - 1.0f) < 0.01f);
-    float3 nTS = float3(0.0f, 0.0f, 1.0f);
-    float3 bumpW = normalW;
-    if (hasNM)
-    {
-        nTS = DecodeNormalMapSample(nmSample);
-        bumpW = NormalFromTsWithTBN(nTS, normalW, T, B);
-    }
-    float tiltNM = hasNM ? saturate(1.0f - nTS.z) : 0.0f;
-    float lateralNM = hasNM ? length(nTS.xy) : 0.0f;
-
-    // Height from optional displacement map (neutral ~0.5)
-    float4 displacementSample = displacementTex.SampleLevel(baseColorSampler, interpolated_uv, 0);
-    bool hasDisplacement = !(abs(displacementSample.r - 1.0f) < 0.01f && abs(displacementSample.g - 1.0f) < 0.01f && abs(displacementSample.b - 1.0f) < 0.01f);
-    float hDisp = 0.0f;
-    if (hasDisplacement) {
-        hDisp = (displacementSample.r - 0.5f) * tessParams.z;
-    }
+    BuildTriangleTBN(patch[0].posW, patch[1].posW, patch[2].posW, patch[0].uv, patch[1].uv, patch[2].uv, normalW, T, B);
+    float3 nTS = DecodeNormalMapSample(materialTextures[textureIndices.y].SampleLevel(baseColorSampler, interpolated_uv, 0));
+    float3 bumpW = NormalFromTsWithTBN(nTS, normalW, T, B);
+    float tiltNM = saturate(1.0f - nTS.z);
+    float lateralNM = length(nTS.xy);
 
     // Height from normal map — gentle curve avoids needle-like extrusions on tight edge gradients
-    float hNm = 0.0f;
-    if (hasNM && tessParams.w > 0.0f) {
+    if (tessParams.w > 0.0f) {
         float edgeAmt = saturate(tiltNM * 0.45f + lateralNM * 0.28f);
-        hNm = tessParams.w * edgeAmt * edgeAmt;
+        h += tessParams.w * edgeAmt * edgeAmt;
     }
+#endif
 
-    float h = hDisp + hNm;
+#ifdef DISPLACEMENT
+    // Height from the displacement map (neutral ~0.5)
+    h += (materialTextures[textureIndices.z].SampleLevel(baseColorSampler, interpolated_uv, 0).r - 0.5f) * tessParams.z;
+#endif
 
     float3 dirW = normalW;
-    if (hasNM && abs(h) > 1e-6f) {
+#ifdef NORMAL_MAP
+    if (abs(h) > 1e-6f) {
         float edgeBlend = saturate(pow(max(lateralNM, tiltNM), 1.15f)) * 0.45f;
         dirW = normalize(lerp(normalW, bumpW, edgeBlend));
     }
+#endif
 
     interpolated_posW += dirW * h;
 
@@ -5,14 +5,42 @@ cbuffer GeometryCB : register(b0)
     row_major float4x4 proj;
     float4 albedo;
     float4 tessParams;
+    float4 cameraPos;
+    float4 quantOffset;   // xyz: AABB min of a QUANTIZED_VERTEX mesh
+    float4 quantScale;    // xyz: AABB extent of a QUANTIZED_VERTEX mesh
 };
 
+#ifdef QUANTIZED_VERTEX
+// 16-byte layout written by VertexQuantizer: UNORM16 position in the AABB, octahedral SNORM16 normal, half UV.
+// With VERTEX_TANGENTS an octahedral SNORM16 tangent follows and pos.w holds its handedness (0 or 1).
+struct VSInput
+{
+    float4 pos : POSITION;
+    float2 normal : NORMAL;
+    float2 uv : TEXCOORD0;
+#ifdef VERTEX_TANGENTS
+    float2 tangent : TANGENT;
+#endif
+};
+
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += (n.xy >= 0.0f) ? -t : t;
+    return normalize(n);
+}
+#else
 struct VSInput
 {
     float3 pos : POSITION;
     float3 normal : NORMAL;
     float2 uv : TEXCOORD0;
+#ifdef VERTEX_TANGENTS
+    float4 tangent : TANGENT;     // xyz tangent, w bitangent sign
+#endif
 };
+#endif
 
 struct VSOutput
 {
@@ -22,19 +50,38 @@ struct VSOutput
     float2 uv : TEXCOORD2;
     float3 posW : TEXCOORD3;      // World-space position for tessellation
     float3 normalW : TEXCOORD4;    // World-space normal for tessellation
+#ifdef VERTEX_TANGENTS
+    float4 tangentW : TEXCOORD5;   // World-space tangent, w bitangent sign
+#endif
 };
 
 VSOutput VSMain(VSInput input)
 {
     VSOutput o;
-    float4 posW = mul(float4(input.pos, 1.0f), world);
+#ifdef QUANTIZED_VERTEX
+    float3 pos = quantOffset.xyz + input.pos.xyz * quantScale.xyz;
+    float3 normal = OctDecode(input.normal);
+#ifdef VERTEX_TANGENTS
+    float4 tangent = float4(OctDecode(input.tangent), input.pos.w >= 0.5f ? 1.0f : -1.0f);
+#endif
+#else
+    float3 pos = input.pos;
+    float3 normal = input.normal;
+#ifdef VERTEX_TANGENTS
+    float4 tangent = input.tangent;
+#endif
+#endif
+    float4 posW = mul(float4(pos, 1.0f), world);
     float4 posV = mul(posW, view);
     o.posH = mul(posV, proj);
     o.posV = posV.xyz;
     o.posW = posW.xyz;  // Store world-space position
-    float3 normalW = mul(float4(input.normal, 0.0f), world).xyz;
+    float3 normalW = mul(float4(normal, 0.0f), world).xyz;
     o.normalV = mul(float4(normalW, 0.0f), view).xyz;
     o.normalW = normalize(normalW);  // Store normalized world-space normal
     o.uv = input.uv;
+#ifdef VERTEX_TANGENTS
+    o.tangentW = float4(normalize(mul(float4(tangent.xyz, 0.0f), world).xyz), tangent.w);
+#endif
     return o;
 }
@@ -0,0 +1,19 @@
+# Every shader entry point and permutation the renderer loads, compiled ahead of time by cmake/EmbedShaders.cmake.
+# Adding a LoadShader call needs a matching entry here; debug builds fall back to runtime compilation until then.
+
+# Framework Phong pipeline
+gfw_add_shader(VertexShader.hlsl ENTRY VSMain PROFILE vs_6_0)
+gfw_add_shader(PixelShader.hlsl ENTRY PSMain PROFILE ps_6_0)
+gfw_add_shader(PixelShader.hlsl ENTRY PSRainbow PROFILE ps_6_0)
+
+# GBuffer pass permutations; feature order matches GeometryStageDefines in GeometryPermutations.h
+gfw_add_shader_permutations(GBufferVertex.hlsl ENTRY VSMain PROFILE vs_6_0 FEATURES QUANTIZED_VERTEX VERTEX_TANGENTS)
+gfw_add_shader(GBufferTessHull.hlsl ENTRY HSMain PROFILE hs_6_0)
+gfw_add_shader_permutations(GBufferTessDomain.hlsl ENTRY DSMain PROFILE ds_6_0 FEATURES NORMAL_MAP DISPLACEMENT)
+gfw_add_shader_permutations(GBufferPixel.hlsl ENTRY PSMain PROFILE ps_6_0 FEATURES VERTEX_TANGENTS NORMAL_MAP ALPHA_TEST)
+
+# Lighting and debug visualization
+gfw_add_shader(DeferredLighting.hlsl ENTRY VSMain PROFILE vs_6_0)
+gfw_add_shader(DeferredLighting.hlsl ENTRY PSMain PROFILE ps_6_0)
+gfw_add_shader(GBufferDebug.hlsl ENTRY VSMain PROFILE vs_6_0)
+gfw_add_shader(GBufferDebug.hlsl ENTRY PSMain PROFILE ps_6_0)
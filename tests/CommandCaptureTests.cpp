@@ -0,0 +1,245 @@
+#include "TestHarness.h"
+#include "framework/CommandCapture.h"
+#include "framework/NullRenderBackend.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    constexpr std::size_t kConstantCount = 3;
+    constexpr std::uint32_t kConstantSizes[kConstantCount] = {64, 256, 20};
+    constexpr std::size_t kHandleCountsOffset = 40; // FileHeader::handle_counts in CommandCapture.cpp
+    constexpr std::size_t kHeaderSize = 72;
+
+    // Where the upload ring placed constant buffer i of a frame whose uploads start at uploads.
+    GpuAddress UploadAddress(GpuAddress uploads, std::size_t i) {
+        return uploads + i * 256;
+    }
+
+    // A small GBuffer-like frame as Framework::CaptureNextFrame sees it: every handle is offset by base and the
+    // constants live at uploads, so two calls with different arguments differ only in where things happened to
+    // be allocated. Barriers go out in batches of at most 16, as the capture replays them.
+    void RecordFrame(CommandCapture &capture, RecordingCommandList &list, std::uint64_t base, GpuAddress uploads) {
+        list.Stream().Clear();
+        capture.Begin();
+        std::uint8_t constants[256];
+        for (std::size_t i = 0; i < kConstantCount; ++i) {
+            for (std::uint32_t b = 0; b < kConstantSizes[i]; ++b) {
+                constants[b] = static_cast<std::uint8_t>(i * 31 + b);
+            }
+            capture.RecordConstants(UploadAddress(uploads, i), constants, kConstantSizes[i]);
+        }
+
+        ResourceBarrier barriers[20];
+        for (std::uint64_t i = 0; i < std::size(barriers); ++i) {
+            barriers[i] = {ResourceHandle{base + 100 + i}, ResourceState::PixelShaderResource,
+                           ResourceState::RenderTarget};
+        }
+        list.Barriers(barriers, 16);
+        list.Barriers(barriers + 16, 4);
+        const CpuDescriptor rtvs[3] = {{base + 11}, {base + 12}, {base + 13}};
+        const float clear[4] = {0.0f, 0.25f, 0.5f, 1.0f};
+        for (const CpuDescriptor rtv: rtvs) {
+            list.ClearRenderTarget(rtv, clear);
+        }
+        list.ClearDepth(CpuDescriptor{base + 14}, 1.0f);
+        list.SetRenderTargets(rtvs, 3, CpuDescriptor{base + 14});
+        list.SetViewport({0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f});
+        list.SetScissor({0, 0, 1280, 720});
+        list.SetRootSignature(RootSignatureHandle{base + 21});
+        list.SetDescriptorHeap(DescriptorHeapHandle{base + 22});
+        list.SetConstantBuffer(1, UploadAddress(uploads, 0));
+        // A constant buffer that was not uploaded during the frame, e.g. a static one.
+        list.SetConstantBuffer(2, base + 0x90000);
+        list.SetTopology(PrimitiveTopology::TriangleList);
+        for (std::uint64_t draw = 0; draw < 6; ++draw) {
+            list.SetPipeline(PipelineHandle{base + 31 + draw / 3});
+            list.SetConstantBuffer(0, UploadAddress(uploads, 1 + draw % 2));
+            list.SetDescriptorTable(3, GpuDescriptor{base + 40 + draw});
+            list.SetVertexBuffer({base + 0x10000 + draw * 0x1000, 4096, 32});
+            list.SetIndexBuffer({base + 0x20000 + draw * 0x1000, 2048, IndexFormat::Uint16});
+            list.DrawIndexed(36 + static_cast<std::uint32_t>(draw) * 3, 0, 0);
+        }
+        list.Draw(3, 0);
+        list.Barrier(ResourceHandle{base + 100}, ResourceState::RenderTarget, ResourceState::PixelShaderResource);
+        capture.Finish(list.Stream());
+    }
+
+    std::vector<char> ReadFile(const std::filesystem::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    bool WriteFile(const std::filesystem::path &path, const std::vector<char> &bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        return out.write(bytes.data(), static_cast<std::streamsize>(bytes.size())).good();
+    }
+
+    bool SameStream(const CommandStream &a, const CommandStream &b) {
+        return a.SizeBytes() == b.SizeBytes() && a.CommandCount() == b.CommandCount() &&
+               std::memcmp(a.Data(), b.Data(), a.SizeBytes()) == 0;
+    }
+
+    // Op sequence and draw arguments; handles differ between a live and a loaded capture.
+    std::vector<std::uint32_t> DrawShape(const CommandStream &stream) {
+        std::vector<std::uint32_t> shape;
+        stream.ForEach([&](CommandOp op, const std::uint8_t *payload, std::size_t) {
+            shape.push_back(static_cast<std::uint32_t>(op));
+            if (op == CommandOp::Draw || op == CommandOp::DrawIndexed) {
+                CommandStream::DrawPacket packet;
+                std::memcpy(&packet, payload, sizeof(packet));
+                shape.push_back(packet.count);
+            }
+        });
+        return shape;
+    }
+
+    // A live capture replays the original handles and constant addresses; Save and Load keep the renumbered
+    // frame and its constants, and a loaded capture replays every draw into a null target.
+    void TestRoundTrip(const std::filesystem::path &dir) {
+        CommandCapture capture;
+        RecordingCommandList original;
+        RecordFrame(capture, original, 1000, 0x7000000);
+        GFW_CHECK(capture.IsLive() && !capture.IsEmpty());
+        GFW_CHECK(capture.ConstantCount() == kConstantCount && capture.PipelineCount() == 2 &&
+                  capture.RootSignatureCount() == 1);
+
+        std::vector<GpuAddress> addresses(kConstantCount);
+        for (std::size_t i = 0; i < kConstantCount; ++i) {
+            addresses[i] = UploadAddress(0x7000000, i);
+        }
+        RecordingCommandList replayed;
+        capture.Replay(replayed, addresses);
+        GFW_CHECK(SameStream(original.Stream(), replayed.Stream()));
+
+        const std::wstring path = (dir / "frame.gfwcap").wstring();
+        GFW_CHECK(capture.Save(path));
+        CommandCapture loaded;
+        GFW_CHECK(loaded.Load(path));
+        GFW_CHECK(!loaded.IsLive() && SameStream(capture.Stream(), loaded.Stream()));
+        GFW_CHECK(loaded.ConstantCount() == kConstantCount && loaded.ConstantBytes() == capture.ConstantBytes() &&
+                  loaded.PipelineCount() == 2 && loaded.RootSignatureCount() == 1);
+        for (std::size_t i = 0; i < kConstantCount; ++i) {
+            GFW_CHECK(loaded.ConstantSize(i) == kConstantSizes[i] &&
+                      std::memcmp(loaded.ConstantData(i), capture.ConstantData(i), kConstantSizes[i]) == 0);
+        }
+
+        NullCommandSink sink;
+        loaded.Replay(sink, addresses);
+        loaded.Replay(sink, addresses);
+        GFW_CHECK(sink.DrawCount() == 2 * original.Stream().DrawCount() && original.Stream().DrawCount() == 7);
+        RecordingCommandList loaded_replay;
+        loaded.Replay(loaded_replay, addresses);
+        GFW_CHECK(DrawShape(loaded_replay.Stream()) == DrawShape(original.Stream()));
+    }
+
+    // Handles are renumbered in order of first use, so where the frame's objects were allocated does not leak
+    // into the file.
+    void TestRecaptureIsByteIdentical(const std::filesystem::path &dir) {
+        CommandCapture capture;
+        RecordingCommandList list;
+        RecordFrame(capture, list, 1000, 0x7000000);
+        GFW_CHECK(capture.Save((dir / "first.gfwcap").wstring()));
+        RecordFrame(capture, list, 555000, 0x3200000);
+        GFW_CHECK(capture.Save((dir / "second.gfwcap").wstring()));
+        const std::vector<char> first = ReadFile(dir / "first.gfwcap");
+        GFW_CHECK(!first.empty() && first == ReadFile(dir / "second.gfwcap"));
+    }
+
+    void TestRejectsTruncatedAndCorruptFiles(const std::filesystem::path &dir) {
+        CommandCapture capture;
+        RecordingCommandList list;
+        RecordFrame(capture, list, 1000, 0x7000000);
+        const auto good_path = dir / "good.gfwcap";
+        GFW_CHECK(capture.Save(good_path.wstring()));
+        const std::vector<char> good = ReadFile(good_path);
+        const auto path = dir / "broken.gfwcap";
+        const auto rejected = [&](const std::vector<char> &bytes) {
+            CommandCapture loaded;
+            return WriteFile(path, bytes) && !loaded.Load(path.wstring()) && loaded.IsEmpty() &&
+                   loaded.ConstantCount() == 0;
+        };
+
+        for (const std::size_t size: {good.size() - 1, good.size() - 8, good.size() / 2, kHeaderSize, std::size_t{10},
+                                      std::size_t{0}}) {
+            GFW_CHECK(rejected(std::vector<char>(good.begin(), good.begin() + static_cast<std::ptrdiff_t>(size))));
+        }
+        CommandCapture missing;
+        GFW_CHECK(!missing.Load((dir / "missing.gfwcap").wstring()));
+
+        const std::size_t stream_offset = kHeaderSize + kConstantCount * sizeof(CommandCapture::ConstantBlock) +
+                                          capture.ConstantBytes();
+        const auto corrupt = [&](std::size_t offset, auto value) {
+            std::vector<char> bytes = good;
+            std::memcpy(bytes.data() + offset, &value, sizeof(value));
+            return rejected(bytes);
+        };
+        const auto unknown_op = static_cast<std::uint16_t>(CommandOp::Count);
+        GFW_CHECK(corrupt(0, 'X'));                                   // magic
+        GFW_CHECK(corrupt(8, std::uint32_t{99}));                     // version
+        GFW_CHECK(corrupt(kHandleCountsOffset, std::uint32_t{1}));    // pipeline ids past the count
+        GFW_CHECK(corrupt(kHeaderSize, std::uint32_t{0xffff}));       // constant block past the data
+        GFW_CHECK(corrupt(stream_offset, unknown_op));                // op
+        GFW_CHECK(corrupt(stream_offset + 2, std::uint16_t{0x4000})); // packet past the end
+        GFW_CHECK(corrupt(stream_offset + 2, std::uint16_t{8}));      // partial barrier
+
+        CommandCapture loaded;
+        GFW_CHECK(loaded.Load(good_path.wstring()));
+    }
+
+    // The capture CaptureReplay runs under ctest is this frame; a format change has to regenerate it.
+    void TestCheckedInCaptureIsCurrent(const std::filesystem::path &sample) {
+        CommandCapture checked_in;
+        GFW_CHECK(checked_in.Load(sample.wstring()));
+        CommandCapture capture;
+        RecordingCommandList list;
+        RecordFrame(capture, list, 1000, 0x7000000);
+        GFW_CHECK(SameStream(checked_in.Stream(), capture.Stream()) &&
+                  checked_in.ConstantBytes() == capture.ConstantBytes());
+    }
+
+    void BenchmarkReplay() {
+        CommandCapture capture;
+        RecordingCommandList list;
+        RecordFrame(capture, list, 1000, 0x7000000);
+        const std::vector<GpuAddress> addresses(kConstantCount, 0x7000000);
+        NullCommandSink sink;
+        constexpr int kFrames = 100000;
+        const double ms = test::MeasureMs([&] {
+            for (int frame = 0; frame < kFrames; ++frame) {
+                capture.Replay(sink, addresses);
+            }
+        });
+        std::printf("replay %zu commands: %.3f us/frame, %.1f ns/command\n", capture.Stream().CommandCount(),
+                    ms * 1e3 / kFrames, ms * 1e6 / (kFrames * static_cast<double>(capture.Stream().CommandCount())));
+    }
+}
+
+// CommandCaptureTests --write-sample <path> regenerates the checked-in tests/captures/sample_frame.gfwcap.
+int main(int argc, char **argv) {
+    // CommandCapture logs through wcerr, and a C stream takes the orientation of its first write. Fix both as byte
+    // streams up front so check failures are not lost after a wide log line.
+    std::fwide(stdout, -1);
+    std::fwide(stderr, -1);
+    if (argc > 2 && std::strcmp(argv[1], "--write-sample") == 0) {
+        CommandCapture capture;
+        RecordingCommandList list;
+        RecordFrame(capture, list, 1000, 0x7000000);
+        return capture.Save(std::filesystem::path(argv[2]).wstring()) ? 0 : 1;
+    }
+    const auto dir = test::ScratchDirectory("gfw_command_capture_tests");
+    TestRoundTrip(dir);
+    TestRecaptureIsByteIdentical(dir);
+    TestRejectsTruncatedAndCorruptFiles(dir);
+    TestCheckedInCaptureIsCurrent(std::filesystem::path(GFW_SOURCE_DIR) / "tests" / "captures" / "sample_frame.gfwcap");
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkReplay();
+    }
+    return test::Result("CommandCaptureTests");
+}
@@ -0,0 +1,124 @@
+#include "TestHarness.h"
+#include "framework/DescriptorAllocator.h"
+
+#include <cstdio>
+#include <map>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    void TestAllocateReleaseRetire() {
+        DescriptorAllocator allocator(4);
+        DescriptorHandle handles[4];
+        for (std::uint32_t i = 0; i < 4; ++i) {
+            GFW_CHECK(allocator.Allocate(handles[i]) && handles[i].index == i && handles[i].generation == 0);
+        }
+        DescriptorHandle extra;
+        GFW_CHECK(!allocator.Allocate(extra));
+
+        GFW_CHECK(allocator.Release(handles[1], 5));
+        GFW_CHECK(!allocator.IsAlive(handles[1]));
+        GFW_CHECK(!allocator.Release(handles[1], 5));
+        GFW_CHECK(allocator.LiveCount() == 3 && allocator.PendingCount() == 1);
+        // The GPU may still read slot 1 until fence 5 completes.
+        GFW_CHECK(!allocator.Allocate(extra));
+        allocator.Retire(4);
+        GFW_CHECK(!allocator.Allocate(extra));
+        allocator.Retire(5);
+        GFW_CHECK(allocator.Allocate(extra) && extra.index == 1 && extra.generation == 1);
+        // The old handle stays stale even though its slot has a new owner.
+        GFW_CHECK(!allocator.IsAlive(handles[1]) && allocator.IsAlive(extra));
+        GFW_CHECK(!allocator.Release(handles[1], 6) && allocator.IsAlive(extra));
+
+        allocator.Grow(8);
+        GFW_CHECK(allocator.Capacity() == 8 && allocator.IsAlive(handles[0]));
+        for (std::uint32_t i = 4; i < 8; ++i) {
+            GFW_CHECK(allocator.Allocate(extra) && extra.index == i);
+        }
+        GFW_CHECK(!allocator.Allocate(extra) && allocator.LiveCount() == 8);
+        allocator.Grow(2);
+        GFW_CHECK(allocator.Capacity() == 8);
+
+        GFW_CHECK(!allocator.IsAlive(DescriptorHandle{}) && !DescriptorHandle{}.IsValid());
+        GFW_CHECK(!allocator.Release(DescriptorHandle{}, 1));
+    }
+
+    // Textures stream in and out every frame against a fence that lags two frames. A slot may only be handed out
+    // again after the fence of the frame that released it, and every live handle must stay valid throughout.
+    void TestStreamingChurn() {
+        constexpr std::uint64_t kLatency = 2;
+        DescriptorAllocator allocator(16);
+        std::vector<DescriptorHandle> live;
+        std::map<std::uint32_t, std::uint64_t> released_at; // slot -> fence value of the release
+        std::uint32_t seed = 7;
+        const auto next = [&seed] { return (seed = seed * 1103515245u + 12345u) >> 16; };
+        bool reused_too_early = false;
+        bool handles_valid = true;
+        std::uint32_t grows = 0;
+        for (std::uint64_t frame = 1; frame <= 3000; ++frame) {
+            const std::uint64_t completed = frame > kLatency ? frame - kLatency : 0;
+            allocator.Retire(completed);
+            for (std::uint32_t i = next() % 6; i > 0 && !live.empty(); --i) {
+                const size_t victim = next() % live.size();
+                GFW_CHECK(allocator.Release(live[victim], frame));
+                released_at[live[victim].index] = frame;
+                live[victim] = live.back();
+                live.pop_back();
+            }
+            for (std::uint32_t i = next() % 6; i > 0; --i) {
+                DescriptorHandle handle;
+                if (!allocator.Allocate(handle)) {
+                    allocator.Grow(allocator.Capacity() * 2);
+                    ++grows;
+                    GFW_CHECK(allocator.Allocate(handle));
+                }
+                const auto released = released_at.find(handle.index);
+                reused_too_early |= released != released_at.end() && released->second > completed;
+                live.push_back(handle);
+            }
+            for (const DescriptorHandle &handle: live) {
+                handles_valid &= allocator.IsAlive(handle);
+            }
+        }
+        GFW_CHECK(!reused_too_early);
+        // Growing the heap mid-stream keeps the handles already given out.
+        GFW_CHECK(grows > 0 && handles_valid);
+        GFW_CHECK(allocator.LiveCount() == live.size());
+        allocator.Retire(~0ull);
+        GFW_CHECK(allocator.PendingCount() == 0);
+    }
+
+    void BenchmarkChurn() {
+        constexpr std::uint32_t kSlots = 100000;
+        constexpr int kFrames = 100;
+        DescriptorAllocator allocator(kSlots * 2);
+        std::vector<DescriptorHandle> live(kSlots);
+        for (DescriptorHandle &handle: live) {
+            allocator.Allocate(handle);
+        }
+        std::uint64_t operations = 0;
+        const double ms = test::MeasureMs([&] {
+            for (int frame = 1; frame <= kFrames; ++frame) {
+                allocator.Retire(frame > 2 ? frame - 2 : 0);
+                // A tenth of the streamed textures change every frame.
+                for (std::uint32_t i = static_cast<std::uint32_t>(frame) % 10; i < kSlots; i += 10) {
+                    allocator.Release(live[i], frame);
+                    allocator.Allocate(live[i]);
+                    operations += 2;
+                }
+            }
+        });
+        std::printf("descriptor allocator: %llu operations, %.2f ns each\n",
+                    static_cast<unsigned long long>(operations), ms * 1e6 / static_cast<double>(operations));
+    }
+}
+
+int main(int argc, char **argv) {
+    TestAllocateReleaseRetire();
+    TestStreamingChurn();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkChurn();
+    }
+    return test::Result("DescriptorAllocatorTests");
+}
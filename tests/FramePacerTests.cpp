@@ -0,0 +1,145 @@
+#include "TestHarness.h"
+#include "framework/FramePacer.h"
+#include "framework/NullRenderBackend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    void TestFenceValues() {
+        GFW_CHECK(FramePacer(1).FramesInFlight() == FramePacer::kMinFramesInFlight);
+        GFW_CHECK(FramePacer(3).FramesInFlight() == 3);
+        GFW_CHECK(FramePacer(9).FramesInFlight() == FramePacer::kMaxFramesInFlight);
+
+        FramePacer pacer(3);
+        GFW_CHECK(pacer.WaitValue(0) == 0 && pacer.PendingFenceValue() == 1);
+        GFW_CHECK(pacer.EndFrame(0) == 1 && pacer.EndFrame(1) == 2 && pacer.EndFrame(2) == 3);
+        GFW_CHECK(pacer.WaitValue(0) == 1 && pacer.WaitValue(1) == 2 && pacer.WaitValue(2) == 3);
+        // A value claimed outside a frame does not belong to any slot.
+        GFW_CHECK(pacer.ClaimFenceValue() == 4 && pacer.PendingFenceValue() == 5);
+        GFW_CHECK(pacer.EndFrame(0) == 5 && pacer.WaitValue(0) == 5 && pacer.WaitValue(1) == 2);
+    }
+
+    void TestTimeline() {
+        FramePacer pacer(2);
+        pacer.EndFrame(0);
+        pacer.EndFrame(1);
+        // The first frame seeds the averages; later ones move them gradually.
+        pacer.RecordFrame(10.0, 4.0, 1);
+        GFW_CHECK(pacer.GetTimeline().cpu_frame_ms == 10.0 && pacer.GetTimeline().fence_wait_ms == 4.0);
+        GFW_CHECK(pacer.GetTimeline().frames_in_flight == 1.0);
+        GFW_CHECK(std::fabs(pacer.GetTimeline().Overlap() - 0.6) < 1e-9);
+        for (int i = 0; i < 500; ++i) {
+            pacer.RecordFrame(16.0, 0.0, 2);
+        }
+        const FramePacer::Timeline &timeline = pacer.GetTimeline();
+        GFW_CHECK(std::fabs(timeline.cpu_frame_ms - 16.0) < 1e-3 && timeline.fence_wait_ms < 1e-3);
+        GFW_CHECK(timeline.frames_in_flight < 1e-3 && timeline.Overlap() > 0.999 && timeline.frame_count == 501);
+        GFW_CHECK(FramePacer::Timeline{}.Overlap() == 0.0);
+    }
+
+    // The frame loop of Framework with the null backend: wait for the slot, record, signal the simulated fence.
+    void TestSimulatedFenceLoop() {
+        for (std::uint32_t frames_in_flight = 2; frames_in_flight <= 4; ++frames_in_flight) {
+            for (std::uint32_t latency = 0; latency <= 5; ++latency) {
+                FramePacer pacer(frames_in_flight);
+                SimulatedFence fence(latency);
+                std::vector<std::uint64_t> slot_frames(frames_in_flight, 0);
+                bool slot_free = true;
+                bool bounded = true;
+                for (std::uint32_t frame = 0; frame < 100; ++frame) {
+                    const std::uint32_t slot = frame % frames_in_flight;
+                    fence.Wait(pacer.WaitValue(slot));
+                    // The slot's previous frame is done, and never more than frames_in_flight - 1 others run.
+                    slot_free &= fence.CompletedValue() >= slot_frames[slot];
+                    bounded &= pacer.PendingFenceValue() - 1 - fence.CompletedValue() < frames_in_flight;
+                    slot_frames[slot] = pacer.PendingFenceValue();
+                    fence.Signal(pacer.EndFrame(slot));
+                }
+                GFW_CHECK(slot_free && bounded);
+                fence.Wait(pacer.PendingFenceValue() - 1);
+                GFW_CHECK(fence.CompletedValue() == pacer.PendingFenceValue() - 1);
+            }
+        }
+    }
+
+    struct PacingResult {
+        double total_ms = 0.0;
+        double cpu_wait_ms = 0.0;
+        double gpu_busy = 0.0; // fraction of the run the GPU was executing frames
+    };
+
+    // Timed model of one queue: the CPU records a frame in cpu_ms, the GPU executes frames in order in gpu_ms
+    // each. frames_in_flight == 1 drains the GPU before every frame, as the renderer did before pacing.
+    PacingResult SimulatePacing(std::uint32_t frames_in_flight, double cpu_ms, double gpu_ms, int frames) {
+        FramePacer pacer(std::max(frames_in_flight, FramePacer::kMinFramesInFlight));
+        std::deque<std::pair<double, std::uint64_t>> queue; // completion time, fence value
+        std::uint64_t completed = 0;
+        double now = 0.0;
+        double gpu_free = 0.0;
+        PacingResult result;
+        const auto wait_for = [&](std::uint64_t value) {
+            while (completed < value) {
+                now = std::max(now, queue.front().first);
+                completed = queue.front().second;
+                queue.pop_front();
+            }
+            while (!queue.empty() && queue.front().first <= now) {
+                completed = queue.front().second;
+                queue.pop_front();
+            }
+        };
+        for (int frame = 0; frame < frames; ++frame) {
+            const std::uint32_t slot = static_cast<std::uint32_t>(frame) % pacer.FramesInFlight();
+            const double before = now;
+            wait_for(frames_in_flight == 1 ? pacer.PendingFenceValue() - 1 : pacer.WaitValue(slot));
+            result.cpu_wait_ms += now - before;
+            now += cpu_ms;
+            gpu_free = std::max(now, gpu_free) + gpu_ms;
+            queue.emplace_back(gpu_free, pacer.EndFrame(slot));
+        }
+        result.total_ms = gpu_free;
+        result.gpu_busy = gpu_ms * frames / gpu_free;
+        return result;
+    }
+
+    void TestPacingKeepsGpuBusy() {
+        // GPU-bound: with two or more frames in flight the CPU records the next frame while the GPU runs.
+        const PacingResult drained = SimulatePacing(1, 4.0, 6.0, 200);
+        const PacingResult paced = SimulatePacing(2, 4.0, 6.0, 200);
+        GFW_CHECK(std::fabs(drained.total_ms - 200 * 10.0) < 1e-6);
+        GFW_CHECK(paced.gpu_busy > 0.99 && paced.total_ms < 0.62 * drained.total_ms);
+        // CPU-bound: the CPU never waits once frames overlap.
+        const PacingResult cpu_bound = SimulatePacing(3, 6.0, 4.0, 200);
+        GFW_CHECK(cpu_bound.cpu_wait_ms == 0.0);
+    }
+
+    void BenchmarkPacing() {
+        std::printf("%-22s %6s %10s %12s %9s\n", "simulated 200 frames", "frames", "total ms", "CPU wait ms",
+                    "GPU busy");
+        for (const auto &[cpu_ms, gpu_ms]: {std::pair{4.0, 6.0}, std::pair{6.0, 4.0}, std::pair{5.0, 5.0}}) {
+            for (std::uint32_t frames_in_flight = 1; frames_in_flight <= FramePacer::kMaxFramesInFlight;
+                 ++frames_in_flight) {
+                const PacingResult r = SimulatePacing(frames_in_flight, cpu_ms, gpu_ms, 200);
+                std::printf("CPU %.0f ms, GPU %.0f ms    %6u %10.0f %12.0f %8.1f%%\n", cpu_ms, gpu_ms, frames_in_flight,
+                            r.total_ms, r.cpu_wait_ms, 100.0 * r.gpu_busy);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestFenceValues();
+    TestTimeline();
+    TestSimulatedFenceLoop();
+    TestPacingKeepsGpuBusy();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkPacing();
+    }
+    return test::Result("FramePacerTests");
+}
@@ -0,0 +1,294 @@
+#include "FrustumCuller.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace gfw;
+using namespace DirectX;
+
+namespace {
+    struct Object {
+        XMFLOAT3 aabb_min;
+        XMFLOAT3 aabb_max;
+        float radius;
+        XMFLOAT4X4 world;
+    };
+
+    // World-space center, box extent and sphere radius as the culler derives them, in double precision.
+    struct WorldBounds {
+        double center[3];
+        double extent[3];
+        double radius;
+    };
+
+    WorldBounds ToWorld(const Object &object, float margin = 0.0f) {
+        const double local_center[3] = {0.5 * (object.aabb_min.x + object.aabb_max.x),
+                                        0.5 * (object.aabb_min.y + object.aabb_max.y),
+                                        0.5 * (object.aabb_min.z + object.aabb_max.z)};
+        const double local_extent[3] = {0.5 * (object.aabb_max.x - object.aabb_min.x) + margin,
+                                        0.5 * (object.aabb_max.y - object.aabb_min.y) + margin,
+                                        0.5 * (object.aabb_max.z - object.aabb_min.z) + margin};
+        const XMFLOAT4X4 &w = object.world;
+        const double rows[4][3] = {{w._11, w._12, w._13}, {w._21, w._22, w._23}, {w._31, w._32, w._33},
+                                   {w._41, w._42, w._43}};
+        WorldBounds bounds = {};
+        double max_scale_sq = 0.0;
+        for (int r = 0; r < 3; ++r) {
+            max_scale_sq = std::max(max_scale_sq, rows[r][0] * rows[r][0] + rows[r][1] * rows[r][1] +
+                                                      rows[r][2] * rows[r][2]);
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            bounds.center[axis] = rows[3][axis];
+            for (int r = 0; r < 3; ++r) {
+                bounds.center[axis] += local_center[r] * rows[r][axis];
+                bounds.extent[axis] += local_extent[r] * std::abs(rows[r][axis]);
+            }
+        }
+        bounds.radius = (object.radius + margin) * std::sqrt(max_scale_sq);
+        return bounds;
+    }
+
+    enum class Expected { Visible, Culled, Borderline };
+
+    // Scalar reference of the culler's test. Within tolerance of a plane float rounding may go either way.
+    Expected Classify(const FrustumCuller::Frustum &frustum, const WorldBounds &bounds, double tolerance) {
+        Expected result = Expected::Visible;
+        for (const XMFLOAT4 &plane : frustum.planes) {
+            const double distance = plane.x * bounds.center[0] + plane.y * bounds.center[1] +
+                                    plane.z * bounds.center[2] + plane.w;
+            const double box = std::abs(plane.x) * bounds.extent[0] + std::abs(plane.y) * bounds.extent[1] +
+                               std::abs(plane.z) * bounds.extent[2];
+            const double reach = std::min(bounds.radius, box);
+            if (distance < -reach - tolerance) {
+                return Expected::Culled;
+            }
+            if (distance < -reach + tolerance) {
+                result = Expected::Borderline;
+            }
+        }
+        return result;
+    }
+
+    FrustumCuller::Frustum CameraFrustum(XMFLOAT3 eye, XMFLOAT3 target, float far_z = 500.0f) {
+        const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f),
+                                               XMVectorSet(target.x, target.y, target.z, 1.0f),
+                                               XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        XMFLOAT4X4 view_proj;
+        XMStoreFloat4x4(&view_proj, XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f,
+                                                                                    far_z)));
+        return FrustumCuller::ExtractFrustum(view_proj);
+    }
+
+    // Rotated about y, non-uniformly scaled boxes with a sphere tighter than the box's corners.
+    std::vector<Object> RandomObjects(size_t count, std::mt19937 &rng, float spread) {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<Object> objects(count);
+        for (Object &object : objects) {
+            const float angle = unit(rng) * 3.0f;
+            const float scale = 1.0f + 0.5f * unit(rng);
+            object.world = {};
+            object.world._11 = std::cos(angle) * scale;
+            object.world._13 = -std::sin(angle) * scale;
+            object.world._22 = scale * 1.5f;
+            object.world._31 = std::sin(angle) * scale;
+            object.world._33 = std::cos(angle) * scale;
+            object.world._41 = unit(rng) * spread;
+            object.world._42 = unit(rng) * spread * 0.3f;
+            object.world._43 = unit(rng) * spread;
+            object.world._44 = 1.0f;
+            object.aabb_min = {-1.0f + 0.5f * unit(rng), -2.0f, -1.0f};
+            object.aabb_max = {1.0f, 2.0f + unit(rng), 1.0f + 0.5f * unit(rng)};
+            const float hx = 0.5f * (object.aabb_max.x - object.aabb_min.x);
+            const float hy = 0.5f * (object.aabb_max.y - object.aabb_min.y);
+            const float hz = 0.5f * (object.aabb_max.z - object.aabb_min.z);
+            object.radius = 0.8f * std::sqrt(hx * hx + hy * hy + hz * hz);
+        }
+        return objects;
+    }
+
+    // The SIMD lanes agree with the scalar reference for every object away from a plane, tail lanes included.
+    void TestMatchesScalarReference() {
+        std::mt19937 rng(7);
+        const FrustumCuller::Frustum frustums[] = {
+            CameraFrustum({0.0f, 0.0f, -50.0f}, {0.0f, 0.0f, 0.0f}),
+            CameraFrustum({100.0f, 40.0f, 100.0f}, {-20.0f, 0.0f, 10.0f}),
+            CameraFrustum({0.0f, 200.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, 150.0f),
+        };
+        size_t mismatches = 0;
+        size_t borderline = 0;
+        size_t checked = 0;
+        for (const size_t count : {1u, 3u, 7u, 8u, 9u, 17u, 1000u, 5000u}) {
+            const std::vector<Object> objects = RandomObjects(count, rng, 300.0f);
+            const float margin = count % 2 ? 0.5f : 0.0f;
+            FrustumCuller culler;
+            culler.Resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (i % 11 != 5) {
+                    culler.SetBounds(i, objects[i].aabb_min, objects[i].aabb_max, objects[i].radius,
+                                     objects[i].world, margin);
+                }
+            }
+            for (const FrustumCuller::Frustum &frustum : frustums) {
+                std::vector<std::uint32_t> visible;
+                const size_t culled = culler.Cull(frustum, visible);
+                GFW_CHECK(culled + visible.size() == count);
+                GFW_CHECK(std::is_sorted(visible.begin(), visible.end()));
+                std::vector<char> is_visible(count, 0);
+                for (const std::uint32_t index : visible) {
+                    is_visible[index] = 1;
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    ++checked;
+                    if (i % 11 == 5) {
+                        mismatches += !is_visible[i];
+                        continue;
+                    }
+                    switch (Classify(frustum, ToWorld(objects[i], margin), 1e-3)) {
+                        case Expected::Visible:
+                            mismatches += !is_visible[i];
+                            break;
+                        case Expected::Culled:
+                            mismatches += is_visible[i];
+                            break;
+                        case Expected::Borderline:
+                            ++borderline;
+                            break;
+                    }
+                }
+            }
+        }
+        GFW_CHECK(mismatches == 0);
+        GFW_CHECK(borderline * 1000 < checked);
+    }
+
+    // Conservative: any point of an object (inside both its box and its sphere) that lies in the frustum means
+    // the object is kept.
+    void TestNeverCullsVisiblePoints() {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        const std::vector<Object> objects = RandomObjects(4000, rng, 200.0f);
+        FrustumCuller culler;
+        culler.Resize(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i) {
+            culler.SetBounds(i, objects[i].aabb_min, objects[i].aabb_max, objects[i].radius, objects[i].world);
+        }
+        const FrustumCuller::Frustum frustum = CameraFrustum({30.0f, 10.0f, -120.0f}, {0.0f, 0.0f, 0.0f});
+        std::vector<std::uint32_t> visible;
+        culler.Cull(frustum, visible);
+        std::vector<char> is_visible(objects.size(), 0);
+        for (const std::uint32_t index : visible) {
+            is_visible[index] = 1;
+        }
+        size_t wrongly_culled = 0;
+        size_t inside_points = 0;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            const Object &o = objects[i];
+            const XMFLOAT3 center = {0.5f * (o.aabb_min.x + o.aabb_max.x), 0.5f * (o.aabb_min.y + o.aabb_max.y),
+                                     0.5f * (o.aabb_min.z + o.aabb_max.z)};
+            for (int s = 0; s < 64; ++s) {
+                const float x = center.x + 0.5f * (o.aabb_max.x - o.aabb_min.x) * unit(rng);
+                const float y = center.y + 0.5f * (o.aabb_max.y - o.aabb_min.y) * unit(rng);
+                const float z = center.z + 0.5f * (o.aabb_max.z - o.aabb_min.z) * unit(rng);
+                const float dx = x - center.x;
+                const float dy = y - center.y;
+                const float dz = z - center.z;
+                if (dx * dx + dy * dy + dz * dz > o.radius * o.radius) {
+                    continue;
+                }
+                const XMFLOAT4X4 &w = o.world;
+                const float px = x * w._11 + y * w._21 + z * w._31 + w._41;
+                const float py = x * w._12 + y * w._22 + z * w._32 + w._42;
+                const float pz = x * w._13 + y * w._23 + z * w._33 + w._43;
+                bool inside = true;
+                for (const XMFLOAT4 &plane : frustum.planes) {
+                    inside &= plane.x * px + plane.y * py + plane.z * pz + plane.w >= 0.0f;
+                }
+                inside_points += inside;
+                wrongly_culled += inside && !is_visible[i];
+            }
+        }
+        GFW_CHECK(inside_points > 1000 && wrongly_culled == 0);
+        GFW_CHECK(!visible.empty() && visible.size() < objects.size());
+    }
+
+    void TestResizeAndUnbounded() {
+        FrustumCuller culler;
+        culler.Resize(3);
+        const FrustumCuller::Frustum frustum = CameraFrustum({0.0f, 0.0f, -10.0f}, {0.0f, 0.0f, 0.0f});
+        XMFLOAT4X4 behind = {};
+        behind._11 = behind._22 = behind._33 = behind._44 = 1.0f;
+        behind._43 = -100.0f;
+        for (size_t i = 0; i < 3; ++i) {
+            culler.SetBounds(i, {-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}, 1.8f, behind);
+        }
+        std::vector<std::uint32_t> visible;
+        GFW_CHECK(culler.Cull(frustum, visible) == 3 && visible.empty());
+        // Objects added by growing are unbounded and always drawn; shrinking drops the tail.
+        culler.Resize(10);
+        GFW_CHECK(culler.Cull(frustum, visible) == 3 && visible.size() == 7 && visible.front() == 3);
+        culler.SetUnbounded(1);
+        culler.Resize(2);
+        GFW_CHECK(culler.Cull(frustum, visible) == 1 && visible.size() == 1 && visible[0] == 1);
+        // A margin that reaches into the frustum keeps the object.
+        culler.SetBounds(0, {-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}, 1.8f, behind, 95.0f);
+        GFW_CHECK(culler.Cull(frustum, visible) == 0);
+    }
+
+    // Culling throughput against the scalar reference over precomputed world bounds.
+    void BenchmarkCull() {
+        std::printf("%zu lanes per iteration\n", FrustumCuller::kLaneCount);
+        const FrustumCuller::Frustum frustum = CameraFrustum({0.0f, 20.0f, -50.0f}, {0.0f, 0.0f, 100.0f});
+        std::mt19937 rng(5);
+        for (const size_t count : {10000u, 100000u, 1000000u}) {
+            const std::vector<Object> objects = RandomObjects(count, rng, 1000.0f);
+            FrustumCuller culler;
+            culler.Resize(count);
+            std::vector<WorldBounds> bounds(count);
+            const double update_ms = test::MeasureMs([&] {
+                for (size_t i = 0; i < count; ++i) {
+                    culler.SetBounds(i, objects[i].aabb_min, objects[i].aabb_max, objects[i].radius,
+                                     objects[i].world);
+                }
+            });
+            for (size_t i = 0; i < count; ++i) {
+                bounds[i] = ToWorld(objects[i]);
+            }
+            std::vector<std::uint32_t> visible;
+            const int repeats = count >= 1000000 ? 10 : 100;
+            const double simd_ms = test::MeasureMs([&] {
+                                       for (int r = 0; r < repeats; ++r) {
+                                           culler.Cull(frustum, visible);
+                                       }
+                                   }) /
+                                   repeats;
+            size_t scalar_visible = 0;
+            const double scalar_ms = test::MeasureMs([&] {
+                                         for (int r = 0; r < repeats; ++r) {
+                                             scalar_visible = 0;
+                                             for (const WorldBounds &b : bounds) {
+                                                 scalar_visible += Classify(frustum, b, 0.0) != Expected::Culled;
+                                             }
+                                         }
+                                     }) /
+                                     repeats;
+            std::printf("%8zu objects, %6zu visible: cull %8.1f us (%4.0f objects/us), scalar %6zu visible in %8.1f us "
+                        "(%4.0f objects/us), bounds update %8.1f us\n",
+                        count, visible.size(), simd_ms * 1e3, count / (simd_ms * 1e3), scalar_visible,
+                        scalar_ms * 1e3, count / (scalar_ms * 1e3), update_ms * 1e3);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestMatchesScalarReference();
+    TestNeverCullsVisiblePoints();
+    TestResizeAndUnbounded();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkCull();
+    }
+    return test::Result("FrustumCullerTests");
+}
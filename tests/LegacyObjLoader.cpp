@@ -0,0 +1,252 @@
+#include "LegacyObjLoader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+namespace gfw::test {
+    namespace {
+        struct Vertex {
+            float px, py, pz;
+            float nx, ny, nz;
+            float u, v;
+        };
+
+        struct ObjIndex {
+            int v = 0;
+            int vt = 0;
+            int vn = 0;
+
+            bool operator<(const ObjIndex &other) const {
+                if (v != other.v) return v < other.v;
+                if (vt != other.vt) return vt < other.vt;
+                return vn < other.vn;
+            }
+        };
+
+        struct ParsedMtl {
+            std::wstring diffuse_texture;
+            XMFLOAT4 kd = {1.0f, 1.0f, 1.0f, 1.0f};
+        };
+
+        int ParseObjInt(const std::string &s) {
+            if (s.empty()) return 0;
+            try {
+                return std::stoi(s);
+            } catch (...) {
+                return 0;
+            }
+        }
+
+        std::wstring DirectoryOf(const std::wstring &path) {
+            const size_t slash = path.find_last_of(L"/\\");
+            if (slash == std::wstring::npos) return L".";
+            return path.substr(0, slash);
+        }
+
+        std::wstring JoinPath(const std::wstring &base, const std::wstring &relative) {
+            if (relative.empty()) return base;
+            if (relative.size() > 1 && relative[1] == L':') return relative;
+            if (relative[0] == L'/' || relative[0] == L'\\') return relative;
+            if (base.empty()) return relative;
+            const wchar_t last = base.back();
+            if (last == L'/' || last == L'\\') return base + relative;
+            return base + L"/" + relative;
+        }
+
+        std::unordered_map<std::wstring, ParsedMtl> ParseMtl(const std::wstring &obj_dir,
+                                                             const std::wstring &mtl_filename) {
+            std::unordered_map<std::wstring, ParsedMtl> result;
+            if (mtl_filename.empty()) {
+                return result;
+            }
+            std::wstring mtl_path = JoinPath(obj_dir, mtl_filename);
+            std::ifstream file(std::filesystem::path(mtl_path), std::ios::binary);
+            if (!file.is_open()) {
+                mtl_path = mtl_filename;
+                file = std::ifstream(std::filesystem::path(mtl_path), std::ios::binary);
+                if (!file.is_open()) {
+                    return result;
+                }
+            }
+
+            std::wstring current;
+            std::string line;
+            while (std::getline(file, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                std::istringstream ss(line);
+                std::string tok;
+                ss >> tok;
+                if (tok == "newmtl") {
+                    std::string name;
+                    ss >> name;
+                    current.assign(name.begin(), name.end());
+                    result[current] = ParsedMtl{};
+                } else if (tok == "map_Kd" && !current.empty()) {
+                    std::string tex;
+                    ss >> tex;
+                    result[current].diffuse_texture =
+                        JoinPath(DirectoryOf(mtl_path), std::wstring(tex.begin(), tex.end()));
+                } else if (tok == "Kd" && !current.empty()) {
+                    float r = 1.0f, g = 1.0f, b = 1.0f;
+                    if (ss >> r >> g >> b) {
+                        result[current].kd = {r, g, b, 1.0f};
+                    }
+                }
+            }
+            return result;
+        }
+    }
+
+    ObjModelData LoadObjModelLegacy(const std::wstring &obj_filename, const std::wstring &mtl_filename) {
+        ObjModelData model;
+        std::ifstream file(std::filesystem::path(obj_filename), std::ios::binary);
+        if (!file.is_open()) {
+            return model;
+        }
+
+        const auto mtls = ParseMtl(DirectoryOf(obj_filename), mtl_filename);
+
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT3> normals;
+        std::vector<XMFLOAT2> uvs;
+        const float scale = 0.01f;
+
+        std::unordered_map<std::wstring, size_t> material_to_submesh;
+        std::vector<std::vector<Vertex>> vertices_per_submesh;
+        std::vector<std::vector<std::uint32_t>> indices_per_submesh;
+        std::vector<std::map<ObjIndex, std::uint32_t>> index_map_per_submesh;
+
+        auto ensure_submesh = [&](const std::wstring &material_name) -> size_t {
+            auto it = material_to_submesh.find(material_name);
+            if (it != material_to_submesh.end()) {
+                return it->second;
+            }
+            const size_t idx = model.submeshes.size();
+            material_to_submesh[material_name] = idx;
+            model.submeshes.push_back({});
+            model.submeshes[idx].material_name = material_name;
+            auto mtl_it = mtls.find(material_name);
+            if (mtl_it != mtls.end()) {
+                model.submeshes[idx].diffuse_texture_path = mtl_it->second.diffuse_texture;
+                model.submeshes[idx].albedo = mtl_it->second.kd;
+            }
+            vertices_per_submesh.emplace_back();
+            indices_per_submesh.emplace_back();
+            index_map_per_submesh.emplace_back();
+            return idx;
+        };
+
+        size_t current_submesh = ensure_submesh(L"default");
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::stringstream ss(line);
+            std::string type;
+            ss >> type;
+
+            if (type == "v") {
+                XMFLOAT3 p;
+                if (!(ss >> p.x >> p.y >> p.z)) continue;
+                p.x *= scale;
+                p.y *= scale;
+                p.z *= scale;
+                p.z = -p.z;
+                positions.push_back(p);
+            } else if (type == "vt") {
+                XMFLOAT2 uv = {};
+                if (!(ss >> uv.x >> uv.y)) continue;
+                uv.y = 1.0f - uv.y;
+                uvs.push_back(uv);
+            } else if (type == "vn") {
+                XMFLOAT3 n;
+                if (!(ss >> n.x >> n.y >> n.z)) continue;
+                n.z = -n.z;
+                normals.push_back(n);
+            } else if (type == "usemtl") {
+                std::string mat;
+                ss >> mat;
+                current_submesh = ensure_submesh(std::wstring(mat.begin(), mat.end()));
+            } else if (type == "f") {
+                std::string vertex_str;
+                std::vector<ObjIndex> face_indices;
+                while (ss >> vertex_str) {
+                    ObjIndex idx;
+                    const size_t first_slash = vertex_str.find('/');
+                    const size_t second_slash = vertex_str.find('/', first_slash + 1);
+                    if (first_slash == std::string::npos) {
+                        idx.v = ParseObjInt(vertex_str);
+                    } else if (second_slash == std::string::npos) {
+                        idx.v = ParseObjInt(vertex_str.substr(0, first_slash));
+                        idx.vt = ParseObjInt(vertex_str.substr(first_slash + 1));
+                    } else {
+                        idx.v = ParseObjInt(vertex_str.substr(0, first_slash));
+                        idx.vt = ParseObjInt(vertex_str.substr(first_slash + 1, second_slash - first_slash - 1));
+                        idx.vn = ParseObjInt(vertex_str.substr(second_slash + 1));
+                    }
+                    face_indices.push_back(idx);
+                }
+
+                const int pos_count = static_cast<int>(positions.size());
+                const int norm_count = static_cast<int>(normals.size());
+                const int uv_count = static_cast<int>(uvs.size());
+                for (size_t i = 1; i + 1 < face_indices.size(); ++i) {
+                    ObjIndex tri[3] = {face_indices[0], face_indices[i + 1], face_indices[i]};
+                    for (ObjIndex &obj_idx: tri) {
+                        if (obj_idx.v < 0) obj_idx.v = pos_count + obj_idx.v + 1;
+                        if (obj_idx.vt < 0) obj_idx.vt = uv_count + obj_idx.vt + 1;
+                        if (obj_idx.vn < 0) obj_idx.vn = norm_count + obj_idx.vn + 1;
+                        obj_idx.v = std::max(1, std::min(obj_idx.v, pos_count));
+                        obj_idx.vt = std::max(0, std::min(obj_idx.vt, uv_count));
+                        obj_idx.vn = std::max(0, std::min(obj_idx.vn, norm_count));
+
+                        auto &sub_vertices = vertices_per_submesh[current_submesh];
+                        auto &sub_index_map = index_map_per_submesh[current_submesh];
+                        if (sub_index_map.find(obj_idx) == sub_index_map.end()) {
+                            Vertex v = {};
+                            v.px = positions[obj_idx.v - 1].x;
+                            v.py = positions[obj_idx.v - 1].y;
+                            v.pz = positions[obj_idx.v - 1].z;
+                            if (obj_idx.vt > 0) {
+                                v.u = uvs[obj_idx.vt - 1].x;
+                                v.v = uvs[obj_idx.vt - 1].y;
+                            }
+                            if (obj_idx.vn > 0) {
+                                v.nx = normals[obj_idx.vn - 1].x;
+                                v.ny = normals[obj_idx.vn - 1].y;
+                                v.nz = normals[obj_idx.vn - 1].z;
+                            }
+                            sub_index_map[obj_idx] = static_cast<std::uint32_t>(sub_vertices.size());
+                            sub_vertices.push_back(v);
+                        }
+                        indices_per_submesh[current_submesh].push_back(sub_index_map[obj_idx]);
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < model.submeshes.size(); ++i) {
+            MeshData &mesh = model.submeshes[i].mesh;
+            const auto &sub_vertices = vertices_per_submesh[i];
+            mesh.vertex_stride = sizeof(Vertex);
+            mesh.vertex_count = static_cast<std::uint32_t>(sub_vertices.size());
+            mesh.indices = std::move(indices_per_submesh[i]);
+            if (mesh.vertex_count > 0) {
+                mesh.vertex_data.resize(static_cast<size_t>(mesh.vertex_count) * mesh.vertex_stride);
+                std::memcpy(mesh.vertex_data.data(), sub_vertices.data(), mesh.vertex_data.size());
+            }
+        }
+        return model;
+    }
+}
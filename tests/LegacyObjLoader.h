@@ -0,0 +1,11 @@
+#pragma once
+
+#include "MeshLoader.h"
+#include <string>
+
+namespace gfw::test {
+    // The stream-based OBJ reader MeshLoader::LoadObjModel replaced, kept as the reference its output has to match
+    // byte for byte and as the baseline of the parser benchmark. Fills the fields the old loader filled: names,
+    // texture paths, albedo, vertex data and indices; bounds and tangents are left unset.
+    ObjModelData LoadObjModelLegacy(const std::wstring &obj_filename, const std::wstring &mtl_filename = L"");
+}
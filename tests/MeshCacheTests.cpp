@@ -0,0 +1,193 @@
+#include "MeshCache.h"
+#include "Meshlets.h"
+#include "OcclusionCuller.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+using namespace gfw;
+
+namespace {
+    // Compares through the accessors, so an owned mesh matches the cache view of the same data.
+    bool SameGeometry(const MeshData &a, const MeshData &b) {
+        if (a.VertexByteSize() != b.VertexByteSize() || a.IndexCount() != b.IndexCount() ||
+            (a.VertexByteSize() > 0 && std::memcmp(a.VertexBytes(), b.VertexBytes(), a.VertexByteSize()) != 0)) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < a.IndexCount(); ++i) {
+            if (a.Index(i) != b.Index(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SameSubmesh(const ObjSubmeshData &x, const ObjSubmeshData &y) {
+        const MeshData &a = x.mesh;
+        const MeshData &b = y.mesh;
+        return x.material_name == y.material_name && x.diffuse_texture_path == y.diffuse_texture_path &&
+               std::memcmp(&x.albedo, &y.albedo, sizeof(x.albedo)) == 0 && SameGeometry(a, b) &&
+               a.vertex_stride == b.vertex_stride && a.vertex_count == b.vertex_count &&
+               a.topology == b.topology && a.vertex_format == b.vertex_format && a.has_tangents == b.has_tangents &&
+               std::memcmp(&a.bounds_min, &b.bounds_min, sizeof(a.bounds_min)) == 0 &&
+               std::memcmp(&a.bounds_max, &b.bounds_max, sizeof(a.bounds_max)) == 0 &&
+               a.bounds_radius == b.bounds_radius && a.meshlets.size() == b.meshlets.size() &&
+               (a.meshlets.empty() ||
+                std::memcmp(a.meshlets.data(), b.meshlets.data(), a.meshlets.size() * sizeof(Meshlet)) == 0) &&
+               a.lods.size() == b.lods.size() &&
+               (a.lods.empty() || std::memcmp(a.lods.data(), b.lods.data(), a.lods.size() * sizeof(MeshLod)) == 0);
+    }
+
+    bool SameModel(const ObjModelData &a, const ObjModelData &b) {
+        if (a.submeshes.size() != b.submeshes.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.submeshes.size(); ++i) {
+            if (!SameSubmesh(a.submeshes[i], b.submeshes[i])) {
+                std::fprintf(stderr, "submesh %zu differs\n", i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ObjModelData LoadProcessed(const std::filesystem::path &obj) {
+        ObjModelData model = MeshLoader::LoadObjModel(obj.wstring(), L"synthetic.mtl");
+        MeshLoader::GenerateTangents(model);
+        for (ObjSubmeshData &sub: model.submeshes) {
+            Meshlets::Build(sub.mesh);
+        }
+        return model;
+    }
+
+    void TestRoundTrip(const std::filesystem::path &dir) {
+        const auto obj = dir / "synthetic.obj";
+        GFW_CHECK(test::WriteTextFile(obj, test::SyntheticObj(64, 3)));
+        GFW_CHECK(test::WriteTextFile(dir / "synthetic.mtl", test::SyntheticMtl(3)));
+        MeshSourceStamp stamp;
+        GFW_CHECK(MeshCache::ComputeStamp(obj.wstring(), L"synthetic.mtl", stamp));
+        stamp.settings_hash = MeshCache::HashSettings({1.05f, 0.5f});
+
+        const ObjModelData model = LoadProcessed(obj);
+        const std::wstring cache = MeshCache::CachePathFor(obj.wstring());
+        GFW_CHECK(cache.ends_with(L".gfwmesh"));
+        GFW_CHECK(MeshCache::Save(cache, stamp, model));
+        ObjModelData cached;
+        GFW_CHECK(MeshCache::Load(cache, stamp, cached));
+        GFW_CHECK(SameModel(model, cached));
+
+        // Loaded meshes read the mapped file in place, 16-bit indices included, and keep it mapped on their own.
+        const MeshData &first = cached.submeshes[0].mesh;
+        GFW_CHECK(first.IsView() && first.vertex_data.empty() && first.indices.empty());
+        GFW_CHECK(first.IndexSize() == 2 && first.BaseIndexCount() == model.submeshes[0].mesh.BaseIndexCount());
+        const std::wstring resaved = (dir / "resaved.gfwmesh").wstring();
+        GFW_CHECK(MeshCache::Save(resaved, stamp, cached));
+        const MeshData kept = first;
+        cached = {};
+        GFW_CHECK(SameGeometry(kept, model.submeshes[0].mesh));
+        GFW_CHECK(MeshCache::Load(resaved, stamp, cached));
+        GFW_CHECK(SameModel(model, cached));
+
+        // Any change to the source or to the processing settings makes the file stale.
+        MeshSourceStamp other = stamp;
+        other.content_hash ^= 1;
+        GFW_CHECK(!MeshCache::Load(cache, other, cached));
+        other = stamp;
+        other.settings_hash = MeshCache::HashSettings({1.05f, 0.25f});
+        GFW_CHECK(other.settings_hash != stamp.settings_hash);
+        GFW_CHECK(!MeshCache::Load(cache, other, cached));
+        GFW_CHECK(MeshCache::HashSettings({1.05f, 0.5f}) == stamp.settings_hash);
+
+        GFW_CHECK(test::WriteTextFile(obj, test::SyntheticObj(64, 2)));
+        MeshSourceStamp edited;
+        GFW_CHECK(MeshCache::ComputeStamp(obj.wstring(), L"synthetic.mtl", edited));
+        edited.settings_hash = stamp.settings_hash;
+        GFW_CHECK(!(edited == stamp));
+    }
+
+    void TestTruncatedFile(const std::filesystem::path &dir) {
+        ObjModelData model;
+        model.submeshes.resize(1);
+        model.submeshes[0].mesh = test::GridMesh(8);
+        const MeshSourceStamp stamp{.content_hash = 7, .settings_hash = 11};
+        const std::wstring cache = (dir / "truncated.gfwmesh").wstring();
+        GFW_CHECK(MeshCache::Save(cache, stamp, model));
+        const auto size = std::filesystem::file_size(cache);
+        for (const auto cut: {size - 1, size / 2, std::uintmax_t{40}, std::uintmax_t{0}}) {
+            std::filesystem::resize_file(cache, cut);
+            ObjModelData out;
+            GFW_CHECK(!MeshCache::Load(cache, stamp, out));
+        }
+        ObjModelData out;
+        GFW_CHECK(!MeshCache::Load((dir / "missing.gfwmesh").wstring(), stamp, out));
+    }
+
+    // Files whose ranges do not fit their own buffers are rejected instead of handed to the renderer. Index values
+    // are trusted on load; the occluder extraction that walks them on the CPU still bounds-checks each one.
+    void TestMalformedRanges(const std::filesystem::path &dir) {
+        ObjModelData model;
+        model.submeshes.resize(1);
+        MeshData &mesh = model.submeshes[0].mesh;
+        mesh.vertex_stride = 32;
+        mesh.vertex_count = 4;
+        mesh.vertex_data.resize(128, 1);
+        mesh.indices = {0, 1, 2, 2, 1, 3};
+        mesh.lods = {{0, 6, 0.0f}, {0, 3, 0.1f}};
+        mesh.meshlets.resize(1);
+        mesh.meshlets[0].triangle_count = 2;
+        const MeshSourceStamp stamp{.content_hash = 7, .settings_hash = 11};
+        const std::wstring cache = (dir / "ranges.gfwmesh").wstring();
+
+        ObjModelData out;
+        GFW_CHECK(MeshCache::Save(cache, stamp, model));
+        GFW_CHECK(MeshCache::Load(cache, stamp, out));
+        const auto rejected = [&](const std::function<void(MeshData &)> &mutate) {
+            ObjModelData broken = model;
+            mutate(broken.submeshes[0].mesh);
+            ObjModelData loaded;
+            return MeshCache::Save(cache, stamp, broken) && !MeshCache::Load(cache, stamp, loaded);
+        };
+        ObjModelData past_vertices = model;
+        past_vertices.submeshes[0].mesh.indices[1] = 9;
+        GFW_CHECK(MeshCache::Save(cache, stamp, past_vertices) && MeshCache::Load(cache, stamp, out));
+        GFW_CHECK(MeshLoader::ExtractOccluder(out.submeshes[0].mesh).indices.empty());
+        GFW_CHECK(rejected([](MeshData &m) { m.lods[1].index_offset = 6; }));
+        GFW_CHECK(rejected([](MeshData &m) { m.meshlets[0].triangle_count = 3; }));
+        GFW_CHECK(rejected([](MeshData &m) { m.meshlets[0].index_offset = 3; }));
+        GFW_CHECK(rejected([](MeshData &m) { m.vertex_stride = 16; m.vertex_data.resize(64); }));
+        GFW_CHECK(rejected([](MeshData &m) { m.indices.pop_back(); m.lods[0].index_count = 5; }));
+    }
+
+    void BenchmarkCacheLoad(const std::filesystem::path &dir) {
+        const auto obj = dir / "benchmark.obj";
+        test::WriteTextFile(obj, test::SyntheticObj(600, 8));
+        test::WriteTextFile(dir / "synthetic.mtl", test::SyntheticMtl(8));
+        MeshSourceStamp stamp;
+        MeshCache::ComputeStamp(obj.wstring(), L"synthetic.mtl", stamp);
+        ObjModelData model;
+        const double parse_ms = test::MeasureMs([&] { model = LoadProcessed(obj); });
+        const std::wstring cache = MeshCache::CachePathFor(obj.wstring());
+        const double save_ms = test::MeasureMs([&] { MeshCache::Save(cache, stamp, model); });
+        ObjModelData cached;
+        const double load_ms = test::MeasureMs([&] { MeshCache::Load(cache, stamp, cached); });
+        GFW_CHECK(SameModel(model, cached));
+        std::printf("mesh cache, %.1f MB OBJ, %.1f MB cache\n",
+                    static_cast<double>(std::filesystem::file_size(obj)) / (1024.0 * 1024.0),
+                    static_cast<double>(std::filesystem::file_size(cache)) / (1024.0 * 1024.0));
+        std::printf("parse + tangents + meshlets %8.1f ms\nsave %8.1f ms\nload %8.1f ms\n", parse_ms, save_ms, load_ms);
+    }
+}
+
+int main(int argc, char **argv) {
+    const auto dir = test::ScratchDirectory("gfw_mesh_cache_tests");
+    TestRoundTrip(dir);
+    TestTruncatedFile(dir);
+    TestMalformedRanges(dir);
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkCacheLoad(dir);
+    }
+    return test::Result("MeshCacheTests");
+}
@@ -0,0 +1,214 @@
+#include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    void TestCacheSimulator() {
+        const VertexCacheStats one = MeshOptimizer::AnalyzeVertexCache({0, 1, 2}, 3);
+        GFW_CHECK(one.transforms == 3 && one.acmr == 3.0f && one.atvr == 1.0f);
+        const VertexCacheStats shared = MeshOptimizer::AnalyzeVertexCache({0, 1, 2, 2, 1, 3}, 4);
+        GFW_CHECK(shared.transforms == 4 && shared.acmr == 2.0f);
+        // A FIFO of three entries has evicted vertex 0 by the time the third triangle reuses it.
+        const VertexCacheStats evicted = MeshOptimizer::AnalyzeVertexCache({0, 1, 2, 3, 4, 5, 0, 1, 2}, 6, 3);
+        GFW_CHECK(evicted.transforms == 9 && evicted.atvr == 1.5f);
+    }
+
+    void TestVertexCacheOrder() {
+        MeshData mesh = test::GridMesh(64);
+        test::ShuffleTriangles(mesh);
+        const auto triangles = test::SortedTriangles(mesh);
+        const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count);
+        MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertex_count);
+        const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count);
+        GFW_CHECK(before.acmr > 2.0f);
+        // A regular grid approaches 0.5 with an ideal cache; 16 FIFO entries cannot hold a full row.
+        GFW_CHECK(after.acmr < 0.8f);
+        GFW_CHECK(test::SortedTriangles(mesh) == triangles);
+
+        MeshData again = test::GridMesh(64);
+        test::ShuffleTriangles(again);
+        MeshOptimizer::OptimizeVertexCache(again.indices, again.vertex_count);
+        GFW_CHECK(again.indices == mesh.indices);
+    }
+
+    void TestVertexFetchOrder() {
+        MeshData mesh = test::GridMesh(16);
+        test::ShuffleTriangles(mesh, 7);
+        // One vertex no triangle references, which the fetch pass drops.
+        mesh.vertex_data.resize(mesh.vertex_data.size() + mesh.vertex_stride);
+        ++mesh.vertex_count;
+        const std::uint32_t referenced = mesh.vertex_count - 1;
+        const auto triangles = test::SortedTriangles(mesh);
+        MeshOptimizer::OptimizeVertexFetch(mesh);
+        GFW_CHECK(mesh.vertex_count == referenced);
+        GFW_CHECK(mesh.vertex_data.size() == static_cast<size_t>(referenced) * mesh.vertex_stride);
+        GFW_CHECK(test::SortedTriangles(mesh) == triangles);
+        std::uint32_t next = 0;
+        bool first_use_order = true;
+        for (std::uint32_t index: mesh.indices) {
+            if (index > next) {
+                first_use_order = false;
+            } else if (index == next) {
+                ++next;
+            }
+        }
+        GFW_CHECK(first_use_order && next == referenced);
+    }
+
+    void TestOtherTopologiesUntouched() {
+        MeshData mesh = test::GridMesh(4);
+        mesh.topology = PrimitiveTopology::PatchList3;
+        test::ShuffleTriangles(mesh);
+        const std::vector<std::uint32_t> indices = mesh.indices;
+        MeshOptimizer::Optimize(mesh);
+        GFW_CHECK(mesh.indices == indices);
+    }
+
+    // Small sphere inside a large one, drawn first: every view shades it and then the shell in front of it.
+    MeshData NestedSpheres() {
+        MeshData mesh = test::SphereMesh(32, 64, 0.5f);
+        test::AppendMesh(mesh, test::SphereMesh(32, 64, 1.0f));
+        return mesh;
+    }
+
+    MeshData SphereCluster() {
+        MeshData mesh;
+        for (int i = 0; i < 8; ++i) {
+            const float x = 0.5f * static_cast<float>(i % 2);
+            const float y = 0.5f * static_cast<float>(i / 2 % 2);
+            const float z = 0.5f * static_cast<float>(i / 4);
+            test::AppendMesh(mesh, test::SphereMesh(16, 32, 0.3f, x, y, z));
+        }
+        return mesh;
+    }
+
+    void TestOverdrawEstimator() {
+        // A gentle height field only folds over itself at grazing views.
+        const OverdrawStats grid = MeshOptimizer::AnalyzeOverdraw(test::GridMesh(16));
+        GFW_CHECK(grid.pixels_covered > 0 && grid.overdraw >= 1.0f && grid.overdraw < 1.01f);
+        const MeshData nested = NestedSpheres();
+        const OverdrawStats first = MeshOptimizer::AnalyzeOverdraw(nested);
+        GFW_CHECK(first.overdraw > 1.5f);
+        const OverdrawStats second = MeshOptimizer::AnalyzeOverdraw(nested);
+        GFW_CHECK(first.pixels_covered == second.pixels_covered && first.pixels_shaded == second.pixels_shaded);
+    }
+
+    void TestOverdrawOrder() {
+        MeshData cache_only = NestedSpheres();
+        MeshOptimizer::OptimizeVertexCache(cache_only.indices, cache_only.vertex_count);
+        const OverdrawStats cache_overdraw = MeshOptimizer::AnalyzeOverdraw(cache_only);
+        const VertexCacheStats cache_stats =
+            MeshOptimizer::AnalyzeVertexCache(cache_only.indices, cache_only.vertex_count);
+
+        MeshData mesh = NestedSpheres();
+        const auto triangles = test::SortedTriangles(mesh);
+        MeshOptimizer::Optimize(mesh, 1.05f);
+        GFW_CHECK(test::SortedTriangles(mesh) == triangles);
+        // The outer shell's clusters face away from the center and are drawn first.
+        GFW_CHECK(MeshOptimizer::AnalyzeOverdraw(mesh).overdraw < 0.9f * cache_overdraw.overdraw);
+        GFW_CHECK(MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count).acmr <=
+                  cache_stats.acmr * 1.05f);
+
+        // A larger threshold allows smaller clusters, trading cache reuse for less overdraw.
+        MeshData strict = SphereCluster();
+        MeshData loose = SphereCluster();
+        MeshOptimizer::Optimize(strict, 1.0f);
+        MeshOptimizer::Optimize(loose, 1.2f);
+        GFW_CHECK(MeshOptimizer::AnalyzeOverdraw(loose).overdraw < MeshOptimizer::AnalyzeOverdraw(strict).overdraw);
+        GFW_CHECK(MeshOptimizer::AnalyzeVertexCache(loose.indices, loose.vertex_count).acmr >
+                  MeshOptimizer::AnalyzeVertexCache(strict.indices, strict.vertex_count).acmr);
+    }
+
+    struct BenchmarkMesh {
+        std::string name;
+        MeshData mesh;
+    };
+
+    std::vector<BenchmarkMesh> BenchmarkMeshes() {
+        std::vector<BenchmarkMesh> meshes;
+        meshes.push_back({"grid 256", test::GridMesh(256)});
+        meshes.push_back({"grid 256 shuffled", test::GridMesh(256)});
+        test::ShuffleTriangles(meshes.back().mesh);
+        meshes.push_back({"sphere 128x256", test::SphereMesh(128, 256)});
+        meshes.push_back({"nested spheres", NestedSpheres()});
+        meshes.push_back({"sphere cluster", SphereCluster()});
+        // The repository's own assets, and Sponza when it has been downloaded next to its MTL.
+        for (const char *asset: {"bricks2/cube.obj", "bricks2/wall.obj", "sponza/Sponza-master/sponza.obj"}) {
+            const std::filesystem::path path = std::filesystem::path(GFW_SOURCE_DIR) / asset;
+            if (!std::filesystem::exists(path)) {
+                continue;
+            }
+            ObjModelData model = MeshLoader::LoadObjModel(path.wstring());
+            MeshData merged;
+            for (const ObjSubmeshData &sub: model.submeshes) {
+                test::AppendMesh(merged, sub.mesh);
+            }
+            meshes.push_back({asset, std::move(merged)});
+        }
+        return meshes;
+    }
+
+    void BenchmarkVertexCache(const std::vector<BenchmarkMesh> &meshes) {
+        std::printf("%-34s %9s %15s %15s %9s\n", "vertex cache (16-entry FIFO)", "triangles", "ACMR", "ATVR", "ms");
+        for (const BenchmarkMesh &entry: meshes) {
+            MeshData mesh = entry.mesh;
+            if (mesh.indices.empty()) {
+                continue;
+            }
+            const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count);
+            const double ms = test::MeasureMs([&] {
+                MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertex_count);
+                MeshOptimizer::OptimizeVertexFetch(mesh);
+            });
+            const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count);
+            std::printf("%-34s %9zu %6.3f -> %5.3f %6.3f -> %5.3f %9.1f\n", entry.name.c_str(),
+                        mesh.indices.size() / 3, before.acmr, after.acmr, before.atvr, after.atvr, ms);
+        }
+    }
+
+    // Overdraw over 16 orthographic views after the full pass at several thresholds, against the cache pass alone.
+    void BenchmarkOverdraw(const std::vector<BenchmarkMesh> &meshes) {
+        std::printf("%-34s %8s %8s %14s %14s %14s %9s\n", "overdraw (ACMR)", "file", "cache", "1.0", "1.05", "1.2",
+                    "ms");
+        for (const BenchmarkMesh &entry: meshes) {
+            if (entry.mesh.indices.empty()) {
+                continue;
+            }
+            MeshData cache_only = entry.mesh;
+            MeshOptimizer::OptimizeVertexCache(cache_only.indices, cache_only.vertex_count);
+            std::printf("%-34s %8.3f %8.3f", entry.name.c_str(), MeshOptimizer::AnalyzeOverdraw(entry.mesh).overdraw,
+                        MeshOptimizer::AnalyzeOverdraw(cache_only).overdraw);
+            double ms = 0.0;
+            for (float threshold: {1.0f, 1.05f, 1.2f}) {
+                MeshData mesh = entry.mesh;
+                const double pass_ms = test::MeasureMs([&] { MeshOptimizer::Optimize(mesh, threshold); });
+                ms = threshold == 1.05f ? pass_ms : ms;
+                std::printf(" %6.3f (%5.3f)", MeshOptimizer::AnalyzeOverdraw(mesh).overdraw,
+                            MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertex_count).acmr);
+            }
+            std::printf(" %9.1f\n", ms);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestCacheSimulator();
+    TestVertexCacheOrder();
+    TestVertexFetchOrder();
+    TestOtherTopologiesUntouched();
+    TestOverdrawEstimator();
+    TestOverdrawOrder();
+    if (test::BenchmarkRequested(argc, argv)) {
+        const std::vector<BenchmarkMesh> meshes = BenchmarkMeshes();
+        BenchmarkVertexCache(meshes);
+        BenchmarkOverdraw(meshes);
+    }
+    return test::Result("MeshOptimizerTests");
+}
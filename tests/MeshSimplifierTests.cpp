@@ -0,0 +1,182 @@
+#include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+#include "framework/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace gfw;
+using namespace DirectX;
+
+namespace {
+    const std::vector<float> kLodRatios = {0.5f, 0.25f, 0.125f};
+
+    XMFLOAT3 Position(const MeshData &mesh, std::uint32_t index) {
+        XMFLOAT3 p;
+        std::memcpy(&p, mesh.vertex_data.data() + static_cast<size_t>(index) * mesh.vertex_stride, sizeof(p));
+        return p;
+    }
+
+    MeshData FlatGrid(std::uint32_t quads_per_side) {
+        MeshData mesh = test::GridMesh(quads_per_side);
+        for (std::uint32_t v = 0; v < mesh.vertex_count; ++v) {
+            std::memset(mesh.vertex_data.data() + static_cast<size_t>(v) * mesh.vertex_stride + sizeof(float), 0,
+                        sizeof(float));
+        }
+        return mesh;
+    }
+
+    // Signed area of the triangles projected onto the xz plane; clockwise (front-facing from +y) counts positive.
+    double ProjectedArea(const MeshData &mesh, const std::uint32_t *indices, size_t index_count) {
+        double area = 0.0;
+        for (size_t t = 0; t + 2 < index_count; t += 3) {
+            const XMFLOAT3 a = Position(mesh, indices[t]);
+            const XMFLOAT3 b = Position(mesh, indices[t + 1]);
+            const XMFLOAT3 c = Position(mesh, indices[t + 2]);
+            area += 0.5 * ((b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z));
+        }
+        return area;
+    }
+
+    // Largest distance from the unit sphere over triangle centroids and edge midpoints.
+    float SphereDeviation(const MeshData &mesh, const std::uint32_t *indices, size_t index_count) {
+        float deviation = 0.0f;
+        const auto distance = [](float x, float y, float z) {
+            return std::fabs(1.0f - std::sqrt(x * x + y * y + z * z));
+        };
+        for (size_t t = 0; t + 2 < index_count; t += 3) {
+            const XMFLOAT3 a = Position(mesh, indices[t]);
+            const XMFLOAT3 b = Position(mesh, indices[t + 1]);
+            const XMFLOAT3 c = Position(mesh, indices[t + 2]);
+            deviation = std::max({deviation,
+                                  distance((a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3, (a.z + b.z + c.z) / 3),
+                                  distance((a.x + b.x) / 2, (a.y + b.y) / 2, (a.z + b.z) / 2),
+                                  distance((b.x + c.x) / 2, (b.y + c.y) / 2, (b.z + c.z) / 2),
+                                  distance((c.x + a.x) / 2, (c.y + a.y) / 2, (c.z + a.z) / 2)});
+        }
+        return deviation;
+    }
+
+    void TestFlatSurfaceCollapsesWithoutError() {
+        const MeshData mesh = FlatGrid(32);
+        float error = 1.0f;
+        const std::vector<std::uint32_t> simplified = MeshSimplifier::Simplify(mesh, mesh.indices, 0, error);
+        // Interior vertices of a plane collapse for free; the open border stays locked, so the outline survives.
+        GFW_CHECK(simplified.size() < mesh.indices.size() / 4);
+        GFW_CHECK(error < 1e-4f);
+        GFW_CHECK(std::fabs(ProjectedArea(mesh, simplified.data(), simplified.size()) - 1.0) < 1e-4);
+        GFW_CHECK(std::all_of(simplified.begin(), simplified.end(),
+                              [&](std::uint32_t index) { return index < mesh.vertex_count; }));
+    }
+
+    void TestLodChain() {
+        MeshData mesh = test::SphereMesh(64, 128);
+        MeshOptimizer::Optimize(mesh);
+        const std::vector<std::uint32_t> base = mesh.indices;
+        MeshSimplifier::BuildLods(mesh, kLodRatios);
+        GFW_CHECK(mesh.lods.size() == kLodRatios.size() + 1);
+        GFW_CHECK(mesh.lods[0].index_offset == 0 && mesh.lods[0].index_count == base.size() &&
+                  mesh.lods[0].error == 0.0f);
+        GFW_CHECK(std::equal(base.begin(), base.end(), mesh.indices.begin()));
+        GFW_CHECK(std::all_of(mesh.indices.begin(), mesh.indices.end(),
+                              [&](std::uint32_t index) { return index < mesh.vertex_count; }));
+
+        std::uint32_t expected_offset = 0;
+        for (size_t i = 0; i < mesh.lods.size(); ++i) {
+            const MeshLod &lod = mesh.lods[i];
+            GFW_CHECK(lod.index_offset == expected_offset && lod.index_count % 3 == 0);
+            expected_offset += lod.index_count;
+            if (i == 0) {
+                continue;
+            }
+            const MeshLod &finer = mesh.lods[i - 1];
+            const double ratio = static_cast<double>(lod.index_count) / static_cast<double>(base.size());
+            GFW_CHECK(ratio <= kLodRatios[i - 1] * 1.02 && ratio >= kLodRatios[i - 1] * 0.9);
+            GFW_CHECK(lod.error > finer.error);
+            // The reported error is an RMS quadric distance accumulated over levels; the surface it produces stays
+            // within a small multiple of it.
+            const float deviation = SphereDeviation(mesh, &mesh.indices[lod.index_offset], lod.index_count);
+            GFW_CHECK(deviation <= 2.0f * lod.error + 0.002f);
+        }
+        GFW_CHECK(expected_offset == mesh.indices.size());
+
+        MeshData again = test::SphereMesh(64, 128);
+        MeshOptimizer::Optimize(again);
+        MeshSimplifier::BuildLods(again, kLodRatios);
+        GFW_CHECK(again.indices == mesh.indices);
+    }
+
+    // The loader builds every submesh's chain on its own worker; the result must not depend on the schedule.
+    void TestParallelBuildMatchesSerial() {
+        std::vector<MeshData> serial;
+        for (std::uint32_t i = 0; i < 6; ++i) {
+            serial.push_back(i % 2 ? test::SphereMesh(16 + i * 4, 32 + i * 8) : test::GridMesh(16 + i * 4));
+        }
+        std::vector<MeshData> parallel = serial;
+        for (MeshData &mesh: serial) {
+            MeshSimplifier::BuildLods(mesh, kLodRatios);
+        }
+        ParallelFor(parallel.size(), 4, [&](std::size_t i) { MeshSimplifier::BuildLods(parallel[i], kLodRatios); });
+        bool same = true;
+        for (size_t i = 0; i < serial.size(); ++i) {
+            same &= serial[i].indices == parallel[i].indices && serial[i].lods.size() == parallel[i].lods.size();
+            for (size_t l = 0; same && l < serial[i].lods.size(); ++l) {
+                same &= std::memcmp(&serial[i].lods[l], &parallel[i].lods[l], sizeof(MeshLod)) == 0;
+            }
+        }
+        GFW_CHECK(same);
+    }
+
+    void TestNonTrianglesSkipped() {
+        MeshData mesh = test::GridMesh(8);
+        mesh.topology = PrimitiveTopology::PatchList3;
+        const std::vector<std::uint32_t> indices = mesh.indices;
+        MeshSimplifier::BuildLods(mesh, kLodRatios);
+        GFW_CHECK(mesh.lods.empty() && mesh.indices == indices);
+    }
+
+    void BenchmarkLods() {
+        std::vector<std::pair<std::string, MeshData>> meshes;
+        meshes.emplace_back("sphere 256x512", test::SphereMesh(256, 512));
+        meshes.emplace_back("grid 256", test::GridMesh(256));
+        for (const char *asset: {"bricks2/cube.obj", "bricks2/wall.obj", "sponza/Sponza-master/sponza.obj"}) {
+            const std::filesystem::path path = std::filesystem::path(GFW_SOURCE_DIR) / asset;
+            if (!std::filesystem::exists(path)) {
+                continue;
+            }
+            ObjModelData model = MeshLoader::LoadObjModel(path.wstring());
+            MeshData merged;
+            for (const ObjSubmeshData &sub: model.submeshes) {
+                test::AppendMesh(merged, sub.mesh);
+            }
+            meshes.emplace_back(asset, std::move(merged));
+        }
+        for (auto &[name, mesh]: meshes) {
+            MeshOptimizer::Optimize(mesh);
+            const double ms = test::MeasureMs([&] { MeshSimplifier::BuildLods(mesh, kLodRatios); });
+            std::printf("%-34s %9u triangles %9.1f ms:", name.c_str(), mesh.BaseIndexCount() / 3, ms);
+            for (size_t i = 1; i < mesh.lods.size(); ++i) {
+                std::printf("  %u (%.4f)", mesh.lods[i].index_count / 3, mesh.lods[i].error);
+            }
+            std::printf("\n");
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestFlatSurfaceCollapsesWithoutError();
+    TestLodChain();
+    TestParallelBuildMatchesSerial();
+    TestNonTrianglesSkipped();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkLods();
+    }
+    return test::Result("MeshSimplifierTests");
+}
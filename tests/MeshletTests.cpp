@@ -0,0 +1,175 @@
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <vector>
+
+using namespace gfw;
+using namespace DirectX;
+
+namespace {
+    XMFLOAT3 Position(const MeshData &mesh, std::uint32_t index) {
+        XMFLOAT3 p;
+        std::memcpy(&p, mesh.vertex_data.data() + static_cast<size_t>(index) * mesh.vertex_stride, sizeof(p));
+        return p;
+    }
+
+    MeshData OptimizedSphere() {
+        MeshData mesh = test::SphereMesh(48, 96);
+        MeshOptimizer::Optimize(mesh);
+        Meshlets::Build(mesh);
+        return mesh;
+    }
+
+    void TestBuildLimitsAndCoverage() {
+        for (MeshData mesh: {test::GridMesh(40), test::SphereMesh(48, 96)}) {
+            MeshOptimizer::Optimize(mesh);
+            Meshlets::Build(mesh);
+            GFW_CHECK(!mesh.meshlets.empty());
+            std::uint32_t expected_offset = 0;
+            bool valid = true;
+            for (const Meshlet &meshlet: mesh.meshlets) {
+                const auto begin = mesh.indices.begin() + meshlet.index_offset;
+                const std::set<std::uint32_t> unique(begin, begin + meshlet.triangle_count * 3);
+                valid &= meshlet.index_offset == expected_offset;
+                valid &= meshlet.triangle_count > 0 && meshlet.triangle_count <= Meshlets::kMaxTriangles;
+                valid &= unique.size() == meshlet.vertex_count && meshlet.vertex_count <= Meshlets::kMaxVertices;
+                for (std::uint32_t index: unique) {
+                    const XMFLOAT3 p = Position(mesh, index);
+                    const float dx = p.x - meshlet.center.x;
+                    const float dy = p.y - meshlet.center.y;
+                    const float dz = p.z - meshlet.center.z;
+                    valid &= p.x >= meshlet.aabb_min.x && p.y >= meshlet.aabb_min.y && p.z >= meshlet.aabb_min.z;
+                    valid &= p.x <= meshlet.aabb_max.x && p.y <= meshlet.aabb_max.y && p.z <= meshlet.aabb_max.z;
+                    valid &= std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.radius * 1.0001f;
+                }
+                expected_offset += meshlet.triangle_count * 3;
+            }
+            GFW_CHECK(valid);
+            GFW_CHECK(expected_offset == mesh.indices.size());
+        }
+    }
+
+    struct Camera {
+        XMFLOAT3 position;
+        XMFLOAT3 target;
+    };
+
+    XMMATRIX ViewProjection(const Camera &camera) {
+        const XMMATRIX view =
+            XMMatrixLookAtLH(XMVectorSet(camera.position.x, camera.position.y, camera.position.z, 1.0f),
+                             XMVectorSet(camera.target.x, camera.target.y, camera.target.z, 1.0f),
+                             XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(1.0f, 1.5f, 0.1f, 100.0f));
+    }
+
+    // Every triangle that faces the camera (clockwise front faces, as in the GBuffer pipeline) and has a vertex
+    // inside the clip volume must be in a drawn range; returns the number that are not.
+    size_t WronglyCulled(const MeshData &mesh, const XMMATRIX &world, const Camera &camera,
+                         const std::vector<MeshletDrawRange> &ranges) {
+        std::vector<char> drawn(mesh.indices.size() / 3, 0);
+        for (const MeshletDrawRange &range: ranges) {
+            for (std::uint32_t t = range.index_offset / 3; t < (range.index_offset + range.index_count) / 3; ++t) {
+                drawn[t] = 1;
+            }
+        }
+        const XMMATRIX world_view_proj = XMMatrixMultiply(world, ViewProjection(camera));
+        XMFLOAT3 eye;
+        XMStoreFloat3(&eye, XMVector3TransformCoord(XMLoadFloat3(&camera.position), XMMatrixInverse(nullptr, world)));
+        size_t wrong = 0;
+        for (size_t t = 0; t < drawn.size(); ++t) {
+            XMFLOAT3 v[3];
+            bool inside = false;
+            for (int k = 0; k < 3; ++k) {
+                v[k] = Position(mesh, mesh.indices[t * 3 + k]);
+                XMFLOAT4 clip;
+                XMStoreFloat4(&clip, XMVector4Transform(XMVectorSet(v[k].x, v[k].y, v[k].z, 1.0f), world_view_proj));
+                inside |= clip.w > 0.0f && std::fabs(clip.x) <= clip.w && std::fabs(clip.y) <= clip.w &&
+                          clip.z >= 0.0f && clip.z <= clip.w;
+            }
+            const XMFLOAT3 e1 = {v[1].x - v[0].x, v[1].y - v[0].y, v[1].z - v[0].z};
+            const XMFLOAT3 e2 = {v[2].x - v[0].x, v[2].y - v[0].y, v[2].z - v[0].z};
+            const XMFLOAT3 n = {e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+            const float facing = n.x * (eye.x - v[0].x) + n.y * (eye.y - v[0].y) + n.z * (eye.z - v[0].z);
+            if (inside && facing > 0.0f && !drawn[t]) {
+                ++wrong;
+            }
+        }
+        return wrong;
+    }
+
+    void TestCullIsConservative() {
+        const MeshData mesh = OptimizedSphere();
+        const XMMATRIX world =
+            XMMatrixMultiply(XMMatrixScaling(2.0f, 1.0f, 3.0f), XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+        const Camera cameras[] = {
+            {{1.0f, 2.0f, -6.0f}, {1.0f, 2.0f, 3.0f}},   // whole object in view
+            {{-4.0f, 3.5f, 1.0f}, {2.0f, 2.0f, 4.0f}},   // partly outside the frustum
+            {{1.5f, 2.2f, 3.5f}, {1.0f, 2.0f, 9.0f}},    // inside the object
+            {{0.0f, 12.0f, 3.0f}, {1.0f, 2.0f, 3.1f}},   // from above
+        };
+        for (const Camera &camera: cameras) {
+            const MeshletCullView view = Meshlets::MakeCullView(world, ViewProjection(camera), camera.position);
+            for (bool cone_culling: {false, true}) {
+                std::vector<MeshletDrawRange> ranges;
+                Meshlets::Cull(mesh.meshlets, view, cone_culling, ranges);
+                GFW_CHECK(WronglyCulled(mesh, world, camera, ranges) == 0);
+            }
+        }
+
+        // From outside, the far half of the sphere faces away: cone culling removes part of it, and only it.
+        const Camera outside = cameras[0];
+        const MeshletCullView view = Meshlets::MakeCullView(world, ViewProjection(outside), outside.position);
+        std::vector<MeshletDrawRange> frustum_ranges;
+        std::vector<MeshletDrawRange> cone_ranges;
+        const std::uint32_t frustum_culled = Meshlets::Cull(mesh.meshlets, view, false, frustum_ranges);
+        const std::uint32_t cone_culled = Meshlets::Cull(mesh.meshlets, view, true, cone_ranges);
+        GFW_CHECK(frustum_culled == 0);
+        GFW_CHECK(cone_culled > mesh.meshlets.size() / 8);
+        // Neighbouring visible meshlets are merged into one range.
+        GFW_CHECK(frustum_ranges.size() == 1 && frustum_ranges[0].index_count == mesh.indices.size());
+
+        // Looking away culls everything.
+        const Camera away = {{1.0f, 2.0f, -6.0f}, {1.0f, 2.0f, -20.0f}};
+        std::vector<MeshletDrawRange> none;
+        const MeshletCullView away_view = Meshlets::MakeCullView(world, ViewProjection(away), away.position);
+        GFW_CHECK(Meshlets::Cull(mesh.meshlets, away_view, true, none) == mesh.meshlets.size() && none.empty());
+    }
+
+    void BenchmarkCull() {
+        MeshData mesh = test::SphereMesh(512, 1024);
+        MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertex_count);
+        Meshlets::Build(mesh);
+        const XMMATRIX world = XMMatrixIdentity();
+        const Camera camera = {{0.3f, 0.2f, -2.5f}, {0.6f, 0.0f, 0.0f}};
+        const MeshletCullView view = Meshlets::MakeCullView(world, ViewProjection(camera), camera.position);
+        std::vector<MeshletDrawRange> ranges;
+        for (bool cone_culling: {false, true}) {
+            constexpr int kIterations = 50;
+            std::uint32_t culled = 0;
+            const double ms = test::MeasureMs([&] {
+                for (int i = 0; i < kIterations; ++i) {
+                    ranges.clear();
+                    culled = Meshlets::Cull(mesh.meshlets, view, cone_culling, ranges);
+                }
+            }) / kIterations;
+            std::printf("meshlet cull (%s): %zu meshlets, %u culled, %zu ranges, %.3f ms, %.0f meshlets/ms, "
+                        "%.0f culled/ms\n", cone_culling ? "frustum + cone" : "frustum", mesh.meshlets.size(), culled,
+                        ranges.size(), ms, static_cast<double>(mesh.meshlets.size()) / ms, culled / ms);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestBuildLimitsAndCoverage();
+    TestCullIsConservative();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkCull();
+    }
+    return test::Result("MeshletTests");
+}
@@ -0,0 +1,316 @@
+#include "TestHarness.h"
+#include "CubeMesh.h"
+#include "RenderingSystem.h"
+#include "framework/NullRenderBackend.h"
+#include "framework/NullRenderDevice.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    constexpr std::uint32_t kWidth = 320;
+    constexpr std::uint32_t kHeight = 180;
+
+    MeshData CubeData() {
+        MeshData data = CubeMesh::CreateUnit().ToMeshData();
+        data.bounds_min = {-1.0f, -1.0f, -1.0f};
+        data.bounds_max = {1.0f, 1.0f, 1.0f};
+        return data;
+    }
+
+    // Runs empty frames until everything released before them has retired.
+    void RetireFrames(NullRenderDevice &device) {
+        for (std::uint32_t i = 0; i <= device.GetFramesInFlight(); ++i) {
+            device.BeginFrame();
+            device.EndFrame();
+        }
+    }
+
+    void TestCommandStreamRoundTrip() {
+        RecordingCommandList list;
+        list.SetPipeline(PipelineHandle{7});
+        list.SetConstantBuffer(0, 0x1000);
+        list.DrawIndexed(36, 6, -2);
+        list.Draw(3, 0);
+        const CommandStream &stream = list.Stream();
+        GFW_CHECK(stream.CommandCount() == 4 && stream.DrawCount() == 2);
+
+        std::vector<CommandOp> ops;
+        CommandStream::DrawPacket indexed = {};
+        stream.ForEach([&](CommandOp op, const std::uint8_t *payload, std::size_t size) {
+            ops.push_back(op);
+            if (op == CommandOp::DrawIndexed && size == sizeof(indexed)) {
+                std::memcpy(&indexed, payload, sizeof(indexed));
+            }
+        });
+        GFW_CHECK((ops == std::vector<CommandOp>{CommandOp::SetPipeline, CommandOp::SetConstantBuffer,
+                                                 CommandOp::DrawIndexed, CommandOp::Draw}));
+        GFW_CHECK(indexed.count == 36 && indexed.first == 6 && indexed.base_vertex == -2);
+
+        CommandStream copy;
+        GFW_CHECK(copy.Assign(stream.Data(), stream.SizeBytes()));
+        GFW_CHECK(copy.CommandCount() == 4 && copy.DrawCount() == 2 && copy.SizeBytes() == stream.SizeBytes());
+        copy.Append(stream);
+        GFW_CHECK(copy.CommandCount() == 8 && copy.DrawCount() == 4 && copy.SizeBytes() == 2 * stream.SizeBytes());
+
+        // A cut-off packet is rejected and leaves the stream empty.
+        GFW_CHECK(!copy.Assign(stream.Data(), stream.SizeBytes() - 1));
+        GFW_CHECK(copy.CommandCount() == 0 && copy.DrawCount() == 0 && copy.SizeBytes() == 0);
+    }
+
+    void TestSimulatedFenceLatency() {
+        SimulatedFence immediate(0);
+        immediate.Signal(1);
+        GFW_CHECK(immediate.CompletedValue() == 1);
+
+        SimulatedFence fence(2);
+        fence.Signal(1);
+        fence.Signal(2);
+        GFW_CHECK(fence.CompletedValue() == 0);
+        fence.Signal(3);
+        GFW_CHECK(fence.CompletedValue() == 1);
+        // Waiting completes up to the value and no further.
+        fence.Signal(4);
+        fence.Wait(3);
+        GFW_CHECK(fence.CompletedValue() == 3);
+        fence.Wait(10);
+        GFW_CHECK(fence.CompletedValue() == 4);
+    }
+
+    void TestCreationValidatesLikeD3D12() {
+        NullRenderDevice device;
+        GFW_CHECK(device.Initialize(kWidth, kHeight));
+        GFW_CHECK(device.GetBackend() == RenderBackend::Null && device.GetWidth() == kWidth);
+
+        std::set<std::uint64_t> handles;
+        for (int i = 0; i < 16; ++i) {
+            handles.insert(device.CreateTexture({64, 64, Format::R16G16B16A16Float, true}).value);
+        }
+        GFW_CHECK(handles.size() == 16 && handles.count(0) == 0);
+        GFW_CHECK(!device.CreateTexture({0, 64, Format::R8G8B8A8Unorm}));
+        GFW_CHECK(!device.CreateTexture({64, 64, Format::Unknown}));
+
+        const DescriptorHeapHandle heap = device.CreateDescriptorHeap(DescriptorHeapType::RenderTarget, 2);
+        GFW_CHECK(heap && !device.CreateDescriptorHeap(DescriptorHeapType::RenderTarget, 0));
+        GFW_CHECK(device.GetCpuDescriptor(heap, 0).value != device.GetCpuDescriptor(heap, 1).value);
+        GFW_CHECK(device.CreateRenderTargetView(heap, 0, ResourceHandle{*handles.begin()}, Format::R8G8B8A8Unorm));
+        GFW_CHECK(!device.CreateRenderTargetView(heap, 1, ResourceHandle{}, Format::R8G8B8A8Unorm));
+
+        RootSignatureDesc empty_table;
+        empty_table.table_size = 0;
+        GFW_CHECK(!device.CreateRootSignature(empty_table));
+        const RootSignatureHandle root_signature = device.CreateRootSignature({});
+        GFW_CHECK(root_signature);
+
+        PipelineDesc desc;
+        desc.root_signature = root_signature;
+        GFW_CHECK(!device.CreatePipeline(desc));
+        desc.vs = {"Geometry.hlsl", "VSMain", "vs_5_0"};
+        GFW_CHECK(device.CreatePipeline(desc));
+        desc.primitive = PrimitiveType::Patch;
+        GFW_CHECK(!device.CreatePipeline(desc));
+        desc.hs = {"Geometry.hlsl", "HSMain", "hs_5_0"};
+        desc.ds = {"Geometry.hlsl", "DSMain", "ds_5_0"};
+        GFW_CHECK(device.CreatePipeline(desc));
+        desc.root_signature = {};
+        GFW_CHECK(!device.CreatePipeline(desc));
+    }
+
+    void TestUploadRing() {
+        NullRenderDevice device;
+        GFW_CHECK(device.Initialize(kWidth, kHeight));
+        const std::vector<std::uint8_t> constants(4096, 1);
+        bool aligned = true;
+        bool nonzero = true;
+        // A frame of more than the whole ring still gets distinct addresses: the ring grows.
+        const std::uint32_t count = NullRenderDevice::kUploadRingSize / constants.size() * 3;
+        for (int frame = 0; frame < 8; ++frame) {
+            device.BeginFrame();
+            std::set<GpuAddress> addresses;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const GpuAddress address =
+                    device.UploadConstants(constants.data(), static_cast<std::uint32_t>(constants.size()));
+                aligned &= address % 256 == 0;
+                nonzero &= address != 0;
+                addresses.insert(address);
+            }
+            GFW_CHECK(addresses.size() == count);
+            device.EndFrame();
+        }
+        GFW_CHECK(aligned && nonzero);
+    }
+
+    void TestMeshBuffers() {
+        NullRenderDevice device;
+        GFW_CHECK(device.Initialize(kWidth, kHeight));
+        const MeshData data = CubeData();
+        std::unique_ptr<MeshBuffers> mesh = device.CreateMeshBuffers(data);
+        GFW_CHECK(mesh != nullptr);
+        if (!mesh) {
+            return;
+        }
+        GFW_CHECK(mesh->vertex_buffer && mesh->index_buffer && mesh->vertex_buffer != mesh->index_buffer);
+        GFW_CHECK(mesh->vertex_count == 24 && mesh->index_count == 36);
+        GFW_CHECK(mesh->vertex_buffer_view.address != 0 && mesh->vertex_buffer_view.stride == data.vertex_stride);
+        GFW_CHECK(mesh->vertex_buffer_view.size == data.VertexByteSize());
+        // 24 vertices fit 16-bit indices.
+        GFW_CHECK(mesh->index_buffer_view.format == IndexFormat::Uint16 && mesh->index_buffer_view.size == 72);
+        GFW_CHECK(std::fabs(mesh->bounds_radius - std::sqrt(3.0f)) < 1e-5f);
+
+        GFW_CHECK(!device.CreateMeshBuffers(MeshData{}));
+        device.ReleaseMeshBuffers(*mesh);
+        GFW_CHECK(!mesh->vertex_buffer && !mesh->index_buffer);
+    }
+
+    void TestReleaseWaitsForFrames() {
+        NullRenderDevice device;
+        GFW_CHECK(device.Initialize(kWidth, kHeight));
+        const std::size_t baseline = device.LiveObjectCount();
+
+        std::unique_ptr<MeshBuffers> mesh = device.CreateMeshBuffers(CubeData());
+        std::shared_ptr<Texture2D> texture = device.CreateSolidTexture({1.0f, 0.0f, 0.0f, 1.0f});
+        RootSignatureObject root_signature(&device, device.CreateRootSignature({}));
+        GFW_CHECK(device.LiveObjectCount() == baseline + 4);
+        GFW_CHECK(device.GetBindlessIndex(texture.get()) == texture->srv.index);
+
+        // Released during a frame, the objects live until that frame has completed.
+        device.BeginFrame();
+        device.ReleaseMeshBuffers(*mesh);
+        device.ReleaseTexture(texture);
+        RootSignatureObject moved = std::move(root_signature);
+        GFW_CHECK(!root_signature && moved);
+        moved.Reset();
+        GFW_CHECK(!moved);
+        device.EndFrame();
+        GFW_CHECK(device.LiveObjectCount() == baseline + 4);
+        RetireFrames(device);
+        GFW_CHECK(device.LiveObjectCount() == baseline);
+        GFW_CHECK(device.GetBindlessIndex(texture.get()) != texture->srv.index);
+
+        // Releasing twice or releasing a null handle changes nothing.
+        device.Release(ResourceHandle{});
+        device.Release(mesh->vertex_buffer);
+        RetireFrames(device);
+        GFW_CHECK(device.LiveObjectCount() == baseline);
+    }
+
+    void TestBindlessSlotsGrow() {
+        NullRenderDevice device;
+        GFW_CHECK(device.Initialize(kWidth, kHeight));
+        std::vector<std::shared_ptr<Texture2D>> textures;
+        std::set<std::uint32_t> indices;
+        for (std::uint32_t i = 0; i < NullRenderDevice::kInitialBindlessDescriptors + 64; ++i) {
+            textures.push_back(device.CreateSolidTexture({1.0f, 1.0f, 1.0f, 1.0f}));
+            if (textures.back()) {
+                indices.insert(device.GetBindlessIndex(textures.back().get()));
+            }
+        }
+        GFW_CHECK(indices.size() == textures.size());
+        GFW_CHECK(!device.CreateTextureFromFile(L"missing/texture.png"));
+    }
+
+    // The whole renderer on the null device: every visible object is one draw, plus the lighting pass.
+    void TestRenderingSystemFrames() {
+        NullRenderDevice device;
+        GFW_CHECK(device.Initialize(kWidth, kHeight));
+        const std::size_t baseline = device.LiveObjectCount();
+        std::unique_ptr<MeshBuffers> cube = device.CreateMeshBuffers(CubeData());
+        GFW_CHECK(cube != nullptr);
+        if (!cube) {
+            return;
+        }
+
+        std::vector<RenderObject> objects(9);
+        for (std::size_t i = 0; i < objects.size(); ++i) {
+            objects[i].mesh = cube.get();
+            const float x = static_cast<float>(i % 3) * 3.0f - 3.0f;
+            const float z = static_cast<float>(i / 3) * 3.0f;
+            DirectX::XMStoreFloat4x4(&objects[i].world, DirectX::XMMatrixTranslation(x, 0.0f, z));
+        }
+        // One object far behind the camera.
+        DirectX::XMStoreFloat4x4(&objects.back().world, DirectX::XMMatrixTranslation(0.0f, 0.0f, -50.0f));
+        Camera camera;
+        camera.position = {0.0f, 4.0f, -12.0f};
+        camera.target = {0.0f, 0.0f, 3.0f};
+        device.SetCamera(camera);
+
+        {
+            RenderingSystem rendering;
+            GFW_CHECK(rendering.Initialize(&device, kWidth, kHeight));
+            rendering.PrewarmPipelines(objects);
+            GFW_CHECK(rendering.FinishPipelineStartup());
+            std::size_t live_objects = 0;
+            std::size_t draws = 0;
+            for (int frame = 0; frame < 6; ++frame) {
+                if (frame == 5) {
+                    device.CaptureNextFrame(L"");
+                }
+                device.BeginFrame();
+                rendering.Render(objects, static_cast<float>(frame) / 60.0f);
+                device.EndFrame();
+                const RenderingSystem::FrustumCullStats stats = rendering.GetFrustumCullStats();
+                GFW_CHECK(stats.objects == objects.size() && stats.visible == objects.size() - 1);
+                draws = device.GetSubmittedCommands().DrawCount();
+                GFW_CHECK(draws == stats.visible + 1);
+                // Pipelines are created once; steady frames create nothing.
+                GFW_CHECK(frame < 2 || device.LiveObjectCount() == live_objects);
+                live_objects = device.LiveObjectCount();
+            }
+
+            const CommandCapture &capture = device.GetLastCapture();
+            GFW_CHECK(capture.Stream().DrawCount() == draws);
+            GFW_CHECK(device.ReplayCapture(capture, 3));
+            GFW_CHECK(device.GetSubmittedCommands().DrawCount() == draws);
+            rendering.Shutdown();
+        }
+        device.ReleaseMeshBuffers(*cube);
+        RetireFrames(device);
+        GFW_CHECK(device.LiveObjectCount() == baseline);
+    }
+
+    void BenchmarkFrames() {
+        NullRenderDevice device;
+        device.Initialize(kWidth, kHeight);
+        const std::vector<std::uint8_t> constants(512, 1);
+        constexpr int kFrames = 1000;
+        constexpr int kUploads = 1000;
+        const double ms = test::MeasureMs([&] {
+            for (int frame = 0; frame < kFrames; ++frame) {
+                device.BeginFrame();
+                for (int i = 0; i < kUploads; ++i) {
+                    device.UploadConstants(constants.data(), static_cast<std::uint32_t>(constants.size()));
+                    device.GetRecorder().DrawIndexed(36, 0, 0);
+                }
+                device.EndFrame();
+            }
+        });
+        std::printf("Null device: %d frames of %d uploads and draws in %.2f ms (%.1f ns per draw)\n", kFrames,
+                    kUploads, ms, ms * 1e6 / (kFrames * kUploads));
+    }
+}
+
+int main(int argc, char **argv) {
+    // NullRenderDevice logs through wcout and wcerr, and a C stream takes the orientation of its first write. Fix
+    // both as byte streams up front so check failures are not lost after a wide log line.
+    std::fwide(stdout, -1);
+    std::fwide(stderr, -1);
+    TestCommandStreamRoundTrip();
+    TestSimulatedFenceLatency();
+    TestCreationValidatesLikeD3D12();
+    TestUploadRing();
+    TestMeshBuffers();
+    TestReleaseWaitsForFrames();
+    TestBindlessSlotsGrow();
+    TestRenderingSystemFrames();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkFrames();
+    }
+    return test::Result("NullRenderBackendTests");
+}
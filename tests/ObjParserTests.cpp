@@ -0,0 +1,179 @@
+#include "LegacyObjLoader.h"
+#include "MeshLoader.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace gfw;
+
+namespace {
+    struct Vertex {
+        float px, py, pz;
+        float nx, ny, nz;
+        float u, v;
+    };
+
+    Vertex VertexAt(const MeshData &mesh, std::uint32_t index) {
+        Vertex vertex;
+        std::memcpy(&vertex, mesh.vertex_data.data() + static_cast<size_t>(index) * mesh.vertex_stride,
+                    sizeof(vertex));
+        return vertex;
+    }
+
+    // Compares what both loaders fill; bounds are the new loader's addition.
+    bool SameModel(const ObjModelData &a, const ObjModelData &b) {
+        if (a.submeshes.size() != b.submeshes.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.submeshes.size(); ++i) {
+            const ObjSubmeshData &x = a.submeshes[i];
+            const ObjSubmeshData &y = b.submeshes[i];
+            if (x.material_name != y.material_name || x.diffuse_texture_path != y.diffuse_texture_path ||
+                std::memcmp(&x.albedo, &y.albedo, sizeof(x.albedo)) != 0 ||
+                x.mesh.vertex_count != y.mesh.vertex_count || x.mesh.vertex_stride != y.mesh.vertex_stride ||
+                x.mesh.vertex_data != y.mesh.vertex_data || x.mesh.indices != y.mesh.indices) {
+                std::fprintf(stderr, "submesh %zu differs\n", i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestHandWrittenFile(const std::filesystem::path &dir) {
+        const auto obj = dir / "hand.obj";
+        GFW_CHECK(test::WriteTextFile(obj, "# two faces\n"
+                                           "v 100 200 300\nv 200 200 300\nv 200 300 300\nv 100 300 300\n"
+                                           "vt 0 0\nvt 1 0.25\nvn 0 0 1\n"
+                                           "f 1/1/1 2/2/1 3/2/1\n"
+                                           "usemtl second\n"
+                                           "f -4//-1 -3//-1 -2//-1 -1//-1\n"));
+        const ObjModelData model = MeshLoader::LoadObjModel(obj.wstring());
+        if (!GFW_CHECK(model.submeshes.size() == 2)) {
+            return;
+        }
+        const MeshData &first = model.submeshes[0].mesh;
+        GFW_CHECK(model.submeshes[0].material_name == L"default");
+        GFW_CHECK(model.submeshes[1].material_name == L"second");
+        GFW_CHECK(first.vertex_stride == sizeof(Vertex));
+        GFW_CHECK(first.vertex_count == 3);
+        // Corners are read (0, 2, 1) to flip the winding along with the mirrored z axis, so the file's third
+        // vertex is the second one emitted. Positions are scaled by 0.01 and v is flipped.
+        GFW_CHECK((first.indices == std::vector<std::uint32_t>{0, 1, 2}));
+        const Vertex v0 = VertexAt(first, 0);
+        const Vertex v1 = VertexAt(first, 1);
+        const Vertex v2 = VertexAt(first, 2);
+        GFW_CHECK(v0.px == 100 * 0.01f && v0.py == 200 * 0.01f && v0.pz == -(300 * 0.01f));
+        GFW_CHECK(v0.nx == 0.0f && v0.nz == -1.0f);
+        GFW_CHECK(v0.u == 0.0f && v0.v == 1.0f);
+        GFW_CHECK(v1.px == 200 * 0.01f && v1.py == 300 * 0.01f && v1.u == 1.0f && v1.v == 0.75f);
+        GFW_CHECK(v2.px == 200 * 0.01f && v2.py == 200 * 0.01f);
+        GFW_CHECK(first.bounds_radius > 0.0f);
+
+        // The quad is fanned into two triangles sharing its first corner; uvs are absent and stay zero.
+        const MeshData &second = model.submeshes[1].mesh;
+        GFW_CHECK(second.vertex_count == 4);
+        GFW_CHECK(second.indices.size() == 6);
+        GFW_CHECK(VertexAt(second, 0).u == 0.0f && VertexAt(second, 0).v == 0.0f);
+    }
+
+    void TestMatchesLegacyLoader(const std::filesystem::path &dir) {
+        const auto obj = dir / "synthetic.obj";
+        const auto mtl = dir / "synthetic.mtl";
+        GFW_CHECK(test::WriteTextFile(obj, test::SyntheticObj(96, 3)));
+        GFW_CHECK(test::WriteTextFile(mtl, test::SyntheticMtl(3)));
+        const ObjModelData legacy = test::LoadObjModelLegacy(obj.wstring(), L"synthetic.mtl");
+        const ObjModelData model = MeshLoader::LoadObjModel(obj.wstring(), L"synthetic.mtl", 1);
+        GFW_CHECK(legacy.submeshes.size() == 4);
+        GFW_CHECK(SameModel(legacy, model));
+        GFW_CHECK(!model.submeshes.empty() &&
+                  model.submeshes.back().diffuse_texture_path.ends_with(L"textures/t2.png"));
+    }
+
+    // Files above 4 MB per thread are split into newline-aligned chunks parsed concurrently; the merge has to
+    // resolve negative indices and submesh order exactly like the serial parse, whatever the split.
+    void TestParallelParseMatchesSerial(const std::filesystem::path &dir) {
+        const auto obj = dir / "parallel.obj";
+        GFW_CHECK(test::WriteTextFile(obj, test::SyntheticObj(380, 5)));
+        GFW_CHECK(test::WriteTextFile(dir / "synthetic.mtl", test::SyntheticMtl(5)));
+        GFW_CHECK(std::filesystem::file_size(obj) > 16u << 20);
+        const ObjModelData serial = MeshLoader::LoadObjModel(obj.wstring(), L"synthetic.mtl", 1);
+        GFW_CHECK(serial.submeshes.size() == 6);
+        for (unsigned threads: {2u, 3u, 4u, 16u}) {
+            const ObjModelData parallel = MeshLoader::LoadObjModel(obj.wstring(), L"synthetic.mtl", threads);
+            GFW_CHECK(SameModel(serial, parallel));
+        }
+    }
+
+    void TestMissingFile(const std::filesystem::path &dir) {
+        GFW_CHECK(MeshLoader::LoadObjModel((dir / "missing.obj").wstring()).submeshes.empty());
+    }
+
+    void BenchmarkParser(const std::filesystem::path &dir) {
+        const auto obj = dir / "benchmark.obj";
+        const std::string text = test::SyntheticObj(800, 8);
+        test::WriteTextFile(obj, text);
+        test::WriteTextFile(dir / "synthetic.mtl", test::SyntheticMtl(8));
+        const double megabytes = static_cast<double>(text.size()) / (1024.0 * 1024.0);
+
+        ObjModelData legacy;
+        ObjModelData model;
+        const double legacy_ms = test::MeasureMs([&] {
+            legacy = test::LoadObjModelLegacy(obj.wstring(), L"synthetic.mtl");
+        });
+        const double model_ms = test::MeasureMs([&] {
+            model = MeshLoader::LoadObjModel(obj.wstring(), L"synthetic.mtl", 1);
+        });
+        size_t triangles = 0;
+        for (const ObjSubmeshData &sub: model.submeshes) {
+            triangles += sub.mesh.indices.size() / 3;
+        }
+        GFW_CHECK(SameModel(legacy, model));
+        const auto report = [&](const char *name, double ms) {
+            std::printf("%-8s %8.1f ms %8.1f MB/s %8.2f Mtri/s\n", name, ms, megabytes * 1000.0 / ms,
+                        static_cast<double>(triangles) / (ms * 1000.0));
+        };
+        std::printf("OBJ parse, %.1f MB, %zu triangles, 1 thread\n", megabytes, triangles);
+        report("legacy", legacy_ms);
+        report("current", model_ms);
+    }
+
+    void BenchmarkParallelScaling(const std::filesystem::path &dir) {
+        const auto obj = dir / "scaling.obj";
+        const std::string text = test::SyntheticObj(1400, 8);
+        test::WriteTextFile(obj, text);
+        test::WriteTextFile(dir / "synthetic.mtl", test::SyntheticMtl(8));
+        const double megabytes = static_cast<double>(text.size()) / (1024.0 * 1024.0);
+        std::printf("OBJ parse scaling, %.1f MB, %u hardware threads\n", megabytes,
+                    std::thread::hardware_concurrency());
+        ObjModelData serial;
+        for (unsigned threads: {1u, 2u, 4u, 8u, 16u}) {
+            ObjModelData model;
+            const double ms = test::MeasureMs([&] {
+                model = MeshLoader::LoadObjModel(obj.wstring(), L"synthetic.mtl", threads);
+            });
+            if (threads == 1) {
+                serial = std::move(model);
+            } else {
+                GFW_CHECK(SameModel(serial, model));
+            }
+            std::printf("%2u threads %8.1f ms %8.1f MB/s\n", threads, ms, megabytes * 1000.0 / ms);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const auto dir = test::ScratchDirectory("gfw_obj_parser_tests");
+    TestHandWrittenFile(dir);
+    TestMatchesLegacyLoader(dir);
+    TestParallelParseMatchesSerial(dir);
+    TestMissingFile(dir);
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkParser(dir);
+        BenchmarkParallelScaling(dir);
+    }
+    return test::Result("ObjParserTests");
+}
@@ -0,0 +1,456 @@
+#include "OcclusionCuller.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+using namespace gfw;
+using namespace DirectX;
+
+namespace {
+    constexpr float kFovY = 1.0f;
+    constexpr std::uint32_t kWidth = 128;
+    constexpr std::uint32_t kHeight = 72;
+
+    struct Occluder {
+        const OccluderMesh *mesh;
+        XMFLOAT4X4 world;
+    };
+
+    struct Camera {
+        XMFLOAT3 eye;
+        XMFLOAT4X4 view_proj;
+    };
+
+    // Looking down +z from eye, so camera right and up are world x and y.
+    Camera MakeCamera(XMFLOAT3 eye) {
+        const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f),
+                                               XMVectorSet(eye.x, eye.y, eye.z + 1.0f, 1.0f),
+                                               XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        Camera camera = {eye, {}};
+        XMStoreFloat4x4(&camera.view_proj,
+                        XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(kFovY, static_cast<float>(kWidth) / kHeight,
+                                                                        0.1f, 500.0f)));
+        return camera;
+    }
+
+    // Maps world x, y straight to pixel coordinates and z to depth.
+    XMFLOAT4X4 PixelViewProj(std::uint32_t width, std::uint32_t height) {
+        XMFLOAT4X4 m = {};
+        m._11 = 2.0f / static_cast<float>(width);
+        m._22 = -2.0f / static_cast<float>(height);
+        m._33 = 1.0f;
+        m._41 = -1.0f;
+        m._42 = 1.0f;
+        m._44 = 1.0f;
+        return m;
+    }
+
+    // Scaled, then rolled about z, then turned about y, then moved to position.
+    XMFLOAT4X4 Place(XMFLOAT3 position, XMFLOAT3 scale, float roll, float yaw) {
+        const float cr = std::cos(roll), sr = std::sin(roll), cy = std::cos(yaw), sy = std::sin(yaw);
+        XMFLOAT4X4 m = {};
+        const float rows[3][3] = {{cr * cy, sr, -cr * sy}, {-sr * cy, cr, sr * sy}, {sy, 0.0f, cy}};
+        const float scales[3] = {scale.x, scale.y, scale.z};
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                m.m[r][c] = rows[r][c] * scales[r];
+            }
+        }
+        m._41 = position.x;
+        m._42 = position.y;
+        m._43 = position.z;
+        m._44 = 1.0f;
+        return m;
+    }
+
+    OccluderMesh UnitBox() {
+        OccluderMesh mesh;
+        for (int corner = 0; corner < 8; ++corner) {
+            mesh.positions.push_back({corner & 1 ? 0.5f : -0.5f, corner & 2 ? 0.5f : -0.5f, corner & 4 ? 0.5f : -0.5f});
+        }
+        const std::uint32_t faces[6][4] = {{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1},
+                                           {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+        for (const auto &face : faces) {
+            mesh.indices.insert(mesh.indices.end(), {face[0], face[1], face[2], face[0], face[2], face[3]});
+        }
+        return mesh;
+    }
+
+    // Unit quad in the xy plane split into cells * cells squares of two triangles each.
+    OccluderMesh Grid(std::uint32_t cells) {
+        OccluderMesh mesh;
+        for (std::uint32_t y = 0; y <= cells; ++y) {
+            for (std::uint32_t x = 0; x <= cells; ++x) {
+                mesh.positions.push_back({static_cast<float>(x) / cells - 0.5f, static_cast<float>(y) / cells - 0.5f,
+                                          0.0f});
+            }
+        }
+        for (std::uint32_t y = 0; y < cells; ++y) {
+            for (std::uint32_t x = 0; x < cells; ++x) {
+                const std::uint32_t a = y * (cells + 1) + x;
+                const std::uint32_t c = a + cells + 1;
+                mesh.indices.insert(mesh.indices.end(), {a, a + 1, c + 1, a, c + 1, c});
+            }
+        }
+        return mesh;
+    }
+
+    XMFLOAT3 TransformPoint(const XMFLOAT3 &p, const XMFLOAT4X4 &m) {
+        return {p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41, p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+                p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43};
+    }
+
+    using WorldTriangle = std::array<XMFLOAT3, 3>;
+
+    std::vector<WorldTriangle> WorldTriangles(const std::vector<Occluder> &occluders) {
+        std::vector<WorldTriangle> triangles;
+        for (const Occluder &occluder : occluders) {
+            const OccluderMesh &mesh = *occluder.mesh;
+            for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+                triangles.push_back({TransformPoint(mesh.positions[mesh.indices[i]], occluder.world),
+                                     TransformPoint(mesh.positions[mesh.indices[i + 1]], occluder.world),
+                                     TransformPoint(mesh.positions[mesh.indices[i + 2]], occluder.world)});
+            }
+        }
+        return triangles;
+    }
+
+    // Whether the segment from eye to p passes through a triangle, in double precision. Edges count as hits so
+    // that rays between two triangles of a mesh do not slip through; that only makes the reference cull more.
+    bool Blocked(const XMFLOAT3 &eye, const XMFLOAT3 &p, const std::vector<WorldTriangle> &triangles) {
+        const double d[3] = {double{p.x} - eye.x, double{p.y} - eye.y, double{p.z} - eye.z};
+        for (const WorldTriangle &triangle : triangles) {
+            const double a[3] = {triangle[0].x, triangle[0].y, triangle[0].z};
+            const double e1[3] = {triangle[1].x - a[0], triangle[1].y - a[1], triangle[1].z - a[2]};
+            const double e2[3] = {triangle[2].x - a[0], triangle[2].y - a[1], triangle[2].z - a[2]};
+            const double h[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+            const double det = e1[0] * h[0] + e1[1] * h[1] + e1[2] * h[2];
+            if (std::abs(det) < 1e-12) {
+                continue;
+            }
+            const double s[3] = {eye.x - a[0], eye.y - a[1], eye.z - a[2]};
+            const double u = (s[0] * h[0] + s[1] * h[1] + s[2] * h[2]) / det;
+            const double q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+            const double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+            const double t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+            if (u >= -1e-9 && v >= -1e-9 && u + v <= 1.0 + 1e-9 && t > 0.0 && t < 1.0 - 1e-9) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Brute-force visibility: an object is visible when an unblocked ray reaches one of the points of a grid over
+    // each face of its box. Points between the samples are missed, so the reference errs towards hidden.
+    bool ReferenceVisible(const Camera &camera, const SceneBvh::Bounds &bounds,
+                          const std::vector<WorldTriangle> &triangles) {
+        constexpr int kSamples = 6;
+        const float lo[3] = {bounds.min.x, bounds.min.y, bounds.min.z};
+        const float hi[3] = {bounds.max.x, bounds.max.y, bounds.max.z};
+        for (int axis = 0; axis < 3; ++axis) {
+            const int u_axis = (axis + 1) % 3;
+            const int v_axis = (axis + 2) % 3;
+            for (const float side : {lo[axis], hi[axis]}) {
+                for (int i = 0; i < kSamples; ++i) {
+                    for (int j = 0; j < kSamples; ++j) {
+                        float p[3];
+                        p[axis] = side;
+                        p[u_axis] = lo[u_axis] + (hi[u_axis] - lo[u_axis]) * static_cast<float>(i) / (kSamples - 1);
+                        p[v_axis] = lo[v_axis] + (hi[v_axis] - lo[v_axis]) * static_cast<float>(j) / (kSamples - 1);
+                        if (!Blocked(camera.eye, {p[0], p[1], p[2]}, triangles)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    struct Scene {
+        Camera camera;
+        std::vector<Occluder> occluders;
+        std::vector<SceneBvh::Bounds> bounds;
+    };
+
+    // Walls split into several triangles and rolled boxes in front, scattered boxes behind them, and slivers
+    // thinner than a pixel placed within a pixel or two of an occluder edge, at and behind its depth.
+    Scene MakeScene(std::uint32_t seed, const OccluderMesh &box, const OccluderMesh &wall) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        const auto between = [&](float lo, float hi) { return lo + (hi - lo) * (unit(rng) * 0.5f + 0.5f); };
+        Scene scene;
+        scene.camera = MakeCamera({unit(rng) * 2.0f, 2.0f + unit(rng), 0.0f});
+        for (int i = 0; i < 12; ++i) {
+            const XMFLOAT3 position = {unit(rng) * 14.0f, between(0.0f, 4.0f), between(15.0f, 40.0f)};
+            if (i % 2 == 0) {
+                scene.occluders.push_back({&wall, Place(position, {between(3.0f, 10.0f), between(2.0f, 6.0f), 1.0f},
+                                                        unit(rng) * 0.4f, unit(rng) * 0.8f)});
+            } else {
+                scene.occluders.push_back({&box, Place(position, {between(1.0f, 4.0f), between(2.0f, 8.0f),
+                                                                  between(1.0f, 4.0f)},
+                                                       unit(rng) * 0.6f, unit(rng) * 3.0f)});
+            }
+        }
+
+        for (int i = 0; i < 1000; ++i) {
+            const XMFLOAT3 center = {unit(rng) * 20.0f, between(-2.0f, 6.0f), between(20.0f, 80.0f)};
+            const XMFLOAT3 extent = {between(0.1f, 1.5f), between(0.1f, 1.5f), between(0.1f, 1.5f)};
+            scene.bounds.push_back({{center.x - extent.x, center.y - extent.y, center.z - extent.z},
+                                    {center.x + extent.x, center.y + extent.y, center.z + extent.z}});
+        }
+
+        const std::vector<WorldTriangle> triangles = WorldTriangles(scene.occluders);
+        const XMFLOAT3 &eye = scene.camera.eye;
+        for (int i = 0; i < 1500; ++i) {
+            const WorldTriangle &triangle = triangles[rng() % triangles.size()];
+            const int edge = static_cast<int>(rng() % 3);
+            const XMFLOAT3 &a = triangle[edge];
+            const XMFLOAT3 &b = triangle[(edge + 1) % 3];
+            const float along = between(0.0f, 1.0f);
+            XMFLOAT3 p = {a.x + (b.x - a.x) * along, a.y + (b.y - a.y) * along, a.z + (b.z - a.z) * along};
+            // Up to two pixels to either side on screen, then up to 8 units further away along the view ray.
+            const float distance = p.z - eye.z;
+            const float pixel = 2.0f * distance * std::tan(0.5f * kFovY) / static_cast<float>(kHeight);
+            p.x += unit(rng) * 2.0f * pixel;
+            p.y += unit(rng) * 2.0f * pixel;
+            const float scale = 1.0f + between(0.0f, 8.0f) / distance;
+            p = {eye.x + (p.x - eye.x) * scale, eye.y + (p.y - eye.y) * scale, eye.z + (p.z - eye.z) * scale};
+            // A sliver a tenth of a pixel thin across at least one screen axis.
+            const float thin = 0.1f * pixel * scale;
+            XMFLOAT3 extent = {between(0.01f, 1.0f), between(0.01f, 1.0f), between(0.01f, 1.0f)};
+            (rng() % 2 ? extent.x : extent.y) = thin;
+            scene.bounds.push_back({{p.x - extent.x, p.y - extent.y, p.z - extent.z},
+                                    {p.x + extent.x, p.y + extent.y, p.z + extent.z}});
+        }
+        return scene;
+    }
+
+    std::vector<std::uint32_t> Cull(OcclusionCuller &culler, const Scene &scene, unsigned threads) {
+        culler.Resize(kWidth, kHeight);
+        culler.BeginFrame(scene.camera.view_proj);
+        for (const Occluder &occluder : scene.occluders) {
+            culler.AddOccluder(*occluder.mesh, occluder.world);
+        }
+        culler.Rasterize(threads);
+        std::vector<std::uint32_t> objects(scene.bounds.size());
+        for (std::uint32_t i = 0; i < objects.size(); ++i) {
+            objects[i] = i;
+        }
+        culler.Cull(scene.bounds, objects, threads);
+        return objects;
+    }
+
+    // Only pixels entirely inside a triangle, or a quad drawn as one, are written.
+    void TestInnerCoverage() {
+        OcclusionCuller culler;
+        culler.Resize(32, 32);
+        XMFLOAT4X4 identity;
+        XMStoreFloat4x4(&identity, XMMatrixIdentity());
+        const auto draw = [&](std::initializer_list<const OccluderMesh *> meshes) {
+            culler.BeginFrame(PixelViewProj(32, 32));
+            for (const OccluderMesh *mesh : meshes) {
+                culler.AddOccluder(*mesh, identity);
+            }
+            culler.Rasterize(1);
+            return culler.Depth();
+        };
+        // Pixel [x, x + 1] * [y, y + 1] holds the expected depth, or 1 where expected returns a negative one.
+        const auto matches = [](const std::vector<float> &depth, auto expected) {
+            bool same = true;
+            for (std::uint32_t y = 0; y < 32; ++y) {
+                for (std::uint32_t x = 0; x < 32; ++x) {
+                    const float z = expected(x, y);
+                    same &= std::abs(depth[y * 32 + x] - (z < 0.0f ? 1.0f : z)) < 1e-5f;
+                }
+            }
+            return same;
+        };
+        const auto in_square = [](std::uint32_t x, std::uint32_t y) { return x >= 8 && x < 16 && y >= 8 && y < 16; };
+
+        // Two consecutive triangles forming a quad cover it whole; drawn apart, their shared diagonal stays
+        // uncovered.
+        const OccluderMesh quad = {{{8.0f, 8.0f, 0.5f}, {16.0f, 8.0f, 0.5f}, {16.0f, 16.0f, 0.5f}, {8.0f, 16.0f, 0.5f}},
+                                   {0, 1, 2, 0, 2, 3}};
+        GFW_CHECK(matches(draw({&quad}), [&](std::uint32_t x, std::uint32_t y) {
+            return in_square(x, y) ? 0.5f : -1.0f;
+        }));
+        GFW_CHECK(culler.GetStats().triangles == 2);
+        const OccluderMesh lower = {quad.positions, {0, 1, 2}};
+        const OccluderMesh upper = {quad.positions, {0, 2, 3}};
+        GFW_CHECK(matches(draw({&lower, &upper}), [&](std::uint32_t x, std::uint32_t y) {
+            return in_square(x, y) && x != y ? 0.5f : -1.0f;
+        }));
+
+        // A bent quad stores no nearer than its farthest vertex's rise over the first triangle's plane.
+        OccluderMesh bent = quad;
+        bent.positions[3].z = 0.7f;
+        GFW_CHECK(matches(draw({&bent}), [&](std::uint32_t x, std::uint32_t y) {
+            return in_square(x, y) ? 0.7f : -1.0f;
+        }));
+        // Two triangles that do not form a convex quad are drawn apart.
+        OccluderMesh dart = quad;
+        dart.positions[3] = {17.0f, 20.0f, 0.5f};
+        const std::vector<float> &dart_depth = draw({&dart});
+        GFW_CHECK(dart_depth[10 * 32 + 10] == 1.0f && dart_depth[9 * 32 + 12] == 0.5f);
+
+        // An edge through the middle of a pixel column leaves that column to whatever is behind it.
+        const OccluderMesh triangle = {{{2.5f, 2.25f, 0.25f}, {24.5f, 2.25f, 0.25f}, {2.5f, 24.25f, 0.75f}},
+                                       {0, 1, 2}};
+        // Pixels are inside when x >= 2.5, y >= 2.25 and x + y + 2 <= 26.75, and store the depth at their bottom
+        // edge, the farthest they reach.
+        GFW_CHECK(matches(draw({&triangle}), [](std::uint32_t x, std::uint32_t y) {
+            return x >= 3 && y >= 3 && x + y <= 24 ? 0.25f + 0.5f * (static_cast<float>(y) + 1.0f - 2.25f) / 22.0f
+                                                   : -1.0f;
+        }));
+
+        // Behind the quad is hidden up to its edges, even a sliver in its last pixel column; anything past an
+        // edge or over the diagonal of a split quad is not.
+        draw({&quad});
+        GFW_CHECK(culler.IsOccluded({{9.1f, 11.1f, 0.6f}, {10.9f, 14.9f, 0.9f}}));
+        GFW_CHECK(culler.IsOccluded({{10.1f, 10.1f, 0.6f}, {10.9f, 10.9f, 0.9f}}));
+        GFW_CHECK(!culler.IsOccluded({{9.1f, 11.1f, 0.4f}, {10.9f, 14.9f, 0.9f}}));
+        GFW_CHECK(culler.IsOccluded({{15.9f, 11.1f, 0.6f}, {15.95f, 14.9f, 0.9f}}));
+        GFW_CHECK(!culler.IsOccluded({{16.01f, 11.1f, 0.6f}, {16.05f, 14.9f, 0.9f}}));
+        draw({&lower, &upper});
+        GFW_CHECK(!culler.IsOccluded({{10.1f, 10.1f, 0.6f}, {10.9f, 10.9f, 0.9f}}));
+    }
+
+    // Nothing the brute-force reference can see is culled, including slivers just past an occluder edge.
+    void TestNeverCullsVisible() {
+        const OccluderMesh box = UnitBox();
+        const OccluderMesh wall = Grid(3);
+        size_t wrongly_culled = 0;
+        size_t culled = 0;
+        for (std::uint32_t seed = 1; seed <= 4; ++seed) {
+            const Scene scene = MakeScene(seed, box, wall);
+            const std::vector<WorldTriangle> triangles = WorldTriangles(scene.occluders);
+            OcclusionCuller culler;
+            const std::vector<std::uint32_t> visible = Cull(culler, scene, 2);
+            std::vector<char> kept(scene.bounds.size(), 0);
+            for (const std::uint32_t object : visible) {
+                kept[object] = 1;
+            }
+            for (size_t i = 0; i < scene.bounds.size(); ++i) {
+                if (!kept[i]) {
+                    ++culled;
+                    wrongly_culled += ReferenceVisible(scene.camera, scene.bounds[i], triangles) ? 1 : 0;
+                }
+            }
+        }
+        GFW_CHECK(wrongly_culled == 0);
+        // Not vacuous: a good part of the objects is culled.
+        GFW_CHECK(culled > 1000);
+    }
+
+    // Bands never share pixels and every object is tested on its own, so the thread count changes nothing.
+    void TestThreadCountIndependent() {
+        const OccluderMesh box = UnitBox();
+        const OccluderMesh wall = Grid(3);
+        const Scene scene = MakeScene(9, box, wall);
+        OcclusionCuller serial;
+        const std::vector<std::uint32_t> expected = Cull(serial, scene, 1);
+        for (const unsigned threads : {2u, 3u, 8u}) {
+            OcclusionCuller culler;
+            GFW_CHECK(Cull(culler, scene, threads) == expected);
+            GFW_CHECK(culler.Depth() == serial.Depth());
+            GFW_CHECK(culler.GetStats().occluded == serial.GetStats().occluded);
+        }
+    }
+
+    // Objects behind the camera's near plane or partly off screen stay visible, as do empty bounds.
+    void TestUntestableObjectsStayVisible() {
+        OcclusionCuller culler;
+        culler.Resize(kWidth, kHeight);
+        const Camera camera = MakeCamera({0.0f, 0.0f, 0.0f});
+        culler.BeginFrame(camera.view_proj);
+        const OccluderMesh wall = Grid(1);
+        culler.AddOccluder(wall, Place({0.0f, 0.0f, 5.0f}, {200.0f, 200.0f, 1.0f}, 0.0f, 0.0f));
+        culler.Rasterize(1);
+        // Clear of the wall's diagonal, which stays uncovered.
+        GFW_CHECK(culler.IsOccluded({{2.0f, -4.0f, 10.0f}, {4.0f, -2.0f, 12.0f}}));
+        GFW_CHECK(!culler.IsOccluded({{2.0f, -4.0f, -1.0f}, {4.0f, -2.0f, 12.0f}}));
+        GFW_CHECK(!culler.IsOccluded({{2.0f, -4.0f, 10.0f}, {100.0f, -2.0f, 12.0f}}));
+        GFW_CHECK(!culler.IsOccluded({{4.0f, -2.0f, 10.0f}, {2.0f, -4.0f, 12.0f}}));
+    }
+
+    // How much the culler removes against what the sampled reference finds hidden, and the time per frame.
+    void BenchmarkOcclusion() {
+        const OccluderMesh box = UnitBox();
+        const OccluderMesh wall = Grid(3);
+        size_t objects = 0, culled = 0, hidden = 0;
+        for (std::uint32_t seed = 1; seed <= 4; ++seed) {
+            const Scene scene = MakeScene(seed, box, wall);
+            const std::vector<WorldTriangle> triangles = WorldTriangles(scene.occluders);
+            OcclusionCuller culler;
+            const std::vector<std::uint32_t> visible = Cull(culler, scene, 1);
+            objects += scene.bounds.size();
+            culled += scene.bounds.size() - visible.size();
+            for (const SceneBvh::Bounds &bounds : scene.bounds) {
+                hidden += ReferenceVisible(scene.camera, bounds, triangles) ? 0 : 1;
+            }
+        }
+        std::printf("%zu objects at %ux%u: %zu culled, %zu hidden by the reference (%.1f%%)\n", objects, kWidth,
+                    kHeight, culled, hidden, 100.0 * static_cast<double>(culled) / static_cast<double>(hidden));
+
+        const OccluderMesh dense = Grid(64);
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for (const bool many : {true, false}) {
+            Scene scene;
+            scene.camera = MakeCamera({0.0f, 2.0f, 0.0f});
+            for (int i = 0; i < (many ? 400 : 30); ++i) {
+                const XMFLOAT3 position = {unit(rng) * 60.0f, 2.0f, 40.0f + unit(rng) * 30.0f};
+                scene.occluders.push_back(
+                    many ? Occluder{&box, Place(position, {4.0f, 14.0f, 4.0f}, 0.0f, unit(rng) * 3.0f)}
+                         : Occluder{&dense, Place(position, {20.0f, 12.0f, 1.0f}, 0.0f, unit(rng) * 0.8f)});
+            }
+            for (int i = 0; i < 100000; ++i) {
+                const XMFLOAT3 center = {unit(rng) * 100.0f, unit(rng) * 8.0f, 110.0f + unit(rng) * 80.0f};
+                scene.bounds.push_back({{center.x - 1.0f, center.y - 0.5f, center.z - 1.0f},
+                                        {center.x + 1.0f, center.y + 0.5f, center.z + 1.0f}});
+            }
+            OcclusionCuller culler;
+            culler.Resize(256, 144);
+            constexpr int kFrames = 10;
+            double raster_ms = 0.0, cull_ms = 0.0;
+            size_t visible = 0;
+            for (int frame = 0; frame < kFrames; ++frame) {
+                raster_ms += test::MeasureMs([&] {
+                    culler.BeginFrame(scene.camera.view_proj);
+                    for (const Occluder &occluder : scene.occluders) {
+                        culler.AddOccluder(*occluder.mesh, occluder.world);
+                    }
+                    culler.Rasterize(1);
+                });
+                std::vector<std::uint32_t> objects(scene.bounds.size());
+                for (std::uint32_t i = 0; i < objects.size(); ++i) {
+                    objects[i] = i;
+                }
+                cull_ms += test::MeasureMs([&] { culler.Cull(scene.bounds, objects, 1); });
+                visible = objects.size();
+            }
+            std::printf("%zu occluders, %zu triangles drawn at 256x144: rasterize %.3f ms, %zu objects tested in "
+                        "%.3f ms, %zu visible\n",
+                        scene.occluders.size(), culler.GetStats().triangles, raster_ms / kFrames,
+                        scene.bounds.size(), cull_ms / kFrames, visible);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestInnerCoverage();
+    TestNeverCullsVisible();
+    TestThreadCountIndependent();
+    TestUntestableObjectsStayVisible();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkOcclusion();
+    }
+    return test::Result("OcclusionCullerTests");
+}
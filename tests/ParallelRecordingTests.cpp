@@ -0,0 +1,238 @@
+#include "TestHarness.h"
+#include "framework/NullRenderBackend.h"
+#include "framework/ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    constexpr std::size_t kMinDrawsPerList = 64; // RenderingSystem::kMinDrawsPerList
+
+    // What RenderingSystem::GeometryPass resolves before recording: one entry per visible object.
+    struct Draw {
+        PipelineHandle pipeline;
+        GpuAddress constants = 0;
+        VertexBufferView vertices;
+        IndexBufferView indices;
+        std::uint32_t index_count = 0;
+    };
+
+    std::vector<Draw> MakeDraws(std::size_t count) {
+        std::uint32_t seed = 9;
+        const auto next = [&seed] { return (seed = seed * 1103515245u + 12345u) >> 16; };
+        std::vector<Draw> draws(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Draw &draw = draws[i];
+            // A handful of permutations, sorted runs as the material order produces them.
+            draw.pipeline.value = 1 + (i * 8 / std::max<std::size_t>(count, 1)) + (next() % 16 == 0);
+            draw.constants = 0x10000 + i * 256;
+            draw.vertices = {0x100000000ull + next() * 4096ull, 4096, 16};
+            draw.indices = {0x200000000ull + next() * 4096ull, 4096, IndexFormat::Uint16};
+            draw.index_count = 3 * (1 + next() % 2000);
+        }
+        return draws;
+    }
+
+    // The binds and draws of BindGeometryTargets, BindGeometryState and RecordGeometryDraws.
+    void BindTargets(CommandRecorder &cmd) {
+        const CpuDescriptor rtvs[3] = {{11}, {12}, {13}};
+        cmd.SetRenderTargets(rtvs, 3, CpuDescriptor{14});
+        cmd.SetViewport({0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f});
+        cmd.SetScissor({0, 0, 1920, 1080});
+    }
+
+    void BindState(CommandRecorder &cmd) {
+        cmd.SetRootSignature(RootSignatureHandle{21});
+        cmd.SetDescriptorHeap(DescriptorHeapHandle{22});
+        cmd.SetDescriptorTable(1, GpuDescriptor{23});
+    }
+
+    void RecordDraws(CommandRecorder &cmd, const std::vector<Draw> &draws, std::size_t begin, std::size_t end) {
+        PipelineHandle bound;
+        for (std::size_t i = begin; i < end; ++i) {
+            const Draw &draw = draws[i];
+            if (draw.pipeline != bound) {
+                cmd.SetPipeline(draw.pipeline);
+                bound = draw.pipeline;
+            }
+            cmd.SetConstantBuffer(0, draw.constants);
+            cmd.SetTopology(PrimitiveTopology::TriangleList);
+            cmd.SetVertexBuffer(draw.vertices);
+            cmd.SetIndexBuffer(draw.indices);
+            cmd.DrawIndexed(draw.index_count, 0, 0);
+        }
+    }
+
+    // GeometryPass with list_count worker lists on ParallelCommandRecorder's pool: contiguous chunks, each list
+    // binding its own state, merged in list order as ExecuteCommandLists would run them.
+    void RecordParallel(WorkerPool &pool, std::vector<RecordingCommandList> &lists, const std::vector<Draw> &draws,
+                        std::size_t list_count, CommandStream &merged) {
+        const std::size_t chunk = (draws.size() + list_count - 1) / list_count;
+        pool.Run(list_count, [&](std::size_t i) {
+            RecordingCommandList &list = lists[i];
+            list.Stream().Clear();
+            BindTargets(list);
+            BindState(list);
+            const std::size_t begin = std::min(draws.size(), i * chunk);
+            RecordDraws(list, draws, begin, std::min(draws.size(), begin + chunk));
+        });
+        merged.Clear();
+        for (std::size_t i = 0; i < list_count; ++i) {
+            merged.Append(lists[i].Stream());
+        }
+    }
+
+    struct BoundDraw {
+        std::uint64_t pipeline;
+        std::uint64_t constants;
+        CommandStream::DrawPacket draw;
+    };
+
+    // Every draw with the pipeline and constants it runs with; false if a list draws before binding its
+    // targets, root signature or pipeline, which a direct command list does not inherit.
+    bool CollectDraws(const CommandStream &stream, std::vector<BoundDraw> &out) {
+        bool bound = true;
+        bool targets = false;
+        bool root_signature = false;
+        std::uint64_t pipeline = 0;
+        std::uint64_t constants = 0;
+        stream.ForEach([&](CommandOp op, const std::uint8_t *payload, std::size_t) {
+            switch (op) {
+                case CommandOp::SetRenderTargets:
+                    targets = true;
+                    break;
+                case CommandOp::SetRootSignature:
+                    // Starts the next worker list in a merged stream.
+                    root_signature = true;
+                    pipeline = 0;
+                    break;
+                case CommandOp::SetPipeline:
+                    std::memcpy(&pipeline, payload, sizeof(pipeline));
+                    break;
+                case CommandOp::SetConstantBuffer: {
+                    CommandStream::RootArgumentPacket packet;
+                    std::memcpy(&packet, payload, sizeof(packet));
+                    constants = packet.value;
+                    break;
+                }
+                case CommandOp::DrawIndexed: {
+                    BoundDraw draw = {pipeline, constants, {}};
+                    std::memcpy(&draw.draw, payload, sizeof(draw.draw));
+                    bound &= targets && root_signature && pipeline != 0;
+                    out.push_back(draw);
+                    break;
+                }
+                default:
+                    break;
+            }
+        });
+        return bound;
+    }
+
+    bool SameDraws(const std::vector<BoundDraw> &a, const std::vector<BoundDraw> &b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const auto &x, const auto &y) {
+                   return x.pipeline == y.pipeline && x.constants == y.constants &&
+                          std::memcmp(&x.draw, &y.draw, sizeof(x.draw)) == 0;
+               });
+    }
+
+    void TestParallelForCoversEveryItem() {
+        for (const unsigned threads: {1u, 2u, 3u, 8u}) {
+            for (const std::size_t count: {std::size_t{0}, std::size_t{1}, std::size_t{5}, std::size_t{1000}}) {
+                std::vector<std::atomic<int>> hits(count);
+                ParallelFor(count, threads, [&](std::size_t i) { hits[i].fetch_add(1); });
+                GFW_CHECK(std::all_of(hits.begin(), hits.end(), [](const auto &h) { return h.load() == 1; }));
+            }
+        }
+    }
+
+    // One pool serves many runs, including ones with fewer items than threads, and can be restarted.
+    void TestWorkerPoolReusesThreads() {
+        WorkerPool pool;
+        for (const unsigned threads: {1u, 3u, 8u}) {
+            pool.Start(threads);
+            GFW_CHECK(pool.ThreadCount() == threads);
+            for (int run = 0; run < 200; ++run) {
+                const std::size_t count = static_cast<std::size_t>(run % 13);
+                std::vector<std::atomic<int>> hits(count);
+                pool.Run(count, [&](std::size_t i) { hits[i].fetch_add(1); });
+                GFW_CHECK(std::all_of(hits.begin(), hits.end(), [](const auto &h) { return h.load() == 1; }));
+            }
+        }
+        pool.Stop();
+        GFW_CHECK(pool.ThreadCount() == 1);
+        int serial = 0;
+        pool.Run(4, [&](std::size_t) { ++serial; });
+        GFW_CHECK(serial == 4);
+    }
+
+    // Splitting the pass must not change what the GPU draws, with which state, or in which order.
+    void TestParallelMatchesSerial() {
+        for (const std::size_t count: {std::size_t{1}, std::size_t{63}, std::size_t{64}, std::size_t{1000}}) {
+            const std::vector<Draw> draws = MakeDraws(count);
+            RecordingCommandList serial;
+            BindTargets(serial);
+            BindState(serial);
+            RecordDraws(serial, draws, 0, draws.size());
+            std::vector<BoundDraw> expected;
+            GFW_CHECK(CollectDraws(serial.Stream(), expected) && expected.size() == count);
+
+            std::vector<RecordingCommandList> lists(8);
+            for (const std::size_t list_count: {std::size_t{1}, std::size_t{2}, std::size_t{3}, std::size_t{8}}) {
+                WorkerPool pool;
+                pool.Start(static_cast<unsigned>(list_count));
+                CommandStream merged;
+                RecordParallel(pool, lists, draws, list_count, merged);
+                std::vector<BoundDraw> actual;
+                GFW_CHECK(CollectDraws(merged, actual));
+                GFW_CHECK(SameDraws(expected, actual) && merged.DrawCount() == count);
+            }
+        }
+    }
+
+    // CPU cost of recording the GBuffer pass into the recording stand-in, by object and worker count.
+    void BenchmarkRecording() {
+        std::printf("hardware threads: %u\n", DefaultWorkerCount());
+        std::vector<RecordingCommandList> lists(8);
+        WorkerPool pool;
+        for (const std::size_t objects: {std::size_t{1000}, std::size_t{10000}, std::size_t{100000}}) {
+            const std::vector<Draw> draws = MakeDraws(objects);
+            double serial_ms = 0.0;
+            for (const std::size_t threads: {std::size_t{1}, std::size_t{2}, std::size_t{4}, std::size_t{8}}) {
+                // GeometryPass never opens more lists than there are kMinDrawsPerList draws.
+                const std::size_t list_count =
+                    std::min(threads, std::max<std::size_t>(1, (objects + kMinDrawsPerList - 1) / kMinDrawsPerList));
+                pool.Start(static_cast<unsigned>(list_count)); // once, as ParallelCommandRecorder::Initialize does
+                CommandStream merged;
+                RecordParallel(pool, lists, draws, list_count, merged); // warm up the stream storage
+                constexpr int kFrames = 10;
+                const double ms = test::MeasureMs([&] {
+                                      for (int frame = 0; frame < kFrames; ++frame) {
+                                          RecordParallel(pool, lists, draws, list_count, merged);
+                                      }
+                                  }) /
+                                  kFrames;
+                if (threads == 1) {
+                    serial_ms = ms;
+                }
+                std::printf("%7zu objects, %zu lists: %8.3f ms/frame %7.1f ns/draw  %.2fx\n", objects, list_count, ms,
+                            ms * 1e6 / static_cast<double>(objects), serial_ms / ms);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestParallelForCoversEveryItem();
+    TestWorkerPoolReusesThreads();
+    TestParallelMatchesSerial();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkRecording();
+    }
+    return test::Result("ParallelRecordingTests");
+}
@@ -0,0 +1,250 @@
+#include "TestHarness.h"
+#include "framework/PipelineCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    enum class FillMode : std::uint32_t { Wireframe = 2, Solid = 3 };
+
+    constexpr AdapterIdentity kAdapter = {0x10de, 0x2204, 1, 2, 0x1f0002000a1234ull};
+
+    std::vector<std::uint8_t> Blob(std::uint64_t key, std::size_t size) {
+        std::vector<std::uint8_t> blob(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            blob[i] = static_cast<std::uint8_t>(key * 31 + i);
+        }
+        return blob;
+    }
+
+    std::vector<char> ReadFile(const std::filesystem::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    void WriteFile(const std::filesystem::path &path, const std::vector<char> &data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    void TestHasherIsCanonical() {
+        // Keys name blobs on disk, so these values must come out the same in every run and on every host.
+        std::uint8_t code[64];
+        for (int i = 0; i < 64; ++i) {
+            code[i] = static_cast<std::uint8_t>(i * 7);
+        }
+        PipelineHasher hasher;
+        hasher.Add(std::uint32_t{7});
+        hasher.Add(-0.0f);
+        hasher.Add(std::uint8_t{3});
+        hasher.AddString("POSITION");
+        hasher.AddString(nullptr);
+        hasher.AddBytes(code, sizeof(code));
+        hasher.Add(std::uint64_t{1} << 40);
+        GFW_CHECK(hasher.Value() == 0x37e4e5b82eab71cfull);
+        PipelineHasher one_and_half;
+        one_and_half.Add(1.5f);
+        GFW_CHECK(one_and_half.Value() == 0x4a98c77f9ba36558ull);
+
+        // Shader bytecode is hashed by content, never by where it lives.
+        const std::vector<std::uint8_t> copy(code, code + sizeof(code));
+        PipelineHasher a;
+        PipelineHasher b;
+        a.AddBytes(code, sizeof(code));
+        b.AddBytes(copy.data(), copy.size());
+        GFW_CHECK(a.Value() == b.Value());
+
+        PipelineHasher positive_zero;
+        PipelineHasher negative_zero;
+        positive_zero.Add(0.0f);
+        negative_zero.Add(-0.0f);
+        GFW_CHECK(positive_zero.Value() == negative_zero.Value());
+
+        PipelineHasher empty;
+        PipelineHasher null;
+        empty.AddString("");
+        null.AddString(nullptr);
+        GFW_CHECK(empty.Value() != null.Value());
+
+        // Length prefixes keep neighbouring fields apart.
+        PipelineHasher ab_c;
+        PipelineHasher a_bc;
+        ab_c.AddString("ab");
+        ab_c.AddString("c");
+        a_bc.AddString("a");
+        a_bc.AddString("bc");
+        GFW_CHECK(ab_c.Value() != a_bc.Value());
+
+        PipelineHasher as_enum;
+        PipelineHasher as_int;
+        as_enum.Add(FillMode::Solid);
+        as_int.Add(std::uint32_t{3});
+        GFW_CHECK(as_enum.Value() == as_int.Value());
+        PipelineHasher signed_value;
+        signed_value.Add(std::int32_t{-1});
+        PipelineHasher unsigned_value;
+        unsigned_value.Add(std::uint32_t{0xFFFFFFFFu});
+        GFW_CHECK(signed_value.Value() == unsigned_value.Value());
+    }
+
+    void TestSaveAndLoad() {
+        const auto dir = test::ScratchDirectory("gfw_pipeline_cache_tests");
+        const std::wstring path = (dir / "pipelines.gfwpso").wstring();
+
+        PipelineCache cache;
+        GFW_CHECK(!cache.Load(path, kAdapter) && cache.Size() == 0 && !cache.IsDirty());
+        for (std::uint64_t i = 0; i < 50; ++i) {
+            const std::vector<std::uint8_t> blob = Blob(i, i * 13);
+            cache.Store(i * 0x9e3779b97f4a7c15ull, blob.data(), blob.size());
+        }
+        GFW_CHECK(cache.IsDirty() && cache.Size() == 50);
+        GFW_CHECK(cache.Save(path) && !cache.IsDirty());
+        GFW_CHECK(!std::filesystem::exists(dir / "pipelines.gfwpso.tmp"));
+
+        PipelineCache loaded;
+        GFW_CHECK(loaded.Load(path, kAdapter) && loaded.Size() == 50 && !loaded.IsDirty());
+        bool same = true;
+        for (std::uint64_t i = 0; i < 50; ++i) {
+            std::vector<std::uint8_t> blob;
+            same &= loaded.Find(i * 0x9e3779b97f4a7c15ull, blob) && blob == Blob(i, i * 13);
+        }
+        GFW_CHECK(same);
+        std::vector<std::uint8_t> missing;
+        GFW_CHECK(!loaded.Find(1, missing));
+
+        // A blob the driver rejects is dropped and the cache needs saving again.
+        loaded.Erase(0x9e3779b97f4a7c15ull);
+        GFW_CHECK(loaded.Size() == 49 && loaded.IsDirty());
+        loaded.Erase(1);
+        GFW_CHECK(loaded.Save(path) && !loaded.IsDirty());
+        PipelineCache reloaded;
+        GFW_CHECK(reloaded.Load(path, kAdapter) && reloaded.Size() == 49);
+
+        // Saving into a directory that does not exist fails and keeps the changes pending.
+        cache.Erase(0);
+        GFW_CHECK(!cache.Save((dir / "missing" / "pipelines.gfwpso").wstring()) && cache.IsDirty());
+    }
+
+    // Anything not written for this adapter, driver and format is ignored as a whole.
+    void TestRejectsStaleAndCorruptFiles() {
+        const auto dir = test::ScratchDirectory("gfw_pipeline_cache_reject_tests");
+        const auto path = dir / "pipelines.gfwpso";
+        PipelineCache cache;
+        cache.Load(path.wstring(), kAdapter);
+        for (std::uint64_t i = 1; i <= 4; ++i) {
+            const std::vector<std::uint8_t> blob = Blob(i, 100);
+            cache.Store(i, blob.data(), blob.size());
+        }
+        GFW_CHECK(cache.Save(path.wstring()));
+        const std::vector<char> good = ReadFile(path);
+        GFW_CHECK(good.size() % 16 == 0);
+
+        const auto rejected = [&](const std::vector<char> &data, const AdapterIdentity &identity) {
+            WriteFile(path, data);
+            PipelineCache stale;
+            return !stale.Load(path.wstring(), identity) && stale.Size() == 0;
+        };
+        AdapterIdentity new_driver = kAdapter;
+        ++new_driver.driver_version;
+        AdapterIdentity other_device = kAdapter;
+        other_device.device_id = 0x2206;
+        GFW_CHECK(rejected(good, new_driver) && rejected(good, other_device));
+
+        GFW_CHECK(rejected(std::vector<char>(good.begin(), good.begin() + 100), kAdapter));
+        GFW_CHECK(rejected(std::vector<char>(good.begin(), good.begin() + 20), kAdapter));
+        std::vector<char> bad_magic = good;
+        bad_magic[0] = 'X';
+        GFW_CHECK(rejected(bad_magic, kAdapter));
+        std::vector<char> bad_version = good;
+        bad_version[8] = 2;
+        GFW_CHECK(rejected(bad_version, kAdapter));
+        // The first entry record follows the 48-byte header: key, offset, size.
+        std::vector<char> bad_offset = good;
+        const std::uint64_t past_end = good.size();
+        std::memcpy(bad_offset.data() + 48 + 8, &past_end, sizeof(past_end));
+        GFW_CHECK(rejected(bad_offset, kAdapter));
+        std::vector<char> too_many = good;
+        const std::uint32_t entries = 1000;
+        std::memcpy(too_many.data() + 12, &entries, sizeof(entries));
+        GFW_CHECK(rejected(too_many, kAdapter));
+
+        WriteFile(path, good);
+        PipelineCache fresh;
+        GFW_CHECK(fresh.Load(path.wstring(), kAdapter) && fresh.Size() == 4);
+    }
+
+    // Pipelines are created on several worker threads, each storing its blob.
+    void TestConcurrentStores() {
+        PipelineCache cache;
+        std::vector<std::thread> threads;
+        for (std::uint64_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&cache, t] {
+                for (std::uint64_t i = 0; i < 500; ++i) {
+                    const std::vector<std::uint8_t> blob = Blob(i, 64);
+                    cache.Store(t * 1000 + i, blob.data(), blob.size());
+                    std::vector<std::uint8_t> out;
+                    cache.Find(i, out);
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        GFW_CHECK(cache.Size() == 2000);
+    }
+
+    void BenchmarkCache() {
+        // A tessellated GBuffer pipeline hashes about 20 KB of DXIL plus a few hundred bytes of state.
+        const std::vector<std::uint8_t> shaders = Blob(7, 20 * 1024);
+        constexpr int kKeys = 2000;
+        std::uint64_t checksum = 0;
+        const double hash_ms = test::MeasureMs([&] {
+            for (int i = 0; i < kKeys; ++i) {
+                PipelineHasher hasher;
+                hasher.Add(static_cast<std::uint32_t>(i));
+                hasher.AddBytes(shaders.data(), shaders.size());
+                checksum ^= hasher.Value();
+            }
+        });
+        std::printf("description hash: %.1f us per pipeline (checksum %016llx)\n", hash_ms * 1e3 / kKeys,
+                    static_cast<unsigned long long>(checksum));
+
+        const auto dir = test::ScratchDirectory("gfw_pipeline_cache_benchmark");
+        const std::wstring path = (dir / "pipelines.gfwpso").wstring();
+        for (const std::size_t count : {100u, 1000u}) {
+            PipelineCache cache;
+            cache.Load(path, kAdapter);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                const std::vector<std::uint8_t> blob = Blob(i, 48 * 1024);
+                cache.Store(i, blob.data(), blob.size());
+            }
+            const double save_ms = test::MeasureMs([&] { cache.Save(path); });
+            PipelineCache loaded;
+            const double load_ms = test::MeasureMs([&] { loaded.Load(path, kAdapter); });
+            std::printf("%5zu blobs of 48 KB: save %.1f ms, load %.1f ms\n", count, save_ms, load_ms);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    // PipelineCache logs through wcout and wcerr, and a C stream takes the orientation of its first write. Fix
+    // both as byte streams up front so check failures and timings are not lost after a wide log line.
+    std::fwide(stdout, -1);
+    std::fwide(stderr, -1);
+    TestHasherIsCanonical();
+    TestSaveAndLoad();
+    TestRejectsStaleAndCorruptFiles();
+    TestConcurrentStores();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkCache();
+    }
+    return test::Result("PipelineCacheTests");
+}
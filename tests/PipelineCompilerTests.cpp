@@ -0,0 +1,213 @@
+#include "TestHarness.h"
+#include "framework/PipelineCompiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    struct MockPipeline {
+        std::uint32_t id = 0;
+
+        explicit operator bool() const { return id != 0; }
+    };
+
+    using Compiler = PipelineCompiler<MockPipeline>;
+
+    // Stands in for ID3D12Device::CreateGraphicsPipelineState: takes create_ms, fails for features == kBroken,
+    // and records which keys were created in which order.
+    class MockDevice {
+    public:
+        static constexpr std::uint32_t kBroken = 0xDEAD;
+
+        explicit MockDevice(double create_ms = 0.0) : create_ms_(create_ms) {}
+
+        MockPipeline Create(const PermutationKey &key) {
+            if (create_ms_ > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(create_ms_));
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            order_.push_back(key);
+            return MockPipeline{key.features == kBroken ? 0u : key.pass * 1000 + key.features + 1};
+        }
+
+        Compiler::CreateFunction Function() {
+            return [this](const PermutationKey &key) { return Create(key); };
+        }
+
+        [[nodiscard]] std::vector<PermutationKey> Order() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return order_;
+        }
+
+    private:
+        double create_ms_;
+        std::mutex mutex_;
+        std::vector<PermutationKey> order_;
+    };
+
+    // Background jobs have no wait of their own; poll until the compiler has nothing left.
+    bool WaitIdle(const Compiler &compiler) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (compiler.GetStats().pending != 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return true;
+    }
+
+    void TestStartupRunsFirst() {
+        MockDevice device;
+        Compiler compiler;
+        for (std::uint32_t i = 0; i < 4; ++i) {
+            compiler.Request({1, i}, Compiler::Priority::Background);
+        }
+        for (std::uint32_t i = 0; i < 3; ++i) {
+            compiler.Request({0, i}, Compiler::Priority::Startup);
+        }
+        // A queued background job that startup needs moves up; requesting it twice does not duplicate it.
+        compiler.Request({1, 3}, Compiler::Priority::Startup);
+        compiler.Request({1, 3}, Compiler::Priority::Background);
+        GFW_CHECK(compiler.GetStats().pending == 7 && compiler.Acquire({0, 0}) == nullptr);
+
+        compiler.Start(1, device.Function());
+        GFW_CHECK(compiler.WaitForStartup());
+        GFW_CHECK(WaitIdle(compiler));
+        const std::vector<PermutationKey> order = device.Order();
+        GFW_CHECK(order.size() == 7);
+        GFW_CHECK((order[0] == PermutationKey{0, 0} && order[2] == PermutationKey{0, 2}));
+        GFW_CHECK((order[3] == PermutationKey{1, 3} && order[4] == PermutationKey{1, 0}));
+        const MockPipeline *pipeline = compiler.Acquire({1, 2});
+        GFW_CHECK(pipeline && pipeline->id == 1003);
+        GFW_CHECK(compiler.GetStats().ready == 7 && compiler.GetStats().failed == 0);
+    }
+
+    void TestLazyAcquire() {
+        MockDevice device(1.0);
+        Compiler compiler;
+        compiler.Start(2, device.Function());
+        // First use queues the variant and the draw falls back for that frame.
+        GFW_CHECK(compiler.Acquire({2, 5}) == nullptr);
+        GFW_CHECK(WaitIdle(compiler));
+        GFW_CHECK(compiler.Acquire({2, 5}) && compiler.Acquire({2, 5})->id == 2006);
+        GFW_CHECK(device.Order().size() == 1);
+    }
+
+    // A broken variant is created once and reported through WaitForStartup, not retried every frame.
+    void TestFailures() {
+        MockDevice device;
+        Compiler compiler;
+        compiler.Start(2, device.Function());
+        compiler.Request({0, 1}, Compiler::Priority::Startup);
+        compiler.Request({0, MockDevice::kBroken}, Compiler::Priority::Startup);
+        GFW_CHECK(!compiler.WaitForStartup());
+        for (int frame = 0; frame < 10; ++frame) {
+            GFW_CHECK(compiler.Acquire({0, MockDevice::kBroken}) == nullptr);
+        }
+        GFW_CHECK(WaitIdle(compiler) && device.Order().size() == 2);
+        GFW_CHECK(compiler.GetStats().failed == 1 && compiler.GetStats().ready == 1);
+    }
+
+    // Render and loading threads ask for the same variants at once; each is still created exactly once.
+    void TestConcurrentRequests() {
+        MockDevice device(0.05);
+        Compiler compiler;
+        compiler.Start(3, device.Function());
+        std::vector<std::thread> threads;
+        std::atomic<int> acquired{0};
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (std::uint32_t i = 0; i < 200; ++i) {
+                    const PermutationKey key = {t % 2 ? 0u : 1u, i % 64};
+                    if (i % 3 == 0) {
+                        compiler.Request(key, Compiler::Priority::Startup);
+                    } else if (compiler.Acquire(key)) {
+                        ++acquired;
+                    }
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        GFW_CHECK(compiler.WaitForStartup() && WaitIdle(compiler));
+        GFW_CHECK(device.Order().size() == 128 && compiler.GetStats().ready == 128);
+    }
+
+    // Stop drops what has not started; a later Start picks up new requests.
+    void TestStopDropsQueue() {
+        MockDevice device(2.0);
+        Compiler compiler;
+        compiler.Start(1, device.Function());
+        for (std::uint32_t i = 0; i < 50; ++i) {
+            compiler.Request({0, i}, Compiler::Priority::Background);
+        }
+        compiler.Stop();
+        const Compiler::Stats stats = compiler.GetStats();
+        GFW_CHECK(stats.pending == 0 && stats.ready == device.Order().size() && stats.ready < 50);
+        GFW_CHECK(compiler.ThreadCount() == 0);
+        compiler.Start(1, device.Function());
+        compiler.Request({3, 0}, Compiler::Priority::Startup);
+        GFW_CHECK(compiler.WaitForStartup() && compiler.Acquire({3, 0}));
+        compiler.Clear();
+        GFW_CHECK(compiler.GetStats().ready == 0);
+    }
+
+    // Time to first frame: core pipelines created one after another before loading starts, against the
+    // compiler building them on workers while the main thread loads assets. Variants are compiled afterwards.
+    void BenchmarkStartup() {
+        constexpr std::uint32_t kCore = 24;
+        constexpr std::uint32_t kLazy = 72;
+        static constexpr double kCreateMs = 4.0;
+        static constexpr double kLoadMs = 60.0;
+        const auto load_assets = [] {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(kLoadMs));
+        };
+        MockDevice serial_device(kCreateMs);
+        const double serial_ms = test::MeasureMs([&] {
+            for (std::uint32_t i = 0; i < kCore + kLazy; ++i) {
+                serial_device.Create({0, i});
+            }
+            load_assets();
+        });
+        std::printf("%u core + %u lazy pipelines at %.0f ms, %.0f ms loading\n", kCore, kLazy, kCreateMs, kLoadMs);
+        std::printf("  serial, everything up front: %7.1f ms to first frame\n", serial_ms);
+        for (const unsigned threads : {1u, 2u, 4u, 8u}) {
+            MockDevice device(kCreateMs);
+            Compiler compiler;
+            const double ms = test::MeasureMs([&] {
+                compiler.Start(threads, device.Function());
+                for (std::uint32_t i = 0; i < kCore; ++i) {
+                    compiler.Request({0, i}, Compiler::Priority::Startup);
+                }
+                load_assets();
+                compiler.WaitForStartup();
+            });
+            for (std::uint32_t i = kCore; i < kCore + kLazy; ++i) {
+                compiler.Acquire({0, i});
+            }
+            const double lazy_ms = test::MeasureMs([&] { WaitIdle(compiler); });
+            std::printf("  %u workers, lazy variants:    %7.1f ms to first frame, variants ready %.1f ms later\n",
+                        threads, ms, lazy_ms);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestStartupRunsFirst();
+    TestLazyAcquire();
+    TestFailures();
+    TestConcurrentRequests();
+    TestStopDropsQueue();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkStartup();
+    }
+    return test::Result("PipelineCompilerTests");
+}
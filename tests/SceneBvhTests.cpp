@@ -0,0 +1,311 @@
+#include "SceneBvh.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace gfw;
+using namespace DirectX;
+
+namespace {
+    using Bounds = SceneBvh::Bounds;
+
+    constexpr float kNoHit = std::numeric_limits<float>::infinity();
+
+    bool OutsideFrustum(const FrustumCuller::Frustum &frustum, const Bounds &b) {
+        const float cx = (b.min.x + b.max.x) * 0.5f;
+        const float cy = (b.min.y + b.max.y) * 0.5f;
+        const float cz = (b.min.z + b.max.z) * 0.5f;
+        const float ex = (b.max.x - b.min.x) * 0.5f;
+        const float ey = (b.max.y - b.min.y) * 0.5f;
+        const float ez = (b.max.z - b.min.z) * 0.5f;
+        for (const XMFLOAT4 &p : frustum.planes) {
+            const float distance = p.x * cx + p.y * cy + p.z * cz + p.w;
+            if (distance < -(std::abs(p.x) * ex + std::abs(p.y) * ey + std::abs(p.z) * ez)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    float DistanceSq(const Bounds &b, const XMFLOAT3 &p) {
+        const float dx = std::max({b.min.x - p.x, 0.0f, p.x - b.max.x});
+        const float dy = std::max({b.min.y - p.y, 0.0f, p.y - b.max.y});
+        const float dz = std::max({b.min.z - p.z, 0.0f, p.z - b.max.z});
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Slab test; kNoHit when the ray misses b within [0, max_distance].
+    float RayEntry(const Bounds &b, const XMFLOAT3 &origin, const XMFLOAT3 &direction, float max_distance) {
+        const float lo[3] = {b.min.x, b.min.y, b.min.z};
+        const float hi[3] = {b.max.x, b.max.y, b.max.z};
+        const float o[3] = {origin.x, origin.y, origin.z};
+        const float d[3] = {direction.x, direction.y, direction.z};
+        float near_t = 0.0f;
+        float far_t = max_distance;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (d[axis] == 0.0f) {
+                if (o[axis] < lo[axis] || o[axis] > hi[axis]) {
+                    return kNoHit;
+                }
+                continue;
+            }
+            const float t0 = (lo[axis] - o[axis]) / d[axis];
+            const float t1 = (hi[axis] - o[axis]) / d[axis];
+            near_t = std::max(near_t, std::min(t0, t1));
+            far_t = std::min(far_t, std::max(t0, t1));
+        }
+        return near_t <= far_t ? near_t : kNoHit;
+    }
+
+    FrustumCuller::Frustum CameraFrustum(float x, float z) {
+        const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(x, 0.0f, z, 1.0f), XMVectorSet(x, 0.0f, z + 1.0f, 1.0f),
+                                               XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        XMFLOAT4X4 view_proj;
+        XMStoreFloat4x4(&view_proj, XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(1.05f, 16.0f / 9.0f, 0.1f,
+                                                                                    300.0f)));
+        return FrustumCuller::ExtractFrustum(view_proj);
+    }
+
+    // Rotated boxes scattered over a world_size square, every 50th one large, plus a few empty bounds.
+    std::vector<Bounds> Scene(size_t count, float world_size, std::mt19937 &rng) {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<Bounds> bounds(count);
+        for (size_t i = 0; i < count; ++i) {
+            const float angle = unit(rng) * 3.0f;
+            const float scale = 1.0f + 0.5f * unit(rng);
+            XMFLOAT4X4 world = {};
+            world._11 = std::cos(angle) * scale;
+            world._13 = -std::sin(angle) * scale;
+            world._22 = scale;
+            world._31 = std::sin(angle) * scale;
+            world._33 = std::cos(angle) * scale;
+            world._41 = unit(rng) * world_size;
+            world._42 = unit(rng) * 20.0f;
+            world._43 = unit(rng) * world_size;
+            world._44 = 1.0f;
+            const float extent = 0.5f + (unit(rng) + 1.0f) * (i % 50 == 0 ? 20.0f : 1.0f);
+            bounds[i] = SceneBvh::WorldBounds({-extent, -1.0f, -extent * 0.5f}, {extent, 1.0f, extent * 0.5f}, world);
+            if (i % 997 == 5) {
+                bounds[i] = {{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+            }
+        }
+        return bounds;
+    }
+
+    void TestWorldBounds() {
+        XMFLOAT4X4 world = {};
+        world._13 = 2.0f; // x -> 2z
+        world._21 = 1.0f; // y -> x
+        world._32 = 1.0f; // z -> y
+        world._41 = 10.0f;
+        world._44 = 1.0f;
+        const Bounds b = SceneBvh::WorldBounds({-1.0f, -2.0f, -3.0f}, {1.0f, 2.0f, 3.0f}, world, 0.5f);
+        GFW_CHECK(b.min.x == 7.5f && b.max.x == 12.5f && b.min.y == -3.5f && b.max.y == 3.5f);
+        GFW_CHECK(b.min.z == -3.0f && b.max.z == 3.0f);
+        GFW_CHECK(SceneBvh::IsEmpty({{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 1.0f}}) && !SceneBvh::IsEmpty(b));
+        GFW_CHECK(SceneBvh::IsEmpty({{std::nanf(""), 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}));
+    }
+
+    // Frustum, sphere and ray queries return exactly what testing every object would, through builds, refits
+    // and objects leaving and entering the tree.
+    void TestQueriesMatchBruteForce() {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        size_t mismatches = 0;
+        size_t hits = 0;
+        for (const size_t count : {0u, 1u, 2u, 9u, 100u, 5000u}) {
+            std::vector<Bounds> bounds = Scene(count, 200.0f, rng);
+            SceneBvh bvh;
+            bvh.Build(bounds);
+            GFW_CHECK(bvh.ObjectCount() == count);
+            for (int round = 0; round < 6; ++round) {
+                if (round > 0) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if ((i + round) % 3 != 0) {
+                            continue;
+                        }
+                        const float dx = unit(rng) * 10.0f;
+                        const float dz = unit(rng) * 10.0f;
+                        Bounds &b = bounds[i];
+                        if (!SceneBvh::IsEmpty(b)) {
+                            b = {{b.min.x + dx, b.min.y, b.min.z + dz}, {b.max.x + dx, b.max.y, b.max.z + dz}};
+                        }
+                        if (round == 4 && i == 1) {
+                            b = {{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+                        } else if (round == 5 && i == 5) {
+                            b = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+                        }
+                        bvh.Update(static_cast<std::uint32_t>(i), b);
+                    }
+                    bvh.Refit();
+                }
+                for (int q = 0; q < 40; ++q) {
+                    const FrustumCuller::Frustum frustum = CameraFrustum(unit(rng) * 150.0f, unit(rng) * 150.0f);
+                    std::vector<std::uint32_t> found;
+                    std::vector<std::uint32_t> expected;
+                    bvh.QueryFrustum(frustum, found);
+                    std::sort(found.begin(), found.end());
+                    for (std::uint32_t i = 0; i < count; ++i) {
+                        if (!SceneBvh::IsEmpty(bounds[i]) && !OutsideFrustum(frustum, bounds[i])) {
+                            expected.push_back(i);
+                        }
+                    }
+                    mismatches += found != expected;
+
+                    const XMFLOAT3 center = {unit(rng) * 200.0f, unit(rng) * 20.0f, unit(rng) * 200.0f};
+                    const float radius = (unit(rng) + 1.0f) * 30.0f;
+                    found.clear();
+                    expected.clear();
+                    bvh.QuerySphere(center, radius, found);
+                    std::sort(found.begin(), found.end());
+                    for (std::uint32_t i = 0; i < count; ++i) {
+                        if (!SceneBvh::IsEmpty(bounds[i]) && DistanceSq(bounds[i], center) <= radius * radius) {
+                            expected.push_back(i);
+                        }
+                    }
+                    mismatches += found != expected;
+
+                    const XMFLOAT3 origin = {unit(rng) * 200.0f, unit(rng) * 20.0f, unit(rng) * 200.0f};
+                    const XMFLOAT3 direction = {unit(rng), q % 4 == 0 ? 0.0f : unit(rng) * 0.1f, unit(rng)};
+                    const float max_distance = q % 2 ? 1e30f : 100.0f;
+                    float nearest = kNoHit;
+                    for (std::uint32_t i = 0; i < count; ++i) {
+                        if (!SceneBvh::IsEmpty(bounds[i])) {
+                            nearest = std::min(nearest, RayEntry(bounds[i], origin, direction, max_distance));
+                        }
+                    }
+                    SceneBvh::RayHit hit;
+                    const bool any = bvh.QueryRay(origin, direction, max_distance, hit);
+                    mismatches += any != (nearest <= max_distance);
+                    mismatches += any && std::abs(hit.distance - nearest) > 1e-4f * std::max(1.0f, nearest);
+                    // The object reported is one the ray enters at that distance.
+                    mismatches += any && std::abs(RayEntry(bounds[hit.object], origin, direction, max_distance) -
+                                                  hit.distance) > 1e-4f * std::max(1.0f, hit.distance);
+                    hits += any;
+                }
+            }
+        }
+        GFW_CHECK(mismatches == 0);
+        GFW_CHECK(hits > 100);
+    }
+
+    // Small moves refit only the path to the root; nothing moving refits nothing.
+    void TestRefitIsLocal() {
+        std::mt19937 rng(2);
+        std::vector<Bounds> bounds = Scene(10000, 600.0f, rng);
+        SceneBvh bvh;
+        bvh.Build(bounds);
+        GFW_CHECK(bvh.Refit() == 0);
+        Bounds moved = bounds[17];
+        moved.min.x += 0.25f;
+        moved.max.x += 0.25f;
+        bvh.Update(17, moved);
+        const size_t refit = bvh.Refit();
+        GFW_CHECK(refit > 0 && refit < 64);
+        std::vector<std::uint32_t> found;
+        bvh.QuerySphere({(moved.min.x + moved.max.x) * 0.5f, (moved.min.y + moved.max.y) * 0.5f,
+                         (moved.min.z + moved.max.z) * 0.5f}, 0.0f, found);
+        GFW_CHECK(std::find(found.begin(), found.end(), 17u) != found.end());
+    }
+
+    // Build, refit and query cost against testing every object, from 1k to 1M objects at constant density.
+    void BenchmarkBvh() {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for (const size_t count : {1000u, 10000u, 100000u, 1000000u}) {
+            const float half = std::sqrt(static_cast<float>(count)) * 6.0f;
+            const std::vector<Bounds> bounds = Scene(count, half, rng);
+            SceneBvh bvh;
+            const double build_ms = test::MeasureMs([&] { bvh.Build(bounds); });
+            size_t refit_nodes = 0;
+            const double refit_ms = test::MeasureMs([&] {
+                for (size_t k = 0; k < count / 10; ++k) {
+                    const size_t i = (k * 7919) % count;
+                    Bounds b = bounds[i];
+                    b.min.x += 0.3f;
+                    b.max.x += 0.3f;
+                    bvh.Update(static_cast<std::uint32_t>(i), b);
+                }
+                refit_nodes = bvh.Refit();
+            });
+
+            const int repeats = count >= 1000000 ? 10 : 100;
+            std::vector<FrustumCuller::Frustum> frustums;
+            for (int r = 0; r < repeats; ++r) {
+                frustums.push_back(CameraFrustum(unit(rng) * half, unit(rng) * half));
+            }
+            std::vector<std::uint32_t> out;
+            size_t tree_visible = 0;
+            const double tree_ms = test::MeasureMs([&] {
+                for (const FrustumCuller::Frustum &frustum : frustums) {
+                    out.clear();
+                    bvh.QueryFrustum(frustum, out);
+                    tree_visible += out.size();
+                }
+            });
+            FrustumCuller culler;
+            culler.Resize(count);
+            XMFLOAT4X4 identity = {};
+            identity._11 = identity._22 = identity._33 = identity._44 = 1.0f;
+            for (size_t i = 0; i < count; ++i) {
+                if (!SceneBvh::IsEmpty(bounds[i])) {
+                    culler.SetBounds(i, bounds[i].min, bounds[i].max, std::numeric_limits<float>::max(), identity);
+                }
+            }
+            size_t linear_visible = 0;
+            const double linear_ms = test::MeasureMs([&] {
+                for (const FrustumCuller::Frustum &frustum : frustums) {
+                    culler.Cull(frustum, out);
+                    linear_visible += out.size();
+                }
+            });
+
+            constexpr int kRays = 2000;
+            size_t ray_hits = 0;
+            const double ray_ms = test::MeasureMs([&] {
+                for (int k = 0; k < kRays; ++k) {
+                    SceneBvh::RayHit hit;
+                    ray_hits += bvh.QueryRay({unit(rng) * half, 0.0f, unit(rng) * half},
+                                             {unit(rng), unit(rng) * 0.1f, unit(rng)}, 1e30f, hit);
+                }
+            });
+            size_t brute_hits = 0;
+            const double brute_ray_ms = test::MeasureMs([&] {
+                for (int k = 0; k < 10; ++k) {
+                    const XMFLOAT3 origin = {unit(rng) * half, 0.0f, unit(rng) * half};
+                    const XMFLOAT3 direction = {unit(rng), unit(rng) * 0.1f, unit(rng)};
+                    float nearest = kNoHit;
+                    for (const Bounds &b : bounds) {
+                        if (!SceneBvh::IsEmpty(b)) {
+                            nearest = std::min(nearest, RayEntry(b, origin, direction, 1e30f));
+                        }
+                    }
+                    brute_hits += nearest != kNoHit;
+                }
+            });
+            std::printf("%8zu objects, %7zu nodes: build %8.2f ms, refit 10%% %7.2f ms (%zu nodes)\n", count,
+                        bvh.NodeCount(), build_ms, refit_ms, refit_nodes);
+            std::printf("    frustum %8.1f us (tree, %.0f visible) vs %8.1f us (SIMD linear, %.0f visible)\n",
+                        tree_ms * 1e3 / repeats, static_cast<double>(tree_visible) / repeats,
+                        linear_ms * 1e3 / repeats, static_cast<double>(linear_visible) / repeats);
+            std::printf("    ray     %8.2f us (tree, %.0f%% hit) vs %8.1f us (every object, %zu/10 hit)\n",
+                        ray_ms * 1e3 / kRays, 100.0 * static_cast<double>(ray_hits) / kRays,
+                        brute_ray_ms * 1e3 / 10, brute_hits);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestWorldBounds();
+    TestQueriesMatchBruteForce();
+    TestRefitIsLocal();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkBvh();
+    }
+    return test::Result("SceneBvhTests");
+}
@@ -0,0 +1,173 @@
+#include "TestHarness.h"
+#include "GeometryPermutations.h"
+#include "framework/ShaderPermutation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    // "file|entry|DEFINE=1;DEFINE=1", the lookup key of ShaderTable.inc.
+    std::string ShaderKey(const std::string &file, const std::string &entry, const std::vector<std::string> &defines) {
+        std::string key = file + "|" + entry + "|";
+        for (size_t i = 0; i < defines.size(); ++i) {
+            key += (i ? ";" : "") + defines[i];
+        }
+        return key;
+    }
+
+    // Expands shaders/Shaders.cmake the way cmake/EmbedShaders.cmake does, without compiling anything.
+    std::set<std::string> EmbeddedShaderKeys() {
+        std::ifstream in(GFW_SOURCE_DIR "/shaders/Shaders.cmake");
+        std::set<std::string> keys;
+        const std::regex single(R"(^gfw_add_shader\((\S+) ENTRY (\S+) PROFILE \S+(?: DEFINES ([^)]*))?\))");
+        const std::regex permutations(
+            R"(^gfw_add_shader_permutations\((\S+) ENTRY (\S+) PROFILE \S+ FEATURES ([^)]*)\))");
+        const auto split = [](const std::string &list) {
+            std::istringstream words(list);
+            std::vector<std::string> out;
+            for (std::string word; words >> word;) {
+                out.push_back(word);
+            }
+            return out;
+        };
+        for (std::string line; std::getline(in, line);) {
+            std::smatch match;
+            if (std::regex_search(line, match, single)) {
+                keys.insert(ShaderKey(match[1], match[2], split(match[3])));
+            } else if (std::regex_search(line, match, permutations)) {
+                const std::vector<std::string> features = split(match[3]);
+                for (std::uint32_t subset = 0; subset < (1u << features.size()); ++subset) {
+                    std::vector<std::string> defines;
+                    for (size_t i = 0; i < features.size(); ++i) {
+                        if (subset & (1u << i)) {
+                            defines.push_back(features[i] + "=1");
+                        }
+                    }
+                    keys.insert(ShaderKey(match[1], match[2], defines));
+                }
+            }
+        }
+        return keys;
+    }
+
+    std::string GeometryShaderKey(const char *file, const char *entry, std::uint32_t features, GeometryStage stage) {
+        const StageDefines stage_defines = GeometryStageDefines(features, stage);
+        std::vector<std::string> defines;
+        for (std::uint32_t i = 0; i < stage_defines.count; ++i) {
+            defines.push_back(std::string(stage_defines.names[i]) + "=1");
+        }
+        return ShaderKey(file, entry, defines);
+    }
+
+    void TestKeyHash() {
+        // Persisted pipelines are named by the hash, so it must never change.
+        GFW_CHECK(PermutationKey().Hash() == 0xa8c7f832281a39c5ull);
+        GFW_CHECK((PermutationKey{1, 0}.Hash() != PermutationKey{0, 1}.Hash()));
+        const PermutationKey key = {2, 9};
+        GFW_CHECK(PermutationKeyHash()(key) == static_cast<size_t>(key.Hash()));
+        std::set<std::uint64_t> hashes;
+        size_t keys = 0;
+        for (std::uint32_t pass = 0; pass < 8; ++pass) {
+            for (std::uint32_t features = 0; features < 4096; ++features) {
+                hashes.insert(PermutationKey{pass, features}.Hash());
+                ++keys;
+            }
+        }
+        GFW_CHECK(hashes.size() == keys);
+    }
+
+    void TestEnumeration() {
+        const std::vector<std::uint32_t> permutations = EnumerateGeometryPermutations();
+        // Displacement without tessellation folds into the same pipeline as no displacement.
+        GFW_CHECK(permutations.size() == 128 - 32);
+        GFW_CHECK(std::is_sorted(permutations.begin(), permutations.end()));
+        for (std::uint32_t features = 0; features < (1u << kGeometryFeatureCount); ++features) {
+            const std::uint32_t normalized = NormalizeGeometryFeatures(features);
+            GFW_CHECK(NormalizeGeometryFeatures(normalized) == normalized);
+            GFW_CHECK(std::binary_search(permutations.begin(), permutations.end(), normalized));
+        }
+        GFW_CHECK(NormalizeGeometryFeatures(kGeometryDisplacement | kGeometryAlphaTest) == kGeometryAlphaTest);
+        GFW_CHECK(NormalizeGeometryFeatures(kGeometryDisplacement | kGeometryTessellation) ==
+                  (kGeometryDisplacement | kGeometryTessellation));
+    }
+
+    // Every stage of every pipeline the GBuffer pass can ask for has an embedded blob with exactly its defines.
+    void TestEveryPermutationIsEmbedded() {
+        const std::set<std::string> embedded = EmbeddedShaderKeys();
+        GFW_CHECK(!embedded.empty());
+        bool complete = true;
+        for (const std::uint32_t features : EnumerateGeometryPermutations()) {
+            complete &= embedded.count(GeometryShaderKey("GBufferVertex.hlsl", "VSMain", features,
+                                                         GeometryStage::Vertex)) == 1;
+            complete &= embedded.count(GeometryShaderKey("GBufferPixel.hlsl", "PSMain", features,
+                                                         GeometryStage::Pixel)) == 1;
+            if (features & kGeometryTessellation) {
+                complete &= embedded.count(GeometryShaderKey("GBufferTessHull.hlsl", "HSMain", features,
+                                                             GeometryStage::Hull)) == 1;
+                complete &= embedded.count(GeometryShaderKey("GBufferTessDomain.hlsl", "DSMain", features,
+                                                             GeometryStage::Domain)) == 1;
+            }
+        }
+        GFW_CHECK(complete);
+
+        // Absent features compile out instead of being tested per pixel.
+        GFW_CHECK(GeometryStageDefines(0, GeometryStage::Pixel).count == 0);
+        GFW_CHECK(GeometryStageDefines(kGeometryVertexTangents, GeometryStage::Pixel).count == 0);
+        GFW_CHECK(GeometryStageDefines(kGeometryWireframe | kGeometryTessellation, GeometryStage::Domain).count == 0);
+    }
+
+    // Pipelines the GBuffer pass can ask for and the blobs they need, plus the cost of a key lookup.
+    void BenchmarkPermutations() {
+        const std::vector<std::uint32_t> permutations = EnumerateGeometryPermutations();
+        const std::set<std::string> embedded = EmbeddedShaderKeys();
+        std::set<std::string> used;
+        for (const std::uint32_t features : permutations) {
+            used.insert(GeometryShaderKey("GBufferVertex.hlsl", "VSMain", features, GeometryStage::Vertex));
+            used.insert(GeometryShaderKey("GBufferPixel.hlsl", "PSMain", features, GeometryStage::Pixel));
+            if (features & kGeometryTessellation) {
+                used.insert(GeometryShaderKey("GBufferTessHull.hlsl", "HSMain", features, GeometryStage::Hull));
+                used.insert(GeometryShaderKey("GBufferTessDomain.hlsl", "DSMain", features, GeometryStage::Domain));
+            }
+        }
+        std::printf("%zu GBuffer pipelines use %zu of %zu embedded shaders\n", permutations.size(), used.size(),
+                    embedded.size());
+
+        std::unordered_map<PermutationKey, std::uint32_t, PermutationKeyHash> pipelines;
+        for (const std::uint32_t features : permutations) {
+            pipelines[{1, features}] = features;
+        }
+        std::uint32_t seed = 4;
+        const auto next = [&seed] { return (seed = seed * 1103515245u + 12345u) >> 16; };
+        std::vector<PermutationKey> draws(100000);
+        for (PermutationKey &key : draws) {
+            key = {1, NormalizeGeometryFeatures(next() % (1u << kGeometryFeatureCount))};
+        }
+        std::uint64_t found = 0;
+        const double ms = test::MeasureMs([&] {
+            for (const PermutationKey &key : draws) {
+                found += pipelines.find(key)->second;
+            }
+        });
+        std::printf("%zu draws: %.1f ns per pipeline lookup (checksum %llu)\n", draws.size(),
+                    ms * 1e6 / static_cast<double>(draws.size()), static_cast<unsigned long long>(found));
+    }
+}
+
+int main(int argc, char **argv) {
+    TestKeyHash();
+    TestEnumeration();
+    TestEveryPermutationIsEmbedded();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkPermutations();
+    }
+    return test::Result("ShaderPermutationTests");
+}
@@ -0,0 +1,168 @@
+#include "TestHarness.h"
+#include "framework/StreamingTimeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    constexpr std::uint64_t kNotResident = StreamingTimeline::kNotResident;
+
+    void TestFrameDecisions() {
+        StreamingTimeline timeline;
+        timeline.BeginFrame(3);
+        // Resident before the frame started: no wait.
+        GFW_CHECK(timeline.Use(0) && timeline.Use(3) && timeline.WaitValue() == 0);
+        // Never submitted: substituted, and it does not make the frame wait.
+        GFW_CHECK(!timeline.Use(kNotResident) && timeline.PlaceholderCount() == 1 && timeline.WaitValue() == 0);
+        // Submitted but not complete: the frame waits for the latest one it uses.
+        GFW_CHECK(timeline.Use(5) && timeline.Use(4) && timeline.WaitValue() == 5);
+        GFW_CHECK(!timeline.Use(kNotResident) && timeline.PlaceholderCount() == 2);
+
+        timeline.BeginFrame(5);
+        GFW_CHECK(timeline.WaitValue() == 0 && timeline.PlaceholderCount() == 0);
+        GFW_CHECK(timeline.Use(5) && timeline.WaitValue() == 0);
+    }
+
+    // Streaming resources as the renderer sees them: kNotResident until a copy batch is submitted, then the
+    // batch's fence value.
+    struct StreamSimulation {
+        std::vector<std::uint64_t> resident;
+        size_t next_pending = 0;
+        std::uint64_t submitted = 0;
+        std::uint64_t completed = 0;
+
+        explicit StreamSimulation(size_t resources) : resident(resources, kNotResident) {}
+
+        // The copy thread records the next `count` pending resources into one batch.
+        void SubmitBatch(size_t count) {
+            ++submitted;
+            for (; count > 0 && next_pending < resident.size(); --count) {
+                resident[next_pending++] = submitted;
+            }
+        }
+    };
+
+    // Random frames against a copy queue that lags: the frame never waits for more than it uses, and never
+    // references a resource without either being resident or waiting for it.
+    void TestRandomFrames() {
+        StreamSimulation stream(512);
+        StreamingTimeline timeline;
+        std::uint32_t seed = 11;
+        const auto next = [&seed] { return (seed = seed * 1103515245u + 12345u) >> 16; };
+        bool safe = true;
+        bool minimal = true;
+        std::uint32_t placeholders = 0;
+        for (int frame = 0; frame < 2000; ++frame) {
+            if (next() % 3 == 0) {
+                stream.SubmitBatch(1 + next() % 8);
+            }
+            stream.completed = std::min(stream.submitted, stream.completed + next() % 2);
+            timeline.BeginFrame(stream.completed);
+            std::uint64_t needed = 0;
+            for (int draw = 0; draw < 64; ++draw) {
+                const std::uint64_t value = stream.resident[next() % stream.resident.size()];
+                const bool used = timeline.Use(value);
+                safe &= used == (value != kNotResident);
+                if (used && value > stream.completed) {
+                    needed = std::max(needed, value);
+                }
+            }
+            // The queue waits exactly for the newest pending resource the frame drew with.
+            minimal &= timeline.WaitValue() == needed;
+            safe &= timeline.WaitValue() <= stream.submitted;
+            placeholders += timeline.PlaceholderCount();
+        }
+        GFW_CHECK(safe && minimal);
+        GFW_CHECK(placeholders > 0);
+    }
+
+    // The copy thread publishes fence values while the render thread builds frames, as in AssetStreamer. A
+    // resource's value is published before its fence can complete, so a frame never sees it complete early.
+    void TestConcurrentCopyThread() {
+        constexpr size_t kResources = 4096;
+        std::vector<std::atomic<std::uint64_t>> resident(kResources);
+        for (auto &value: resident) {
+            value.store(kNotResident, std::memory_order_relaxed);
+        }
+        std::atomic<std::uint64_t> completed{0};
+        std::thread copy([&] {
+            std::uint64_t fence = 0;
+            for (size_t i = 0; i < kResources; i += 16) {
+                ++fence;
+                for (size_t k = i; k < i + 16; ++k) {
+                    resident[k].store(fence, std::memory_order_release);
+                }
+                if (fence > 2) {
+                    completed.store(fence - 2, std::memory_order_release);
+                }
+            }
+            completed.store(fence, std::memory_order_release);
+        });
+        StreamingTimeline timeline;
+        bool consistent = true;
+        std::uint64_t frames = 0;
+        for (std::uint64_t seen = 0; seen < kResources / 16; ++frames) {
+            seen = completed.load(std::memory_order_acquire);
+            timeline.BeginFrame(seen);
+            for (size_t k = 0; k < kResources; k += 97) {
+                const std::uint64_t value = resident[k].load(std::memory_order_acquire);
+                // A completed batch was fully published before its fence advanced.
+                consistent &= !(value == kNotResident && k < seen * 16);
+                timeline.Use(value);
+            }
+            consistent &= timeline.WaitValue() == 0 || timeline.WaitValue() > seen;
+        }
+        copy.join();
+        GFW_CHECK(consistent && frames > 0);
+    }
+
+    // Frames that wait on uploads: on a single queue every frame is ordered behind everything submitted; with the
+    // timeline a frame waits only when it draws a pending resource.
+    void BenchmarkWaits() {
+        for (const int draws: {16, 128, 1024}) {
+            StreamSimulation stream(4096);
+            StreamingTimeline timeline;
+            std::uint32_t seed = 5;
+            const auto next = [&seed] { return (seed = seed * 1103515245u + 12345u) >> 16; };
+            std::uint64_t single_queue_waits = 0;
+            std::uint64_t timeline_waits = 0;
+            std::uint64_t placeholders = 0;
+            constexpr int kFrames = 3000;
+            const double ms = test::MeasureMs([&] {
+                for (int frame = 0; frame < kFrames; ++frame) {
+                    stream.SubmitBatch(4);
+                    // The copy queue finishes one batch per frame but starts three frames behind.
+                    stream.completed = frame > 3 ? stream.submitted - 3 : 0;
+                    timeline.BeginFrame(stream.completed);
+                    for (int d = 0; d < draws; ++d) {
+                        timeline.Use(stream.resident[next() % std::min<size_t>(stream.resident.size(),
+                                                                               4 * stream.submitted + 64)]);
+                    }
+                    single_queue_waits += stream.submitted > stream.completed;
+                    timeline_waits += timeline.WaitValue() != 0;
+                    placeholders += timeline.PlaceholderCount();
+                }
+            });
+            std::printf("%5d draws/frame: frames stalled on uploads %5llu single queue, %5llu timeline; %.1f "
+                        "placeholders/frame, %.1f ns per Use\n",
+                        draws, static_cast<unsigned long long>(single_queue_waits),
+                        static_cast<unsigned long long>(timeline_waits),
+                        static_cast<double>(placeholders) / kFrames, ms * 1e6 / (static_cast<double>(kFrames) * draws));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestFrameDecisions();
+    TestRandomFrames();
+    TestConcurrentCopyThread();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkWaits();
+    }
+    return test::Result("StreamingTimelineTests");
+}
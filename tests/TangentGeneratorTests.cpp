@@ -0,0 +1,179 @@
+#include "MeshLoader.h"
+#include "TangentGenerator.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    struct TangentVertex {
+        float p[3];
+        float n[3];
+        float uv[2];
+        float t[4];
+    };
+    static_assert(sizeof(TangentVertex) == 48);
+
+    struct FrameErrors {
+        float worst_degrees = 0.0f;
+        int handedness_mismatches = 0;
+    };
+
+    float AngleDegrees(const float a[3], const float b[3]) {
+        const double cx = double{a[1]} * b[2] - double{a[2]} * b[1];
+        const double cy = double{a[2]} * b[0] - double{a[0]} * b[2];
+        const double cz = double{a[0]} * b[1] - double{a[1]} * b[0];
+        const double dot = double{a[0]} * b[0] + double{a[1]} * b[1] + double{a[2]} * b[2];
+        return static_cast<float>(std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / 3.14159265358979);
+    }
+
+    // Reference frame per triangle: dP/du gives the tangent and dP/dv the bitangent, exact for planar faces with
+    // affine UVs. Every corner's generated tangent must match its face's, and w must give the same bitangent side.
+    FrameErrors CompareWithFaceFrames(const MeshData &mesh) {
+        FrameErrors errors;
+        std::vector<TangentVertex> v(mesh.vertex_count);
+        std::memcpy(v.data(), mesh.vertex_data.data(), v.size() * sizeof(TangentVertex));
+        for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            const TangentVertex &a = v[mesh.indices[t]];
+            const TangentVertex &b = v[mesh.indices[t + 1]];
+            const TangentVertex &c = v[mesh.indices[t + 2]];
+            float e1[3];
+            float e2[3];
+            for (int k = 0; k < 3; ++k) {
+                e1[k] = b.p[k] - a.p[k];
+                e2[k] = c.p[k] - a.p[k];
+            }
+            const float du1 = b.uv[0] - a.uv[0];
+            const float dv1 = b.uv[1] - a.uv[1];
+            const float du2 = c.uv[0] - a.uv[0];
+            const float dv2 = c.uv[1] - a.uv[1];
+            const float det = du1 * dv2 - du2 * dv1;
+            if (std::fabs(det) < 1e-12f) {
+                continue;
+            }
+            float tangent[3];
+            float bitangent[3];
+            for (int k = 0; k < 3; ++k) {
+                tangent[k] = (e1[k] * dv2 - e2[k] * dv1) / det;
+                bitangent[k] = (e2[k] * du1 - e1[k] * du2) / det;
+            }
+            for (int k = 0; k < 3; ++k) {
+                const TangentVertex &corner = v[mesh.indices[t + k]];
+                errors.worst_degrees = std::max(errors.worst_degrees, AngleDegrees(tangent, corner.t));
+                const float side[3] = {corner.n[1] * corner.t[2] - corner.n[2] * corner.t[1],
+                                       corner.n[2] * corner.t[0] - corner.n[0] * corner.t[2],
+                                       corner.n[0] * corner.t[1] - corner.n[1] * corner.t[0]};
+                const float s = side[0] * bitangent[0] + side[1] * bitangent[1] + side[2] * bitangent[2];
+                errors.handedness_mismatches += (s >= 0.0f) != (corner.t[3] > 0.0f);
+            }
+        }
+        return errors;
+    }
+
+    void TestRepositoryAssets() {
+        for (const char *asset: {"bricks2/cube.obj", "bricks2/wall.obj"}) {
+            ObjModelData model = MeshLoader::LoadObjModel((std::filesystem::path(GFW_SOURCE_DIR) / asset).wstring());
+            MeshLoader::GenerateTangents(model);
+            size_t meshes = 0;
+            for (const ObjSubmeshData &sub: model.submeshes) {
+                if (sub.mesh.vertex_count == 0) {
+                    continue;
+                }
+                ++meshes;
+                GFW_CHECK(sub.mesh.has_tangents && sub.mesh.vertex_stride == sizeof(TangentVertex));
+                const FrameErrors errors = CompareWithFaceFrames(sub.mesh);
+                GFW_CHECK(errors.worst_degrees < 0.01f);
+                GFW_CHECK(errors.handedness_mismatches == 0);
+            }
+            GFW_CHECK(meshes > 0);
+        }
+    }
+
+    // Two quads sharing an edge with mirrored U, as on a symmetric character: the shared vertices get one copy per
+    // handedness.
+    void TestMirroredUvsSplit() {
+        const std::vector<test::TestVertex> vertices = {
+            {0, 0, 0, 0, 1, 0, 0, 0}, {1, 0, 0, 0, 1, 0, 1, 0}, {1, 0, 1, 0, 1, 0, 1, 1},
+            {0, 0, 1, 0, 1, 0, 0, 1}, {2, 0, 0, 0, 1, 0, 0, 0}, {2, 0, 1, 0, 1, 0, 0, 1},
+        };
+        MeshData mesh = test::MeshFromVertices(vertices, {0, 2, 1, 0, 3, 2, 1, 2, 5, 1, 5, 4});
+        GFW_CHECK(TangentGenerator::Generate(mesh));
+        GFW_CHECK(mesh.vertex_count == 8);
+        const FrameErrors errors = CompareWithFaceFrames(mesh);
+        GFW_CHECK(errors.worst_degrees < 0.01f);
+        GFW_CHECK(errors.handedness_mismatches == 0);
+    }
+
+    // On a curved surface the frame is averaged, but stays unit length and orthogonal to the normal.
+    void TestCurvedSurfaceFrames() {
+        MeshData mesh = test::SphereMesh(32, 64);
+        GFW_CHECK(TangentGenerator::Generate(mesh));
+        std::vector<TangentVertex> v(mesh.vertex_count);
+        std::memcpy(v.data(), mesh.vertex_data.data(), v.size() * sizeof(TangentVertex));
+        float worst_length = 0.0f;
+        float worst_dot = 0.0f;
+        for (const TangentVertex &x: v) {
+            const float length = std::sqrt(x.t[0] * x.t[0] + x.t[1] * x.t[1] + x.t[2] * x.t[2]);
+            worst_length = std::max(worst_length, std::fabs(length - 1.0f));
+            worst_dot = std::max(worst_dot, std::fabs(x.t[0] * x.n[0] + x.t[1] * x.n[1] + x.t[2] * x.n[2]));
+        }
+        GFW_CHECK(worst_length < 1e-4f);
+        GFW_CHECK(worst_dot < 1e-4f);
+    }
+
+    void TestRejectedLayouts() {
+        MeshData mesh = test::GridMesh(2);
+        GFW_CHECK(TangentGenerator::Generate(mesh));
+        const std::vector<std::uint8_t> data = mesh.vertex_data;
+        GFW_CHECK(!TangentGenerator::Generate(mesh));
+        GFW_CHECK(mesh.vertex_data == data);
+        MeshData patches = test::GridMesh(2);
+        patches.topology = PrimitiveTopology::PatchList3;
+        GFW_CHECK(!TangentGenerator::Generate(patches) && !patches.has_tangents);
+    }
+
+    void TestParallelMatchesSerial() {
+        ObjModelData serial;
+        for (std::uint32_t i = 0; i < 8; ++i) {
+            serial.submeshes.push_back({});
+            serial.submeshes.back().mesh = i % 2 ? test::SphereMesh(8 + i, 16 + i) : test::GridMesh(4 + i);
+        }
+        ObjModelData parallel = serial;
+        MeshLoader::GenerateTangents(serial, 1);
+        MeshLoader::GenerateTangents(parallel, 4);
+        bool same = true;
+        for (size_t i = 0; i < serial.submeshes.size(); ++i) {
+            same &= serial.submeshes[i].mesh.vertex_data == parallel.submeshes[i].mesh.vertex_data &&
+                    serial.submeshes[i].mesh.indices == parallel.submeshes[i].mesh.indices;
+        }
+        GFW_CHECK(same);
+    }
+
+    void BenchmarkGenerate() {
+        for (const std::uint32_t rings: {128u, 512u}) {
+            MeshData mesh = test::SphereMesh(rings, rings * 2);
+            const std::uint32_t vertices = mesh.vertex_count;
+            const double ms = test::MeasureMs([&] { TangentGenerator::Generate(mesh); });
+            std::printf("tangents, sphere %ux%u: %u vertices, %zu triangles, %.1f ms, %.1f Mvertices/s\n", rings,
+                        rings * 2, vertices, mesh.indices.size() / 3, ms, vertices / ms / 1000.0);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestRepositoryAssets();
+    TestMirroredUvsSplit();
+    TestCurvedSurfaceFrames();
+    TestRejectedLayouts();
+    TestParallelMatchesSerial();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkGenerate();
+    }
+    return test::Result("TangentGeneratorTests");
+}
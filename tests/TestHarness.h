@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+// Shared by the test executables: GFW_CHECK reports a failed expression and keeps going, and main returns
+// Result() so ctest marks the executable as failed. Benchmarks only run when --benchmark is passed.
+namespace gfw::test {
+    inline int &FailureCount() {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool Check(bool passed, const char *expression, const char *file, int line) {
+        if (!passed) {
+            ++FailureCount();
+            std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+        }
+        return passed;
+    }
+
+    inline bool BenchmarkRequested(int argc, char **argv) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--benchmark") == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Fn>
+    double MeasureMs(Fn &&fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Empty directory under the system temp directory for files a test writes; recreated on every run.
+    inline std::filesystem::path ScratchDirectory(const char *name) {
+        std::error_code error;
+        const std::filesystem::path path = std::filesystem::temp_directory_path(error) / name;
+        std::filesystem::remove_all(path, error);
+        std::filesystem::create_directories(path, error);
+        return path;
+    }
+
+    inline int Result(const char *name) {
+        if (FailureCount() > 0) {
+            std::cerr << name << ": " << FailureCount() << " check(s) failed" << std::endl;
+            return 1;
+        }
+        std::cout << name << ": all checks passed" << std::endl;
+        return 0;
+    }
+}
+
+#define GFW_CHECK(expression) ::gfw::test::Check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Synthetic assets for the tests and benchmarks, generated at run time so the tree carries no binary fixtures.
+namespace gfw::test {
+    inline bool WriteTextFile(const std::filesystem::path &path, const std::string &text) {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+        return static_cast<bool>(file);
+    }
+
+    // Wavy grid of quads_per_side^2 quads in bands of `materials` materials that repeat, so submeshes are revisited
+    // after other materials. Rows cycle through the face forms the loader accepts (v, v/vt, v//vn, v/vt/vn, negative
+    // indices, quads and triangles), with comments, tabs, CRLF endings and exponent notation mixed in.
+    inline std::string SyntheticObj(std::uint32_t quads_per_side, std::uint32_t materials) {
+        const std::uint32_t side = quads_per_side + 1;
+        std::string obj = "# synthetic grid\nmtllib synthetic.mtl\n";
+        obj.reserve(static_cast<size_t>(side) * side * 120);
+        char line[160];
+        for (std::uint32_t y = 0; y < side; ++y) {
+            for (std::uint32_t x = 0; x < side; ++x) {
+                const float height = static_cast<float>((x * 7 + y * 13) % 17) * 0.25f;
+                std::snprintf(line, sizeof(line), (x + y) % 5 == 0 ? "v\t%g %g %e\r\n" : "v %g %g %g\n",
+                              static_cast<double>(x) * 10.0, static_cast<double>(height),
+                              static_cast<double>(y) * 10.0);
+                obj += line;
+                std::snprintf(line, sizeof(line), "vt %g %g\n", static_cast<double>(x) / quads_per_side,
+                              static_cast<double>(y) / quads_per_side);
+                obj += line;
+                std::snprintf(line, sizeof(line), "vn %g 1 %g\n", static_cast<double>(height) * 0.1,
+                              -static_cast<double>(height) * 0.05);
+                obj += line;
+            }
+        }
+        const std::uint32_t vertex_count = side * side;
+        const std::uint32_t band = materials > 0 ? std::max(1u, quads_per_side / (materials * 2)) : 1;
+        for (std::uint32_t y = 0; y < quads_per_side; ++y) {
+            if (materials > 0 && y % band == 0) {
+                std::snprintf(line, sizeof(line), "usemtl material_%u\n", (y / band) % materials);
+                obj += line;
+            }
+            if (y % 11 == 3) {
+                obj += "# comment between faces\n\n";
+            }
+            for (std::uint32_t x = 0; x < quads_per_side; ++x) {
+                const std::uint32_t a = y * side + x + 1;
+                const std::uint32_t b = a + 1;
+                const std::uint32_t c = a + side + 1;
+                const std::uint32_t d = a + side;
+                switch (y % 6) {
+                    case 0:
+                        std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b,
+                                      c, c, c, d, d, d);
+                        break;
+                    case 1:
+                        std::snprintf(line, sizeof(line),
+                                      "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b,
+                                      b, c, c, c, a, a, a, c, c, c, d, d, d);
+                        break;
+                    case 2: {
+                        const int na = static_cast<int>(a) - static_cast<int>(vertex_count) - 1;
+                        const int nb = na + 1;
+                        const int nc = na + static_cast<int>(side) + 1;
+                        const int nd = na + static_cast<int>(side);
+                        std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", na, na, na, nb,
+                                      nb, nb, nc, nc, nc, nd, nd, nd);
+                        break;
+                    }
+                    case 3:
+                        std::snprintf(line, sizeof(line), "f %u//%u %u//%u %u//%u %u//%u\n", a, a, b, b, c, c, d, d);
+                        break;
+                    case 4:
+                        std::snprintf(line, sizeof(line), "f %u/%u %u/%u %u/%u %u/%u\r\n", a, a, b, b, c, c, d, d);
+                        break;
+                    default:
+                        std::snprintf(line, sizeof(line), "f %u %u %u %u\n", a, b, c, d);
+                        break;
+                }
+                obj += line;
+            }
+        }
+        return obj;
+    }
+
+    inline std::string SyntheticMtl(std::uint32_t materials) {
+        std::string mtl;
+        char line[96];
+        for (std::uint32_t i = 0; i < materials; ++i) {
+            std::snprintf(line, sizeof(line), "newmtl material_%u\nKd %g 0.5 0.25\nmap_Kd textures/t%u.png\n\n", i,
+                          static_cast<double>(i) / materials, i);
+            mtl += line;
+        }
+        return mtl;
+    }
+
+    // Float32 vertex as laid out by MeshLoader.
+    struct TestVertex {
+        float px, py, pz;
+        float nx, ny, nz;
+        float u, v;
+    };
+
+    inline MeshData MeshFromVertices(const std::vector<TestVertex> &vertices, std::vector<std::uint32_t> indices) {
+        MeshData mesh;
+        mesh.vertex_stride = sizeof(TestVertex);
+        mesh.vertex_count = static_cast<std::uint32_t>(vertices.size());
+        mesh.vertex_data.resize(vertices.size() * sizeof(TestVertex));
+        std::memcpy(mesh.vertex_data.data(), vertices.data(), mesh.vertex_data.size());
+        mesh.indices = std::move(indices);
+        if (!vertices.empty()) {
+            mesh.bounds_min = {vertices[0].px, vertices[0].py, vertices[0].pz};
+            mesh.bounds_max = mesh.bounds_min;
+            for (const TestVertex &v: vertices) {
+                mesh.bounds_min = {std::min(mesh.bounds_min.x, v.px), std::min(mesh.bounds_min.y, v.py),
+                                   std::min(mesh.bounds_min.z, v.pz)};
+                mesh.bounds_max = {std::max(mesh.bounds_max.x, v.px), std::max(mesh.bounds_max.y, v.py),
+                                   std::max(mesh.bounds_max.z, v.pz)};
+            }
+            const float cx = 0.5f * (mesh.bounds_min.x + mesh.bounds_max.x);
+            const float cy = 0.5f * (mesh.bounds_min.y + mesh.bounds_max.y);
+            const float cz = 0.5f * (mesh.bounds_min.z + mesh.bounds_max.z);
+            float radius_sq = 0.0f;
+            for (const TestVertex &v: vertices) {
+                radius_sq = std::max(radius_sq, (v.px - cx) * (v.px - cx) + (v.py - cy) * (v.py - cy) +
+                                                    (v.pz - cz) * (v.pz - cz));
+            }
+            mesh.bounds_radius = std::sqrt(radius_sq);
+        }
+        return mesh;
+    }
+
+    // Unit-square grid in the xz plane with a gentle height wave, quads_per_side^2 quads in row order.
+    inline MeshData GridMesh(std::uint32_t quads_per_side) {
+        const std::uint32_t side = quads_per_side + 1;
+        const float step = 1.0f / static_cast<float>(quads_per_side);
+        std::vector<TestVertex> vertices;
+        vertices.reserve(static_cast<size_t>(side) * side);
+        for (std::uint32_t z = 0; z < side; ++z) {
+            for (std::uint32_t x = 0; x < side; ++x) {
+                const float u = static_cast<float>(x) * step;
+                const float v = static_cast<float>(z) * step;
+                const float height = 0.05f * std::sin(6.0f * u) * std::cos(4.0f * v);
+                vertices.push_back({u, height, v, 0.0f, 1.0f, 0.0f, u, v});
+            }
+        }
+        std::vector<std::uint32_t> indices;
+        indices.reserve(static_cast<size_t>(quads_per_side) * quads_per_side * 6);
+        for (std::uint32_t z = 0; z < quads_per_side; ++z) {
+            for (std::uint32_t x = 0; x < quads_per_side; ++x) {
+                const std::uint32_t a = z * side + x;
+                const std::uint32_t b = a + 1;
+                const std::uint32_t c = a + side + 1;
+                const std::uint32_t d = a + side;
+                indices.insert(indices.end(), {a, c, b, a, d, c});
+            }
+        }
+        return MeshFromVertices(vertices, std::move(indices));
+    }
+
+    // UV sphere of the given radius around center with outward normals.
+    inline MeshData SphereMesh(std::uint32_t rings, std::uint32_t segments, float radius = 1.0f,
+                               float cx = 0.0f, float cy = 0.0f, float cz = 0.0f) {
+        std::vector<TestVertex> vertices;
+        for (std::uint32_t r = 0; r <= rings; ++r) {
+            const float theta = 3.14159265f * static_cast<float>(r) / static_cast<float>(rings);
+            for (std::uint32_t s = 0; s <= segments; ++s) {
+                const float phi = 6.28318531f * static_cast<float>(s) / static_cast<float>(segments);
+                const float nx = std::sin(theta) * std::cos(phi);
+                const float ny = std::cos(theta);
+                const float nz = std::sin(theta) * std::sin(phi);
+                vertices.push_back({cx + radius * nx, cy + radius * ny, cz + radius * nz, nx, ny, nz,
+                                    static_cast<float>(s) / static_cast<float>(segments),
+                                    static_cast<float>(r) / static_cast<float>(rings)});
+            }
+        }
+        std::vector<std::uint32_t> indices;
+        for (std::uint32_t r = 0; r < rings; ++r) {
+            for (std::uint32_t s = 0; s < segments; ++s) {
+                const std::uint32_t a = r * (segments + 1) + s;
+                const std::uint32_t b = a + segments + 1;
+                indices.insert(indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+            }
+        }
+        return MeshFromVertices(vertices, std::move(indices));
+    }
+
+    // Appends b's vertices and triangles to a; both use the same vertex layout.
+    inline void AppendMesh(MeshData &a, const MeshData &b) {
+        const std::uint32_t base = a.vertex_count;
+        a.vertex_data.insert(a.vertex_data.end(), b.vertex_data.begin(), b.vertex_data.end());
+        for (std::uint32_t index: b.indices) {
+            a.indices.push_back(base + index);
+        }
+        a.vertex_count += b.vertex_count;
+        a.vertex_stride = b.vertex_stride;
+        a.bounds_min = {std::min(a.bounds_min.x, b.bounds_min.x), std::min(a.bounds_min.y, b.bounds_min.y),
+                        std::min(a.bounds_min.z, b.bounds_min.z)};
+        a.bounds_max = {std::max(a.bounds_max.x, b.bounds_max.x), std::max(a.bounds_max.y, b.bounds_max.y),
+                        std::max(a.bounds_max.z, b.bounds_max.z)};
+    }
+
+    // Reorders whole triangles with a fixed-seed shuffle, the worst case for the vertex cache.
+    inline void ShuffleTriangles(MeshData &mesh, std::uint32_t seed = 1) {
+        const size_t triangle_count = mesh.indices.size() / 3;
+        std::uint32_t state = seed;
+        for (size_t t = triangle_count; t > 1; --t) {
+            state = state * 1664525u + 1013904223u;
+            const size_t other = state % t;
+            for (int k = 0; k < 3; ++k) {
+                std::swap(mesh.indices[(t - 1) * 3 + k], mesh.indices[other * 3 + k]);
+            }
+        }
+    }
+
+    // Triangles of the full-detail range as vertex bytes, each rotated to start at its smallest corner (which keeps
+    // the winding) and then sorted, so meshes that draw the same surface compare equal whatever their ordering.
+    inline std::vector<std::vector<std::uint8_t>> SortedTriangles(const MeshData &mesh) {
+        const std::uint32_t stride = mesh.vertex_stride;
+        std::vector<std::vector<std::uint8_t>> triangles;
+        triangles.reserve(mesh.BaseIndexCount() / 3);
+        for (std::uint32_t t = 0; t + 2 < mesh.BaseIndexCount(); t += 3) {
+            const std::uint8_t *corners[3];
+            for (int k = 0; k < 3; ++k) {
+                corners[k] = mesh.vertex_data.data() + static_cast<size_t>(mesh.indices[t + k]) * stride;
+            }
+            int first = 0;
+            for (int k = 1; k < 3; ++k) {
+                if (std::memcmp(corners[k], corners[first], stride) < 0) {
+                    first = k;
+                }
+            }
+            std::vector<std::uint8_t> triangle(static_cast<size_t>(stride) * 3);
+            for (int k = 0; k < 3; ++k) {
+                std::memcpy(triangle.data() + static_cast<size_t>(k) * stride, corners[(first + k) % 3], stride);
+            }
+            triangles.push_back(std::move(triangle));
+        }
+        // Entries all have the same length; a memcmp of that length keeps GCC's -Wstringop-overread quiet.
+        const size_t size = static_cast<size_t>(stride) * 3;
+        std::sort(triangles.begin(), triangles.end(), [size](const auto &l, const auto &r) {
+            return std::memcmp(l.data(), r.data(), size) < 0;
+        });
+        return triangles;
+    }
+}
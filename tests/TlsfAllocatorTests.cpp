@@ -0,0 +1,250 @@
+#include "TestHarness.h"
+#include "framework/TlsfAllocator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    using Allocation = TlsfAllocator::Allocation;
+
+    void TestBasics() {
+        TlsfAllocator allocator(1024);
+        Allocation a;
+        Allocation b;
+        Allocation c;
+        GFW_CHECK(allocator.Allocate(100, 1, a) && a.offset == 0 && a.size == 100);
+        GFW_CHECK(allocator.Allocate(100, 256, b) && b.offset == 256);
+        GFW_CHECK(allocator.Used() == 200 && allocator.AllocationCount() == 2);
+        // The 156 bytes of padding in front of b went back to the free lists. Searches round up to the next size
+        // class, so a request that exactly fills the range looks one class higher; 144 bytes still fit.
+        GFW_CHECK(allocator.Allocate(144, 1, c) && c.offset == 100);
+        allocator.Free(c);
+        allocator.Free(a);
+        allocator.Free(a);
+        GFW_CHECK(allocator.AllocationCount() == 1 && allocator.Used() == 100 && allocator.Fragmentation() > 0.0);
+        allocator.Free(b);
+        // Everything merged back into one range.
+        GFW_CHECK(allocator.IsEmpty() && allocator.LargestFreeRange() == 1024 && allocator.Fragmentation() == 0.0);
+        Allocation all;
+        GFW_CHECK(allocator.Allocate(1024, 1, all) && all.offset == 0);
+        GFW_CHECK(!allocator.Allocate(1, 1, c) && allocator.Fragmentation() == 0.0);
+        allocator.Free(all);
+
+        GFW_CHECK(!allocator.Allocate(0, 1, c) && !allocator.Allocate(2048, 1, c));
+        TlsfAllocator empty;
+        GFW_CHECK(!empty.Allocate(1, 1, c) && empty.LargestFreeRange() == 0);
+    }
+
+    // Random mixed-size churn: ranges never overlap, respect alignment, add up to Used, and merge back fully.
+    void TestRandomChurn() {
+        constexpr std::uint64_t kCapacity = 64ull << 20;
+        TlsfAllocator allocator(kCapacity);
+        std::mt19937_64 rng(7);
+        std::vector<Allocation> live;
+        std::map<std::uint64_t, std::uint64_t> ranges;
+        bool valid = true;
+        std::uint64_t failures = 0;
+        for (int i = 0; i < 100000; ++i) {
+            if (live.empty() || rng() % 100 < 55) {
+                const std::uint64_t size = rng() % 2 ? (rng() % 64 + 1) * 65536 : rng() % 5000 + 1;
+                const std::uint64_t alignment = size >= 65536 ? 65536 : 1ull << (rng() % 9);
+                Allocation allocation;
+                if (!allocator.Allocate(size, alignment, allocation)) {
+                    ++failures;
+                    continue;
+                }
+                valid &= allocation.offset % alignment == 0 && allocation.offset + size <= kCapacity &&
+                         allocation.size == size;
+                auto next = ranges.lower_bound(allocation.offset);
+                valid &= next == ranges.end() || next->first >= allocation.offset + size;
+                if (next != ranges.begin()) {
+                    --next;
+                    valid &= next->first + next->second <= allocation.offset;
+                }
+                ranges[allocation.offset] = size;
+                live.push_back(allocation);
+            } else {
+                const size_t k = rng() % live.size();
+                ranges.erase(live[k].offset);
+                allocator.Free(live[k]);
+                live[k] = live.back();
+                live.pop_back();
+            }
+        }
+        std::uint64_t used = 0;
+        for (const auto &[offset, size]: ranges) {
+            used += size;
+        }
+        GFW_CHECK(valid);
+        GFW_CHECK(failures > 0 && used == allocator.Used());
+        GFW_CHECK(allocator.LargestFreeRange() <= allocator.FreeBytes());
+        for (const Allocation &allocation: live) {
+            allocator.Free(allocation);
+        }
+        GFW_CHECK(allocator.Used() == 0 && allocator.LargestFreeRange() == kCapacity);
+    }
+
+    // Reference for the benchmark: address-ordered first fit over a map of free ranges, O(free ranges) per call.
+    class FirstFitAllocator {
+    public:
+        explicit FirstFitAllocator(std::uint64_t capacity) : capacity_(capacity) { free_[0] = capacity; }
+
+        bool Allocate(std::uint64_t size, std::uint64_t alignment, Allocation &out) {
+            for (auto it = free_.begin(); it != free_.end(); ++it) {
+                const std::uint64_t aligned = (it->first + alignment - 1) & ~(alignment - 1);
+                const std::uint64_t end = it->first + it->second;
+                if (aligned + size > end) {
+                    continue;
+                }
+                const std::uint64_t begin = it->first;
+                free_.erase(it);
+                if (aligned > begin) {
+                    free_[begin] = aligned - begin;
+                }
+                if (aligned + size < end) {
+                    free_[aligned + size] = end - aligned - size;
+                }
+                used_ += size;
+                out = {0, aligned, size};
+                return true;
+            }
+            return false;
+        }
+
+        void Free(const Allocation &allocation) {
+            used_ -= allocation.size;
+            auto it = free_.emplace(allocation.offset, allocation.size).first;
+            const auto next = std::next(it);
+            if (next != free_.end() && it->first + it->second == next->first) {
+                it->second += next->second;
+                free_.erase(next);
+            }
+            if (it != free_.begin()) {
+                const auto prev = std::prev(it);
+                if (prev->first + prev->second == it->first) {
+                    prev->second += it->second;
+                    free_.erase(it);
+                }
+            }
+        }
+
+        [[nodiscard]] double Fragmentation() const {
+            std::uint64_t largest = 0;
+            for (const auto &[offset, size]: free_) {
+                largest = std::max(largest, size);
+            }
+            const std::uint64_t free_bytes = capacity_ - used_;
+            return free_bytes == 0 ? 0.0 : 1.0 - static_cast<double>(largest) / static_cast<double>(free_bytes);
+        }
+
+    private:
+        std::uint64_t capacity_;
+        std::uint64_t used_ = 0;
+        std::map<std::uint64_t, std::uint64_t> free_;
+    };
+
+    struct TraceOp {
+        bool allocate;
+        std::uint64_t size;      // allocate
+        std::uint64_t alignment; // allocate
+        size_t target;           // free: index of the allocation in trace order
+    };
+
+    // Streaming waves: levels of mixed mesh and texture sizes load, then older levels unload in order.
+    std::vector<TraceOp> LevelStreamingTrace() {
+        std::mt19937_64 rng(1);
+        std::vector<TraceOp> ops;
+        std::vector<std::vector<size_t>> levels;
+        size_t allocations = 0;
+        for (int level = 0; level < 60; ++level) {
+            levels.emplace_back();
+            for (int i = 0; i < 400; ++i) {
+                const bool texture = rng() % 3 == 0;
+                const std::uint64_t size = texture ? 65536ull << (rng() % 6) : 256 + rng() % 200000;
+                ops.push_back({true, size, texture ? 65536ull : 256ull, 0});
+                levels.back().push_back(allocations++);
+            }
+            if (levels.size() > 3) {
+                for (const size_t index: levels[levels.size() - 4]) {
+                    ops.push_back({false, 0, 0, index});
+                }
+            }
+        }
+        return ops;
+    }
+
+    // Long-lived and short-lived buffers interleaved; short ones die in random order.
+    std::vector<TraceOp> MixedLifetimeTrace() {
+        std::mt19937_64 rng(2);
+        std::vector<TraceOp> ops;
+        std::vector<size_t> short_lived;
+        size_t allocations = 0;
+        for (int i = 0; i < 60000; ++i) {
+            const bool persistent = rng() % 10 == 0;
+            ops.push_back({true, persistent ? 4096 + rng() % 65536 : 256 + rng() % 1048576, 256, 0});
+            if (!persistent) {
+                short_lived.push_back(allocations);
+            }
+            ++allocations;
+            if (short_lived.size() > 200) {
+                const size_t k = rng() % short_lived.size();
+                ops.push_back({false, 0, 0, short_lived[k]});
+                short_lived[k] = short_lived.back();
+                short_lived.pop_back();
+            }
+        }
+        return ops;
+    }
+
+    template <typename Allocator>
+    void Replay(const char *trace, const char *name, const std::vector<TraceOp> &ops, std::uint64_t capacity) {
+        Allocator allocator(capacity);
+        std::vector<Allocation> results;
+        std::vector<bool> succeeded;
+        std::uint64_t failures = 0;
+        double worst_fragmentation = 0.0;
+        size_t step = 0;
+        const double ms = test::MeasureMs([&] {
+            for (const TraceOp &op: ops) {
+                if (op.allocate) {
+                    results.emplace_back();
+                    succeeded.push_back(allocator.Allocate(op.size, op.alignment, results.back()));
+                    failures += !succeeded.back();
+                } else if (succeeded[op.target]) {
+                    allocator.Free(results[op.target]);
+                }
+                // Sampled so the reference allocator's linear scan does not dominate its own timing.
+                if (++step % 1024 == 0) {
+                    worst_fragmentation = std::max(worst_fragmentation, allocator.Fragmentation());
+                }
+            }
+        });
+        std::printf("%-18s %-10s %8zu ops %8.1f ns/op %7llu failed  worst fragmentation %.3f\n", trace, name,
+                    ops.size(), ms * 1e6 / static_cast<double>(ops.size()),
+                    static_cast<unsigned long long>(failures), worst_fragmentation);
+    }
+
+    void BenchmarkTraces() {
+        const std::vector<TraceOp> streaming = LevelStreamingTrace();
+        const std::vector<TraceOp> mixed = MixedLifetimeTrace();
+        Replay<TlsfAllocator>("level streaming", "TLSF", streaming, 512ull << 20);
+        Replay<FirstFitAllocator>("level streaming", "first fit", streaming, 512ull << 20);
+        Replay<TlsfAllocator>("mixed lifetimes", "TLSF", mixed, 256ull << 20);
+        Replay<FirstFitAllocator>("mixed lifetimes", "first fit", mixed, 256ull << 20);
+    }
+}
+
+int main(int argc, char **argv) {
+    TestBasics();
+    TestRandomChurn();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkTraces();
+    }
+    return test::Result("TlsfAllocatorTests");
+}
@@ -0,0 +1,206 @@
+#include "TestHarness.h"
+#include "framework/UploadBatchState.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+using namespace gfw;
+
+namespace {
+    constexpr std::uint64_t kTextureAlignment = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+    struct Range {
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    // UploadBatcher with the device replaced by a queue that completes a batch only when the CPU waits for it or
+    // `latency` later batches have been submitted. Records what the real batcher would have copied where.
+    class FakeBatcher {
+    public:
+        FakeBatcher(std::uint64_t staging_capacity, std::uint64_t latency)
+            : state_(staging_capacity), latency_(latency) {}
+
+        UploadTicket Enqueue(std::uint64_t size, std::uint64_t alignment) {
+            state_.Retire(completed_);
+            std::uint64_t offset = 0;
+            UploadBatchState::Placement placement = state_.Reserve(size, alignment, offset);
+            if (placement == UploadBatchState::Placement::Full) {
+                Wait(Flush());
+                state_.Retire(completed_);
+                placement = state_.Reserve(size, alignment, offset);
+            }
+            if (placement == UploadBatchState::Placement::Full) {
+                return 0;
+            }
+            if (placement == UploadBatchState::Placement::Ring) {
+                aligned_ &= offset % alignment == 0;
+                for (const auto &[ticket, ranges]: in_flight_) {
+                    for (const Range &r: ranges) {
+                        overlaps_ |= ticket > completed_ && !(offset + size <= r.begin || offset >= r.end);
+                    }
+                }
+                in_flight_[state_.PendingTicket()].push_back({offset, offset + size});
+            } else {
+                ++oversized_;
+            }
+            recording_ = true;
+            return state_.Record(size);
+        }
+
+        UploadTicket Flush() {
+            if (!recording_) {
+                return state_.LastSubmitted();
+            }
+            recording_ = false;
+            const UploadBatchState::Batch batch = state_.Submit();
+            batches_.push_back(batch);
+            if (batch.ticket > latency_) {
+                Complete(batch.ticket - latency_);
+            }
+            return batch.ticket;
+        }
+
+        void Wait(UploadTicket ticket) {
+            if (recording_ && ticket >= state_.PendingTicket()) {
+                Flush();
+            }
+            if (completed_ < ticket) {
+                ++round_trips_;
+                Complete(ticket);
+            }
+        }
+
+        [[nodiscard]] bool IsComplete(UploadTicket ticket) const { return completed_ >= ticket; }
+
+        UploadBatchState state_;
+        std::vector<UploadBatchState::Batch> batches_;
+        std::uint32_t round_trips_ = 0;
+        std::uint32_t oversized_ = 0;
+        bool overlaps_ = false;
+        bool aligned_ = true;
+
+    private:
+        void Complete(UploadTicket ticket) {
+            completed_ = std::max(completed_, ticket);
+            in_flight_.erase(in_flight_.begin(), in_flight_.upper_bound(completed_));
+            state_.Retire(completed_);
+        }
+
+        std::uint64_t latency_;
+        std::uint64_t completed_ = 0;
+        bool recording_ = false;
+        std::map<UploadTicket, std::vector<Range>> in_flight_;
+    };
+
+    std::uint64_t TextureBytes(std::uint64_t width, std::uint64_t height) {
+        // Rows are padded to 256 bytes in the copyable footprint.
+        return ((width * 4 + 255) & ~255ull) * height;
+    }
+
+    // Startup: every texture goes into one batch and one wait covers them all.
+    void TestStartupIsOneRoundTrip() {
+        FakeBatcher batcher(64ull << 20, 2);
+        std::vector<UploadTicket> tickets;
+        for (int i = 0; i < 40; ++i) {
+            tickets.push_back(batcher.Enqueue(TextureBytes(512, 512), kTextureAlignment));
+        }
+        tickets.push_back(batcher.Enqueue(64 * 1024, 16));
+        GFW_CHECK(tickets.front() == 1 && tickets.back() == 1);
+        GFW_CHECK(!batcher.IsComplete(tickets.back()));
+        batcher.Wait(batcher.Flush());
+        GFW_CHECK(batcher.IsComplete(tickets.back()));
+        GFW_CHECK(batcher.batches_.size() == 1 && batcher.batches_[0].copies == 41);
+        GFW_CHECK(batcher.batches_[0].bytes == 40 * TextureBytes(512, 512) + 64 * 1024);
+        GFW_CHECK(batcher.round_trips_ == 1);
+        // Nothing pending: Flush hands back the last ticket without submitting an empty batch.
+        GFW_CHECK(batcher.Flush() == 1 && batcher.batches_.size() == 1);
+        GFW_CHECK(batcher.aligned_ && !batcher.overlaps_);
+    }
+
+    // A ring smaller than the working set drains itself instead of overwriting staging memory in flight.
+    void TestFullRingDrains() {
+        FakeBatcher batcher(4ull << 20, 3);
+        std::vector<UploadTicket> tickets;
+        for (int i = 0; i < 40; ++i) {
+            tickets.push_back(batcher.Enqueue(TextureBytes(512, 512), kTextureAlignment));
+        }
+        batcher.Wait(batcher.Flush());
+        GFW_CHECK(batcher.aligned_ && !batcher.overlaps_);
+        // Four 1 MB textures per 4 MB ring: a batch closes whenever the ring is full.
+        GFW_CHECK(batcher.batches_.size() == 10);
+        GFW_CHECK(tickets[3] == 1 && tickets[4] == 2 && tickets.back() == 10);
+        GFW_CHECK(batcher.state_.StagingUsed() == 0);
+
+        // An upload larger than the ring gets its own buffer but still rides in the open batch.
+        const UploadTicket big = batcher.Enqueue(8ull << 20, kTextureAlignment);
+        GFW_CHECK(big == 11 && batcher.oversized_ == 1);
+        GFW_CHECK(batcher.Flush() == 11 && batcher.batches_.back().bytes == 8ull << 20);
+
+        // Stats add up every submitted batch.
+        const UploadBatchState::Stats &stats = batcher.state_.GetStats();
+        GFW_CHECK(stats.batches == 11 && stats.copies == 41);
+        GFW_CHECK(stats.bytes == 40 * TextureBytes(512, 512) + (8ull << 20));
+        GFW_CHECK(stats.last.ticket == 11 && stats.last.copies == 1);
+    }
+
+    // Random asset sizes against a queue that lags several batches behind.
+    void TestRandomUploads() {
+        FakeBatcher batcher(1ull << 20, 2);
+        std::uint32_t seed = 3;
+        const auto next = [&seed] { return (seed = seed * 1103515245u + 12345u) >> 16; };
+        UploadTicket last = 0;
+        bool monotonic = true;
+        for (int i = 0; i < 5000; ++i) {
+            const bool texture = next() % 2;
+            const std::uint64_t size = texture ? TextureBytes(1 + next() % 300, 1 + next() % 300) : 1 + next() % 200000;
+            const UploadTicket ticket = batcher.Enqueue(size, texture ? kTextureAlignment : 16);
+            monotonic &= ticket >= last && ticket != 0;
+            last = ticket;
+            if (next() % 16 == 0) {
+                batcher.Flush();
+            }
+        }
+        batcher.Wait(batcher.Flush());
+        GFW_CHECK(monotonic);
+        GFW_CHECK(batcher.aligned_ && !batcher.overlaps_);
+        GFW_CHECK(batcher.IsComplete(last) && batcher.state_.StagingUsed() == 0);
+    }
+
+    // GPU round-trips to load N textures: one copy, submit and wait each, against one batch per ring fill.
+    void BenchmarkRoundTrips() {
+        for (const std::uint64_t ring_mb: {16ull, 64ull, 256ull}) {
+            for (const std::uint64_t count: {64ull, 512ull}) {
+                FakeBatcher batched(ring_mb << 20, 2);
+                FakeBatcher serial(ring_mb << 20, 2);
+                const double ms = test::MeasureMs([&] {
+                    for (std::uint64_t i = 0; i < count; ++i) {
+                        const std::uint64_t side = 256u << (i % 3);
+                        batched.Enqueue(TextureBytes(side, side), kTextureAlignment);
+                    }
+                    batched.Wait(batched.Flush());
+                });
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    const std::uint64_t side = 256u << (i % 3);
+                    serial.Wait(serial.Enqueue(TextureBytes(side, side), kTextureAlignment));
+                }
+                std::printf("%3llu textures, %3llu MB ring: %3u round-trips batched (%zu batches, %.3f ms), %3u "
+                            "one-by-one\n",
+                            static_cast<unsigned long long>(count), static_cast<unsigned long long>(ring_mb),
+                            batched.round_trips_, batched.batches_.size(), ms, serial.round_trips_);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestStartupIsOneRoundTrip();
+    TestFullRingDrains();
+    TestRandomUploads();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkRoundTrips();
+    }
+    return test::Result("UploadBatchStateTests");
+}
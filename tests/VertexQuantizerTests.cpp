@@ -0,0 +1,240 @@
+#include "MeshLoader.h"
+#include "TestHarness.h"
+#include "TestMeshes.h"
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace gfw;
+using namespace DirectX;
+
+namespace {
+    // atan2 in double: a float acos cannot resolve angles below about 0.03 degrees.
+    float AngleDegrees(const float a[3], const float b[3]) {
+        const double cx = double{a[1]} * b[2] - double{a[2]} * b[1];
+        const double cy = double{a[2]} * b[0] - double{a[0]} * b[2];
+        const double cz = double{a[0]} * b[1] - double{a[1]} * b[0];
+        const double dot = double{a[0]} * b[0] + double{a[1]} * b[1] + double{a[2]} * b[2];
+        return static_cast<float>(std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / 3.14159265358979);
+    }
+
+    // Directions spread over the whole sphere plus the axes and the octahedron's fold lines.
+    std::vector<XMFLOAT3> Directions() {
+        std::vector<XMFLOAT3> directions = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+                                            {1, 1, -1}, {-1, 1, -1}, {0.5f, -0.5f, -0.001f}};
+        constexpr int kCount = 4096;
+        for (int i = 0; i < kCount; ++i) {
+            // Fibonacci sphere.
+            const float y = 1.0f - 2.0f * (static_cast<float>(i) + 0.5f) / kCount;
+            const float r = std::sqrt(1.0f - y * y);
+            const float phi = 2.39996323f * static_cast<float>(i);
+            directions.push_back({r * std::cos(phi), y, r * std::sin(phi)});
+        }
+        return directions;
+    }
+
+    void TestNormalEncoding() {
+        float worst = 0.0f;
+        const XMFLOAT3 zero = {0, 0, 0};
+        for (const XMFLOAT3 &d: Directions()) {
+            const float length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+            const float normal[3] = {d.x / length, d.y / length, d.z / length};
+            const float position[3] = {0, 0, 0};
+            const float uv[2] = {0, 0};
+            const QuantizedVertex q = VertexQuantizer::Encode(position, normal, uv, zero, zero);
+            float decoded_position[3];
+            float decoded_normal[3];
+            float decoded_uv[2];
+            VertexQuantizer::Decode(q, zero, zero, decoded_position, decoded_normal, decoded_uv);
+            worst = std::max(worst, AngleDegrees(normal, decoded_normal));
+        }
+        // Two 16-bit components over the octahedron resolve directions to a few thousandths of a degree.
+        GFW_CHECK(worst < 0.01f);
+    }
+
+    void TestTangentHandedness() {
+        QuantizedVertex vertex = {};
+        for (const float w: {1.0f, -1.0f}) {
+            const float tangent[4] = {0.6f, 0.0f, -0.8f, w};
+            const QuantizedTangent t = VertexQuantizer::EncodeTangent(tangent, vertex);
+            float decoded[4];
+            VertexQuantizer::DecodeTangent(t, vertex, decoded);
+            GFW_CHECK(decoded[3] == w);
+            GFW_CHECK(AngleDegrees(tangent, decoded) < 0.01f);
+        }
+    }
+
+    // Sphere vertices with a tangent around the y axis, handedness alternating per vertex.
+    MeshData SphereWithTangents() {
+        const MeshData sphere = test::SphereMesh(64, 128, 3.0f, 10.0f, -2.0f, 0.5f);
+        MeshData mesh = sphere;
+        const std::uint32_t stride = sphere.vertex_stride + 4 * sizeof(float);
+        mesh.vertex_stride = stride;
+        mesh.has_tangents = true;
+        mesh.vertex_data.assign(static_cast<size_t>(mesh.vertex_count) * stride, 0);
+        for (std::uint32_t i = 0; i < mesh.vertex_count; ++i) {
+            const std::uint8_t *src = sphere.vertex_data.data() + static_cast<size_t>(i) * sphere.vertex_stride;
+            std::uint8_t *dst = mesh.vertex_data.data() + static_cast<size_t>(i) * stride;
+            std::memcpy(dst, src, sphere.vertex_stride);
+            float normal[3];
+            std::memcpy(normal, src + 3 * sizeof(float), sizeof(normal));
+            const float tangent[4] = {-normal[2], 0.0f, normal[0], i % 2 ? 1.0f : -1.0f};
+            std::memcpy(dst + sphere.vertex_stride, tangent, sizeof(tangent));
+        }
+        return mesh;
+    }
+
+    void TestMeshRoundTrip() {
+        for (const bool tangents: {false, true}) {
+            const MeshData source =
+                tangents ? SphereWithTangents() : test::SphereMesh(64, 128, 3.0f, 10.0f, -2.0f, 0.5f);
+            MeshData mesh = source;
+            QuantizationStats stats;
+            GFW_CHECK(VertexQuantizer::Quantize(mesh, &stats));
+            GFW_CHECK(mesh.vertex_format == VertexFormat::Quantized);
+            GFW_CHECK(mesh.vertex_stride == (tangents ? 20u : 16u));
+            GFW_CHECK(mesh.vertex_data.size() == static_cast<size_t>(mesh.vertex_count) * mesh.vertex_stride);
+            GFW_CHECK(mesh.indices == source.indices);
+
+            const XMFLOAT3 scale = {mesh.bounds_max.x - mesh.bounds_min.x, mesh.bounds_max.y - mesh.bounds_min.y,
+                                    mesh.bounds_max.z - mesh.bounds_min.z};
+            GFW_CHECK(std::fabs(scale.x - 6.0f) < 1e-3f && std::fabs(scale.y - 6.0f) < 1e-3f);
+            // Rounding to the nearest of 65536 steps along each axis.
+            const float half_step = 0.5f * std::max({scale.x, scale.y, scale.z}) / 65535.0f;
+            const float position_bound = half_step * std::sqrt(3.0f) * 1.01f + 1e-6f;
+
+            float position_error = 0.0f;
+            float normal_error = 0.0f;
+            float uv_error = 0.0f;
+            bool handedness = true;
+            for (std::uint32_t i = 0; i < mesh.vertex_count; ++i) {
+                test::TestVertex original;
+                std::memcpy(&original, source.vertex_data.data() + static_cast<size_t>(i) * source.vertex_stride,
+                            sizeof(original));
+                QuantizedVertex q;
+                const std::uint8_t *encoded = mesh.vertex_data.data() + static_cast<size_t>(i) * mesh.vertex_stride;
+                std::memcpy(&q, encoded, sizeof(q));
+                float position[3];
+                float normal[3];
+                float uv[2];
+                VertexQuantizer::Decode(q, mesh.bounds_min, scale, position, normal, uv);
+                const float dx = position[0] - original.px;
+                const float dy = position[1] - original.py;
+                const float dz = position[2] - original.pz;
+                const float original_normal[3] = {original.nx, original.ny, original.nz};
+                position_error = std::max(position_error, std::sqrt(dx * dx + dy * dy + dz * dz));
+                normal_error = std::max(normal_error, AngleDegrees(original_normal, normal));
+                uv_error = std::max({uv_error, std::fabs(uv[0] - original.u), std::fabs(uv[1] - original.v)});
+                if (tangents) {
+                    QuantizedTangent t;
+                    std::memcpy(&t, encoded + sizeof(q), sizeof(t));
+                    float tangent[4];
+                    VertexQuantizer::DecodeTangent(t, q, tangent);
+                    handedness &= tangent[3] == (i % 2 ? 1.0f : -1.0f);
+                }
+            }
+            GFW_CHECK(position_error <= position_bound);
+            GFW_CHECK(normal_error < 0.01f);
+            // Half floats keep 11 significant bits, so UVs in [0, 1] are off by at most 2^-12.
+            GFW_CHECK(uv_error <= 1.0f / 4096.0f);
+            GFW_CHECK(handedness);
+            // The reported statistics are the same worst cases.
+            GFW_CHECK(std::fabs(stats.max_position_error - position_error) < 1e-6f);
+            GFW_CHECK(stats.max_uv_error == uv_error);
+            // Angles are reported through a float acos, which rounds them up to its resolution.
+            GFW_CHECK(stats.max_normal_error < 0.05f);
+            GFW_CHECK(!tangents || stats.max_tangent_error < 0.05f);
+        }
+    }
+
+    void TestMemoryReport() {
+        MeshData mesh = test::GridMesh(64);
+        const size_t index_count = mesh.indices.size();
+        QuantizationStats stats;
+        GFW_CHECK(VertexQuantizer::Quantize(mesh, &stats));
+        GFW_CHECK(stats.bytes_before == mesh.vertex_count * 32ull + index_count * 4ull);
+        // Fewer than 65536 vertices: 16-bit indices.
+        GFW_CHECK(stats.bytes_after == mesh.vertex_count * 16ull + index_count * 2ull);
+        GFW_CHECK(VertexQuantizer::IndexSize(0xffff) == 2 && VertexQuantizer::IndexSize(0x10000) == 4);
+
+        MeshData large = test::GridMesh(256);
+        GFW_CHECK(large.vertex_count >= 0x10000u);
+        GFW_CHECK(VertexQuantizer::Quantize(large, &stats));
+        GFW_CHECK(stats.bytes_after == large.vertex_count * 16ull + large.indices.size() * 4ull);
+    }
+
+    void TestRejectedLayouts() {
+        MeshData mesh = test::GridMesh(4);
+        GFW_CHECK(VertexQuantizer::Quantize(mesh));
+        const std::vector<std::uint8_t> quantized = mesh.vertex_data;
+        GFW_CHECK(!VertexQuantizer::Quantize(mesh));
+        GFW_CHECK(mesh.vertex_data == quantized && mesh.vertex_stride == 16);
+
+        MeshData odd = test::GridMesh(4);
+        odd.vertex_stride = 24;
+        GFW_CHECK(!VertexQuantizer::Quantize(odd) && odd.vertex_format == VertexFormat::Float32);
+        MeshData empty;
+        GFW_CHECK(!VertexQuantizer::Quantize(empty));
+    }
+
+    // A flat axis has no extent to quantize against; it decodes back to the plane exactly.
+    void TestFlatAxis() {
+        MeshData mesh = test::GridMesh(8);
+        for (std::uint32_t i = 0; i < mesh.vertex_count; ++i) {
+            const float height = 2.5f;
+            std::memcpy(mesh.vertex_data.data() + static_cast<size_t>(i) * mesh.vertex_stride + sizeof(float), &height,
+                        sizeof(height));
+        }
+        QuantizationStats stats;
+        GFW_CHECK(VertexQuantizer::Quantize(mesh, &stats));
+        GFW_CHECK(mesh.bounds_min.y == 2.5f && mesh.bounds_max.y == 2.5f);
+        // Only x and z round: half a step on each of the unit grid's two axes.
+        GFW_CHECK(stats.max_position_error <= 0.5f / 65535.0f * std::sqrt(2.0f) * 1.01f);
+    }
+
+    void BenchmarkQuantize() {
+        std::vector<std::pair<std::string, MeshData>> meshes;
+        meshes.emplace_back("sphere 256x512", test::SphereMesh(256, 512));
+        meshes.emplace_back("sphere 64x128 + tangents", SphereWithTangents());
+        meshes.emplace_back("grid 128", test::GridMesh(128));
+        for (const char *asset: {"bricks2/cube.obj", "bricks2/wall.obj", "sponza/Sponza-master/sponza.obj"}) {
+            const std::filesystem::path path = std::filesystem::path(GFW_SOURCE_DIR) / asset;
+            if (!std::filesystem::exists(path)) {
+                continue;
+            }
+            ObjModelData model = MeshLoader::LoadObjModel(path.wstring());
+            MeshLoader::GenerateTangents(model);
+            for (size_t i = 0; i < model.submeshes.size(); ++i) {
+                meshes.emplace_back(std::string(asset) + " #" + std::to_string(i), std::move(model.submeshes[i].mesh));
+            }
+        }
+        std::printf("%-40s %9s %11s %11s %9s %9s %9s %9s %8s\n", "quantize", "vertices", "bytes", "after",
+                    "pos err", "nrm deg", "uv err", "tan deg", "ms");
+        for (auto &[name, mesh]: meshes) {
+            QuantizationStats stats;
+            const double ms = test::MeasureMs([&] { VertexQuantizer::Quantize(mesh, &stats); });
+            std::printf("%-40s %9u %11llu %11llu %9.2e %9.4f %9.2e %9.4f %8.2f\n", name.c_str(), mesh.vertex_count,
+                        static_cast<unsigned long long>(stats.bytes_before),
+                        static_cast<unsigned long long>(stats.bytes_after), stats.max_position_error,
+                        stats.max_normal_error, stats.max_uv_error, stats.max_tangent_error, ms);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TestNormalEncoding();
+    TestTangentHandedness();
+    TestMeshRoundTrip();
+    TestMemoryReport();
+    TestRejectedLayouts();
+    TestFlatAxis();
+    if (test::BenchmarkRequested(argc, argv)) {
+        BenchmarkQuantize();
+    }
+    return test::Result("VertexQuantizerTests");
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+// Scalar stand-in for the part of DirectXMath the headless tests compile against, for hosts without the Windows
+// SDK. Conventions match the real library: row vectors, row-major XMMATRIX, left-handed view and projection.
+// Only tests/CMakeLists.txt and the RenderBenchmark target put this directory on the include path, and only on
+// non-Windows hosts.
+
+#include <cmath>
+#include <cstdint>
+
+namespace DirectX {
+    constexpr float XM_PI = 3.141592654f;
+
+    constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+    constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+    struct XMFLOAT2 {
+        float x;
+        float y;
+    };
+
+    struct XMFLOAT3 {
+        float x;
+        float y;
+        float z;
+    };
+
+    struct XMFLOAT4 {
+        float x;
+        float y;
+        float z;
+        float w;
+    };
+
+    struct XMUINT4 {
+        std::uint32_t x;
+        std::uint32_t y;
+        std::uint32_t z;
+        std::uint32_t w;
+    };
+
+    struct XMFLOAT4X4 {
+        union {
+            struct {
+                float _11, _12, _13, _14;
+                float _21, _22, _23, _24;
+                float _31, _32, _33, _34;
+                float _41, _42, _43, _44;
+            };
+            float m[4][4];
+        };
+    };
+
+    struct XMVECTOR {
+        float v[4];
+    };
+
+    struct XMMATRIX {
+        XMVECTOR r[4];
+    };
+
+    using FXMVECTOR = const XMVECTOR &;
+    using FXMMATRIX = const XMMATRIX &;
+    using CXMMATRIX = const XMMATRIX &;
+
+    inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+    inline XMVECTOR XMVectorZero() { return {{0.0f, 0.0f, 0.0f, 0.0f}}; }
+    inline float XMVectorGetX(FXMVECTOR v) { return v.v[0]; }
+    inline float XMVectorGetY(FXMVECTOR v) { return v.v[1]; }
+    inline float XMVectorGetZ(FXMVECTOR v) { return v.v[2]; }
+    inline float XMVectorGetW(FXMVECTOR v) { return v.v[3]; }
+
+    inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) {
+        return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+    }
+
+    inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) {
+        return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+    }
+
+    inline XMVECTOR XMVectorScale(FXMVECTOR a, float s) { return {{a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s}}; }
+
+    inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) {
+        const float d = a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2];
+        return {{d, d, d, d}};
+    }
+
+    inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b) {
+        return {{a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2],
+                 a.v[0] * b.v[1] - a.v[1] * b.v[0], 0.0f}};
+    }
+
+    inline XMVECTOR XMVector3LengthSq(FXMVECTOR a) { return XMVector3Dot(a, a); }
+
+    inline XMVECTOR XMVector3Length(FXMVECTOR a) {
+        const float length = std::sqrt(XMVectorGetX(XMVector3LengthSq(a)));
+        return {{length, length, length, length}};
+    }
+
+    inline XMVECTOR XMVector3Normalize(FXMVECTOR a) {
+        const float length = XMVectorGetX(XMVector3Length(a));
+        return length > 0.0f ? XMVectorScale(a, 1.0f / length) : a;
+    }
+
+    inline XMVECTOR XMLoadFloat3(const XMFLOAT3 *p) { return {{p->x, p->y, p->z, 0.0f}}; }
+    inline void XMStoreFloat3(XMFLOAT3 *p, FXMVECTOR v) { *p = {v.v[0], v.v[1], v.v[2]}; }
+    inline XMVECTOR XMLoadFloat4(const XMFLOAT4 *p) { return {{p->x, p->y, p->z, p->w}}; }
+    inline void XMStoreFloat4(XMFLOAT4 *p, FXMVECTOR v) { *p = {v.v[0], v.v[1], v.v[2], v.v[3]}; }
+
+    inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4 *p) {
+        XMMATRIX result{};
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                result.r[row].v[column] = p->m[row][column];
+            }
+        }
+        return result;
+    }
+
+    inline void XMStoreFloat4x4(XMFLOAT4X4 *p, FXMMATRIX m) {
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                p->m[row][column] = m.r[row].v[column];
+            }
+        }
+    }
+
+    inline XMMATRIX XMMatrixIdentity() {
+        return {{{{1.0f, 0.0f, 0.0f, 0.0f}}, {{0.0f, 1.0f, 0.0f, 0.0f}}, {{0.0f, 0.0f, 1.0f, 0.0f}},
+                 {{0.0f, 0.0f, 0.0f, 1.0f}}}};
+    }
+
+    inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b) {
+        XMMATRIX result{};
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; ++k) {
+                    sum += a.r[row].v[k] * b.r[k].v[column];
+                }
+                result.r[row].v[column] = sum;
+            }
+        }
+        return result;
+    }
+
+    inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a, b); }
+
+    inline XMMATRIX XMMatrixTranspose(FXMMATRIX m) {
+        XMMATRIX result{};
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                result.r[row].v[column] = m.r[column].v[row];
+            }
+        }
+        return result;
+    }
+
+    inline XMMATRIX XMMatrixTranslation(float x, float y, float z) {
+        XMMATRIX result = XMMatrixIdentity();
+        result.r[3] = {{x, y, z, 1.0f}};
+        return result;
+    }
+
+    inline XMMATRIX XMMatrixScaling(float x, float y, float z) {
+        XMMATRIX result = XMMatrixIdentity();
+        result.r[0].v[0] = x;
+        result.r[1].v[1] = y;
+        result.r[2].v[2] = z;
+        return result;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting in double precision; a singular matrix yields non-finite values
+    // as in the real library, and the determinant is not reported.
+    inline XMMATRIX XMMatrixInverse(XMVECTOR *determinant, FXMMATRIX m) {
+        double a[4][8];
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                a[row][column] = m.r[row].v[column];
+                a[row][column + 4] = row == column ? 1.0 : 0.0;
+            }
+        }
+        for (int column = 0; column < 4; ++column) {
+            int pivot = column;
+            for (int row = column + 1; row < 4; ++row) {
+                if (std::fabs(a[row][column]) > std::fabs(a[pivot][column])) {
+                    pivot = row;
+                }
+            }
+            for (int k = 0; k < 8; ++k) {
+                const double swap = a[column][k];
+                a[column][k] = a[pivot][k];
+                a[pivot][k] = swap;
+            }
+            const double scale = 1.0 / a[column][column];
+            for (int k = 0; k < 8; ++k) {
+                a[column][k] *= scale;
+            }
+            for (int row = 0; row < 4; ++row) {
+                if (row != column) {
+                    const double factor = a[row][column];
+                    for (int k = 0; k < 8; ++k) {
+                        a[row][k] -= factor * a[column][k];
+                    }
+                }
+            }
+        }
+        if (determinant) {
+            *determinant = XMVectorZero();
+        }
+        XMMATRIX result{};
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                result.r[row].v[column] = static_cast<float>(a[row][column + 4]);
+            }
+        }
+        return result;
+    }
+
+    inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eye, FXMVECTOR focus, FXMVECTOR up) {
+        const XMVECTOR z = XMVector3Normalize(XMVectorSubtract(focus, eye));
+        const XMVECTOR x = XMVector3Normalize(XMVector3Cross(up, z));
+        const XMVECTOR y = XMVector3Cross(z, x);
+        XMMATRIX result = XMMatrixIdentity();
+        for (int i = 0; i < 3; ++i) {
+            result.r[i].v[0] = x.v[i];
+            result.r[i].v[1] = y.v[i];
+            result.r[i].v[2] = z.v[i];
+        }
+        result.r[3] = {{-XMVectorGetX(XMVector3Dot(x, eye)), -XMVectorGetX(XMVector3Dot(y, eye)),
+                        -XMVectorGetX(XMVector3Dot(z, eye)), 1.0f}};
+        return result;
+    }
+
+    inline XMMATRIX XMMatrixPerspectiveFovLH(float fov_y, float aspect, float near_z, float far_z) {
+        const float height = 1.0f / std::tan(0.5f * fov_y);
+        const float range = far_z / (far_z - near_z);
+        XMMATRIX result{};
+        result.r[0].v[0] = height / aspect;
+        result.r[1].v[1] = height;
+        result.r[2].v[2] = range;
+        result.r[2].v[3] = 1.0f;
+        result.r[3].v[2] = -range * near_z;
+        return result;
+    }
+
+    inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m) {
+        XMVECTOR result{};
+        for (int column = 0; column < 4; ++column) {
+            result.v[column] = v.v[0] * m.r[0].v[column] + v.v[1] * m.r[1].v[column] + v.v[2] * m.r[2].v[column] +
+                               v.v[3] * m.r[3].v[column];
+        }
+        return result;
+    }
+
+    inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m) {
+        const XMVECTOR result = XMVector4Transform({{v.v[0], v.v[1], v.v[2], 1.0f}}, m);
+        return XMVectorScale(result, 1.0f / result.v[3]);
+    }
+
+    inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m) {
+        return XMVector4Transform({{v.v[0], v.v[1], v.v[2], 0.0f}}, m);
+    }
+}
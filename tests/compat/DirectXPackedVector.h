@@ -0,0 +1,70 @@
+#pragma once
+
+// Half-float conversions of DirectXPackedVector for hosts without the Windows SDK; see DirectXMath.h here.
+
+#include <cstdint>
+#include <cstring>
+
+namespace DirectX::PackedVector {
+    using HALF = std::uint16_t;
+
+    // Rounds to nearest even; values beyond the half range become infinity and NaNs stay NaN.
+    inline HALF XMConvertFloatToHalf(float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+        const std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+        if (magnitude >= 0x7F800000u) {
+            return static_cast<HALF>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+        }
+        if (magnitude >= 0x477FF000u) {
+            return static_cast<HALF>(sign | 0x7C00u);
+        }
+        if (magnitude < 0x38800000u) {
+            // Subnormal half: shift the mantissa with its implicit bit into place, rounding to nearest even.
+            const std::uint32_t exponent = magnitude >> 23;
+            if (exponent < 102) {
+                return sign;
+            }
+            const std::uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+            const std::uint32_t shift = 126 - exponent;
+            std::uint32_t half = mantissa >> shift;
+            const std::uint32_t remainder = mantissa & ((1u << shift) - 1u);
+            const std::uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+                ++half;
+            }
+            return static_cast<HALF>(sign | half);
+        }
+        std::uint32_t half = ((magnitude - 0x38000000u) >> 13);
+        const std::uint32_t remainder = magnitude & 0x1FFFu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<HALF>(sign | half);
+    }
+
+    inline float XMConvertHalfToFloat(HALF value) {
+        const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000u) << 16;
+        std::uint32_t exponent = (value >> 10) & 0x1Fu;
+        std::uint32_t mantissa = value & 0x3FFu;
+        std::uint32_t bits;
+        if (exponent == 0x1Fu) {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        } else if (mantissa == 0) {
+            bits = sign;
+        } else {
+            exponent = 113;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+}